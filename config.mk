@@ -26,20 +26,39 @@ __CONFIG_LIBC_SCANF_FLOAT ?= y
 # wrap standard input/output/error functions
 __CONFIG_LIBC_WRAP_STDIO ?= y
 
+# queue stdout messages in a ring and write them out from a low priority
+# thread through UART DMA, depends on __CONFIG_LIBC_WRAP_STDIO
+__CONFIG_LIBC_WRAP_STDIO_DEFER ?= n
+
 # heap managed by stdlib
 __CONFIG_MALLOC_USE_STDLIB ?= y
 
 # trace heap memory usage and error when using malloc, free, etc.
 __CONFIG_MALLOC_TRACE ?= n
 
+# serve small malloc requests from size-class pages to limit heap fragmentation
+__CONFIG_MALLOC_SLAB ?= n
+
 # os
 __CONFIG_OS_FREERTOS ?= y
 
+# record context switches, IRQs and IPC into a trace buffer, see "trace" command
+__CONFIG_OS_TRACE ?= n
+
+# time pm device callbacks, residency, wakeup sources, see "pm stat" command
+__CONFIG_PM_PROFILE ?= n
+
 # lwIP
 #   - y: lwIP 1.4.1, support IPv4 stack only
 #   - n: lwIP 2.x.x, support dual IPv4/IPv6 stack
 __CONFIG_LWIP_V1 ?= y
 
+# mbedTLS configuration
+#   - y: ECDHE and AES-GCM suites, session tickets and client session cache
+#        (config-xr-fast-cliserv.h)
+#   - n: RSA key exchange and CBC suites only (config-xr-mini-cliserv.h)
+__CONFIG_MBEDTLS_FAST_PROFILE ?= n
+
 # mbuf implementation mode
 #   - mode 0: continuous memory allocated from net core
 #   - mode 1: continuous memory (lwip pbuf) allocated from app core
@@ -95,6 +114,10 @@ ifeq ($(__CONFIG_LIBC_WRAP_STDIO), y)
   CONFIG_SYMBOLS += -D__CONFIG_LIBC_WRAP_STDIO
 endif
 
+ifeq ($(__CONFIG_LIBC_WRAP_STDIO_DEFER), y)
+  CONFIG_SYMBOLS += -D__CONFIG_LIBC_WRAP_STDIO_DEFER
+endif
+
 ifeq ($(__CONFIG_MALLOC_USE_STDLIB), y)
   CONFIG_SYMBOLS += -D__CONFIG_MALLOC_USE_STDLIB
 endif
@@ -103,6 +126,18 @@ ifeq ($(__CONFIG_MALLOC_TRACE), y)
   CONFIG_SYMBOLS += -D__CONFIG_MALLOC_TRACE
 endif
 
+ifeq ($(__CONFIG_OS_TRACE), y)
+  CONFIG_SYMBOLS += -D__CONFIG_OS_TRACE
+endif
+
+ifeq ($(__CONFIG_PM_PROFILE), y)
+  CONFIG_SYMBOLS += -D__CONFIG_PM_PROFILE
+endif
+
+ifeq ($(__CONFIG_MALLOC_SLAB), y)
+  CONFIG_SYMBOLS += -D__CONFIG_MALLOC_SLAB
+endif
+
 ifeq ($(__CONFIG_OS_FREERTOS), y)
   CONFIG_SYMBOLS += -D__CONFIG_OS_FREERTOS
 endif
@@ -111,6 +146,10 @@ ifeq ($(__CONFIG_LWIP_V1), y)
   CONFIG_SYMBOLS += -D__CONFIG_LWIP_V1
 endif
 
+ifeq ($(__CONFIG_MBEDTLS_FAST_PROFILE), y)
+  CONFIG_SYMBOLS += -D__CONFIG_MBEDTLS_FAST_PROFILE
+endif
+
 CONFIG_SYMBOLS += -D__CONFIG_MBUF_IMPL_MODE=$(__CONFIG_MBUF_IMPL_MODE)
 
 ifeq ($(__CONFIG_XIP_SECTION_FUNC_LEVEL), y)
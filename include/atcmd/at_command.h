@@ -91,6 +91,7 @@ typedef enum {
 	ACC_GPIOR, /* Read specified GPIO */
 	ACC_GPIOW, /* Write specified GPIO */
 	ACC_SCAN, /* scan available AP */
+	ACC_MODE_EXIT, /* back to command mode */
 } AT_CALLBACK_CMD;
 
 typedef struct {
@@ -134,6 +135,7 @@ typedef struct {
 		struct {
 			s32 len; /* transparent transmission send buffer length */
 			u8 *buf; /* transparent transmission send buffer */
+			s32 mux; /* 0: one socket 1: all sockets in frames */
 		} mode;
 	} u;
  } at_callback_para_t;
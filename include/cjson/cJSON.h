@@ -159,6 +159,72 @@ extern cJSON *cJSON_ParseWithOpts(const char *value, const char **return_parse_e
 
 extern void cJSON_Minify(char *json);
 
+/* Arena parsing: all the items and strings of a parse come from one block supplied by the caller,
+ * the result is a plain cJSON tree for the usual getters and printers. Don't cJSON_Delete() it or
+ * modify it with calls that free, drop the whole parse with cJSON_ArenaReset() instead.
+ * peak is the high water mark of used, for sizing the block. */
+typedef struct cJSON_Arena
+{
+    char *block;
+    size_t size;
+    size_t used;
+    size_t peak;
+} cJSON_Arena;
+
+extern void cJSON_ArenaInit(cJSON_Arena *arena, void *block, size_t size);
+/* Returns NULL when the text is invalid or the block is too small, the arena is left as it was. */
+extern cJSON *cJSON_ParseInArena(cJSON_Arena *arena, const char *value);
+extern cJSON *cJSON_ParseWithOptsInArena(cJSON_Arena *arena, const char *value, const char **return_parse_end, int require_null_terminated);
+/* Release every tree parsed in the arena at once. */
+extern void cJSON_ArenaReset(cJSON_Arena *arena);
+
+/* Pull parsing: walk a document token by token without building a tree or allocating,
+ * the nesting is kept in a stack of max_depth bytes supplied by the caller. */
+typedef enum
+{
+    cJSON_PullError = -1,
+    cJSON_PullEnd = 0,
+    cJSON_PullObjectStart,
+    cJSON_PullObjectEnd,
+    cJSON_PullArrayStart,
+    cJSON_PullArrayEnd,
+    cJSON_PullKey,      /* token is the raw key */
+    cJSON_PullString,   /* token is the raw string, escapes not decoded */
+    cJSON_PullNumber,   /* token is the number text, also in valueint and valuedouble */
+    cJSON_PullTrue,
+    cJSON_PullFalse,
+    cJSON_PullNull
+} cJSON_PullEvent;
+
+typedef struct cJSON_Pull
+{
+    const char *pos;
+    const char *end;
+    const char *token;
+    size_t token_len;
+    int valueint;
+    double valuedouble;
+    /* where the text is invalid or too deep, after cJSON_PullError */
+    const char *error;
+    char *stack;
+    int depth;
+    int max_depth;
+    int state;
+    cJSON_PullEvent event;
+} cJSON_Pull;
+
+/* The text need not be null terminated, it must stay valid while pulling. */
+extern void cJSON_PullInit(cJSON_Pull *pull, const char *json, size_t len, char *stack, int max_depth);
+extern cJSON_PullEvent cJSON_PullNext(cJSON_Pull *pull);
+/* After a key, skip its value; after an object or array start, skip to its end. Returns the last event. */
+extern cJSON_PullEvent cJSON_PullSkip(cJSON_Pull *pull);
+/* Case insensitive like cJSON_GetObjectItem. */
+extern int cJSON_PullIsKey(const cJSON_Pull *pull, const char *key);
+/* Inside an object, skip to the given key of this level. Returns 0 at the end of the object. */
+extern int cJSON_PullFindKey(cJSON_Pull *pull, const char *key);
+/* Decode the current key or string into buf, which needs token_len + 1 bytes. Returns the length or -1. */
+extern int cJSON_PullCopyString(const cJSON_Pull *pull, char *buf, size_t size);
+
 /* Macros for creating things quickly. */
 #define cJSON_AddNullToObject(object,name) cJSON_AddItemToObject(object, name, cJSON_CreateNull())
 #define cJSON_AddTrueToObject(object,name) cJSON_AddItemToObject(object, name, cJSON_CreateTrue())
@@ -256,6 +256,33 @@ typedef struct {
 /** @brief Type define of UART receive ready callback function */
 typedef void (*UART_RxReadyCallback) (void *arg);
 
+/** @brief Events of the UART receive ring, or-ed */
+#define UART_RX_EVENT_HALF      HAL_BIT(0)  /* DMA filled the first half */
+#define UART_RX_EVENT_FULL      HAL_BIT(1)  /* DMA filled the second half */
+#define UART_RX_EVENT_IDLE      HAL_BIT(2)  /* RX FIFO drained on timeout */
+#define UART_RX_EVENT_OVERRUN   HAL_BIT(3)  /* received data lost */
+
+/**
+ * @brief Type define of UART receive ring callback function
+ * @note Called in interrupt context
+ */
+typedef void (*UART_RxRingCallback) (void *arg, uint32_t events);
+
+/**
+ * @brief UART receive ring statistics
+ */
+typedef struct {
+    uint32_t        rxBytes;        /* Bytes received, wraps around */
+    uint32_t        pending;        /* Bytes not consumed yet */
+    uint32_t        maxPending;     /* Highest pending seen */
+    uint32_t        halfCnt;        /* UART_RX_EVENT_HALF count */
+    uint32_t        fullCnt;        /* UART_RX_EVENT_FULL count */
+    uint32_t        idleCnt;        /* UART_RX_EVENT_IDLE count */
+    uint32_t        overrunCnt;     /* Times the DMA overwrote unread data */
+    uint32_t        overrunBytes;   /* Unread bytes overwritten by the DMA */
+    uint32_t        fifoOverrun;    /* RX FIFO overruns */
+} UART_RxRingStat;
+
 UART_T *HAL_UART_GetInstance(UART_ID uartID);
 int HAL_UART_IsTxReady(UART_T *uart);
 int HAL_UART_IsTxEmpty(UART_T *uart);
@@ -279,6 +306,13 @@ HAL_Status HAL_UART_DisableRxDMA(UART_ID uartID);
 int32_t HAL_UART_Transmit_DMA(UART_ID uartID, uint8_t *buf, int32_t size);
 int32_t HAL_UART_Receive_DMA(UART_ID uartID, uint8_t *buf, int32_t size, uint32_t msec);
 
+HAL_Status HAL_UART_StartRxRing(UART_ID uartID, uint8_t *buf, uint32_t size,
+                                UART_RxRingCallback cb, void *arg);
+HAL_Status HAL_UART_StopRxRing(UART_ID uartID);
+int32_t HAL_UART_GetRxSpan(UART_ID uartID, uint8_t **data);
+void HAL_UART_ConsumeRx(UART_ID uartID, int32_t len);
+void HAL_UART_GetRxRingStat(UART_ID uartID, UART_RxRingStat *stat);
+
 int32_t HAL_UART_Transmit_Poll(UART_ID uartID, uint8_t *buf, int32_t size);
 int32_t HAL_UART_Receive_Poll(UART_ID uartID, uint8_t *buf, int32_t size, uint32_t msec);
 
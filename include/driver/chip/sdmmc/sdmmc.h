@@ -459,6 +459,37 @@ extern int32_t mmc_block_read(struct mmc_card *card, uint8_t *buf, uint64_t sblk
  */
 extern int32_t mmc_block_write(struct mmc_card *card, const uint8_t *buf, uint64_t sblk, uint32_t nblk);
 
+/**
+ * @brief write SD card from two buffers in one transfer.
+ * @param card:
+ *        @arg card->card handler.
+ * @param buf0:
+ *        @arg buf0->data of the first blocks.
+ * @param nblk0:
+ *        @arg nblk0->number of blocks in buf0.
+ * @param buf1:
+ *        @arg buf1->data of the following blocks.
+ * @param nblk1:
+ *        @arg nblk1->number of blocks in buf1.
+ * @param sblk:
+ *        @arg sblk->start block num.
+ * @retval  0 if success or other if failed.
+ */
+extern int32_t mmc_block_write2(struct mmc_card *card, const uint8_t *buf0, uint32_t nblk0,
+                                const uint8_t *buf1, uint32_t nblk1, uint64_t sblk);
+
+/**
+ * @brief erase SD card blocks, the card may then read them as 0 or 0xff.
+ * @param card:
+ *        @arg card->card handler.
+ * @param sblk:
+ *        @arg sblk->start block num.
+ * @param nblk:
+ *        @arg nblk->number of blocks.
+ * @retval  0 if success or other if failed.
+ */
+extern int32_t mmc_erase(struct mmc_card *card, uint64_t sblk, uint32_t nblk);
+
 /**
  * @brief scan or rescan SD card.
  * @param card:
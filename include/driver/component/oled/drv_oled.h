@@ -56,6 +56,10 @@ typedef struct {
 	 GPIO_Pin oled_reset_Pin;		/*!< The spi reset io seclet */
 }Oled_Config;
 
+/*
+ * The draws go to the framebuffer of oled_fb.h, which sends what changed
+ * before they return, or from its task once oled_fb_task_start() was called.
+ */
 Component_Status DRV_Oled_Pnxm_Bmp(uint8_t column, uint8_t page, uint8_t width, uint8_t hight, const uint8_t *bmp);
 Component_Status  DRV_Oled_Showchar_1608(uint8_t x, uint8_t y, uint8_t chr);
 Component_Status DRV_Oled_Show_Str_1608(uint8_t column, uint8_t page, const char* str);
@@ -0,0 +1,128 @@
+/**
+  * @file  oled_fb.h
+  * @author  XRADIO IOT WLAN Team
+  */
+
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _OLED_FB_H_
+#define _OLED_FB_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * RAM framebuffer of the 128x64 panel. Row y is bit (7 - y % 8) of the byte
+ * of column x in page y / 8, page 0 at the top, the layout of the font and
+ * of the bitmaps of DRV_Oled_Pnxm_Bmp(). The draws mark the columns they
+ * change in each page, and a flush sends the changed part of the marked
+ * area as one window, or page by page when that is less bytes.
+ */
+#define OLED_FB_WIDTH		128
+#define OLED_FB_HEIGHT		64
+#define OLED_FB_PAGES		(OLED_FB_HEIGHT / 8)
+
+#define OLED_FB_FONT_WIDTH	8
+#define OLED_FB_FONT_HEIGHT	16
+
+/* Async flush task, 0 leaves out oled_fb_task_start() */
+#ifndef OLED_FB_TASK
+#define OLED_FB_TASK		1
+#endif
+
+typedef enum {
+	OLED_FB_BLACK = 0,
+	OLED_FB_WHITE,
+	OLED_FB_INVERT,
+} oled_fb_color;
+
+/**
+  * @brief The controller interface of the flush.
+  */
+typedef struct {
+	/* Send len command bytes, 0 on success */
+	int (*cmd)(const uint8_t *cmd, uint32_t len);
+	/* Send len bytes to the display RAM in one transfer, 0 on success */
+	int (*data)(const uint8_t *data, uint32_t len);
+} oled_fb_ops;
+
+typedef struct {
+	uint32_t flushes;		/* flushes that sent something */
+	uint32_t clean;			/* flushes with nothing changed */
+	uint32_t windows;		/* address windows sent */
+	uint32_t cmd_bytes;
+	uint32_t data_bytes;
+	uint32_t max_bytes;		/* most bytes of one flush */
+} oled_fb_stat;
+
+/* ops are kept, the panel is assumed black and in horizontal addressing */
+int oled_fb_init(const oled_fb_ops *ops);
+void oled_fb_deinit(void);
+
+void oled_fb_clear(void);
+void oled_fb_pixel(int x, int y, oled_fb_color color);
+void oled_fb_line(int x0, int y0, int x1, int y1, oled_fb_color color);
+void oled_fb_rect(int x, int y, int w, int h, oled_fb_color color);
+void oled_fb_fill_rect(int x, int y, int w, int h, oled_fb_color color);
+/* Copy a w x h bitmap of pages of w bytes, it replaces the pixels under it */
+void oled_fb_bitmap(int x, int y, int w, int h, const uint8_t *bmp);
+/* Copy len bytes to page page from column x, the DRV_Oled_P8xnstr() write */
+void oled_fb_page_write(int x, int page, const uint8_t *data, int len);
+/* Draw in the 8x16 font, return the x after the text */
+int oled_fb_char(int x, int y, char c);
+int oled_fb_text(int x, int y, const char *str);
+
+/* Send the changes to the panel, return the bytes sent or -1 on error */
+int oled_fb_flush(void);
+/* Mark the whole panel changed, e.g. after it was reset */
+void oled_fb_invalidate(void);
+/* Copy the framebuffer, OLED_FB_PAGES * OLED_FB_WIDTH bytes */
+void oled_fb_read(uint8_t *buf);
+void oled_fb_get_stat(oled_fb_stat *stat, int reset);
+
+#if OLED_FB_TASK
+/*
+ * Flush from a task instead of the caller: oled_fb_kick() wakes it, and it
+ * flushes at most max_fps times a second, the kicks in between are merged.
+ */
+int oled_fb_task_start(uint32_t max_fps);
+void oled_fb_task_stop(void);
+/* Flush now if no task runs */
+void oled_fb_kick(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _OLED_FB_H_ */
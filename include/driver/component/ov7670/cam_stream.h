@@ -0,0 +1,104 @@
+/**
+  * @file  cam_stream.h
+  * @author  XRADIO IOT WLAN Team
+  */
+
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _CAM_STREAM_H_
+#define _CAM_STREAM_H_
+
+#include <stdint.h>
+#include "driver/component/ov7670/jpeg_enc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Camera pipeline of the OV7670: the CSI fills a ring of strips of
+ * JPEG_ENC_STRIP_LINES lines, a task encodes each strip as it comes into a
+ * frame buffer, and the finished frames wait in a bounded queue for any
+ * number of readers. A reader gets the newest frame and holds it until it
+ * puts it back, the encoder reuses the oldest frame nobody holds and drops
+ * the frame when there is none. The camera is powered and initialized by
+ * the caller, at QVGA.
+ */
+typedef struct {
+	uint16_t width;
+	uint16_t height;
+	uint8_t yuv;			/* 1 for YUV422 out of the camera, 0 for RGB565 */
+	uint8_t quality;		/* 1 - 100 */
+	uint8_t clk_div;		/* of the camera clock, the lines must come no faster than they are encoded */
+	uint8_t strip_num;		/* strips in the ring, 2 at least */
+	uint8_t frame_num;		/* frames in the queue, 2 at least */
+	uint32_t frame_size;	/* bytes of a frame buffer, a bigger frame is dropped */
+} cam_stream_cfg;
+
+#define CAM_STREAM_CFG_DEFAULT	{ 320, 240, 1, 50, 3, 3, 3, 16 * 1024 }
+
+typedef struct {
+	uint32_t seq;			/* 1 for the first frame */
+	uint32_t ticks;			/* OS_GetTicks() at the end of the frame */
+	uint32_t len;
+	uint8_t *data;
+	uint32_t refs;			/* private */
+	uint8_t state;			/* private */
+} cam_stream_frame;
+
+typedef struct {
+	uint32_t frames;		/* frames out of the camera */
+	uint32_t encoded;		/* frames put in the queue */
+	uint32_t drop_ring;		/* frames with strips lost, the encoder was behind */
+	uint32_t drop_busy;		/* frames with no buffer free, the readers were behind */
+	uint32_t drop_size;		/* frames bigger than frame_size */
+	uint32_t bytes;			/* of the frames in the queue */
+	uint32_t max_len;
+	uint32_t enc_us;		/* encoding time of the frames in the queue */
+	uint32_t enc_us_max;
+	uint32_t ram;			/* bytes allocated by cam_stream_start() */
+} cam_stream_stat;
+
+int cam_stream_start(const cam_stream_cfg *cfg);
+void cam_stream_stop(void);
+/* Takes effect at the next frame */
+int cam_stream_set_quality(uint8_t quality);
+
+/* Wait for a frame newer than seq and hold it, NULL on timeout */
+cam_stream_frame *cam_stream_get(uint32_t seq, uint32_t timeout_ms);
+void cam_stream_put(cam_stream_frame *frame);
+
+void cam_stream_get_stat(cam_stream_stat *stat, int reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CAM_STREAM_H_ */
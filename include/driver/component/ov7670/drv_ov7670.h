@@ -102,6 +102,28 @@ typedef enum {
 	IMAGE_VINTAGE,
 } OV7670_SPECAIL_EFFECTS;
 
+/**
+  * @brief Output format.
+  */
+typedef enum {
+	OV7670_OUTPUT_RGB565, /*!< The default, high byte first */
+	OV7670_OUTPUT_YUV422, /*!< Y U Y V */
+} OV7670_OUTPUT_FORMAT;
+
+/**
+  * @brief Config the strip capture.
+  */
+typedef struct {
+	uint8_t *buf;         /*!< strip_num strips of strip_size bytes */
+	uint32_t strip_size;  /*!< A multiple of the line, 640 bytes at QVGA */
+	uint32_t strip_num;   /*!< 2 at least */
+	/* Called in the interrupt, strip index % strip_num holds len bytes */
+	void (*strip_done)(uint32_t index, uint32_t len, void *arg);
+	/* Called in the interrupt at the end of a frame of len bytes, drop if strips were lost */
+	void (*frame_done)(uint32_t len, int drop, void *arg);
+	void *arg;
+} Ov7670_StripCfg;
+
 /**
   * @brief Config power ctrl.
   */
@@ -119,6 +141,8 @@ Component_Status Drv_Ov7670_Init();
 Component_Status Drv_Ov7670_Capture_Enable(CSI_CAPTURE_MODE mode , CSI_CTRL ctrl);
 void Drv_Ov7670_Set_SaveImage_Buff(uint32_t image_buff_addr);
 uint32_t Drv_Ov7670_Capture_Componemt(uint32_t timeout_ms);
+Component_Status Drv_Ov7670_Set_Strip_Buff(const Ov7670_StripCfg *cfg);
+void Drv_Ov7670_Strip_Release(uint32_t num);
 void Drv_Ov7670_Uart_Send_Picture(void *buf, uint32_t image_size);
 void Drv_Ov7670_DeInit();
 
@@ -128,6 +152,8 @@ void Drv_OV7670_Contrast(OV7670_CONTARST contrast);
 void Drv_OV7670_Light_Mode(OV7670_LIGHT_MODE light_mode);
 void Drv_OV7670_Color_Saturation(OV7670_COLOR_SATURATION sat);
 void Drv_OV7670_Brightness(OV7670_BRIGHTNESS bright);
+void Drv_OV7670_Output_Format(OV7670_OUTPUT_FORMAT format);
+void Drv_OV7670_Clock_Div(uint8_t div);
 
 Component_Status Ov7670_Demo();
 
@@ -0,0 +1,96 @@
+/**
+  * @file  jpeg_enc.h
+  * @author  XRADIO IOT WLAN Team
+  */
+
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _JPEG_ENC_H_
+#define _JPEG_ENC_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Baseline JPEG encoder in fixed point, fed by strips of lines so that a
+ * frame never has to be in RAM as a whole. The chroma is subsampled
+ * horizontally (H2V1), which is what YUYV gives, so an MCU is 16x8 pixels
+ * and a strip is 8 lines. The output goes out through the write callback
+ * in pieces of up to JPEG_ENC_OUT_SIZE bytes.
+ */
+#define JPEG_ENC_STRIP_LINES	8
+#define JPEG_ENC_OUT_SIZE		512
+
+typedef enum {
+	JPEG_ENC_YUYV = 0,		/* Y0 U Y1 V, the YUV output of the OV7670 */
+	JPEG_ENC_RGB565,		/* high byte first, the RGB output of the OV7670 */
+} jpeg_enc_format;
+
+/* Take len bytes of the JPEG stream, 0 on success */
+typedef int (*jpeg_enc_write)(void *arg, const uint8_t *data, uint32_t len);
+
+typedef struct {
+	uint16_t width;			/* even */
+	uint16_t height;
+	jpeg_enc_format format;
+	uint8_t quality;		/* 1 - 100, the IJG scale */
+	jpeg_enc_write write;
+	void *arg;
+} jpeg_enc_cfg;
+
+typedef struct jpeg_enc jpeg_enc;
+
+jpeg_enc *jpeg_enc_create(const jpeg_enc_cfg *cfg);
+void jpeg_enc_destroy(jpeg_enc *enc);
+/* Bytes allocated by jpeg_enc_create() */
+uint32_t jpeg_enc_mem_size(void);
+/* Takes effect at the next frame */
+int jpeg_enc_set_quality(jpeg_enc *enc, uint8_t quality);
+
+/* Write the headers, a frame that was not finished is dropped */
+int jpeg_enc_frame_start(jpeg_enc *enc);
+/*
+ * Encode lines lines of stride bytes from src. lines is a multiple of
+ * JPEG_ENC_STRIP_LINES, except for the last lines of the frame.
+ */
+int jpeg_enc_strip(jpeg_enc *enc, const uint8_t *src, uint32_t stride, uint32_t lines);
+/* Write the end of the stream, -1 if lines are missing or a write failed */
+int jpeg_enc_frame_end(jpeg_enc *enc);
+/* Bytes written in the current or last frame */
+uint32_t jpeg_enc_frame_size(jpeg_enc *enc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _JPEG_ENC_H_ */
@@ -0,0 +1,54 @@
+/*-----------------------------------------------------------------------/
+/  Sector cache between FatFs and the disk drivers                      /
+/-----------------------------------------------------------------------*/
+
+#ifndef _DISKCACHE_DEFINED
+#define _DISKCACHE_DEFINED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "fs/fatfs/diskio.h"
+
+
+/* Device I/O under the cache */
+
+typedef struct {
+	DRESULT	(*read)(BYTE* buff, DWORD sector, UINT count);
+	DRESULT	(*write)(const BYTE* buff, DWORD sector, UINT count);
+	DRESULT	(*sync)(void);
+} DISKCACHE_OPS;
+
+
+/* Cache statistics (DISKCACHE_STAT) */
+
+typedef struct {
+	DWORD	meta_hits;		/* FAT, directory and FSInfo sectors read from the cache */
+	DWORD	meta_misses;	/* and read from the device */
+	DWORD	data_hits;		/* Single data sectors read from the cache */
+	DWORD	data_misses;	/* and read from the device */
+	DWORD	bypasses;		/* Multiple sector transfers passed to the device */
+	DWORD	write_hits;		/* Writes to a sector already in the cache */
+	DWORD	write_backs;	/* Dirty sectors written to the device */
+	DWORD	evictions;		/* Sectors dropped for another */
+	DWORD	flushes;		/* Calls of disk_cache_flush */
+} DISKCACHE_STAT;
+
+
+/*---------------------------------------*/
+/* Prototypes for the cache functions    */
+
+DRESULT disk_cache_attach (BYTE pdrv, const DISKCACHE_OPS* ops);
+void disk_cache_detach (BYTE pdrv);
+DRESULT disk_cache_read (BYTE pdrv, BYTE* buff, DWORD sector, UINT count, BYTE meta);
+DRESULT disk_cache_write (BYTE pdrv, const BYTE* buff, DWORD sector, UINT count, BYTE meta);
+DRESULT disk_cache_flush (BYTE pdrv);
+void disk_cache_trim (BYTE pdrv, DWORD start, DWORD end);
+DRESULT disk_cache_stat (BYTE pdrv, DISKCACHE_STAT* st, BYTE reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
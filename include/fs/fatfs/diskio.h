@@ -35,6 +35,10 @@ DRESULT disk_read (BYTE pdrv, BYTE* buff, DWORD sector, UINT count);
 DRESULT disk_write (BYTE pdrv, const BYTE* buff, DWORD sector, UINT count);
 DRESULT disk_ioctl (BYTE pdrv, BYTE cmd, void* buff);
 
+/* FAT, directory and FSInfo sectors (needed at _USE_DISKCACHE == 1) */
+DRESULT disk_read_meta (BYTE pdrv, BYTE* buff, DWORD sector, UINT count);
+DRESULT disk_write_meta (BYTE pdrv, const BYTE* buff, DWORD sector, UINT count);
+
 
 /* Disk Status Bits (DSTATUS) */
 
@@ -209,6 +209,23 @@ typedef struct {
 
 
 
+#if _USE_SEEKCACHE
+/* Seek statistics (FFSEEKSTAT) */
+
+typedef struct {
+	DWORD	seeks;			/* Calls of f_lseek */
+	DWORD	map_seeks;		/* Seeks done with a link map */
+	DWORD	hits;			/* Link maps found in the cache */
+	DWORD	builds;			/* Link maps built */
+	DWORD	links;			/* FAT links followed by the seeks and the builds */
+	DWORD	max_links;		/* Most links followed by one seek */
+	DWORD	ms;				/* Time spent in the seeks */
+	DWORD	max_ms;			/* Longest seek */
+} FFSEEKSTAT;
+#endif
+
+
+
 /* File function return code (FRESULT) */
 
 typedef enum {
@@ -273,6 +290,10 @@ int f_puts (const TCHAR* str, FIL* cp);								/* Put a string to the file */
 int f_printf (FIL* fp, const TCHAR* str, ...);						/* Put a formatted string to the file */
 TCHAR* f_gets (TCHAR* buff, int len, FIL* fp);						/* Get a string from the file */
 
+#if _USE_SEEKCACHE
+FRESULT f_seekstat (FFSEEKSTAT* st, BYTE reset);					/* Get the seek statistics */
+#endif
+
 #define f_eof(fp) ((int)((fp)->fptr == (fp)->obj.objsize))
 #define f_error(fp) ((fp)->err)
 #define f_tell(fp) ((fp)->fptr)
@@ -306,6 +327,11 @@ void ff_memfree (void* mblock);			/* Free memory block */
 #endif
 #endif
 
+/* Time function of the seek statistics */
+#if _USE_SEEKCACHE
+DWORD ff_get_ms (void);
+#endif
+
 /* Sync functions */
 #if _FS_REENTRANT
 int ff_cre_syncobj (BYTE vol, _SYNC_t* sobj);	/* Create a sync object */
@@ -47,6 +47,43 @@
 /* This option switches fast seek function. (0:Disable or 1:Enable) */
 
 
+#ifndef _USE_SEEKCACHE
+#define	_USE_SEEKCACHE	1
+#endif
+#define	_SEEKCACHE_ENTRIES	4
+#define	_SEEKCACHE_MAX_SIZE	1024
+#define	_SEEKCACHE_MIN_LINKS	16
+/* This option switches the seek cache. (0:Disable or 1:Enable)
+/
+/  A seek in a file opened without FA_WRITE that has to follow at least
+/  _SEEKCACHE_MIN_LINKS links of the cluster chain builds a link map of the file.
+/  The map is kept for the next opens of the file, up to _SEEKCACHE_ENTRIES maps
+/  in LRU order, and dropped when a chain on the volume is removed or the volume
+/  is remounted. A map takes 8 bytes per fragment of the file, but at most
+/  _SEEKCACHE_MAX_SIZE bytes; a file in more fragments is mapped every n-th
+/  cluster instead, so a seek follows less than n links. Unlike _USE_FASTSEEK,
+/  it does not change the FIL structure. _USE_LFN must be 3 (ff_memalloc) and
+/  ff_get_ms() is needed for f_seekstat(). */
+
+
+#ifndef _USE_DISKCACHE
+#define	_USE_DISKCACHE	1
+#endif
+#ifndef _DISKCACHE_SECTORS
+#define	_DISKCACHE_SECTORS	16
+#endif
+#define	_DISKCACHE_PINNED	8
+/* This option switches the sector cache of diskcache.c between FatFs and the
+/  SD card driver. (0:Disable or 1:Enable)
+/
+/  Single sector reads and writes are kept in _DISKCACHE_SECTORS sectors of
+/  the heap in LRU order. The FAT, directory and FSInfo sectors of the window
+/  take up to _DISKCACHE_PINNED of them, which file data does not evict.
+/  Writes stay in the cache until they are evicted or CTRL_SYNC, sent by
+/  f_sync(), f_close() and the unmount, writes them back. Multiple sector
+/  transfers go to the driver directly. */
+
+
 #define	_USE_EXPAND		0
 /* This option switches f_expand function. (0:Disable or 1:Enable) */
 
@@ -178,10 +215,13 @@
 /  the disk_ioctl() function. */
 
 
+#ifndef _USE_TRIM
 #define	_USE_TRIM	0
+#endif
 /* This option switches support of ATA-TRIM. (0:Disable or 1:Enable)
 /  To enable Trim function, also CTRL_TRIM command should be implemented to the
-/  disk_ioctl() function. */
+/  disk_ioctl() function. The SD card driver erases the sectors, which keeps
+/  the card busy up to seconds on removing a large file. */
 
 
 #define _FS_NOFSINFO	0
@@ -208,6 +208,29 @@ See http://www.FreeRTOS.org/RTOS-Cortex-M3-M4.html. */
 #endif
 
 /* A header file that defines trace macro can be included here. */
+#if (defined(__CONFIG_OS_TRACE) && !defined(__CONFIG_BOOTLOADER))
+#define configDEBUG_TRACE_EN                    1 /* trace recorder, see tracebuf.h */
+#include "kernel/FreeRTOS/tracehook.h"
+#else
+#define configDEBUG_TRACE_EN                    0
+#endif
+
+/* release the heap trace slot of a deleted thread, see wrap_malloc.c */
+#if (defined(__CONFIG_MALLOC_USE_STDLIB) && defined(__CONFIG_MALLOC_TRACE) && \
+     !defined(__CONFIG_BOOTLOADER))
+extern void wrap_malloc_thread_delete(void *handle);
+#if configDEBUG_TRACE_EN
+/* chain the hook of the trace recorder, vTraceTaskDelete() of tracehook.h */
+#undef traceTASK_DELETE
+#define traceTASK_DELETE(pxTCB)                         \
+	do {                                            \
+		vTraceTaskDelete((pxTCB)->uxTaskNumber);    \
+		wrap_malloc_thread_delete(pxTCB);           \
+	} while (0)
+#else
+#define traceTASK_DELETE(pxTCB)                 wrap_malloc_thread_delete(pxTCB)
+#endif
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////
 
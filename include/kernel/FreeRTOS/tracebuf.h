@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __TRACEBUF_H__
+#define __TRACEBUF_H__
+
+#include "kernel/FreeRTOS/FreeRTOS.h"
+
+#if (configDEBUG_TRACE_EN == 1)
+
+#include "kernel/FreeRTOS/tracehook.h"
+
+/*
+ * Trace recorder
+ *
+ * Records scheduler and IPC activity into a binary ring buffer of
+ * fixed-size events stamped with the CPU cycle counter, and keeps per-thread,
+ * per-IRQ and per-lock statistics while recording. OSTraceDump() streams a
+ * self-describing image (header, thread table, events oldest first) that
+ * tools/trace/xrtrace.py turns into Chrome trace JSON for Perfetto or
+ * chrome://tracing.
+ *
+ * Timestamps are the low 32 bits of the cycle counter; the decoder unwraps
+ * them, so two consecutive events must be less than 2^32 cycles apart.
+ */
+
+#define TRACE_MAGIC             0x52545258 /* "XRTR" */
+#define TRACE_VERSION           1
+
+#define TRACE_NAME_LEN          16
+#define TRACE_THREAD_MAX        32 /* slot 0 collects threads beyond the table */
+#define TRACE_IRQ_MAX           64
+#define TRACE_LOCK_MAX          16
+#define TRACE_ISR_NEST_MAX      8
+
+/* event types */
+#define TRACE_EV_SWITCH_IN      1  /* tid: thread now running */
+#define TRACE_EV_SWITCH_OUT     2  /* sub: TRACE_OUT_xxx */
+#define TRACE_EV_READY          3  /* tid: thread made ready */
+#define TRACE_EV_BLOCK          4  /* sub: TRACE_BLOCK_xxx, arg: object */
+#define TRACE_EV_ISR_ENTER      5  /* arg: irq number */
+#define TRACE_EV_ISR_EXIT       6  /* arg: irq number */
+#define TRACE_EV_SEND           7  /* sub: class | TRACE_OP_xxx flags, arg: object */
+#define TRACE_EV_RECV           8  /* sub: class | TRACE_OP_xxx flags, arg: object */
+#define TRACE_EV_PRIO_INHERIT   9  /* tid: mutex holder, arg: new priority */
+#define TRACE_EV_CREATE         10 /* tid: new thread */
+#define TRACE_EV_DELETE         11 /* tid: deleted thread */
+#define TRACE_EV_MARK           12 /* sub: marker id, arg: user value */
+#define TRACE_EV_SPAN_BEGIN     13 /* sub: span id, arg: user value */
+#define TRACE_EV_SPAN_END       14 /* sub: span id, arg: user value */
+#define TRACE_EV_STOP           15 /* statistics settled */
+
+/* TRACE_EV_SWITCH_OUT reasons */
+#define TRACE_OUT_PREEMPT       0
+#define TRACE_OUT_BLOCK         1
+#define TRACE_OUT_DELETE        2
+
+/* object class, low bits of the sub field of send/receive events */
+#define TRACE_CLASS_SHIFT       4
+#define TRACE_CLASS_QUEUE       0
+#define TRACE_CLASS_MUTEX       1
+#define TRACE_CLASS_SEM         2
+
+/* recording modes */
+#define TRACE_MODE_WRAP         0 /* overwrite the oldest events */
+#define TRACE_MODE_ONESHOT      1 /* stop recording when the buffer is full */
+
+typedef struct {
+	uint32_t ts;        /* cycle counter, low 32 bits */
+	uint8_t  type;      /* TRACE_EV_xxx */
+	uint8_t  sub;
+	uint16_t tid;       /* uxTCBNumber of the running thread */
+	uint32_t arg;
+} OSTraceEvent;
+
+/* dump image: header, thread_num thread records, event_num events */
+typedef struct {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t hdr_size;
+	uint32_t cpu_hz;
+	uint16_t thread_num;
+	uint16_t event_size;
+	uint32_t event_num;
+	uint32_t dropped;
+	uint8_t  mode;
+	uint8_t  rsv[3];
+} OSTraceHeader;
+
+typedef struct {
+	uint16_t tid;
+	uint8_t  alive;
+	uint8_t  rsv;
+	char     name[TRACE_NAME_LEN];
+} OSTraceThreadRec;
+
+typedef struct {
+	uint16_t tid;
+	uint8_t  alive;
+	char     name[TRACE_NAME_LEN];
+	uint64_t run;                       /* cycles on the CPU, ISRs excluded */
+	uint64_t ready;                     /* cycles runnable but not running */
+	uint64_t blocked[TRACE_BLOCK_NUM];  /* cycles blocked, by reason */
+	uint32_t switches;                  /* times switched in */
+	uint32_t preempts;                  /* times switched out while runnable */
+} OSTraceThreadStat;
+
+typedef struct {
+	uint32_t count;
+	uint64_t total;                     /* cycles, nested IRQs included */
+	uint32_t max;
+} OSTraceIrqStat;
+
+typedef struct {
+	const void *obj;
+	uint8_t  reason;                    /* TRACE_BLOCK_xxx */
+	uint32_t waits;
+	uint64_t total;                     /* cycles threads spent blocked on it */
+	uint32_t max;
+} OSTraceLockStat;
+
+typedef struct {
+	uint32_t cpu_hz;
+	uint64_t elapsed;                   /* cycles recorded */
+	uint64_t isr;                       /* cycles in ISRs */
+	uint32_t event_num;                 /* events in the buffer */
+	uint32_t event_max;
+	uint32_t dropped;                   /* events overwritten or not recorded */
+	uint8_t  mode;
+	uint8_t  running;
+} OSTraceInfo;
+
+typedef int (*OSTraceWrite)(const void *buf, uint32_t len, void *arg);
+
+/*
+ * size: buffer size in bytes, the buffer is allocated on the heap.
+ * Restarting discards the previous events and statistics.
+ */
+extern int OSTraceStart(uint32_t size, uint8_t mode);
+extern void OSTraceStop(void);
+extern void OSTraceFree(void);
+
+extern void OSTraceMark(uint8_t id, uint32_t arg);
+extern void OSTraceSpanBegin(uint8_t id, uint32_t arg);
+extern void OSTraceSpanEnd(uint8_t id, uint32_t arg);
+
+/* called around peripheral interrupt handlers, see HAL_NVIC_SetIRQHandler() */
+extern void OSTraceIsrEnter(uint32_t irq);
+extern void OSTraceIsrExit(uint32_t irq);
+
+extern void OSTraceGetInfo(OSTraceInfo *info);
+extern int OSTraceGetThreadStat(OSTraceThreadStat *st, int num);
+extern int OSTraceGetIrqStat(OSTraceIrqStat *st, int num);
+extern int OSTraceGetLockStat(OSTraceLockStat *st, int num);
+
+/* stops recording, returns the image size or -1 if write() failed */
+extern int32_t OSTraceDump(OSTraceWrite write, void *arg);
+
+#else
+
+static inline int OSTraceStart(uint32_t size, uint8_t mode) { return -1; }
+static inline void OSTraceStop(void) { ; }
+static inline void OSTraceFree(void) { ; }
+static inline void OSTraceMark(uint8_t id, uint32_t arg) { ; }
+static inline void OSTraceSpanBegin(uint8_t id, uint32_t arg) { ; }
+static inline void OSTraceSpanEnd(uint8_t id, uint32_t arg) { ; }
+static inline void OSTraceIsrEnter(uint32_t irq) { ; }
+static inline void OSTraceIsrExit(uint32_t irq) { ; }
+
+#endif
+#endif /* __TRACEBUF_H__ */
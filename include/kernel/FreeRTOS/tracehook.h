@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __TRACEHOOK_H__
+#define __TRACEHOOK_H__
+
+/*
+ * Kernel trace macros routed to the trace recorder (tracebuf.c).
+ *
+ * Included from FreeRTOSConfig.h, before the kernel types exist, so only
+ * plain C types are used here. The macros are expanded inside tasks.c,
+ * queue.c and event_groups.c, which is why they can reach pxCurrentTCB and
+ * the queue type. Each task keeps its recorder slot in uxTaskNumber, the
+ * TCB field FreeRTOS reserves for trace code.
+ */
+
+#include <stdint.h>
+
+/* why a thread left the CPU */
+#define TRACE_BLOCK_MUTEX       0
+#define TRACE_BLOCK_SEM         1
+#define TRACE_BLOCK_QUEUE       2
+#define TRACE_BLOCK_EVENT       3
+#define TRACE_BLOCK_NOTIFY      4
+#define TRACE_BLOCK_DELAY       5
+#define TRACE_BLOCK_SUSPEND     6
+#define TRACE_BLOCK_NUM         7
+
+/* queue operations */
+#define TRACE_OP_SEND           0
+#define TRACE_OP_RECV           1
+#define TRACE_OP_FAILED         0x2
+#define TRACE_OP_ISR            0x4
+
+extern uint32_t uxTraceTaskCreate(uint32_t tcb_num, const char *name);
+extern void vTraceTaskDelete(uint32_t slot);
+extern void vTraceTaskSwitchedOut(uint32_t slot);
+extern void vTraceTaskSwitchedIn(uint32_t slot);
+extern void vTraceTaskReady(uint32_t slot);
+extern void vTraceTaskSuspend(uint32_t slot);
+extern void vTraceTaskPrioInherit(uint32_t slot, uint32_t prio);
+extern void vTraceBlock(uint32_t reason, const void *obj);
+extern void vTraceQueueBlock(const void *queue, uint8_t type, uint32_t op);
+extern void vTraceQueueOp(const void *queue, uint8_t type, uint32_t op);
+
+#define traceTASK_CREATE(pxNewTCB) \
+	(pxNewTCB)->uxTaskNumber = uxTraceTaskCreate((pxNewTCB)->uxTCBNumber, (pxNewTCB)->pcTaskName)
+#define traceTASK_DELETE(pxTCB)                     vTraceTaskDelete((pxTCB)->uxTaskNumber)
+#define traceTASK_SWITCHED_OUT()                    vTraceTaskSwitchedOut(pxCurrentTCB->uxTaskNumber)
+#define traceTASK_SWITCHED_IN()                     vTraceTaskSwitchedIn(pxCurrentTCB->uxTaskNumber)
+#define traceMOVED_TASK_TO_READY_STATE(pxTCB)       vTraceTaskReady((pxTCB)->uxTaskNumber)
+#define traceTASK_SUSPEND(pxTCB)                    vTraceTaskSuspend((pxTCB)->uxTaskNumber)
+#define traceTASK_PRIORITY_INHERIT(pxTCB, uxPrio)   vTraceTaskPrioInherit((pxTCB)->uxTaskNumber, (uxPrio))
+
+#define traceTASK_DELAY()                           vTraceBlock(TRACE_BLOCK_DELAY, 0)
+#define traceTASK_DELAY_UNTIL()                     vTraceBlock(TRACE_BLOCK_DELAY, 0)
+#define traceTASK_NOTIFY_TAKE_BLOCK()               vTraceBlock(TRACE_BLOCK_NOTIFY, 0)
+#define traceTASK_NOTIFY_WAIT_BLOCK()               vTraceBlock(TRACE_BLOCK_NOTIFY, 0)
+#define traceEVENT_GROUP_WAIT_BITS_BLOCK(xEventGroup, uxBitsToWaitFor) \
+	vTraceBlock(TRACE_BLOCK_EVENT, (xEventGroup))
+#define traceEVENT_GROUP_SYNC_BLOCK(xEventGroup, uxBitsToSet, uxBitsToWaitFor) \
+	vTraceBlock(TRACE_BLOCK_EVENT, (xEventGroup))
+
+#define traceBLOCKING_ON_QUEUE_SEND(pxQueue) \
+	vTraceQueueBlock((pxQueue), (pxQueue)->ucQueueType, TRACE_OP_SEND)
+#define traceBLOCKING_ON_QUEUE_RECEIVE(pxQueue) \
+	vTraceQueueBlock((pxQueue), (pxQueue)->ucQueueType, TRACE_OP_RECV)
+
+#define traceQUEUE_SEND(pxQueue) \
+	vTraceQueueOp((pxQueue), (pxQueue)->ucQueueType, TRACE_OP_SEND)
+#define traceQUEUE_SEND_FAILED(pxQueue) \
+	vTraceQueueOp((pxQueue), (pxQueue)->ucQueueType, TRACE_OP_SEND | TRACE_OP_FAILED)
+#define traceQUEUE_RECEIVE(pxQueue) \
+	vTraceQueueOp((pxQueue), (pxQueue)->ucQueueType, TRACE_OP_RECV)
+#define traceQUEUE_RECEIVE_FAILED(pxQueue) \
+	vTraceQueueOp((pxQueue), (pxQueue)->ucQueueType, TRACE_OP_RECV | TRACE_OP_FAILED)
+#define traceQUEUE_SEND_FROM_ISR(pxQueue) \
+	vTraceQueueOp((pxQueue), (pxQueue)->ucQueueType, TRACE_OP_SEND | TRACE_OP_ISR)
+#define traceQUEUE_RECEIVE_FROM_ISR(pxQueue) \
+	vTraceQueueOp((pxQueue), (pxQueue)->ucQueueType, TRACE_OP_RECV | TRACE_OP_ISR)
+
+#endif /* __TRACEHOOK_H__ */
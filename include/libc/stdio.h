@@ -5,6 +5,10 @@
 
 #ifdef __CONFIG_LIBC_WRAP_STDIO
 
+#ifdef __CONFIG_LIBC_WRAP_STDIO_DEFER
+#include <stdint.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -16,6 +20,34 @@ void stdio_set_write(stdio_write_fn fn);
 void stdout_mutex_lock(void);
 void stdout_mutex_unlock(void);
 
+#ifdef __CONFIG_LIBC_WRAP_STDIO_DEFER
+/**
+ * @brief Statistics of the deferred stdout ring
+ */
+typedef struct {
+	uint32_t records;	/* messages queued */
+	uint32_t dropped;	/* messages lost because the ring was full */
+	uint32_t sync;		/* messages written synchronously (too long, critical context) */
+	uint32_t max_used;	/* high water mark of the ring, in bytes */
+} stdio_defer_stats_t;
+
+int stdio_defer_start(stdio_write_fn fn);
+void stdio_defer_stop(void);
+void stdio_defer_flush(void);
+void stdio_defer_get_stats(stdio_defer_stats_t *stats);
+
+/**
+ * @brief Run-time level of the XR_DEBUG modules that have an id, see
+ *        XR_MOD_ID() of sys/xr_debug.h. Every module starts at XR_LEVEL_ALL.
+ */
+#define STDIO_DEFER_MOD_MAX	64
+
+extern uint8_t stdio_defer_mod_level[STDIO_DEFER_MOD_MAX];
+
+int stdio_defer_set_level(unsigned int id, int level);
+int stdio_defer_get_level(unsigned int id);
+#endif /* __CONFIG_LIBC_WRAP_STDIO_DEFER */
+
 #undef putc
 #undef putchar
 
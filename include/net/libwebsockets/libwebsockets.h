@@ -213,7 +213,11 @@ extern "C" {
    #endif
    #if defined(LWS_WITH_XRADIO)
     #undef MBEDTLS_CONFIG_FILE
-    #define MBEDTLS_CONFIG_FILE "net/mbedtls/configs/config-xr-mini-cliserv.h"
+    #if defined(__CONFIG_MBEDTLS_FAST_PROFILE)
+     #define MBEDTLS_CONFIG_FILE "net/mbedtls/configs/config-xr-fast-cliserv.h"
+    #else
+     #define MBEDTLS_CONFIG_FILE "net/mbedtls/configs/config-xr-mini-cliserv.h"
+    #endif
     #include "net/mbedtls/ssl.h"
    #else
     #include <mbedtls/ssl.h>
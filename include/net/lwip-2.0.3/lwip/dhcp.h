@@ -111,6 +111,9 @@ void dhcp_set_struct(struct netif *netif, struct dhcp *dhcp);
 #define dhcp_remove_struct(netif) netif_set_client_data(netif, LWIP_NETIF_CLIENT_DATA_INDEX_DHCP, NULL)
 void dhcp_cleanup(struct netif *netif);
 err_t dhcp_start(struct netif *netif);
+#if LWIP_XR_IMPL
+err_t dhcp_start_reboot(struct netif *netif, const ip4_addr_t *ipaddr);
+#endif
 err_t dhcp_renew(struct netif *netif);
 err_t dhcp_release(struct netif *netif);
 void dhcp_stop(struct netif *netif);
@@ -38,11 +38,37 @@
 
 #define MBEDTLS_ERR_AES_INVALID_KEY_LENGTH                -0x0020  /**< Invalid key length. */
 #define MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH              -0x0022  /**< Invalid data input length. */
+#define MBEDTLS_ERR_AES_HW_ACCEL_FAILED                   -0x0025  /**< Crypto engine failed or timed out. */
 
 #if defined(MBEDTLS_AES_ALT)
 // Regular implementation
 //
 
+#include "driver/chip/hal_crypto.h"
+
+/**
+ * \def MBEDTLS_AES_ALT_BULK_BLOCKS
+ *
+ * Number of blocks handed to the crypto engine in one CTR/GCM submission.
+ * HAL_AES_Encrypt() moves runs above 300 bytes by DMA, so it takes 19 blocks
+ * or more for a submission to use it. The key stream buffer is part of
+ * mbedtls_aes_context, 16 bytes per block.
+ */
+#if !defined(MBEDTLS_AES_ALT_BULK_BLOCKS)
+#define MBEDTLS_AES_ALT_BULK_BLOCKS         32
+#endif
+
+/**
+ * \def MBEDTLS_AES_ALT_SW_THRESHOLD
+ *
+ * Encryptions shorter than this many bytes are done in software instead of
+ * on the crypto engine. 0 disables the software path and its round keys in
+ * mbedtls_aes_context.
+ */
+#if !defined(MBEDTLS_AES_ALT_SW_THRESHOLD)
+#define MBEDTLS_AES_ALT_SW_THRESHOLD        0
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -58,6 +84,11 @@ extern "C" {
 typedef struct
 {
 	CE_AES_Config aes;
+    unsigned char ks[MBEDTLS_AES_ALT_BULK_BLOCKS * 16]; /*!< CTR/GCM key stream */
+#if MBEDTLS_AES_ALT_SW_THRESHOLD > 0
+    int nr;                     /*!<  number of rounds, software path  */
+    uint32_t rk[60];            /*!<  encryption round keys            */
+#endif
 }
 mbedtls_aes_context;
 
@@ -114,6 +145,28 @@ int mbedtls_aes_crypt_ecb( mbedtls_aes_context *ctx,
                     const unsigned char input[16],
                     unsigned char output[16] );
 
+/**
+ * \brief          AES-ECB encryption/decryption of several blocks in one
+ *                 crypto engine submission
+ *
+ * \note           Encryptions shorter than MBEDTLS_AES_ALT_SW_THRESHOLD
+ *                 are done in software.
+ *
+ * \param ctx      AES context
+ * \param mode     MBEDTLS_AES_ENCRYPT or MBEDTLS_AES_DECRYPT
+ * \param length   length of the input data, a multiple of 16
+ * \param input    buffer holding the input data
+ * \param output   buffer holding the output data (may equal input)
+ *
+ * \return         0 if successful, MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH
+ *                 or MBEDTLS_ERR_AES_HW_ACCEL_FAILED
+ */
+int mbedtls_aes_crypt_ecb_bulk( mbedtls_aes_context *ctx,
+                    int mode,
+                    size_t length,
+                    const unsigned char *input,
+                    unsigned char *output );
+
 #if defined(MBEDTLS_CIPHER_MODE_CBC)
 /**
  * \brief          AES-CBC buffer encryption/decryption
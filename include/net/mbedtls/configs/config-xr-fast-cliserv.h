@@ -0,0 +1,135 @@
+/*
+ *  Fast configuration for TLS 1.2 clients and servers on XRadio
+ *
+ *  Copyright (C) 2006-2015, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of mbed TLS (https://tls.mbed.org)
+ */
+/*
+ * Fast configuration for TLS 1.2 (RFC 5246) clients and servers.
+ *
+ * Prefers ECDHE key exchange on secp256r1 with AES-128-GCM, keeps RSA/CBC
+ * suites as a fallback for legacy peers, and enables session tickets and
+ * session-ID resumption so that reconnects skip the public key operations.
+ *
+ * Selected by __CONFIG_MBEDTLS_FAST_PROFILE in config.mk.
+ * See README.txt for usage instructions.
+ */
+
+#ifndef MBEDTLS_CONFIG_H
+#define MBEDTLS_CONFIG_H
+/* System support */
+#define MBEDTLS_HAVE_ASM
+#define MBEDTLS_HAVE_TIME
+//#define MBEDTLS_PLATFORM_MEMORY
+#define MBEDTLS_SSL_ALPN
+
+/* Save RAM at the expense of ROM */
+#define MBEDTLS_AES_ROM_TABLES
+
+/* AES on the crypto engine, bulk CTR/GCM submissions, see aes_alt.h */
+#define MBEDTLS_AES_ALT
+#define MBEDTLS_AES_ALT_BULK_BLOCKS         32  /* 512 bytes, DMA from 19 */
+#define MBEDTLS_AES_ALT_SW_THRESHOLD        32
+
+/* mbed TLS feature support */
+#define MBEDTLS_CIPHER_MODE_CBC
+#define MBEDTLS_PKCS1_V15
+#define MBEDTLS_ECP_DP_SECP256R1_ENABLED
+#define MBEDTLS_ECP_NIST_OPTIM
+#define MBEDTLS_KEY_EXCHANGE_RSA_ENABLED
+#define MBEDTLS_KEY_EXCHANGE_ECDHE_RSA_ENABLED
+#define MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA_ENABLED
+#define MBEDTLS_SSL_PROTO_TLS1_1
+#define MBEDTLS_SSL_PROTO_TLS1_2
+#define MBEDTLS_SSL_SESSION_TICKETS
+//#define MBEDTLS_THREADING_C
+//#define MBEDTLS_THREADING_ALT
+//#define MBEDTLS_PLATFORM_C
+
+/* mbed TLS modules */
+#define MBEDTLS_AES_C
+#define MBEDTLS_ASN1_PARSE_C
+#define MBEDTLS_ASN1_WRITE_C
+#define MBEDTLS_BIGNUM_C
+#define MBEDTLS_CIPHER_C
+#define MBEDTLS_CTR_DRBG_C
+#define MBEDTLS_ECDH_C
+#define MBEDTLS_ECDSA_C
+#define MBEDTLS_ECP_C
+#define MBEDTLS_ENTROPY_C
+#define MBEDTLS_GCM_C
+#define MBEDTLS_MD_C
+#define MBEDTLS_MD5_C
+#define MBEDTLS_NET_C
+#define MBEDTLS_OID_C
+#define MBEDTLS_PK_C
+#define MBEDTLS_PK_PARSE_C
+#define MBEDTLS_RSA_C
+#define MBEDTLS_SHA1_C
+#define MBEDTLS_SHA256_C
+#define MBEDTLS_SSL_CACHE_C
+#define MBEDTLS_SSL_CLI_C
+#define MBEDTLS_SSL_SRV_C
+#define MBEDTLS_SSL_TICKET_C
+#define MBEDTLS_SSL_TLS_C
+#define MBEDTLS_X509_CRT_PARSE_C
+#define MBEDTLS_X509_USE_C
+#define MBEDTLS_SSL_SERVER_NAME_INDICATION
+/**/
+//#define MBEDTLS_KEY_EXCHANGE_PSK_ENABLED
+//#define MBEDTLS_NO_PLATFORM_ENTROPY
+//#define MBEDTLS_ENTROPY_HARDWARE_ALT
+/**/
+/* For test certificates */
+#define MBEDTLS_BASE64_C
+#define MBEDTLS_CERTS_C
+#define MBEDTLS_PEM_PARSE_C
+#define MBEDTLS_SSL_MAX_FRAGMENT_LENGTH
+
+#define MBEDTLS_SSL_MAX_CONTENT_LEN         (4*1024)   /**< Size of the input / output buffer */
+
+/* Small ECC windows keep the scalar multiplication scratch area below 2KB */
+#define MBEDTLS_ECP_MAX_BITS                256
+#define MBEDTLS_ECP_WINDOW_SIZE             2
+#define MBEDTLS_ECP_FIXED_POINT_OPTIM       0
+
+/* Server side session-ID cache, only used by the TLS server */
+#define MBEDTLS_SSL_CACHE_DEFAULT_MAX_ENTRIES   4
+
+/* Fast suites first, legacy RSA suites kept for old servers */
+#define MBEDTLS_SSL_CIPHERSUITES                              \
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,          \
+    MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,            \
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CBC_SHA,             \
+    MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_CBC_SHA,               \
+    MBEDTLS_TLS_RSA_WITH_AES_128_GCM_SHA256,                  \
+    MBEDTLS_TLS_RSA_WITH_AES_128_CBC_SHA256,                  \
+    MBEDTLS_TLS_RSA_WITH_AES_128_CBC_SHA
+
+/* Add for XRadio */
+//#define MBEDTLS_DEBUG_C
+
+#define MBEDTLS_ON_LWIP
+
+/* Client side session resumption cache shared by MQTT, HTTPClient and nopoll */
+#define MBEDTLS_XR_SESSION_CACHE
+#define MBEDTLS_XR_SESSION_CACHE_ENTRIES    4
+
+#include "net/mbedtls/check_config.h"
+#include "driver/chip/hal_crypto.h"
+
+#endif /* MBEDTLS_CONFIG_H */
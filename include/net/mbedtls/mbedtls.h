@@ -33,6 +33,7 @@
 #include "net/mbedtls/ctr_drbg.h"
 #include "net/mbedtls/ssl.h"
 #include "net/mbedtls/net.h"
+#include "net/mbedtls/xr_ssl_session.h"
 #include "lwip/sockets.h"
 
 /**
@@ -87,6 +88,8 @@ typedef struct
 	mbedtls_ctr_drbg_context  ctr_drbg;
 	mbedtls_ssl_context       ssl;
 	mbedtls_ssl_config        conf;
+	char                      peer_host[64]; /* key of the resumption cache */
+	uint16_t                  peer_port;
 } mbedtls_context;
 
 typedef mbedtls_net_context mbedtls_sock;
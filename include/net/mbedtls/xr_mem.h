@@ -1,11 +1,6 @@
 #ifndef XR_MEM__H
 #define XR_MEM__H
 
-struct os_heap_mem {
-        void *ptr;
-        size_t size;
-};
-
 void heap_usage();
 void * XR_MALLOC(size_t size);
 void *XR_CALLOC(size_t nmemb, size_t size);
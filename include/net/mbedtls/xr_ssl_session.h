@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _NET_MBEDTLS_XR_SSL_SESSION_H_
+#define _NET_MBEDTLS_XR_SSL_SESSION_H_
+
+#include <stdint.h>
+#include "ssl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Client side TLS session resumption cache.
+ *
+ * The cache keeps the last negotiated session (session ID, master secret and
+ * session ticket) per server, so that a reconnect to the same host:port can
+ * offer it in the ClientHello and skip certificate verification and the
+ * public key operations. The peer certificate is not kept, only the verify
+ * result of the full handshake.
+ *
+ * It is only active when the library is built with MBEDTLS_XR_SESSION_CACHE
+ * (see config-xr-fast-cliserv.h), otherwise all calls are no-ops.
+ */
+
+typedef struct xr_ssl_session_stats {
+	uint32_t lookups;   /* number of xr_ssl_session_load() calls */
+	uint32_t hits;      /* cached session offered to the server */
+	uint32_t resumed;   /* offered session accepted by the server */
+	uint32_t stores;    /* sessions saved after a handshake */
+	uint32_t evictions; /* entries replaced to make room */
+	uint32_t expired;   /* entries dropped on lifetime expiry */
+} xr_ssl_session_stats_t;
+
+/**
+ * @brief Offer the cached session of host:port for the next handshake
+ * @note Must be called after mbedtls_ssl_setup() and before the handshake
+ * @retval 0 if a session was set, -1 if there is no usable entry
+ */
+int xr_ssl_session_load(mbedtls_ssl_context *ssl, const char *host, uint16_t port);
+
+/**
+ * @brief Save the session negotiated by a successful handshake
+ * @retval 0 on success, -1 on failure
+ */
+int xr_ssl_session_save(mbedtls_ssl_context *ssl, const char *host, uint16_t port);
+
+/**
+ * @brief Forget the session of host:port, eg. after a failed handshake
+ */
+void xr_ssl_session_remove(const char *host, uint16_t port);
+
+/**
+ * @brief Forget all cached sessions
+ */
+void xr_ssl_session_flush(void);
+
+void xr_ssl_session_get_stats(xr_ssl_session_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _NET_MBEDTLS_XR_SSL_SESSION_H_ */
@@ -40,6 +40,7 @@
 #define SHTTPD_SINGLE_CONNECTION
 #define SHTTPD_LOG_ALT
 #define SHTTPD_MEM_IN_HEAP
+#define SHTTPD_ZERO_COPY
 //#define SHTTPD_SSL
 //#define SHTTPD_CUSTOM_LOG_ON
 //#define SHTTPD_DEBUG_ON
@@ -53,9 +54,35 @@ struct usr_file {
 	char *body;
 };
 
+/*
+ * Asset packed by tools/shttpd_pack.py. gz_body is the gzip encoding,
+ * body the identity one, either may be NULL. Both NULL is a directory.
+ */
+struct usr_asset {
+	const char    *name;
+	const char    *body;
+	const char    *gz_body;
+	unsigned long size;
+	unsigned long gz_size;
+	unsigned long mtime;    /* Last-Modified, seconds since the epoch */
+	const char    *etag;
+};
+
+/*
+ * Perfect hash of the asset names: slots[hash & (nslots - 1)] is the
+ * asset index plus one, 0 for an empty slot.
+ */
+struct usr_asset_table {
+	const struct usr_asset *assets;
+	const unsigned short   *slots;
+	unsigned int           nslots;
+	unsigned long          seed;
+};
+
 struct f_stat {
 	unsigned long st_size;
 	unsigned int  st_mode;
+	time_t        st_mtime;
 };
 
 time_t TIME(time_t *timer);
@@ -74,6 +101,8 @@ time_t TIME(time_t *timer);
 void _shttpd_free(void *ptr);
 void *_shttpd_zalloc(size_t size);
 void _shttpd_init_local_file(const struct usr_file *list, int count);
+void _shttpd_init_assets(const struct usr_asset_table *table);
+const struct usr_asset *_shttpd_lookup_asset(const char *name);
 
 #if defined(SHTTPD_THREADS)
 #define HTTP_THREAD_STACK_SIZE	(4 * 1024)
@@ -25,5 +25,6 @@
 #define	ENV_MAX		4096		/* Size of environment block	*/
 #define	CGI_ENV_VARS	64		/* Maximum vars passed to CGI	*/
 #define	SERVICE_NAME	"SHTTPD " VERSION	/* NT service name	*/
+#define	ASSET_CACHE	"no-cache"	/* Cache-Control of packed assets */
 
 #endif /* CONFIG_HEADER_DEFINED */
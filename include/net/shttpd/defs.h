@@ -124,6 +124,8 @@ struct headers {
 	union variant   range;        /* Range:			*/
 	union variant   status;       /* Status:			*/
 	union variant   transenc;     /* Transfer-Encoding:		*/
+	union variant   inm;          /* If-None-Match:		*/
+	union variant   ae;           /* Accept-Encoding:		*/
 };
 
 /* Must go after union variant definition */
@@ -136,7 +138,7 @@ union channel {
 #if defined(SHTTPD_FS)
 	int                  fd;            /* Regular static file */
 #else
-	unsigned int         fh;            /* file handler */
+	char                 *fh;           /* file body in memory */
 #endif
 	int                  sock;          /* Connected socket	*/
 
@@ -393,6 +395,9 @@ extern int _shttpd_put_dir(const char *path);
 extern void _shttpd_get_dir(struct conn *c);
 #endif
 extern void _shttpd_get_file(struct conn *c, struct stat *stp);
+#if !defined(SHTTPD_FS)
+extern void _shttpd_get_asset(struct conn *c, const struct usr_asset *asset);
+#endif
 extern void _shttpd_ssl_handshake(struct stream *stream);
 extern void _shttpd_setup_embedded_stream(struct conn *,
                                                         union variant, void *);
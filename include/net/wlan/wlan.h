@@ -90,6 +90,7 @@ int wlan_set_appie(struct netif *nif, uint8_t type, uint8_t *ie, uint16_t ie_len
 /* STA */
 int wlan_sta_set(uint8_t *ssid, uint8_t ssid_len, uint8_t *psk);
 int wlan_sta_set_config(wlan_sta_config_t *config);
+int wlan_sta_set_config_batch(wlan_sta_config_t *config, int num);
 int wlan_sta_get_config(wlan_sta_config_t *config);
 
 int wlan_sta_enable(void);
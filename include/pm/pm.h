@@ -129,6 +129,12 @@ struct soc_device_driver {
  * @note For devices on custom boards, as typical of embedded and SOC based
  *   hardware, You uses platform_data to point to board-specific structures
  *   describing devices and how they are wired.
+ * @resume_stage:
+ *  0: resume() is called in the reverse order of suspend(), as usual.
+ *  n: resume() is called after all devices of stage 0 and of the stages
+ *     below n, together with the other devices of stage n. Devices of one
+ *     stage must not depend on each other, they run on the resume workers
+ *     in parallel, see pm_set_resume_workers().
  */
 struct soc_device {
 	struct list_head node[PM_OP_NUM];
@@ -138,6 +144,67 @@ struct soc_device {
 
 	const struct soc_device_driver *driver; /* which driver has allocated this device */
 	void *platform_data;                    /* Platform specific data, device core doesn't touch it */
+	unsigned int resume_stage;              /* 0 or the stage of devices resumed in parallel */
+};
+
+/** @brief Device callbacks timed by the pm profiler. */
+enum pm_dev_op_t {
+	PM_DEV_SUSPEND = 0,
+	PM_DEV_SUSPEND_NOIRQ,
+	PM_DEV_RESUME_NOIRQ,
+	PM_DEV_RESUME,
+	PM_DEV_OP_NUM,
+};
+
+/** @brief Time spent in a callback or a step of suspend and resume, in us. */
+struct pm_time_stats {
+	uint32_t count;
+	uint32_t last;
+	uint32_t max;
+	uint64_t total;
+};
+
+/** @brief Callback timings of a registered device. */
+struct pm_dev_stats {
+	const struct soc_device *dev;
+	struct pm_time_stats op[PM_DEV_OP_NUM];
+};
+
+/* hist[0]: below 1 ms, hist[n]: [2^(n-1), 2^n) ms, hist[15]: 16384 ms and more */
+#define PM_RESIDENCY_HIST_NUM   16
+
+/** @brief Time spent in a low power mode, in us. */
+struct pm_residency_stats {
+	uint32_t count;
+	uint32_t max;
+	uint64_t total;
+	uint32_t hist[PM_RESIDENCY_HIST_NUM];
+};
+
+/* bit n of HAL_Wakeup_GetEvent(), PM_WAKEUP_SRC_WKIO0 ~ PM_WAKEUP_SRC_DEVICES */
+#define PM_WAKE_SRC_NUM         13
+#define PM_WAKE_IRQ_NUM         64
+
+/**
+ * @brief Wakeups by one source.
+ * @note A wakeup reporting several sources counts for each of them.
+ */
+struct pm_wake_src_stats {
+	uint32_t count;
+	uint64_t sleep;                         /* us slept before the wakeups */
+	uint64_t awake;                         /* us from the wakeups to the next pm_enter_mode() */
+};
+
+/** @brief Statistics of the pm profiler. */
+struct pm_prof_stats {
+	struct pm_residency_stats mode[PM_MODE_MAX];
+	struct pm_wake_src_stats src[PM_WAKE_SRC_NUM];
+	uint32_t wake_irq[PM_WAKE_IRQ_NUM];     /* wakeups by a peripheral irq */
+	uint32_t abort_irq[PM_WAKE_IRQ_NUM];    /* suspends given up for a pending peripheral irq */
+	uint32_t aborts;                        /* suspends given up for any pending wakeup */
+	struct pm_time_stats suspend;           /* pm_enter_mode() to the sleep instruction */
+	struct pm_time_stats first_task;        /* wakeup to the scheduler running tasks again */
+	struct pm_time_stats resume;            /* wakeup to pm_enter_mode() returning */
 };
 
 #ifdef CONFIG_PM
@@ -211,6 +278,41 @@ extern void pm_set_debug_delay_ms(unsigned int ms);
 /** @brief Show suspend statistic info. */
 extern void pm_stats_show(void);
 
+/**
+ * @brief Set the number of threads resuming devices of resume_stage above 0.
+ * @note The calling thread of pm_enter_mode() resumes devices too. With 0
+ *       workers the devices of a stage are resumed one after another.
+ * @param num:
+ *        @arg num->Worker threads, 0 ~ 4.
+ * @retval  0 if success or other if failed.
+ */
+extern int pm_set_resume_workers(unsigned int num);
+
+#ifdef __CONFIG_PM_PROFILE
+/**
+ * @brief Get the statistics of the pm profiler.
+ * @retval  0 if success or other if failed.
+ */
+extern int pm_get_prof_stats(struct pm_prof_stats *st);
+
+/**
+ * @brief Get the callback timings of the registered devices.
+ * @param st:
+ *        @arg st->Array receiving the timings.
+ * @param num:
+ *        @arg num->Entries of the array.
+ * @retval  Number of entries filled.
+ */
+extern int pm_get_dev_stats(struct pm_dev_stats *st, int num);
+
+/** @brief Clear the statistics of the pm profiler. */
+extern void pm_prof_reset(void);
+#else
+static inline int pm_get_prof_stats(struct pm_prof_stats *st) { return -1; }
+static inline int pm_get_dev_stats(struct pm_dev_stats *st, int num) { return 0; }
+static inline void pm_prof_reset(void) {;}
+#endif
+
 /**
  * @brief Select pm modes used on this platform.
  * @note Select modes at init for some modes are not used on some platforms.
@@ -247,6 +349,10 @@ static inline void pm_stop(void) { ; }
 static inline void pm_set_test_level(enum suspend_test_level_t level) {;}
 static inline void pm_set_debug_delay_ms(unsigned int ms) { ; }
 static inline void pm_stats_show(void) {;}
+static inline int pm_set_resume_workers(unsigned int num) { return -1; }
+static inline int pm_get_prof_stats(struct pm_prof_stats *st) { return -1; }
+static inline int pm_get_dev_stats(struct pm_dev_stats *st, int num) { return 0; }
+static inline void pm_prof_reset(void) {;}
 static inline void pm_mode_platform_select(unsigned int select) {;}
 static inline int pm_register_wlan_power_onoff(pm_wlan_power_onoff wlan_power_cb,
                                                unsigned int select) { return 0; }
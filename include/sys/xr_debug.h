@@ -84,6 +84,36 @@
 #define MOD_DBG_ALW_ON (DBG_ON | XR_LEVEL_ALL)
 
 
+/*
+ * Highest level compiled in, messages above it are removed at compile time
+ */
+#ifndef XR_DEBUG_LEVEL_MAX
+#define XR_DEBUG_LEVEL_MAX XR_LEVEL_ALL
+#endif
+
+
+/*
+ * Module id, in bits 8-13 of the module param, e.g.
+ *     #define WLAN_MODULE (DBG_ON | XR_LEVEL_INFO | XR_MOD_ID(3))
+ * With the deferred stdout, the messages of a module with an id are also
+ * filtered by the level set with stdio_defer_set_level(id, level) at run
+ * time. The id 0 is no id, the project assigns the others.
+ */
+#define XR_MOD_ID_SHIFT 8
+
+#define XR_MOD_ID(id) (((id) & 0x3F) << XR_MOD_ID_SHIFT)
+
+#define XR_MOD_ID_GET(module) (((module) >> XR_MOD_ID_SHIFT) & 0x3F)
+
+#ifdef __CONFIG_LIBC_WRAP_STDIO_DEFER
+#define XR_DEBUG_LEVEL_ON(module, dlevel) \
+		((XR_MOD_ID_GET(module) == 0) || \
+		 ((dlevel) <= stdio_defer_mod_level[XR_MOD_ID_GET(module)]))
+#else
+#define XR_DEBUG_LEVEL_ON(module, dlevel) 1
+#endif
+
+
 /************************************************************
  * XR_DEBUG INTERFACE
  ************************************************************/
@@ -110,8 +140,10 @@
 #define _XR_DEBUG(module, dlevel, expand, msg, arg...)	\
 		do { \
 			if ( \
+				((dlevel) <= XR_DEBUG_LEVEL_MAX) && \
 				((module) & DBG_ON) && \
 				(((module) & DBG_LEVEL_MASK) >= dlevel) && \
+				XR_DEBUG_LEVEL_ON(module, dlevel) && \
 				(expand)) { \
 				XR_DEBUG_PRINT(msg, ##arg); \
 			} \
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * pthread stand-in of the OS API used by passthrough.c, for the Linux
+ * benchmark only.
+ */
+
+#ifndef _BENCH_PORT_OS_H_
+#define _BENCH_PORT_OS_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+
+typedef enum {
+	OS_OK = 0,
+	OS_FAIL = -1,
+} OS_Status;
+
+#define OS_WAIT_FOREVER		0xffffffffU
+#define OS_PRIORITY_NORMAL	3
+
+typedef void (*OS_ThreadEntry_t)(void *);
+
+typedef struct {
+	pthread_mutex_t m;
+} OS_Mutex_t;
+
+typedef struct {
+	pthread_t t;
+	volatile int valid;
+	OS_ThreadEntry_t entry;
+	void *arg;
+} OS_Thread_t;
+
+static __inline OS_Status OS_MutexCreate(OS_Mutex_t *mutex)
+{
+	return pthread_mutex_init(&mutex->m, NULL) ? OS_FAIL : OS_OK;
+}
+
+static __inline OS_Status OS_MutexDelete(OS_Mutex_t *mutex)
+{
+	pthread_mutex_destroy(&mutex->m);
+	return OS_OK;
+}
+
+static __inline OS_Status OS_MutexLock(OS_Mutex_t *mutex, uint32_t waitMS)
+{
+	(void)waitMS;
+	pthread_mutex_lock(&mutex->m);
+	return OS_OK;
+}
+
+static __inline OS_Status OS_MutexUnlock(OS_Mutex_t *mutex)
+{
+	pthread_mutex_unlock(&mutex->m);
+	return OS_OK;
+}
+
+static void *os_thread_entry(void *arg)
+{
+	OS_Thread_t *thread = arg;
+
+	thread->entry(thread->arg);
+	return NULL;
+}
+
+static __inline OS_Status OS_ThreadCreate(OS_Thread_t *thread, const char *name,
+                                          OS_ThreadEntry_t entry, void *arg,
+                                          int priority, uint32_t stackSize)
+{
+	(void)name;
+	(void)priority;
+	(void)stackSize;
+	thread->entry = entry;
+	thread->arg = arg;
+	thread->valid = 1;
+	if (pthread_create(&thread->t, NULL, os_thread_entry, thread)) {
+		thread->valid = 0;
+		return OS_FAIL;
+	}
+	pthread_detach(thread->t);
+	return OS_OK;
+}
+
+/* Only the thread deleting itself is supported */
+static __inline OS_Status OS_ThreadDelete(OS_Thread_t *thread)
+{
+	thread->valid = 0;
+	pthread_exit(NULL);
+	return OS_OK;
+}
+
+static __inline int OS_ThreadIsValid(OS_Thread_t *thread)
+{
+	return thread->valid;
+}
+
+#define OS_MSleep(msec)		usleep((msec) * 1000)
+
+#endif /* _BENCH_PORT_OS_H_ */
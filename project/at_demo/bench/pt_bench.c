@@ -0,0 +1,682 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Linux benchmark of the passthrough engine: a pty stands in for the UART
+ * and loopback TCP sockets for the network.
+ *
+ *   ./run.sh [MB per link]
+ *
+ * The module side of the pty is written by the I/O thread and read by a
+ * stand-in of the AT thread in data mode. The host side checks the frames
+ * and the data of every link. A pty holds a few KB, so a host that stops
+ * reading blocks the UART writes like CTS does.
+ *
+ * select() is wrapped to count the wakeups of the I/O thread: with links
+ * open and no traffic it must not run, and room made by AT+S.SOCKR in
+ * command mode must be refilled at once, not after a polling period.
+ * Exits with 1 if any check fails.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <termios.h>
+#include <pthread.h>
+#include <netinet/tcp.h>
+
+#include "passthrough.h"
+
+#define LINKS			4
+#define CHUNK			1024
+#define RING_SIZE		4096
+#define PING_LEN		32
+#define PING_COUNT		1000
+#define IDLE_MS			200
+#define SOCKR_LEN		256
+#define SOCKR_COUNT		20
+#define SOCKR_MAX_US	5000
+
+typedef struct {
+	int hdr_len;
+	uint8_t hdr[PASSTHROUGH_FRAME_HDR_LEN];
+	int id;
+	int32_t left;
+} deframer_t;
+
+typedef struct {
+	int id;
+	int fd;
+	uint32_t bytes;
+	uint32_t bad;
+} peer_t;
+
+static int g_uart;	/* module side of the pty */
+static int g_host;	/* host side */
+static int g_listen;
+static struct sockaddr_in g_listen_addr;
+static volatile int g_stop;
+static volatile int g_mux;
+static volatile int g_legacy;
+static int g_legacy_fd;
+static uint32_t g_bytes;
+static volatile uint32_t g_selects;
+static int g_errors;
+
+int __real_select(int nfds, fd_set *r, fd_set *w, fd_set *e, struct timeval *tv);
+
+int __wrap_select(int nfds, fd_set *r, fd_set *w, fd_set *e, struct timeval *tv)
+{
+	g_selects++;
+	return __real_select(nfds, r, w, e, tv);
+}
+
+static double now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static uint8_t pattern(int id, uint32_t off)
+{
+	return (uint8_t)(off * 7 + id * 13);
+}
+
+static int write_all(int fd, const uint8_t *buf, int32_t len)
+{
+	int32_t done = 0;
+	ssize_t rc;
+
+	while (done < len) {
+		rc = write(fd, buf + done, len - done);
+		if (rc < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		done += rc;
+	}
+	return len;
+}
+
+static int read_all(int fd, uint8_t *buf, int32_t len)
+{
+	int32_t done = 0;
+	ssize_t rc;
+
+	while (done < len) {
+		rc = read(fd, buf + done, len - done);
+		if (rc <= 0) {
+			return -1;
+		}
+		done += rc;
+	}
+	return len;
+}
+
+static int uart_write(uint8_t *buf, int32_t len)
+{
+	return write_all(g_uart, buf, len);
+}
+
+static void open_pty(void)
+{
+	struct termios tio;
+
+	g_host = posix_openpt(O_RDWR | O_NOCTTY);
+	if (g_host < 0 || grantpt(g_host) || unlockpt(g_host)) {
+		perror("pty");
+		exit(1);
+	}
+	g_uart = open(ptsname(g_host), O_RDWR | O_NOCTTY);
+	if (g_uart < 0) {
+		perror("pty");
+		exit(1);
+	}
+	tcgetattr(g_uart, &tio);
+	cfmakeraw(&tio);
+	tcsetattr(g_uart, TCSANOW, &tio);
+}
+
+static void open_listen(void)
+{
+	socklen_t len = sizeof(g_listen_addr);
+
+	memset(&g_listen_addr, 0, sizeof(g_listen_addr));
+	g_listen_addr.sin_family = AF_INET;
+	g_listen_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	g_listen = socket(AF_INET, SOCK_STREAM, 0);
+	if (bind(g_listen, (struct sockaddr *)&g_listen_addr, sizeof(g_listen_addr)) ||
+	    listen(g_listen, LINKS)) {
+		perror("listen");
+		exit(1);
+	}
+	getsockname(g_listen, (struct sockaddr *)&g_listen_addr, &len);
+}
+
+/* module is the socket of the firmware, the peer is the remote end */
+static void open_link(int *module, int *peer)
+{
+	int one = 1;
+
+	*module = socket(AF_INET, SOCK_STREAM, 0);
+	if (connect(*module, (struct sockaddr *)&g_listen_addr, sizeof(g_listen_addr))) {
+		perror("connect");
+		exit(1);
+	}
+	*peer = accept(g_listen, NULL, NULL);
+	setsockopt(*module, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	setsockopt(*peer, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+/*
+ * Stand-in of the AT thread in data mode: whatever the UART has goes to
+ * the callback, like at_mode() with the zero-copy queue.
+ */
+static void *at_thread(void *arg)
+{
+	struct pollfd pfd = { g_uart, POLLIN, 0 };
+	uint8_t buf[CHUNK];
+	ssize_t len;
+
+	(void)arg;
+	while (!g_stop) {
+		if (poll(&pfd, 1, 10) <= 0) {
+			continue;
+		}
+		len = read(g_uart, buf, sizeof(buf));
+		if (len <= 0) {
+			continue;
+		}
+		if (g_mux) {
+			passthrough_mux_input(buf, len);
+		}
+		else {
+			passthrough_link_send(0, buf, len);
+		}
+	}
+	return NULL;
+}
+
+/*
+ * The data mode before the I/O thread: the UART input is gathered until
+ * serial_read() times out after 10 ms, then mode() polls the socket with
+ * a 10 ms select() each way.
+ */
+static void *legacy_thread(void *arg)
+{
+	struct pollfd pfd = { g_uart, POLLIN, 0 };
+	uint8_t in[CHUNK];
+	uint8_t out[CHUNK];
+	struct timeval tv;
+	fd_set fdset;
+	int32_t len;
+	ssize_t rc;
+
+	(void)arg;
+	while (!g_stop) {
+		len = 0;
+		while (len < CHUNK && poll(&pfd, 1, 10) > 0) {
+			rc = read(g_uart, in + len, CHUNK - len);
+			if (rc <= 0) {
+				break;
+			}
+			len += rc;
+		}
+
+		FD_ZERO(&fdset);
+		FD_SET(g_legacy_fd, &fdset);
+		tv.tv_sec = 0;
+		tv.tv_usec = 10000;
+		if (select(g_legacy_fd + 1, &fdset, NULL, NULL, &tv) > 0) {
+			rc = recv(g_legacy_fd, out, sizeof(out), 0);
+			if (rc > 0) {
+				uart_write(out, rc);
+			}
+		}
+
+		FD_ZERO(&fdset);
+		FD_SET(g_legacy_fd, &fdset);
+		tv.tv_sec = 0;
+		tv.tv_usec = 10000;
+		if (select(g_legacy_fd + 1, NULL, &fdset, NULL, &tv) > 0 && len > 0) {
+			send(g_legacy_fd, in, len, 0);
+		}
+	}
+	return NULL;
+}
+
+static void *peer_source(void *arg)
+{
+	peer_t *peer = arg;
+	uint8_t buf[CHUNK];
+	uint32_t off = 0;
+	uint32_t n;
+	uint32_t i;
+
+	while (off < g_bytes) {
+		n = g_bytes - off < CHUNK ? g_bytes - off : CHUNK;
+		for (i = 0; i < n; i++) {
+			buf[i] = pattern(peer->id, off + i);
+		}
+		if (write_all(peer->fd, buf, n) < 0) {
+			break;
+		}
+		off += n;
+	}
+	close(peer->fd);
+	return NULL;
+}
+
+static void *peer_sink(void *arg)
+{
+	peer_t *peer = arg;
+	uint8_t buf[CHUNK];
+	ssize_t rc;
+	ssize_t i;
+
+	while (peer->bytes < g_bytes) {
+		rc = recv(peer->fd, buf, sizeof(buf), 0);
+		if (rc <= 0) {
+			break;
+		}
+		for (i = 0; i < rc; i++) {
+			if (buf[i] != pattern(peer->id, peer->bytes + i)) {
+				peer->bad++;
+			}
+		}
+		peer->bytes += rc;
+	}
+	return NULL;
+}
+
+static void *peer_echo(void *arg)
+{
+	peer_t *peer = arg;
+	uint8_t buf[CHUNK];
+	ssize_t rc;
+
+	while ((rc = recv(peer->fd, buf, sizeof(buf), 0)) > 0) {
+		write_all(peer->fd, buf, rc);
+	}
+	return NULL;
+}
+
+static void *host_source(void *arg)
+{
+	uint8_t buf[PASSTHROUGH_FRAME_HDR_LEN + CHUNK];
+	uint32_t off = 0;
+	uint32_t n;
+	uint32_t i;
+	int id;
+
+	(void)arg;
+	while (off < g_bytes) {
+		n = g_bytes - off < CHUNK ? g_bytes - off : CHUNK;
+		for (id = 0; id < LINKS; id++) {
+			buf[0] = PASSTHROUGH_FRAME_SYNC;
+			buf[1] = id;
+			buf[2] = n >> 8;
+			buf[3] = n & 0xff;
+			for (i = 0; i < n; i++) {
+				buf[PASSTHROUGH_FRAME_HDR_LEN + i] = pattern(id, off + i);
+			}
+			write_all(g_host, buf, PASSTHROUGH_FRAME_HDR_LEN + n);
+		}
+		off += n;
+	}
+	return NULL;
+}
+
+static void report(const char *name, double us, uint32_t total, uint32_t bad)
+{
+	passthrough_stat_t stat;
+
+	passthrough_get_stat(&stat);
+	printf("%-22s %8.1f ms %8.2f MB/s  data %s  ring full %u  sync drop %u\n",
+	       name, us / 1000, total / us, bad ? "BAD" : "ok", stat.ring_full, stat.sync_drop);
+	g_errors += bad != 0;
+}
+
+/* All links stream to the host in frames, the host stalls once */
+static void bench_mux_down(void)
+{
+	pthread_t th[LINKS];
+	peer_t peer[LINKS];
+	int module[LINKS];
+	uint32_t got[LINKS];
+	uint8_t buf[CHUNK];
+	deframer_t df;
+	uint32_t total = 0;
+	uint32_t bad = 0;
+	int closed = 0;
+	int paused = 0;
+	double start;
+	ssize_t rc;
+	ssize_t i;
+	int32_t n;
+	int id;
+
+	memset(&df, 0, sizeof(df));
+	memset(got, 0, sizeof(got));
+	passthrough_set_mode(PASSTHROUGH_MODE_MUX, 0);
+
+	for (id = 0; id < LINKS; id++) {
+		open_link(&module[id], &peer[id].fd);
+		peer[id].id = id;
+		passthrough_link_open(id, module[id], 0, NULL, RING_SIZE);
+	}
+
+	start = now_us();
+	for (id = 0; id < LINKS; id++) {
+		pthread_create(&th[id], NULL, peer_source, &peer[id]);
+	}
+
+	while (closed < LINKS) {
+		if (!paused && total > g_bytes) {
+			paused = 1;
+			usleep(100 * 1000); /* the host drops CTS */
+		}
+
+		rc = read(g_host, buf, sizeof(buf));
+		if (rc <= 0) {
+			break;
+		}
+		for (i = 0; i < rc; ) {
+			if (df.left > 0) {
+				n = rc - i < df.left ? rc - i : df.left;
+				for (; n > 0; n--, i++, df.left--) {
+					if (buf[i] != pattern(df.id, got[df.id]++)) {
+						bad++;
+					}
+				}
+				continue;
+			}
+			df.hdr[df.hdr_len++] = buf[i++];
+			if (df.hdr[0] != PASSTHROUGH_FRAME_SYNC) {
+				bad++;
+				df.hdr_len = 0;
+			}
+			if (df.hdr_len == PASSTHROUGH_FRAME_HDR_LEN) {
+				df.id = df.hdr[1];
+				df.left = (df.hdr[2] << 8) | df.hdr[3];
+				df.hdr_len = 0;
+				if (df.id >= LINKS) {
+					bad++;
+					df.id = 0;
+				}
+				if (df.left == 0) {
+					closed++;
+				}
+				total += df.left;
+			}
+		}
+	}
+
+	for (id = 0; id < LINKS; id++) {
+		pthread_join(th[id], NULL);
+		if (got[id] != g_bytes) {
+			bad++;
+		}
+	}
+	report("mux sockets -> uart", now_us() - start, total, bad);
+
+	for (id = 0; id < LINKS; id++) {
+		passthrough_link_close(id);
+		close(module[id]);
+	}
+}
+
+/* The host streams frames to all links */
+static void bench_mux_up(void)
+{
+	pthread_t th[LINKS];
+	pthread_t host;
+	peer_t peer[LINKS];
+	int module[LINKS];
+	uint32_t total = 0;
+	uint32_t bad = 0;
+	double start;
+	int id;
+
+	passthrough_set_mode(PASSTHROUGH_MODE_MUX, 0);
+	g_mux = 1;
+
+	for (id = 0; id < LINKS; id++) {
+		open_link(&module[id], &peer[id].fd);
+		peer[id].id = id;
+		peer[id].bytes = 0;
+		peer[id].bad = 0;
+		passthrough_link_open(id, module[id], 0, NULL, RING_SIZE);
+	}
+
+	start = now_us();
+	for (id = 0; id < LINKS; id++) {
+		pthread_create(&th[id], NULL, peer_sink, &peer[id]);
+	}
+	pthread_create(&host, NULL, host_source, NULL);
+
+	for (id = 0; id < LINKS; id++) {
+		pthread_join(th[id], NULL);
+		total += peer[id].bytes;
+		bad += peer[id].bad + (peer[id].bytes != g_bytes);
+	}
+	pthread_join(host, NULL);
+	report("mux uart -> sockets", now_us() - start, total, bad);
+
+	for (id = 0; id < LINKS; id++) {
+		passthrough_link_close(id);
+		close(module[id]);
+		close(peer[id].fd);
+	}
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+	double d = *(const double *)a - *(const double *)b;
+
+	return d < 0 ? -1 : d > 0;
+}
+
+/* Round trip host -> socket -> echo -> host in the single link mode */
+static void bench_ping(int legacy)
+{
+	static double rtt[PING_COUNT];
+	pthread_t echo;
+	pthread_t at;
+	peer_t peer;
+	uint8_t out[PING_LEN];
+	uint8_t in[PING_LEN];
+	int module;
+	int bad = 0;
+	int i;
+
+	open_link(&module, &peer.fd);
+	memset(out, 'p', sizeof(out));
+	pthread_create(&echo, NULL, peer_echo, &peer);
+
+	g_mux = 0;
+	g_stop = 0;
+	if (legacy) {
+		g_legacy_fd = module;
+		pthread_create(&at, NULL, legacy_thread, NULL);
+	}
+	else {
+		passthrough_link_open(0, module, 0, NULL, RING_SIZE);
+		passthrough_set_mode(PASSTHROUGH_MODE_SINGLE, 0);
+		pthread_create(&at, NULL, at_thread, NULL);
+	}
+
+	for (i = 0; i < (legacy ? PING_COUNT / 10 : PING_COUNT); i++) {
+		double t = now_us();
+
+		write_all(g_host, out, sizeof(out));
+		if (read_all(g_host, in, sizeof(in)) < 0 || memcmp(in, out, sizeof(in))) {
+			bad++;
+		}
+		rtt[i] = now_us() - t;
+	}
+
+	qsort(rtt, i, sizeof(rtt[0]), cmp_double);
+	printf("%-22s %6d round trips  median %8.1f us  p99 %8.1f us  data %s\n",
+	       legacy ? "ping, 10 ms polling" : "ping, I/O thread", i,
+	       rtt[i / 2], rtt[i * 99 / 100], bad ? "BAD" : "ok");
+	g_errors += bad != 0;
+
+	g_stop = 1;
+	pthread_join(at, NULL);
+	if (!legacy) {
+		passthrough_link_close(0);
+		passthrough_set_mode(PASSTHROUGH_MODE_CMD, 0);
+	}
+	shutdown(module, SHUT_RDWR);
+	pthread_join(echo, NULL);
+	close(module);
+	close(peer.fd);
+}
+
+/* Links open, nothing moves: the I/O thread sleeps in select() */
+static void bench_idle(void)
+{
+	peer_t peer[LINKS];
+	int module[LINKS];
+	uint32_t calls;
+	int id;
+
+	passthrough_set_mode(PASSTHROUGH_MODE_MUX, 0);
+	for (id = 0; id < LINKS; id++) {
+		open_link(&module[id], &peer[id].fd);
+		passthrough_link_open(id, module[id], 0, NULL, RING_SIZE);
+	}
+
+	usleep(10 * 1000);
+	calls = g_selects;
+	usleep(IDLE_MS * 1000);
+	calls = g_selects - calls;
+	printf("%-22s %6u select() calls in %d ms  %s\n", "idle, links open",
+	       calls, IDLE_MS, calls <= 1 ? "ok" : "BAD");
+	g_errors += calls > 1;
+
+	for (id = 0; id < LINKS; id++) {
+		passthrough_link_close(id);
+		close(module[id]);
+		close(peer[id].fd);
+	}
+	passthrough_set_mode(PASSTHROUGH_MODE_CMD, 0);
+}
+
+static int wait_pending(int id, int32_t len, double *us)
+{
+	double start = now_us();
+
+	while (passthrough_link_pending(id) < len) {
+		if (now_us() - start > 1e6) {
+			return -1;
+		}
+	}
+	*us = now_us() - start;
+	return 0;
+}
+
+/* Command mode: AT+S.SOCKR reads a full ring, the room is refilled */
+static void bench_sockr(void)
+{
+	uint8_t buf[SOCKR_LEN];
+	pthread_t th;
+	peer_t peer;
+	int module;
+	double us;
+	double worst = 0;
+	int bad = 0;
+	int i;
+
+	g_bytes = RING_SIZE + SOCKR_LEN * (SOCKR_COUNT + 1);
+	open_link(&module, &peer.fd);
+	peer.id = 0;
+	passthrough_link_open(0, module, 0, NULL, RING_SIZE);
+	pthread_create(&th, NULL, peer_source, &peer);
+
+	bad += wait_pending(0, RING_SIZE, &us) != 0;
+	for (i = 0; i < SOCKR_COUNT && !bad; i++) {
+		passthrough_link_dump(0, SOCKR_LEN);
+		bad += read_all(g_host, buf, sizeof(buf)) < 0;
+		bad += wait_pending(0, RING_SIZE, &us) != 0;
+		if (us > worst) {
+			worst = us;
+		}
+	}
+	bad += worst > SOCKR_MAX_US;
+	printf("%-22s %6d reads, refilled within %8.1f us  %s\n", "sockr, full ring",
+	       i, worst, bad ? "BAD" : "ok");
+	g_errors += bad != 0;
+
+	passthrough_link_close(0);
+	shutdown(module, SHUT_RDWR);
+	pthread_join(th, NULL);
+	close(module);
+}
+
+int main(int argc, char **argv)
+{
+	pthread_t at;
+
+	g_bytes = (argc > 1 ? atoi(argv[1]) : 4) << 20;
+
+	open_pty();
+	open_listen();
+	passthrough_init(uart_write);
+
+	printf("%d links, %u KB each, ring %d\n", LINKS, g_bytes >> 10, RING_SIZE);
+
+	bench_mux_down();
+
+	g_stop = 0;
+	pthread_create(&at, NULL, at_thread, NULL);
+	bench_mux_up();
+	g_stop = 1;
+	pthread_join(at, NULL);
+
+	bench_ping(0);
+	bench_ping(1);
+
+	bench_idle();
+	bench_sockr();
+
+	passthrough_deinit();
+
+	return g_errors ? 1 : 0;
+}
@@ -0,0 +1,19 @@
+#!/bin/sh
+#
+# Build passthrough.c on the host with the stand-ins in port/ and run the
+# multi-link, ping, idle and AT+S.SOCKR checks over a pty and loopback
+# TCP, then a short run under AddressSanitizer. select() is wrapped to
+# count the wakeups of the I/O thread. Arguments are passed to pt_bench,
+# the MB per link.
+#
+set -e
+cd "$(dirname "$0")"
+build() {
+	gcc -O2 -Wall -pthread "$@" -Iport -I.. ../passthrough.c pt_bench.c \
+		-Wl,--wrap=select -o /tmp/pt_bench
+}
+build
+/tmp/pt_bench "$@"
+build -fsanitize=address -g
+/tmp/pt_bench 1 > /dev/null
+echo "PASS"
@@ -43,6 +43,7 @@
 
 #include "lwip/inet.h"
 #include "common/framework/net_ctrl.h"
+#include "common/framework/fast_connect.h"
 
 #include "driver/chip/hal_rtc.h"
 
@@ -58,6 +59,7 @@
 #include "driver/chip/hal_wdg.h"
 
 #include "atcmd.h"
+#include "passthrough.h"
 
 #define FUN_DEBUG_ON	1
 
@@ -111,13 +113,6 @@ typedef struct {
 	connect_t connect[MAX_SOCKET_NUM];
 } network_t;
 
-typedef struct {
-	u32 flag;
-	s32 offset;
-	s32 cnt;
-	u8 buffer[SOCKET_CACHE_BUFFER_SIZE];
-} socket_cache_t;
-
 typedef struct {
 	s16 port;
 	s32 protocol;
@@ -136,7 +131,14 @@ typedef struct {
 	s32 conn_fd;
 } server_ctrl_t;
 
-static socket_cache_t socket_cache[MAX_SOCKET_NUM+1];
+/* receive ring of each link, the last one is the server's */
+static const u32 socket_ring_size[MAX_SOCKET_NUM+1] = {
+	SOCKET_CACHE_BUFFER_SIZE, SOCKET_CACHE_BUFFER_SIZE,
+	SOCKET_CACHE_BUFFER_SIZE, SOCKET_CACHE_BUFFER_SIZE,
+	SOCKET_CACHE_BUFFER_SIZE, SOCKET_CACHE_BUFFER_SIZE,
+	SOCKET_CACHE_BUFFER_SIZE, SOCKET_CACHE_BUFFER_SIZE,
+	4 * SOCKET_CACHE_BUFFER_SIZE,
+};
 
 static OS_Thread_t g_server_thread;
 static OS_Mutex_t g_server_mutex;
@@ -152,6 +154,8 @@ static AT_ERROR_CODE callback(AT_CALLBACK_CMD cmd, at_callback_para_t *para, at_
 static AT_ERROR_CODE act(at_callback_para_t *para, at_callback_rsp_t *rsp);
 static AT_ERROR_CODE reset(at_callback_para_t *para, at_callback_rsp_t *rsp);
 static AT_ERROR_CODE mode(at_callback_para_t *para, at_callback_rsp_t *rsp);
+static AT_ERROR_CODE mode_exit(at_callback_para_t *para, at_callback_rsp_t *rsp);
+static AT_ERROR_CODE disconnect(s32 id);
 static AT_ERROR_CODE save(at_callback_para_t *para, at_callback_rsp_t *rsp);
 static AT_ERROR_CODE load(at_callback_para_t *para, at_callback_rsp_t *rsp);
 static AT_ERROR_CODE status(at_callback_para_t *para, at_callback_rsp_t *rsp);
@@ -193,6 +197,7 @@ static const callback_handler_t callback_tbl[] = {
 	{ACC_GPIOR,				gpior},
 	{ACC_GPIOW,				gpiow},
 	{ACC_SCAN,				scan},
+	{ACC_MODE_EXIT,			mode_exit},
 };
 
 static const u32 channel_freq_tbl[] = {
@@ -338,6 +343,8 @@ void at_cmd_init(void)
 
 	at_init(&at_cb);
 
+	passthrough_init(serial_write);
+
 	observer_base *obs = sys_callback_observer_create(CTRL_MSG_TYPE_NETWORK,
 	                                                  NET_CTRL_MSG_ALL,
 	                                                  occur,
@@ -391,8 +398,12 @@ static AT_ERROR_CODE act(at_callback_para_t *para, at_callback_rsp_t *rsp)
 	case 1: /* STA */
 
 		net_switch_mode(WLAN_MODE_STA);
+#if PRJCONF_NET_FAST_CONNECT
+		fast_connect_sta(para->cfg->wifi_ssid, para->cfg->wifi_ssid_len, (uint8_t *)para->cfg->wifi_wpa_psk_text);
+#else
 		wlan_sta_set(para->cfg->wifi_ssid, para->cfg->wifi_ssid_len, (uint8_t *)para->cfg->wifi_wpa_psk_text);
 		wlan_sta_enable();
+#endif
 
 		break;
 
@@ -429,252 +440,143 @@ static AT_ERROR_CODE reset(at_callback_para_t *para, at_callback_rsp_t *rsp)
 	return aec;
 }
 
-static AT_ERROR_CODE mode(at_callback_para_t *para, at_callback_rsp_t *rsp)
+/* Pick up the connection accepted by the server task */
+static s32 mode_server_link(void)
 {
-	AT_ERROR_CODE res = AEC_OK;
-	s32 id;
-	u8 *buffer;
-	s32 len;
-	s32 timeout_ms=10;
-	fd_set fdset_r,fdset_w;
-	int fd;
-	struct sockaddr_in address;
-	socklen_t addr_len;
-	char ip[IP_ADDR_SIZE+1];
-	s16 port;
-	s32 protocol;
+	if (!g_server_ctrl.flag) {
+		g_server_ctrl.protocol = g_server_arg.protocol;
 
-	if (!g_server_enable) { /* as client */
-		id = 0;
-		fd = networks.connect[id].fd;
-		protocol = networks.connect[id].protocol;
-		port = networks.connect[id].port;
-		strncpy(ip, networks.connect[id].ip, sizeof(ip));
+		server_mutex_lock();
+		g_server_ctrl.conn_fd = g_server_net.conn_fd;
+		g_server_ctrl.flag = g_server_net.flag;
+		server_mutex_unlock();
 
-		if (networks.count > 0) {
-			if (networks.connect[id].flag) {
-				int rc = -1;
-				struct timeval tv;
+		if (g_server_ctrl.flag) {
+			if (passthrough_link_open(MAX_SOCKET_NUM, g_server_ctrl.conn_fd, g_server_ctrl.protocol,
+			                          NULL, socket_ring_size[MAX_SOCKET_NUM]) != 0) {
+				g_server_ctrl.flag = 0;
+			}
+		}
+	}
 
-				FD_ZERO(&fdset_w);
-				FD_ZERO(&fdset_r);
-				FD_SET(fd, &fdset_w);
-				FD_SET(fd, &fdset_r);
+	return g_server_ctrl.flag ? MAX_SOCKET_NUM : -1;
+}
 
-				tv.tv_sec = timeout_ms / 1000;
-				tv.tv_usec = (timeout_ms % 1000) * 1000;
+/* The client of the TCP server has gone, accept the next one */
+static void mode_server_closed(void)
+{
+	passthrough_link_close(MAX_SOCKET_NUM);
 
-				rc = select(fd + 1, &fdset_r, NULL, NULL, &tv);
-				if (rc > 0) {
-					if (FD_ISSET(fd, &fdset_r)) {
-						buffer = socket_cache[id].buffer;
-						len = SOCKET_CACHE_BUFFER_SIZE;
-
-						if (protocol == 0) { /* TCP */
-							rc = recv(fd, buffer, len, 0);
-						}
-						else if (protocol == 1) { /* UDP */
-							address.sin_port = htons(port);
-							address.sin_family = AF_INET;
-							address.sin_addr.s_addr= inet_addr(ip);
-
-							addr_len = sizeof(address);
-
-							rc = recvfrom(fd, buffer, len, 0, (struct sockaddr *)&address, &addr_len);
-						}
-
-						if (rc > 0) {
-							/* received normally */
-							serial_write(buffer, rc);
-						}
-						else if (rc == 0) {
-							/* has disconnected with server */
-							res = AEC_DISCONNECT;
-						}
-						else {
-							/* network error */
-							res = AEC_NETWORK_ERROR;
-						}
-					}
-				}
-				else if (rc == 0) {
-					/* timeouted and sent 0 bytes */
-				}
-				else {
-					 /* network error */
-					res = AEC_NETWORK_ERROR;
-				}
+	if (g_server_ctrl.protocol == 0) { /* TCP */
+		closesocket(g_server_ctrl.conn_fd);
 
-				rc = select(fd + 1, NULL, &fdset_w, NULL, &tv);
-				if (rc > 0) {
-					if (FD_ISSET(fd, &fdset_w)) {
-						buffer = para->u.mode.buf;
-						len = para->u.mode.len;
-
-						if (buffer != NULL && len >0) {
-							if (protocol == 0) { /* TCP */
-								rc = send(fd, buffer, len, 0);
-							}
-							else if (protocol == 1) { /* UDP */
-								address.sin_port = htons(port);
-								address.sin_family = AF_INET;
-								address.sin_addr.s_addr= inet_addr(ip);
-
-								addr_len = sizeof(address);
-								rc = sendto(fd, buffer, len, 0, (struct sockaddr *)&address, sizeof(address));
-							}
-
-							if (rc > 0) {
-								/* do nothing */
-							}
-							else if (rc == 0) {
-								/* disconnected with server */
-								res = AEC_DISCONNECT;
-							}
-							else {
-								/* network error */
-								res = AEC_NETWORK_ERROR;
-							}
-						}
-					}
-				}
-				else if (rc == 0) {
-					/* timeouted and sent 0 bytes */
-				}
-				else {
-					 /* network error */
-					res = AEC_NETWORK_ERROR;
-				}
-			}
-			else {
-				res = AEC_SWITCH_MODE;
-			}
-		}
-		else {
-			res = AEC_SWITCH_MODE;
-		}
+		server_mutex_lock();
+		g_server_net.conn_fd = -1;
+		g_server_net.flag = 0;
+		server_mutex_unlock();
+
+		OS_SemaphoreRelease(&g_server_sem);
 	}
-	else { /* as server */
-		if (!g_server_ctrl.flag) {
-			g_server_ctrl.protocol = g_server_arg.protocol;
 
-			server_mutex_lock();
-			g_server_ctrl.conn_fd = g_server_net.conn_fd;
-			g_server_ctrl.flag = g_server_net.flag;
-			server_mutex_unlock();
-		}
+	g_server_ctrl.flag = 0;
+}
 
-		if (g_server_ctrl.flag) {
-			int rc = -1;
-			struct timeval tv;
+static AT_ERROR_CODE mode_mux(at_callback_para_t *para)
+{
+	s32 i;
 
-			port = g_server_ctrl.port;
-			protocol = g_server_ctrl.protocol;
-			fd = g_server_ctrl.conn_fd;
+	passthrough_set_mode(PASSTHROUGH_MODE_MUX, 0);
 
-			FD_ZERO(&fdset_w);
-			FD_ZERO(&fdset_r);
-			FD_SET(fd, &fdset_w);
-			FD_SET(fd, &fdset_r);
+	if (g_server_enable) {
+		mode_server_link();
+	}
 
-			tv.tv_sec = timeout_ms / 1000;
-			tv.tv_usec = (timeout_ms % 1000) * 1000;
+	/* the host has got the close frame of these links */
+	for (i = 0; i < MAX_SOCKET_NUM; i++) {
+		if (networks.connect[i].flag &&
+		    passthrough_link_state_get(i) != PASSTHROUGH_LINK_OPEN) {
+			disconnect(i);
+		}
+	}
 
-			rc = select(fd + 1, &fdset_r, NULL, NULL, &tv);
-			if (rc > 0) {
-				if (FD_ISSET(fd, &fdset_r)) {
-					buffer = socket_cache[MAX_SOCKET_NUM].buffer;
-					len = SOCKET_CACHE_BUFFER_SIZE;
+	if (g_server_ctrl.flag &&
+	    passthrough_link_state_get(MAX_SOCKET_NUM) == PASSTHROUGH_LINK_EOF) {
+		mode_server_closed();
+	}
 
-					if (protocol == 0) { /* TCP */
-						rc = recv(fd, buffer, len, 0);
-					}
-					else if (protocol == 1) { /* UDP */
-						address.sin_port = htons(port);
-						address.sin_family = AF_INET;
-						address.sin_addr.s_addr= inet_addr(ip);
+	if (para->u.mode.buf != NULL && para->u.mode.len > 0) {
+		passthrough_mux_input(para->u.mode.buf, para->u.mode.len);
+	}
 
-						addr_len = sizeof(address);
+	return AEC_OK;
+}
 
-						rc = recvfrom(fd, buffer, len, 0, (struct sockaddr *)&address, &addr_len);
-					}
+/*
+ * Called for each chunk of the UART input in data mode, at least every
+ * serial_read() timeout. The socket input is sent to the UART by the
+ * passthrough I/O thread.
+ */
+static AT_ERROR_CODE mode(at_callback_para_t *para, at_callback_rsp_t *rsp)
+{
+	passthrough_link_state state;
+	s32 id;
+	s32 rc;
 
-					if (rc > 0) {
-						/* received normally */
-						serial_write(buffer, rc);
-					}
-					else if (rc == 0) {
-						/* has disconnected with server */
-						if (protocol == 0) { /* TCP */
-							server_mutex_lock();
-							g_server_net.conn_fd = -1;
-							g_server_net.flag = 0;
-							server_mutex_unlock();
+	if (para->u.mode.mux) {
+		return mode_mux(para);
+	}
 
-							OS_SemaphoreRelease(&g_server_sem);
+	if (!g_server_enable) { /* as client */
+		id = 0;
 
-							g_server_ctrl.flag = 0;
-						}
+		if (networks.count == 0 || !networks.connect[id].flag) {
+			return AEC_SWITCH_MODE;
+		}
+	}
+	else { /* as server */
+		id = mode_server_link();
 
-						res = AEC_DISCONNECT;
-					}
-					else {
-						/* network error */
-						res = AEC_NETWORK_ERROR;
-					}
-				}
-			}
-			else if (rc == 0) {
-				/* timeouted and sent 0 bytes */
-			}
-			else {
-				 /* network error */
-				res = AEC_NETWORK_ERROR;
-			}
+		if (id < 0) {
+			return AEC_DISCONNECT;
+		}
+	}
 
-			rc = select(fd + 1, NULL, &fdset_w, NULL, &tv);
-			if (rc > 0) {
-				if (FD_ISSET(fd, &fdset_w)) {
-					buffer = para->u.mode.buf;
-					len = para->u.mode.len;
-
-					if (buffer != NULL && len >0) {
-						if (protocol == 0) { /* TCP */
-							rc = send(fd, buffer, len, 0);
-						}
-						else if (protocol == 1) { /* UDP */
-							FUN_DEBUG("Unsupported!\n");
-						}
-
-						if (rc > 0) {
-							/* do nothing */
-						}
-						else if (rc == 0) {
-							/* disconnected with server */
-							res = AEC_DISCONNECT;
-						}
-						else {
-							/* network error */
-							res = AEC_NETWORK_ERROR;
-						}
-					}
-				}
-			}
-			else if (rc == 0) {
-				/* timeouted and sent 0 bytes */
-			}
-			else {
-				 /* network error */
-				res = AEC_NETWORK_ERROR;
-			}
+	passthrough_set_mode(PASSTHROUGH_MODE_SINGLE, id);
+
+	state = passthrough_link_state_get(id);
+	if (state == PASSTHROUGH_LINK_EOF) {
+		/* has disconnected with server */
+		if (g_server_enable) {
+			mode_server_closed();
 		}
-		else {
-			res = AEC_DISCONNECT;
+
+		return AEC_DISCONNECT;
+	}
+	else if (state == PASSTHROUGH_LINK_ERROR) {
+		/* network error */
+		return AEC_NETWORK_ERROR;
+	}
+
+	if (para->u.mode.buf != NULL && para->u.mode.len > 0) {
+		rc = passthrough_link_send(id, para->u.mode.buf, para->u.mode.len);
+		if (rc == -1) {
+			/* disconnected with server */
+			return AEC_DISCONNECT;
+		}
+		else if (rc < 0) {
+			/* network error */
+			return AEC_NETWORK_ERROR;
 		}
 	}
 
-	return res;
+	return AEC_OK;
+}
+
+static AT_ERROR_CODE mode_exit(at_callback_para_t *para, at_callback_rsp_t *rsp)
+{
+	passthrough_set_mode(PASSTHROUGH_MODE_CMD, 0);
 
+	return AEC_OK;
 }
 
 static AT_ERROR_CODE save(at_callback_para_t *para, at_callback_rsp_t *rsp)
@@ -902,6 +804,7 @@ static AT_ERROR_CODE disconnect(s32 id)
 {
 	if (networks.count > 0) {
 		if (networks.connect[id].flag) {
+			passthrough_link_close(id);
 			closesocket(networks.connect[id].fd);
 			networks.connect[id].flag = 0;
 			networks.count--;
@@ -922,6 +825,7 @@ static AT_ERROR_CODE sockon(at_callback_para_t *para, at_callback_rsp_t *rsp)
 
 	int rc = -1;
 	struct sockaddr_in address;
+	struct sockaddr_in peer_addr;
 	struct addrinfo *result = NULL;
 	s32 id = -1;
 	int fd = 0;
@@ -985,13 +889,16 @@ static AT_ERROR_CODE sockon(at_callback_para_t *para, at_callback_rsp_t *rsp)
 				return AEC_CONNECT_FAIL;
 			}
 
+			if (passthrough_link_open(id, fd, 0, NULL, socket_ring_size[id]) != 0) {
+				closesocket(fd);
+				return AEC_NOT_ENOUGH_MEMORY;
+			}
+
 			networks.connect[id].fd = fd;
 			networks.connect[id].flag = 1;
 
 			networks.count++;
 
-			memset(&socket_cache[id], 0 ,sizeof(socket_cache_t));
-
 			rsp->type = 0;
 			rsp->vptr = (void *)id;
 
@@ -1039,13 +946,21 @@ static AT_ERROR_CODE sockon(at_callback_para_t *para, at_callback_rsp_t *rsp)
 				return AEC_BIND_FAIL;
 			}
 
+			memset(&peer_addr, 0, sizeof(peer_addr));
+			peer_addr.sin_port = htons(networks.connect[id].port);
+			peer_addr.sin_family = AF_INET;
+			peer_addr.sin_addr.s_addr= inet_addr(networks.connect[id].ip);
+
+			if (passthrough_link_open(id, fd, 1, &peer_addr, socket_ring_size[id]) != 0) {
+				closesocket(fd);
+				return AEC_NOT_ENOUGH_MEMORY;
+			}
+
 			networks.connect[id].fd = fd;
 			networks.connect[id].flag = 1;
 
 			networks.count++;
 
-			memset(&socket_cache[id], 0 ,sizeof(socket_cache_t));
-
 			rsp->type = 0;
 			rsp->vptr = (void *)id;
 
@@ -1162,171 +1077,32 @@ static AT_ERROR_CODE sockw(at_callback_para_t *para, at_callback_rsp_t *rsp)
 }
 
 
-typedef struct Timer Timer;
-
-struct Timer
-{
-	unsigned int end_time;
-};
-
-
-/** countdown_ms - set timeout value in mil seconds
- * @param timer - timeout timer where the timeout value save
- * @param timeout_ms - timeout in timeout_ms mil seconds
- */
-static void countdown_ms(Timer* timer, unsigned int timeout_ms)
-{
-	timer->end_time = OS_TicksToMSecs(OS_GetTicks()) + timeout_ms;
-}
-
-/** countdown - set timeout value in seconds
- * @param timer - timeout timer where the timeout value save
- * @param timeout - timeout in timeout seconds
- */
- /*
-static void countdown(Timer* timer, unsigned int timeout)
-{
-	countdown_ms(timer, timeout * 1000);
-}
-*/
-
-/** left_ms - calculate how much time left before timeout
- * @param timer - timeout timer
- * @return the time left befor timeout, or 0 if it has expired
- */
-static int left_ms(Timer* timer)
-{
-	int diff = (int)(timer->end_time) - (int)(OS_TicksToMSecs(OS_GetTicks()));
-	return (diff < 0) ? 0 : diff;
-}
-
-/** expired - has it already timeouted
- * @param timer - timeout timer
- * @return 0 if it has already timeout, or otherwise.
- */
-static char expired(Timer* timer)
-{
-	return 0 <= (int)OS_TicksToMSecs(OS_GetTicks()) - (int)(timer->end_time); /* is time_now over than end time */
-}
-
-static AT_ERROR_CODE read_socket(s32 id)
-{
-	int recvLen = 0;
-	int leftms;
-	int rc = -1;
-	struct timeval tv;
-	Timer timer;
-	fd_set fdset;
-	struct sockaddr_in address;
-	socklen_t addr_len;
-
-	u8 *buffer;
-	s32 len;
-	s32 timeout_ms = 10;
-
-	buffer = socket_cache[id].buffer;
-	len = SOCKET_CACHE_BUFFER_SIZE;
-
-	countdown_ms(&timer, timeout_ms);
-
-	do {
-		leftms = left_ms(&timer);
-		tv.tv_sec = leftms / 1000;
-		tv.tv_usec = (leftms % 1000) * 1000;
-
-		FD_ZERO(&fdset);
-		FD_SET(networks.connect[id].fd, &fdset);
-
-		rc = select(networks.connect[id].fd + 1, &fdset, NULL, NULL, &tv);
-		if (rc > 0) {
-			if (networks.connect[id].protocol == 0) { /* TCP */
-				rc = recv(networks.connect[id].fd, buffer + recvLen, len - recvLen, 0);
-			}
-			else if (networks.connect[id].protocol == 1) { /* UDP */
-				address.sin_port = htons(networks.connect[id].port);
-				address.sin_family = AF_INET;
-				address.sin_addr.s_addr= inet_addr(networks.connect[id].ip);
-
-				addr_len = sizeof(address);
-
-				rc = recvfrom(networks.connect[id].fd, buffer + recvLen, len - recvLen, 0, (struct sockaddr *)&address, &addr_len);
-			}
-
-			if (rc > 0) {
-				/* received normally */
-				recvLen += rc;
-			} else if (rc == 0) {
-				/* has disconnected with server */
-				recvLen = -1;
-				break;
-			} else {
-				/* network error */
-				recvLen = -2;
-				break;
-			}
-		} else if (rc == 0) {
-			/* timeouted and return the length received */
-			break;
-		} else {
-			/* network error */
-			recvLen = -2;
-			break;
-		}
-	} while (recvLen < len && !expired(&timer)); /* expired() is redundant? */
-
-	if (recvLen >= 0) {
-		if (recvLen > 0) {
-			socket_cache[id].cnt = recvLen;
-			socket_cache[id].offset = 0;
-			socket_cache[id].flag = 1;
-		}
-
-		return AEC_OK;
-	}
-	else if (recvLen == -1) {
-		return AEC_DISCONNECT;
-	}
-	else if (recvLen == -2) {
-		return AEC_NETWORK_ERROR;
-	}
-	else {
-		return AEC_UNDEFINED;
-	}
-}
-
 static AT_ERROR_CODE sockq(at_callback_para_t *para, at_callback_rsp_t *rsp)
 {
-	AT_ERROR_CODE aec;
+	passthrough_link_state state;
 	s32 id;
+	s32 cnt;
 
 	id = para->u.sockq.id;
 
 	if (networks.count > 0) {
 		if (networks.connect[id].flag) {
-			if (socket_cache[id].flag) {
-				rsp->type = 0;
-				rsp->vptr = (void *)socket_cache[id].cnt;
-
-				return AEC_OK;
-			}
-
-			aec = read_socket(id);
-			if (aec != AEC_OK) {
-				return aec;
+			/* the ring is filled by the passthrough I/O thread */
+			cnt = passthrough_link_pending(id);
+			if (cnt == 0) {
+				state = passthrough_link_state_get(id);
+				if (state == PASSTHROUGH_LINK_EOF) {
+					return AEC_DISCONNECT;
+				}
+				else if (state == PASSTHROUGH_LINK_ERROR) {
+					return AEC_NETWORK_ERROR;
+				}
 			}
 
-			if (socket_cache[id].flag) {
-				rsp->type = 0;
-				rsp->vptr = (void *)socket_cache[id].cnt;
-
-				return AEC_OK;
-			}
-			else {
-				rsp->type = 0;
-				rsp->vptr = (void *)0;
+			rsp->type = 0;
+			rsp->vptr = (void *)cnt;
 
-				return AEC_OK;
-			}
+			return AEC_OK;
 		}
 		else {
 			return AEC_DISCONNECT;
@@ -1339,10 +1115,8 @@ static AT_ERROR_CODE sockq(at_callback_para_t *para, at_callback_rsp_t *rsp)
 
 static AT_ERROR_CODE sockr(at_callback_para_t *para, at_callback_rsp_t *rsp)
 {
-	AT_ERROR_CODE aec;
 	s32 id;
-	u8 *buffer;
-	s32 len,rlen;
+	s32 len;
 
 	id = para->u.sockr.id;
 	len = para->u.sockr.len;
@@ -1351,27 +1125,9 @@ static AT_ERROR_CODE sockr(at_callback_para_t *para, at_callback_rsp_t *rsp)
 		if (networks.connect[id].flag) {
 			/* FUN_DEBUG("len = %d\n", len); */
 			if (len > 0) {
-				if (!socket_cache[id].flag) {
-
-					aec = read_socket(id);
-					if (aec != AEC_OK) {
-						return aec;
-					}
-				}
-
-				if (socket_cache[id].flag) {
-					buffer = socket_cache[id].buffer;
-					rlen = len < socket_cache[id].cnt ? len : socket_cache[id].cnt;
-
-					serial_write(&buffer[socket_cache[id].offset], rlen);
-
-					socket_cache[id].cnt -= rlen;
-					socket_cache[id].offset += rlen;
-					len -= rlen;
-
-					if (socket_cache[id].cnt <= 0) {
-						socket_cache[id].flag = 0;
-					}
+				if (passthrough_link_dump(id, len) == 0 &&
+				    passthrough_link_state_get(id) == PASSTHROUGH_LINK_EOF) {
+					return AEC_DISCONNECT;
 				}
 			}
 		}
@@ -1394,6 +1150,7 @@ static AT_ERROR_CODE sockc(at_callback_para_t *para, at_callback_rsp_t *rsp)
 
 	if (networks.count > 0) {
 		if (networks.connect[id].flag) {
+			passthrough_link_close(id);
 			closesocket(networks.connect[id].fd);
 			networks.connect[id].flag = 0;
 			networks.count--;
@@ -1514,7 +1271,6 @@ static AT_ERROR_CODE sockd(at_callback_para_t *para, at_callback_rsp_t *rsp)
 		if (!g_server_enable) {
 			g_server_arg.port = para->u.sockd.port;
 			g_server_arg.protocol = para->u.sockd.protocol;
-			memset(&socket_cache[MAX_SOCKET_NUM], 0 ,sizeof(socket_cache_t));
 
 			if (protocol == 0) { /* TCP */
 				server_mutex_lock();
@@ -1585,6 +1341,9 @@ static AT_ERROR_CODE sockd(at_callback_para_t *para, at_callback_rsp_t *rsp)
 		conn_fd = g_server_net.conn_fd;
 		server_mutex_unlock();
 
+		passthrough_link_close(MAX_SOCKET_NUM);
+		memset(&g_server_ctrl, 0, sizeof(g_server_ctrl));
+
 		if (g_server_arg.protocol == 0) { /* TCP */
 			if (sock_fd != -1) {
 				FUN_DEBUG("close fd = %d\n", sock_fd);
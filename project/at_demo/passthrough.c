@@ -0,0 +1,692 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * One I/O thread reads all the sockets into per-link rings, waiting on
+ * their readiness. A link is not polled while its ring is full, so the
+ * peer is held back by the TCP window. In the data modes the thread also
+ * drains the rings to the UART; the UART write blocks while the host
+ * holds CTS, and that again stops the reads.
+ *
+ * The sockets are opened, written and closed by the AT thread. The mutex
+ * covers the link table, the UART mutex the UART writes of the I/O thread,
+ * which are made out of the mutex. select() has no timeout: a datagram on
+ * a loopback UDP socket wakes the thread when a link is opened or closed,
+ * the mode changes or AT+S.SOCKR makes room in a ring.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include "kernel/os/os.h"
+#include "lwip/sockets.h"
+
+#include "atcmd.h"
+#include "passthrough.h"
+
+#define PASSTHROUGH_THREAD_STACK_SIZE	(2 * 1024)
+#define PASSTHROUGH_RING_MAX			(32 * 1024)	/* the frame length is 16 bits */
+#define PASSTHROUGH_DRAIN_LEN			1024		/* per link and round */
+
+typedef struct {
+	passthrough_link_state state;
+	int fd;
+	int protocol; /* 0: TCP 1: UDP */
+	uint8_t has_peer;
+	uint8_t eof_sent;
+	uint8_t full;
+	struct sockaddr_in peer;
+	uint8_t *buf;
+	uint32_t size; /* power of 2 */
+	volatile uint32_t rd; /* free running */
+	volatile uint32_t wr;
+} passthrough_link_t;
+
+typedef struct {
+	passthrough_link_t link[PASSTHROUGH_LINK_NUM];
+	passthrough_write_func output;
+	volatile passthrough_mode mode;
+	volatile int single;
+	volatile int run;
+	int next;
+	OS_Mutex_t mutex;
+	OS_Mutex_t uart_mutex;
+	OS_Thread_t thread;
+	int wake_fd;
+	volatile int wake_pending;
+	uint8_t drain[PASSTHROUGH_FRAME_HDR_LEN + PASSTHROUGH_DRAIN_LEN];
+
+	/* deframer, in the AT thread */
+	uint8_t hdr[PASSTHROUGH_FRAME_HDR_LEN];
+	int hdr_len;
+	int rx_id;
+	int32_t rx_left;
+
+	passthrough_stat_t stat;
+} passthrough_priv_t;
+
+static passthrough_priv_t g_pt;
+
+static __inline uint32_t pt_pending(passthrough_link_t *link)
+{
+	return link->wr - link->rd;
+}
+
+static __inline int pt_valid(int id)
+{
+	return id >= 0 && id < PASSTHROUGH_LINK_NUM;
+}
+
+static int pt_wakeup_open(void)
+{
+	struct sockaddr_in addr;
+	socklen_t len = sizeof(addr);
+	int fd;
+
+	fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0) {
+		return -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = 0;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    getsockname(fd, (struct sockaddr *)&addr, &len) < 0 ||
+	    connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		closesocket(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+/* Make the I/O thread build its fd set again */
+static void pt_wakeup(void)
+{
+	uint8_t c = 0;
+
+	if (g_pt.wake_fd >= 0 && !g_pt.wake_pending) {
+		g_pt.wake_pending = 1;
+		send(g_pt.wake_fd, &c, sizeof(c), MSG_DONTWAIT);
+	}
+}
+
+static void pt_wakeup_drain(void)
+{
+	uint8_t buf[8];
+
+	g_pt.wake_pending = 0;
+	while (recv(g_pt.wake_fd, buf, sizeof(buf), MSG_DONTWAIT) > 0) {
+	}
+}
+
+static void pt_recv(passthrough_link_t *link)
+{
+	struct sockaddr_in from;
+	socklen_t from_len;
+	uint32_t off;
+	uint32_t room;
+	int rc;
+
+	off = link->wr & (link->size - 1);
+	room = link->size - pt_pending(link);
+	if (room > link->size - off) {
+		room = link->size - off;
+	}
+
+	if (link->protocol == 0) { /* TCP */
+		rc = recv(link->fd, link->buf + off, room, MSG_DONTWAIT);
+	}
+	else { /* UDP */
+		from_len = sizeof(from);
+		rc = recvfrom(link->fd, link->buf + off, room, MSG_DONTWAIT,
+		              (struct sockaddr *)&from, &from_len);
+		if (rc > 0 && !link->has_peer) {
+			link->peer = from; /* reply to the last sender */
+		}
+	}
+
+	if (rc > 0) {
+		link->wr += rc;
+	}
+	else if (rc == 0) {
+		if (link->protocol == 0) {
+			link->state = PASSTHROUGH_LINK_EOF;
+		}
+	}
+	else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+		link->state = PASSTHROUGH_LINK_ERROR;
+	}
+}
+
+static __inline int pt_eof_due(passthrough_link_t *link)
+{
+	return g_pt.mode == PASSTHROUGH_MODE_MUX &&
+	       link->state != PASSTHROUGH_LINK_OPEN && !link->eof_sent;
+}
+
+static void pt_frame_hdr(uint8_t *hdr, int id, uint32_t len)
+{
+	hdr[0] = PASSTHROUGH_FRAME_SYNC;
+	hdr[1] = id;
+	hdr[2] = len >> 8;
+	hdr[3] = len & 0xff;
+}
+
+/*
+ * Up to PASSTHROUGH_DRAIN_LEN bytes per link and round, copied out of the
+ * ring under the mutex and written to the UART after it, so that the AT
+ * thread is not held up while the host holds CTS. Return 1 if data is
+ * left for the UART.
+ */
+static int pt_drain(void)
+{
+	passthrough_link_t *link;
+	uint32_t hdr_len;
+	uint32_t off;
+	uint32_t len;
+	uint32_t span;
+	uint32_t out;
+	int left = 0;
+	int n;
+	int i;
+
+	OS_MutexLock(&g_pt.uart_mutex, OS_WAIT_FOREVER);
+
+	for (n = 0; n < PASSTHROUGH_LINK_NUM; n++) {
+		i = (g_pt.next + n) % PASSTHROUGH_LINK_NUM;
+		link = &g_pt.link[i];
+		out = 0;
+
+		OS_MutexLock(&g_pt.mutex, OS_WAIT_FOREVER);
+
+		if (g_pt.mode == PASSTHROUGH_MODE_CMD) {
+			OS_MutexUnlock(&g_pt.mutex);
+			break;
+		}
+		if (link->state == PASSTHROUGH_LINK_FREE ||
+		    (g_pt.mode == PASSTHROUGH_MODE_SINGLE && i != g_pt.single)) {
+			OS_MutexUnlock(&g_pt.mutex);
+			continue;
+		}
+
+		hdr_len = g_pt.mode == PASSTHROUGH_MODE_MUX ? PASSTHROUGH_FRAME_HDR_LEN : 0;
+		len = pt_pending(link);
+		if (len > PASSTHROUGH_DRAIN_LEN) {
+			len = PASSTHROUGH_DRAIN_LEN;
+		}
+
+		if (len > 0) {
+			off = link->rd & (link->size - 1);
+			span = link->size - off;
+			if (span > len) {
+				span = len;
+			}
+			memcpy(g_pt.drain + hdr_len, link->buf + off, span);
+			memcpy(g_pt.drain + hdr_len + span, link->buf, len - span);
+			if (hdr_len > 0) {
+				pt_frame_hdr(g_pt.drain, i, len);
+			}
+			out = hdr_len + len;
+
+			link->rd += len;
+			g_pt.stat.net_bytes += len;
+		}
+		else if (pt_eof_due(link)) {
+			pt_frame_hdr(g_pt.drain, i, 0);
+			out = PASSTHROUGH_FRAME_HDR_LEN;
+			link->eof_sent = 1;
+		}
+
+		if (pt_pending(link) > 0 || pt_eof_due(link)) {
+			left = 1;
+		}
+
+		OS_MutexUnlock(&g_pt.mutex);
+
+		if (out > 0) {
+			g_pt.output(g_pt.drain, out);
+		}
+	}
+
+	g_pt.next = (g_pt.next + 1) % PASSTHROUGH_LINK_NUM;
+
+	OS_MutexUnlock(&g_pt.uart_mutex);
+
+	return left;
+}
+
+static void pt_task(void *arg)
+{
+	passthrough_link_t *link;
+	struct timeval tv;
+	fd_set fdset;
+	int maxfd;
+	int left;
+	int rc;
+	int i;
+
+	ATCMD_DBG("%s() start...\n", __func__);
+
+	while (g_pt.run) {
+		left = 0;
+		if (g_pt.mode != PASSTHROUGH_MODE_CMD) {
+			left = pt_drain();
+		}
+
+		FD_ZERO(&fdset);
+		FD_SET(g_pt.wake_fd, &fdset);
+		maxfd = g_pt.wake_fd;
+
+		OS_MutexLock(&g_pt.mutex, OS_WAIT_FOREVER);
+
+		for (i = 0; i < PASSTHROUGH_LINK_NUM; i++) {
+			link = &g_pt.link[i];
+
+			if (link->state != PASSTHROUGH_LINK_OPEN) {
+				continue;
+			}
+
+			if (pt_pending(link) >= link->size) {
+				if (!link->full) {
+					link->full = 1;
+					g_pt.stat.ring_full++;
+				}
+				continue;
+			}
+			link->full = 0;
+
+			FD_SET(link->fd, &fdset);
+			if (link->fd > maxfd) {
+				maxfd = link->fd;
+			}
+		}
+
+		OS_MutexUnlock(&g_pt.mutex);
+
+		/* only poll while the UART has data left to take */
+		tv.tv_sec = 0;
+		tv.tv_usec = 0;
+
+		rc = select(maxfd + 1, &fdset, NULL, NULL, left ? &tv : NULL);
+		if (rc < 0) {
+			/* a link was closed under select() */
+			OS_MSleep(1);
+			continue;
+		}
+		if (rc == 0) {
+			continue;
+		}
+
+		if (FD_ISSET(g_pt.wake_fd, &fdset)) {
+			pt_wakeup_drain();
+		}
+
+		OS_MutexLock(&g_pt.mutex, OS_WAIT_FOREVER);
+
+		for (i = 0; i < PASSTHROUGH_LINK_NUM; i++) {
+			link = &g_pt.link[i];
+
+			if (link->state == PASSTHROUGH_LINK_OPEN && FD_ISSET(link->fd, &fdset)) {
+				pt_recv(link);
+			}
+		}
+
+		OS_MutexUnlock(&g_pt.mutex);
+	}
+
+	ATCMD_DBG("%s() exit\n", __func__);
+	OS_ThreadDelete(&g_pt.thread);
+}
+
+int passthrough_init(passthrough_write_func output)
+{
+	if (g_pt.run) {
+		return -1;
+	}
+
+	memset(&g_pt, 0, sizeof(g_pt));
+	g_pt.output = output;
+
+	g_pt.wake_fd = pt_wakeup_open();
+	if (g_pt.wake_fd < 0) {
+		ATCMD_WARN("create wakeup socket failed\n");
+		return -1;
+	}
+
+	if (OS_MutexCreate(&g_pt.mutex) != OS_OK) {
+		ATCMD_WARN("create mutex failed\n");
+		closesocket(g_pt.wake_fd);
+		return -1;
+	}
+
+	if (OS_MutexCreate(&g_pt.uart_mutex) != OS_OK) {
+		ATCMD_WARN("create mutex failed\n");
+		OS_MutexDelete(&g_pt.mutex);
+		closesocket(g_pt.wake_fd);
+		return -1;
+	}
+
+	g_pt.run = 1;
+
+	if (OS_ThreadCreate(&g_pt.thread,
+	                    "passthrough",
+	                    pt_task,
+	                    NULL,
+	                    OS_PRIORITY_NORMAL,
+	                    PASSTHROUGH_THREAD_STACK_SIZE) != OS_OK) {
+		ATCMD_WARN("create passthrough task failed\n");
+		g_pt.run = 0;
+		OS_MutexDelete(&g_pt.uart_mutex);
+		OS_MutexDelete(&g_pt.mutex);
+		closesocket(g_pt.wake_fd);
+		return -1;
+	}
+
+	return 0;
+}
+
+void passthrough_deinit(void)
+{
+	int i;
+
+	if (!g_pt.run) {
+		return;
+	}
+
+	g_pt.run = 0;
+	pt_wakeup();
+	while (OS_ThreadIsValid(&g_pt.thread)) {
+		OS_MSleep(1);
+	}
+
+	for (i = 0; i < PASSTHROUGH_LINK_NUM; i++) {
+		passthrough_link_close(i);
+	}
+
+	OS_MutexDelete(&g_pt.uart_mutex);
+	OS_MutexDelete(&g_pt.mutex);
+	closesocket(g_pt.wake_fd);
+	g_pt.wake_fd = -1;
+}
+
+int passthrough_link_open(int id, int fd, int protocol,
+                          const struct sockaddr_in *peer, uint32_t ring_size)
+{
+	passthrough_link_t *link;
+	uint32_t size;
+	uint8_t *buf;
+
+	if (!pt_valid(id) || ring_size == 0 || ring_size > PASSTHROUGH_RING_MAX) {
+		return -1;
+	}
+
+	size = 1;
+	while (size < ring_size) {
+		size <<= 1;
+	}
+
+	buf = malloc(size);
+	if (buf == NULL) {
+		return -1;
+	}
+
+	link = &g_pt.link[id];
+
+	OS_MutexLock(&g_pt.mutex, OS_WAIT_FOREVER);
+
+	if (link->state != PASSTHROUGH_LINK_FREE) {
+		OS_MutexUnlock(&g_pt.mutex);
+		free(buf);
+		return -1;
+	}
+
+	memset(link, 0, sizeof(*link));
+	link->fd = fd;
+	link->protocol = protocol;
+	if (peer != NULL) {
+		link->peer = *peer;
+		link->has_peer = 1;
+	}
+	link->buf = buf;
+	link->size = size;
+	link->state = PASSTHROUGH_LINK_OPEN;
+
+	OS_MutexUnlock(&g_pt.mutex);
+
+	pt_wakeup();
+
+	return 0;
+}
+
+void passthrough_link_close(int id)
+{
+	passthrough_link_t *link;
+	uint8_t *buf;
+
+	if (!pt_valid(id)) {
+		return;
+	}
+
+	link = &g_pt.link[id];
+
+	OS_MutexLock(&g_pt.mutex, OS_WAIT_FOREVER);
+	buf = link->buf;
+	link->buf = NULL;
+	link->fd = -1;
+	link->state = PASSTHROUGH_LINK_FREE;
+	OS_MutexUnlock(&g_pt.mutex);
+
+	pt_wakeup();
+
+	if (buf != NULL) {
+		free(buf);
+	}
+}
+
+passthrough_link_state passthrough_link_state_get(int id)
+{
+	passthrough_link_t *link;
+
+	if (!pt_valid(id)) {
+		return PASSTHROUGH_LINK_FREE;
+	}
+
+	link = &g_pt.link[id];
+
+	/* the end is reported after the data */
+	if (link->state != PASSTHROUGH_LINK_OPEN && link->state != PASSTHROUGH_LINK_FREE) {
+		if (pt_pending(link) > 0 || (g_pt.mode == PASSTHROUGH_MODE_MUX && !link->eof_sent)) {
+			return PASSTHROUGH_LINK_OPEN;
+		}
+	}
+
+	return link->state;
+}
+
+int32_t passthrough_link_pending(int id)
+{
+	if (!pt_valid(id) || g_pt.link[id].state == PASSTHROUGH_LINK_FREE) {
+		return 0;
+	}
+
+	return pt_pending(&g_pt.link[id]);
+}
+
+int32_t passthrough_link_dump(int id, int32_t len)
+{
+	passthrough_link_t *link;
+	uint32_t off;
+	uint32_t n;
+	int32_t cnt = 0;
+
+	if (!pt_valid(id) || g_pt.link[id].state == PASSTHROUGH_LINK_FREE) {
+		return 0;
+	}
+
+	link = &g_pt.link[id];
+
+	while (len > 0 && pt_pending(link) > 0) {
+		off = link->rd & (link->size - 1);
+		n = pt_pending(link);
+		if (n > link->size - off) {
+			n = link->size - off;
+		}
+		if (n > (uint32_t)len) {
+			n = len;
+		}
+
+		g_pt.output(link->buf + off, n);
+
+		link->rd += n;
+		len -= n;
+		cnt += n;
+	}
+
+	/* a full ring is polled again */
+	if (cnt > 0) {
+		pt_wakeup();
+	}
+
+	return cnt;
+}
+
+int32_t passthrough_link_send(int id, uint8_t *buf, int32_t len)
+{
+	passthrough_link_t *link;
+	struct sockaddr_in peer;
+	int32_t sent = 0;
+	int rc;
+
+	if (!pt_valid(id) || g_pt.link[id].state == PASSTHROUGH_LINK_FREE) {
+		return -1;
+	}
+
+	link = &g_pt.link[id];
+
+	if (link->protocol == 1) { /* UDP */
+		OS_MutexLock(&g_pt.mutex, OS_WAIT_FOREVER);
+		peer = link->peer;
+		OS_MutexUnlock(&g_pt.mutex);
+
+		if (peer.sin_family != AF_INET) {
+			g_pt.stat.link_drop += len; /* nobody to reply to yet */
+			return len;
+		}
+
+		rc = sendto(link->fd, buf, len, 0, (struct sockaddr *)&peer, sizeof(peer));
+		if (rc < 0) {
+			return -2;
+		}
+		g_pt.stat.uart_bytes += len;
+		return len;
+	}
+
+	while (sent < len) {
+		rc = send(link->fd, buf + sent, len - sent, 0);
+		if (rc > 0) {
+			sent += rc;
+		}
+		else if (rc == 0) {
+			return -1; /* disconnected with server */
+		}
+		else {
+			return -2; /* network error */
+		}
+	}
+
+	g_pt.stat.uart_bytes += len;
+
+	return len;
+}
+
+void passthrough_set_mode(passthrough_mode mode, int id)
+{
+	if (g_pt.mode == mode && g_pt.single == id) {
+		return;
+	}
+
+	/* the I/O thread is not in the middle of a UART write once locked */
+	OS_MutexLock(&g_pt.uart_mutex, OS_WAIT_FOREVER);
+	OS_MutexLock(&g_pt.mutex, OS_WAIT_FOREVER);
+	g_pt.mode = mode;
+	g_pt.single = id;
+	g_pt.hdr_len = 0;
+	g_pt.rx_left = 0;
+	OS_MutexUnlock(&g_pt.mutex);
+	OS_MutexUnlock(&g_pt.uart_mutex);
+
+	pt_wakeup();
+}
+
+void passthrough_mux_input(uint8_t *buf, int32_t len)
+{
+	int32_t n;
+
+	while (len > 0) {
+		if (g_pt.rx_left > 0) {
+			n = len < g_pt.rx_left ? len : g_pt.rx_left;
+
+			if (!pt_valid(g_pt.rx_id) ||
+			    g_pt.link[g_pt.rx_id].state != PASSTHROUGH_LINK_OPEN ||
+			    passthrough_link_send(g_pt.rx_id, buf, n) != n) {
+				g_pt.stat.link_drop += n;
+			}
+
+			buf += n;
+			len -= n;
+			g_pt.rx_left -= n;
+			continue;
+		}
+
+		if (g_pt.hdr_len == 0 && *buf != PASSTHROUGH_FRAME_SYNC) {
+			g_pt.stat.sync_drop++;
+			buf++;
+			len--;
+			continue;
+		}
+
+		g_pt.hdr[g_pt.hdr_len++] = *buf++;
+		len--;
+
+		if (g_pt.hdr_len == PASSTHROUGH_FRAME_HDR_LEN) {
+			g_pt.rx_id = g_pt.hdr[1];
+			g_pt.rx_left = (g_pt.hdr[2] << 8) | g_pt.hdr[3];
+			g_pt.hdr_len = 0;
+		}
+	}
+}
+
+void passthrough_get_stat(passthrough_stat_t *stat)
+{
+	memcpy(stat, &g_pt.stat, sizeof(*stat));
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _PASSTHROUGH_H_
+#define _PASSTHROUGH_H_
+
+#include <stdint.h>
+#include "lwip/sockets.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PASSTHROUGH_LINK_NUM		9	/* the client sockets and the server */
+
+/*
+ * Frame of the multi-link mode, both directions:
+ *   0xA5, <link id>, <length high>, <length low>, <payload>
+ * A frame of length 0 sent to the host tells the link was closed by the
+ * peer. Bytes out of sync are dropped.
+ */
+#define PASSTHROUGH_FRAME_SYNC		0xA5
+#define PASSTHROUGH_FRAME_HDR_LEN	4
+
+typedef enum {
+	PASSTHROUGH_MODE_CMD = 0,	/* the rings are read by AT+S.SOCKR */
+	PASSTHROUGH_MODE_SINGLE,	/* one link goes to the UART as is */
+	PASSTHROUGH_MODE_MUX,		/* all the links go to the UART in frames */
+} passthrough_mode;
+
+typedef enum {
+	PASSTHROUGH_LINK_FREE = 0,
+	PASSTHROUGH_LINK_OPEN,
+	PASSTHROUGH_LINK_EOF,		/* closed by the peer, the ring is drained */
+	PASSTHROUGH_LINK_ERROR,
+} passthrough_link_state;
+
+typedef struct {
+	uint32_t net_bytes;		/* from the sockets to the UART */
+	uint32_t uart_bytes;	/* from the UART to the sockets */
+	uint32_t ring_full;		/* a link was not read for lack of room */
+	uint32_t sync_drop;		/* bytes dropped by the deframer */
+	uint32_t link_drop;		/* payload bytes for a link not open */
+} passthrough_stat_t;
+
+typedef int (*passthrough_write_func)(uint8_t *buf, int32_t len);
+
+/* Start the I/O thread, output writes the UART */
+int passthrough_init(passthrough_write_func output);
+void passthrough_deinit(void);
+
+/*
+ * Hand a connected socket over to the I/O thread, which reads it into a
+ * ring of ring_size bytes. peer is the destination of a UDP link, NULL to
+ * reply to the last sender.
+ */
+int passthrough_link_open(int id, int fd, int protocol,
+                          const struct sockaddr_in *peer, uint32_t ring_size);
+/* The socket is not closed, it is still owned by the caller */
+void passthrough_link_close(int id);
+passthrough_link_state passthrough_link_state_get(int id);
+
+/* Bytes waiting in the ring of the link */
+int32_t passthrough_link_pending(int id);
+/* Write up to len bytes of the ring to the UART, return the count */
+int32_t passthrough_link_dump(int id, int32_t len);
+/* Blocking send, return len, -1 if disconnected or -2 on network error */
+int32_t passthrough_link_send(int id, uint8_t *buf, int32_t len);
+
+/* id is the link of the single mode */
+void passthrough_set_mode(passthrough_mode mode, int id);
+/* Deframe the UART input of the multi-link mode and send the payloads */
+void passthrough_mux_input(uint8_t *buf, int32_t len);
+
+void passthrough_get_stat(passthrough_stat_t *stat);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PASSTHROUGH_H_ */
@@ -50,6 +50,9 @@ typedef struct serial_priv {
 
 	serial_cmd_exec_func cmd_exec;
 
+	uint8_t			hwfc;
+	volatile uint8_t rx_paused; /* rx held in the FIFO, RTS stops the host */
+
 	struct {
 		volatile uint8_t cnt;
 		uint8_t widx;
@@ -61,6 +64,31 @@ typedef struct serial_priv {
 
 static serial_priv_t g_serial;
 
+/*
+ * No cache buffer left. With hardware flow control the data is left in the
+ * FIFO and the rx interrupt is disabled until serial_read() frees a buffer,
+ * otherwise it is discarded.
+ */
+static void serial_rx_full(serial_priv_t *serial, UART_T *uart)
+{
+	uint8_t data;
+
+	if (serial->hwfc) {
+		HAL_UART_DisableRxCallback(serial->uartID);
+		serial->rx_paused = 1;
+		return;
+	}
+
+	if (HAL_UART_IsRxReady(uart)) {
+		/* discard data */
+		while (HAL_UART_IsRxReady(uart)) {
+			data = HAL_UART_GetRxData(uart);
+		}
+
+		SERIAL_WARN("no buf for rx, discard received data\n");
+	}
+}
+
 /* Note: only support line end with "\r\n" or "\n", not support "\r" */
 static void serial_rx_callback(void *arg)
 {
@@ -97,15 +125,7 @@ static void serial_rx_callback(void *arg)
 					OS_SemaphoreRelease(&serial->cmd_sem);
 
 					if (cnt >= SERIAL_CACHE_BUF_NUM) {
-						if (HAL_UART_IsRxReady(uart)) {
-							/* discard data */
-							while (HAL_UART_IsRxReady(uart)) {
-								data = HAL_UART_GetRxData(uart);
-							}
-
-							SERIAL_WARN("no buf for rx, discard received data\n");
-						}
-
+						serial_rx_full(serial, uart);
 						break;
 					}
 
@@ -130,11 +150,7 @@ static void serial_rx_callback(void *arg)
 		}
 	}
 	else {
-		/* discard data */
-		while (HAL_UART_IsRxReady(uart)) {
-			data = HAL_UART_GetRxData(uart);
-		}
-		SERIAL_WARN("no buf for rx, discard received data\n");
+		serial_rx_full(serial, uart);
 	}
 }
 
@@ -229,6 +245,7 @@ int serial_init(UART_ID uart_id, int baudrate, int data_bits, int parity, int st
 
 	memset(serial, 0, sizeof(*serial));
 	serial->uartID = uart_id;
+	serial->hwfc = hwfc ? 1 : 0;
 
 	if (OS_SemaphoreCreate(&serial->cmd_sem, 0, OS_SEMAPHORE_MAX_COUNT) != OS_OK) {
 		SERIAL_ERR("create semaphore failed\n");
@@ -323,6 +340,12 @@ int serial_read(uint8_t *buf, int32_t size)
 			serial->cache.cnt--;
 			arch_irq_enable();
 
+			if (serial->rx_paused) {
+				serial->rx_paused = 0;
+				HAL_UART_EnableRxCallback(serial->uartID, serial_rx_callback,
+				                          HAL_UART_GetInstance(serial->uartID));
+			}
+
 			break;
 		}
 		else {
@@ -43,6 +43,10 @@ enum cmd_status cmd_heap_space_exec(char *cmd)
 
 #ifdef __CONFIG_MALLOC_TRACE
 extern uint32_t wrap_malloc_heap_info(int verbose);
+extern uint32_t wrap_malloc_heap_mark(void);
+extern uint32_t wrap_malloc_heap_leak(uint32_t mark);
+
+static uint32_t g_heap_mark;
 
 enum cmd_status cmd_heap_info_exec(char *cmd)
 {
@@ -58,12 +62,46 @@ enum cmd_status cmd_heap_info_exec(char *cmd)
 	                  end - start - used, (end - start - used) / 1024);
 	return CMD_STATUS_ACKED;
 }
+
+/* heap mark: remember the allocation sequence for "heap leak" */
+enum cmd_status cmd_heap_mark_exec(char *cmd)
+{
+	g_heap_mark = wrap_malloc_heap_mark();
+	cmd_write_respond(CMD_STATUS_OK, "mark %u", g_heap_mark);
+	return CMD_STATUS_ACKED;
+}
+
+/* heap leak: show allocations made after "heap mark" and not freed yet */
+enum cmd_status cmd_heap_leak_exec(char *cmd)
+{
+	uint32_t sum;
+
+	sum = wrap_malloc_heap_leak(g_heap_mark);
+	cmd_write_respond(CMD_STATUS_OK, "%u bytes allocated since mark %u",
+	                  sum, g_heap_mark);
+	return CMD_STATUS_ACKED;
+}
+#endif
+
+#ifdef __CONFIG_MALLOC_SLAB
+extern void malloc_slab_info(void);
+
+enum cmd_status cmd_heap_slab_exec(char *cmd)
+{
+	malloc_slab_info();
+	return CMD_STATUS_OK;
+}
 #endif
 
 static const struct cmd_data g_heap_cmds[] = {
 	{ "space",	cmd_heap_space_exec },
 #ifdef __CONFIG_MALLOC_TRACE
 	{ "info",	cmd_heap_info_exec },
+	{ "mark",	cmd_heap_mark_exec },
+	{ "leak",	cmd_heap_leak_exec },
+#endif
+#ifdef __CONFIG_MALLOC_SLAB
+	{ "slab",	cmd_heap_slab_exec },
 #endif
 };
 
@@ -216,6 +216,45 @@ static enum cmd_status cmd_pm_net_prepare_exec(char *cmd)
 	return CMD_STATUS_OK;
 }
 
+/* pm stat [reset]
+ *  reset: clear the statistics of the pm profiler.
+ */
+static enum cmd_status cmd_pm_stat_exec(char *cmd)
+{
+	if (cmd_strcmp(cmd, "reset") == 0) {
+		pm_prof_reset();
+	} else if (cmd[0] == '\0') {
+		pm_stats_show();
+	} else {
+		CMD_ERR("err cmd:%s, expect: [reset]\n", cmd);
+		return CMD_STATUS_INVALID_ARG;
+	}
+
+	return CMD_STATUS_OK;
+}
+
+/* pm resume_workers <Num>
+ *  <Num>: 0 ~ 4, threads resuming the devices of resume_stage above 0.
+ */
+static enum cmd_status cmd_pm_resume_workers_exec(char *cmd)
+{
+	int32_t cnt;
+	uint32_t num;
+
+	cnt = cmd_sscanf(cmd, "%d", &num);
+	if (cnt != 1) {
+		CMD_ERR("err cmd:%s, expect: <Num>\n", cmd);
+		return CMD_STATUS_INVALID_ARG;
+	}
+
+	if (pm_set_resume_workers(num) != 0) {
+		CMD_ERR("set %u resume workers failed\n", num);
+		return CMD_STATUS_FAIL;
+	}
+
+	return CMD_STATUS_OK;
+}
+
 static const struct cmd_data g_pm_cmds[] = {
 	{ "config",      cmd_pm_config_exec },
 	{ "dump",        cmd_pm_dump_exec },
@@ -229,6 +268,8 @@ static const struct cmd_data g_pm_cmds[] = {
 	{ "hibernation", cmd_pm_hibernation_exec },
 	{ "poweroff",    cmd_pm_poweroff_exec },
 	{ "net_prepare", cmd_pm_net_prepare_exec },
+	{ "stat",        cmd_pm_stat_exec },
+	{ "resume_workers", cmd_pm_resume_workers_exec },
 	{ "shutdown",    cmd_pm_poweroff_exec },
 };
 
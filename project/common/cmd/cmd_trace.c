@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "cmd_util.h"
+#include "kernel/os/os_trace.h"
+
+#if (configDEBUG_TRACE_EN == 1)
+
+/*
+ * $ trace start [<size KB>] [wrap|once]
+ * $ trace stop
+ * $ trace mark <id> [<value>]
+ * $ trace stat
+ * $ trace dump
+ * $ trace free
+ *
+ * "trace dump" prints the image as "TR" lines, which tools/trace/xrtrace.py
+ * reads from a saved console log.
+ */
+
+#define TRACE_LOG(fmt, arg...)      printf(fmt, ##arg)
+
+#define TRACE_DEFAULT_KB            16
+#define TRACE_DUMP_BYTES_PER_LINE   32
+
+static const char * const g_trace_block_name[TRACE_BLOCK_NUM] = {
+	"mutex", "sem", "queue", "event", "notify", "delay", "suspend"
+};
+
+static enum cmd_status cmd_trace_start_exec(char *cmd)
+{
+	char *argv[2];
+	int argc;
+	uint32_t kb = TRACE_DEFAULT_KB;
+	uint8_t mode = TRACE_MODE_WRAP;
+
+	argc = cmd_parse_argv(cmd, argv, cmd_nitems(argv));
+	if (argc > 0)
+		kb = cmd_atoi(argv[0]);
+	if (argc > 1) {
+		if (cmd_strcmp(argv[1], "once") == 0)
+			mode = TRACE_MODE_ONESHOT;
+		else if (cmd_strcmp(argv[1], "wrap") != 0)
+			return CMD_STATUS_INVALID_ARG;
+	}
+	if (kb == 0)
+		return CMD_STATUS_INVALID_ARG;
+
+	if (OSTraceStart(kb * 1024, mode) != 0) {
+		CMD_ERR("trace start failed\n");
+		return CMD_STATUS_FAIL;
+	}
+	return CMD_STATUS_OK;
+}
+
+static enum cmd_status cmd_trace_stop_exec(char *cmd)
+{
+	OSTraceStop();
+	return CMD_STATUS_OK;
+}
+
+static enum cmd_status cmd_trace_free_exec(char *cmd)
+{
+	OSTraceFree();
+	return CMD_STATUS_OK;
+}
+
+static enum cmd_status cmd_trace_mark_exec(char *cmd)
+{
+	uint32_t id, value = 0;
+
+	if (cmd_sscanf(cmd, "%u %u", &id, &value) < 1 || id > 255)
+		return CMD_STATUS_INVALID_ARG;
+	OSTraceMark(id, value);
+	return CMD_STATUS_OK;
+}
+
+static uint32_t cmd_trace_permille(uint64_t part, uint64_t total)
+{
+	return total ? (uint32_t)(part * 1000 / total) : 0;
+}
+
+static enum cmd_status cmd_trace_stat_exec(char *cmd)
+{
+	OSTraceInfo info;
+	OSTraceThreadStat *ts;
+	OSTraceIrqStat *is;
+	OSTraceLockStat ls[8];
+	uint32_t us_div;
+	int i, j, n;
+
+	ts = cmd_malloc(TRACE_THREAD_MAX * sizeof(*ts));
+	is = cmd_malloc(TRACE_IRQ_MAX * sizeof(*is));
+	if (ts == NULL || is == NULL) {
+		cmd_free(ts);
+		cmd_free(is);
+		return CMD_STATUS_FAIL;
+	}
+
+	OSTraceGetInfo(&info);
+	us_div = info.cpu_hz / 1000000;
+	if (us_div == 0)
+		us_div = 1;
+	TRACE_LOG("%s, %u ms, %u/%u events, %u dropped, isr %u.%u%%\n",
+	          info.running ? "running" : "stopped",
+	          (uint32_t)(info.elapsed / us_div / 1000),
+	          info.event_num, info.event_max, info.dropped,
+	          cmd_trace_permille(info.isr, info.elapsed) / 10,
+	          cmd_trace_permille(info.isr, info.elapsed) % 10);
+
+	n = OSTraceGetThreadStat(ts, TRACE_THREAD_MAX);
+	TRACE_LOG("%-16s %5s %7s %9s %9s %8s  blocked ms\n",
+	          "thread", "tid", "cpu", "run ms", "ready ms", "switches");
+	for (i = 0; i < n; i++) {
+		TRACE_LOG("%-16s %5u %5u.%u%% %9u %9u %8u ",
+		          ts[i].name, ts[i].tid,
+		          cmd_trace_permille(ts[i].run, info.elapsed) / 10,
+		          cmd_trace_permille(ts[i].run, info.elapsed) % 10,
+		          (uint32_t)(ts[i].run / us_div / 1000),
+		          (uint32_t)(ts[i].ready / us_div / 1000),
+		          ts[i].switches);
+		for (j = 0; j < TRACE_BLOCK_NUM; j++) {
+			if (ts[i].blocked[j] / us_div >= 1000)
+				TRACE_LOG(" %s %u", g_trace_block_name[j],
+				          (uint32_t)(ts[i].blocked[j] / us_div / 1000));
+		}
+		TRACE_LOG("%s\n", ts[i].alive ? "" : " (deleted)");
+	}
+
+	n = OSTraceGetIrqStat(is, TRACE_IRQ_MAX);
+	TRACE_LOG("%-5s %8s %9s %7s\n", "irq", "count", "total us", "max us");
+	for (i = 0; i < n; i++) {
+		if (is[i].count == 0)
+			continue;
+		TRACE_LOG("%-5d %8u %9u %7u\n", i, is[i].count,
+		          (uint32_t)(is[i].total / us_div), is[i].max / us_div);
+	}
+
+	n = OSTraceGetLockStat(ls, cmd_nitems(ls));
+	TRACE_LOG("%-10s %-6s %6s %9s %7s\n", "object", "type", "waits", "total ms", "max ms");
+	for (i = 0; i < n; i++) {
+		TRACE_LOG("%p %-6s %6u %9u %7u\n", ls[i].obj,
+		          g_trace_block_name[ls[i].reason], ls[i].waits,
+		          (uint32_t)(ls[i].total / us_div / 1000),
+		          ls[i].max / us_div / 1000);
+	}
+
+	cmd_free(ts);
+	cmd_free(is);
+	return CMD_STATUS_OK;
+}
+
+struct cmd_trace_dump {
+	uint8_t line[TRACE_DUMP_BYTES_PER_LINE];
+	uint32_t len;
+	uint32_t offset;
+};
+
+static void cmd_trace_dump_line(struct cmd_trace_dump *d)
+{
+	uint32_t i;
+
+	TRACE_LOG("TR %08x:", d->offset);
+	for (i = 0; i < d->len; i++)
+		TRACE_LOG(" %02x", d->line[i]);
+	TRACE_LOG("\n");
+	d->offset += d->len;
+	d->len = 0;
+}
+
+static int cmd_trace_dump_write(const void *buf, uint32_t len, void *arg)
+{
+	struct cmd_trace_dump *d = arg;
+	const uint8_t *p = buf;
+
+	while (len--) {
+		d->line[d->len++] = *p++;
+		if (d->len == TRACE_DUMP_BYTES_PER_LINE)
+			cmd_trace_dump_line(d);
+	}
+	return 0;
+}
+
+static enum cmd_status cmd_trace_dump_exec(char *cmd)
+{
+	struct cmd_trace_dump d;
+	int32_t len;
+
+	cmd_memset(&d, 0, sizeof(d));
+	TRACE_LOG("TR begin\n");
+	len = OSTraceDump(cmd_trace_dump_write, &d);
+	if (d.len)
+		cmd_trace_dump_line(&d);
+	TRACE_LOG("TR end %d\n", len);
+	return len < 0 ? CMD_STATUS_FAIL : CMD_STATUS_OK;
+}
+
+static const struct cmd_data g_trace_cmds[] = {
+	{ "start",	cmd_trace_start_exec },
+	{ "stop",	cmd_trace_stop_exec },
+	{ "mark",	cmd_trace_mark_exec },
+	{ "stat",	cmd_trace_stat_exec },
+	{ "dump",	cmd_trace_dump_exec },
+	{ "free",	cmd_trace_free_exec },
+};
+
+enum cmd_status cmd_trace_exec(char *cmd)
+{
+	return cmd_exec(cmd, g_trace_cmds, cmd_nitems(g_trace_cmds));
+}
+
+#endif /* configDEBUG_TRACE_EN */
@@ -35,8 +35,12 @@
 #include "net/mbedtls/configs/config-xr-mini-cli.h"
 #endif
 #if defined (MBEDTLS_CLIENT_SERVER)
+#if defined(__CONFIG_MBEDTLS_FAST_PROFILE)
+#include "net/mbedtls/configs/config-xr-fast-cliserv.h"
+#else
 #include "net/mbedtls/configs/config-xr-mini-cliserv.h"
 #endif
+#endif
 #if defined (MBEDTLS_SERVER)
 #include "net/mbedtls/configs/config-xr-mini-serv.h"
 #endif
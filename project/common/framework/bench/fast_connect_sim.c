@@ -0,0 +1,530 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Linux simulation of fast_connect.c. It is built against the real lwIP and
+ * wlan headers, and the bench stands in for the supplicant, the access point,
+ * the DHCP server, sysinfo in flash and the OS timer. Time is virtual:
+ * every step of the air model moves the tick count forward by a fixed cost,
+ * so the times to IP are exact and the checks compare them to the model.
+ *
+ *   fast_connect_sim
+ *
+ * Runs a cold connect, a warm connect, a stale PMK, an AP that ignores the
+ * PMK, an expired lease, a NAK, a changed passphrase, another network and a
+ * cleared cache, and checks the path taken, the per-phase times, the cache
+ * contents and the flash writes of each.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "kernel/os/os.h"
+#include "lwip/dhcp.h"
+#include "lwip/prot/dhcp.h"
+#include "lwip/dns.h"
+#include "lwip/netifapi.h"
+#include "net/wlan/wlan.h"
+
+#include "common/framework/sysinfo.h"
+#include "net_ctrl.h"
+#include "fast_connect.h"
+
+/* air model, in ms */
+#define SIM_SCAN_MS			800		/* scan, auth and assoc */
+#define SIM_PBKDF2_MS		1600	/* PMK from passphrase by the supplicant */
+#define SIM_HANDSHAKE_MS	40		/* 4-way handshake */
+#define SIM_DISCOVER_MS		1500	/* DISCOVER to ACK, with ARP check */
+#define SIM_REBOOT_MS		150		/* INIT-REBOOT REQUEST to ACK or NAK */
+#define SIM_ASSOC_TIMEOUT	5000	/* FAST_CONNECT_ASSOC_TIMEOUT */
+
+#define SIM_NONE			0xffff
+#define SIM_NEVER			0xffffffffU
+
+static int sim_errors;
+
+#define SIM_CHECK(cond, fmt, arg...)                                    \
+	do {                                                            \
+		if (!(cond)) {                                          \
+			printf("FAIL %s:%d: " fmt "\n", __func__,       \
+			       __LINE__, ##arg);                        \
+			sim_errors++;                                   \
+		}                                                       \
+	} while (0)
+
+struct sim_ap {
+	const char *ssid;
+	const char *passphrase;
+	uint8_t bssid[6];
+	uint8_t channel;
+	int ignore_pmk;			/* never answers an association with a hex PSK */
+	uint32_t lease_ip;		/* address the DHCP server hands out */
+	uint32_t dns;
+};
+
+static struct sim_ap sim_home = {
+	"home", "correct horse battery", { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 }, 6,
+	0, PP_HTONL(LWIP_MAKEU32(192, 168, 1, 23)), PP_HTONL(LWIP_MAKEU32(192, 168, 1, 1)),
+};
+
+static struct sim_ap sim_office = {
+	"office", "battery staple", { 0x00, 0x66, 0x77, 0x88, 0x99, 0xaa }, 11,
+	0, PP_HTONL(LWIP_MAKEU32(10, 0, 0, 57)), PP_HTONL(LWIP_MAKEU32(10, 0, 0, 2)),
+};
+
+static struct sim_ap *sim_air = &sim_home;
+
+static uint32_t sim_now;
+static struct sysinfo sim_sysinfo;
+static struct netif sim_netif;
+static struct dhcp sim_dhcp;
+static ip_addr_t sim_dns;
+
+struct netif *g_wlan_netif = &sim_netif;
+
+/* pending air event and the one OS timer of fast_connect.c */
+static uint16_t sim_event = SIM_NONE;
+static uint32_t sim_event_at;
+static uint32_t sim_up_ip;
+static uint32_t sim_timer_at = SIM_NEVER;
+static OS_TimerCallback_t sim_timer_cb;
+static uint32_t sim_timer_period;
+
+/* what the supplicant was given */
+static uint8_t sim_sta_ssid[WLAN_SSID_MAX_LEN];
+static uint8_t sim_sta_ssid_len;
+static char sim_sta_psk[WLAN_PASSPHRASE_MAX_LEN + 2];
+
+struct sim_count {
+	int flash_writes;
+	int gen_psk;
+	int hex_psk;
+	int dhcp_reboot;
+	int dhcp_discover;
+	int dns_set;
+};
+
+static struct sim_count sim_count;
+
+size_t strlcpy(char *dst, const char *src, size_t size)
+{
+	size_t len = strlen(src);
+
+	if (size) {
+		size_t n = len < size - 1 ? len : size - 1;
+		memcpy(dst, src, n);
+		dst[n] = '\0';
+	}
+	return len;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+	return (TickType_t)OS_MSecsToTicks(sim_now);
+}
+
+OS_Status OS_TimerCreate(OS_Timer_t *timer, OS_TimerType type,
+                         OS_TimerCallback_t cb, void *ctx, OS_Time_t periodMS)
+{
+	timer->handle = (OS_TimerHandle_t)&sim_timer_cb;
+	sim_timer_cb = cb;
+	sim_timer_period = periodMS;
+	return OS_OK;
+}
+
+OS_Status OS_TimerStart(OS_Timer_t *timer)
+{
+	sim_timer_at = sim_now + sim_timer_period;
+	return OS_OK;
+}
+
+OS_Status OS_TimerStop(OS_Timer_t *timer)
+{
+	sim_timer_at = SIM_NEVER;
+	return OS_OK;
+}
+
+/* the sys_ctrl thread runs the handler at once */
+int sys_handler_send(void (*exec)(event_msg *), uint32_t data, uint32_t wait_ms)
+{
+	event_msg msg = { 0 };
+
+	msg.data = data;
+	exec(&msg);
+	return 0;
+}
+
+struct sysinfo *sysinfo_get(void)
+{
+	return &sim_sysinfo;
+}
+
+int sysinfo_save(void)
+{
+	sim_count.flash_writes++;
+	return 0;
+}
+
+/* stand-in for PBKDF2-SHA1, only needs to be a function of ssid and passphrase */
+static void sim_pbkdf2(const uint8_t *ssid, uint8_t ssid_len, const char *passphrase,
+                       uint8_t *pmk)
+{
+	uint32_t h = 2166136261U;
+	int i, j;
+
+	for (i = 0; i < SYSINFO_PMK_LEN; ++i) {
+		for (j = 0; j < ssid_len; ++j)
+			h = (h ^ ssid[j]) * 16777619U;
+		for (j = 0; passphrase[j]; ++j)
+			h = (h ^ (uint8_t)passphrase[j]) * 16777619U;
+		pmk[i] = h >> 24;
+	}
+}
+
+static void sim_pmk_hex(const struct sim_ap *ap, char *hex)
+{
+	uint8_t pmk[SYSINFO_PMK_LEN];
+	int i;
+
+	sim_pbkdf2((const uint8_t *)ap->ssid, strlen(ap->ssid), ap->passphrase, pmk);
+	for (i = 0; i < SYSINFO_PMK_LEN; ++i)
+		sprintf(hex + i * 2, "%02x", pmk[i]);
+}
+
+static void sim_schedule(uint16_t type, uint32_t delay)
+{
+	sim_event = type;
+	sim_event_at = sim_now + delay;
+}
+
+int wlan_sta_set(uint8_t *ssid, uint8_t ssid_len, uint8_t *psk)
+{
+	memcpy(sim_sta_ssid, ssid, ssid_len);
+	sim_sta_ssid_len = ssid_len;
+	strlcpy(sim_sta_psk, psk ? (char *)psk : "", sizeof(sim_sta_psk));
+	return 0;
+}
+
+int wlan_sta_enable(void)
+{
+	char hex[SYSINFO_PMK_LEN * 2 + 1];
+	uint32_t cost = SIM_SCAN_MS + SIM_HANDSHAKE_MS;
+	int ok;
+
+	if (sim_sta_ssid_len != strlen(sim_air->ssid) ||
+	    memcmp(sim_sta_ssid, sim_air->ssid, sim_sta_ssid_len) != 0) {
+		sim_schedule(NET_CTRL_MSG_WLAN_CONNECT_FAILED, SIM_SCAN_MS);
+		return 0;
+	}
+
+	if (strlen(sim_sta_psk) == SYSINFO_PMK_LEN * 2) {
+		sim_count.hex_psk++;
+		if (sim_air->ignore_pmk) {
+			sim_event = SIM_NONE;
+			return 0;
+		}
+		sim_pmk_hex(sim_air, hex);
+		ok = strcmp(sim_sta_psk, hex) == 0;
+	} else {
+		cost += SIM_PBKDF2_MS;
+		ok = strcmp(sim_sta_psk, sim_air->passphrase) == 0;
+	}
+	sim_schedule(ok ? NET_CTRL_MSG_WLAN_CONNECTED :
+	             NET_CTRL_MSG_WLAN_4WAY_HANDSHAKE_FAILED, cost);
+	return 0;
+}
+
+int wlan_sta_disable(void)
+{
+	sim_event = SIM_NONE;
+	return 0;
+}
+
+int wlan_sta_ap_info(wlan_sta_ap_t *ap)
+{
+	memset(ap, 0, sizeof(*ap));
+	memcpy(ap->bssid, sim_air->bssid, sizeof(ap->bssid));
+	ap->channel = sim_air->channel;
+	return 0;
+}
+
+int wlan_sta_gen_psk(wlan_gen_psk_param_t *param)
+{
+	sim_count.gen_psk++;
+	sim_pbkdf2(param->ssid, param->ssid_len, param->passphrase, param->psk);
+	sim_now += SIM_PBKDF2_MS;
+	return 0;
+}
+
+err_t netifapi_netif_common(struct netif *netif, netifapi_void_fn voidfunc,
+                            netifapi_errt_fn errtfunc)
+{
+	if (voidfunc)
+		voidfunc(netif);
+	return errtfunc ? errtfunc(netif) : ERR_OK;
+}
+
+err_t dhcp_start(struct netif *netif)
+{
+	sim_count.dhcp_discover++;
+	sim_up_ip = sim_air->lease_ip;
+	sim_schedule(NET_CTRL_MSG_NETWORK_UP, SIM_DISCOVER_MS);
+	return ERR_OK;
+}
+
+/* a NAK restarts discovery inside lwIP */
+err_t dhcp_start_reboot(struct netif *netif, const ip4_addr_t *ipaddr)
+{
+	sim_count.dhcp_reboot++;
+	sim_up_ip = sim_air->lease_ip;
+	if (ip4_addr_get_u32(ipaddr) == sim_air->lease_ip)
+		sim_schedule(NET_CTRL_MSG_NETWORK_UP, SIM_REBOOT_MS);
+	else
+		sim_schedule(NET_CTRL_MSG_NETWORK_UP, SIM_REBOOT_MS + SIM_DISCOVER_MS);
+	return ERR_OK;
+}
+
+void dns_setserver(u8_t numdns, const ip_addr_t *dnsserver)
+{
+	sim_count.dns_set++;
+	ip_addr_copy(sim_dns, *dnsserver);
+}
+
+const ip_addr_t *dns_getserver(u8_t numdns)
+{
+	return &sim_dns;
+}
+
+char *ip4addr_ntoa(const ip4_addr_t *addr)
+{
+	static char buf[16];
+
+	snprintf(buf, sizeof(buf), "%u.%u.%u.%u", ip4_addr1(addr), ip4_addr2(addr),
+	         ip4_addr3(addr), ip4_addr4(addr));
+	return buf;
+}
+
+/* what net_ctrl does with the air events, as far as fast connect sees it */
+static void sim_deliver(uint16_t type)
+{
+	fast_connect_process(type);
+
+	if (type == NET_CTRL_MSG_WLAN_CONNECTED) {
+		ip4_addr_set_zero(ip_2_ip4(&sim_netif.ip_addr));
+		sim_dhcp.state = DHCP_STATE_REQUESTING;
+		fast_connect_dhcp_start(&sim_netif);
+	}
+}
+
+static void sim_bind(void)
+{
+	ip4_addr_set_u32(ip_2_ip4(&sim_netif.ip_addr), sim_up_ip);
+	sim_dhcp.state = DHCP_STATE_BOUND;
+	ip4_addr_set_u32(&sim_dhcp.offered_ip_addr, sim_up_ip);
+	ip4_addr_set_u32(&sim_dhcp.offered_sn_mask, PP_HTONL(LWIP_MAKEU32(255, 255, 255, 0)));
+	ip4_addr_set_u32(&sim_dhcp.offered_gw_addr, sim_air->dns);
+	sim_dhcp.offered_t0_lease = 86400;
+	IP_SET_TYPE_VAL(sim_dns, IPADDR_TYPE_V4);
+	ip4_addr_set_u32(ip_2_ip4(&sim_dns), sim_air->dns);
+}
+
+/* run the air until the network is up, 0 on success */
+static int sim_connect(const char *ssid, const char *passphrase,
+                       struct fast_connect_stats *stats)
+{
+	uint16_t type;
+	uint32_t deadline;
+
+	memset(&sim_count, 0, sizeof(sim_count));
+	sim_event = SIM_NONE;
+	if (fast_connect_sta((uint8_t *)ssid, strlen(ssid), (uint8_t *)passphrase) != 0)
+		return -1;
+
+	deadline = sim_now + 60000;
+	while (OS_TimeBefore(sim_now, deadline)) {
+		if (sim_timer_at != SIM_NEVER &&
+		    (sim_event == SIM_NONE || OS_TimeBeforeEqual(sim_timer_at, sim_event_at))) {
+			sim_now = sim_timer_at;
+			sim_timer_at = SIM_NEVER;
+			sim_timer_cb(NULL);
+			continue;
+		}
+		if (sim_event == SIM_NONE)
+			break;
+		sim_now = sim_event_at;
+		type = sim_event;
+		sim_event = SIM_NONE;
+		if (type == NET_CTRL_MSG_NETWORK_UP)
+			sim_bind();
+		sim_deliver(type);
+		if (type == NET_CTRL_MSG_NETWORK_UP) {
+			fast_connect_get_stats(stats);
+			return 0;
+		}
+	}
+	return -1;
+}
+
+struct sim_expect {
+	int fast_assoc;
+	int fast_dhcp;
+	int fallback;
+	uint32_t assoc_ms;
+	uint32_t dhcp_ms;
+	uint32_t cache_ms;
+	int flash_writes;
+};
+
+static void sim_case(const char *name, const char *ssid, const char *passphrase,
+                     const struct sim_expect *e)
+{
+	struct sysinfo_wlan_sta_fast *fast = &sim_sysinfo.wlan_sta_fast;
+	struct fast_connect_stats st;
+	uint8_t pmk[SYSINFO_PMK_LEN];
+
+	memset(&st, 0, sizeof(st));
+	if (sim_connect(ssid, passphrase, &st) != 0) {
+		SIM_CHECK(0, "%s: no IP", name);
+		return;
+	}
+
+	printf("%-18s %6u %6u %6u %6u   %-5s %-5s %d\n", name, st.total_ms, st.assoc_ms,
+	       st.dhcp_ms, st.cache_ms, st.fast_assoc ? "fast" : "full",
+	       st.fast_dhcp ? "fast" : "full", sim_count.flash_writes);
+
+	SIM_CHECK(st.fast_assoc == e->fast_assoc, "%s: fast_assoc %d", name, st.fast_assoc);
+	SIM_CHECK(st.fast_dhcp == e->fast_dhcp, "%s: fast_dhcp %d", name, st.fast_dhcp);
+	SIM_CHECK(st.fallback == e->fallback, "%s: fallback %d", name, st.fallback);
+	SIM_CHECK(st.assoc_ms == e->assoc_ms, "%s: assoc %u ms, expected %u",
+	          name, st.assoc_ms, e->assoc_ms);
+	SIM_CHECK(st.dhcp_ms == e->dhcp_ms, "%s: dhcp %u ms, expected %u",
+	          name, st.dhcp_ms, e->dhcp_ms);
+	SIM_CHECK(st.total_ms == e->assoc_ms + e->dhcp_ms, "%s: total %u ms", name, st.total_ms);
+	SIM_CHECK(st.cache_ms == e->cache_ms, "%s: cache %u ms, expected %u",
+	          name, st.cache_ms, e->cache_ms);
+	SIM_CHECK(sim_count.flash_writes == e->flash_writes, "%s: %d flash writes, expected %d",
+	          name, sim_count.flash_writes, e->flash_writes);
+	SIM_CHECK(sim_count.hex_psk == e->fast_assoc + e->fallback,
+	          "%s: %d hex PSK associations", name, sim_count.hex_psk);
+	SIM_CHECK(sim_count.gen_psk == (e->cache_ms != 0), "%s: %d PMK derivations",
+	          name, sim_count.gen_psk);
+
+	/* the cache now holds this connection */
+	sim_pbkdf2((const uint8_t *)ssid, strlen(ssid), passphrase, pmk);
+	SIM_CHECK(fast->magic == SYSINFO_FAST_CONNECT_MAGIC, "%s: cache magic %#x", name, fast->magic);
+	SIM_CHECK(fast->pmk_valid && memcmp(fast->pmk, pmk, sizeof(pmk)) == 0, "%s: cached PMK", name);
+	SIM_CHECK(memcmp(fast->bssid, sim_air->bssid, SYSINFO_BSSID_LEN) == 0 &&
+	          fast->channel == sim_air->channel, "%s: cached bssid/channel", name);
+	SIM_CHECK(fast->lease_valid && ip4_addr_get_u32(&fast->lease.ip_addr) == sim_air->lease_ip &&
+	          ip4_addr_get_u32(&fast->lease.gateway) == sim_air->dns &&
+	          fast->lease_time == 86400, "%s: cached lease", name);
+	SIM_CHECK(fast->dns == sim_air->dns, "%s: cached dns %#x", name, fast->dns);
+}
+
+int main(void)
+{
+	const uint32_t full = SIM_SCAN_MS + SIM_PBKDF2_MS + SIM_HANDSHAKE_MS;
+	const uint32_t fast = SIM_SCAN_MS + SIM_HANDSHAKE_MS;
+	const char *home = sim_home.passphrase;
+	struct sim_expect e;
+
+	sim_netif.client_data[LWIP_NETIF_CLIENT_DATA_INDEX_DHCP] = &sim_dhcp;
+
+	printf("air model: scan %u ms, PBKDF2 %u ms, handshake %u ms, discover %u ms, "
+	       "reboot %u ms\n\n", SIM_SCAN_MS, SIM_PBKDF2_MS, SIM_HANDSHAKE_MS,
+	       SIM_DISCOVER_MS, SIM_REBOOT_MS);
+	printf("case               total  assoc   dhcp  cache   assoc dhcp  flash\n");
+
+	/* nothing cached: passphrase and discovery, the PMK derived after IP */
+	e = (struct sim_expect){ 0, 0, 0, full, SIM_DISCOVER_MS, SIM_PBKDF2_MS, 1 };
+	sim_case("cold", "home", home, &e);
+
+	/* same network: hex PMK and INIT-REBOOT, nothing to write */
+	e = (struct sim_expect){ 1, 1, 0, fast, SIM_REBOOT_MS, 0, 0 };
+	sim_case("warm", "home", home, &e);
+	SIM_CHECK(sim_count.dns_set == 1, "warm: dns set %d times before DHCP", sim_count.dns_set);
+
+	/* corrupted PMK: handshake fails, passphrase retried, PMK derived again */
+	sim_sysinfo.wlan_sta_fast.pmk[0] ^= 0x5a;
+	e = (struct sim_expect){ 0, 1, 1, fast + full, SIM_REBOOT_MS, SIM_PBKDF2_MS, 1 };
+	sim_case("stale PMK", "home", home, &e);
+
+	/* no answer to the hex PSK: passphrase after the timeout */
+	sim_home.ignore_pmk = 1;
+	e = (struct sim_expect){ 0, 1, 1, SIM_ASSOC_TIMEOUT + full, SIM_REBOOT_MS, SIM_PBKDF2_MS, 1 };
+	sim_case("assoc timeout", "home", home, &e);
+	sim_home.ignore_pmk = 0;
+
+	/* lease over: discovery at once, no INIT-REBOOT, the new start saved */
+	sim_sysinfo.wlan_sta_fast.lease_start = (uint32_t)time(NULL) - 86400 - 60;
+	e = (struct sim_expect){ 1, 0, 0, fast, SIM_DISCOVER_MS, 0, 1 };
+	sim_case("lease expired", "home", home, &e);
+	SIM_CHECK(sim_count.dhcp_reboot == 0, "lease expired: %d INIT-REBOOT", sim_count.dhcp_reboot);
+
+	/* half a lease old: same lease, only the start, rewritten all the same */
+	sim_sysinfo.wlan_sta_fast.lease_start -= 86400 / 2 + 60;
+	e = (struct sim_expect){ 1, 1, 0, fast, SIM_REBOOT_MS, 0, 1 };
+	sim_case("lease half old", "home", home, &e);
+
+	/* server renumbered: NAK, discovery inside lwIP, the new lease cached */
+	sim_home.lease_ip = PP_HTONL(LWIP_MAKEU32(192, 168, 1, 99));
+	e = (struct sim_expect){ 1, 0, 0, fast, SIM_REBOOT_MS + SIM_DISCOVER_MS, 0, 1 };
+	sim_case("NAK", "home", home, &e);
+	SIM_CHECK(sim_count.dhcp_reboot == 1, "NAK: %d INIT-REBOOT", sim_count.dhcp_reboot);
+
+	/* new passphrase: the old PMK is not even tried */
+	sim_home.passphrase = home = "tr0ub4dor&3";
+	e = (struct sim_expect){ 0, 1, 0, full, SIM_REBOOT_MS, SIM_PBKDF2_MS, 1 };
+	sim_case("new passphrase", "home", home, &e);
+
+	/* other network: neither the PMK nor the lease of home */
+	sim_air = &sim_office;
+	e = (struct sim_expect){ 0, 0, 0, full, SIM_DISCOVER_MS, SIM_PBKDF2_MS, 1 };
+	sim_case("other ssid", "office", sim_office.passphrase, &e);
+	SIM_CHECK(sim_count.dhcp_reboot == 0, "other ssid: %d INIT-REBOOT", sim_count.dhcp_reboot);
+
+	e = (struct sim_expect){ 1, 1, 0, fast, SIM_REBOOT_MS, 0, 0 };
+	sim_case("warm again", "office", sim_office.passphrase, &e);
+
+	/* cleared cache: back to the cold path */
+	fast_connect_clear();
+	SIM_CHECK(sim_sysinfo.wlan_sta_fast.magic == 0, "clear: cache still valid");
+	e = (struct sim_expect){ 0, 0, 0, full, SIM_DISCOVER_MS, SIM_PBKDF2_MS, 1 };
+	sim_case("cleared", "office", sim_office.passphrase, &e);
+
+	if (sim_errors) {
+		printf("%d errors\n", sim_errors);
+		return 1;
+	}
+	printf("\ntime to IP %u ms cold, %u ms warm\n",
+	       full + SIM_DISCOVER_MS, fast + SIM_REBOOT_MS);
+	return 0;
+}
@@ -0,0 +1,14 @@
+#!/bin/sh
+#
+# Build fast_connect.c against the real lwIP and wlan headers and the host
+# stand-ins of port/, and run the simulated connections.
+#
+set -e
+cd "$(dirname "$0")"
+gcc -O2 -Wall -DPRJCONF_NET_FAST_CONNECT=1 -DPRJCONF_SYSINFO_SAVE_TO_FLASH=1 \
+	-D__CONFIG_OS_FREERTOS -D__CONFIG_CHIP_XR871 -D__CONFIG_ARCH_DUAL_CORE -D__CONFIG_ARCH_APP_CORE \
+	-Iport -I.. -I../../.. -I../../../../include -I../../../../include/kernel/FreeRTOS \
+	-I../../../../include/kernel/FreeRTOS/portable/GCC/ARM_CM4F -I../../../../include/net/lwip-2.0.3 \
+	fast_connect_sim.c ../fast_connect.c -o /tmp/fast_connect_sim
+/tmp/fast_connect_sim
+echo "PASS"
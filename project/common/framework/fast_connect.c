@@ -0,0 +1,443 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include "kernel/os/os.h"
+#include "lwip/tcpip.h"
+#include "lwip/inet.h"
+#include "lwip/dhcp.h"
+#ifndef __CONFIG_LWIP_V1
+#include "lwip/prot/dhcp.h"
+#endif
+#include "lwip/dns.h"
+#include "lwip/netifapi.h"
+#include "net/wlan/wlan.h"
+
+#include "common/framework/sys_ctrl/sys_ctrl.h"
+#include "common/framework/sysinfo.h"
+#include "net_ctrl.h"
+#include "net_ctrl_debug.h"
+#include "fast_connect.h"
+
+#if PRJCONF_NET_FAST_CONNECT
+
+/*
+ * Fast connect keeps the PMK and DHCP lease of the last connection in sysinfo.
+ * The next connection to the same network passes the PMK as a hex PSK, so
+ * the supplicant skips the PBKDF2 derivation, and asks the DHCP server to
+ * confirm the old address in INIT-REBOOT state instead of a full discovery.
+ * A rejected PMK falls back to the passphrase, a NAK or no reply to the
+ * INIT-REBOOT request falls back to discovery inside lwIP.
+ *
+ * The supplicant has no BSSID/frequency fields for a station network, so the
+ * cached BSSID and channel are only recorded to tell whether it roamed.
+ */
+
+#define FAST_CONNECT_ASSOC_TIMEOUT	(5000)	/* ms to associate with cached PMK */
+
+enum fast_connect_state {
+	FAST_CONNECT_IDLE,
+	FAST_CONNECT_ASSOC_FAST,
+	FAST_CONNECT_ASSOC_FULL,
+	FAST_CONNECT_DHCP,
+};
+
+struct fast_connect_ctx {
+	int state;
+	uint8_t ssid[WLAN_SSID_MAX_LEN];
+	uint8_t ssid_len;
+	uint8_t psk[WLAN_PASSPHRASE_MAX_LEN + 2];
+	uint8_t dhcp_reboot;
+	uint32_t t_start;
+	uint32_t t_assoc;
+	OS_Timer_t timer;
+	struct fast_connect_stats stats;
+};
+
+static struct fast_connect_ctx g_fast_connect;
+
+#ifndef __CONFIG_LWIP_V1
+static ip4_addr_t m_reboot_addr;
+#endif
+
+static __inline uint32_t fast_connect_time(void)
+{
+	return OS_TicksToMSecs(OS_GetTicks());
+}
+
+static uint32_t fast_connect_hash(uint32_t hash, const uint8_t *data, uint32_t len)
+{
+	/* FNV-1a */
+	while (len--) {
+		hash ^= *data++;
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+static uint32_t fast_connect_ssid_hash(const uint8_t *ssid, uint8_t ssid_len)
+{
+	return fast_connect_hash(2166136261U, ssid, ssid_len);
+}
+
+static uint32_t fast_connect_key_hash(const uint8_t *ssid, uint8_t ssid_len, const uint8_t *psk)
+{
+	uint32_t hash = fast_connect_ssid_hash(ssid, ssid_len);
+	return fast_connect_hash(hash, psk, strlen((const char *)psk));
+}
+
+/* only a passphrase needs PBKDF2, a 64 hex digits PSK is the PMK already */
+static int fast_connect_is_passphrase(const uint8_t *psk)
+{
+	size_t len = strlen((const char *)psk);
+	return (len >= 8 && len <= WLAN_PASSPHRASE_MAX_LEN);
+}
+
+static struct sysinfo_wlan_sta_fast *fast_connect_cache(void)
+{
+	struct sysinfo *sysinfo = sysinfo_get();
+	if (sysinfo == NULL) {
+		NET_ERR("failed to get sysinfo %p\n", sysinfo);
+		return NULL;
+	}
+
+	if (sysinfo->wlan_sta_fast.magic != SYSINFO_FAST_CONNECT_MAGIC) {
+		memset(&sysinfo->wlan_sta_fast, 0, sizeof(sysinfo->wlan_sta_fast));
+	}
+	return &sysinfo->wlan_sta_fast;
+}
+
+static void fast_connect_timeout(event_msg *msg);
+
+static void fast_connect_timer_cb(void *arg)
+{
+	/* run on sys_ctrl thread, same as net_ctrl_msg_process() */
+	sys_handler_send(fast_connect_timeout, 0, 0);
+}
+
+static void fast_connect_timer_start(struct fast_connect_ctx *ctx)
+{
+	if (!OS_TimerIsValid(&ctx->timer) &&
+	    OS_TimerCreate(&ctx->timer, OS_TIMER_ONCE, fast_connect_timer_cb,
+	                   NULL, FAST_CONNECT_ASSOC_TIMEOUT) != OS_OK) {
+		NET_WRN("fast connect timer create failed\n");
+		return;
+	}
+	OS_TimerStart(&ctx->timer);
+}
+
+static void fast_connect_timer_stop(struct fast_connect_ctx *ctx)
+{
+	if (OS_TimerIsValid(&ctx->timer))
+		OS_TimerStop(&ctx->timer);
+}
+
+static void fast_connect_fallback(struct fast_connect_ctx *ctx)
+{
+	struct sysinfo_wlan_sta_fast *fast = fast_connect_cache();
+
+	NET_INF("cached PMK failed, connect with passphrase\n");
+	fast_connect_timer_stop(ctx);
+	if (fast)
+		fast->pmk_valid = 0;
+
+	ctx->stats.fast_assoc = 0;
+	ctx->stats.fallback = 1;
+	ctx->state = FAST_CONNECT_ASSOC_FULL;
+	wlan_sta_disable();
+	wlan_sta_set(ctx->ssid, ctx->ssid_len, ctx->psk);
+	wlan_sta_enable();
+}
+
+static void fast_connect_timeout(event_msg *msg)
+{
+	if (g_fast_connect.state == FAST_CONNECT_ASSOC_FAST)
+		fast_connect_fallback(&g_fast_connect);
+}
+
+/**
+ * @brief Configure and enable station, reuse the cached PMK if it belongs to
+ *        the same ssid and passphrase
+ * @param[in] ssid Network name
+ * @param[in] ssid_len Length of the ssid
+ * @param[in] psk Passphrase or hex PSK, NULL or "" for open network
+ * @return 0 on success, -1 on failure
+ */
+int fast_connect_sta(uint8_t *ssid, uint8_t ssid_len, uint8_t *psk)
+{
+	struct fast_connect_ctx *ctx = &g_fast_connect;
+	struct sysinfo_wlan_sta_fast *fast;
+	char hex[SYSINFO_PMK_LEN * 2 + 1];
+	int i;
+
+	if ((ssid == NULL) || (ssid_len == 0) || (ssid_len > WLAN_SSID_MAX_LEN)) {
+		NET_ERR("invalid ssid (%p, %u)\n", ssid, ssid_len);
+		return -1;
+	}
+
+	fast_connect_timer_stop(ctx);
+	memset(&ctx->stats, 0, sizeof(ctx->stats));
+	memcpy(ctx->ssid, ssid, ssid_len);
+	ctx->ssid_len = ssid_len;
+	if (psk)
+		strlcpy((char *)ctx->psk, (char *)psk, sizeof(ctx->psk));
+	else
+		ctx->psk[0] = '\0';
+	ctx->t_start = fast_connect_time();
+
+	fast = fast_connect_cache();
+	if (fast && fast->pmk_valid && fast_connect_is_passphrase(ctx->psk) &&
+	    fast->key_hash == fast_connect_key_hash(ssid, ssid_len, ctx->psk)) {
+		for (i = 0; i < SYSINFO_PMK_LEN; ++i) {
+			hex[i * 2] = "0123456789abcdef"[fast->pmk[i] >> 4];
+			hex[i * 2 + 1] = "0123456789abcdef"[fast->pmk[i] & 0xf];
+		}
+		hex[SYSINFO_PMK_LEN * 2] = '\0';
+		if (wlan_sta_set(ssid, ssid_len, (uint8_t *)hex) != 0)
+			return -1;
+		ctx->stats.fast_assoc = 1;
+		ctx->state = FAST_CONNECT_ASSOC_FAST;
+		fast_connect_timer_start(ctx);
+	} else {
+		if (wlan_sta_set(ssid, ssid_len, ctx->psk) != 0)
+			return -1;
+		ctx->state = FAST_CONNECT_ASSOC_FULL;
+	}
+
+	return wlan_sta_enable();
+}
+
+/**
+ * @brief Drop the cached PMK and lease, the next connection takes the full path
+ * @return None
+ */
+void fast_connect_clear(void)
+{
+	struct sysinfo_wlan_sta_fast *fast = fast_connect_cache();
+
+	if (fast && fast->magic == SYSINFO_FAST_CONNECT_MAGIC) {
+		memset(fast, 0, sizeof(*fast));
+#if PRJCONF_SYSINFO_SAVE_TO_FLASH
+		sysinfo_save();
+#endif
+	}
+}
+
+#ifndef __CONFIG_LWIP_V1
+static err_t fast_connect_dhcp_reboot(struct netif *nif)
+{
+	return dhcp_start_reboot(nif, &m_reboot_addr);
+}
+
+static int fast_connect_lease_usable(struct sysinfo_wlan_sta_fast *fast, uint32_t ssid_hash)
+{
+	uint32_t now;
+
+	if (!fast->lease_valid || fast->ssid_hash != ssid_hash)
+		return 0;
+
+	/* the clock may restart after power off, let the server judge then */
+	now = (uint32_t)time(NULL);
+	if (OS_TimeAfterEqual(now, fast->lease_start) &&
+	    now - fast->lease_start >= fast->lease_time) {
+		NET_DBG("cached lease expired\n");
+		return 0;
+	}
+
+	return 1;
+}
+#endif /* __CONFIG_LWIP_V1 */
+
+/**
+ * @brief Start DHCP on station, from INIT-REBOOT if a lease of this network
+ *        is cached
+ * @param[in] nif Station net interface
+ * @return 0 on success, -1 on failure
+ */
+int fast_connect_dhcp_start(struct netif *nif)
+{
+#ifndef __CONFIG_LWIP_V1
+	struct fast_connect_ctx *ctx = &g_fast_connect;
+	struct sysinfo_wlan_sta_fast *fast = fast_connect_cache();
+	ip_addr_t dns;
+
+	ctx->dhcp_reboot = 0;
+	if (ctx->state != FAST_CONNECT_IDLE && fast &&
+	    fast_connect_lease_usable(fast, fast_connect_ssid_hash(ctx->ssid, ctx->ssid_len))) {
+		NET_INF("DHCP reboot with %s\n", inet_ntoa(fast->lease.ip_addr));
+		if (fast->dns != 0) {
+			IP_SET_TYPE_VAL(dns, IPADDR_TYPE_V4);
+			ip4_addr_set_u32(ip_2_ip4(&dns), fast->dns);
+			dns_setserver(0, &dns);
+		}
+		ip4_addr_copy(m_reboot_addr, fast->lease.ip_addr);
+		ctx->dhcp_reboot = 1;
+		return netifapi_netif_common(nif, NULL, fast_connect_dhcp_reboot) == ERR_OK ? 0 : -1;
+	}
+#endif
+	return netifapi_dhcp_start(nif) == ERR_OK ? 0 : -1;
+}
+
+static void fast_connect_save(struct fast_connect_ctx *ctx)
+{
+	struct sysinfo_wlan_sta_fast *fast = fast_connect_cache();
+	struct sysinfo_wlan_sta_fast old;
+	wlan_sta_ap_t *ap;
+	wlan_gen_psk_param_t *param;
+	uint32_t key_hash;
+
+	if (fast == NULL)
+		return;
+	memcpy(&old, fast, sizeof(old));
+
+	ap = malloc(sizeof(*ap));
+	if (ap && wlan_sta_ap_info(ap) == 0) {
+		if (fast->magic == SYSINFO_FAST_CONNECT_MAGIC &&
+		    memcmp(fast->bssid, ap->bssid, SYSINFO_BSSID_LEN) != 0) {
+			NET_DBG("roamed from cached bssid\n");
+		}
+		memcpy(fast->bssid, ap->bssid, SYSINFO_BSSID_LEN);
+		fast->channel = ap->channel;
+	}
+	free(ap);
+
+	/* derive PMK once per ssid and passphrase, it is off the time to IP path */
+	key_hash = fast_connect_key_hash(ctx->ssid, ctx->ssid_len, ctx->psk);
+	if (!fast_connect_is_passphrase(ctx->psk)) {
+		fast->pmk_valid = 0;
+	} else if (!fast->pmk_valid || fast->key_hash != key_hash) {
+		param = malloc(sizeof(*param));
+		if (param) {
+			memcpy(param->ssid, ctx->ssid, ctx->ssid_len);
+			param->ssid_len = ctx->ssid_len;
+			strlcpy(param->passphrase, (char *)ctx->psk, sizeof(param->passphrase));
+			if (wlan_sta_gen_psk(param) == 0) {
+				memcpy(fast->pmk, param->psk, SYSINFO_PMK_LEN);
+				fast->pmk_valid = 1;
+			}
+			free(param);
+		}
+	}
+	fast->key_hash = key_hash;
+	fast->ssid_hash = fast_connect_ssid_hash(ctx->ssid, ctx->ssid_len);
+
+#ifndef __CONFIG_LWIP_V1
+	struct dhcp *dhcp = netif_dhcp_data(g_wlan_netif);
+	const ip_addr_t *dns = dns_getserver(0);
+
+	if (dhcp && dhcp->state == DHCP_STATE_BOUND) {
+		ip4_addr_copy(fast->lease.ip_addr, dhcp->offered_ip_addr);
+		ip4_addr_copy(fast->lease.net_mask, dhcp->offered_sn_mask);
+		ip4_addr_copy(fast->lease.gateway, dhcp->offered_gw_addr);
+		fast->lease_time = dhcp->offered_t0_lease;
+		fast->lease_start = (uint32_t)time(NULL);
+		fast->lease_valid = 1;
+	} else {
+		fast->lease_valid = 0;
+	}
+	fast->dns = dns ? ip4_addr_get_u32(ip_2_ip4(dns)) : 0;
+#endif
+	fast->magic = SYSINFO_FAST_CONNECT_MAGIC;
+
+	/*
+	 * The lease start moves every time, only rewrite flash on a real change
+	 * or once the stored start is half a lease old, else the lease in flash
+	 * looks expired at every boot after one lease period.
+	 */
+	if (OS_TimeBeforeEqual(fast->lease_start, old.lease_start + fast->lease_time / 2))
+		old.lease_start = fast->lease_start;
+	if (memcmp(&old, fast, sizeof(old)) != 0) {
+#if PRJCONF_SYSINFO_SAVE_TO_FLASH
+		sysinfo_save();
+#endif
+	}
+}
+
+/**
+ * @brief Track the station connection, called with every net ctrl message
+ * @param[in] type Net ctrl message type
+ * @return None
+ */
+void fast_connect_process(uint16_t type)
+{
+	struct fast_connect_ctx *ctx = &g_fast_connect;
+	struct fast_connect_stats *stats = &ctx->stats;
+	uint32_t now;
+
+	switch (type) {
+	case NET_CTRL_MSG_WLAN_CONNECTED:
+		if (ctx->state == FAST_CONNECT_ASSOC_FAST || ctx->state == FAST_CONNECT_ASSOC_FULL) {
+			fast_connect_timer_stop(ctx);
+			ctx->t_assoc = fast_connect_time();
+			stats->assoc_ms = ctx->t_assoc - ctx->t_start;
+			ctx->state = FAST_CONNECT_DHCP;
+		} else if (ctx->state == FAST_CONNECT_DHCP) {
+			ctx->t_assoc = fast_connect_time(); /* reconnected before IP bound */
+		}
+		break;
+	case NET_CTRL_MSG_WLAN_4WAY_HANDSHAKE_FAILED:
+	case NET_CTRL_MSG_WLAN_CONNECT_FAILED:
+		if (ctx->state == FAST_CONNECT_ASSOC_FAST)
+			fast_connect_fallback(ctx);
+		break;
+	case NET_CTRL_MSG_NETWORK_UP:
+		if (ctx->state != FAST_CONNECT_DHCP)
+			break;
+		now = fast_connect_time();
+		stats->dhcp_ms = now - ctx->t_assoc;
+		stats->total_ms = now - ctx->t_start;
+#ifndef __CONFIG_LWIP_V1
+		stats->fast_dhcp = ctx->dhcp_reboot &&
+		                   ip4_addr_cmp(netif_ip4_addr(g_wlan_netif), &m_reboot_addr);
+#endif
+		ctx->state = FAST_CONNECT_IDLE;
+		fast_connect_save(ctx);
+		stats->cache_ms = fast_connect_time() - now;
+		NET_INF("time to IP %u ms (assoc %u ms %s, dhcp %u ms %s)\n",
+		        stats->total_ms, stats->assoc_ms, stats->fast_assoc ? "fast" : "full",
+		        stats->dhcp_ms, stats->fast_dhcp ? "fast" : "full");
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * @brief Get the time to IP of the last station connection
+ * @param[out] stats Pointer to fast_connect_stats structure
+ * @return None
+ */
+void fast_connect_get_stats(struct fast_connect_stats *stats)
+{
+	memcpy(stats, &g_fast_connect.stats, sizeof(*stats));
+}
+
+#endif /* PRJCONF_NET_FAST_CONNECT */
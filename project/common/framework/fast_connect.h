@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _FAST_CONNECT_H_
+#define _FAST_CONNECT_H_
+
+#include <stdint.h>
+#include "lwip/netif.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if PRJCONF_NET_FAST_CONNECT
+
+/**
+ * @brief Time to IP of the last station connection, in ms
+ */
+struct fast_connect_stats {
+	uint8_t  fast_assoc;	/* associated with the cached PMK */
+	uint8_t  fast_dhcp;		/* cached lease confirmed by INIT-REBOOT */
+	uint8_t  fallback;		/* cached PMK rejected or timed out */
+	uint32_t assoc_ms;		/* start to wlan connected */
+	uint32_t dhcp_ms;		/* wlan connected to IP bound */
+	uint32_t total_ms;		/* start to IP bound */
+	uint32_t cache_ms;		/* caching after IP bound, including PMK derivation */
+};
+
+int fast_connect_sta(uint8_t *ssid, uint8_t ssid_len, uint8_t *psk);
+void fast_connect_clear(void);
+int fast_connect_dhcp_start(struct netif *nif);
+void fast_connect_process(uint16_t type);
+void fast_connect_get_stats(struct fast_connect_stats *stats);
+
+#endif /* PRJCONF_NET_FAST_CONNECT */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FAST_CONNECT_H_ */
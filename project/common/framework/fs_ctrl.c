@@ -31,6 +31,7 @@
 #include "driver/chip/sdmmc/hal_sdhost.h"
 #include "common/framework/sys_ctrl/sys_ctrl.h"
 #include "fs/fatfs/ff.h"
+#include "fs/fatfs/diskio.h"
 #include "driver/chip/sdmmc/sdmmc.h"
 
 #define FS_DBG_ON	0
@@ -163,6 +164,7 @@ int fs_ctrl_unmount(enum fs_mnt_dev_type dev_type, uint32_t dev_id)
 		free(fs_ctrl.fs);
 		fs_ctrl.fs = NULL;
 	}
+	disk_ioctl(0, CTRL_EJECT, NULL); /* write back and release the card */
 
 	struct mmc_card *card = mmc_card_open(dev_id);
 	if (card == NULL) {
@@ -190,6 +192,26 @@ out:
 	return ret;
 }
 
+/*
+ * @brief Write the sectors held by the disk cache to the card
+ * @note The buffers of the open files are not written, f_sync() them first
+ *       when there is time. Called on a power fail warning, it does not wait
+ *       for the FatFs calls in progress but only for their card transfer.
+ * @return 0 on success, -1 on failure
+ */
+int fs_ctrl_flush(void)
+{
+	int ret = 0;
+
+	FS_CTRL_LOCK();
+	if (fs_ctrl.fs != NULL && disk_ioctl(0, CTRL_SYNC, NULL) != RES_OK) {
+		FS_ERR("flush fail\n");
+		ret = -1;
+	}
+	FS_CTRL_UNLOCK();
+	return ret;
+}
+
 static void fs_ctrl_msg_process(uint32_t event, uint32_t data, void *arg)
 {
 	switch (EVENT_SUBTYPE(event)) {
@@ -72,6 +72,8 @@ enum fs_mnt_status {
 int fs_ctrl_init(void);
 int fs_ctrl_mount(enum fs_mnt_dev_type dev_type, uint32_t dev_id);
 int fs_ctrl_unmount(enum fs_mnt_dev_type dev_type, uint32_t dev_id);
+/* Write back the disk cache, e.g. on a power fail warning */
+int fs_ctrl_flush(void);
 
 void sdcard_detect_callback(uint32_t present);
 
@@ -38,6 +38,7 @@
 
 #include "common/framework/sys_ctrl/sys_ctrl.h"
 #include "common/framework/sysinfo.h"
+#include "fast_connect.h"
 #include "net_ctrl.h"
 #include "net_ctrl_debug.h"
 
@@ -242,7 +243,11 @@ static void netif_config(struct netif *nif, struct netif_conf *conf)
 			}
 
 			NET_INF("start DHCP...\n");
+#if PRJCONF_NET_FAST_CONNECT
+			if (fast_connect_dhcp_start(nif) != 0) {
+#else
 			if (netifapi_dhcp_start(nif) != ERR_OK) {
+#endif
 				NET_ERR("DHCP start failed!\n");
 				return;
 			}
@@ -491,6 +496,10 @@ void net_ctrl_msg_process(uint32_t event, uint32_t data, void *arg)
 	uint16_t type = EVENT_SUBTYPE(event);
 	NET_INF("msg <%s>\n", net_ctrl_msg_str[type]);
 
+#if PRJCONF_NET_FAST_CONNECT
+	fast_connect_process(type);
+#endif
+
 	switch (type) {
 	case NET_CTRL_MSG_WLAN_CONNECTED:
 		connect_status = NET_CTRL_MSG_WLAN_CONNECTED;	//tuya-iot luowq add
@@ -0,0 +1,446 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Linux stress test of the publisher and its observers (publisher.c,
+ * observer.c, looper.c), on the pthread stand-ins of port/.
+ *
+ *   ./run.sh [events]
+ *
+ * Events are notified straight from bench threads, as the looper of the
+ * publisher would. The checks:
+ *  - a thread observer whose run() is slow never holds the publisher: its
+ *    full queue drops and counts, notify stays short;
+ *  - an observer that needs more stack than the shared workers have runs on
+ *    a worker of its own, the others stay on the shared pool;
+ *  - an observer on a dedicated worker is not delayed by slow observers
+ *    which occupy the shared workers, the latency of a fast observer is
+ *    printed with the slow ones shared and dedicated;
+ *  - 4 notifiers and a stats reader run against callback and thread
+ *    observers, every callback observer sees each of its events once,
+ *    every thread observer runs or drops each of them, and the stats read
+ *    meanwhile are never torn.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "kernel/os/os.h"
+#include "event_queue.h"
+#include "observer.h"
+#include "publisher.h"
+
+#define SIM_TYPES               50
+#define SIM_CB_OBS              200
+#define SIM_THREAD_OBS          100
+#define SIM_NOTIFIERS           4
+#define SIM_EVENTS              20000
+#define SIM_SLOW_MS             20
+#define SIM_ROUNDS              100
+
+static int sim_errors;
+
+#define SIM_CHECK(cond, fmt, arg...)                                    \
+	do {                                                            \
+		if (!(cond)) {                                          \
+			printf("FAIL %s:%d: " fmt "\n", __func__,       \
+			       __LINE__, ##arg);                        \
+			sim_errors++;                                   \
+		}                                                       \
+	} while (0)
+
+pthread_mutex_t sim_irq_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+#define SIM_EVENT(type)         ((uint32_t)(type) << 16)
+
+static publisher_base *g_pub;
+
+static uint32_t sim_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static int sim_compare(uint32_t newEvent, uint32_t obsEvent)
+{
+	return newEvent == obsEvent ? 0 : -1;
+}
+
+static uint32_t sim_index(uint32_t event)
+{
+	return event >> 16;
+}
+
+static publisher_base *sim_publisher_create(void)
+{
+	event_queue *q = normal_event_queue_create(16, sizeof(event_msg));
+	publisher_factory *ctor = publisher_factory_create(q);
+
+	return ctor->set_compare(ctor, sim_compare)
+	           ->set_index(ctor, sim_index, 16)
+	           ->create_publisher(ctor);
+}
+
+/*
+ * Detach, wait for the workers to run or drop the @expected events of a
+ * thread observer, keep its stats and destroy it.
+ */
+static void sim_observer_remove(observer_base *obs, uint32_t expected,
+                                observer_stats *st)
+{
+	int i;
+
+	g_pub->detach(g_pub, obs);
+	for (i = 0; st != NULL && i < 5000; i++) {
+		observer_get_stats(obs, st);
+		if (st->count + st->drop >= expected)
+			break;
+		OS_MSleep(1);
+	}
+	while (observer_destroy(obs) != 0)
+		OS_MSleep(1);
+}
+
+/* ------------------------------------------------------------------------ */
+/* a slow observer never holds the publisher                                 */
+
+static volatile uint32_t g_exceptions;
+
+static void slow_run(uint32_t event, uint32_t data, void *arg)
+{
+	OS_MSleep(SIM_SLOW_MS);
+}
+
+static void slow_exception(int ret)
+{
+	if (ret == OS_E_NOMEM)
+		__sync_fetch_and_add(&g_exceptions, 1);
+}
+
+static void observer_check_backpressure(void)
+{
+	observer_base *obs = thread_observer_create(SIM_EVENT(1), slow_run, NULL, 1024,
+	                                            OS_PRIORITY_NORMAL);
+	observer_stats st;
+	uint32_t t0, dt, dt_max = 0;
+	int i;
+
+	thread_observer_throw(obs, slow_exception);
+	g_pub->attach(g_pub, obs);
+	g_exceptions = 0;
+	for (i = 0; i < 50; i++) {
+		t0 = sim_us();
+		g_pub->notify(g_pub, SIM_EVENT(1), i);
+		dt = sim_us() - t0;
+		if (dt > dt_max)
+			dt_max = dt;
+	}
+	sim_observer_remove(obs, 50, &st);
+
+	SIM_CHECK(dt_max < SIM_SLOW_MS * 1000 / 4, "notify held for %u us", dt_max);
+	SIM_CHECK(st.drop > 0 && st.drop == g_exceptions && st.count + st.drop == 50,
+	          "%u run, %u dropped, %u exceptions", st.count, st.drop, g_exceptions);
+	printf("slow observer: notify max %u us, %u of 50 run, %u dropped\n",
+	       dt_max, st.count, st.drop);
+}
+
+/* ------------------------------------------------------------------------ */
+/* dedicated workers                                                         */
+
+/* the shared pool keeps its stack, a larger observer gets a worker of its own */
+static void observer_check_stack(void)
+{
+	observer_base *big, *small;
+	observer_stats st;
+
+	big = thread_observer_create(SIM_EVENT(5), slow_run, NULL, 8 * 1024,
+	                             OS_PRIORITY_HIGH);
+	small = thread_observer_create(SIM_EVENT(5), slow_run, NULL, 1024,
+	                               OS_PRIORITY_NORMAL);
+	SIM_CHECK(big != NULL && small != NULL, "large stack observer refused");
+	if (big == NULL || small == NULL) {
+		observer_destroy(big);
+		observer_destroy(small);
+		return;
+	}
+
+	g_pub->attach(g_pub, big);
+	g_pub->attach(g_pub, small);
+	g_pub->notify(g_pub, SIM_EVENT(5), 0);
+	sim_observer_remove(big, 1, &st);
+	SIM_CHECK(st.count == 1, "large stack observer ran %u times", st.count);
+	sim_observer_remove(small, 1, &st);
+	SIM_CHECK(st.count == 1, "small observer ran %u times", st.count);
+}
+
+static uint32_t g_fast_lat[SIM_ROUNDS];
+static volatile uint32_t g_fast_cnt;
+
+static void fast_run(uint32_t event, uint32_t data, void *arg)
+{
+	if (g_fast_cnt < SIM_ROUNDS)
+		g_fast_lat[g_fast_cnt] = sim_us() - data;
+	__sync_fetch_and_add(&g_fast_cnt, 1);
+}
+
+/* slow observers of type 2 and 3 keep the shared workers busy */
+static uint32_t observer_isolation(int dedicated)
+{
+	observer_base *slow[2], *fast;
+	observer_stats st;
+	uint32_t n, p99;
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		slow[i] = thread_observer_create(SIM_EVENT(2 + i), slow_run, NULL, 1024,
+		                                 OS_PRIORITY_NORMAL);
+		if (dedicated)
+			SIM_CHECK(thread_observer_set_dedicated(slow[i], OS_PRIORITY_LOW, 1024) == 0,
+			          "dedicated worker");
+		g_pub->attach(g_pub, slow[i]);
+	}
+	fast = thread_observer_create(SIM_EVENT(4), fast_run, NULL, 1024, OS_PRIORITY_NORMAL);
+	g_pub->attach(g_pub, fast);
+
+	g_fast_cnt = 0;
+	for (i = 0; i < SIM_ROUNDS; i++) {
+		g_pub->notify(g_pub, SIM_EVENT(2), 0);
+		g_pub->notify(g_pub, SIM_EVENT(3), 0);
+		g_pub->notify(g_pub, SIM_EVENT(4), sim_us());
+		OS_MSleep(2);
+	}
+	sim_observer_remove(fast, SIM_ROUNDS, &st);
+	for (i = 0; i < 2; i++)
+		sim_observer_remove(slow[i], SIM_ROUNDS, &st);
+
+	n = g_fast_cnt < SIM_ROUNDS ? g_fast_cnt : SIM_ROUNDS;
+	SIM_CHECK(!dedicated || n == SIM_ROUNDS, "fast observer ran %u of %u",
+	          n, SIM_ROUNDS);
+	if (n == 0)
+		return 0xFFFFFFFF;
+	qsort(g_fast_lat, n, sizeof(g_fast_lat[0]), cmp_u32);
+	p99 = g_fast_lat[n * 99 / 100];
+	printf("fast observer, slow ones %-9s: %3u of %u run, p50 %6u us, p99 %6u us\n",
+	       dedicated ? "dedicated" : "shared", n, SIM_ROUNDS, g_fast_lat[n / 2], p99);
+	return p99;
+}
+
+static void observer_check_isolation(void)
+{
+	uint32_t shared = observer_isolation(0);
+	uint32_t dedicated = observer_isolation(1);
+
+	SIM_CHECK(dedicated < shared && dedicated < SIM_SLOW_MS * 1000 / 4,
+	          "p99 %u us dedicated, %u us shared", dedicated, shared);
+}
+
+/* ------------------------------------------------------------------------ */
+/* stress                                                                    */
+
+typedef struct sim_obs {
+	observer_base *obs;
+	uint32_t type;
+	volatile uint32_t seen;
+} sim_obs;
+
+static sim_obs g_cb[SIM_CB_OBS];
+static sim_obs g_th[SIM_THREAD_OBS];
+static uint32_t g_sent[SIM_TYPES];
+static int g_stress_run;
+static uint32_t g_torn;
+
+static void stress_cb(uint32_t event, uint32_t data, void *arg)
+{
+	sim_obs *o = arg;
+
+	o->seen++;      /* callbacks run under the publisher lock */
+}
+
+static void stress_run(uint32_t event, uint32_t data, void *arg)
+{
+	sim_obs *o = arg;
+
+	__sync_fetch_and_add(&o->seen, 1);
+}
+
+typedef struct sim_notifier {
+	pthread_t t;
+	int id;
+	int events;
+	uint32_t sent[SIM_TYPES];
+	uint32_t *lat;
+} sim_notifier;
+
+static void *stress_notifier(void *arg)
+{
+	sim_notifier *n = arg;
+	uint32_t seed = n->id + 1, type, t0;
+	int i;
+
+	for (i = 0; i < n->events; i++) {
+		seed = seed * 1103515245 + 12345;
+		type = (seed >> 8) % SIM_TYPES;
+		t0 = sim_us();
+		g_pub->notify(g_pub, SIM_EVENT(100 + type), i);
+		n->lat[i] = sim_us() - t0;
+		n->sent[type]++;
+		if ((i & 63) == 63)
+			usleep(200);
+	}
+	return NULL;
+}
+
+/* a snapshot is consistent if each max is within its sum */
+static void *stress_reader(void *arg)
+{
+	observer_stats st, last[SIM_THREAD_OBS];
+	int i;
+
+	memset(last, 0, sizeof(last));
+	while (__atomic_load_n(&g_stress_run, __ATOMIC_ACQUIRE)) {
+		for (i = 0; i < SIM_THREAD_OBS; i++) {
+			observer_get_stats(g_th[i].obs, &st);
+			if (st.lat_max > st.lat_sum || st.run_max > st.run_sum ||
+			    st.count < last[i].count || st.drop < last[i].drop ||
+			    st.lat_sum < last[i].lat_sum)
+				g_torn++;
+			last[i] = st;
+		}
+	}
+	return NULL;
+}
+
+static void observer_stress(int events)
+{
+	static sim_notifier nt[SIM_NOTIFIERS];
+	uint32_t *lat = malloc(sizeof(uint32_t) * SIM_NOTIFIERS * events);
+	uint32_t run = 0, drop = 0, t0, total;
+	observer_stats st;
+	pthread_t reader;
+	int i, t;
+
+	for (i = 0; i < SIM_CB_OBS; i++) {
+		g_cb[i].type = i % SIM_TYPES;
+		g_cb[i].obs = callback_observer_create(SIM_EVENT(100 + g_cb[i].type),
+		                                       stress_cb, &g_cb[i]);
+		g_pub->attach(g_pub, g_cb[i].obs);
+	}
+	for (i = 0; i < SIM_THREAD_OBS; i++) {
+		g_th[i].type = i % SIM_TYPES;
+		g_th[i].obs = thread_observer_create(SIM_EVENT(100 + g_th[i].type),
+		                                     stress_run, &g_th[i], 1024,
+		                                     OS_PRIORITY_NORMAL);
+		if (i % 25 == 0)
+			thread_observer_set_dedicated(g_th[i].obs, OS_PRIORITY_NORMAL, 1024);
+		g_pub->attach(g_pub, g_th[i].obs);
+	}
+
+	__atomic_store_n(&g_stress_run, 1, __ATOMIC_RELEASE);
+	pthread_create(&reader, NULL, stress_reader, NULL);
+	t0 = sim_us();
+	for (i = 0; i < SIM_NOTIFIERS; i++) {
+		nt[i].id = i;
+		nt[i].events = events;
+		nt[i].lat = lat + i * events;
+		memset(nt[i].sent, 0, sizeof(nt[i].sent));
+		pthread_create(&nt[i].t, NULL, stress_notifier, &nt[i]);
+	}
+	memset(g_sent, 0, sizeof(g_sent));
+	for (i = 0; i < SIM_NOTIFIERS; i++) {
+		pthread_join(nt[i].t, NULL);
+		for (t = 0; t < SIM_TYPES; t++)
+			g_sent[t] += nt[i].sent[t];
+	}
+	total = sim_us() - t0;
+
+	__atomic_store_n(&g_stress_run, 0, __ATOMIC_RELEASE);
+	pthread_join(reader, NULL);
+
+	for (i = 0; i < SIM_CB_OBS; i++) {
+		SIM_CHECK(g_cb[i].seen == g_sent[g_cb[i].type], "callback %d: %u of %u",
+		          i, g_cb[i].seen, g_sent[g_cb[i].type]);
+		sim_observer_remove(g_cb[i].obs, 0, NULL);
+	}
+	for (i = 0; i < SIM_THREAD_OBS; i++) {
+		sim_observer_remove(g_th[i].obs, g_sent[g_th[i].type], &st);
+		SIM_CHECK(st.count == __atomic_load_n(&g_th[i].seen, __ATOMIC_ACQUIRE) &&
+		          st.count + st.drop == g_sent[g_th[i].type],
+		          "thread %d: %u run, %u dropped, %u sent", i, st.count, st.drop,
+		          g_sent[g_th[i].type]);
+		run += st.count;
+		drop += st.drop;
+	}
+	SIM_CHECK(g_torn == 0, "%u torn stats snapshots", g_torn);
+
+	qsort(lat, SIM_NOTIFIERS * events, sizeof(lat[0]), cmp_u32);
+	printf("stress: %d x %d events, %.2f us/event, notify p50 %u us, p99 %u us\n"
+	       "        thread observers ran %u, dropped %u\n",
+	       SIM_NOTIFIERS, events, (double)total / (SIM_NOTIFIERS * events),
+	       lat[SIM_NOTIFIERS * events / 2], lat[SIM_NOTIFIERS * events * 99 / 100],
+	       run, drop);
+	free(lat);
+}
+
+int main(int argc, char *argv[])
+{
+	int events = (argc > 1) ? atoi(argv[1]) : SIM_EVENTS;
+
+	if (events <= 0)
+		events = SIM_EVENTS;
+
+	g_pub = sim_publisher_create();
+	if (g_pub == NULL) {
+		printf("FAIL publisher\n");
+		return 1;
+	}
+
+	observer_check_backpressure();
+	observer_check_stack();
+	observer_check_isolation();
+	observer_stress(events / SIM_NOTIFIERS);
+
+	if (sim_errors) {
+		printf("%d errors\n", sim_errors);
+		return 1;
+	}
+	return 0;
+}
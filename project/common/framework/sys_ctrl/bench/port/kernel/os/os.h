@@ -0,0 +1,359 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * pthread stand-in of the OS API used by sys_ctrl, for the Linux benchmarks
+ * only. A tick is a millisecond.
+ */
+
+#ifndef _BENCH_PORT_OS_H_
+#define _BENCH_PORT_OS_H_
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+typedef enum {
+	OS_OK = 0,
+	OS_FAIL = -1,
+	OS_E_NOMEM = -2,
+	OS_E_PARAM = -3,
+	OS_E_TIMEOUT = -4,
+} OS_Status;
+
+typedef enum {
+	OS_PRIORITY_IDLE = 0,
+	OS_PRIORITY_LOW = 1,
+	OS_PRIORITY_BELOW_NORMAL = 2,
+	OS_PRIORITY_NORMAL = 3,
+	OS_PRIORITY_ABOVE_NORMAL = 4,
+	OS_PRIORITY_HIGH = 5,
+	OS_PRIORITY_REAL_TIME = 6,
+} OS_Priority;
+
+typedef uint32_t OS_Time_t;
+
+#define OS_WAIT_FOREVER			0xffffffffU
+#define OS_SEMAPHORE_MAX_COUNT	0xffffffffU
+
+static __inline uint32_t OS_GetTicks(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+#define OS_TicksToMSecs(t)		(t)
+#define OS_MSecsToTicks(ms)		(ms)
+#define OS_TimeAfter(a, b)		((int32_t)(b) - (int32_t)(a) < 0)
+#define OS_MSleep(msec)			usleep((msec) * 1000)
+
+/* absolute CLOCK_MONOTONIC time @ms from now */
+static __inline void os_deadline(struct timespec *ts, uint32_t ms)
+{
+	clock_gettime(CLOCK_MONOTONIC, ts);
+	ts->tv_sec += ms / 1000;
+	ts->tv_nsec += (ms % 1000) * 1000000;
+	if (ts->tv_nsec >= 1000000000) {
+		ts->tv_sec++;
+		ts->tv_nsec -= 1000000000;
+	}
+}
+
+static __inline void os_cond_init(pthread_cond_t *cond)
+{
+	pthread_condattr_t attr;
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(cond, &attr);
+	pthread_condattr_destroy(&attr);
+}
+
+/* Wait on @cond while @cond_expr holds, OS_E_TIMEOUT after @ms */
+#define os_cond_wait(cond, mutex, ms, cond_expr)				\
+	({									\
+		struct timespec __ts;						\
+		int __err = 0;							\
+		if ((ms) != OS_WAIT_FOREVER)					\
+			os_deadline(&__ts, (ms));				\
+		while ((cond_expr) && __err == 0) {				\
+			if ((ms) == OS_WAIT_FOREVER)				\
+				pthread_cond_wait((cond), (mutex));		\
+			else							\
+				__err = pthread_cond_timedwait((cond), (mutex), &__ts); \
+		}								\
+		(cond_expr) ? OS_E_TIMEOUT : OS_OK;				\
+	})
+
+/* semaphore */
+typedef struct {
+	pthread_mutex_t m;
+	pthread_cond_t c;
+	uint32_t count;
+	uint32_t max;
+	int valid;
+} OS_Semaphore_t;
+
+static __inline OS_Status OS_SemaphoreCreate(OS_Semaphore_t *sem, uint32_t initCount,
+                                             uint32_t maxCount)
+{
+	pthread_mutex_init(&sem->m, NULL);
+	os_cond_init(&sem->c);
+	sem->count = initCount;
+	sem->max = maxCount;
+	sem->valid = 1;
+	return OS_OK;
+}
+
+static __inline OS_Status OS_SemaphoreCreateBinary(OS_Semaphore_t *sem)
+{
+	return OS_SemaphoreCreate(sem, 0, 1);
+}
+
+static __inline OS_Status OS_SemaphoreDelete(OS_Semaphore_t *sem)
+{
+	pthread_cond_destroy(&sem->c);
+	pthread_mutex_destroy(&sem->m);
+	sem->valid = 0;
+	return OS_OK;
+}
+
+static __inline OS_Status OS_SemaphoreWait(OS_Semaphore_t *sem, OS_Time_t waitMS)
+{
+	OS_Status ret;
+
+	pthread_mutex_lock(&sem->m);
+	ret = os_cond_wait(&sem->c, &sem->m, waitMS, sem->count == 0);
+	if (ret == OS_OK)
+		sem->count--;
+	pthread_mutex_unlock(&sem->m);
+	return ret;
+}
+
+static __inline OS_Status OS_SemaphoreRelease(OS_Semaphore_t *sem)
+{
+	OS_Status ret = OS_FAIL;
+
+	pthread_mutex_lock(&sem->m);
+	if (sem->count < sem->max) {
+		sem->count++;
+		pthread_cond_signal(&sem->c);
+		ret = OS_OK;
+	}
+	pthread_mutex_unlock(&sem->m);
+	return ret;
+}
+
+#define OS_SemaphoreIsValid(sem)	((sem)->valid)
+
+/* mutex, the recursive one shares the type */
+typedef struct {
+	pthread_mutex_t m;
+	int valid;
+} OS_Mutex_t;
+
+static __inline OS_Status os_mutex_create(OS_Mutex_t *mutex, int type)
+{
+	pthread_mutexattr_t attr;
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, type);
+	pthread_mutex_init(&mutex->m, &attr);
+	pthread_mutexattr_destroy(&attr);
+	mutex->valid = 1;
+	return OS_OK;
+}
+
+static __inline OS_Status OS_MutexCreate(OS_Mutex_t *mutex)
+{
+	return os_mutex_create(mutex, PTHREAD_MUTEX_NORMAL);
+}
+
+static __inline OS_Status OS_RecursiveMutexCreate(OS_Mutex_t *mutex)
+{
+	return os_mutex_create(mutex, PTHREAD_MUTEX_RECURSIVE);
+}
+
+static __inline OS_Status OS_MutexDelete(OS_Mutex_t *mutex)
+{
+	pthread_mutex_destroy(&mutex->m);
+	mutex->valid = 0;
+	return OS_OK;
+}
+
+/* waitMS is ignored, every caller in sys_ctrl waits forever */
+static __inline OS_Status OS_MutexLock(OS_Mutex_t *mutex, OS_Time_t waitMS)
+{
+	(void)waitMS;
+	return pthread_mutex_lock(&mutex->m) ? OS_FAIL : OS_OK;
+}
+
+static __inline OS_Status OS_MutexUnlock(OS_Mutex_t *mutex)
+{
+	return pthread_mutex_unlock(&mutex->m) ? OS_FAIL : OS_OK;
+}
+
+#define OS_RecursiveMutexDelete		OS_MutexDelete
+#define OS_RecursiveMutexLock		OS_MutexLock
+#define OS_RecursiveMutexUnlock		OS_MutexUnlock
+#define OS_MutexIsValid(mutex)		((mutex)->valid)
+
+/* queue of fixed size items */
+typedef struct {
+	pthread_mutex_t m;
+	pthread_cond_t c;
+	uint8_t *buf;
+	uint32_t len;
+	uint32_t size;
+	uint32_t head;
+	uint32_t count;
+	int valid;
+} OS_Queue_t;
+
+static __inline OS_Status OS_QueueCreate(OS_Queue_t *queue, uint32_t queueLen,
+                                         uint32_t itemSize)
+{
+	queue->buf = malloc(queueLen * itemSize);
+	if (queue->buf == NULL)
+		return OS_FAIL;
+	pthread_mutex_init(&queue->m, NULL);
+	os_cond_init(&queue->c);
+	queue->len = queueLen;
+	queue->size = itemSize;
+	queue->head = 0;
+	queue->count = 0;
+	queue->valid = 1;
+	return OS_OK;
+}
+
+static __inline OS_Status OS_QueueDelete(OS_Queue_t *queue)
+{
+	pthread_cond_destroy(&queue->c);
+	pthread_mutex_destroy(&queue->m);
+	free(queue->buf);
+	queue->valid = 0;
+	return OS_OK;
+}
+
+static __inline OS_Status OS_QueueSend(OS_Queue_t *queue, const void *item,
+                                       OS_Time_t waitMS)
+{
+	OS_Status ret;
+
+	pthread_mutex_lock(&queue->m);
+	ret = os_cond_wait(&queue->c, &queue->m, waitMS, queue->count == queue->len);
+	if (ret == OS_OK) {
+		memcpy(queue->buf + (queue->head + queue->count) % queue->len * queue->size,
+		       item, queue->size);
+		queue->count++;
+		pthread_cond_broadcast(&queue->c);
+	}
+	pthread_mutex_unlock(&queue->m);
+	return ret;
+}
+
+static __inline OS_Status OS_QueueReceive(OS_Queue_t *queue, void *item,
+                                          OS_Time_t waitMS)
+{
+	OS_Status ret;
+
+	pthread_mutex_lock(&queue->m);
+	ret = os_cond_wait(&queue->c, &queue->m, waitMS, queue->count == 0);
+	if (ret == OS_OK) {
+		memcpy(item, queue->buf + queue->head * queue->size, queue->size);
+		queue->head = (queue->head + 1) % queue->len;
+		queue->count--;
+		pthread_cond_broadcast(&queue->c);
+	}
+	pthread_mutex_unlock(&queue->m);
+	return ret;
+}
+
+#define OS_QueueIsValid(queue)		((queue)->valid)
+
+/* thread */
+typedef void (*OS_ThreadEntry_t)(void *);
+
+typedef struct {
+	pthread_t t;
+	volatile int valid;
+	OS_ThreadEntry_t entry;
+	void *arg;
+} OS_Thread_t;
+
+static void *os_thread_entry(void *arg)
+{
+	OS_Thread_t *thread = arg;
+
+	thread->entry(thread->arg);
+	return NULL;
+}
+
+static __inline OS_Status OS_ThreadCreate(OS_Thread_t *thread, const char *name,
+                                          OS_ThreadEntry_t entry, void *arg,
+                                          OS_Priority priority, uint32_t stackSize)
+{
+	(void)name;
+	(void)priority;
+	(void)stackSize;
+	thread->entry = entry;
+	thread->arg = arg;
+	thread->valid = 1;
+	if (pthread_create(&thread->t, NULL, os_thread_entry, thread)) {
+		thread->valid = 0;
+		return OS_FAIL;
+	}
+	pthread_detach(thread->t);
+	return OS_OK;
+}
+
+/* Only a thread deleting itself exits, others are only marked invalid */
+static __inline OS_Status OS_ThreadDelete(OS_Thread_t *thread)
+{
+	int self;
+
+	if (thread == NULL)
+		pthread_exit(NULL);
+	/* *thread may be freed as soon as it is invalid */
+	self = pthread_equal(thread->t, pthread_self());
+	__atomic_store_n(&thread->valid, 0, __ATOMIC_RELEASE);
+	if (self)
+		pthread_exit(NULL);
+	return OS_OK;
+}
+
+#define OS_ThreadIsValid(thread)	__atomic_load_n(&(thread)->valid, __ATOMIC_ACQUIRE)
+
+#endif /* _BENCH_PORT_OS_H_ */
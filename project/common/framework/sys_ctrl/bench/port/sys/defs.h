@@ -0,0 +1,21 @@
+/*
+ * Host stand-in for sys/defs.h: the C library already defines the byte
+ * order macros, only the container helpers are needed.
+ */
+
+#ifndef _SYS_DEFS_H_
+#define _SYS_DEFS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "compiler.h"
+
+#ifndef __containerof
+#define __containerof(ptr, type, field) \
+	((type *)((char *)(ptr) - offsetof(type, field)))
+#endif
+#ifndef container_of
+#define container_of(ptr, type, field) __containerof(ptr, type, field)
+#endif
+
+#endif /* _SYS_DEFS_H_ */
@@ -0,0 +1,16 @@
+/*
+ * Host stand-in for sys/interrupt.h: disabling interrupts takes one
+ * process-wide recursive lock, defined by each benchmark.
+ */
+
+#ifndef _SYS_INTERRUPT_H_
+#define _SYS_INTERRUPT_H_
+
+#include <pthread.h>
+
+extern pthread_mutex_t sim_irq_lock;
+
+#define arch_irq_disable()	pthread_mutex_lock(&sim_irq_lock)
+#define arch_irq_enable()	pthread_mutex_unlock(&sim_irq_lock)
+
+#endif /* _SYS_INTERRUPT_H_ */
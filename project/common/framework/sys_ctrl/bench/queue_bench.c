@@ -0,0 +1,331 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Linux test and benchmark of the priority event queue (event_queue.c over
+ * prio_heap of container.c), with the normal queue as reference.
+ *
+ *   ./run.sh [events per producer]
+ *
+ * Items are passed as uint32_t like on the 32-bit target, so the program
+ * is linked at a fixed low address and the messages and stats handed to
+ * the queue live in the data segment or in the heap of the main thread.
+ *
+ * The order checks fill a queue, pop it and expect strict priority with
+ * FIFO order among equal events. Then 4 producers send bursts of events of
+ * 4 priorities to one consumer through a 32 entry queue, the consumer
+ * checks that nothing is lost and that each producer's events of one
+ * priority arrive in order, and prints the send to receive latency.
+ */
+
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "kernel/os/os.h"
+#include "container.h"
+#include "event_queue.h"
+
+#define SIM_QUEUE_LEN           32
+#define SIM_PRODUCERS           4
+#define SIM_EVENTS              20000
+#define SIM_PRIOS               4
+#define SIM_BURST               16
+
+static int sim_errors;
+
+#define SIM_CHECK(cond, fmt, arg...)                                    \
+	do {                                                            \
+		if (!(cond)) {                                          \
+			printf("FAIL %s:%d: " fmt "\n", __func__,       \
+			       __LINE__, ##arg);                        \
+			sim_errors++;                                   \
+		}                                                       \
+	} while (0)
+
+pthread_mutex_t sim_irq_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+/* an event_msg with the send time in extra[0] */
+typedef union sim_msg {
+	event_msg msg;
+	uint32_t raw[sizeof(event_msg) / 4 + 1];
+} sim_msg;
+
+#define SIM_DATA(producer, seq)         ((uint32_t)(producer) << 24 | (seq))
+#define SIM_DATA_PRODUCER(data)         ((data) >> 24)
+#define SIM_DATA_SEQ(data)              ((data) & 0xFFFFFF)
+
+static struct container_stats g_stats;  /* passed as uint32_t */
+
+static uint32_t sim_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
+static uint32_t rnd(uint32_t *state, uint32_t n)
+{
+	*state = *state * 1103515245 + 12345;
+	return (*state >> 8) % n;
+}
+
+static int sim_send(event_queue *q, uint32_t event, uint32_t data, uint32_t wait_ms)
+{
+	sim_msg m;
+
+	memset(&m, 0, sizeof(m));
+	m.msg.event = event;
+	m.msg.data = data;
+	m.msg.extra[0] = sim_us();
+	return q->send(q, &m.msg, wait_ms);
+}
+
+/* ------------------------------------------------------------------------ */
+/* checks                                                                    */
+
+static void queue_check_order(void)
+{
+	event_queue *q = prio_event_queue_create(SIM_QUEUE_LEN, sizeof(sim_msg));
+	uint32_t seed = 7, last_event = 0, last_data[SIM_PRIOS];
+	sim_msg m;
+	int i;
+
+	SIM_CHECK(q != NULL, "create");
+	if (q == NULL)
+		return;
+	for (i = 0; i < SIM_QUEUE_LEN; i++)
+		SIM_CHECK(sim_send(q, rnd(&seed, SIM_PRIOS), i, 0) == 0, "send %d", i);
+	SIM_CHECK(sim_send(q, 0, 0, 0) != 0, "send to a full queue");
+
+	memset(last_data, 0xFF, sizeof(last_data));
+	for (i = 0; i < SIM_QUEUE_LEN; i++) {
+		SIM_CHECK(q->recv(q, &m.msg, 0) == 0, "recv %d", i);
+		SIM_CHECK(m.msg.event >= last_event, "event %u after %u",
+		          m.msg.event, last_event);
+		SIM_CHECK(last_data[m.msg.event] == 0xFFFFFFFF ||
+		          m.msg.data > last_data[m.msg.event],
+		          "event %u: %u after %u", m.msg.event, m.msg.data,
+		          last_data[m.msg.event]);
+		last_event = m.msg.event;
+		last_data[m.msg.event] = m.msg.data;
+	}
+	SIM_CHECK(q->recv(q, &m.msg, 0) != 0, "recv from an empty queue");
+
+	SIM_CHECK(prio_event_queue_get_stats(q, &g_stats) == 0, "stats");
+	SIM_CHECK(g_stats.push == SIM_QUEUE_LEN && g_stats.pop == SIM_QUEUE_LEN &&
+	          g_stats.overflow == 1 && g_stats.count == 0 &&
+	          g_stats.max_count == SIM_QUEUE_LEN,
+	          "stats push %u pop %u overflow %u count %u max %u", g_stats.push,
+	          g_stats.pop, g_stats.overflow, g_stats.count, g_stats.max_count);
+
+	/* the queue keeps working after wrapping the sequence of its heap */
+	for (i = 0; i < 3 * SIM_QUEUE_LEN; i++) {
+		SIM_CHECK(sim_send(q, 1, i, 0) == 0, "send %d", i);
+		SIM_CHECK(q->recv(q, &m.msg, 0) == 0 && m.msg.data == i, "recv %d", i);
+	}
+	q->deinit(q);
+}
+
+static void *queue_late_recv(void *arg)
+{
+	event_queue *q = arg;
+	sim_msg m;
+
+	OS_MSleep(20);
+	q->recv(q, &m.msg, OS_WAIT_FOREVER);
+	return NULL;
+}
+
+static void *queue_late_send(void *arg)
+{
+	OS_MSleep(20);
+	sim_send(arg, 2, 0, 0);
+	return NULL;
+}
+
+/* recv times out on an empty queue, both sides block until the other acts */
+static void queue_check_blocking(void)
+{
+	event_queue *q = prio_event_queue_create(2, sizeof(sim_msg));
+	pthread_t t;
+	uint32_t t0, dt;
+	sim_msg m;
+
+	t0 = OS_GetTicks();
+	SIM_CHECK(q->recv(q, &m.msg, 30) != 0, "recv from an empty queue");
+	dt = OS_GetTicks() - t0;
+	SIM_CHECK(dt >= 29 && dt < 200, "recv timeout after %u ms", dt);
+
+	pthread_create(&t, NULL, queue_late_send, q);
+	t0 = OS_GetTicks();
+	SIM_CHECK(q->recv(q, &m.msg, 1000) == 0 && m.msg.event == 2, "blocking recv");
+	dt = OS_GetTicks() - t0;
+	SIM_CHECK(dt >= 15 && dt < 500, "recv woken after %u ms", dt);
+	pthread_join(t, NULL);
+
+	sim_send(q, 0, 0, 0);
+	sim_send(q, 0, 1, 0);
+	pthread_create(&t, NULL, queue_late_recv, q);
+	t0 = OS_GetTicks();
+	SIM_CHECK(sim_send(q, 0, 2, 1000) == 0, "blocking send");
+	dt = OS_GetTicks() - t0;
+	SIM_CHECK(dt >= 15 && dt < 500, "send woken after %u ms", dt);
+	pthread_join(t, NULL);
+	SIM_CHECK(q->recv(q, &m.msg, 0) == 0 && m.msg.data == 1, "first left");
+	SIM_CHECK(q->recv(q, &m.msg, 0) == 0 && m.msg.data == 2, "second left");
+	q->deinit(q);
+}
+
+/* ------------------------------------------------------------------------ */
+/* producers and consumer                                                    */
+
+typedef struct sim_producer {
+	pthread_t t;
+	event_queue *q;
+	int id;
+	int events;
+	uint32_t fail;
+} sim_producer;
+
+static void *queue_producer(void *arg)
+{
+	sim_producer *p = arg;
+	uint32_t seed = p->id + 1;
+	int i;
+
+	for (i = 0; i < p->events; i++) {
+		if (sim_send(p->q, rnd(&seed, SIM_PRIOS), SIM_DATA(p->id, i), 1000) != 0)
+			p->fail++;
+		if (i % SIM_BURST == SIM_BURST - 1)
+			usleep(100 + rnd(&seed, 200));
+	}
+	return NULL;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void queue_bench(const char *name, event_queue *q, int events)
+{
+	static sim_producer prod[SIM_PRODUCERS];
+	uint32_t last[SIM_PRODUCERS][SIM_PRIOS];
+	uint32_t *lat = malloc(sizeof(uint32_t) * SIM_PRODUCERS * events);
+	uint32_t n = 0, fail = 0, order = 0, d, seq;
+	uint32_t t0 = sim_us(), total;
+	sim_msg m;
+	int i;
+
+	memset(last, 0xFF, sizeof(last));
+	for (i = 0; i < SIM_PRODUCERS; i++) {
+		prod[i].q = q;
+		prod[i].id = i;
+		prod[i].events = events;
+		prod[i].fail = 0;
+		pthread_create(&prod[i].t, NULL, queue_producer, &prod[i]);
+	}
+
+	while (n < SIM_PRODUCERS * events) {
+		if (q->recv(q, &m.msg, 1000) != 0)
+			break;
+		lat[n++] = sim_us() - m.msg.extra[0];
+		d = SIM_DATA_PRODUCER(m.msg.data);
+		seq = SIM_DATA_SEQ(m.msg.data);
+		if (d >= SIM_PRODUCERS || m.msg.event >= SIM_PRIOS) {
+			order++;
+			continue;
+		}
+		if (last[d][m.msg.event] != 0xFFFFFFFF && seq <= last[d][m.msg.event])
+			order++;
+		last[d][m.msg.event] = seq;
+	}
+	total = sim_us() - t0;
+
+	for (i = 0; i < SIM_PRODUCERS; i++) {
+		pthread_join(prod[i].t, NULL);
+		fail += prod[i].fail;
+	}
+	SIM_CHECK(n == SIM_PRODUCERS * events && fail == 0,
+	          "%s: %u of %u received, %u sends failed", name, n,
+	          SIM_PRODUCERS * events, fail);
+	SIM_CHECK(order == 0, "%s: %u events out of order", name, order);
+
+	qsort(lat, n, sizeof(lat[0]), cmp_u32);
+	printf("%-8s %8u %8u %8u %8u %10.2f\n", name, n,
+	       n ? lat[n / 2] : 0, n ? lat[n * 99 / 100] : 0, n ? lat[n - 1] : 0,
+	       n ? (double)total / n : 0);
+	free(lat);
+}
+
+int main(int argc, char *argv[])
+{
+	int events = (argc > 1) ? atoi(argv[1]) : SIM_EVENTS;
+	void *probe = malloc(16);
+	event_queue *q;
+
+	if (events <= 0 || events > 0xFFFFFF)
+		events = SIM_EVENTS;
+	if ((uintptr_t)probe > 0xFFFFFFFFU || (uintptr_t)&g_stats > 0xFFFFFFFFU) {
+		printf("FAIL heap or data above 4 GB, link with -no-pie\n");
+		return 1;
+	}
+	free(probe);
+
+	queue_check_order();
+	queue_check_blocking();
+
+	printf("%d producers x %d events, bursts of %d, %d entry queue\n",
+	       SIM_PRODUCERS, events, SIM_BURST, SIM_QUEUE_LEN);
+	printf("queue        recv   p50 us   p99 us   max us  us/event\n");
+	q = prio_event_queue_create(SIM_QUEUE_LEN, sizeof(sim_msg));
+	queue_bench("prio", q, events);
+	SIM_CHECK(prio_event_queue_get_stats(q, &g_stats) == 0 && g_stats.overflow == 0 &&
+	          g_stats.count == 0 && g_stats.max_count <= SIM_QUEUE_LEN,
+	          "stats overflow %u count %u max %u", g_stats.overflow, g_stats.count,
+	          g_stats.max_count);
+	q->deinit(q);
+	q = normal_event_queue_create(SIM_QUEUE_LEN, sizeof(sim_msg));
+	queue_bench("normal", q, events);
+	q->deinit(q);
+
+	if (sim_errors) {
+		printf("%d errors\n", sim_errors);
+		return 1;
+	}
+	return 0;
+}
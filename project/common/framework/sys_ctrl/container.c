@@ -45,197 +45,207 @@
 #define CONTAINER_NOTSUPPORT() 			CONTAINER_ALERT("not support command")
 
 
-typedef struct list_node
+/*
+ * Priority heap: a binary heap of items, the first one is the item which the
+ * compare() prefers over all others, items of equal priority keep the order
+ * of pushing. Push blocks on the free slots and pop blocks on the used slots,
+ * both are counting semaphores, so no polling is needed.
+ */
+typedef struct heap_node
 {
-	struct list_head node;
 	uint32_t arg;
-} list_node;
+	uint32_t seq;
+} heap_node;
 
-typedef struct sorted_list
+typedef struct prio_heap
 {
 	container_base base;
-	OS_Semaphore_t sem;
+	OS_Semaphore_t items;
+	OS_Semaphore_t slots;
 	OS_Mutex_t lock;
-	struct list_head head;
-	struct list_head pool;
-	list_node *poolBuf;
+	heap_node *nodes;
+	uint32_t count;
+	uint32_t seq;
+	container_stats stats;
 	int (*compare)(uint32_t newArg, uint32_t oldArg);
-} sorted_list;
+} prio_heap;
+
+/* return 1 if a should be popped before b */
+static __inline int prio_heap_before(prio_heap *impl, heap_node *a, heap_node *b)
+{
+	if (impl->compare(a->arg, b->arg) > 0)
+		return 1;
+	if (impl->compare(b->arg, a->arg) > 0)
+		return 0;
+	return (int32_t)(a->seq - b->seq) < 0;
+}
+
+static void prio_heap_sift_up(prio_heap *impl, uint32_t i)
+{
+	heap_node node = impl->nodes[i];
+	uint32_t parent;
+
+	while (i > 0) {
+		parent = (i - 1) / 2;
+		if (!prio_heap_before(impl, &node, &impl->nodes[parent]))
+			break;
+		impl->nodes[i] = impl->nodes[parent];
+		i = parent;
+	}
+	impl->nodes[i] = node;
+}
 
-typedef struct sorted_list_config
+static void prio_heap_sift_down(prio_heap *impl, uint32_t i)
 {
-	uint32_t size;
-	int (*compare)(uint32_t oldArg, uint32_t newArg);
-} sorted_list_config;
+	heap_node node = impl->nodes[i];
+	uint32_t child;
+
+	while ((child = 2 * i + 1) < impl->count) {
+		if (child + 1 < impl->count &&
+		    prio_heap_before(impl, &impl->nodes[child + 1], &impl->nodes[child]))
+			child++;
+		if (!prio_heap_before(impl, &impl->nodes[child], &node))
+			break;
+		impl->nodes[i] = impl->nodes[child];
+		i = child;
+	}
+	impl->nodes[i] = node;
+}
 
-static int sorted_list_init(struct container_base *base, uint32_t config)
+static int prio_heap_init(struct container_base *base, uint32_t size,
+                          int (*compare)(uint32_t newArg, uint32_t oldArg))
 {
-	OS_Status ret1 = OS_FAIL;
-	OS_Status ret2 = OS_FAIL;
-	list_node *vec = NULL;
-	sorted_list_config *cfg = (sorted_list_config *)config;
-	sorted_list *impl = __containerof(base, sorted_list, base);
-
-	INIT_LIST_HEAD(&impl->head);
-	INIT_LIST_HEAD(&impl->pool);
-	impl->base.size = cfg->size;
-	impl->compare = cfg->compare;
-
-	ret1 = OS_SemaphoreCreateBinary(&impl->sem);
-	if (ret1 != OS_OK)
+	prio_heap *impl = __containerof(base, prio_heap, base);
+
+	impl->base.size = size;
+	impl->compare = compare;
+
+	impl->nodes = malloc(sizeof(heap_node) * size);
+	if (impl->nodes == NULL)
 		goto failed;
 
-	ret2 = OS_MutexCreate(&impl->lock);
-	if (ret2 != OS_OK)
+	if (OS_SemaphoreCreate(&impl->items, 0, size) != OS_OK)
 		goto failed;
 
-	vec = malloc(sizeof(list_node) * impl->base.size);
-	if (vec == NULL)
+	if (OS_SemaphoreCreate(&impl->slots, size, size) != OS_OK)
 		goto failed;
-	memset(vec, 0, sizeof(list_node) * impl->base.size);
-	impl->poolBuf = vec;
 
-	for(int i = impl->base.size; i-- > 0; )
-	{
-		INIT_LIST_HEAD(&vec[i].node);
-		list_add_tail(&vec[i].node, &impl->pool);
-	}
+	if (OS_MutexCreate(&impl->lock) != OS_OK)
+		goto failed;
 
 	return 0;
 
 failed:
-	if (vec != NULL)
-		free(vec);
-	if (ret1 == OS_OK)
-		OS_SemaphoreDelete(&impl->sem);
-	if (ret2 == OS_OK)
-		OS_MutexDelete(&impl->lock);
-	if (impl != NULL)
-		free(impl);
+	if (OS_SemaphoreIsValid(&impl->items))
+		OS_SemaphoreDelete(&impl->items);
+	if (OS_SemaphoreIsValid(&impl->slots))
+		OS_SemaphoreDelete(&impl->slots);
+	if (impl->nodes != NULL)
+		free(impl->nodes);
 
 	return -1;
 }
 
-static int sorted_list_deinit(struct container_base *base)
+static int prio_heap_deinit(struct container_base *base)
 {
-	sorted_list *impl = __containerof(base, sorted_list, base);
+	prio_heap *impl = __containerof(base, prio_heap, base);
 
-	/* TODO: flush the node left */
+	if (impl->count != 0)
+		CONTAINER_ALERT("%u items left", impl->count);
 
-	OS_SemaphoreDelete(&impl->sem);
+	OS_SemaphoreDelete(&impl->items);
+	OS_SemaphoreDelete(&impl->slots);
 	OS_MutexDelete(&impl->lock);
-	if (impl->poolBuf != NULL)
-		free(impl->poolBuf);
-	if (impl != NULL)
-		free(impl);
+	free(impl->nodes);
+	free(impl);
 
 	return 0;
 }
 
-static int sorted_list_control(struct container_base *base, uint32_t cmd, uint32_t arg)
+static int prio_heap_control(struct container_base *base, uint32_t cmd, uint32_t arg)
 {
-	sorted_list *impl = __containerof(base, sorted_list, base);
-	/* TODO: tbc... */
-	(void)impl;
-	return -1;
-}
+	prio_heap *impl = __containerof(base, prio_heap, base);
 
-static int sorted_list_push(struct container_base *base, uint32_t arg, uint32_t timeout)
-{
-#define BLOCK_WAIT_EACHTIME (3)
-	sorted_list *impl = __containerof(base, sorted_list, base);
-	list_node *node = NULL;
-	list_node *tmp = NULL;
-
-	OS_MutexLock(&impl->lock, -1);	/* TODO: OS should move to event_queue */
-
-	/* 1. get 1 node from pool */
-	while ((node = list_first_entry_or_null(&impl->pool, list_node, node)) == NULL)
-	{
+	switch (cmd) {
+	case CONTAINER_CMD_GET_STATS:
+		OS_MutexLock(&impl->lock, OS_WAIT_FOREVER);
+		memcpy((container_stats *)arg, &impl->stats, sizeof(impl->stats));
+		((container_stats *)arg)->count = impl->count;
 		OS_MutexUnlock(&impl->lock);
-		OS_MSleep(BLOCK_WAIT_EACHTIME);
-		if (timeout <= BLOCK_WAIT_EACHTIME) {
-			CONTAINER_ALERT("list full and timeout");
-
-			return -1;
-		}
-		OS_MutexLock(&impl->lock, -1);
-		timeout -= BLOCK_WAIT_EACHTIME;
+		return 0;
+	case CONTAINER_CMD_RESET_STATS:
+		OS_MutexLock(&impl->lock, OS_WAIT_FOREVER);
+		memset(&impl->stats, 0, sizeof(impl->stats));
+		OS_MutexUnlock(&impl->lock);
+		return 0;
+	default:
+		CONTAINER_NOTSUPPORT();
+		return -1;
 	}
-	node->arg = arg;
+}
 
-	CONTAINER_DEBUG("get a node from pool");
+static int prio_heap_push(struct container_base *base, uint32_t arg, uint32_t timeout)
+{
+	prio_heap *impl = __containerof(base, prio_heap, base);
 
-	/* 2. find a proper place and insert it */
-	list_for_each_entry(tmp, &impl->head, node)
-	{
-		if (impl->compare(arg, tmp->arg) >= 0) {
-			tmp = list_prev_entry(tmp, node);
-			break;
-		}
+	/* 1. wait for a free slot */
+	if (OS_SemaphoreWait(&impl->slots, timeout) != OS_OK) {
+		OS_MutexLock(&impl->lock, OS_WAIT_FOREVER);
+		impl->stats.overflow++;
+		OS_MutexUnlock(&impl->lock);
+		CONTAINER_DEBUG("heap full and timeout");
+		return -1;
 	}
-	list_add(&node->node, &tmp->node);
-
-	CONTAINER_DEBUG("insert node to list");
-
-	/* 3. release sem to pop */
-	OS_SemaphoreRelease(&impl->sem);
 
+	/* 2. add it at the end and move it up to its place */
+	OS_MutexLock(&impl->lock, OS_WAIT_FOREVER);
+	impl->nodes[impl->count].arg = arg;
+	impl->nodes[impl->count].seq = impl->seq++;
+	prio_heap_sift_up(impl, impl->count++);
+	impl->stats.push++;
+	if (impl->count > impl->stats.max_count)
+		impl->stats.max_count = impl->count;
 	OS_MutexUnlock(&impl->lock);
+
+	/* 3. wake up pop */
+	OS_SemaphoreRelease(&impl->items);
 	return 0;
 }
 
-static int sorted_list_pop(struct container_base *base, uint32_t *arg, uint32_t timeout)
+static int prio_heap_pop(struct container_base *base, uint32_t *arg, uint32_t timeout)
 {
-	sorted_list *impl = __containerof(base, sorted_list, base);
-	list_node *node = NULL;
-	OS_Status ret;
+	prio_heap *impl = __containerof(base, prio_heap, base);
 
-	ret = OS_SemaphoreWait(&impl->sem, timeout);
-	if (ret != OS_OK)
+	if (OS_SemaphoreWait(&impl->items, timeout) != OS_OK)
 		return -1;
 
-	OS_MutexLock(&impl->lock, -1);
-
-	/* 1. get node from list */
-	node = list_first_entry_or_null(&impl->head, list_node, node);
-	if (node == NULL)
-	{
-		CONTAINER_ERROR("list empty but sem released!");
-		OS_MutexUnlock(&impl->lock);
-		return -2;
+	/* take the first one, move the last one down from the top */
+	OS_MutexLock(&impl->lock, OS_WAIT_FOREVER);
+	*arg = impl->nodes[0].arg;
+	if (--impl->count > 0) {
+		impl->nodes[0] = impl->nodes[impl->count];
+		prio_heap_sift_down(impl, 0);
 	}
-	*arg = node->arg;
-
-	CONTAINER_DEBUG("get a node from list");
-
-	/* 2. remove the node from this and push it to pool */
-	list_del(&node->node);
-	list_add_tail(&node->node, &impl->head);
-
-	CONTAINER_DEBUG("remove a node from list and push it to pool");
-
+	impl->stats.pop++;
 	OS_MutexUnlock(&impl->lock);
+
+	OS_SemaphoreRelease(&impl->slots);
 	return 0;
 }
 
-container_base *sorted_list_create(uint32_t size, int (*compare)(uint32_t newArg, uint32_t oldArg))
+container_base *prio_heap_create(uint32_t size, int (*compare)(uint32_t newArg, uint32_t oldArg))
 {
-	sorted_list *impl = malloc(sizeof(*impl));
+	prio_heap *impl = malloc(sizeof(*impl));
 	if (impl == NULL)
 		return NULL;
 	memset(impl, 0, sizeof(*impl));
 
-	sorted_list_config cfg;
-	cfg.compare = compare;
-	cfg.size = size;
-
-	impl->base.control = sorted_list_control;
-	impl->base.deinit = sorted_list_deinit;
-	impl->base.pop = sorted_list_pop;
-	impl->base.push = sorted_list_push;
+	impl->base.control = prio_heap_control;
+	impl->base.deinit = prio_heap_deinit;
+	impl->base.pop = prio_heap_pop;
+	impl->base.push = prio_heap_push;
 
-	if (sorted_list_init(&impl->base, (uint32_t)&cfg) != 0)
+	if (prio_heap_init(&impl->base, size, compare) != 0)
 	{
 		CONTAINER_ERROR("init failed");
 		free(impl);
@@ -31,6 +31,19 @@
 #ifndef CONTAINER_H_
 #define CONTAINER_H_
 
+/* control commands */
+#define CONTAINER_CMD_GET_STATS		(1)	/* arg: container_stats * */
+#define CONTAINER_CMD_RESET_STATS	(2)
+
+typedef struct container_stats
+{
+	uint32_t push;
+	uint32_t pop;
+	uint32_t overflow;	/* push failed for container full */
+	uint32_t count;		/* items in container now */
+	uint32_t max_count;
+} container_stats;
+
 typedef struct container_base
 {
 	uint32_t size;
@@ -42,6 +55,7 @@ typedef struct container_base
 	int (*pop)(struct container_base *base, uint32_t *item, uint32_t timeout);
 } container_base;
 
-container_base *sorted_list_create(uint32_t size, int (*compare)(uint32_t newArg, uint32_t oldArg));
+/* compare() returns > 0 if newArg goes before oldArg */
+container_base *prio_heap_create(uint32_t size, int (*compare)(uint32_t newArg, uint32_t oldArg));
 
 #endif /* CONTAINER_H_ */
@@ -35,6 +35,7 @@
 #include "sys/list.h"
 #include "sys/param.h"
 #include "sys/defs.h"
+#include "sys/interrupt.h"
 #include "container.h"
 #include "event_queue.h"
 
@@ -51,6 +52,9 @@ typedef struct prio_event_queue
 	event_queue base;
 	container_base *container;
 	uint32_t msg_size;
+	OS_Queue_t pool;	/* free messages of poolBuf */
+	uint8_t *poolBuf;
+	uint32_t overflow;
 } prio_event_queue;
 
 static int complare_event_msg(uint32_t newArg, uint32_t oldArg)
@@ -66,8 +70,11 @@ static int prio_event_queue_deinit(struct event_queue *base)
 	prio_event_queue *impl = __containerof(base, prio_event_queue, base);
 
 	int ret = impl->container->deinit(impl->container);
-	if (ret == 0)
+	if (ret == 0) {
+		OS_QueueDelete(&impl->pool);
+		free(impl->poolBuf);
 		free(impl);
+	}
 
 	return ret;
 }
@@ -76,20 +83,25 @@ __nonxip_text
 static int prio_event_send(struct event_queue *base, struct event_msg *msg, uint32_t wait_ms)
 {
 	prio_event_queue *impl = __containerof(base, prio_event_queue, base);
+	struct event_msg *newMsg;
 
 //	EVTMSG_DEBUG("send event: 0x%x", msg->event);
 
-	/* TODO: cache some to faster create msg and less fragmented memory */
-	struct event_msg *newMsg = malloc(impl->msg_size);
-	if (newMsg == NULL)
-		return -1;
+	/* a free message means a free slot in container, so push never waits */
+	if (OS_QueueReceive(&impl->pool, &newMsg, wait_ms) != OS_OK) {
+		arch_irq_disable();
+		impl->overflow++;
+		arch_irq_enable();
+//		EVTMSG_ALERT("send event timeout");
+		return -2;
+	}
 	memcpy(newMsg, msg, impl->msg_size);
 
-	int ret = impl->container->push(impl->container, (uint32_t)newMsg, wait_ms);
+	int ret = impl->container->push(impl->container, (uint32_t)newMsg, 0);
 	if (ret != 0)
 	{
-		free(newMsg);
-//		EVTMSG_ALERT("send event timeout");
+		OS_QueueSend(&impl->pool, &newMsg, 0);
+		EVTMSG_ERROR("push failed");
 		return -2;
 	}
 
@@ -99,14 +111,14 @@ static int prio_event_send(struct event_queue *base, struct event_msg *msg, uint
 static int prio_event_recv(struct event_queue *base, struct event_msg *msg, uint32_t wait_ms)
 {
 	prio_event_queue *impl = __containerof(base, prio_event_queue, base);
-	event_msg *newMsg;
+	event_msg *newMsg = NULL;
 
 	int ret = impl->container->pop(impl->container, (uint32_t *)&newMsg, wait_ms);
 	if (ret != 0)
 		return -2;
 
 	memcpy(msg, newMsg, impl->msg_size);
-	free(newMsg);
+	OS_QueueSend(&impl->pool, &newMsg, 0);
 
 	EVTMSG_DEBUG("recv event: 0x%x", msg->event);
 
@@ -115,27 +127,57 @@ static int prio_event_recv(struct event_queue *base, struct event_msg *msg, uint
 
 struct event_queue *prio_event_queue_create(uint32_t queue_len, uint32_t msg_size)
 {
+	uint8_t *msg;
+	uint32_t i;
+
 	prio_event_queue *impl = malloc(sizeof(*impl));
 	if (impl == NULL)
 		return NULL;
 	memset(impl, 0, sizeof(*impl));
 
-	impl->container = sorted_list_create(queue_len, complare_event_msg);
+	/* keep messages 4 bytes aligned in pool */
+	impl->msg_size = msg_size;
+	msg_size = (msg_size + 3) & ~3U;
+	impl->poolBuf = malloc(msg_size * queue_len);
+	if (impl->poolBuf == NULL)
+		goto out;
+	if (OS_QueueCreate(&impl->pool, queue_len, sizeof(void *)) != OS_OK)
+		goto out;
+	for (i = 0; i < queue_len; i++) {
+		msg = impl->poolBuf + i * msg_size;
+		OS_QueueSend(&impl->pool, &msg, 0);
+	}
+
+	impl->container = prio_heap_create(queue_len, complare_event_msg);
 	if (impl->container == NULL)
 		goto out;
 	impl->base.send = prio_event_send;
 	impl->base.recv = prio_event_recv;
 	impl->base.deinit = prio_event_queue_deinit;
-	impl->msg_size = msg_size;
 
 	return &impl->base;
 
 out:
-	EVTMSG_ERROR("sorted_list_create failed");
+	EVTMSG_ERROR("prio_event_queue_create failed");
+	if (OS_QueueIsValid(&impl->pool))
+		OS_QueueDelete(&impl->pool);
+	if (impl->poolBuf != NULL)
+		free(impl->poolBuf);
 	free(impl);
 	return NULL;
 }
 
+int prio_event_queue_get_stats(struct event_queue *base, struct container_stats *stats)
+{
+	prio_event_queue *impl = __containerof(base, prio_event_queue, base);
+
+	if (impl->container->control(impl->container, CONTAINER_CMD_GET_STATS,
+	                             (uint32_t)stats) != 0)
+		return -1;
+	stats->overflow += impl->overflow;
+	return 0;
+}
+
 
 typedef struct normal_event_queue
 {
@@ -53,6 +53,10 @@ typedef struct event_queue
 
 struct event_queue *prio_event_queue_create(uint32_t queue_len, uint32_t msg_size);
 
+struct container_stats;
+/* Get push/pop counts, depth and overflow (send timeout) of prio queue */
+int prio_event_queue_get_stats(struct event_queue *base, struct container_stats *stats);
+
 struct event_queue *normal_event_queue_create(uint32_t queue_len, uint32_t msg_size);
 
 #endif /* EVENT_QUEUE_H_ */
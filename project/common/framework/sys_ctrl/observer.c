@@ -32,6 +32,8 @@
 #include <stdio.h>
 #include <string.h>
 #include "sys/list.h"
+#include "sys/param.h"
+#include "sys/interrupt.h"
 #include "kernel/os/os.h"
 #include "observer.h"
 
@@ -63,6 +65,8 @@ int observer_init(observer_base *base, uint32_t event,
     obs->event = event;
     obs->trigger = trigger;
     obs->arg = arg;
+    obs->async = 0;
+    memset(&obs->stats, 0, sizeof(obs->stats));
     INIT_LIST_HEAD(&obs->node);
 
     return 0;
@@ -153,38 +157,200 @@ observer_base *callback_observer_create(uint32_t event, void (*cb)(uint32_t even
 
 
 /*
- * thread observer
- * observe a event to run a thread.
+ * observer worker pool
+ * run thread observers on a few fixed threads, each observer owns a bounded
+ * queue and is serviced by at most one worker at a time to keep its order.
+ * The shared pool serves all thread observers, unless one is given a pool
+ * of its own by thread_observer_set_dedicated().
  */
-static void wrap_thread(void *arg)
+#define OBSERVER_WORKER_NUM         (2)
+#define OBSERVER_WORKER_PRIO        OS_PRIORITY_NORMAL
+#ifndef OBSERVER_WORKER_STACK
+#define OBSERVER_WORKER_STACK       (2 * 1024)  /* larger run() get a worker of their own */
+#endif
+#define OBSERVER_QUEUE_DEPTH        (4)
+#define OBSERVER_WORKER_MAX         (4)
+
+typedef enum observer_pool_state
 {
-    thread_observer *impl = (thread_observer *)arg;
+    OBSERVER_POOL_NONE,
+    OBSERVER_POOL_INITIALIZING,
+    OBSERVER_POOL_READY,
+    OBSERVER_POOL_STOPPING,
+} observer_pool_state;
 
-    impl->run(impl->event, impl->arg, impl->base.arg);
+typedef struct observer_worker_pool
+{
+    int state;
+    uint32_t num;
+    uint32_t stack;
+    OS_Mutex_t lock;
+    OS_Semaphore_t ready_sem;   /* count of observers in ready list */
+    struct list_head ready;
+    OS_Thread_t thd[OBSERVER_WORKER_MAX];
+} observer_worker_pool;
+
+static observer_worker_pool g_observer_pool;
+
+static void observer_worker(void *arg)
+{
+    observer_worker_pool *pool = (observer_worker_pool *)arg;
+    thread_observer *impl;
+    thread_observer_msg msg;
+    uint32_t t0, t1;
 
-    OS_ThreadDelete(&impl->thd);
+    while (1)
+    {
+        if (OS_SemaphoreWait(&pool->ready_sem, OS_WAIT_FOREVER) != OS_OK)
+            continue;
+
+        OS_MutexLock(&pool->lock, OS_WAIT_FOREVER);
+        if (pool->state == OBSERVER_POOL_STOPPING)
+        {
+            OS_MutexUnlock(&pool->lock);
+            break;
+        }
+        impl = list_first_entry(&pool->ready, thread_observer, ready);
+        list_del_init(&impl->ready);
+        msg = impl->msg[impl->head];
+        impl->head = (impl->head + 1) % impl->depth;
+        impl->count--;
+        OS_MutexUnlock(&pool->lock);
+
+        t0 = OS_TicksToMSecs(OS_GetTicks());
+        impl->run(msg.event, msg.arg, impl->base.arg);
+        t1 = OS_TicksToMSecs(OS_GetTicks());
+        observer_stats_update(&impl->base, t0 - msg.stamp, t1 - t0);
+
+        /* requeue at the tail, so a busy observer can't starve the others */
+        OS_MutexLock(&pool->lock, OS_WAIT_FOREVER);
+        if (impl->count > 0)
+        {
+            list_add_tail(&impl->ready, &pool->ready);
+            OS_SemaphoreRelease(&pool->ready_sem);
+        }
+        else
+        {
+            impl->busy = 0;
+        }
+        OS_MutexUnlock(&pool->lock);
+    }
+
+    /* only a pool of one worker is stopped, see observer_worker_pool_stop() */
+    OS_ThreadDelete(&pool->thd[0]);
 }
 
+static void observer_worker_pool_deinit(observer_worker_pool *pool)
+{
+    if (OS_SemaphoreIsValid(&pool->ready_sem))
+        OS_SemaphoreDelete(&pool->ready_sem);
+    if (OS_MutexIsValid(&pool->lock))
+        OS_MutexDelete(&pool->lock);
+    pool->state = OBSERVER_POOL_NONE;
+}
+
+static int observer_worker_pool_start(observer_worker_pool *pool, uint32_t num,
+                                      OS_Priority prio, uint32_t stack)
+{
+    uint32_t i = 0;
+
+    INIT_LIST_HEAD(&pool->ready);
+    pool->num = num;
+    pool->stack = stack;
+    if (OS_MutexCreate(&pool->lock) != OS_OK)
+        goto failed;
+    if (OS_SemaphoreCreate(&pool->ready_sem, 0, OS_SEMAPHORE_MAX_COUNT) != OS_OK)
+        goto failed;
+
+    for (i = 0; i < num; i++)
+    {
+        if (OS_ThreadCreate(&pool->thd[i], "Observer", observer_worker, pool, prio, stack) != OS_OK)
+        {
+            OBSERVER_ERROR("thread create error, maybe no RAM to create");
+            goto failed;
+        }
+    }
+
+    pool->state = OBSERVER_POOL_READY;
+    return 0;
+
+failed:
+    while (i-- > 0)
+        OS_ThreadDelete(&pool->thd[i]);
+    observer_worker_pool_deinit(pool);
+    return -1;
+}
+
+/* stop the worker of a dedicated pool, no observer may be queued */
+static void observer_worker_pool_stop(observer_worker_pool *pool)
+{
+    OS_MutexLock(&pool->lock, OS_WAIT_FOREVER);
+    pool->state = OBSERVER_POOL_STOPPING;
+    OS_MutexUnlock(&pool->lock);
+    OS_SemaphoreRelease(&pool->ready_sem);
+    while (OS_ThreadIsValid(&pool->thd[0]))
+        OS_MSleep(1);
+    observer_worker_pool_deinit(pool);
+}
+
+int observer_worker_pool_init(uint32_t num, OS_Priority prio, uint32_t stack)
+{
+    observer_worker_pool *pool = &g_observer_pool;
+
+    if (num == 0 || num > OBSERVER_WORKER_MAX)
+        return -1;
+
+    arch_irq_disable();
+    if (pool->state != OBSERVER_POOL_NONE)
+    {
+        arch_irq_enable();
+        while (pool->state == OBSERVER_POOL_INITIALIZING)
+            OS_MSleep(1);
+        return pool->state == OBSERVER_POOL_READY ? 0 : -1;
+    }
+    pool->state = OBSERVER_POOL_INITIALIZING;
+    arch_irq_enable();
+
+    return observer_worker_pool_start(pool, num, prio, stack);
+}
+
+
+/*
+ * thread observer
+ * observe a event to run on the observer worker pool.
+ */
 static void trigger_thread(struct observer_base *base, uint32_t event, uint32_t arg)
 {
     thread_observer *impl = __containerof(base, thread_observer, base);
-    OS_Status ret;
-
-    impl->event = event;
-    impl->arg = arg;
+    observer_worker_pool *pool = impl->pool;
+    thread_observer_msg *msg;
 
-    if (OS_ThreadIsValid(&impl->thd))
+    /* called under the publisher lock, a full queue drops instead of waiting */
+    OS_MutexLock(&pool->lock, OS_WAIT_FOREVER);
+    if (impl->count == impl->depth)
     {
-        OBSERVER_ALERT("thread still running or not init");
+        OS_MutexUnlock(&pool->lock);
+        arch_irq_disable();
+        impl->base.stats.drop++;
+        arch_irq_enable();
+        OBSERVER_DEBUG("obs: %p queue full, event 0x%x dropped", base, event);
+        if (impl->exception != NULL)
+            impl->exception(OS_E_NOMEM);
         return;
     }
 
-    if ((ret = OS_ThreadCreate(&impl->thd, "Trigger", wrap_thread, impl, impl->prio, impl->stack)) != OS_OK)
+    msg = &impl->msg[(impl->head + impl->count) % impl->depth];
+    msg->event = event;
+    msg->arg = arg;
+    msg->stamp = OS_TicksToMSecs(OS_GetTicks());
+    impl->count++;
+    if (!impl->busy)
     {
-        OBSERVER_ERROR("thread create error, maybe no RAM to create");
-        if (impl->exception != NULL)
-            impl->exception(ret);
+        impl->busy = 1;
+        list_add_tail(&impl->ready, &pool->ready);
+        OS_SemaphoreRelease(&pool->ready_sem);
     }
+    OS_MutexUnlock(&pool->lock);
 }
 
 void thread_observer_throw(struct observer_base *base, void (*exception)(int ret))
@@ -194,20 +360,92 @@ void thread_observer_throw(struct observer_base *base, void (*exception)(int ret
     impl->exception = exception;
 }
 
+static void thread_observer_release(thread_observer *obs)
+{
+    if (obs->msg != NULL)
+    {
+        free(obs->msg);
+        obs->msg = NULL;
+    }
+    if (obs->pool != NULL && obs->pool != &g_observer_pool)
+    {
+        observer_worker_pool_stop(obs->pool);
+        free(obs->pool);
+    }
+    obs->pool = NULL;
+}
+
+int thread_observer_set_queue(struct observer_base *base, uint16_t depth)
+{
+    thread_observer *impl = __containerof(base, thread_observer, base);
+    thread_observer_msg *msg;
+
+    if (depth == 0 || base->state != OBSERVER_ILDE || impl->busy)
+        return -1;
+
+    msg = malloc(sizeof(*msg) * depth);
+    if (msg == NULL)
+        return -1;
+
+    free(impl->msg);
+    impl->msg = msg;
+    impl->depth = depth;
+    impl->head = 0;
+    impl->count = 0;
+
+    return 0;
+}
+
+int thread_observer_set_dedicated(struct observer_base *base, OS_Priority prio, uint32_t stackSize)
+{
+    thread_observer *impl = __containerof(base, thread_observer, base);
+    observer_worker_pool *pool;
+
+    if (base->state != OBSERVER_ILDE || impl->busy || impl->pool != &g_observer_pool)
+        return -1;
+
+    pool = malloc(sizeof(*pool));
+    if (pool == NULL)
+        return -1;
+    memset(pool, 0, sizeof(*pool));
+
+    if (observer_worker_pool_start(pool, 1, prio, stackSize) != 0)
+    {
+        free(pool);
+        return -1;
+    }
+
+    impl->pool = pool;
+    impl->stack = stackSize;
+    impl->prio = prio;
+    return 0;
+}
+
 int thread_observer_init(observer_base *base, uint32_t event, void (*run)(uint32_t event, uint32_t data, void *arg),
                                       void *arg, uint32_t stackSize, OS_Priority prio)
 {
 	thread_observer *obs = __containerof(base, thread_observer, base);
 
-    /* TODO: need mode in case of trigger serval times */
-    obs->base.event = event;
+    if (g_observer_pool.state != OBSERVER_POOL_READY
+        && observer_worker_pool_init(OBSERVER_WORKER_NUM, OBSERVER_WORKER_PRIO,
+                                     OBSERVER_WORKER_STACK) != 0)
+        return -1;
+
+    observer_init(&obs->base, event, trigger_thread, arg);
 //  obs->base.type = THREAD_OBSERVER;
-    obs->base.trigger = trigger_thread;
-    INIT_LIST_HEAD(&obs->base.node);
+    obs->base.async = 1;
+    INIT_LIST_HEAD(&obs->ready);
     obs->run = run;
     obs->stack = stackSize;
     obs->prio = prio;
-    obs->base.arg = arg;
+    obs->pool = &g_observer_pool;
+
+    if (thread_observer_set_queue(&obs->base, OBSERVER_QUEUE_DEPTH) != 0)
+        return -1;
+
+    /* the shared workers' stack is fixed, a larger run() gets its own worker */
+    if (stackSize > g_observer_pool.stack)
+        return thread_observer_set_dedicated(&obs->base, prio, stackSize);
 
     return 0;
 }
@@ -222,18 +460,76 @@ observer_base *thread_observer_create(uint32_t event, void (*run)(uint32_t event
         return NULL;
     memset(obs, 0, sizeof(*obs));
 
-    thread_observer_init(&obs->base, event, run, arg, stackSize, prio);
+    if (thread_observer_init(&obs->base, event, run, arg, stackSize, prio) != 0)
+    {
+        thread_observer_release(obs);
+        free(obs);
+        return NULL;
+    }
 
     return &obs->base;
 }
 
+
+/*
+ * observer statistics
+ * updated by the publisher and by the workers, a critical section keeps
+ * every snapshot consistent.
+ */
+void observer_stats_update(observer_base *base, uint32_t lat, uint32_t run)
+{
+    observer_stats *stats = &base->stats;
+
+    arch_irq_disable();
+    stats->count++;
+    stats->lat_sum += lat;
+    if (lat > stats->lat_max)
+        stats->lat_max = lat;
+    stats->run_sum += run;
+    if (run > stats->run_max)
+        stats->run_max = run;
+    arch_irq_enable();
+}
+
+void observer_get_stats(observer_base *base, observer_stats *stats)
+{
+    arch_irq_disable();
+    *stats = base->stats;
+    arch_irq_enable();
+}
+
+void observer_reset_stats(observer_base *base)
+{
+    arch_irq_disable();
+    memset(&base->stats, 0, sizeof(base->stats));
+    arch_irq_enable();
+}
+
 int observer_destroy(observer_base *base)
 {
     if (base == NULL)
         return -1;
     if (base->state != OBSERVER_ILDE)
         return -1;
+    if (base->trigger == trigger_thread)
+    {
+        thread_observer *impl = __containerof(base, thread_observer, base);
+
+        /*
+         * the worker clears busy under the pool lock when it is done, an
+         * empty queue makes a late trigger drop instead of queueing it again
+         */
+        OS_MutexLock(&impl->pool->lock, OS_WAIT_FOREVER);
+        if (impl->busy)
+        {
+            OS_MutexUnlock(&impl->pool->lock);
+            return -1;
+        }
+        impl->depth = 0;
+        impl->count = 0;
+        OS_MutexUnlock(&impl->pool->lock);
+        thread_observer_release(impl);
+    }
     free(base);
     return 0;
 }
-
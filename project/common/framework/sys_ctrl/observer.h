@@ -58,6 +58,16 @@ typedef enum observer_state
 	OBSERVER_WORKING,
 } observer_state;
 
+typedef struct observer_stats
+{
+	uint32_t count;		/* callbacks finished */
+	uint32_t drop;		/* triggers dropped because the observer queue stayed full */
+	uint32_t lat_max;	/* ms from dispatch to callback start */
+	uint32_t lat_sum;
+	uint32_t run_max;	/* ms spent in the callback */
+	uint32_t run_sum;
+} observer_stats;
+
 typedef struct observer_base
 {
 	struct list_head node;
@@ -65,6 +75,8 @@ typedef struct observer_base
 	int state;
 	void *arg;
 	void (*trigger)(struct observer_base *base, uint32_t event, uint32_t arg);
+	int async;		/* callback runs on the worker pool, which records the stats */
+	observer_stats stats;
 } observer_base;
 
 /*
@@ -110,17 +122,28 @@ typedef struct callback_observer
 } callback_observer;
 
 /* thread observer */
+typedef struct thread_observer_msg
+{
+    uint32_t event;
+    uint32_t arg;
+    uint32_t stamp;
+} thread_observer_msg;
+
 typedef struct thread_observer
 {
     observer_base base;
-    OS_Thread_t thd;
     void (*run)(uint32_t event, uint32_t data, void *arg);
     void (*exception)(int ret);
     uint32_t stack;
     OS_Priority prio;
 
-    uint32_t event;
-    uint32_t arg;
+    struct observer_worker_pool *pool;  /* shared pool or a dedicated one */
+    struct list_head ready;     /* node in the worker pool ready list */
+    thread_observer_msg *msg;
+    uint16_t depth;
+    uint16_t head;
+    uint16_t count;
+    uint16_t busy;              /* queued in the ready list or running on a worker */
 } thread_observer;
 
 
@@ -137,7 +160,13 @@ observer_base *callback_observer_create(uint32_t event,
 										void (*cb)(uint32_t event, uint32_t data, void *arg),
 										void *arg);
 
-/* thread observer : a event observed will create a thread to run, exception will throw if create failed  */
+/* thread observer : a event observed will queue run() to the observer worker pool,
+ *                   the event is dropped and exception(OS_E_NOMEM) thrown if the observer
+ *                   queue is full, the publisher never waits for it.
+ *                   run() executes on a thread of the shared pool, which has a fixed stack
+ *                   (OBSERVER_WORKER_STACK) and priority. prio is ignored for an observer on
+ *                   the shared pool, it only applies to a dedicated one. An observer whose
+ *                   stackSize is larger than the pool stack is made dedicated, with prio. */
 observer_base *thread_observer_create(uint32_t event,
 									  void (*run)(uint32_t event, uint32_t data, void *arg),
 									  void *arg,
@@ -146,6 +175,24 @@ observer_base *thread_observer_create(uint32_t event,
 
 void thread_observer_throw(struct observer_base *base, void (*exception)(int ret));
 
+/* set queue depth, call before attach */
+int thread_observer_set_queue(struct observer_base *base, uint16_t depth);
+
+/* run the observer on a worker thread of its own instead of the shared pool, so a slow
+   or blocking run() can't delay other observers. the worker has the given prio and
+   stackSize. call before attach, the thread is deleted by observer_destroy(). */
+int thread_observer_set_dedicated(struct observer_base *base, OS_Priority prio, uint32_t stackSize);
+
+/* create the worker pool running thread observers, otherwise it's created with the
+   default parameters by the first thread observer. */
+int observer_worker_pool_init(uint32_t num, OS_Priority prio, uint32_t stack);
+
+void observer_stats_update(observer_base *base, uint32_t lat, uint32_t run);
+
+void observer_get_stats(observer_base *base, observer_stats *stats);
+
+void observer_reset_stats(observer_base *base);
+
 int observer_destroy(observer_base *base);
 
 #endif /* OBSERVER_H_ */
@@ -55,6 +55,14 @@ static void atomic_set(int *var, uint32_t cnt)
 	arch_irq_enable();
 }
 
+static struct list_head *publisher_bucket(struct publisher_base *base, uint32_t event)
+{
+	if (base->index == NULL)
+		return base->bucket;
+
+	return &base->bucket[((base->index(event) * 0x9E3779B1U) >> 16) & base->bucket_mask];
+}
+
 static int __attach(struct publisher_base *base, observer_base *obs, int once)
 {
 	int ret = 0;
@@ -72,7 +80,7 @@ static int __attach(struct publisher_base *base, observer_base *obs, int once)
 	else if (list_empty(&obs->node))
 	{
 		arch_irq_disable();
-		list_add_tail(&obs->node, &base->head);
+		list_add_tail(&obs->node, publisher_bucket(base, obs->event));
 		obs->state = attach_state;
 		arch_irq_enable();
 	}
@@ -109,6 +117,7 @@ static int detach(struct publisher_base *base, observer_base *obs)
 	else
 	{
 		atomic_set(&obs->state, OBSERVER_DETACHED);
+		base->detached++;
 	}
 	OS_RecursiveMutexUnlock(&base->lock);
 	/* TODO: exit critical section */
@@ -120,9 +129,10 @@ static int detach(struct publisher_base *base, observer_base *obs)
 
 static int notify(struct publisher_base *base, uint32_t event, uint32_t arg)
 {
-	observer_base *obs = NULL;
 	observer_base *itor = NULL;
 	observer_base *safe = NULL;
+	uint32_t t0, t1, t2;
+	uint32_t i;
 	int cnt = 0;
 
 	/* TODO: define some event to debug, for example, event -1 can be detect how many observer now. */
@@ -130,46 +140,57 @@ static int notify(struct publisher_base *base, uint32_t event, uint32_t arg)
 	OS_RecursiveMutexLock(&base->lock, -1);
 	atomic_set(&base->state, PUBLISHER_WORKING);
 
-	/* trigger observers */
-	list_for_each_entry(itor, &base->head, node)
+	/* trigger observers, only the bucket of this event can match */
+	t0 = OS_TicksToMSecs(OS_GetTicks());
+	list_for_each_entry(itor, publisher_bucket(base, event), node)
 	{
 		/* TODO: detect the observer if is locked by detach or sth else */
 		if (base->compare(event, itor->event) == 0
 			&& (itor->state == OBSERVER_ATTACHED || itor->state == OBSERVER_ATTACHED_ONCE))
 		{
-			obs = itor;
-			uint32_t t0 = OS_TicksToMSecs(OS_GetTicks());
-			obs->trigger(obs, event, arg);
-			uint32_t t1 = OS_TicksToMSecs(OS_GetTicks());
+			t1 = OS_TicksToMSecs(OS_GetTicks());
+			itor->trigger(itor, event, arg);
+			t2 = OS_TicksToMSecs(OS_GetTicks());
+
+			/* async observer is accounted by the worker which runs it */
+			if (!itor->async)
+				observer_stats_update(itor, t1 - t0, t2 - t1);
 
 			if (itor->state == OBSERVER_ATTACHED_ONCE)
-				obs->state = OBSERVER_DETACHED;
+			{
+				itor->state = OBSERVER_DETACHED;
+				base->detached++;
+			}
 
 #define OBSERVER_TRIGGER_OVERTIME 1000
-			if ((t1 - t0 > OBSERVER_TRIGGER_OVERTIME) && (OS_TimeAfter(t1, t0)))
-				PUBLISHER_ALERT("obs: %p callback run %d ms", obs, t1 - t0);
+			if ((t2 - t1 > OBSERVER_TRIGGER_OVERTIME) && (OS_TimeAfter(t2, t1)))
+				PUBLISHER_ALERT("obs: %p callback run %d ms", itor, t2 - t1);
 			cnt++;
 		}
 	}
 
 	/* remove observers detached in trigger function */
-	list_for_each_entry_safe(itor, safe, &base->head, node)
+	if (base->detached)
 	{
-		if (itor->state == OBSERVER_DETACHED)
+		for (i = 0; i <= base->bucket_mask; i++)
 		{
-			list_del(&itor->node);
-			atomic_set(&itor->state, OBSERVER_ILDE);
+			list_for_each_entry_safe(itor, safe, &base->bucket[i], node)
+			{
+				if (itor->state == OBSERVER_DETACHED)
+				{
+					list_del(&itor->node);
+					atomic_set(&itor->state, OBSERVER_ILDE);
+				}
+			}
 		}
+		base->detached = 0;
 	}
 
 	atomic_set(&base->state, PUBLISHER_IDLE);
 	OS_RecursiveMutexUnlock(&base->lock);
 
-	if (obs == NULL)
-	{
+	if (cnt == 0)
 		PUBLISHER_DEBUG("no observer eyes on this event");
-		return 0;
-	}
 
 	return cnt;
 }
@@ -227,6 +248,7 @@ publisher_base *publisher_create(struct event_queue *queue, int (*compare)(uint3
 		goto failed;
 
 	INIT_LIST_HEAD(&base->head);
+	base->bucket = &base->head;
 //	base->queue = queue;
 	base->touch = attach_once;
 	base->attach = attach;
@@ -281,16 +303,46 @@ static struct publisher_factory *set_msg_size(struct publisher_factory *ctor, ui
 	return ctor;
 }
 
+static struct publisher_factory *set_index(struct publisher_factory *ctor, uint32_t (*index)(uint32_t event), uint32_t bucket_num)
+{
+	if (bucket_num == 0 || (bucket_num & (bucket_num - 1)) || bucket_num > 0x10000)
+	{
+		PUBLISHER_ALERT("bucket num %u is not power of 2, ignore index", bucket_num);
+		return ctor;
+	}
+
+	ctor->publisher->index = index;
+	ctor->bucket_num = bucket_num;
+	return ctor;
+}
+
 static struct publisher_base *create_publisher(struct publisher_factory *ctor)
 {
 	publisher_base *publisher = ctor->publisher;
 	OS_Priority prio = ctor->prio;
 	uint32_t stack = ctor->stack;
 	uint32_t size = ctor->size;
+	uint32_t bucket_num = ctor->bucket_num;
 	struct event_queue *queue= ctor->queue;
+	uint32_t i;
 
 	free(ctor);
 
+	if (publisher->index == NULL || bucket_num == 1)
+	{
+		publisher->index = NULL;
+		publisher->bucket = &publisher->head;
+	}
+	else
+	{
+		publisher->bucket = malloc(sizeof(struct list_head) * bucket_num);
+		if (publisher->bucket == NULL)
+			goto failed;
+		for (i = 0; i < bucket_num; i++)
+			INIT_LIST_HEAD(&publisher->bucket[i]);
+		publisher->bucket_mask = bucket_num - 1;
+	}
+
 	looper_factory *looper_ctor = looper_factory_create(queue);
 	publisher->looper = looper_ctor->set_thread_param(looper_ctor, prio, stack)
 								   ->set_msg_size(looper_ctor, size)
@@ -301,6 +353,8 @@ static struct publisher_base *create_publisher(struct publisher_factory *ctor)
 	return publisher;
 
 failed:
+	if (publisher->bucket != NULL && publisher->bucket != &publisher->head)
+		free(publisher->bucket);
 	OS_RecursiveMutexDelete(&publisher->lock);
 	if (publisher != NULL)
 		free(publisher);
@@ -309,6 +363,7 @@ failed:
 
 struct publisher_factory *publisher_factory_create(struct event_queue *queue)
 {
+	OS_Status ret = OS_FAIL;
 	publisher_base *base = malloc(sizeof(*base));
 	if (base == NULL)
 		return NULL;
@@ -319,7 +374,7 @@ struct publisher_factory *publisher_factory_create(struct event_queue *queue)
 		goto failed;
 	memset(ctor, 0, sizeof(*ctor));
 
-	OS_Status ret = OS_RecursiveMutexCreate(&base->lock);
+	ret = OS_RecursiveMutexCreate(&base->lock);
 	if (ret != OS_OK)
 		goto failed;
 
@@ -334,9 +389,11 @@ struct publisher_factory *publisher_factory_create(struct event_queue *queue)
 	ctor->prio = OS_PRIORITY_NORMAL;
 	ctor->stack = 2 * 1024;
 	ctor->size = sizeof(struct event_msg);
+	ctor->bucket_num = 1;
 	ctor->set_compare = set_compare;
 	ctor->set_thread_param = set_thread_param;
 	ctor->set_msg_size = set_msg_size;
+	ctor->set_index = set_index;
 	ctor->create_publisher = create_publisher;
 	ctor->queue = queue;
 
@@ -39,7 +39,10 @@
 typedef struct publisher_base
 {
 	looper_base *looper;
-	struct list_head head;	/* TODO: it's more effective by 2-dimention list */
+	struct list_head head;	/* the only bucket if publisher is not indexed */
+	struct list_head *bucket;	/* observers hashed by index(event) */
+	uint32_t bucket_mask;
+	int detached;	/* observers detached during notify, removed after it */
 //	struct event_queue *queue;
 //	OS_Thread_t thd;
 	OS_Mutex_t lock;	// or uint32_t sync by atomic;
@@ -50,6 +53,7 @@ typedef struct publisher_base
 	int (*detach)(struct publisher_base *base, observer_base *obs);
 	int (*notify)(struct publisher_base *base, uint32_t event, uint32_t arg);
 	int (*compare)(uint32_t newEvent, uint32_t obsEvent);
+	uint32_t (*index)(uint32_t event);
 } publisher_base;
 
 typedef struct publisher_factory
@@ -59,9 +63,12 @@ typedef struct publisher_factory
 	OS_Priority prio;
 	uint32_t stack;
 	uint32_t size;
+	uint32_t bucket_num;
 	struct publisher_factory *(*set_compare)(struct publisher_factory *ctor, int (*compare)(uint32_t newEvent, uint32_t obsEvent));
 	struct publisher_factory *(*set_thread_param)(struct publisher_factory *ctor, OS_Priority prio, uint32_t stack);
 	struct publisher_factory *(*set_msg_size)(struct publisher_factory *ctor, uint32_t size);
+	/* index(event) must be equal for every two events compare() matches, bucket_num is power of 2 */
+	struct publisher_factory *(*set_index)(struct publisher_factory *ctor, uint32_t (*index)(uint32_t event), uint32_t bucket_num);
 	struct publisher_base *(*create_publisher)(struct publisher_factory *ctor);
 } publisher_factory;
 
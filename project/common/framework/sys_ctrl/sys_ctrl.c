@@ -85,6 +85,14 @@ static int compare(uint32_t newEvent, uint32_t obsEvent)
 	return -1;
 }
 
+/* observers hashed by event type, compare() only matches in the same type */
+#define SYS_CTRL_INDEX_NUM (16)
+
+static uint32_t sys_ctrl_index(uint32_t event)
+{
+	return EVENT_TYPE(event);
+}
+
 int sys_ctrl_create(void)
 {
 	uint32_t queue_len = PRJCONF_SYS_CTRL_QUEUE_LEN;
@@ -106,6 +114,7 @@ int sys_ctrl_create(void)
 		publisher_factory *ctor = publisher_factory_create(g_sys_queue);
 		g_sys_publisher = ctor->set_thread_param(ctor, PRJCONF_SYS_CTRL_PRIO, PRJCONF_SYS_CTRL_STACK_SIZE)
 							  ->set_compare(ctor, compare)
+							  ->set_index(ctor, sys_ctrl_index, SYS_CTRL_INDEX_NUM)
 							  ->set_msg_size(ctor, sizeof(struct sys_ctrl_msg))
 							  ->create_publisher(ctor);
 
@@ -36,7 +36,16 @@
 #include "publisher.h"
 #include "observer.h"
 
+/*
+ * Deliver sys_ctrl events through the priority heap instead of the OS queue.
+ * prio_event_queue orders by event value, so all pending events of a lower
+ * type (e.g. NETWORK) would be delivered before an earlier one of a higher
+ * type (e.g. VKEY), while the projects are written for the send order of the
+ * OS queue. Off unless a project asks for strict type priority.
+ */
+#ifndef SYS_CTRL_PRIO_QUEUE
 #define SYS_CTRL_PRIO_QUEUE (0)
+#endif
 
 #define ALL_SUBTYPE (0xFFFF)
 
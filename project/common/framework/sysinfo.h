@@ -92,6 +92,32 @@ struct sysinfo_netif_param {
 #endif
 };
 
+#if PRJCONF_NET_FAST_CONNECT
+#define SYSINFO_FAST_CONNECT_MAGIC	(0x46434e31U) /* "FCN1" */
+#define SYSINFO_BSSID_LEN			(6)
+#define SYSINFO_PMK_LEN				(32)
+
+/**
+ * @brief Sysinfo station fast connect cache definition
+ */
+struct sysinfo_wlan_sta_fast {
+	uint32_t magic;			/* SYSINFO_FAST_CONNECT_MAGIC if cache is valid */
+	uint32_t ssid_hash;		/* network the lease belongs to */
+	uint32_t key_hash;		/* ssid and passphrase the PMK derived from */
+
+	uint8_t bssid[SYSINFO_BSSID_LEN];
+	uint8_t channel;
+	uint8_t pmk_valid;
+	uint8_t pmk[SYSINFO_PMK_LEN];
+
+	uint8_t lease_valid;
+	struct sysinfo_netif_param lease;
+	uint32_t dns;			/* first DNS server, network byte order */
+	uint32_t lease_time;	/* lease period in seconds */
+	uint32_t lease_start;	/* time() when the lease was bound */
+};
+#endif
+
 /**
  * @brief Sysinfo structure definition
  */
@@ -109,6 +135,10 @@ struct sysinfo {
 
 	struct sysinfo_netif_param netif_sta_param;
 	struct sysinfo_netif_param netif_ap_param;
+
+#if PRJCONF_NET_FAST_CONNECT
+	struct sysinfo_wlan_sta_fast wlan_sta_fast;
+#endif
 };
 
 #define SYSINFO_SIZE	sizeof(struct sysinfo)
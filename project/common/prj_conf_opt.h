@@ -241,6 +241,11 @@ extern "C" {
                                          PM_SUPPORT_POWEROFF)
 #endif
 
+/* wlan station fast connect with cached PMK and DHCP lease */
+#ifndef PRJCONF_NET_FAST_CONNECT
+#define PRJCONF_NET_FAST_CONNECT        0
+#endif
+
 /* environment variable "TZ" for time zone setting */
 #ifndef PRJCONF_ENV_TZ
 #define PRJCONF_ENV_TZ                  "TZ=GMT-8"
@@ -158,6 +158,24 @@ static int stdout_write(const char *buf, int len)
 	return board_uart_write(g_stdout_uart_id, buf, len);
 }
 
+#ifdef __CONFIG_LIBC_WRAP_STDIO_DEFER
+/* used by the drain thread of deferred stdout, block until DMA transfer end */
+static int stdout_write_dma(const char *buf, int len)
+{
+	if (!g_stdout_enable || g_stdout_uart_id >= UART_NUM || len <= 0) {
+		return 0;
+	}
+
+#ifdef CONFIG_PM
+	if (g_stdio_suspending) {
+		return stdout_write(buf, len);
+	}
+#endif
+
+	return HAL_UART_Transmit_DMA(g_stdout_uart_id, (uint8_t *)buf, len);
+}
+#endif /* __CONFIG_LIBC_WRAP_STDIO_DEFER */
+
 int stdout_init(void)
 {
 	if (g_stdout_uart_id < UART_NUM) {
@@ -169,6 +187,11 @@ int stdout_init(void)
 #ifdef __CONFIG_LIBC_WRAP_STDIO
 		stdio_set_write(stdout_write);
 #endif
+#ifdef __CONFIG_LIBC_WRAP_STDIO_DEFER
+		if (HAL_UART_EnableTxDMA(g_stdout_uart_id) == HAL_OK) {
+			stdio_defer_start(stdout_write_dma);
+		}
+#endif
 #ifdef CONFIG_PM
 		if (!g_stdio_suspending) {
 			pm_register_ops(STDIO_DEV);
@@ -192,6 +215,11 @@ int stdout_deinit(void)
 	}
 #endif
 
+#ifdef __CONFIG_LIBC_WRAP_STDIO_DEFER
+	stdio_defer_stop();
+	HAL_UART_DisableTxDMA(g_stdout_uart_id);
+#endif
+
 	if (board_uart_deinit(g_stdout_uart_id) == HAL_OK) {
 		g_stdout_uart_id = UART_NUM;
 		return 0;
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "common/cmd/cmd_util.h"
+#include "common/cmd/cmd.h"
+#include "driver/component/ov7670/cam_stream.h"
+#include "command.h"
+
+#define COMMAND_IPERF	1
+#define COMMAND_PING	1
+
+/*
+ * net commands
+ */
+static const struct cmd_data g_net_cmds[] = {
+	{ "sta",		cmd_wlan_sta_exec },
+	{ "ifconfig",	cmd_ifconfig_exec },
+#if COMMAND_IPERF
+	{ "iperf",		cmd_iperf_exec },
+#endif
+#if COMMAND_PING
+	{ "ping",		cmd_ping_exec },
+#endif
+};
+
+static enum cmd_status cmd_net_exec(char *cmd)
+{
+	return cmd_exec(cmd, g_net_cmds, cmd_nitems(g_net_cmds));
+}
+
+/*
+ * camera commands
+ */
+static enum cmd_status cmd_cam_stat_exec(char *cmd)
+{
+	cam_stream_stat st;
+
+	cam_stream_get_stat(&st, cmd_strcmp(cmd, "reset") == 0);
+	CMD_LOG(1, "frames %u, encoded %u, dropped: ring %u, busy %u, size %u\n",
+	        st.frames, st.encoded, st.drop_ring, st.drop_busy, st.drop_size);
+	if (st.encoded)
+		CMD_LOG(1, "avg %u bytes, max %u bytes, encode avg %u us, max %u us\n",
+		        st.bytes / st.encoded, st.max_len, st.enc_us / st.encoded, st.enc_us_max);
+	CMD_LOG(1, "ram %u bytes\n", st.ram);
+	return CMD_STATUS_OK;
+}
+
+static enum cmd_status cmd_cam_snap_exec(char *cmd)
+{
+	cam_snap_kick();
+	return CMD_STATUS_OK;
+}
+
+static enum cmd_status cmd_cam_quality_exec(char *cmd)
+{
+	int quality = cmd_atoi(cmd);
+
+	if (cam_stream_set_quality(quality) != 0)
+		return CMD_STATUS_INVALID_ARG;
+	return CMD_STATUS_OK;
+}
+
+static const struct cmd_data g_cam_cmds[] = {
+	{ "stat",		cmd_cam_stat_exec },
+	{ "snap",		cmd_cam_snap_exec },
+	{ "quality",	cmd_cam_quality_exec },
+};
+
+static enum cmd_status cmd_cam_exec(char *cmd)
+{
+	return cmd_exec(cmd, g_cam_cmds, cmd_nitems(g_cam_cmds));
+}
+
+/*
+ * main commands
+ */
+static const struct cmd_data g_main_cmds[] = {
+	{ "net",	cmd_net_exec },
+	{ "cam",	cmd_cam_exec },
+	{ "echo",	cmd_echo_exec },
+	{ "mem",	cmd_mem_exec },
+	{ "upgrade",cmd_upgrade_exec },
+	{ "reboot", cmd_reboot_exec },
+};
+
+void main_cmd_exec(char *cmd)
+{
+	enum cmd_status status;
+
+	if (cmd[0] == '\0') { /* empty command */
+		CMD_LOG(1, "$\n");
+		return;
+	}
+
+	CMD_LOG(CMD_DBG_ON, "$ %s\n", cmd);
+
+	status = cmd_exec(cmd, g_main_cmds, cmd_nitems(g_main_cmds));
+	if (status == CMD_STATUS_ACKED) {
+		return; /* already acked, just return */
+	}
+
+	cmd_write_respond(status, cmd_get_status_desc(status));
+}
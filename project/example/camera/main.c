@@ -0,0 +1,316 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "kernel/os/os.h"
+#include "lwip/sockets.h"
+#include "fs/fatfs/ff.h"
+#include "driver/component/ov7670/drv_ov7670.h"
+#include "driver/component/ov7670/cam_stream.h"
+
+#include "common/framework/platform_init.h"
+#include "command.h"
+
+/*
+ * The OV7670 at QVGA, encoded to JPEG on the chip:
+ *   http://<ip>/         a page showing the stream
+ *   http://<ip>/stream   MJPEG, multipart/x-mixed-replace
+ *   http://<ip>/jpg      the newest frame
+ * and a snapshot to the SD card every CAM_SNAP_PERIOD_S seconds, or on
+ * "cam snap".
+ *
+ * cmds:
+ * 1. net sta config ap_ssid [ap_psk]
+ * 2. net sta enable
+ * 3. cam stat | cam snap | cam quality <1-100>
+ */
+#define CAM_HTTP_PORT			80
+#define CAM_HTTP_CLIENTS		2
+#define CAM_HTTP_STACK_SIZE		(2 * 1024)
+#define CAM_HTTP_SEND_TIMEOUT	3000	/* ms, a client slower than this is closed */
+
+#define CAM_SNAP_PERIOD_S		60
+#define CAM_SNAP_STACK_SIZE		(2 * 1024)
+
+#define CAM_BOUNDARY			"xrframe"
+
+typedef struct {
+	OS_Thread_t thread;
+	int sock;
+} cam_client;
+
+static cam_client g_clients[CAM_HTTP_CLIENTS];
+static OS_Thread_t g_http_thread;
+static OS_Thread_t g_snap_thread;
+static OS_Semaphore_t g_snap_sem;
+
+static int cam_send(int sock, const void *data, uint32_t len)
+{
+	const uint8_t *p = data;
+	int ret;
+
+	while (len) {
+		ret = send(sock, p, len, 0);
+		if (ret <= 0)
+			return -1;
+		p += ret;
+		len -= ret;
+	}
+	return 0;
+}
+
+static int cam_send_frame(int sock, cam_stream_frame *f, int part)
+{
+	char hdr[128];
+	int len;
+
+	if (part)
+		len = snprintf(hdr, sizeof(hdr), "--" CAM_BOUNDARY "\r\n"
+		               "Content-Type: image/jpeg\r\nContent-Length: %u\r\n\r\n", f->len);
+	else
+		len = snprintf(hdr, sizeof(hdr), "HTTP/1.0 200 OK\r\n"
+		               "Content-Type: image/jpeg\r\nContent-Length: %u\r\n"
+		               "Cache-Control: no-cache\r\nConnection: close\r\n\r\n", f->len);
+	if (cam_send(sock, hdr, len) || cam_send(sock, f->data, f->len))
+		return -1;
+	return part ? cam_send(sock, "\r\n", 2) : 0;
+}
+
+static void cam_http_stream(int sock)
+{
+	static const char hdr[] = "HTTP/1.0 200 OK\r\n"
+		"Content-Type: multipart/x-mixed-replace;boundary=" CAM_BOUNDARY "\r\n"
+		"Cache-Control: no-cache\r\nConnection: close\r\n\r\n";
+	cam_stream_frame *f;
+	uint32_t seq = 0;
+	int ret;
+
+	if (cam_send(sock, hdr, sizeof(hdr) - 1))
+		return;
+
+	/* the newest frame each time, the ones made while sending are skipped */
+	while (1) {
+		f = cam_stream_get(seq, 2000);
+		if (f == NULL)
+			continue;
+		seq = f->seq;
+		ret = cam_send_frame(sock, f, 1);
+		cam_stream_put(f);
+		if (ret)
+			break;
+	}
+}
+
+static void cam_http_client(void *arg)
+{
+	static const char page[] = "HTTP/1.0 200 OK\r\n"
+		"Content-Type: text/html\r\nConnection: close\r\n\r\n"
+		"<html><body><img src=\"/stream\"></body></html>\r\n";
+	static const char not_found[] = "HTTP/1.0 404 Not Found\r\n"
+		"Connection: close\r\n\r\n";
+	cam_client *c = arg;
+	cam_stream_frame *f;
+	char req[256];
+	int len = 0, ret;
+
+	/* the request line is enough, the rest of the header is not read */
+	while (len < (int)sizeof(req) - 1) {
+		ret = recv(c->sock, req + len, sizeof(req) - 1 - len, 0);
+		if (ret <= 0)
+			break;
+		len += ret;
+		req[len] = '\0';
+		if (strstr(req, "\r\n"))
+			break;
+	}
+	req[len] = '\0';
+
+	if (strncmp(req, "GET /stream", 11) == 0) {
+		cam_http_stream(c->sock);
+	} else if (strncmp(req, "GET /jpg", 8) == 0) {
+		f = cam_stream_get(0, 2000);
+		if (f) {
+			cam_send_frame(c->sock, f, 0);
+			cam_stream_put(f);
+		}
+	} else if (strncmp(req, "GET / ", 6) == 0) {
+		cam_send(c->sock, page, sizeof(page) - 1);
+	} else if (len > 0) {
+		cam_send(c->sock, not_found, sizeof(not_found) - 1);
+	}
+
+	closesocket(c->sock);
+	c->sock = -1;
+	OS_ThreadDelete(&c->thread);
+}
+
+static void cam_http_task(void *arg)
+{
+	struct sockaddr_in addr;
+	struct timeval tv;
+	int srv, sock, i;
+
+	srv = socket(AF_INET, SOCK_STREAM, 0);
+	if (srv < 0) {
+		printf("cam http socket failed\n");
+		OS_ThreadDelete(&g_http_thread);
+		return;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(CAM_HTTP_PORT);
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (bind(srv, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(srv, 2) < 0) {
+		printf("cam http bind failed\n");
+		closesocket(srv);
+		OS_ThreadDelete(&g_http_thread);
+		return;
+	}
+
+	for (i = 0; i < CAM_HTTP_CLIENTS; i++)
+		g_clients[i].sock = -1;
+
+	while (1) {
+		sock = accept(srv, NULL, NULL);
+		if (sock < 0)
+			continue;
+
+		for (i = 0; i < CAM_HTTP_CLIENTS; i++) {
+			if (g_clients[i].sock < 0 && !OS_ThreadIsValid(&g_clients[i].thread))
+				break;
+		}
+		if (i == CAM_HTTP_CLIENTS) {
+			printf("cam http busy\n");
+			closesocket(sock);
+			continue;
+		}
+
+		tv.tv_sec = CAM_HTTP_SEND_TIMEOUT / 1000;
+		tv.tv_usec = (CAM_HTTP_SEND_TIMEOUT % 1000) * 1000;
+		setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+		setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+		g_clients[i].sock = sock;
+		if (OS_ThreadCreate(&g_clients[i].thread, "cam_client", cam_http_client,
+		                    &g_clients[i], OS_THREAD_PRIO_APP,
+		                    CAM_HTTP_STACK_SIZE) != OS_OK) {
+			closesocket(sock);
+			g_clients[i].sock = -1;
+		}
+	}
+}
+
+/* Write the newest frame to the SD card as snapNNNNN.jpg */
+static void cam_snap_task(void *arg)
+{
+	cam_stream_frame *f;
+	uint32_t num = 0;
+	char name[16];
+	FIL fp;
+	UINT bw;
+	FRESULT res;
+
+	while (1) {
+		OS_SemaphoreWait(&g_snap_sem, CAM_SNAP_PERIOD_S * 1000);
+
+		f = cam_stream_get(0, 2000);
+		if (f == NULL)
+			continue;
+
+		snprintf(name, sizeof(name), "snap%05u.jpg", num);
+		res = f_open(&fp, name, FA_CREATE_ALWAYS | FA_WRITE);
+		if (res == FR_OK) {
+			res = f_write(&fp, f->data, f->len, &bw);
+			if (f_close(&fp) != FR_OK || bw != f->len)
+				res = FR_DISK_ERR;
+		}
+		cam_stream_put(f);
+
+		if (res == FR_OK) {
+			printf("cam %s, %u bytes\n", name, bw);
+			num++;
+		} else {
+			printf("cam snap failed, %d\n", res);
+		}
+	}
+}
+
+static int cam_init(void)
+{
+	cam_stream_cfg cfg = CAM_STREAM_CFG_DEFAULT;
+	Ov7670_PowerCtrlCfg power;
+
+	power.Ov7670_Pwdn_Port = GPIO_PORT_A;
+	power.Ov7670_Pwdn_Pin = GPIO_PIN_12;
+	power.Ov7670_Reset_Port = GPIO_PORT_A;
+	power.Ov7670_Reset_Pin = GPIO_PIN_13;
+	Drv_Ov7670_PowerInit(&power);
+	Drv_Ov7670_Reset_Pin_Ctrl(GPIO_PIN_HIGH);
+	Drv_Ov7670_Pwdn_Pin_Ctrl(GPIO_PIN_LOW);
+	OS_MSleep(10);
+
+	HAL_CSI_Moudle_Enalbe(CSI_DISABLE);
+	if (Drv_Ov7670_Init() != COMP_OK)
+		return -1;
+	OS_MSleep(500);
+
+	/* a frame for each HTTP client and the snapshot, and one to encode */
+	cfg.frame_num = CAM_HTTP_CLIENTS + 2;
+	return cam_stream_start(&cfg);
+}
+
+void cam_snap_kick(void)
+{
+	OS_SemaphoreRelease(&g_snap_sem);
+}
+
+int main(void)
+{
+	platform_init();
+
+	printf("camera demo started\n\n");
+
+	if (cam_init() != 0) {
+		printf("camera init failed\n");
+		return -1;
+	}
+
+	if (OS_SemaphoreCreateBinary(&g_snap_sem) != OS_OK ||
+	    OS_ThreadCreate(&g_snap_thread, "cam_snap", cam_snap_task, NULL,
+	                    OS_THREAD_PRIO_APP, CAM_SNAP_STACK_SIZE) != OS_OK ||
+	    OS_ThreadCreate(&g_http_thread, "cam_http", cam_http_task, NULL,
+	                    OS_THREAD_PRIO_APP, CAM_HTTP_STACK_SIZE) != OS_OK) {
+		printf("camera demo thread create failed\n");
+		return -1;
+	}
+
+	return 0;
+}
@@ -10,6 +10,7 @@
 #include "driver/chip/hal_uart.h"
 #include "tuya_cloud_types.h"
 #include "driver/chip/hal_util.h"
+#include <string.h>
 
 /***********************************************************
 *************************micro define***********************
@@ -22,6 +23,8 @@ typedef struct {
     BYTE_T *buf;
     USHORT_T in;
     USHORT_T out;
+    BOOL_T dma_ring; // buf is filled by the uart rx dma
+    UINT_T lost;
 }TUYA_UART_S;
 
 /***********************************************************
@@ -32,6 +35,17 @@ STATIC TUYA_UART_S ty_uart[TY_UART_NUM];
 /***********************************************************
 *************************function define********************
 ***********************************************************/
+STATIC UINT_T __ty_uart_ring_size(IN CONST UINT_T bufsz)
+{
+    UINT_T size = 64;
+
+    while(size < bufsz) {
+        size <<= 1;
+    }
+
+    return size;
+}
+
 STATIC UINT_T __ty_uart_read_data_size(IN CONST TY_UART_PORT_E port)
 {
     UINT_T remain_buf_size = 0;
@@ -51,19 +65,19 @@ static void rx_callback(void *arg)
 	uint8_t data = 0;
 
 	uart_param = (TUYA_UART_S*)arg;
-	if (HAL_UART_IsRxReady(uart_param->uart)) {
+	while (HAL_UART_IsRxReady(uart_param->uart)) {
 		data = HAL_UART_GetRxData(uart_param->uart);
 		//PR_DEBUG("data = %d", data);
-	}else {
-        return;
+
+		if(__ty_uart_read_data_size(uart_param->portid) < uart_param->buf_len - 1) {
+			uart_param->buf[uart_param->in++] = data;
+			if(uart_param->in >= uart_param->buf_len) {
+				uart_param->in = 0;
+			}
+		}else {
+			uart_param->lost++;
+		}
 	}
-	
-	if(__ty_uart_read_data_size(uart_param->portid) < uart_param->buf_len - 1) {
-    	uart_param->buf[uart_param->in++] = data;
-        if(uart_param->in >= uart_param->buf_len) {
-        	uart_param->in = 0;
-        }
-    }
 }
 
 /***********************************************************
@@ -85,12 +99,13 @@ OPERATE_RET ty_uart_init(IN CONST TY_UART_PORT_E port,IN CONST TY_UART_BAUD_E ba
 
     if(ty_uart[port].buf == NULL) {
         memset(&ty_uart[port], 0, sizeof(TUYA_UART_S));
-        ty_uart[port].buf = Malloc(bufsz);
+        // the dma ring size is a power of 2
+        ty_uart[port].buf_len = __ty_uart_ring_size(bufsz);
+        ty_uart[port].buf = Malloc(ty_uart[port].buf_len);
         if(ty_uart[port].buf == NULL) {
             return OPRT_MALLOC_FAILED;
         }
-        ty_uart[port].buf_len = bufsz;
-        PR_DEBUG("uart buf size : %d",bufsz);
+        PR_DEBUG("uart buf size : %d",ty_uart[port].buf_len);
     }else {
         return OPRT_COM_ERROR;
     }
@@ -109,7 +124,13 @@ OPERATE_RET ty_uart_init(IN CONST TY_UART_PORT_E port,IN CONST TY_UART_BAUD_E ba
 
 	ty_uart[port].portid = port;
 	ty_uart[port].uart = HAL_UART_GetInstance(port);
-	HAL_UART_EnableRxCallback(port, rx_callback, &ty_uart[port]);
+	if (HAL_UART_StartRxRing(port, ty_uart[port].buf, ty_uart[port].buf_len,
+	                         NULL, NULL) == HAL_OK) {
+		ty_uart[port].dma_ring = TRUE;
+	} else {
+		PR_NOTICE("uart %d no rx dma, receive by irq", port);
+		HAL_UART_EnableRxCallback(port, rx_callback, &ty_uart[port]);
+	}
 
 	//UART_EnableTxReadyIRQ(ty_uart[port].uart);
 
@@ -134,7 +155,12 @@ OPERATE_RET ty_uart_free(IN CONST TY_UART_PORT_E port)
 
 	// uart deinit
 	//UART_DisableTxReadyIRQ(ty_uart[port].uart);
-	HAL_UART_DisableRxCallback(port);
+	if (ty_uart[port].dma_ring) {
+		HAL_UART_StopRxRing(port);
+		ty_uart[port].dma_ring = FALSE;
+	} else {
+		HAL_UART_DisableRxCallback(port);
+	}
 	HAL_UART_DeInit(port);
 
     if(ty_uart[port].buf != NULL) {
@@ -183,6 +209,33 @@ UINT_T ty_uart_read_data(IN CONST TY_UART_PORT_E port,OUT BYTE_T *buf,IN CONST U
     }
 
     UINT_T actual_size = 0;
+    if(ty_uart[port].dma_ring) {
+        UART_RxRingStat stat;
+        BYTE_T *data;
+        INT_T n;
+
+        HAL_UART_GetRxRingStat(port, &stat);
+        if(stat.overrunBytes + stat.fifoOverrun != ty_uart[port].lost) {
+            PR_NOTICE("uart rx lost %d bytes, %d fifo overruns",
+                      stat.overrunBytes, stat.fifoOverrun);
+            ty_uart[port].lost = stat.overrunBytes + stat.fifoOverrun;
+        }
+
+        while(actual_size < len && (n = HAL_UART_GetRxSpan(port, &data)) > 0) {
+            if(n > len - actual_size) {
+                n = len - actual_size;
+            }
+            memcpy(buf + actual_size, data, n);
+            HAL_UART_ConsumeRx(port, n);
+            actual_size += n;
+        }
+        return actual_size;
+    }
+
+    if(ty_uart[port].lost) {
+        PR_NOTICE("uart fifo is full! lost:%d",ty_uart[port].lost);
+        ty_uart[port].lost = 0;
+    }
     UINT_T cur_num = __ty_uart_read_data_size(port);
     if(cur_num > ty_uart[port].buf_len - 1) {
         PR_NOTICE("uart fifo is full! buf_zize:%d  len:%d",cur_num,len);
@@ -128,6 +128,9 @@ static const struct cmd_data g_main_cmds[] = {
 	{ "mem",	cmd_mem_exec },
 	{ "heap",	cmd_heap_exec },
 	{ "thread",	cmd_thread_exec },
+#ifdef __CONFIG_OS_TRACE
+	{ "trace",	cmd_trace_exec },
+#endif
 	{ "upgrade",cmd_upgrade_exec },
 	{ "reboot", cmd_reboot_exec },
 #ifdef __PRJ_CONFIG_OTA
@@ -32,6 +32,7 @@
 #include "at_debug.h"
 
 #define CMD_CACHE_MAX_LEN 1024
+#define CMD_HASH_SIZE 64 /* power of 2, twice the commands at least */
 
 typedef struct cmd_cache {
 	u32 cnt;
@@ -187,6 +188,7 @@ static AT_ERROR_CODE sockr_handler(at_para_t *at_para);
 static AT_ERROR_CODE sockc_handler(at_para_t *at_para);
 static AT_ERROR_CODE sockd_handler(at_para_t *at_para);
 static AT_ERROR_CODE mode_handler(at_para_t *at_para);
+static AT_ERROR_CODE mux_handler(at_para_t *at_para);
 static AT_ERROR_CODE wifi_handler(at_para_t *at_para);
 static AT_ERROR_CODE reassociate_handler(at_para_t *at_para);
 //static AT_ERROR_CODE gpioc_handler(at_para_t *at_para);
@@ -197,6 +199,9 @@ static AT_ERROR_CODE scan_handler(at_para_t *at_para);
 
 at_callback_t at_callback;
 static cmd_cache_t cache;
+static u8 cmd_hash[CMD_HASH_SIZE]; /* index + 1 in at_command_table, 0 is empty */
+static u32 cmd_hash_seed;
+static u8 cmd_cr; /* the last line ended with CR, skip a following LF */
 
 static const at_command_handler_t at_command_table[] = {
 	{"AT",					attention_handler,	" -- Null cmd, always returns OK"},
@@ -219,6 +224,7 @@ static const at_command_handler_t at_command_table[] = {
 	{"AT+S.SOCKC",			sockc_handler,		" =<id> -- Close socket"},
 	{"AT+S.SOCKD",			sockd_handler,		" =<0|port>,<t|u> -- Disable/Enable socket server. Default is TCP"},
 	{"AT+S.",				mode_handler,		" -- Switch to data mode",},
+	{"AT+S.MUX",			mux_handler,		" -- Switch to data mode of all sockets, framed"},
 	//{"AT+S.HTTPGET",		NULL,				" =<hostname>,<path&queryopts>[,port] -- Http GET of the given path to the specified host/port"},
 	//{"AT+S.HTTPPOST",		NULL,				" =<hostname>,<path&queryopts>,<formcontent>[,port] -- Http POST of the given path to the specified host/port"},
 	//{"AT+S.FSC",			NULL,				" =<fname>,<max_len> -- Create a file for httpd use"},
@@ -249,7 +255,50 @@ AT_ERROR_CODE at_help(void)
 	return AEC_OK;
 }
 
-static s32 at_match(char *cmd)
+static u32 at_hash(u32 seed, const char *cmd, s32 len)
+{
+	u32 h = 2166136261UL ^ seed;
+	s32 i;
+
+	for (i = 0; i < len; i++) {
+		h ^= (u8)cmd[i];
+		h *= 16777619UL;
+	}
+	h ^= h >> 16;
+	h *= 0x85ebca6bUL;
+	h ^= h >> 13;
+
+	return h;
+}
+
+/*
+ * Search a seed that maps every command to its own slot, so a lookup is
+ * one hash and one compare.
+ */
+static void at_hash_init(void)
+{
+	u32 seed;
+	u32 slot;
+	s32 i;
+
+	for (seed = 0; ; seed++) {
+		memset(cmd_hash, 0, sizeof(cmd_hash));
+		for (i = 0; i < TABLE_SIZE(at_command_table); i++) {
+			slot = at_hash(seed, at_command_table[i].cmd,
+			               strlen(at_command_table[i].cmd)) & (CMD_HASH_SIZE - 1);
+			if (cmd_hash[slot] != 0) {
+				break;
+			}
+			cmd_hash[slot] = i + 1;
+		}
+		if (i == TABLE_SIZE(at_command_table)) {
+			break;
+		}
+	}
+	cmd_hash_seed = seed;
+}
+
+static s32 at_match(char *cmd, s32 len)
 {
 	s32 i;
 
@@ -257,10 +306,10 @@ static s32 at_match(char *cmd)
 		return -2;
 	}
 
-	for (i = 0; i < TABLE_SIZE(at_command_table); i++) {
-		if (!strcmp(cmd, at_command_table[i].cmd)) {
-			return i;
-		}
+	i = cmd_hash[at_hash(cmd_hash_seed, cmd, len) & (CMD_HASH_SIZE - 1)] - 1;
+	if (i >= 0 && !strncmp(cmd, at_command_table[i].cmd, len) &&
+	    at_command_table[i].cmd[len] == '\0') {
+		return i;
 	}
 
 	return -1;
@@ -314,57 +363,38 @@ AT_ERROR_CODE at_init(at_callback_t *cb)
 	}
 
 	memset(&cache, 0, sizeof(cache));
+	cmd_cr = 0;
+
+	at_hash_init();
 
 	return AEC_OK;
 }
 
 static AT_ERROR_CODE at_parse_cmd(char *cmdline, s32 size)
 {
-	char at_cmd[AT_CMD_MAX_SIZE+1];
 	at_para_t at_para;
-	char *cptr;
 	s32 idx;
-	s32 cnt = 0;
-	s32 i;
+	s32 cnt;
 
-	cptr = cmdline;
-
-	for (i = 0; i < size; i++) {
-		if (*cptr == AT_EQU) {
+	for (cnt = 0; cnt < size; cnt++) {
+		if (cmdline[cnt] == AT_EQU || cmdline[cnt] == AT_LF || cmdline[cnt] == AT_CR) {
 			break;
 		}
-		else if (*cptr == AT_LF) {
-			break;
-		}
-		else if (*cptr == AT_CR) {
-			if (((i+1) < size) && (*(cptr+1) == AT_LF)) {
-				break;
-			}
-			else {
-				break;
-			}
-		}
-		else {
-			if (cnt < sizeof(at_cmd)-1) {
-				at_cmd[cnt++] = *cptr++;
-			}
-			else {
-				return AEC_CMD_ERROR;
-			}
-		}
 	}
 
-	at_cmd[cnt] = '\0'; /* add string termination */
-
 	if (cnt == 0) { /* skip blank line */
 		return AEC_BLANK_LINE;
 	}
 
-	idx = at_match(at_cmd);
+	if (cnt > AT_CMD_MAX_SIZE) {
+		return AEC_CMD_ERROR;
+	}
+
+	idx = at_match(cmdline, cnt);
 
 	if (idx >= 0) {
 		if (at_command_table[idx].handler != NULL) {
-			at_para.ptr = cptr;
+			at_para.ptr = cmdline + cnt;
 			return at_command_table[idx].handler(&at_para);
 		}
 		else {
@@ -384,70 +414,87 @@ static AT_ERROR_CODE at_parse_cmd(char *cmdline, s32 size)
 AT_ERROR_CODE at_parse(void)
 {
 	AT_ERROR_CODE aec;
-	AT_QUEUE_ERROR_CODE aqec;
+	u8 *data;
+	s32 len;
+	s32 i;
 	u8 tmp;
-	u32 flag = 0;
 
 	while(1) {
-		aqec = at_queue_get(&tmp);
+		len = at_queue_data(&data);
+		if (len <= 0) {
+			continue;
+		}
 
-		if(aqec == AQEC_OK) {
-			if (tmp == AT_LF) {
-				if(cache.cnt < CMD_CACHE_MAX_LEN) {
-					cache.buf[cache.cnt++] = tmp;
-				}
-				else {
-					cache.cnt = 0;
-					AT_DBG("command is discarded!\n");
-					continue; /* command is discarded */
-				}
+		if (cmd_cr) { /* CR LF split between two reads */
+			cmd_cr = 0;
+			if (data[0] == AT_LF) {
+				at_queue_skip(1);
+				continue;
+			}
+		}
 
-				flag = 1;
+		/* Take everything up to the end of the line in one go */
+		for (i = 0; i < len; i++) {
+			if (data[i] == AT_LF || data[i] == AT_CR) {
+				break;
 			}
-			else if (tmp == AT_CR) {
-				cache.buf[cache.cnt++] = tmp;
+		}
 
-				aqec = at_queue_peek(&tmp);
-				if(aqec == AQEC_OK && tmp == AT_LF) {
-					aqec = at_queue_peek(&tmp);
-					if(cache.cnt < CMD_CACHE_MAX_LEN) {
+		if (i == len) {
+			if (cache.cnt + len < CMD_CACHE_MAX_LEN) {
+				memcpy(cache.buf + cache.cnt, data, len);
+				cache.cnt += len;
+			}
+			else {
+				cache.cnt = CMD_CACHE_MAX_LEN; /* discard up to the end of the line */
+			}
+			at_queue_skip(len);
+			continue;
+		}
+
+		tmp = data[i];
+		i++;
+		if (cache.cnt + i < CMD_CACHE_MAX_LEN) {
+			memcpy(cache.buf + cache.cnt, data, i);
+			cache.cnt += i;
+		}
+		else {
+			cache.cnt = CMD_CACHE_MAX_LEN;
+		}
+		at_queue_skip(i);
+
+		if (tmp == AT_CR) {
+			/* the payload of a command follows its line, consume a LF first */
+			if (at_queue_peek(&tmp) == AQEC_OK) {
+				if (tmp == AT_LF) {
+					at_queue_skip(1);
+					if (cache.cnt < CMD_CACHE_MAX_LEN - 1) {
 						cache.buf[cache.cnt++] = tmp;
 					}
-					else {
-						cache.cnt = 0;
-						AT_DBG("command is discarded!\n");
-						continue; /* command is discarded */
-					}
 				}
-
-				flag = 1;
-			}
-
-			if(cache.cnt < CMD_CACHE_MAX_LEN) {
-				cache.buf[cache.cnt++] = tmp;
 			}
 			else {
-				cache.cnt = 0;
-				AT_DBG("command is discarded!\n");
-				continue; /* command is discarded */
+				cmd_cr = 1;
 			}
 		}
 
-		if (flag) {
-			/* echo */
-			if (at_cfg.localecho1) {
-				cache.buf[cache.cnt] = '\0';
-				at_dump("%s", cache.buf);
-			}
+		if (cache.cnt >= CMD_CACHE_MAX_LEN) {
+			cache.cnt = 0;
+			AT_DBG("command is discarded!\n");
+			continue; /* command is discarded */
+		}
 
-			aec = at_parse_cmd((char *)cache.buf, cache.cnt);
+		/* echo */
+		if (at_cfg.localecho1) {
+			cache.buf[cache.cnt] = '\0';
+			at_dump("%s", cache.buf);
+		}
 
-			at_response(aec);
+		aec = at_parse_cmd((char *)cache.buf, cache.cnt);
 
-			cache.cnt = 0;
+		at_response(aec);
 
-			flag = 0;
-		}
+		cache.cnt = 0;
 	}
 
 	return AEC_OK;
@@ -1016,6 +1063,20 @@ static AT_ERROR_CODE mode_handler(at_para_t *at_para)
 	}
 }
 
+static AT_ERROR_CODE mux_handler(at_para_t *at_para)
+{
+	int res;
+
+	res = at_get_parameters(&at_para->ptr, NULL, 0, NULL);
+
+	if (res != AEC_OK) {
+		return AEC_PARA_ERROR;
+	}
+	else {
+		return at_mode(AM_MUX);
+	}
+}
+
 static AT_ERROR_CODE wifi_handler(at_para_t *at_para)
 {
 	at_wifi_para_t cmd_para = { /* default value */
@@ -36,7 +36,6 @@ extern "C" {
 
 #define AT_MAX_PEER_NUM	5
 #define AT_CMD_MAX_SIZE	32
-#define AT_SOCKET_BUFFER_SIZE	1024L
 #define MAX_DUMP_BUFF_SIZE	1024L
 
 #define ANL_WINDOWS	0
@@ -77,6 +76,7 @@ typedef enum {
 typedef enum {
 	AM_CMD=0,
 	AM_DATA,
+	AM_MUX, /* data mode of all the sockets, framed */
 } AT_MODE;
 
 typedef struct {
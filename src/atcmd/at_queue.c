@@ -52,37 +52,47 @@ s32 at_queue_init(void *buf, s32 size, at_queue_callback_t cb)
 	return 0;
 }
 
+/*
+ * Refill the empty queue straight from the callback, in one call and
+ * without a bounce buffer. The queue is only refilled when empty, so the
+ * data is always contiguous from ridx.
+ */
+static s32 at_queue_fill(at_queue_t *q)
+{
+	s32 dcnt;
+
+	if (q->qcnt > 0) {
+		return q->qcnt;
+	}
+
+	if (at_queue_callback == NULL) {
+		return 0;
+	}
+
+	q->ridx = 0;
+	q->widx = 0;
+
+	dcnt = at_queue_callback(q->qbuf, q->qsize);
+	if (dcnt <= 0) {
+		return 0;
+	}
+	if (dcnt > q->qsize) {
+		AT_DBG("queue is overflow\n");
+		return 0;
+	}
+
+	q->widx = dcnt >= q->qsize ? 0 : dcnt;
+	q->qcnt = dcnt;
+
+	return dcnt;
+}
+
 AT_QUEUE_ERROR_CODE at_queue_get(u8 *element)
 {
 	at_queue_t *q = &at_queue;
-	u8 winbuf[32];
-	s32 dcnt;
 
-	if (q->qcnt <= 0) {
-		if (at_queue_callback != NULL) {
-			dcnt = at_queue_callback(winbuf, sizeof(winbuf));
-
-			if (dcnt > 0) {
-				if (dcnt > q->qsize - q->qcnt) {
-					AT_DBG("queue is overflow\n");
-				}
-				else {
-					s32 i;
-
-					for (i=0; i < dcnt; i++) {
-						q->qbuf[q->widx++] = winbuf[i];
-						q->widx = q->widx >= q->qsize ? 0 : q->widx;
-						q->qcnt++;
-					}
-				}
-			}
-			else {
-				return AQEC_EMPTY;
-			}
-		}
-		else {
-			return AQEC_EMPTY;
-		}
+	if (at_queue_fill(q) <= 0) {
+		return AQEC_EMPTY;
 	}
 
 	*element = q->qbuf[q->ridx++];
@@ -95,37 +105,70 @@ AT_QUEUE_ERROR_CODE at_queue_get(u8 *element)
 AT_QUEUE_ERROR_CODE at_queue_peek(u8 *element)
 {
 	at_queue_t *q = &at_queue;
-	u8 winbuf[32];
-	s32 dcnt;
 
-	if (q->qcnt <= 0) {
-		if (at_queue_callback != NULL) {
-			dcnt = at_queue_callback(winbuf, sizeof(winbuf));
-
-			if (dcnt > 0) {
-				if (dcnt > q->qsize - q->qcnt) {
-					AT_DBG("queue is overflow\n");
-				}
-				else {
-					s32 i;
-
-					for (i=0; i < dcnt; i++) {
-						q->qbuf[q->widx++] = winbuf[i];
-						q->widx = q->widx >= q->qsize ? 0 : q->widx;
-						q->qcnt++;
-					}
-				}
-			}
-			else {
-				return AQEC_EMPTY;
-			}
-		}
-		else {
-			return AQEC_EMPTY;
-		}
+	if (at_queue_fill(q) <= 0) {
+		return AQEC_EMPTY;
 	}
 
 	*element = q->qbuf[q->ridx];
 
 	return AQEC_OK;
 }
+
+/**
+  * @brief  Get the data waiting in the queue without copying it.
+  * @param	data: set to the first byte
+  * @retval the number of bytes at data, 0 if empty
+  * @note	The data stays queued until at_queue_skip().
+  */
+s32 at_queue_data(u8 **data)
+{
+	at_queue_t *q = &at_queue;
+	s32 len;
+
+	len = at_queue_fill(q);
+	if (len <= 0) {
+		return 0;
+	}
+
+	*data = q->qbuf + q->ridx;
+
+	return len;
+}
+
+/**
+  * @brief  Drop bytes returned by at_queue_data().
+  */
+void at_queue_skip(s32 len)
+{
+	at_queue_t *q = &at_queue;
+
+	if (len > q->qcnt) {
+		len = q->qcnt;
+	}
+
+	q->ridx += len;
+	q->ridx = q->ridx >= q->qsize ? 0 : q->ridx;
+	q->qcnt -= len;
+}
+
+/**
+  * @brief  Copy the queued data, refilling once if the queue is empty.
+  * @retval the number of bytes copied, 0 if empty
+  */
+s32 at_queue_read(u8 *buf, s32 size)
+{
+	u8 *data;
+	s32 len;
+
+	len = at_queue_data(&data);
+	if (len > size) {
+		len = size;
+	}
+	if (len > 0) {
+		memcpy(buf, data, len);
+		at_queue_skip(len);
+	}
+
+	return len;
+}
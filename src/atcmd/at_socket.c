@@ -31,8 +31,6 @@
 #include "at_private.h"
 #include "at_debug.h"
 
-u8 at_socket_buf[AT_SOCKET_BUFFER_SIZE];
-
 AT_ERROR_CODE at_sockon(char *hostname, s32 port, char *protocol, char *ind)
 {
 	AT_ERROR_CODE aec;
@@ -79,31 +77,34 @@ AT_ERROR_CODE at_sockw(char *id, s32 len)
 {
 	at_callback_para_t para;
 	char *cptr;
+	u8 *data;
 	s32 rlen;
-	s32 i;
 
 	memset(&para, 0, sizeof(para));
 
 	para.u.sockw.id = strtol(id, &cptr, 10);
-	para.u.sockw.buf = at_socket_buf;
 
+	/* The payload is handed over from the queue, not copied */
 	while (len > 0) {
-		rlen = len < sizeof(at_socket_buf) ? len : sizeof(at_socket_buf);
+		rlen = at_queue_data(&data);
+		if (rlen <= 0) {
+			continue;
+		}
+		if (rlen > len) {
+			rlen = len;
+		}
 
+		para.u.sockw.buf = data;
 		para.u.sockw.len = rlen;
 
-		for (i = 0; i < rlen; i++) {
-			while (at_queue_get(&at_socket_buf[i]) != AQEC_OK) {
-				;
-			}
-		}
-
 		if (at_callback.handle_cb != NULL) {
 			if (at_callback.handle_cb(ACC_SOCKW, &para, NULL) != AEC_OK) {
+				at_queue_skip(rlen);
 				return AEC_SEND_FAIL; /* fail */
 			}
 		}
 
+		at_queue_skip(rlen);
 		len -= rlen;
 	}
 
@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Linux benchmark of the AT command parser: scripted sessions are fed
+ * through at_queue and at_parse() with stub callbacks.
+ *
+ *   ./run.sh [sessions]
+ *
+ * The serial callback hands out the script in chunks of the given size,
+ * like the UART driver, and ends the run when the script is consumed.
+ * Every payload byte must reach SOCKW and every command but the bad one
+ * must answer OK, else the bench exits with 1.
+ */
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "atcmd/at_command.h"
+
+#define BENCH_PAYLOAD	1024
+
+static u8 queue_buf[1024];
+static jmp_buf bench_end;
+
+static const u8 *script;
+static s32 script_len;
+static s32 script_pos;
+static s32 chunk_size;
+
+static u32 cmd_cnt;
+static u32 payload_cnt;
+static u32 payload_sum;
+static u32 dump_cnt;
+static u32 ok_cnt;
+
+static s32 bench_read(u8 *buf, s32 size)
+{
+	s32 len;
+
+	if (script_pos >= script_len) {
+		longjmp(bench_end, 1);
+	}
+
+	len = script_len - script_pos;
+	if (len > chunk_size) {
+		len = chunk_size;
+	}
+	if (len > size) {
+		len = size;
+	}
+	memcpy(buf, script + script_pos, len);
+	script_pos += len;
+
+	return len;
+}
+
+static s32 bench_dump(u8 *buf, s32 len)
+{
+	dump_cnt += len;
+	if (len == 6 && !memcmp(buf, "\r\nOK\r\n", 6)) {
+		ok_cnt++;
+	}
+
+	return len;
+}
+
+static AT_ERROR_CODE bench_handle(AT_CALLBACK_CMD cmd, at_callback_para_t *para, at_callback_rsp_t *rsp)
+{
+	s32 i;
+
+	switch (cmd) {
+	case ACC_LOAD:
+		return AEC_UNDEFINED;
+	case ACC_SOCKW:
+		for (i = 0; i < para->u.sockw.len; i++) {
+			payload_sum += para->u.sockw.buf[i];
+		}
+		payload_cnt += para->u.sockw.len;
+		return AEC_OK;
+	case ACC_SOCKQ:
+		rsp->type = 0;
+		rsp->vptr = (void *)0;
+		return AEC_OK;
+	default:
+		return AEC_OK;
+	}
+}
+
+/*
+ * One session: query, a bulk write, a few short commands and a bad one
+ */
+static s32 build_script(u8 *buf, s32 sessions, u32 *cmds, u32 *sum)
+{
+	static const char *lines[] = {
+		"AT\r\n",
+		"AT+S.SOCKQ=01\r\n",
+		"AT+S.SOCKC=01\r\n",
+		"AT+S.ROAM\r\n",
+		"AT+S.NOPE=1\r\n",
+	};
+	s32 len = 0;
+	s32 i, j, k;
+
+	*cmds = 0;
+	*sum = 0;
+	for (i = 0; i < sessions; i++) {
+		for (j = 0; j < (s32)(sizeof(lines) / sizeof(lines[0])); j++) {
+			if (buf) {
+				memcpy(buf + len, lines[j], strlen(lines[j]));
+			}
+			len += strlen(lines[j]);
+			(*cmds)++;
+
+			if (j == 1) {
+				const char *w = "AT+S.SOCKW=01,1024\r\n";
+
+				if (buf) {
+					memcpy(buf + len, w, strlen(w));
+				}
+				len += strlen(w);
+				(*cmds)++;
+				for (k = 0; k < BENCH_PAYLOAD; k++) {
+					u8 c = (u8)(k * 7 + i);
+
+					if (buf) {
+						buf[len] = c;
+					}
+					*sum += c;
+					len++;
+				}
+			}
+		}
+	}
+
+	return len;
+}
+
+static int run(s32 sessions, s32 chunk)
+{
+	at_callback_t cb;
+	u8 *buf;
+	u32 cmds, sum;
+	clock_t start;
+	double cpu;
+	int ok;
+
+	script_len = build_script(NULL, sessions, &cmds, &sum);
+	buf = malloc(script_len);
+	if (buf == NULL) {
+		return -1;
+	}
+	build_script(buf, sessions, &cmds, &sum);
+	script = buf;
+	script_pos = 0;
+	chunk_size = chunk;
+	cmd_cnt = cmds;
+	payload_cnt = payload_sum = dump_cnt = ok_cnt = 0;
+
+	at_queue_init(queue_buf, sizeof(queue_buf), bench_read);
+	cb.handle_cb = bench_handle;
+	cb.dump_cb = bench_dump;
+	at_init(&cb);
+
+	start = clock();
+	if (setjmp(bench_end) == 0) {
+		at_parse();
+	}
+	cpu = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	/* one bad command per session */
+	ok = payload_cnt == (u32)sessions * BENCH_PAYLOAD && payload_sum == sum &&
+	     ok_cnt == cmd_cnt - (u32)sessions;
+	printf("chunk %4d: %7u cmds %9u bytes  %10.0f cmds/s  %6.2f ns/byte  payload %s  OK %u\n",
+	       (int)chunk, (unsigned)cmd_cnt, (unsigned)script_len,
+	       cmd_cnt / cpu, cpu * 1e9 / script_len,
+	       ok ? "ok" : "BAD", (unsigned)ok_cnt);
+	free(buf);
+
+	return ok ? 0 : -1;
+}
+
+int main(int argc, char *argv[])
+{
+	s32 sessions = argc > 1 ? atoi(argv[1]) : 20000;
+	int ret = 0;
+
+	ret |= run(sessions, 32);
+	ret |= run(sessions, 256);
+	ret |= run(sessions, 1024);
+
+	return ret ? 1 : 0;
+}
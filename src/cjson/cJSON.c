@@ -137,6 +137,62 @@ static cJSON *cJSON_New_Item(void)
     return node;
 }
 
+/* Arena allocation: bump pointer in the caller's block, no per-item free. */
+#define ARENA_ALIGN 8
+
+static void *arena_alloc(cJSON_Arena *arena, size_t size, size_t align)
+{
+    size_t offset = (arena->used + align - 1) & ~(align - 1);
+
+    if ((offset > arena->size) || (size > arena->size - offset))
+    {
+        return NULL;
+    }
+    arena->used = offset + size;
+    if (arena->used > arena->peak)
+    {
+        arena->peak = arena->used;
+    }
+
+    return arena->block + offset;
+}
+
+/* Allocators used by the parser, from the arena when one is given. */
+static cJSON *parse_new_item(cJSON_Arena *arena)
+{
+    cJSON *node = NULL;
+
+    if (!arena)
+    {
+        return cJSON_New_Item();
+    }
+    node = (cJSON*)arena_alloc(arena, sizeof(cJSON), ARENA_ALIGN);
+    if (node)
+    {
+        memset(node, '\0', sizeof(cJSON));
+    }
+
+    return node;
+}
+
+static char *parse_malloc_string(cJSON_Arena *arena, size_t len)
+{
+    return arena ? (char*)arena_alloc(arena, len, 1) : (char*)cJSON_malloc(len);
+}
+
+void cJSON_ArenaInit(cJSON_Arena *arena, void *block, size_t size)
+{
+    arena->block = (char*)block;
+    arena->size = size;
+    arena->used = 0;
+    arena->peak = 0;
+}
+
+void cJSON_ArenaReset(cJSON_Arena *arena)
+{
+    arena->used = 0;
+}
+
 /* Delete a cJSON structure. */
 void cJSON_Delete(cJSON *c)
 {
@@ -486,50 +542,16 @@ static const unsigned char firstByteMark[7] =
     0xFC
 };
 
-/* Parse the input text into an unescaped cstring, and populate item. */
-static const char *parse_string(cJSON *item, const char *str, const char **ep)
+/* Unescape the string literal from str (the opening quote) to end_ptr into out,
+ * which holds at least end_ptr - str bytes. Returns the text after the literal. */
+static const char *unescape_string(const char *str, const char *end_ptr, char *out, const char **ep)
 {
     const char *ptr = str + 1;
-    const char *end_ptr =str + 1;
-    char *ptr2 = NULL;
-    char *out = NULL;
+    char *ptr2 = out;
     int len = 0;
     unsigned uc = 0;
     unsigned uc2 = 0;
 
-    /* not a string! */
-    if (*str != '\"')
-    {
-        *ep = str;
-        return NULL;
-    }
-
-    while ((*end_ptr != '\"') && *end_ptr)
-    {
-        if (*end_ptr++ == '\\')
-        {
-            if (*end_ptr == '\0')
-            {
-                /* prevent buffer overflow when last input character is a backslash */
-                return NULL;
-            }
-            /* Skip escaped quotes. */
-            end_ptr++;
-        }
-        len++;
-    }
-
-    /* This is at most how long we need for the string, roughly. */
-    out = (char*)cJSON_malloc(len + 1);
-    if (!out)
-    {
-        return NULL;
-    }
-    item->valuestring = out; /* assign here so out will be deleted during cJSON_Delete() later */
-    item->type = cJSON_String;
-
-    ptr = str + 1;
-    ptr2 = out;
     /* loop through the string literal */
     while (ptr < end_ptr)
     {
@@ -565,6 +587,12 @@ static const char *parse_string(cJSON *item, const char *str, const char **ep)
                     break;
                 case 'u':
                     /* transcode utf16 to utf8. See RFC2781 and RFC3629. */
+                    if ((end_ptr - ptr) < 5)
+                    {
+                        /* invalid, and don't read past the literal */
+                        *ep = str;
+                        return NULL;
+                    }
                     uc = parse_hex4(ptr + 1); /* get the unicode char. */
                     ptr += 4;
                     if (ptr >= end_ptr)
@@ -664,6 +692,55 @@ static const char *parse_string(cJSON *item, const char *str, const char **ep)
     return ptr;
 }
 
+/* Parse the input text into an unescaped cstring, and populate item. */
+static const char *parse_string(cJSON *item, const char *str, const char **ep, cJSON_Arena *arena)
+{
+    const char *end_ptr =str + 1;
+    const char *ptr = NULL;
+    char *out = NULL;
+    int len = 0;
+
+    /* not a string! */
+    if (*str != '\"')
+    {
+        *ep = str;
+        return NULL;
+    }
+
+    while ((*end_ptr != '\"') && *end_ptr)
+    {
+        if (*end_ptr++ == '\\')
+        {
+            if (*end_ptr == '\0')
+            {
+                /* prevent buffer overflow when last input character is a backslash */
+                return NULL;
+            }
+            /* Skip escaped quotes. */
+            end_ptr++;
+        }
+        len++;
+    }
+
+    /* This is at most how long we need for the string, roughly. */
+    out = parse_malloc_string(arena, len + 1);
+    if (!out)
+    {
+        return NULL;
+    }
+    item->valuestring = out; /* assign here so out will be deleted during cJSON_Delete() later */
+    item->type = cJSON_String;
+
+    ptr = unescape_string(str, end_ptr, out, ep);
+    if (ptr && arena)
+    {
+        /* give back what the escapes saved, out is the last allocation */
+        arena->used = (size_t)(out - arena->block) + strlen(out) + 1;
+    }
+
+    return ptr;
+}
+
 /* Render the cstring provided to an escaped version that can be printed. */
 static char *print_string_ptr(const char *str, printbuffer *p)
 {
@@ -817,11 +894,11 @@ static char *print_string(const cJSON *item, printbuffer *p)
 }
 
 /* Predeclare these prototypes. */
-static const char *parse_value(cJSON *item, const char *value, const char **ep);
+static const char *parse_value(cJSON *item, const char *value, const char **ep, cJSON_Arena *arena);
 static char *print_value(const cJSON *item, int depth, cjbool fmt, printbuffer *p);
-static const char *parse_array(cJSON *item, const char *value, const char **ep);
+static const char *parse_array(cJSON *item, const char *value, const char **ep, cJSON_Arena *arena);
 static char *print_array(const cJSON *item, int depth, cjbool fmt, printbuffer *p);
-static const char *parse_object(cJSON *item, const char *value, const char **ep);
+static const char *parse_object(cJSON *item, const char *value, const char **ep, cJSON_Arena *arena);
 static char *print_object(const cJSON *item, int depth, cjbool fmt, printbuffer *p);
 
 /* Utility to jump whitespace and cr/lf */
@@ -836,37 +913,43 @@ static const char *skip(const char *in)
 }
 
 /* Parse an object - create a new root, and populate. */
-cJSON *cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cjbool require_null_terminated)
+static cJSON *parse_root(const char *value, const char **return_parse_end, cjbool require_null_terminated, cJSON_Arena *arena)
 {
     const char *end = NULL;
     /* use global error pointer if no specific one was given */
     const char **ep = return_parse_end ? return_parse_end : &global_ep;
-    cJSON *c = cJSON_New_Item();
+    size_t used = arena ? arena->used : 0;
+    cJSON *c = parse_new_item(arena);
     *ep = NULL;
     if (!c) /* memory fail */
     {
         return NULL;
     }
 
-    end = parse_value(c, skip(value), ep);
-    if (!end)
-    {
-        /* parse failure. ep is set. */
-        cJSON_Delete(c);
-        return NULL;
-    }
-
-    /* if we require null-terminated JSON without appended garbage, skip and then check for a null terminator */
-    if (require_null_terminated)
+    end = parse_value(c, skip(value), ep, arena);
+    if (end && require_null_terminated)
     {
+        /* if we require null-terminated JSON without appended garbage, skip and then check for a null terminator */
         end = skip(end);
         if (*end)
         {
-            cJSON_Delete(c);
             *ep = end;
-            return NULL;
+            end = NULL;
         }
     }
+    if (!end)
+    {
+        /* parse failure. ep is set. */
+        if (arena)
+        {
+            arena->used = used;
+        }
+        else
+        {
+            cJSON_Delete(c);
+        }
+        return NULL;
+    }
     if (return_parse_end)
     {
         *return_parse_end = end;
@@ -875,12 +958,32 @@ cJSON *cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cjb
     return c;
 }
 
+cJSON *cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cjbool require_null_terminated)
+{
+    return parse_root(value, return_parse_end, require_null_terminated, NULL);
+}
+
 /* Default options for cJSON_Parse */
 cJSON *cJSON_Parse(const char *value)
 {
     return cJSON_ParseWithOpts(value, 0, 0);
 }
 
+cJSON *cJSON_ParseWithOptsInArena(cJSON_Arena *arena, const char *value, const char **return_parse_end, cjbool require_null_terminated)
+{
+    if (!arena)
+    {
+        return NULL;
+    }
+
+    return parse_root(value, return_parse_end, require_null_terminated, arena);
+}
+
+cJSON *cJSON_ParseInArena(cJSON_Arena *arena, const char *value)
+{
+    return cJSON_ParseWithOptsInArena(arena, value, 0, 0);
+}
+
 /* Render a cJSON item/entity/structure to text. */
 char *cJSON_Print(const cJSON *item)
 {
@@ -918,7 +1021,7 @@ int cJSON_PrintPreallocated(cJSON *item,char *buf, const int len, const cjbool f
 }
 
 /* Parser core - when encountering text, process appropriately. */
-static const char *parse_value(cJSON *item, const char *value, const char **ep)
+static const char *parse_value(cJSON *item, const char *value, const char **ep, cJSON_Arena *arena)
 {
     if (!value)
     {
@@ -945,7 +1048,7 @@ static const char *parse_value(cJSON *item, const char *value, const char **ep)
     }
     if (*value == '\"')
     {
-        return parse_string(item, value, ep);
+        return parse_string(item, value, ep, arena);
     }
     if ((*value == '-') || ((*value >= '0') && (*value <= '9')))
     {
@@ -953,11 +1056,11 @@ static const char *parse_value(cJSON *item, const char *value, const char **ep)
     }
     if (*value == '[')
     {
-        return parse_array(item, value, ep);
+        return parse_array(item, value, ep, arena);
     }
     if (*value == '{')
     {
-        return parse_object(item, value, ep);
+        return parse_object(item, value, ep, arena);
     }
 
     /* failure. */
@@ -1069,7 +1172,7 @@ static char *print_value(const cJSON *item, int depth, cjbool fmt, printbuffer *
 }
 
 /* Build an array from input text. */
-static const char *parse_array(cJSON *item,const char *value,const char **ep)
+static const char *parse_array(cJSON *item,const char *value,const char **ep, cJSON_Arena *arena)
 {
     cJSON *child = NULL;
     if (*value != '[')
@@ -1087,14 +1190,14 @@ static const char *parse_array(cJSON *item,const char *value,const char **ep)
         return value + 1;
     }
 
-    item->child = child = cJSON_New_Item();
+    item->child = child = parse_new_item(arena);
     if (!item->child)
     {
         /* memory fail */
         return NULL;
     }
     /* skip any spacing, get the value. */
-    value = skip(parse_value(child, skip(value), ep));
+    value = skip(parse_value(child, skip(value), ep, arena));
     if (!value)
     {
         return NULL;
@@ -1104,7 +1207,7 @@ static const char *parse_array(cJSON *item,const char *value,const char **ep)
     while (*value == ',')
     {
         cJSON *new_item = NULL;
-        if (!(new_item = cJSON_New_Item()))
+        if (!(new_item = parse_new_item(arena)))
         {
             /* memory fail */
             return NULL;
@@ -1115,7 +1218,7 @@ static const char *parse_array(cJSON *item,const char *value,const char **ep)
         child = new_item;
 
         /* go to the next comma */
-        value = skip(parse_value(child, skip(value + 1), ep));
+        value = skip(parse_value(child, skip(value + 1), ep, arena));
         if (!value)
         {
             /* memory fail */
@@ -1305,7 +1408,7 @@ static char *print_array(const cJSON *item, int depth, cjbool fmt, printbuffer *
 }
 
 /* Build an object from the text. */
-static const char *parse_object(cJSON *item, const char *value, const char **ep)
+static const char *parse_object(cJSON *item, const char *value, const char **ep, cJSON_Arena *arena)
 {
     cJSON *child = NULL;
     if (*value != '{')
@@ -1323,14 +1426,14 @@ static const char *parse_object(cJSON *item, const char *value, const char **ep)
         return value + 1;
     }
 
-    child = cJSON_New_Item();
+    child = parse_new_item(arena);
     item->child = child;
     if (!item->child)
     {
         return NULL;
     }
     /* parse first key */
-    value = skip(parse_string(child, skip(value), ep));
+    value = skip(parse_string(child, skip(value), ep, arena));
     if (!value)
     {
         return NULL;
@@ -1346,7 +1449,7 @@ static const char *parse_object(cJSON *item, const char *value, const char **ep)
         return NULL;
     }
     /* skip any spacing, get the value. */
-    value = skip(parse_value(child, skip(value + 1), ep));
+    value = skip(parse_value(child, skip(value + 1), ep, arena));
     if (!value)
     {
         return NULL;
@@ -1355,7 +1458,7 @@ static const char *parse_object(cJSON *item, const char *value, const char **ep)
     while (*value == ',')
     {
         cJSON *new_item = NULL;
-        if (!(new_item = cJSON_New_Item()))
+        if (!(new_item = parse_new_item(arena)))
         {
             /* memory fail */
             return NULL;
@@ -1365,7 +1468,7 @@ static const char *parse_object(cJSON *item, const char *value, const char **ep)
         new_item->prev = child;
 
         child = new_item;
-        value = skip(parse_string(child, skip(value + 1), ep));
+        value = skip(parse_string(child, skip(value + 1), ep, arena));
         if (!value)
         {
             return NULL;
@@ -1382,7 +1485,7 @@ static const char *parse_object(cJSON *item, const char *value, const char **ep)
             return NULL;
         }
         /* skip any spacing, get the value. */
-        value = skip(parse_value(child, skip(value + 1), ep));
+        value = skip(parse_value(child, skip(value + 1), ep, arena));
         if (!value)
         {
             return NULL;
@@ -2315,3 +2418,291 @@ void cJSON_Minify(char *json)
     *into = '\0';
 }
 
+
+/* Pull parser: one token per call from a buffer of known length, the
+ * nesting is kept in the caller's stack and nothing is allocated. */
+#define PULL_VALUE  0   /* a value is expected */
+#define PULL_FIRST  1   /* after '{' or '[' */
+#define PULL_KEY    2   /* after ',' in an object */
+#define PULL_COLON  3   /* after a key */
+#define PULL_AFTER  4   /* after a value */
+#define PULL_DONE   5
+#define PULL_ERROR  6
+
+void cJSON_PullInit(cJSON_Pull *pull, const char *json, size_t len, char *stack, int max_depth)
+{
+    memset(pull, '\0', sizeof(cJSON_Pull));
+    pull->pos = json;
+    pull->end = json + len;
+    pull->stack = stack;
+    pull->max_depth = max_depth;
+    pull->state = PULL_VALUE;
+}
+
+static cJSON_PullEvent pull_error(cJSON_Pull *pull, const char *at)
+{
+    pull->error = at;
+    pull->state = PULL_ERROR;
+    pull->event = cJSON_PullError;
+    return cJSON_PullError;
+}
+
+static cJSON_PullEvent pull_token(cJSON_Pull *pull, cJSON_PullEvent event, const char *next, int state)
+{
+    pull->pos = next;
+    pull->state = state;
+    pull->event = event;
+    return event;
+}
+
+/* Find the closing quote of the literal at p, the token is its raw content. */
+static const char *pull_string(cJSON_Pull *pull, const char *p)
+{
+    const char *q = p + 1;
+
+    while ((q < pull->end) && (*q != '\"'))
+    {
+        if (*q++ == '\\')
+        {
+            q++;
+        }
+    }
+    if (q >= pull->end)
+    {
+        return NULL;
+    }
+    pull->token = p + 1;
+    pull->token_len = (size_t)(q - (p + 1));
+
+    return q + 1;
+}
+
+static cJSON_PullEvent pull_next(cJSON_Pull *pull, cjbool convert)
+{
+    const char *p = NULL;
+    const char *q = NULL;
+    char top = 0;
+    char number[64];
+    cJSON item;
+
+    for (;;)
+    {
+        if (pull->state == PULL_DONE)
+        {
+            return cJSON_PullEnd;
+        }
+        if (pull->state == PULL_ERROR)
+        {
+            return cJSON_PullError;
+        }
+
+        p = pull->pos;
+        while ((p < pull->end) && ((unsigned char)*p <= 32))
+        {
+            p++;
+        }
+        top = pull->depth ? pull->stack[pull->depth - 1] : 0;
+
+        if ((pull->state == PULL_AFTER) && !top)
+        {
+            return pull_token(pull, cJSON_PullEnd, p, PULL_DONE);
+        }
+        if (p >= pull->end)
+        {
+            return pull_error(pull, p);
+        }
+
+        switch (pull->state)
+        {
+            case PULL_AFTER:
+                if (*p == ',')
+                {
+                    pull->pos = p + 1;
+                    pull->state = (top == '{') ? PULL_KEY : PULL_VALUE;
+                    continue;
+                }
+                /* fall through - close the container */
+            case PULL_FIRST:
+                if (*p == ((top == '{') ? '}' : ']'))
+                {
+                    pull->depth--;
+                    return pull_token(pull, (top == '{') ? cJSON_PullObjectEnd : cJSON_PullArrayEnd, p + 1, PULL_AFTER);
+                }
+                if (pull->state == PULL_AFTER)
+                {
+                    return pull_error(pull, p);
+                }
+                pull->pos = p;
+                pull->state = (top == '{') ? PULL_KEY : PULL_VALUE;
+                continue;
+            case PULL_KEY:
+                if ((*p != '\"') || !(q = pull_string(pull, p)))
+                {
+                    return pull_error(pull, p);
+                }
+                return pull_token(pull, cJSON_PullKey, q, PULL_COLON);
+            case PULL_COLON:
+                if (*p != ':')
+                {
+                    return pull_error(pull, p);
+                }
+                pull->pos = p + 1;
+                pull->state = PULL_VALUE;
+                continue;
+            default:
+                break;
+        }
+
+        /* PULL_VALUE */
+        if ((*p == '{') || (*p == '['))
+        {
+            if (pull->depth >= pull->max_depth)
+            {
+                return pull_error(pull, p);
+            }
+            pull->stack[pull->depth++] = *p;
+            return pull_token(pull, (*p == '{') ? cJSON_PullObjectStart : cJSON_PullArrayStart, p + 1, PULL_FIRST);
+        }
+        if (*p == '\"')
+        {
+            if (!(q = pull_string(pull, p)))
+            {
+                return pull_error(pull, p);
+            }
+            return pull_token(pull, cJSON_PullString, q, PULL_AFTER);
+        }
+        if ((*p == '-') || ((*p >= '0') && (*p <= '9')))
+        {
+            for (q = p + 1; (q < pull->end) && (((*q >= '0') && (*q <= '9')) || (*q == '.') || (*q == 'e') || (*q == 'E') || (*q == '+') || (*q == '-')); q++)
+            {
+            }
+            pull->token = p;
+            pull->token_len = (size_t)(q - p);
+            if (convert)
+            {
+                /* the buffer is not terminated, convert a copy */
+                if (pull->token_len >= sizeof(number))
+                {
+                    return pull_error(pull, p);
+                }
+                memcpy(number, p, pull->token_len);
+                number[pull->token_len] = '\0';
+                parse_number(&item, number);
+                pull->valuedouble = item.valuedouble;
+                pull->valueint = item.valueint;
+            }
+            return pull_token(pull, cJSON_PullNumber, q, PULL_AFTER);
+        }
+        if (((pull->end - p) >= 4) && !strncmp(p, "null", 4))
+        {
+            return pull_token(pull, cJSON_PullNull, p + 4, PULL_AFTER);
+        }
+        if (((pull->end - p) >= 5) && !strncmp(p, "false", 5))
+        {
+            pull->valueint = 0;
+            return pull_token(pull, cJSON_PullFalse, p + 5, PULL_AFTER);
+        }
+        if (((pull->end - p) >= 4) && !strncmp(p, "true", 4))
+        {
+            pull->valueint = 1;
+            return pull_token(pull, cJSON_PullTrue, p + 4, PULL_AFTER);
+        }
+
+        return pull_error(pull, p);
+    }
+}
+
+cJSON_PullEvent cJSON_PullNext(cJSON_Pull *pull)
+{
+    return pull_next(pull, true);
+}
+
+cJSON_PullEvent cJSON_PullSkip(cJSON_Pull *pull)
+{
+    cJSON_PullEvent event = pull->event;
+    int depth = 0;
+
+    if (event == cJSON_PullKey)
+    {
+        event = pull_next(pull, false);
+    }
+    if ((event == cJSON_PullObjectStart) || (event == cJSON_PullArrayStart))
+    {
+        depth = pull->depth;
+        while (pull->depth >= depth)
+        {
+            event = pull_next(pull, false);
+            if ((event == cJSON_PullError) || (event == cJSON_PullEnd))
+            {
+                break;
+            }
+        }
+    }
+
+    return event;
+}
+
+cjbool cJSON_PullIsKey(const cJSON_Pull *pull, const char *key)
+{
+    size_t i = 0;
+
+    if ((pull->event != cJSON_PullKey) || !key)
+    {
+        return false;
+    }
+    /* case insensitive like cJSON_GetObjectItem, escaped keys never match */
+    for (i = 0; i < pull->token_len; i++)
+    {
+        if (!key[i] || (tolower((unsigned char)key[i]) != tolower((unsigned char)pull->token[i])))
+        {
+            return false;
+        }
+    }
+
+    return key[i] == '\0';
+}
+
+cjbool cJSON_PullFindKey(cJSON_Pull *pull, const char *key)
+{
+    cJSON_PullEvent event;
+    int depth = pull->depth;
+
+    if (!depth || (pull->stack[depth - 1] != '{'))
+    {
+        return false;
+    }
+
+    for (;;)
+    {
+        event = pull_next(pull, false);
+        if (event != cJSON_PullKey)
+        {
+            return false;
+        }
+        if (cJSON_PullIsKey(pull, key))
+        {
+            return true;
+        }
+        event = cJSON_PullSkip(pull);
+        if ((event == cJSON_PullError) || (event == cJSON_PullEnd))
+        {
+            return false;
+        }
+    }
+}
+
+int cJSON_PullCopyString(const cJSON_Pull *pull, char *buf, size_t size)
+{
+    const char *ep = NULL;
+
+    if (((pull->event != cJSON_PullKey) && (pull->event != cJSON_PullString)) || (size <= pull->token_len))
+    {
+        return -1;
+    }
+    if (!unescape_string(pull->token - 1, pull->token + pull->token_len, buf, &ep))
+    {
+        return -1;
+    }
+
+    return (int)strlen(buf);
+}
@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include "cjson/cJSON.h"
 
 
@@ -467,3 +468,276 @@ int cjson_test(void)
 
     return 0;
 }
+
+/* Parse benchmark: heap tree, arena tree and pull parser on the same documents. */
+
+#define BENCH_ROUNDS        2000
+#define BENCH_ARENA_SIZE    (64 * 1024)
+
+static size_t bench_allocs = 0;
+static size_t bench_live = 0;
+static size_t bench_peak = 0;
+
+typedef union
+{
+    size_t size;
+    double align;
+} bench_head;
+
+static void *bench_malloc(size_t size)
+{
+    bench_head *head = (bench_head *)malloc(sizeof(bench_head) + size);
+    if (head == NULL)
+    {
+        return NULL;
+    }
+    head->size = size;
+    bench_allocs++;
+    bench_live += size;
+    if (bench_live > bench_peak)
+    {
+        bench_peak = bench_live;
+    }
+    return head + 1;
+}
+
+static void bench_free(void *ptr)
+{
+    bench_head *head = (bench_head *)ptr - 1;
+    if (ptr == NULL)
+    {
+        return;
+    }
+    bench_live -= head->size;
+    free(head);
+}
+
+static void bench_reset_counters(void)
+{
+    bench_allocs = 0;
+    bench_live = 0;
+    bench_peak = 0;
+}
+
+static const char bench_directive[] =
+    "{\"to_client\":{\"header\":{\"namespace\":\"ai.dueros.device_interface.audio_player\","
+    "\"name\":\"Play\",\"messageId\":\"NWE1MmY1ZjYtYjI1MS00ZDA0LWEzMTgtMzMzNzI1ZTQ4YjZl\","
+    "\"dialogRequestId\":\"a3c4b1b2-7b0a-4d43-9d2c-5c1e5b0a1f3e\"},\"payload\":{\"playBehavior\":\"REPLACE_ALL\","
+    "\"audioItem\":{\"audioItemId\":\"7f33a1a0-2a7f-4c3c-8b6e-7e4d0f8a9c11\",\"stream\":{"
+    "\"url\":\"http://audio.example.com/track/123456.mp3?token=0123456789abcdef\",\"streamFormat\":\"AUDIO_MP3\","
+    "\"offsetInMilliseconds\":0,\"expiryTime\":\"\",\"progressReportIntervalMs\":5000,"
+    "\"progressReportDelayMs\":0,\"token\":\"bd_audio_123456\",\"expectedPreviousToken\":\"\"}},"
+    "\"title\":\"\\u6674\\u5929\",\"volume\":42,\"mute\":false,\"tags\":[\"music\",\"pop\",null]}}}";
+
+static const char bench_dp[] =
+    "{\"devId\":\"6c8a1f3e2b9d4c7a\",\"dps\":{\"1\":true,\"2\":\"white\",\"3\":255,\"4\":127,"
+    "\"5\":\"ff00ff0000ffff\",\"6\":\"00ff00ff\",\"7\":\"scene_1\",\"8\":\"000e0d0000000000000000c803e8\","
+    "\"9\":false,\"10\":3600,\"101\":[1,2,3,4,5,6,7,8],\"102\":{\"min\":0,\"max\":1000,\"step\":1,\"scale\":0},"
+    "\"103\":\"Living room \\\"main\\\" light\",\"104\":-12.5,\"105\":1.5e3},\"t\":1538211480,\"s\":42}";
+
+static char *bench_generate(int records)
+{
+    size_t size = (size_t)records * 160 + 64;
+    char *text = (char *)malloc(size);
+    size_t len = 0;
+    int i;
+
+    if (text == NULL)
+    {
+        return NULL;
+    }
+    len += sprintf(text + len, "{\"code\":0,\"items\":[");
+    for (i = 0; i < records; i++)
+    {
+        len += sprintf(text + len, "%s{\"id\":%d,\"name\":\"device_%04d\",\"online\":%s,\"rssi\":%d,"
+                "\"pos\":[%d.25,%d.5],\"note\":\"line\\nbreak\"}",
+                i ? "," : "", i, i, (i & 1) ? "true" : "false", -40 - (i % 50), i, -i);
+    }
+    sprintf(text + len, "],\"total\":%d}", records);
+    return text;
+}
+
+/* What an application does with the document: pick the first field it needs. */
+static int bench_pick_tree(cJSON *root, const char *path0, const char *path1)
+{
+    cJSON *item = cJSON_GetObjectItem(root, path0);
+    if (item != NULL && path1 != NULL)
+    {
+        item = cJSON_GetObjectItem(item, path1);
+    }
+    return item != NULL;
+}
+
+static int bench_pick_pull(const char *text, size_t len, const char *path0, const char *path1)
+{
+    cJSON_Pull pull;
+    char stack[32];
+
+    cJSON_PullInit(&pull, text, len, stack, sizeof(stack));
+    if (cJSON_PullNext(&pull) != cJSON_PullObjectStart || !cJSON_PullFindKey(&pull, path0))
+    {
+        return 0;
+    }
+    if (path1 == NULL)
+    {
+        return 1;
+    }
+    return cJSON_PullNext(&pull) == cJSON_PullObjectStart && cJSON_PullFindKey(&pull, path1);
+}
+
+/* Walk every token, like a full parse without the tree. */
+static int bench_walk_pull(const char *text, size_t len)
+{
+    cJSON_Pull pull;
+    char stack[32];
+    cJSON_PullEvent event;
+    int tokens = 0;
+
+    cJSON_PullInit(&pull, text, len, stack, sizeof(stack));
+    while ((event = cJSON_PullNext(&pull)) > cJSON_PullEnd)
+    {
+        tokens++;
+    }
+    return event == cJSON_PullEnd ? tokens : -1;
+}
+
+static int bench_same(cJSON *a, cJSON *b)
+{
+    char *pa = cJSON_PrintUnformatted(a);
+    char *pb = cJSON_PrintUnformatted(b);
+    int same = pa != NULL && pb != NULL && strcmp(pa, pb) == 0;
+
+    bench_free(pa);
+    bench_free(pb);
+    return same;
+}
+
+static int bench_one(const char *name, const char *text, int rounds, void *block, size_t block_size,
+                     const char *path0, const char *path1)
+{
+    cJSON_Hooks hooks = { bench_malloc, bench_free };
+    cJSON_Arena arena;
+    cJSON *heap_root = NULL;
+    cJSON *arena_root = NULL;
+    size_t len = strlen(text);
+    size_t heap_allocs;
+    size_t heap_peak;
+    clock_t start;
+    double heap_us, arena_us, pull_us, pick_us;
+    int tokens = 0;
+    int i;
+
+    cJSON_InitHooks(&hooks);
+    cJSON_ArenaInit(&arena, block, block_size);
+
+    /* the arena tree must match the heap one */
+    heap_root = cJSON_Parse(text);
+    arena_root = cJSON_ParseInArena(&arena, text);
+    if (arena_root == NULL)
+    {
+        printf("%s: arena of %u bytes too small\n", name, (unsigned)block_size);
+    }
+    if (heap_root == NULL || arena_root == NULL || !bench_same(heap_root, arena_root))
+    {
+        printf("%s: arena parse differs from cJSON_Parse\n", name);
+        cJSON_Delete(heap_root);
+        cJSON_InitHooks(NULL);
+        return -1;
+    }
+    cJSON_Delete(heap_root);
+    cJSON_ArenaReset(&arena);
+
+    bench_reset_counters();
+    heap_root = cJSON_Parse(text);
+    heap_allocs = bench_allocs;
+    heap_peak = bench_peak;
+    cJSON_Delete(heap_root);
+
+    start = clock();
+    for (i = 0; i < rounds; i++)
+    {
+        heap_root = cJSON_Parse(text);
+        bench_pick_tree(heap_root, path0, path1);
+        cJSON_Delete(heap_root);
+    }
+    heap_us = (double)(clock() - start) * 1e6 / CLOCKS_PER_SEC / rounds;
+
+    bench_reset_counters();
+    start = clock();
+    for (i = 0; i < rounds; i++)
+    {
+        arena_root = cJSON_ParseInArena(&arena, text);
+        bench_pick_tree(arena_root, path0, path1);
+        cJSON_ArenaReset(&arena);
+    }
+    arena_us = (double)(clock() - start) * 1e6 / CLOCKS_PER_SEC / rounds;
+
+    start = clock();
+    for (i = 0; i < rounds; i++)
+    {
+        tokens = bench_walk_pull(text, len);
+    }
+    pull_us = (double)(clock() - start) * 1e6 / CLOCKS_PER_SEC / rounds;
+
+    start = clock();
+    for (i = 0; i < rounds; i++)
+    {
+        if (!bench_pick_pull(text, len, path0, path1))
+        {
+            tokens = -1;
+        }
+    }
+    pick_us = (double)(clock() - start) * 1e6 / CLOCKS_PER_SEC / rounds;
+
+    printf("%-10s %6u bytes %6d tokens\n", name, (unsigned)len, tokens);
+    printf("  heap   %9.2f us %6u allocs %7u peak bytes\n", heap_us, (unsigned)heap_allocs, (unsigned)heap_peak);
+    printf("  arena  %9.2f us %6u allocs %7u peak bytes\n", arena_us, (unsigned)bench_allocs, (unsigned)arena.peak);
+    printf("  pull   %9.2f us      0 allocs      32 peak bytes (all tokens)\n", pull_us);
+    printf("  pick   %9.2f us      0 allocs      32 peak bytes (%s%s%s)\n", pick_us,
+           path0, path1 ? "." : "", path1 ? path1 : "");
+
+    cJSON_InitHooks(NULL);
+    return tokens < 0 ? -1 : 0;
+}
+
+int cjson_bench(void)
+{
+    void *block = malloc(BENCH_ARENA_SIZE);
+    void *big_block = NULL;
+    char *big = bench_generate(1000);
+    int ret = 0;
+
+    if (block == NULL || big == NULL)
+    {
+        printf("Failed to allocate memory.\n");
+        free(block);
+        free(big);
+        return -1;
+    }
+    big_block = malloc(strlen(big) * 16);
+    if (big_block == NULL)
+    {
+        printf("Failed to allocate memory.\n");
+        free(block);
+        free(big);
+        return -1;
+    }
+
+    ret |= bench_one("directive", bench_directive, BENCH_ROUNDS, block, BENCH_ARENA_SIZE, "to_client", "header");
+    ret |= bench_one("dp", bench_dp, BENCH_ROUNDS, block, BENCH_ARENA_SIZE, "dps", "103");
+    ret |= bench_one("1000 items", big, BENCH_ROUNDS / 20, big_block, strlen(big) * 16, "total", NULL);
+
+    free(big_block);
+    free(big);
+    free(block);
+    return ret;
+}
+
+#ifdef CJSON_TEST_MAIN
+/* gcc -O2 -DCJSON_TEST_MAIN -I../../include cJSON.c json_test.c -lm */
+int main(void)
+{
+    cjson_test();
+    return cjson_bench() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+#endif
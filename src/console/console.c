@@ -47,6 +47,10 @@
  */
 #define CONSOLE_NEW_LINE_MODE       1
 
+/* Size of the UART RX DMA ring, a power of 2. 0 to receive in the UART RX IRQ,
+ * which is also the fallback if no DMA channel is free. */
+#define CONSOLE_RX_RING_SIZE        256
+
 #define CONSOLE_CMD_LINE_MAX_LEN    256
 #define CONSOLE_CMD_LINE_BUF_NUM    2
 
@@ -70,6 +74,12 @@ typedef struct console_priv {
 
     uint8_t         *buf[CONSOLE_CMD_LINE_BUF_NUM];
 
+#if CONSOLE_RX_RING_SIZE
+    uint8_t         rx_ring;        /* receive from the UART RX DMA ring */
+    uint8_t         *rx_span;
+    int32_t         rx_span_len;
+#endif
+
     OS_Semaphore_t   cmd_sem;
 
     console_cmd_exec_func cmd_exec;
@@ -85,6 +95,47 @@ static console_priv_t g_console;
 
 #define CONSOLE_BUF(console, buf_idx)   ((console)->buf[buf_idx])
 
+#if CONSOLE_RX_RING_SIZE
+
+static uint8_t g_console_rx_ring[CONSOLE_RX_RING_SIZE];
+
+__nonxip_text
+static int console_uart_rx_ready(UART_T *uart)
+{
+	console_priv_t *console = &g_console;
+
+	if (!console->rx_ring) {
+		return HAL_UART_IsRxReady(uart);
+	}
+	if (console->rx_span_len <= 0) {
+		console->rx_span_len = HAL_UART_GetRxSpan(console->uart_id,
+		                                          &console->rx_span);
+	}
+	return (console->rx_span_len > 0);
+}
+
+__nonxip_text
+static uint8_t console_uart_rx_data(UART_T *uart)
+{
+	console_priv_t *console = &g_console;
+	uint8_t data;
+
+	if (!console->rx_ring) {
+		return HAL_UART_GetRxData(uart);
+	}
+	data = *console->rx_span++;
+	--console->rx_span_len;
+	HAL_UART_ConsumeRx(console->uart_id, 1);
+	return data;
+}
+
+#else /* CONSOLE_RX_RING_SIZE */
+
+#define console_uart_rx_ready(uart) HAL_UART_IsRxReady(uart)
+#define console_uart_rx_data(uart)  HAL_UART_GetRxData(uart)
+
+#endif /* CONSOLE_RX_RING_SIZE */
+
 #if (CONSOLE_NEW_LINE_MODE == 1)
 
 static int32_t g_console_rx_data;
@@ -95,7 +146,7 @@ static int console_is_rx_ready(UART_T *uart)
 	if (g_console_rx_data >= 0) {
 		return 1;
 	} else {
-		return HAL_UART_IsRxReady(uart);
+		return console_uart_rx_ready(uart);
 	}
 }
 
@@ -108,7 +159,7 @@ static uint8_t console_get_rx_data(UART_T *uart)
 		data = (uint8_t)g_console_rx_data;
 		g_console_rx_data = -1;
 	} else {
-		data = HAL_UART_GetRxData(uart);
+		data = console_uart_rx_data(uart);
 	}
 	return data;
 }
@@ -120,8 +171,8 @@ static uint8_t console_get_rx_data(UART_T *uart)
 
 #else /* CONSOLE_NEW_LINE_MODE */
 
-#define console_is_rx_ready(uart)   HAL_UART_IsRxReady(uart)
-#define console_get_rx_data(uart)   HAL_UART_GetRxData(uart)
+#define console_is_rx_ready(uart)   console_uart_rx_ready(uart)
+#define console_get_rx_data(uart)   console_uart_rx_data(uart)
 
 #endif /* CONSOLE_NEW_LINE_MODE */
 
@@ -208,8 +259,8 @@ retry:
 				if (data == '\n' || data == '\r') { /* command line end */
 #if (CONSOLE_NEW_LINE_MODE == 1)
 					if (data == '\r') { /* check one more data if exist */
-						if (HAL_UART_IsRxReady(uart)) {
-							data = HAL_UART_GetRxData(uart);
+						if (console_uart_rx_ready(uart)) {
+							data = console_uart_rx_data(uart);
 							/* skip data if it's '\n', save it otherwise */
 							if (data != '\n') {
 								console_set_rx_data(data);
@@ -280,6 +331,48 @@ retry:
 	}
 }
 
+#if CONSOLE_RX_RING_SIZE
+__nonxip_text
+static void console_rx_ring_callback(void *arg, uint32_t events)
+{
+	/* a command is taken per call, the ring does not raise the IRQ again for
+	 * the rest like the RX FIFO does */
+	do {
+		console_rx_callback(arg);
+	} while (console_is_rx_ready((UART_T *)arg));
+}
+#endif
+
+static void console_rx_enable(console_priv_t *console)
+{
+	UART_T *uart;
+
+	uart = HAL_UART_GetInstance(console->uart_id);
+#if CONSOLE_RX_RING_SIZE
+	console->rx_span_len = 0;
+	console->rx_ring = 1;
+	if (HAL_UART_StartRxRing(console->uart_id, g_console_rx_ring,
+	                         sizeof(g_console_rx_ring),
+	                         console_rx_ring_callback, uart) == HAL_OK) {
+		return;
+	}
+	console->rx_ring = 0;
+#endif
+	HAL_UART_EnableRxCallback(console->uart_id, console_rx_callback, uart);
+}
+
+static void console_rx_disable(console_priv_t *console)
+{
+#if CONSOLE_RX_RING_SIZE
+	if (console->rx_ring) {
+		HAL_UART_StopRxRing(console->uart_id);
+		console->rx_ring = 0;
+		return;
+	}
+#endif
+	HAL_UART_DisableRxCallback(console->uart_id);
+}
+
 static OS_Thread_t g_console_thread;
 
 static void console_task(void *arg)
@@ -345,7 +438,6 @@ static void console_task(void *arg)
 int console_start(console_param_t *param)
 {
 	int i;
-	UART_T *uart;
 	console_priv_t *console;
 
 	console = &g_console;
@@ -387,9 +479,7 @@ int console_start(console_param_t *param)
 		return -1;
 	}
 
-
-	uart = HAL_UART_GetInstance(console->uart_id);
-	HAL_UART_EnableRxCallback(console->uart_id, console_rx_callback, uart);
+	console_rx_enable(console);
 	console->state = CONSOLE_STATE_START;
 
 	return 0;
@@ -404,7 +494,7 @@ void console_stop(void)
 	console_priv_t *console;
 
 	console = &g_console;
-	HAL_UART_DisableRxCallback(console->uart_id);
+	console_rx_disable(console);
 	console->state = CONSOLE_STATE_TERMINATE;
 	OS_SemaphoreRelease(&console->cmd_sem);
 
@@ -443,7 +533,7 @@ void console_disable(void)
 
 	console = &g_console;
 	if (console->state == CONSOLE_STATE_START) {
-		HAL_UART_DisableRxCallback(console->uart_id);
+		console_rx_disable(console);
 	}
 }
 
@@ -457,12 +547,10 @@ void console_disable(void)
 void console_enable(void)
 {
 	console_priv_t *console;
-	UART_T *uart;
 
 	console = &g_console;
 	if (console->state == CONSOLE_STATE_START) {
-		uart = HAL_UART_GetInstance(console->uart_id);
-		HAL_UART_EnableRxCallback(console->uart_id, console_rx_callback, uart);
+		console_rx_enable(console);
 	}
 }
 
@@ -0,0 +1,404 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * Linux model of the UART receive path: a 64 byte RX FIFO fed at a
+ * sustained baud rate, the DMA and the CPU serving their requests after a
+ * random latency, and a reader thread woken by the callback.
+ *
+ *   gcc -O2 -Wall uart_rx_model.c -o uart_rx_model && ./uart_rx_model
+ *
+ * "ring" runs the circular DMA receive of hal_uart.c with the bookkeeping of
+ * hal_uart_ring.h, "irq" the RX callback reading the FIFO byte by byte into
+ * a ring dropping on full, like tuya_uart.c. Every byte read is checked
+ * against the sent sequence, and the bytes sent must add up to the bytes
+ * read, pending and reported lost.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define __STATIC_INLINE static inline
+#include "../hal_uart_ring.h"
+
+#define RX_EVENT_HALF		(1 << 0)
+#define RX_EVENT_FULL		(1 << 1)
+#define RX_EVENT_IDLE		(1 << 2)
+#define RX_EVENT_OVERRUN	(1 << 3)
+
+#define FIFO_SIZE			64
+#define FIFO_TRIG			32	/* UART_RX_FIFO_TRIG_LEVEL_HALF_FULL */
+#define NEVER				UINT64_MAX
+
+typedef enum {
+	MODE_RING,
+	MODE_IRQ,
+} rx_mode;
+
+typedef struct {
+	const char *name;
+	uint32_t    baud;
+	uint32_t    bytes;
+	uint32_t    burst;		/* max chars sent back to back, 0 for no gap */
+	uint32_t    gap;		/* max idle chars between bursts */
+	uint32_t    isr_lat;	/* max CPU latency to serve an IRQ, ns */
+	uint32_t    dma_lat;	/* max DMA latency to serve a request, ns */
+	uint32_t    task_lat;	/* max latency to run the reader, ns */
+	uint32_t    ring_size;
+} model_param;
+
+typedef struct {
+	uint32_t irqs;
+	uint32_t fifo_lost;
+	uint32_t ring_lost;
+	uint32_t read;
+	uint32_t pending;
+	uint32_t max_pending;
+	uint32_t bad;
+	uint32_t idle;
+} model_result;
+
+static uint32_t rnd_state;
+
+static uint32_t rnd(uint32_t max)
+{
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+	return max ? rnd_state % (max + 1) : 0;
+}
+
+static uint8_t stream_byte(uint32_t k)
+{
+	return (uint8_t)(k * 7 + (k >> 9));
+}
+
+/* UART, DMA and CPU state */
+static uint8_t  fifo[FIFO_SIZE];
+static uint32_t fifo_rd, fifo_cnt;
+static uint64_t fifo_touch;		/* last char in or FIFO read */
+static uint64_t tc;				/* ns per char */
+
+static uint64_t dma_at;			/* DMA serves its request */
+static uint64_t uirq_at;		/* CPU enters the UART IRQ handler */
+static uint64_t dirq_at;		/* CPU enters the DMA IRQ handler */
+static uint32_t dirq_pend;
+static uint64_t task_at;		/* reader runs */
+
+static UART_RxRing ring;
+static uint32_t dma_pos;
+static uint32_t idle_wr;
+
+/* software ring of the IRQ mode */
+static uint8_t *sw_buf;
+static uint32_t sw_in, sw_out;
+
+static const model_param *prm;
+static model_result *res;
+static uint32_t read_seq;		/* stream index of the next byte read */
+
+static uint64_t later(uint64_t now, uint32_t max)
+{
+	return now + rnd(max);
+}
+
+static void wake_reader(uint64_t now)
+{
+	if (task_at == NEVER)
+		task_at = later(now, prm->task_lat);
+}
+
+/* UART_RxRingNotify() of hal_uart.c */
+static void ring_notify(uint64_t now, uint32_t events)
+{
+	if (UART_RxRingSync(&ring, dma_pos))
+		events |= RX_EVENT_OVERRUN;
+	if (events & RX_EVENT_IDLE) {
+		if (ring.wr == idle_wr) {
+			events &= ~RX_EVENT_IDLE;
+		} else {
+			idle_wr = ring.wr;
+			ring.idleCnt++;
+		}
+	}
+	if (events)
+		wake_reader(now);
+}
+
+static int timeout_pending(uint64_t now)
+{
+	return fifo_cnt && now >= fifo_touch + 4 * tc;
+}
+
+static uint8_t fifo_pop(uint64_t now)
+{
+	uint8_t c = fifo[fifo_rd];
+
+	fifo_rd = (fifo_rd + 1) % FIFO_SIZE;
+	fifo_cnt--;
+	fifo_touch = now;
+	return c;
+}
+
+/* the DMA (ring) or the CPU (irq) is asked to read the FIFO */
+static void raise_requests(uint64_t now, rx_mode mode)
+{
+	int req = fifo_cnt >= FIFO_TRIG || timeout_pending(now);
+
+	if (!req)
+		return;
+	if (mode == MODE_RING && dma_at == NEVER)
+		dma_at = later(now, prm->dma_lat);
+	if (uirq_at == NEVER)
+		uirq_at = later(now, prm->isr_lat); /* NVIC latches the request */
+}
+
+static void dma_serve(uint64_t now)
+{
+	uint32_t half = ring.size / 2;
+
+	while (fifo_cnt) {
+		ring.buf[dma_pos] = fifo_pop(now);
+		dma_pos = (dma_pos + 1) & (ring.size - 1);
+		if (dma_pos == half)
+			dirq_pend |= RX_EVENT_HALF;
+		else if (dma_pos == 0)
+			dirq_pend |= RX_EVENT_FULL;
+	}
+	if (dirq_pend && dirq_at == NEVER)
+		dirq_at = later(now, prm->isr_lat);
+}
+
+static void uart_irq(uint64_t now, rx_mode mode)
+{
+	res->irqs++;
+	if (mode == MODE_RING) {
+		/* UART_IRQHandler(): RX_READY syncs, CHAR_TIMEOUT and NONE are idle */
+		ring_notify(now, fifo_cnt >= FIFO_TRIG ? 0 : RX_EVENT_IDLE);
+		return;
+	}
+	/* rx_callback() of tuya_uart.c reads a byte per IRQ, the IRQ is level */
+	while (fifo_cnt) {
+		uint8_t c = fifo_pop(now);
+
+		if (sw_in - sw_out < prm->ring_size - 1)
+			sw_buf[sw_in++ % prm->ring_size] = c;
+		else
+			res->ring_lost++;
+		if (fifo_cnt)
+			res->irqs++;
+	}
+	wake_reader(now);
+}
+
+static void dma_irq(uint64_t now)
+{
+	uint32_t pend = dirq_pend;
+
+	res->irqs++;
+	dirq_pend = 0;
+	if (pend & RX_EVENT_HALF) {
+		ring.halfCnt++;
+		ring_notify(now, RX_EVENT_HALF);
+	}
+	if (pend & RX_EVENT_FULL) {
+		ring.fullCnt++;
+		ring_notify(now, RX_EVENT_FULL);
+	}
+}
+
+static void check_byte(uint8_t c)
+{
+	if (c != stream_byte(read_seq))
+		res->bad++;
+	read_seq++;
+	res->read++;
+}
+
+/* HAL_UART_GetRxSpan() and HAL_UART_ConsumeRx() until empty */
+static void reader(rx_mode mode)
+{
+	uint8_t *data;
+	uint32_t len, i;
+
+	if (mode == MODE_IRQ) {
+		while (sw_out != sw_in)
+			check_byte(sw_buf[sw_out++ % prm->ring_size]);
+		return;
+	}
+	UART_RxRingSync(&ring, dma_pos);
+	read_seq = ring.rd; /* the ring index is the stream index, no FIFO loss */
+	while ((len = UART_RxRingSpan(&ring, &data)) > 0) {
+		for (i = 0; i < len; ++i)
+			check_byte(data[i]);
+		UART_RxRingConsume(&ring, len);
+	}
+}
+
+static void run(const model_param *p, rx_mode mode, model_result *r)
+{
+	uint64_t now = 0, next_rx = 0, t;
+	uint32_t sent = 0, burst_left;
+	uint8_t *buf = malloc(p->ring_size);
+
+	prm = p;
+	res = r;
+	memset(r, 0, sizeof(*r));
+	rnd_state = 0x12345678;
+	tc = 10ULL * 1000000000ULL / p->baud; /* 8N1 */
+
+	fifo_rd = fifo_cnt = 0;
+	fifo_touch = 0;
+	dma_at = uirq_at = dirq_at = task_at = NEVER;
+	dirq_pend = 0;
+	dma_pos = 0;
+	idle_wr = 0;
+	UART_RxRingInit(&ring, buf, p->ring_size);
+	sw_buf = buf;
+	sw_in = sw_out = 0;
+	read_seq = 0;
+	burst_left = p->burst ? 1 + rnd(p->burst) : UINT32_MAX;
+
+	for (;;) {
+		t = next_rx;
+		if (dma_at < t)
+			t = dma_at;
+		if (uirq_at < t)
+			t = uirq_at;
+		if (dirq_at < t)
+			t = dirq_at;
+		if (task_at < t)
+			t = task_at;
+		/* the char timeout, if it is the next thing to happen */
+		if (fifo_cnt && fifo_touch + 4 * tc > now && fifo_touch + 4 * tc < t)
+			t = fifo_touch + 4 * tc;
+		if (t == NEVER)
+			break;
+		now = t;
+
+		if (now == next_rx) {
+			if (fifo_cnt == FIFO_SIZE) {
+				r->fifo_lost++;
+			} else {
+				fifo[(fifo_rd + fifo_cnt) % FIFO_SIZE] = stream_byte(sent);
+				fifo_cnt++;
+			}
+			fifo_touch = now;
+			sent++;
+			if (sent == p->bytes) {
+				next_rx = NEVER;
+			} else if (--burst_left == 0) {
+				next_rx = now + tc * (1 + rnd(p->gap));
+				burst_left = 1 + rnd(p->burst);
+			} else {
+				next_rx = now + tc;
+			}
+		}
+		if (now == dma_at) {
+			dma_at = NEVER;
+			dma_serve(now);
+		}
+		if (now == uirq_at) {
+			uirq_at = NEVER;
+			uart_irq(now, mode);
+		}
+		if (now == dirq_at) {
+			dirq_at = NEVER;
+			dma_irq(now);
+		}
+		if (now == task_at) {
+			task_at = NEVER;
+			reader(mode);
+		}
+		raise_requests(now, mode);
+	}
+
+	if (mode == MODE_RING) {
+		UART_RxRingSync(&ring, dma_pos);
+		r->ring_lost = ring.overrunBytes;
+		r->pending = ring.wr - ring.rd;
+		r->max_pending = ring.maxPending;
+		r->idle = ring.idleCnt;
+	} else {
+		r->pending = sw_in - sw_out;
+	}
+	free(buf);
+}
+
+static int report(const model_param *p)
+{
+	static const char *mode_name[] = { "ring", "irq" };
+	model_result r;
+	int mode, fail = 0;
+
+	printf("%s: %u bytes at %u baud, ring %u, isr <= %u us, task <= %u us\n",
+	       p->name, p->bytes, p->baud, p->ring_size,
+	       p->isr_lat / 1000, p->task_lat / 1000);
+	printf("  %-5s %9s %8s %10s %10s %8s %6s %s\n", "mode", "irqs",
+	       "irq/KB", "fifo lost", "ring lost", "max pend", "idle", "data");
+	for (mode = MODE_RING; mode <= MODE_IRQ; ++mode) {
+		int ok;
+
+		run(p, mode, &r);
+		/* the sequence is checked as long as the stream has no hole before
+		 * the ring, which the irq mode does not tell */
+		ok = r.read + r.pending + r.fifo_lost + r.ring_lost == p->bytes &&
+		     (r.bad == 0 || r.fifo_lost || mode == MODE_IRQ);
+		if (mode == MODE_RING && (!ok || r.fifo_lost))
+			fail = 1;
+		printf("  %-5s %9u %8.1f %10u %10u %8u %6u %s\n", mode_name[mode],
+		       r.irqs, r.irqs * 1024.0 / p->bytes, r.fifo_lost, r.ring_lost,
+		       mode == MODE_RING ? r.max_pending : 0, r.idle,
+		       !ok ? "unaccounted" : (r.fifo_lost || r.ring_lost ? "lossy" : "ok"));
+	}
+	return fail;
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t baud = argc > 1 ? strtoul(argv[1], NULL, 0) : 3000000;
+	model_param p[] = {
+		/* back to back at full rate, other ISRs stall the CPU 200 us */
+		{ "stream", baud, 8000000, 0, 0, 200000, 2000, 2000000, 4096 },
+		/* packets with idle gaps, the reader is woken by the idle events */
+		{ "bursts", baud, 8000000, 2048, 400, 200000, 2000, 2000000, 4096 },
+		/* the reader is late by more than a lap, the loss is reported */
+		{ "slow",   baud, 2000000, 0, 0, 200000, 2000, 40000000, 4096 },
+	};
+	unsigned int i;
+	int fail = 0;
+
+	for (i = 0; i < sizeof(p) / sizeof(p[0]); ++i)
+		fail |= report(&p[i]);
+	printf("%s\n", fail ? "FAIL" : "PASS");
+	return fail;
+}
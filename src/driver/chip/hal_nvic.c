@@ -36,6 +36,21 @@
 #include "pm/pm.h"
 #include "sys/param.h"
 #include "sys/xr_debug.h"
+#include "kernel/os/os_trace.h"
+
+#if (configDEBUG_TRACE_EN == 1)
+/* the vector table points at nvic_trace_irq_handler(), which calls these */
+static NVIC_IRQHandler nvic_trace_handler[NVIC_PERIPH_IRQ_NUM];
+
+static void nvic_trace_irq_handler(void)
+{
+	uint32_t irq = __get_IPSR() - NVIC_PERIPH_IRQ_OFFSET;
+
+	OSTraceIsrEnter(irq);
+	nvic_trace_handler[irq]();
+	OSTraceIsrExit(irq);
+}
+#endif
 
 /**
  * @brief Set the handler for the specified interrupt
@@ -47,6 +62,12 @@ __noinline void HAL_NVIC_SetIRQHandler(IRQn_Type IRQn, NVIC_IRQHandler handler)
 {
     uint32_t *vectors = (uint32_t *)SCB->VTOR;
 
+#if (configDEBUG_TRACE_EN == 1)
+    if (handler != NULL) {
+        nvic_trace_handler[IRQn] = handler;
+        handler = nvic_trace_irq_handler;
+    }
+#endif
     vectors[IRQn + NVIC_PERIPH_IRQ_OFFSET] = (uint32_t)handler;
 }
 
@@ -59,6 +80,10 @@ NVIC_IRQHandler HAL_NVIC_GetIRQHandler(IRQn_Type IRQn)
 {
     uint32_t *vectors = (uint32_t*)SCB->VTOR;
 
+#if (configDEBUG_TRACE_EN == 1)
+    if (vectors[IRQn + NVIC_PERIPH_IRQ_OFFSET] == (uint32_t)nvic_trace_irq_handler)
+        return nvic_trace_handler[IRQn];
+#endif
     return (NVIC_IRQHandler)(vectors[IRQn + NVIC_PERIPH_IRQ_OFFSET]);
 }
 
@@ -35,6 +35,7 @@
 #include "driver/chip/hal_dma.h"
 #include "driver/chip/hal_uart.h"
 #include "hal_base.h"
+#include "hal_uart_ring.h"
 #include "pm/pm.h"
 
 #define UART_TRANSMIT_BY_IRQ_HANDLER	1
@@ -63,6 +64,11 @@ typedef struct {
 
 	DMA_Channel				txDMAChan;
 	DMA_Channel				rxDMAChan;
+
+	UART_RxRing				rxRing;			/* valid if rxRing.buf != NULL */
+	UART_RxRingCallback		rxRingCallback;
+	void                   *rxRingArg;
+	uint32_t				rxRingIdleWr;	/* rxRing.wr at the last idle event */
 } UART_Private;
 
 static UART_Private gUartPrivate[UART_NUM];
@@ -75,6 +81,11 @@ static int8_t g_uart_irq_enable = 0;
 static UART_InitParam g_uart_param[UART_NUM];
 static UART_RxReadyCallback g_uart_cb[UART_NUM];
 static void *g_uart_arg[UART_NUM];
+static int8_t g_uart_ring_enable = 0;
+static uint8_t *g_uart_ring_buf[UART_NUM];
+static uint32_t g_uart_ring_size[UART_NUM];
+static UART_RxRingCallback g_uart_ring_cb[UART_NUM];
+static void *g_uart_ring_arg[UART_NUM];
 
 static int uart_suspend(struct soc_device *dev, enum suspend_state_t state)
 {
@@ -89,6 +100,8 @@ static int uart_suspend(struct soc_device *dev, enum suspend_state_t state)
 	case PM_MODE_POWEROFF:
 		if (g_uart_irq_enable & (1 << uartID))
 			HAL_UART_DisableRxCallback(uartID);
+		if (g_uart_ring_enable & (1 << uartID))
+			HAL_UART_StopRxRing(uartID);
 		while (!HAL_UART_IsTxEmpty(HAL_UART_GetInstance(uartID))) { }
 		HAL_UDelay(100); /* wait tx done */
 		HAL_DBG("%s ok, id %d\n", __func__, uartID);
@@ -112,6 +125,10 @@ static int uart_resume(struct soc_device *dev, enum suspend_state_t state)
 		if (g_uart_irq_enable & (1 << uartID))
 			HAL_UART_EnableRxCallback(uartID, g_uart_cb[uartID],
 			                          g_uart_arg[uartID]);
+		if (g_uart_ring_enable & (1 << uartID))
+			HAL_UART_StartRxRing(uartID, g_uart_ring_buf[uartID],
+			                     g_uart_ring_size[uartID],
+			                     g_uart_ring_cb[uartID], g_uart_ring_arg[uartID]);
 		HAL_DBG("%s ok, id %d\n", __func__, uartID);
 		break;
 	default:
@@ -342,6 +359,50 @@ __STATIC_INLINE uint32_t UART_GetUartStatus(UART_T *uart)
 	return HAL_GET_BIT(uart->STATUS, UART_STATUS_MASK);
 }
 
+__STATIC_INLINE uint32_t UART_RxRingDMAPos(UART_Private *priv)
+{
+	return priv->rxRing.size - HAL_DMA_GetByteCount(priv->rxDMAChan);
+}
+
+/* Sync the receive ring to the DMA and report the events, in IRQ context */
+static void UART_RxRingNotify(UART_Private *priv, uint32_t events)
+{
+	UART_RxRing *ring = &priv->rxRing;
+	unsigned long flags;
+
+	flags = HAL_EnterCriticalSection();
+	if (UART_RxRingSync(ring, UART_RxRingDMAPos(priv)))
+		events |= UART_RX_EVENT_OVERRUN;
+	if (events & UART_RX_EVENT_IDLE) {
+		if (ring->wr == priv->rxRingIdleWr) {
+			events &= ~UART_RX_EVENT_IDLE; /* nothing new since the last one */
+		} else {
+			priv->rxRingIdleWr = ring->wr;
+			ring->idleCnt++;
+		}
+	}
+	HAL_ExitCriticalSection(flags);
+
+	if (events && priv->rxRingCallback)
+		priv->rxRingCallback(priv->rxRingArg, events);
+}
+
+static void UART_RxRingDMAHalfCallback(void *arg)
+{
+	UART_Private *priv = arg;
+
+	priv->rxRing.halfCnt++;
+	UART_RxRingNotify(priv, UART_RX_EVENT_HALF);
+}
+
+static void UART_RxRingDMAEndCallback(void *arg)
+{
+	UART_Private *priv = arg;
+
+	priv->rxRing.fullCnt++;
+	UART_RxRingNotify(priv, UART_RX_EVENT_FULL);
+}
+
 static void UART_IRQHandler(UART_T *uart, UART_Private *priv)
 {
 	uint32_t iid = UART_GetInterruptID(uart);
@@ -376,7 +437,11 @@ static void UART_IRQHandler(UART_T *uart, UART_Private *priv)
 		break;
 	case UART_IID_RX_READY:
 	case UART_IID_CHAR_TIMEOUT:
-		if (priv && priv->rxReadyCallback) {
+		if (priv && priv->rxRing.buf) {
+			/* the DMA drains the FIFO, the IRQ is kept for the timeout */
+			UART_RxRingNotify(priv, iid == UART_IID_CHAR_TIMEOUT ?
+			                        UART_RX_EVENT_IDLE : 0);
+		} else if (priv && priv->rxReadyCallback) {
 			priv->rxReadyCallback(priv->arg);
 		} else if (priv && priv->rxBuf) {
 			while (priv->rxBufSize > 0) {
@@ -400,8 +465,18 @@ static void UART_IRQHandler(UART_T *uart, UART_Private *priv)
 			}
 		}
 		break;
+	case UART_IID_NONE:
+		/* the DMA may have drained the FIFO before the timeout is served */
+		if (priv && priv->rxRing.buf) {
+			UART_RxRingNotify(priv, UART_RX_EVENT_IDLE);
+		}
+		break;
 	case UART_IID_LINE_STATUS:
-		UART_GetLineStatus(uart);
+		if ((UART_GetLineStatus(uart) & UART_OVERRUN_ERROR_BIT) &&
+		    priv && priv->rxRing.buf) {
+			priv->rxRing.fifoOverrun++;
+			UART_RxRingNotify(priv, UART_RX_EVENT_OVERRUN);
+		}
 		break;
 	case UART_IID_BUSY_DETECT:
 		UART_GetUartStatus(uart);
@@ -474,6 +549,9 @@ HAL_Status HAL_UART_Init(UART_ID uartID, const UART_InitParam *param)
 	priv->arg = NULL;
 	priv->txDMAChan = DMA_CHANNEL_INVALID;
 	priv->rxDMAChan = DMA_CHANNEL_INVALID;
+	priv->rxRing.buf = NULL;
+	priv->rxRingCallback = NULL;
+	priv->rxRingArg = NULL;
 
 	/* config pinmux */
 	HAL_BoardIoctl(HAL_BIR_PINMUX_INIT, HAL_MKDEV(HAL_DEV_MAJOR_UART, uartID), 0);
@@ -566,6 +644,7 @@ HAL_Status HAL_UART_DeInit(UART_ID uartID)
 	}
 #endif
 
+	HAL_UART_StopRxRing(uartID);
 	HAL_UART_DisableTxDMA(uartID);
 	HAL_UART_DisableRxDMA(uartID);
 
@@ -683,7 +762,7 @@ int32_t HAL_UART_Receive_IT(UART_ID uartID, uint8_t *buf, int32_t size, uint32_t
 	uart = HAL_UART_GetInstance(uartID);
 	priv = UART_GetUartPriv(uartID);
 
-	if (priv->rxReadyCallback != NULL) {
+	if (priv->rxReadyCallback != NULL || priv->rxRing.buf != NULL) {
 		HAL_WRN("rx callback is enabled\n");
 		return -1;
 	}
@@ -731,6 +810,11 @@ HAL_Status HAL_UART_EnableRxCallback(UART_ID uartID, UART_RxReadyCallback cb, vo
 	uart = HAL_UART_GetInstance(uartID);
 	priv = UART_GetUartPriv(uartID);
 
+	if (priv->rxRing.buf != NULL) {
+		HAL_WRN("rx ring is started\n");
+		return HAL_BUSY;
+	}
+
 	priv->rxReadyCallback = cb;
 	priv->arg = arg;
 
@@ -1050,7 +1134,7 @@ int32_t HAL_UART_Receive_DMA(UART_ID uartID, uint8_t *buf, int32_t size, uint32_
 	uart = HAL_UART_GetInstance(uartID);
 	priv = UART_GetUartPriv(uartID);
 
-	if (priv->rxReadyCallback != NULL) {
+	if (priv->rxReadyCallback != NULL || priv->rxRing.buf != NULL) {
 		HAL_WRN("rx callback is enabled\n");
 		return -1;
 	}
@@ -1070,6 +1154,242 @@ int32_t HAL_UART_Receive_DMA(UART_ID uartID, uint8_t *buf, int32_t size, uint32_
 	return (size - left);
 }
 
+/**
+ * @brief Start receiving data continuously into a ring by circular DMA
+ *
+ * The DMA fills the ring without CPU work per byte. The callback is called
+ * when the DMA filled each half of the ring and when the RX line goes idle
+ * after data, then the data is read in place by HAL_UART_GetRxSpan() and
+ * released by HAL_UART_ConsumeRx().
+ *
+ * @param[in] uartID ID of the specified UART
+ * @param[in] buf Pointer to the ring buffer
+ * @param[in] size Size of the ring buffer, a power of 2, not more than
+ *                 DMA_DATA_MAX_LEN
+ * @param[in] cb The callback function of UART_RX_EVENT_xxx, NULL for none
+ * @param[in] arg Argument of the callback function
+ * @retval HAL_Status, HAL_OK on success, HAL_BUSY if receiving by other
+ *         functions, HAL_ERROR on no valid DMA channel
+ *
+ * @note UART_RX_EVENT_IDLE comes from the RX timeout IRQ. The DMA may drain
+ *       the FIFO before the IRQ is served, then the timeout cannot be told
+ *       from the FIFO trigger level, so while streaming the event comes at
+ *       most once per trigger level of data.
+ * @note Data is lost if it is not consumed within a lap of the ring, see
+ *       UART_RxRingStat::overrunBytes. Size the ring for the longest time the
+ *       reader can be late, at least two callback latencies of data.
+ * @note If the receive ring is started, all other receive series functions
+ *       cannot be used to receive data.
+ */
+HAL_Status HAL_UART_StartRxRing(UART_ID uartID, uint8_t *buf, uint32_t size,
+                                UART_RxRingCallback cb, void *arg)
+{
+	UART_T *uart;
+	UART_Private *priv;
+	DMA_ChannelInitParam dmaParam;
+
+	UART_ASSERT_ID(uartID);
+
+	if (buf == NULL || size < 2 || size > DMA_DATA_MAX_LEN || (size & (size - 1))) {
+		return HAL_INVALID;
+	}
+
+	uart = HAL_UART_GetInstance(uartID);
+	priv = UART_GetUartPriv(uartID);
+
+	if (priv->rxReadyCallback != NULL || priv->rxRing.buf != NULL ||
+	    priv->rxDMAChan != DMA_CHANNEL_INVALID) {
+		HAL_WRN("uart %d rx is busy\n", uartID);
+		return HAL_BUSY;
+	}
+
+	priv->rxDMAChan = HAL_DMA_Request();
+	if (priv->rxDMAChan == DMA_CHANNEL_INVALID) {
+		return HAL_ERROR;
+	}
+
+	UART_RxRingInit(&priv->rxRing, buf, size);
+	priv->rxRingIdleWr = 0;
+	priv->rxRingCallback = cb;
+	priv->rxRingArg = arg;
+
+	HAL_Memset(&dmaParam, 0, sizeof(dmaParam));
+	dmaParam.cfg = HAL_DMA_MakeChannelInitCfg(DMA_WORK_MODE_CIRCULAR,
+	                                          DMA_WAIT_CYCLE_2,
+	                                          DMA_BYTE_CNT_MODE_REMAIN,
+	                                          DMA_DATA_WIDTH_8BIT,
+	                                          DMA_BURST_LEN_1,
+	                                          DMA_ADDR_MODE_INC,
+	                                          DMA_PERIPH_SRAM,
+	                                          DMA_DATA_WIDTH_8BIT,
+	                                          DMA_BURST_LEN_1,
+	                                          DMA_ADDR_MODE_FIXED,
+	                                          uartID == UART0_ID ?
+	                                                    DMA_PERIPH_UART0 :
+	                                                    DMA_PERIPH_UART1);
+	dmaParam.irqType = DMA_IRQ_TYPE_BOTH;
+	dmaParam.endCallback = UART_RxRingDMAEndCallback;
+	dmaParam.endArg = priv;
+	dmaParam.halfCallback = UART_RxRingDMAHalfCallback;
+	dmaParam.halfArg = priv;
+	HAL_DMA_Init(priv->rxDMAChan, &dmaParam);
+
+	HAL_SET_BIT(uart->HALT, UART_DMA_PTE_RX_BIT);
+	HAL_DMA_Start(priv->rxDMAChan, (uint32_t)&uart->RBR_THR_DLL.RX_BUF,
+	              (uint32_t)buf, size);
+
+	/* the RX IRQ reports the idle line, the DMA requests at the FIFO trigger
+	 * level, so the IRQ is seen once per trigger level of data at most */
+	UART_EnableIRQ(uart, UART_RX_READY_IRQ_EN_BIT | UART_LINE_STATUS_IRQ_EN_BIT);
+
+#ifdef CONFIG_PM
+	if (!(g_uart_suspending & (1 << uartID))) {
+		g_uart_ring_buf[uartID] = buf;
+		g_uart_ring_size[uartID] = size;
+		g_uart_ring_cb[uartID] = cb;
+		g_uart_ring_arg[uartID] = arg;
+		g_uart_ring_enable |= (1 << uartID);
+	}
+#endif
+
+	return HAL_OK;
+}
+
+/**
+ * @brief Stop receiving data into the ring
+ * @param[in] uartID ID of the specified UART
+ * @retval HAL_Status, HAL_OK on success
+ *
+ * @note The data not consumed is dropped.
+ */
+HAL_Status HAL_UART_StopRxRing(UART_ID uartID)
+{
+	UART_T *uart;
+	UART_Private *priv;
+	unsigned long flags;
+
+	UART_ASSERT_ID(uartID);
+
+	uart = HAL_UART_GetInstance(uartID);
+	priv = UART_GetUartPriv(uartID);
+
+	if (priv->rxRing.buf == NULL) {
+		return HAL_OK;
+	}
+
+	UART_DisableIRQ(uart, UART_RX_READY_IRQ_EN_BIT | UART_LINE_STATUS_IRQ_EN_BIT);
+	HAL_DMA_Stop(priv->rxDMAChan);
+	HAL_DMA_DeInit(priv->rxDMAChan);
+	HAL_DMA_Release(priv->rxDMAChan);
+	HAL_CLR_BIT(uart->HALT, UART_DMA_PTE_RX_BIT);
+
+	flags = HAL_EnterCriticalSection();
+	priv->rxDMAChan = DMA_CHANNEL_INVALID;
+	priv->rxRing.buf = NULL;
+	priv->rxRingCallback = NULL;
+	priv->rxRingArg = NULL;
+	HAL_ExitCriticalSection(flags);
+
+#ifdef CONFIG_PM
+	if (!(g_uart_suspending & (1 << uartID))) {
+		g_uart_ring_enable &= ~(1 << uartID);
+	}
+#endif
+
+	return HAL_OK;
+}
+
+/**
+ * @brief Get the received data not consumed yet, in place
+ * @param[in] uartID ID of the specified UART
+ * @param[out] data Pointer to the first byte not consumed
+ * @return Number of contiguous bytes at *data, 0 if none, -1 on error
+ *
+ * @note The ring wraps around, if the return value is less than the data
+ *       pending, call again after HAL_UART_ConsumeRx() for the rest.
+ * @note This function is not thread safe, the ring has one reader.
+ */
+int32_t HAL_UART_GetRxSpan(UART_ID uartID, uint8_t **data)
+{
+	UART_Private *priv;
+	UART_RxRing *ring;
+	unsigned long flags;
+	int32_t len = -1;
+
+	UART_ASSERT_ID(uartID);
+
+	priv = UART_GetUartPriv(uartID);
+	ring = &priv->rxRing;
+
+	flags = HAL_EnterCriticalSection();
+	if (ring->buf != NULL) {
+		UART_RxRingSync(ring, UART_RxRingDMAPos(priv));
+		len = UART_RxRingSpan(ring, data);
+	}
+	HAL_ExitCriticalSection(flags);
+
+	return len;
+}
+
+/**
+ * @brief Release received data got by HAL_UART_GetRxSpan()
+ * @param[in] uartID ID of the specified UART
+ * @param[in] len Number of bytes to release
+ * @return None
+ */
+void HAL_UART_ConsumeRx(UART_ID uartID, int32_t len)
+{
+	UART_Private *priv;
+	unsigned long flags;
+
+	UART_ASSERT_ID(uartID);
+
+	if (len <= 0) {
+		return;
+	}
+
+	priv = UART_GetUartPriv(uartID);
+
+	flags = HAL_EnterCriticalSection();
+	if (priv->rxRing.buf != NULL) {
+		UART_RxRingConsume(&priv->rxRing, len);
+	}
+	HAL_ExitCriticalSection(flags);
+}
+
+/**
+ * @brief Get the statistics of the receive ring
+ * @param[in] uartID ID of the specified UART
+ * @param[out] stat Pointer to UART_RxRingStat structure
+ * @return None
+ */
+void HAL_UART_GetRxRingStat(UART_ID uartID, UART_RxRingStat *stat)
+{
+	UART_Private *priv;
+	UART_RxRing *ring;
+	unsigned long flags;
+
+	UART_ASSERT_ID(uartID);
+
+	priv = UART_GetUartPriv(uartID);
+	ring = &priv->rxRing;
+
+	flags = HAL_EnterCriticalSection();
+	if (ring->buf != NULL) {
+		UART_RxRingSync(ring, UART_RxRingDMAPos(priv));
+	}
+	stat->rxBytes = ring->wr;
+	stat->pending = ring->wr - ring->rd;
+	stat->maxPending = ring->maxPending;
+	stat->halfCnt = ring->halfCnt;
+	stat->fullCnt = ring->fullCnt;
+	stat->idleCnt = ring->idleCnt;
+	stat->overrunCnt = ring->overrunCnt;
+	stat->overrunBytes = ring->overrunBytes;
+	stat->fifoOverrun = ring->fifoOverrun;
+	HAL_ExitCriticalSection(flags);
+}
+
 /**
  * @brief Transmit an amount of data in polling mode
  * @param[in] uartID ID of the specified UART
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef _DRIVER_CHIP_HAL_UART_RING_H_
+#define _DRIVER_CHIP_HAL_UART_RING_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Bookkeeping of the UART receive ring filled by a circular DMA. There is no
+ * register access here, the host model in bench/ runs the same code.
+ *
+ * rd and wr are free running byte counters and size is a power of 2. wr is
+ * extended from the DMA write offset, so the offset must be sampled at least
+ * once a lap. The half and end DMA IRQs sample it twice a lap.
+ */
+typedef struct {
+	uint8_t    *buf;
+	uint32_t    size;
+	uint32_t    rd;
+	uint32_t    wr;
+
+	uint32_t    maxPending;
+	uint32_t    halfCnt;
+	uint32_t    fullCnt;
+	uint32_t    idleCnt;
+	uint32_t    overrunCnt;
+	uint32_t    overrunBytes;	/* unread bytes overwritten by the DMA */
+	uint32_t    fifoOverrun;	/* reported by the UART line status */
+} UART_RxRing;
+
+__STATIC_INLINE void UART_RxRingInit(UART_RxRing *ring, uint8_t *buf, uint32_t size)
+{
+	memset(ring, 0, sizeof(*ring));
+	ring->buf = buf;
+	ring->size = size;
+}
+
+/**
+ * @brief Advance the ring to the DMA write offset
+ * @param[in] ring The receive ring
+ * @param[in] pos Offset in the buffer the DMA writes next
+ * @return 1 if the DMA overwrote unread data, 0 otherwise
+ *
+ * @note On overrun the reader is moved to the newest half of the buffer,
+ *       which the DMA is not about to overwrite.
+ */
+__STATIC_INLINE int UART_RxRingSync(UART_RxRing *ring, uint32_t pos)
+{
+	uint32_t pending;
+
+	ring->wr += (pos - ring->wr) & (ring->size - 1);
+	pending = ring->wr - ring->rd;
+	if (pending > ring->size) {
+		ring->overrunBytes += pending - (ring->size >> 1);
+		ring->overrunCnt++;
+		ring->rd = ring->wr - (ring->size >> 1);
+		return 1;
+	}
+	if (pending > ring->maxPending)
+		ring->maxPending = pending;
+	return 0;
+}
+
+/* The unread bytes up to the end of the buffer */
+__STATIC_INLINE uint32_t UART_RxRingSpan(UART_RxRing *ring, uint8_t **data)
+{
+	uint32_t off = ring->rd & (ring->size - 1);
+	uint32_t len = ring->wr - ring->rd;
+
+	if (len > ring->size - off)
+		len = ring->size - off;
+	*data = ring->buf + off;
+	return len;
+}
+
+__STATIC_INLINE void UART_RxRingConsume(UART_RxRing *ring, uint32_t len)
+{
+	uint32_t pending = ring->wr - ring->rd;
+
+	ring->rd += (len > pending ? pending : len);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DRIVER_CHIP_HAL_UART_RING_H_ */
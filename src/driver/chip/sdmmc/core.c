@@ -752,6 +752,135 @@ int32_t mmc_block_write(struct mmc_card *card, const uint8_t *buf, uint64_t sblk
 
 	err = __sdmmc_block_rw(card, sblk, nblk, 1, &sg, 1);
 
+out:
+	mmc_release_host(card->host);
+	return err;
+}
+
+/**
+ * @brief write SD card from two buffers in one transfer.
+ * @param card:
+ *        @arg card->card handler.
+ * @param buf0:
+ *        @arg buf0->data of the first blocks.
+ * @param nblk0:
+ *        @arg nblk0->number of blocks in buf0.
+ * @param buf1:
+ *        @arg buf1->data of the following blocks.
+ * @param nblk1:
+ *        @arg nblk1->number of blocks in buf1.
+ * @param sblk:
+ *        @arg sblk->start block num.
+ * @retval  0 if success or other if failed.
+ */
+int32_t mmc_block_write2(struct mmc_card *card, const uint8_t *buf0, uint32_t nblk0,
+                         const uint8_t *buf1, uint32_t nblk1, uint64_t sblk)
+{
+	int32_t err;
+	struct scatterlist sg[2];
+
+	if (!card->host) {
+		SD_LOGE("%s,%d err", __func__, __LINE__);
+		return -1;
+	}
+
+	if (nblk0 + nblk1 > SDXC_MAX_TRANS_LEN/512) {
+		SD_LOGW("%s only support block number < %d\n", __func__, SDXC_MAX_TRANS_LEN/512);
+		return -1;
+	}
+
+	mmc_claim_host(card->host);
+
+	err = mmc_set_blocklen(card, 512);
+	if (err)
+		goto out;
+
+	/* one descriptor chain, the blocks of both buffers go in one CMD25 */
+	sg[0].len = 512 * nblk0;
+	sg[0].buffer = (uint8_t *)buf0;
+	sg[1].len = 512 * nblk1;
+	sg[1].buffer = (uint8_t *)buf1;
+
+	err = __sdmmc_block_rw(card, sblk, nblk0 + nblk1, 2, sg, 1);
+
+out:
+	mmc_release_host(card->host);
+	return err;
+}
+
+/**
+ * @brief erase SD card blocks, the card may then read them as 0 or 0xff.
+ * @param card:
+ *        @arg card->card handler.
+ * @param sblk:
+ *        @arg sblk->start block num.
+ * @param nblk:
+ *        @arg nblk->number of blocks.
+ * @retval  0 if success or other if failed.
+ */
+int32_t mmc_erase(struct mmc_card *card, uint64_t sblk, uint32_t nblk)
+{
+	int32_t err;
+	struct mmc_command cmd = {0};
+	uint32_t from = sblk, to = sblk + nblk - 1;
+	uint32_t status = 0, timeout;
+
+	if (!card->host || !nblk) {
+		SD_LOGE("%s,%d err", __func__, __LINE__);
+		return -1;
+	}
+
+	if (!(card->csd.cmdclass & CCC_ERASE)) {
+		SD_LOGW("%s card not support erase\n", __func__);
+		return -1;
+	}
+
+	if (!mmc_card_blockaddr(card)) {
+		from <<= 9;
+		to <<= 9;
+	}
+
+	mmc_claim_host(card->host);
+
+	cmd.opcode = mmc_card_sd(card) ? SD_ERASE_WR_BLK_START : MMC_ERASE_GROUP_START;
+	cmd.arg = from;
+	cmd.flags = MMC_RSP_SPI_R1 | MMC_RSP_R1 | MMC_CMD_AC;
+	err = mmc_wait_for_cmd(card->host, &cmd);
+	if (err)
+		goto out;
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.opcode = mmc_card_sd(card) ? SD_ERASE_WR_BLK_END : MMC_ERASE_GROUP_END;
+	cmd.arg = to;
+	cmd.flags = MMC_RSP_SPI_R1 | MMC_RSP_R1 | MMC_CMD_AC;
+	err = mmc_wait_for_cmd(card->host, &cmd);
+	if (err)
+		goto out;
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.opcode = MMC_ERASE;
+	cmd.arg = 0;
+	cmd.flags = MMC_RSP_SPI_R1B | MMC_RSP_R1B | MMC_CMD_AC;
+	err = mmc_wait_for_cmd(card->host, &cmd);
+	if (err)
+		goto out;
+
+	/* the card is busy until the blocks are erased, up to seconds */
+	timeout = 10000;
+	do {
+		if (HAL_SDC_Is_Busy(card->host) || mmc_send_status(card, &status)) {
+			mmc_mdelay(1);
+			continue;
+		}
+		if (R1_CURRENT_STATE(status) != R1_STATE_PRG)
+			break;
+		mmc_mdelay(1);
+	} while (--timeout);
+	if (!timeout) {
+		SD_LOGE("%s timeout, sector:%x BSZ:%u\n", __func__, from, nblk);
+		err = -1;
+	}
+
 out:
 	mmc_release_host(card->host);
 	return err;
@@ -0,0 +1,468 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Linux benchmark of oled_fb.c. The flushes go to a simulated SSD1306 that
+ * runs the commands and counts the SPI bytes and transfers, next to the
+ * old drv_oled.c writes of the same frames, one transfer a byte with the
+ * address set per glyph page. After each frame both simulated panels must
+ * show the framebuffer. The last frame of each workload is written to
+ * <dir>/oled_<workload>.ppm.
+ *
+ *   ./run.sh [dir]
+ *
+ * The bus time is modelled at 8 MHz, with the setup of a polled transfer
+ * and of a DMA one.
+ *
+ * Built with the flush task, the bench also draws a frame a millisecond
+ * and calls oled_fb_kick() after each; the task must coalesce the kicks
+ * to at most KICK_FPS flushes a second and still keep up with them, and
+ * the panel must show the last frame once the task is stopped.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "kernel/os/os.h"
+#include "driver/component/oled/oled_fb.h"
+#include "oled_char_lib.h"
+
+#define BYTE_US			1.0		/* 8 bit at 8 MHz */
+#define POLL_XFER_US	8.0		/* lock, D/C pin and a polled transfer */
+#define DMA_XFER_US		25.0	/* lock, D/C pin and a DMA transfer */
+
+#define KICK_FPS		50
+#define KICK_MS			1000
+
+struct sim {
+	uint8_t ram[OLED_FB_PAGES][OLED_FB_WIDTH];	/* pages of the controller */
+	int horizontal;
+	int col, page;
+	int col0, col1, page0, page1;
+	uint8_t cmd[3];
+	int ncmd, nargs;
+	uint32_t bytes;
+	uint32_t xfers;
+};
+
+static struct sim sim_new, sim_old;
+static uint32_t errors;
+
+static void sim_reset(struct sim *s, int horizontal)
+{
+	memset(s, 0, sizeof(*s));
+	s->horizontal = horizontal;
+	s->col1 = OLED_FB_WIDTH - 1;
+	s->page1 = OLED_FB_PAGES - 1;
+}
+
+static int cmd_args(uint8_t c)
+{
+	switch (c) {
+	case 0x21:
+	case 0x22:
+		return 2;
+	case 0x20:
+	case 0x81:
+	case 0x8D:
+	case 0xA8:
+	case 0xD3:
+	case 0xD5:
+	case 0xD9:
+	case 0xDA:
+	case 0xDB:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+static void sim_cmd(struct sim *s, uint8_t c)
+{
+	if (s->ncmd == 0)
+		s->nargs = cmd_args(c);
+	s->cmd[s->ncmd++] = c;
+	if (s->ncmd <= s->nargs)
+		return;
+	s->ncmd = 0;
+
+	c = s->cmd[0];
+	if (c == 0x20) {
+		s->horizontal = s->cmd[1] == 0;
+	} else if (c == 0x21) {
+		s->col = s->col0 = s->cmd[1] & 0x7F;
+		s->col1 = s->cmd[2] & 0x7F;
+	} else if (c == 0x22) {
+		s->page = s->page0 = s->cmd[1] & 7;
+		s->page1 = s->cmd[2] & 7;
+	} else if (c >= 0xB0 && c <= 0xB7) {
+		s->page = c & 7;
+	} else if (c <= 0x0F) {
+		s->col = (s->col & 0xF0) | c;
+	} else if (c <= 0x1F) {
+		s->col = (s->col & 0x0F) | ((c & 0x0F) << 4);
+	}
+}
+
+static void sim_data(struct sim *s, uint8_t d)
+{
+	if (s->col < OLED_FB_WIDTH)
+		s->ram[s->page][s->col] = d;
+	if (!s->horizontal) {
+		s->col++;
+		return;
+	}
+	if (s->col++ == s->col1) {
+		s->col = s->col0;
+		s->page = s->page == s->page1 ? s->page0 : s->page + 1;
+	}
+}
+
+/* Pixel of the panel, the controller counts the pages from the bottom */
+static int sim_pixel(const struct sim *s, int x, int y)
+{
+	return (s->ram[OLED_FB_PAGES - 1 - y / 8][x] & (0x80 >> (y & 7))) != 0;
+}
+
+/* oled_fb_ops over sim_new */
+static int new_cmd(const uint8_t *cmd, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++)
+		sim_cmd(&sim_new, cmd[i]);
+	sim_new.bytes += len;
+	sim_new.xfers++;
+	return 0;
+}
+
+static int new_data(const uint8_t *data, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++)
+		sim_data(&sim_new, data[i]);
+	sim_new.bytes += len;
+	sim_new.xfers++;
+	return 0;
+}
+
+static const oled_fb_ops sim_ops = { new_cmd, new_data };
+
+/* The writes of the old drv_oled.c, a transfer a byte */
+static void old_byte(uint8_t b, int data)
+{
+	if (data)
+		sim_data(&sim_old, b);
+	else
+		sim_cmd(&sim_old, b);
+	sim_old.bytes++;
+	sim_old.xfers++;
+}
+
+static void old_write(uint8_t column, uint8_t page, const uint8_t *data, int len)
+{
+	int i;
+
+	old_byte(0xb0 + page, 0);
+	old_byte(((column & 0xf0) >> 4) | 0x10, 0);
+	old_byte(column & 0x0f, 0);
+	for (i = 0; i < len; i++)
+		old_byte(data[i], 1);
+}
+
+static void old_str(uint8_t column, uint8_t page, const char *str)
+{
+	const uint8_t *glyph;
+
+	while (*str != '\0') {
+		glyph = ascii_1608[*str++ - ' '];
+		old_write(column, 7 - page, glyph, 8);
+		old_write(column, 6 - page, glyph + 8, 8);
+		column += 8;
+		if (column > 128 || (128 - column) < 8) {
+			page += 2;
+			column = 0;
+		}
+	}
+}
+
+/* DRV_Oled_Pnxm_Bmp() of pages page0 to page1 of the framebuffer */
+static void old_pages(int page0, int page1)
+{
+	static uint8_t fb[OLED_FB_PAGES][OLED_FB_WIDTH];
+	int p;
+
+	oled_fb_read(&fb[0][0]);
+	for (p = page0; p <= page1; p++)
+		old_write(0, 7 - p, fb[p], OLED_FB_WIDTH);
+}
+
+static void check_frame(void)
+{
+	static uint8_t fb[OLED_FB_PAGES][OLED_FB_WIDTH];
+	int x, y, on;
+
+	oled_fb_read(&fb[0][0]);
+	for (y = 0; y < OLED_FB_HEIGHT; y++) {
+		for (x = 0; x < OLED_FB_WIDTH; x++) {
+			on = (fb[y / 8][x] & (0x80 >> (y & 7))) != 0;
+			if (sim_pixel(&sim_new, x, y) != on || sim_pixel(&sim_old, x, y) != on) {
+				printf("error: pixel %d,%d\n", x, y);
+				errors++;
+				return;
+			}
+		}
+	}
+}
+
+static void write_ppm(const char *dir, const char *name)
+{
+	char path[256];
+	FILE *f;
+	int x, y, i;
+
+	snprintf(path, sizeof(path), "%s/oled_%s.ppm", dir, name);
+	f = fopen(path, "wb");
+	if (f == NULL) {
+		printf("error: cannot write %s\n", path);
+		errors++;
+		return;
+	}
+	/* 4x, a pixel is 3x3 lit and a dark gap */
+	fprintf(f, "P6\n%d %d\n255\n", OLED_FB_WIDTH * 4, OLED_FB_HEIGHT * 4);
+	for (y = 0; y < OLED_FB_HEIGHT * 4; y++) {
+		for (x = 0; x < OLED_FB_WIDTH * 4; x++) {
+			i = sim_pixel(&sim_new, x / 4, y / 4) && x % 4 != 3 && y % 4 != 3;
+			fputc(i ? 0x40 : 0x08, f);
+			fputc(i ? 0xC0 : 0x08, f);
+			fputc(i ? 0xFF : 0x10, f);
+		}
+	}
+	fclose(f);
+}
+
+static uint32_t frames, old_frame_max, old_frame_start;
+
+static void report(const char *name)
+{
+	oled_fb_stat st;
+	double old_us = sim_old.bytes * BYTE_US + sim_old.xfers * POLL_XFER_US;
+	double new_us = sim_new.bytes * BYTE_US + sim_new.xfers * DMA_XFER_US;
+
+	oled_fb_get_stat(&st, 1);
+	printf("%-10s %6u | %9.1f %7.1f %6u %8.3f | %9.1f %7.1f %6u %8.3f\n", name, frames,
+	       sim_old.bytes / (double)frames, sim_old.xfers / (double)frames, old_frame_max,
+	       old_us / 1000 / frames,
+	       sim_new.bytes / (double)frames, sim_new.xfers / (double)frames, st.max_bytes,
+	       new_us / 1000 / frames);
+}
+
+static void frame_start(void)
+{
+	old_frame_start = sim_old.bytes;
+}
+
+static void frame_end(void)
+{
+	if (oled_fb_flush() < 0) {
+		printf("error: flush\n");
+		errors++;
+	}
+	if (sim_old.bytes - old_frame_start > old_frame_max)
+		old_frame_max = sim_old.bytes - old_frame_start;
+	frames++;
+	check_frame();
+}
+
+static void workload_start(void)
+{
+	sim_new.bytes = sim_new.xfers = 0;
+	sim_old.bytes = sim_old.xfers = 0;
+	old_frame_max = 0;
+	frames = 0;
+	oled_fb_get_stat(NULL, 1);
+}
+
+/* The clock of the status line, a second a frame */
+static void clock_line(void)
+{
+	char str[16];
+	int i;
+
+	for (i = 0; i < 120; i++) {
+		frame_start();
+		snprintf(str, sizeof(str), "%02d:%02d:%02d", 12, 34 + (56 + i) / 60, (56 + i) % 60);
+		oled_fb_text(64, 0, str);
+		old_str(64, 0, str);
+		frame_end();
+	}
+}
+
+/* A sensor page of component_manage.c, the label drawn again each time */
+static void sensor_page(void)
+{
+	char str[16];
+	int i;
+
+	for (i = 0; i < 100; i++) {
+		frame_start();
+		snprintf(str, sizeof(str), "%d.%d C  ", 23 + i / 40, (i / 4) % 10);
+		oled_fb_text(16, 16, "TEMPER");
+		oled_fb_text(16, 32, str);
+		old_str(16, 2, "TEMPER");
+		old_str(16, 4, str);
+		frame_end();
+	}
+}
+
+/* A progress bar and its percentage, the old driver sends the bar as a bitmap */
+static void progress(void)
+{
+	char str[8];
+	int i;
+
+	for (i = 0; i <= 100; i++) {
+		frame_start();
+		oled_fb_rect(0, 48, 128, 16, OLED_FB_WHITE);
+		oled_fb_fill_rect(2, 50, i * 124 / 100, 12, OLED_FB_WHITE);
+		snprintf(str, sizeof(str), "%3d%%", i);
+		oled_fb_text(48, 16, str);
+		old_pages(6, 7);
+		old_str(48, 2, str);
+		frame_end();
+	}
+}
+
+/* A ball bouncing over a frame, the old driver sends whole frames */
+static void animation(void)
+{
+	int i, x = 10, y = 20, dx = 3, dy = 2;
+
+	for (i = 0; i < 100; i++) {
+		frame_start();
+		oled_fb_fill_rect(x, y, 6, 6, OLED_FB_BLACK);
+		x += dx;
+		y += dy;
+		if (x <= 2 || x >= OLED_FB_WIDTH - 8)
+			dx = -dx;
+		if (y <= 2 || y >= OLED_FB_HEIGHT - 8)
+			dy = -dy;
+		oled_fb_rect(0, 0, OLED_FB_WIDTH, OLED_FB_HEIGHT, OLED_FB_WHITE);
+		oled_fb_fill_rect(x, y, 6, 6, OLED_FB_WHITE);
+		oled_fb_line(0, OLED_FB_HEIGHT - 1, x + 3, y + 3, OLED_FB_INVERT);
+		oled_fb_line(0, OLED_FB_HEIGHT - 1, x + 3, y + 3, OLED_FB_INVERT);
+		old_pages(0, OLED_FB_PAGES - 1);
+		frame_end();
+	}
+}
+
+#if OLED_FB_TASK
+/* A counter drawn every millisecond, the flush task paces the panel */
+static void kick(void)
+{
+	oled_fb_stat st;
+	char str[16];
+	uint32_t start, n, max;
+	int i;
+
+	sim_reset(&sim_new, 1);
+	sim_reset(&sim_old, 0);
+	if (oled_fb_init(&sim_ops) != 0 || oled_fb_task_start(KICK_FPS) != 0) {
+		printf("error: task start\n");
+		errors++;
+		return;
+	}
+	oled_fb_invalidate();
+	oled_fb_kick();
+
+	start = OS_GetTicks();
+	for (i = 0; OS_GetTicks() - start < KICK_MS; i++) {
+		snprintf(str, sizeof(str), "%6d", i);
+		oled_fb_text(0, 0, str);
+		oled_fb_kick();
+		OS_MSleep(1);
+	}
+	oled_fb_task_stop();
+	oled_fb_get_stat(&st, 1);
+
+	/* not the flush of the stop, the first kick and a period of slack */
+	n = st.flushes + st.clean - 1;
+	max = KICK_MS * KICK_FPS / 1000 + 2;
+	printf("\nkick %d draws in %d ms, %u flushes, at most %u\n", i, KICK_MS, n, max);
+	if (n > max || n < max / 2) {
+		printf("error: %u flushes\n", n);
+		errors++;
+	}
+	old_pages(0, OLED_FB_PAGES - 1);
+	check_frame();
+	oled_fb_deinit();
+}
+#endif
+
+int main(int argc, char **argv)
+{
+	static const struct {
+		const char *name;
+		void (*run)(void);
+	} workloads[] = {
+		{ "clock", clock_line },
+		{ "sensor", sensor_page },
+		{ "progress", progress },
+		{ "animation", animation },
+	};
+	const char *dir = argc > 1 ? argv[1] : "/tmp";
+	uint32_t i;
+
+	printf("%-10s %6s | %-33s | %-33s\n", "", "", "old driver, per frame",
+	       "framebuffer, per frame");
+	printf("%-10s %6s | %9s %7s %6s %8s | %9s %7s %6s %8s\n", "workload", "frames",
+	       "bytes", "xfers", "max", "bus ms", "bytes", "xfers", "max", "bus ms");
+
+	for (i = 0; i < sizeof(workloads) / sizeof(workloads[0]); i++) {
+		sim_reset(&sim_new, 1);
+		sim_reset(&sim_old, 0);
+		if (oled_fb_init(&sim_ops) != 0)
+			return 1;
+		oled_fb_invalidate();
+		oled_fb_flush();
+		workload_start();
+		workloads[i].run();
+		report(workloads[i].name);
+		write_ppm(dir, workloads[i].name);
+		oled_fb_deinit();
+	}
+#if OLED_FB_TASK
+	kick();
+#endif
+
+	printf("\n%s\n", errors ? "FAIL" : "PASS");
+	return errors != 0;
+}
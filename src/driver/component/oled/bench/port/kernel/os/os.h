@@ -0,0 +1,155 @@
+/*
+ * Host stand-in for kernel/os/os.h, the locks and the flush task of
+ * oled_fb.c over pthreads. A tick is a millisecond.
+ */
+
+#ifndef _KERNEL_OS_OS_H_
+#define _KERNEL_OS_OS_H_
+
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+typedef int OS_Status;
+typedef uint32_t OS_Time_t;
+
+#define OS_OK			0
+#define OS_FAIL			-1
+#define OS_WAIT_FOREVER	0xffffffffU
+#define OS_THREAD_PRIO_APP	3
+
+typedef void (*OS_ThreadEntry_t)(void *);
+
+typedef struct {
+	pthread_mutex_t m;
+} OS_Mutex_t;
+
+typedef struct {
+	pthread_mutex_t m;
+	pthread_cond_t c;
+	int count;
+} OS_Semaphore_t;
+
+typedef struct {
+	pthread_t t;
+	volatile int valid;
+	OS_ThreadEntry_t entry;
+	void *arg;
+} OS_Thread_t;
+
+static inline OS_Status OS_MutexCreate(OS_Mutex_t *mutex)
+{
+	return pthread_mutex_init(&mutex->m, NULL) ? OS_FAIL : OS_OK;
+}
+
+static inline OS_Status OS_MutexDelete(OS_Mutex_t *mutex)
+{
+	pthread_mutex_destroy(&mutex->m);
+	return OS_OK;
+}
+
+static inline OS_Status OS_MutexLock(OS_Mutex_t *mutex, OS_Time_t waitMS)
+{
+	(void)waitMS;
+	pthread_mutex_lock(&mutex->m);
+	return OS_OK;
+}
+
+static inline OS_Status OS_MutexUnlock(OS_Mutex_t *mutex)
+{
+	pthread_mutex_unlock(&mutex->m);
+	return OS_OK;
+}
+
+static inline OS_Status OS_SemaphoreCreateBinary(OS_Semaphore_t *sem)
+{
+	sem->count = 0;
+	if (pthread_mutex_init(&sem->m, NULL))
+		return OS_FAIL;
+	if (pthread_cond_init(&sem->c, NULL)) {
+		pthread_mutex_destroy(&sem->m);
+		return OS_FAIL;
+	}
+	return OS_OK;
+}
+
+static inline OS_Status OS_SemaphoreDelete(OS_Semaphore_t *sem)
+{
+	pthread_cond_destroy(&sem->c);
+	pthread_mutex_destroy(&sem->m);
+	return OS_OK;
+}
+
+/* Only OS_WAIT_FOREVER is supported */
+static inline OS_Status OS_SemaphoreWait(OS_Semaphore_t *sem, OS_Time_t waitMS)
+{
+	(void)waitMS;
+	pthread_mutex_lock(&sem->m);
+	while (sem->count == 0)
+		pthread_cond_wait(&sem->c, &sem->m);
+	sem->count = 0;
+	pthread_mutex_unlock(&sem->m);
+	return OS_OK;
+}
+
+static inline OS_Status OS_SemaphoreRelease(OS_Semaphore_t *sem)
+{
+	pthread_mutex_lock(&sem->m);
+	sem->count = 1;
+	pthread_cond_signal(&sem->c);
+	pthread_mutex_unlock(&sem->m);
+	return OS_OK;
+}
+
+static void *os_thread_entry(void *arg)
+{
+	OS_Thread_t *thread = arg;
+
+	thread->entry(thread->arg);
+	return NULL;
+}
+
+static inline OS_Status OS_ThreadCreate(OS_Thread_t *thread, const char *name,
+                                        OS_ThreadEntry_t entry, void *arg,
+                                        int priority, uint32_t stackSize)
+{
+	(void)name;
+	(void)priority;
+	(void)stackSize;
+	thread->entry = entry;
+	thread->arg = arg;
+	thread->valid = 1;
+	if (pthread_create(&thread->t, NULL, os_thread_entry, thread)) {
+		thread->valid = 0;
+		return OS_FAIL;
+	}
+	pthread_detach(thread->t);
+	return OS_OK;
+}
+
+/* Only the thread deleting itself is supported */
+static inline OS_Status OS_ThreadDelete(OS_Thread_t *thread)
+{
+	thread->valid = 0;
+	pthread_exit(NULL);
+	return OS_OK;
+}
+
+static inline int OS_ThreadIsValid(OS_Thread_t *thread)
+{
+	return thread->valid;
+}
+
+static inline OS_Time_t OS_GetTicks(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (OS_Time_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+#define OS_TicksToMSecs(t)	(t)
+#define OS_MSleep(msec)		usleep((msec) * 1000)
+
+#endif /* _KERNEL_OS_OS_H_ */
@@ -0,0 +1,15 @@
+#!/bin/sh
+#
+# Build oled_bench.c with oled_fb.c, without the flush task, and run it.
+# The PPM files of the last frames go to the directory of the first
+# argument, /tmp by default. Then build it again with the flush task and
+# check the rate of the flushes driven by oled_fb_kick().
+#
+set -e
+cd "$(dirname "$0")"
+gcc -O2 -Wall -Iport -I.. -I../../../../../include -DOLED_FB_TASK=0 \
+	oled_bench.c ../oled_fb.c -pthread -o /tmp/oled_bench
+/tmp/oled_bench "${1:-/tmp}"
+gcc -O2 -Wall -Iport -I.. -I../../../../../include -DOLED_FB_TASK=1 \
+	oled_bench.c ../oled_fb.c -pthread -o /tmp/oled_bench_task
+/tmp/oled_bench_task "${1:-/tmp}"
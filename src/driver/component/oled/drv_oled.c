@@ -38,9 +38,9 @@
 #include "kernel/os/os_time.h"
 #include "kernel/os/os_mutex.h"
 
-#include "oled_char_lib.h"
 #include "driver/chip/hal_def.h"
 #include "driver/component/oled/drv_oled.h"
+#include "driver/component/oled/oled_fb.h"
 #include "ssd1306.h"
 
 #define OLED_DBG 0
@@ -53,38 +53,36 @@
 #define DRV_OLDE_DBG(fmt, arg...)	\
 			//LOG(OLED_DBG, "[OLED] "fmt, ##arg)
 
-#define OLED_MAX_TRANSFER_DATA_LEN 128
-
 static SSD1306_t oled_t;
-static OS_Mutex_t OLED_WR_LOCK;
 
 static void oled_wrcmd (uint8_t cmd)
 {
 	oled_t.SSD1306_Write(cmd, SSD1306_CMD);
 }
 
-static Component_Status oled_wrdata(const uint8_t *data, uint32_t len)
+static int oled_spi_cmd(const uint8_t *cmd, uint32_t len)
 {
-	int i=0;
-	if (len <= OLED_MAX_TRANSFER_DATA_LEN)
-		for (i = 0; i < len; i++)
-			oled_t.SSD1306_Write(*(data++), SSD1306_DATA);
-	return COMP_OK;
+	return SSD1306_SPI_Write_Buf(cmd, len, SSD1306_CMD) == HAL_OK ? 0 : -1;
 }
 
-static Component_Status oled_setpos(uint8_t column, uint8_t page)
+static int oled_spi_data(const uint8_t *data, uint32_t len)
 {
-    oled_wrcmd(0xb0 + page);
-    oled_wrcmd(((column&0xf0)>>4)|0x10);
-    oled_wrcmd((column&0x0f)|0x00);
-    return COMP_OK;
+	return SSD1306_SPI_Write_Buf(data, len, SSD1306_DATA) == HAL_OK ? 0 : -1;
 }
 
-static Component_Status oled_write(uint8_t column, uint8_t page , const uint8_t *data, uint32_t len)
+static const oled_fb_ops oled_fb_spi = {
+	oled_spi_cmd,
+	oled_spi_data,
+};
+
+/* The draws are in the framebuffer, send the changes or have the task do it */
+static void oled_show(void)
 {
-	oled_setpos(column, page);
-	oled_wrdata(data, len);
-	return COMP_OK;
+#if OLED_FB_TASK
+	oled_fb_kick();
+#else
+	oled_fb_flush();
+#endif
 }
 
 static void Oled_Reset_Io_Init()
@@ -107,7 +105,6 @@ static void Oled_Reset_Io_Init()
   */
 Component_Status DRV_Oled_Pnxm_Bmp(uint8_t column, uint8_t page, uint8_t width, uint8_t hight, const uint8_t *bmp)
 {
-	OS_MutexLock(&OLED_WR_LOCK, 1000000);
     int pages = hight / 8;
 	if ((hight % 8) > 0)
 		pages += 1;
@@ -115,40 +112,8 @@ Component_Status DRV_Oled_Pnxm_Bmp(uint8_t column, uint8_t page, uint8_t width,
 		COMPONENT_WARN("oled show bmp error\n");
 		return COMP_ERROR;
     }
-    // draw 1st page
-    page = 7 - page;
-    if (pages >= 1) {
-		oled_write(column, page, bmp, width);
-    }
-    // draw 2nd page
-    if (pages >= 2) {
-		oled_write(column, page - 1,&bmp[width], width);
-    }
-    // draw 3rd page
-    if (pages >= 3) {
-		oled_write(column, page - 2, &bmp[width * 2], width);
-    }
-    // draw 4th page
-    if (pages >= 4) {
-		oled_write(column, page - 3, &bmp[width * 3], width);
-    }
-	// draw 5th page
-	if (pages >= 5) {
-		oled_write(column, page - 4, &bmp[width *4], width);
-	}
-	// draw 6th page
-	if (pages >= 6) {
-		oled_write(column, page - 5, &bmp[width* 5], width);
-	}
-	// draw 7th page
-	if (pages >= 7) {
-		oled_write(column, page - 6, &bmp[width * 6], width);
-	}
-	// draw 8th page
-	if (pages == 8) {
-		oled_write(column, page - 7, &bmp[width * 7], width);
-	}
-	OS_MutexUnlock(&OLED_WR_LOCK);
+	oled_fb_bitmap(column, page * 8, width, pages * 8, bmp);
+	oled_show();
     return COMP_OK;
 }
 
@@ -190,19 +155,13 @@ void DRV_Oled_Reset()
   */
 Component_Status  DRV_Oled_Showchar_1608(uint8_t x, uint8_t y, uint8_t chr)
 {
-	OS_MutexLock(&OLED_WR_LOCK, 1000000);
-	const uint8_t *temp;
-	chr -= ' ';
 	if (x > 128 || y > 7) {
 		COMPONENT_WARN("oled show char error\n");
 		return COMP_ERROR;
 	}
 
-	y = 7 - y;
-	temp = &ascii_1608[chr][0];
-	oled_write(x, y, temp, 8);
-	oled_write(x, y - 1, &temp[8], 8);
-	OS_MutexUnlock(&OLED_WR_LOCK);
+	oled_fb_char(x, y * 8, chr);
+	oled_show();
 	return COMP_OK;
 }
 
@@ -221,29 +180,29 @@ Component_Status DRV_Oled_Show_Str_1608(uint8_t column, uint8_t page, const char
 	}
     const char *p = str;
     while (*p != '\0') {
-		DRV_Oled_Showchar_1608(column, page, *(p++));
+		oled_fb_char(column, page * 8, *(p++));
 		column += 8;
 		if (column > 128 || (128 - column) < 8) {
 			page += 2;
 			column = 0;
 		}
 	}
+	oled_show();
     return COMP_OK;
 }
 
 /**
   * @brief Oled show string.
   * @param column:Starting coordinates.
-  * @param page:Starting coordinates.
+  * @param page:Starting coordinates, counted from the bottom.
   * @param chr: Data
   * @param len: The len of data.
   * @retval Component_Status: The status of driver.
   */
 int DRV_Oled_P8xnstr(uint8_t column, uint8_t page, const uint8_t* str, uint8_t len)
 {
-	OS_MutexLock(&OLED_WR_LOCK, 1000000);
-	oled_write(column, page, str, len);
-	OS_MutexUnlock(&OLED_WR_LOCK);
+	oled_fb_page_write(column, 7 - page, str, len);
+	oled_show();
     return 0;
 }
 
@@ -272,10 +231,8 @@ void DRV_Oled_OnOff(int onoff)
 void DRV_Oled_Clear_Screen()
 {
 	DRV_OLDE_DBG("oled_clear_screen\n");
-	uint8_t data[128] = {0};
-	int i = 0;
-	for (i = 0; i <= 7; i++)
-    	DRV_Oled_P8xnstr(0, i, data, 128);
+	oled_fb_clear();
+	oled_show();
 }
 
 /**
@@ -295,9 +252,6 @@ void DRV_Oled_Set_Brightness(uint8_t brightness)
   */
 Component_Status  DRV_Oled_Init(Oled_Config *cfg)
 {
-	if(OS_MutexCreate(&OLED_WR_LOCK) != OS_OK)
-		COMPONENT_WARN("OS_MutexCreate error\n");
-
 	oled_t.SSD1306_SPI_ID = cfg->oled_SPI_ID;
 	oled_t.SSD1306_SPI_MCLK = cfg->oled_SPI_MCLK;
 	oled_t.SSD1306_SPI_CS = cfg->oled_SPI_CS;
@@ -314,7 +268,14 @@ Component_Status  DRV_Oled_Init(Oled_Config *cfg)
 	Oled_Reset_Io_Init();
 	DRV_Oled_Reset();
 	SSD1306_Init();
-	DRV_Oled_Clear_Screen();
+
+	if (oled_fb_init(&oled_fb_spi) != 0) {
+		COMPONENT_WARN("oled framebuffer init error\n");
+		SSD1306_SPI_DeInit();
+		return COMP_ERROR;
+	}
+	oled_fb_invalidate();	/* the display RAM is random after the reset */
+	oled_fb_flush();
 
 	COMPONENT_TRACK("end\n");
 	return COMP_OK;
@@ -326,7 +287,7 @@ Component_Status  DRV_Oled_Init(Oled_Config *cfg)
   */
 Component_Status DRV_Oled_DeInit()
 {
-	OS_MutexDelete(&OLED_WR_LOCK);
+	oled_fb_deinit();
 
 	if(SSD1306_SPI_DeInit() != HAL_OK) {
 		COMPONENT_WARN("SSD1306 SPI Deinit error\n");
@@ -30,7 +30,7 @@
 #ifndef _OLED_CHAR_LIB_H_
 #define _OLED_CHAR_LIB_H_
 
-const unsigned char ascii_1608[95][16]= {
+static const unsigned char ascii_1608[95][16]= {
 	{0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},/*" ",0*/
 
 	{0x00,0x00,0x00,0x1F,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xCC,0x0C,0x00,0x00,0x00},/*"!",1*/
@@ -223,7 +223,7 @@ const unsigned char ascii_1608[95][16]= {
 
 };
 
-const unsigned char flag[36]= {
+static const unsigned char flag[36]= {
 	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x70,0x70,0x70,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x38,0x38,0x38,0x00,0x00,0x00,0x00,/*":",0*/
 };/*":",0*/
 
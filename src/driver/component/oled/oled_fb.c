@@ -0,0 +1,507 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include "kernel/os/os.h"
+#include "driver/component/oled/oled_fb.h"
+#include "oled_char_lib.h"
+
+#define OLED_FB_SIZE			(OLED_FB_PAGES * OLED_FB_WIDTH)
+
+/* SSD1306_HV_COLUMN_ADDRESS, SSD1306_HV_PAGE_ADDRESS and their arguments */
+#define OLED_FB_COLUMN_ADDRESS	0x21
+#define OLED_FB_PAGE_ADDRESS	0x22
+#define OLED_FB_WINDOW_LEN		6
+
+#define OLED_FB_TASK_STACK		(1 * 1024)
+
+typedef struct {
+	uint8_t fb[OLED_FB_PAGES][OLED_FB_WIDTH];
+	uint8_t panel[OLED_FB_PAGES][OLED_FB_WIDTH];	/* as on the panel */
+	uint8_t tx[OLED_FB_SIZE];
+	/* columns x0 to x1 of the page were drawn, none if x0 > x1 */
+	uint8_t x0[OLED_FB_PAGES];
+	uint8_t x1[OLED_FB_PAGES];
+	uint8_t resend;			/* the panel is not known, send all */
+	const oled_fb_ops *ops;
+	OS_Mutex_t lock;		/* fb and the marks */
+	OS_Mutex_t flush_lock;	/* panel, tx and the transfers */
+	oled_fb_stat stat;
+#if OLED_FB_TASK
+	OS_Thread_t thread;
+	OS_Semaphore_t kick;
+	uint32_t period_ms;
+	volatile uint8_t run;
+#endif
+} oled_fb_t;
+
+static oled_fb_t g_fb;
+
+#define FB_LOCK()		OS_MutexLock(&g_fb.lock, OS_WAIT_FOREVER)
+#define FB_UNLOCK()		OS_MutexUnlock(&g_fb.lock)
+
+static void fb_mark(int page, int x0, int x1)
+{
+	if (x0 < g_fb.x0[page])
+		g_fb.x0[page] = x0;
+	if (x1 > g_fb.x1[page])
+		g_fb.x1[page] = x1;
+}
+
+static void fb_mark_all(void)
+{
+	memset(g_fb.x0, 0, sizeof(g_fb.x0));
+	memset(g_fb.x1, OLED_FB_WIDTH - 1, sizeof(g_fb.x1));
+}
+
+static void fb_pixel(int x, int y, oled_fb_color color)
+{
+	uint8_t *b;
+	uint8_t m;
+
+	if ((unsigned)x >= OLED_FB_WIDTH || (unsigned)y >= OLED_FB_HEIGHT)
+		return;
+
+	b = &g_fb.fb[y >> 3][x];
+	m = 0x80 >> (y & 7);
+	if (color == OLED_FB_WHITE)
+		*b |= m;
+	else if (color == OLED_FB_BLACK)
+		*b &= ~m;
+	else
+		*b ^= m;
+	fb_mark(y >> 3, x, x);
+}
+
+static void fb_fill(int x, int y, int w, int h, oled_fb_color color)
+{
+	int x1 = x + w - 1, y1 = y + h - 1;
+	int p, i;
+	uint8_t m;
+
+	if (x < 0)
+		x = 0;
+	if (y < 0)
+		y = 0;
+	if (x1 >= OLED_FB_WIDTH)
+		x1 = OLED_FB_WIDTH - 1;
+	if (y1 >= OLED_FB_HEIGHT)
+		y1 = OLED_FB_HEIGHT - 1;
+	if (x > x1 || y > y1)
+		return;
+
+	for (p = y >> 3; p <= y1 >> 3; p++) {
+		/* rows of the page in the rectangle, bit 7 is the top one */
+		m = 0xFF;
+		if (p == y >> 3)
+			m &= 0xFF >> (y & 7);
+		if (p == y1 >> 3)
+			m &= 0xFF << (7 - (y1 & 7));
+		for (i = x; i <= x1; i++) {
+			if (color == OLED_FB_WHITE)
+				g_fb.fb[p][i] |= m;
+			else if (color == OLED_FB_BLACK)
+				g_fb.fb[p][i] &= ~m;
+			else
+				g_fb.fb[p][i] ^= m;
+		}
+		fb_mark(p, x, x1);
+	}
+}
+
+static void fb_bitmap(int x, int y, int w, int h, const uint8_t *bmp)
+{
+	int c, r, n;
+
+	if ((y & 7) == 0 && (h & 7) == 0 && y >= 0 && y + h <= OLED_FB_HEIGHT) {
+		/* whole pages, copy the bytes */
+		c = x < 0 ? -x : 0;
+		n = x + w > OLED_FB_WIDTH ? OLED_FB_WIDTH - x : w;
+		if (c >= n)
+			return;
+		for (r = 0; r < h / 8; r++) {
+			memcpy(&g_fb.fb[(y >> 3) + r][x + c], &bmp[r * w + c], n - c);
+			fb_mark((y >> 3) + r, x + c, x + n - 1);
+		}
+		return;
+	}
+
+	for (c = 0; c < w; c++) {
+		for (r = 0; r < h; r++) {
+			fb_pixel(x + c, y + r, (bmp[(r >> 3) * w + c] & (0x80 >> (r & 7))) ?
+			         OLED_FB_WHITE : OLED_FB_BLACK);
+		}
+	}
+}
+
+static int fb_char(int x, int y, char c)
+{
+	if (c < ' ' || c > '~')
+		c = ' ';
+	fb_bitmap(x, y, OLED_FB_FONT_WIDTH, OLED_FB_FONT_HEIGHT, ascii_1608[c - ' ']);
+	return x + OLED_FB_FONT_WIDTH;
+}
+
+/* Send columns x0 to x1 of pages p0 to p1 of panel as one window */
+static int fb_send(int x0, int x1, int p0, int p1)
+{
+	uint8_t cmd[OLED_FB_WINDOW_LEN];
+	uint32_t n = 0;
+	int p;
+
+	/* the controller counts the pages from the bottom */
+	cmd[0] = OLED_FB_COLUMN_ADDRESS;
+	cmd[1] = x0;
+	cmd[2] = x1;
+	cmd[3] = OLED_FB_PAGE_ADDRESS;
+	cmd[4] = OLED_FB_PAGES - 1 - p1;
+	cmd[5] = OLED_FB_PAGES - 1 - p0;
+	for (p = p1; p >= p0; p--) {
+		memcpy(&g_fb.tx[n], &g_fb.panel[p][x0], x1 - x0 + 1);
+		n += x1 - x0 + 1;
+	}
+
+	g_fb.stat.windows++;
+	g_fb.stat.cmd_bytes += OLED_FB_WINDOW_LEN;
+	g_fb.stat.data_bytes += n;
+	if (g_fb.ops->cmd(cmd, OLED_FB_WINDOW_LEN) != 0 || g_fb.ops->data(g_fb.tx, n) != 0)
+		return -1;
+	return OLED_FB_WINDOW_LEN + n;
+}
+
+/**
+  * @brief Init the framebuffer, it is black.
+  * @param ops: The controller interface.
+  * @retval 0 on success, -1 on failure.
+  */
+int oled_fb_init(const oled_fb_ops *ops)
+{
+	memset(&g_fb, 0, sizeof(g_fb));
+	if (OS_MutexCreate(&g_fb.lock) != OS_OK)
+		return -1;
+	if (OS_MutexCreate(&g_fb.flush_lock) != OS_OK) {
+		OS_MutexDelete(&g_fb.lock);
+		return -1;
+	}
+	memset(g_fb.x0, OLED_FB_WIDTH, sizeof(g_fb.x0));
+	g_fb.ops = ops;
+	return 0;
+}
+
+void oled_fb_deinit(void)
+{
+#if OLED_FB_TASK
+	oled_fb_task_stop();
+#endif
+	OS_MutexDelete(&g_fb.flush_lock);
+	OS_MutexDelete(&g_fb.lock);
+	g_fb.ops = NULL;
+}
+
+void oled_fb_clear(void)
+{
+	FB_LOCK();
+	memset(g_fb.fb, 0, sizeof(g_fb.fb));
+	fb_mark_all();
+	FB_UNLOCK();
+}
+
+void oled_fb_pixel(int x, int y, oled_fb_color color)
+{
+	FB_LOCK();
+	fb_pixel(x, y, color);
+	FB_UNLOCK();
+}
+
+/**
+  * @brief Draw a line, both ends included.
+  */
+void oled_fb_line(int x0, int y0, int x1, int y1, oled_fb_color color)
+{
+	int dx = x1 > x0 ? x1 - x0 : x0 - x1;
+	int dy = y1 > y0 ? y0 - y1 : y1 - y0;
+	int sx = x0 < x1 ? 1 : -1;
+	int sy = y0 < y1 ? 1 : -1;
+	int err = dx + dy, e2;
+
+	FB_LOCK();
+	if (y0 == y1 || x0 == x1) {
+		fb_fill(x0 < x1 ? x0 : x1, y0 < y1 ? y0 : y1, dx + 1, 1 - dy, color);
+		FB_UNLOCK();
+		return;
+	}
+	for (;;) {
+		fb_pixel(x0, y0, color);
+		if (x0 == x1 && y0 == y1)
+			break;
+		e2 = 2 * err;
+		if (e2 >= dy) {
+			err += dy;
+			x0 += sx;
+		}
+		if (e2 <= dx) {
+			err += dx;
+			y0 += sy;
+		}
+	}
+	FB_UNLOCK();
+}
+
+void oled_fb_rect(int x, int y, int w, int h, oled_fb_color color)
+{
+	if (w <= 0 || h <= 0)
+		return;
+
+	FB_LOCK();
+	fb_fill(x, y, w, 1, color);
+	if (h > 1)
+		fb_fill(x, y + h - 1, w, 1, color);
+	if (h > 2) {
+		fb_fill(x, y + 1, 1, h - 2, color);
+		if (w > 1)
+			fb_fill(x + w - 1, y + 1, 1, h - 2, color);
+	}
+	FB_UNLOCK();
+}
+
+void oled_fb_fill_rect(int x, int y, int w, int h, oled_fb_color color)
+{
+	FB_LOCK();
+	fb_fill(x, y, w, h, color);
+	FB_UNLOCK();
+}
+
+void oled_fb_bitmap(int x, int y, int w, int h, const uint8_t *bmp)
+{
+	FB_LOCK();
+	fb_bitmap(x, y, w, h, bmp);
+	FB_UNLOCK();
+}
+
+void oled_fb_page_write(int x, int page, const uint8_t *data, int len)
+{
+	if ((unsigned)page >= OLED_FB_PAGES || x < 0 || x >= OLED_FB_WIDTH || len <= 0)
+		return;
+	if (len > OLED_FB_WIDTH - x)
+		len = OLED_FB_WIDTH - x;
+
+	FB_LOCK();
+	memcpy(&g_fb.fb[page][x], data, len);
+	fb_mark(page, x, x + len - 1);
+	FB_UNLOCK();
+}
+
+int oled_fb_char(int x, int y, char c)
+{
+	FB_LOCK();
+	x = fb_char(x, y, c);
+	FB_UNLOCK();
+	return x;
+}
+
+int oled_fb_text(int x, int y, const char *str)
+{
+	FB_LOCK();
+	while (*str != '\0')
+		x = fb_char(x, y, *str++);
+	FB_UNLOCK();
+	return x;
+}
+
+/**
+  * @brief Send the drawn bytes that differ from the panel. They go in one
+  *        window around all of them, or a window per page when the pages
+  *        are far apart and that sends less.
+  * @retval The bytes sent, commands included, or -1 on error.
+  */
+int oled_fb_flush(void)
+{
+	uint8_t x0[OLED_FB_PAGES], x1[OLED_FB_PAGES];
+	int p, a, b, p0 = -1, p1 = -1, c0 = OLED_FB_WIDTH, c1 = -1;
+	int split = 0, box, n, ret = 0;
+
+	if (g_fb.ops == NULL)
+		return -1;
+
+	OS_MutexLock(&g_fb.flush_lock, OS_WAIT_FOREVER);
+
+	/* take the changes, the draws go on while they are sent */
+	FB_LOCK();
+	for (p = 0; p < OLED_FB_PAGES; p++) {
+		a = g_fb.x0[p];
+		b = g_fb.x1[p];
+		g_fb.x0[p] = OLED_FB_WIDTH;
+		g_fb.x1[p] = 0;
+		if (g_fb.resend) {
+			a = 0;
+			b = OLED_FB_WIDTH - 1;
+		} else {
+			while (a <= b && g_fb.fb[p][a] == g_fb.panel[p][a])
+				a++;
+			while (a <= b && g_fb.fb[p][b] == g_fb.panel[p][b])
+				b--;
+		}
+		x0[p] = a;
+		x1[p] = b;
+		if (a > b)
+			continue;
+		memcpy(&g_fb.panel[p][a], &g_fb.fb[p][a], b - a + 1);
+		if (p0 < 0)
+			p0 = p;
+		p1 = p;
+		if (a < c0)
+			c0 = a;
+		if (b > c1)
+			c1 = b;
+		split += OLED_FB_WINDOW_LEN + b - a + 1;
+	}
+	g_fb.resend = 0;
+	FB_UNLOCK();
+
+	if (p0 < 0) {
+		g_fb.stat.clean++;
+		OS_MutexUnlock(&g_fb.flush_lock);
+		return 0;
+	}
+
+	box = OLED_FB_WINDOW_LEN + (p1 - p0 + 1) * (c1 - c0 + 1);
+	if (box <= split) {
+		ret = fb_send(c0, c1, p0, p1);
+	} else {
+		for (p = p0; p <= p1 && ret >= 0; p++) {
+			if (x0[p] > x1[p])
+				continue;
+			n = fb_send(x0[p], x1[p], p, p);
+			ret = n < 0 ? n : ret + n;
+		}
+	}
+
+	if (ret < 0) {
+		g_fb.resend = 1;	/* the panel may be anything now */
+	} else {
+		g_fb.stat.flushes++;
+		if (ret > g_fb.stat.max_bytes)
+			g_fb.stat.max_bytes = ret;
+	}
+	OS_MutexUnlock(&g_fb.flush_lock);
+	return ret;
+}
+
+void oled_fb_invalidate(void)
+{
+	FB_LOCK();
+	g_fb.resend = 1;
+	fb_mark_all();
+	FB_UNLOCK();
+}
+
+void oled_fb_read(uint8_t *buf)
+{
+	FB_LOCK();
+	memcpy(buf, g_fb.fb, sizeof(g_fb.fb));
+	FB_UNLOCK();
+}
+
+void oled_fb_get_stat(oled_fb_stat *stat, int reset)
+{
+	OS_MutexLock(&g_fb.flush_lock, OS_WAIT_FOREVER);
+	if (stat)
+		*stat = g_fb.stat;
+	if (reset)
+		memset(&g_fb.stat, 0, sizeof(g_fb.stat));
+	OS_MutexUnlock(&g_fb.flush_lock);
+}
+
+#if OLED_FB_TASK
+static void oled_fb_task(void *arg)
+{
+	uint32_t last = OS_TicksToMSecs(OS_GetTicks()) - g_fb.period_ms;
+	uint32_t wait;
+
+	while (g_fb.run) {
+		if (OS_SemaphoreWait(&g_fb.kick, OS_WAIT_FOREVER) != OS_OK || !g_fb.run)
+			continue;
+		/* the draws of the wait go in the same flush */
+		wait = OS_TicksToMSecs(OS_GetTicks()) - last;
+		if (wait < g_fb.period_ms)
+			OS_MSleep(g_fb.period_ms - wait);
+		last = OS_TicksToMSecs(OS_GetTicks());
+		oled_fb_flush();
+	}
+
+	OS_ThreadDelete(&g_fb.thread);
+}
+
+/**
+  * @brief Start the flush task.
+  * @param max_fps: The most flushes a second.
+  * @retval 0 on success, -1 on failure.
+  */
+int oled_fb_task_start(uint32_t max_fps)
+{
+	if (g_fb.run || max_fps == 0)
+		return -1;
+
+	if (OS_SemaphoreCreateBinary(&g_fb.kick) != OS_OK)
+		return -1;
+	g_fb.period_ms = 1000 / max_fps;
+	g_fb.run = 1;
+	if (OS_ThreadCreate(&g_fb.thread, "oled_fb", oled_fb_task, NULL,
+	                    OS_THREAD_PRIO_APP, OLED_FB_TASK_STACK) != OS_OK) {
+		g_fb.run = 0;
+		OS_SemaphoreDelete(&g_fb.kick);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+  * @brief Stop the flush task, what was drawn is flushed.
+  */
+void oled_fb_task_stop(void)
+{
+	if (!g_fb.run)
+		return;
+
+	g_fb.run = 0;
+	OS_SemaphoreRelease(&g_fb.kick);
+	while (OS_ThreadIsValid(&g_fb.thread))
+		OS_MSleep(1);
+	OS_SemaphoreDelete(&g_fb.kick);
+	oled_fb_flush();
+}
+
+void oled_fb_kick(void)
+{
+	if (g_fb.run)
+		OS_SemaphoreRelease(&g_fb.kick);
+	else
+		oled_fb_flush();
+}
+#endif /* OLED_FB_TASK */
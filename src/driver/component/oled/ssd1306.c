@@ -68,6 +68,24 @@ HAL_Status SSD1306_SPI_Write(uint8_t data, SSD1306_WR_MODE mode)
 	return sta;
 }
 
+/* len bytes in one transfer, by DMA */
+HAL_Status SSD1306_SPI_Write_Buf(const uint8_t *data, uint32_t len, SSD1306_WR_MODE mode)
+{
+	OS_MutexLock(&SSD1306_SPI_WR_LOCK, 10000000);
+	HAL_Status sta;
+	if(mode == SSD1306_CMD) {
+		HAL_GPIO_WritePin(SSD1306_dsPort, SSD1306_dsPin, GPIO_PIN_LOW);
+	} else if(mode == SSD1306_DATA) {
+		HAL_GPIO_WritePin(SSD1306_dsPort, SSD1306_dsPin, GPIO_PIN_HIGH);
+	}
+	sta = HAL_SPI_Transmit(SSD1306_SPI_ID, (uint8_t *)data, len);
+	if (sta != HAL_OK)
+		COMPONENT_WARN("spi write error error %d\n", sta);
+
+	OS_MutexUnlock(&SSD1306_SPI_WR_LOCK);
+	return sta;
+}
+
 HAL_Status SSD1306_SPI_Init(SSD1306_t *SSD1306config)
 {
 	SPI_Global_Config gconfig;
@@ -83,7 +101,7 @@ HAL_Status SSD1306_SPI_Init(SSD1306_t *SSD1306config)
 	SPI_Config spi_Config;
 	spi_Config.firstBit = SPI_TCTRL_FBS_MSB;
 	spi_Config.mode = SPI_CTRL_MODE_MASTER;
-	spi_Config.opMode = SPI_OPERATION_MODE_POLL;
+	spi_Config.opMode = SPI_OPERATION_MODE_DMA;
 	spi_Config.sclk = SSD1306config->SSD1306_SPI_MCLK;
 	spi_Config.sclkMode = SPI_SCLK_Mode0;
 
@@ -148,7 +166,7 @@ void SSD1306_Init(SSD1306_t *SSD1306config)
 	SSD1306_SPI_Write(SSD1306_ENABLE_CHARGE_PUMP, SSD1306_CMD);
 	SSD1306_SPI_Write(0x14, SSD1306_CMD);
 	SSD1306_SPI_Write(SSD1306_MEMORYMODE, SSD1306_CMD);
-	SSD1306_SPI_Write(0x02, SSD1306_CMD);
+	SSD1306_SPI_Write(0x00, SSD1306_CMD); //horizontal, for the windows of oled_fb
 	SSD1306_SPI_Write(0xA1, SSD1306_CMD);
 	SSD1306_SPI_Write(SSD1306_COMSCANINC, SSD1306_CMD);
 	SSD1306_SPI_Write(SSD1306_SETCOMPINS, SSD1306_CMD);
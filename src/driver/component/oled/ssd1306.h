@@ -101,6 +101,7 @@ typedef struct {
 
 HAL_Status SSD1306_SPI_Init(SSD1306_t *SSD1306config);
 HAL_Status SSD1306_SPI_DeInit();
+HAL_Status SSD1306_SPI_Write_Buf(const uint8_t *data, uint32_t len, SSD1306_WR_MODE mode);
 void SSD1306_Init();
 void SSD1306_set_brightness(uint8_t brightness);
 
@@ -0,0 +1,347 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Linux benchmark of jpeg_enc.c. Synthetic YUYV frames of a moving scene
+ * with sensor noise are made strip by strip into a ring of two strips, the
+ * way the CSI DMA fills it, and encoded from there. Each frame is decoded
+ * again with libjpeg and compared to the source, and the report has the
+ * encode rate, the compressed sizes, the PSNR and the RAM of the strip
+ * path next to a whole raw frame. The last frame of each run is written
+ * to <dir>/ov7670_<run>.jpg.
+ *
+ *   ./run.sh [dir]
+ *
+ * The rates are of the host, on the Cortex-M4 they are a fraction of it.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <jpeglib.h>
+
+#include "driver/component/ov7670/jpeg_enc.h"
+#include "driver/component/ov7670/cam_stream.h"
+
+#define FRAMES			60
+#define RING_STRIPS		2
+#define OUT_MAX			(64 * 1024)
+#define UART_BAUD		115200
+
+struct out {
+	uint8_t buf[OUT_MAX];
+	uint32_t len;
+};
+
+struct run {
+	const char *name;
+	uint16_t width, height;
+	jpeg_enc_format format;
+	uint8_t quality;
+	double min_psnr;
+};
+
+static const struct run runs[] = {
+	{ "qvga_q30",  320, 240, JPEG_ENC_YUYV,   30, 30.0 },
+	{ "qvga_q50",  320, 240, JPEG_ENC_YUYV,   50, 32.0 },
+	{ "qvga_q80",  320, 240, JPEG_ENC_YUYV,   80, 35.0 },
+	{ "qvga_rgb",  320, 240, JPEG_ENC_RGB565, 50, 30.0 },
+	{ "vga_q50",   640, 480, JPEG_ENC_YUYV,   50, 32.0 },
+	{ "qcif_q50",  176, 144, JPEG_ENC_YUYV,   50, 32.0 },
+	{ "odd_q50",   200, 150, JPEG_ENC_YUYV,   50, 32.0 },
+};
+
+static struct out out;
+static uint32_t errors;
+
+static int out_write(void *arg, const uint8_t *data, uint32_t len)
+{
+	struct out *o = arg;
+
+	if (o->len + len > OUT_MAX)
+		return -1;
+	memcpy(o->buf + o->len, data, len);
+	o->len += len;
+	return 0;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint8_t clamp8(int v)
+{
+	return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+/*
+ * The scene: a gradient, colour bars, a grid, a ball that moves and
+ * +-4 of noise, in Y, U and V of pixel x of line y.
+ */
+static void scene(int w, int h, int frame, int x, int y, int *py, int *pu, int *pv)
+{
+	static const uint8_t bars[8][3] = {
+		{ 235, 128, 128 }, { 210,  16, 146 }, { 170, 166,  16 }, { 145,  54,  34 },
+		{ 106, 202, 222 }, {  81,  90, 240 }, {  41, 240, 110 }, {  16, 128, 128 },
+	};
+	uint32_t n = (x * 73856093u) ^ (y * 19349663u) ^ (frame * 83492791u);
+	int cx = (w / 4) + ((frame * 5) % (w / 2));
+	int cy = h / 2 + (h / 5) * ((frame / 8) % 2 ? 1 : -1);
+	int r = h / 8;
+	int dx = x - cx, dy = y - cy;
+
+	n = (n ^ (n >> 13)) * 0x5bd1e995u;
+	if (y < h / 4) {
+		const uint8_t *b = bars[(x * 8) / w];
+		*py = b[0];
+		*pu = b[1];
+		*pv = b[2];
+	} else if (y > (h * 3) / 4) {
+		*py = ((x / 8 + y / 8 + frame / 4) & 1) ? 200 : 60;
+		*pu = 128;
+		*pv = 128;
+	} else {
+		*py = 40 + (x * 160) / w + (y - h / 4) / 4;
+		*pu = 100 + (y * 40) / h;
+		*pv = 150 - (x * 40) / w;
+	}
+	if (dx * dx + dy * dy < r * r) {
+		*py = 220;
+		*pu = 90;
+		*pv = 200;
+	}
+	*py = clamp8(*py + (int)(n >> 29) - 4);
+}
+
+/* Line y in the format of the run, as the sensor sends it */
+static void make_line(const struct run *rn, int frame, int y, uint8_t *line)
+{
+	int x, i, Y[2], U[2], V[2], u, v, r, g, b;
+	uint16_t px;
+
+	for (x = 0; x < rn->width; x += 2) {
+		for (i = 0; i < 2; i++)
+			scene(rn->width, rn->height, frame, x + i, y, &Y[i], &U[i], &V[i]);
+		u = (U[0] + U[1] + 1) / 2;
+		v = (V[0] + V[1] + 1) / 2;
+		if (rn->format == JPEG_ENC_YUYV) {
+			line[x * 2 + 0] = Y[0];
+			line[x * 2 + 1] = u;
+			line[x * 2 + 2] = Y[1];
+			line[x * 2 + 3] = v;
+			continue;
+		}
+		for (i = 0; i < 2; i++) {
+			r = clamp8(Y[i] + (91881 * (v - 128) >> 16));
+			g = clamp8(Y[i] - ((22554 * (u - 128) + 46802 * (v - 128)) >> 16));
+			b = clamp8(Y[i] + (116130 * (u - 128) >> 16));
+			px = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+			line[(x + i) * 2 + 0] = px >> 8;
+			line[(x + i) * 2 + 1] = px;
+		}
+	}
+}
+
+/* Y of line y as the encoder sees it */
+static void ref_luma(const struct run *rn, const uint8_t *line, uint8_t *luma)
+{
+	int x, r, g, b;
+	uint16_t px;
+
+	for (x = 0; x < rn->width; x++) {
+		if (rn->format == JPEG_ENC_YUYV) {
+			luma[x] = line[x * 2];
+			continue;
+		}
+		px = (line[x * 2] << 8) | line[x * 2 + 1];
+		r = (px >> 8) & 0xf8;
+		g = (px >> 3) & 0xfc;
+		b = (px << 3) & 0xf8;
+		r |= r >> 5;
+		g |= g >> 6;
+		b |= b >> 5;
+		luma[x] = (19595 * r + 38470 * g + 7471 * b + 32768) >> 16;
+	}
+}
+
+/* Decode out and return the PSNR of Y against ref, -1 on a decode error */
+static double check_frame(const struct run *rn, const uint8_t *ref)
+{
+	struct jpeg_decompress_struct cinfo;
+	struct jpeg_error_mgr jerr;
+	uint8_t *row = malloc(rn->width * 3);
+	JSAMPROW rows[1] = { row };
+	double se = 0;
+	int x, y = 0;
+
+	cinfo.err = jpeg_std_error(&jerr);
+	jpeg_create_decompress(&cinfo);
+	jpeg_mem_src(&cinfo, out.buf, out.len);
+	if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK ||
+	    cinfo.image_width != rn->width || cinfo.image_height != rn->height) {
+		jpeg_destroy_decompress(&cinfo);
+		free(row);
+		return -1;
+	}
+	cinfo.out_color_space = JCS_YCbCr;
+	jpeg_start_decompress(&cinfo);
+	while (cinfo.output_scanline < cinfo.output_height) {
+		jpeg_read_scanlines(&cinfo, rows, 1);
+		for (x = 0; x < rn->width; x++) {
+			double d = (double)row[x * 3] - ref[y * rn->width + x];
+			se += d * d;
+		}
+		y++;
+	}
+	jpeg_finish_decompress(&cinfo);
+	jpeg_destroy_decompress(&cinfo);
+	free(row);
+
+	se /= (double)rn->width * rn->height;
+	return se > 0 ? 10 * log10(255.0 * 255.0 / se) : 99.0;
+}
+
+static void bench(const struct run *rn, const char *dir)
+{
+	uint32_t stride = rn->width * 2;
+	uint32_t strip = stride * JPEG_ENC_STRIP_LINES;
+	uint8_t *ring = malloc(strip * RING_STRIPS);
+	uint8_t *ref = malloc(rn->width * rn->height);
+	jpeg_enc_cfg cfg = {
+		.width = rn->width,
+		.height = rn->height,
+		.format = rn->format,
+		.quality = rn->quality,
+		.write = out_write,
+		.arg = &out,
+	};
+	jpeg_enc *enc = jpeg_enc_create(&cfg);
+	uint32_t min = ~0u, max = 0, ram;
+	double sum = 0, t, enc_s = 0, psnr, min_psnr = 99;
+	int frame, y, n, s, bad = 0;
+	char path[256];
+	FILE *f;
+
+	if (enc == NULL) {
+		printf("%-9s jpeg_enc_create failed\n", rn->name);
+		errors++;
+		return;
+	}
+
+	for (frame = 0; frame < FRAMES; frame++) {
+		out.len = 0;
+		t = now();
+		jpeg_enc_frame_start(enc);
+		enc_s += now() - t;
+		for (y = 0, s = 0; y < rn->height; y += n, s++) {
+			uint8_t *slot = ring + (s % RING_STRIPS) * strip;
+			int i;
+
+			n = rn->height - y;
+			if (n > JPEG_ENC_STRIP_LINES)
+				n = JPEG_ENC_STRIP_LINES;
+			for (i = 0; i < n; i++) {
+				make_line(rn, frame, y + i, slot + i * stride);
+				ref_luma(rn, slot + i * stride, ref + (y + i) * rn->width);
+			}
+			t = now();
+			if (jpeg_enc_strip(enc, slot, stride, n) != 0)
+				bad++;
+			enc_s += now() - t;
+		}
+		t = now();
+		if (jpeg_enc_frame_end(enc) != 0 || jpeg_enc_frame_size(enc) != out.len)
+			bad++;
+		enc_s += now() - t;
+
+		sum += out.len;
+		if (out.len < min)
+			min = out.len;
+		if (out.len > max)
+			max = out.len;
+		psnr = check_frame(rn, ref);
+		if (psnr < rn->min_psnr)
+			bad++;
+		if (psnr < min_psnr)
+			min_psnr = psnr;
+	}
+
+	snprintf(path, sizeof(path), "%s/ov7670_%s.jpg", dir, rn->name);
+	f = fopen(path, "wb");
+	if (f) {
+		fwrite(out.buf, 1, out.len, f);
+		fclose(f);
+	}
+
+	/* encoder, two strips and the biggest frame, against one raw frame */
+	ram = jpeg_enc_mem_size() + strip * RING_STRIPS + max;
+	printf("%-9s %4ux%-4u q%-3u %7.1f %6.2f %7.1f %6u %6u %5.2f %6.1f %7u %7u %7.2f %s\n",
+	       rn->name, rn->width, rn->height, rn->quality,
+	       FRAMES / enc_s, enc_s * 1000 / FRAMES, sum / FRAMES / 1024.0, min, max,
+	       sum * 8 / FRAMES / ((double)rn->width * rn->height), min_psnr,
+	       ram, stride * rn->height,
+	       sum / FRAMES * 10 / UART_BAUD, bad ? "FAIL" : "ok");
+	if (bad)
+		errors++;
+
+	jpeg_enc_destroy(enc);
+	free(ring);
+	free(ref);
+}
+
+int main(int argc, char **argv)
+{
+	const char *dir = argc > 1 ? argv[1] : "/tmp";
+	cam_stream_cfg cam = CAM_STREAM_CFG_DEFAULT;
+	uint32_t i;
+
+	printf("%u frames a run, encoder context %u bytes, %u strips of %u lines\n\n",
+	       FRAMES, jpeg_enc_mem_size(), RING_STRIPS, JPEG_ENC_STRIP_LINES);
+	printf("%-9s %-9s %-4s %7s %6s %7s %6s %6s %5s %6s %7s %7s %7s\n",
+	       "run", "size", "q", "fps", "ms", "avg_KB", "min_B", "max_B", "bpp",
+	       "PSNR", "RAM_B", "raw_B", "uart_s");
+	for (i = 0; i < sizeof(runs) / sizeof(runs[0]); i++)
+		bench(&runs[i], dir);
+
+	printf("\ncam_stream at QVGA, %u strips and %u frames of %u bytes: %u bytes\n",
+	       cam.strip_num, cam.frame_num, cam.frame_size,
+	       jpeg_enc_mem_size() + cam.strip_num * cam.width * 2 * JPEG_ENC_STRIP_LINES +
+	       cam.frame_num * (uint32_t)(sizeof(cam_stream_frame) + cam.frame_size));
+	printf("raw QVGA frame over the UART at %u baud: %.2f s\n",
+	       UART_BAUD, 320 * 240 * 2 * 10.0 / UART_BAUD);
+	printf("%s\n", errors ? "FAIL" : "PASS");
+	return errors ? 1 : 0;
+}
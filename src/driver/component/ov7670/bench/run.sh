@@ -0,0 +1,11 @@
+#!/bin/sh
+#
+# Build jpeg_bench.c with jpeg_enc.c and libjpeg to check the output, and
+# run it. The JPEG files of the last frames go to the directory of the
+# first argument, /tmp by default.
+#
+set -e
+cd "$(dirname "$0")"
+gcc -O2 -Wall -I../../../../../include \
+	jpeg_bench.c ../jpeg_enc.c -ljpeg -lm -o /tmp/jpeg_bench
+/tmp/jpeg_bench "${1:-/tmp}"
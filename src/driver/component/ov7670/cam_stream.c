@@ -0,0 +1,413 @@
+/**
+  * @file  cam_stream.c
+  * @author  XRADIO IOT WLAN Team
+  */
+
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "kernel/os/os.h"
+#include "driver/chip/hal_rtc.h"
+#include "driver/component/ov7670/drv_ov7670.h"
+#include "driver/component/ov7670/cam_stream.h"
+
+#define CAM_STREAM_TASK_STACK	(2 * 1024)
+
+enum {
+	CAM_MSG_STRIP = 0,
+	CAM_MSG_FRAME,
+};
+
+enum {
+	CAM_FRAME_FREE = 0,
+	CAM_FRAME_ENCODING,
+	CAM_FRAME_READY,
+};
+
+typedef struct {
+	uint8_t type;
+	uint8_t drop;
+	uint32_t index;
+	uint32_t len;
+} cam_stream_msg;
+
+typedef struct {
+	cam_stream_cfg cfg;
+	uint32_t stride;
+	uint32_t strip_size;
+	uint8_t *strips;
+	cam_stream_frame *frames;
+	jpeg_enc *enc;
+
+	/* the frame of the encoder */
+	cam_stream_frame *cur;
+	uint8_t in_frame;
+	uint8_t too_big;
+	uint32_t enc_us;
+
+	uint32_t seq;			/* of the newest frame in the queue */
+	uint32_t waiters;		/* readers waiting for ready */
+	OS_Mutex_t lock;		/* frames, seq, waiters and stat */
+	OS_Semaphore_t ready;
+	OS_Queue_t queue;		/* messages of the capture interrupt */
+	OS_Thread_t thread;
+	volatile uint8_t run;
+	cam_stream_stat stat;
+} cam_stream_t;
+
+static cam_stream_t g_cam;
+
+#define CAM_LOCK()		OS_MutexLock(&g_cam.lock, OS_WAIT_FOREVER)
+#define CAM_UNLOCK()	OS_MutexUnlock(&g_cam.lock)
+
+/* In the interrupt of the capture */
+
+static void cam_strip_done(uint32_t index, uint32_t len, void *arg)
+{
+	cam_stream_msg msg = { CAM_MSG_STRIP, 0, index, len };
+
+	OS_QueueSend(&g_cam.queue, &msg, 0);
+}
+
+static void cam_frame_done(uint32_t len, int drop, void *arg)
+{
+	cam_stream_msg msg = { CAM_MSG_FRAME, drop, 0, len };
+
+	OS_QueueSend(&g_cam.queue, &msg, 0);
+}
+
+/* In the task */
+
+static int cam_write(void *arg, const uint8_t *data, uint32_t len)
+{
+	cam_stream_frame *f = g_cam.cur;
+
+	if (f->len + len > g_cam.cfg.frame_size) {
+		g_cam.too_big = 1;
+		return -1;
+	}
+	memcpy(f->data + f->len, data, len);
+	f->len += len;
+	return 0;
+}
+
+/* A free frame, or the oldest one in the queue that nobody holds */
+static cam_stream_frame *cam_frame_take(void)
+{
+	cam_stream_frame *f, *pick = NULL;
+	uint32_t i;
+
+	CAM_LOCK();
+	for (i = 0; i < g_cam.cfg.frame_num; i++) {
+		f = &g_cam.frames[i];
+		if (f->state == CAM_FRAME_FREE) {
+			pick = f;
+			break;
+		}
+		if (f->state == CAM_FRAME_READY && f->refs == 0 && f->seq != g_cam.seq &&
+		    (pick == NULL || f->seq < pick->seq))
+			pick = f;
+	}
+	if (pick) {
+		pick->state = CAM_FRAME_ENCODING;
+		pick->len = 0;
+	}
+	CAM_UNLOCK();
+
+	return pick;
+}
+
+static void cam_stream_strip(const cam_stream_msg *msg)
+{
+	uint8_t *strip = g_cam.strips + (msg->index % g_cam.cfg.strip_num) * g_cam.strip_size;
+	uint32_t t = (uint32_t)HAL_RTC_GetFreeRunTime();
+
+	if (!g_cam.in_frame) {
+		g_cam.in_frame = 1;
+		g_cam.too_big = 0;
+		g_cam.enc_us = 0;
+		g_cam.cur = cam_frame_take();
+		if (g_cam.cur)
+			jpeg_enc_frame_start(g_cam.enc);
+	}
+	if (g_cam.cur)
+		jpeg_enc_strip(g_cam.enc, strip, g_cam.stride, msg->len / g_cam.stride);
+	Drv_Ov7670_Strip_Release(1);
+
+	g_cam.enc_us += (uint32_t)HAL_RTC_GetFreeRunTime() - t;
+}
+
+static void cam_stream_frame_end(const cam_stream_msg *msg)
+{
+	cam_stream_frame *f = g_cam.cur;
+	cam_stream_stat *st = &g_cam.stat;
+	int ok = 0;
+
+	if (f && !msg->drop)
+		ok = (jpeg_enc_frame_end(g_cam.enc) == 0);
+
+	CAM_LOCK();
+	st->frames++;
+	if (ok) {
+		f->seq = ++g_cam.seq;
+		f->ticks = OS_GetTicks();
+		f->state = CAM_FRAME_READY;
+		st->encoded++;
+		st->bytes += f->len;
+		if (f->len > st->max_len)
+			st->max_len = f->len;
+		st->enc_us += g_cam.enc_us;
+		if (g_cam.enc_us > st->enc_us_max)
+			st->enc_us_max = g_cam.enc_us;
+		while (g_cam.waiters) {
+			g_cam.waiters--;
+			OS_SemaphoreRelease(&g_cam.ready);
+		}
+	} else {
+		if (f)
+			f->state = CAM_FRAME_FREE;
+		if (msg->drop || !g_cam.in_frame)
+			st->drop_ring++;
+		else if (f == NULL)
+			st->drop_busy++;
+		else if (g_cam.too_big)
+			st->drop_size++;
+		else
+			st->drop_ring++;
+	}
+	CAM_UNLOCK();
+
+	g_cam.cur = NULL;
+	g_cam.in_frame = 0;
+}
+
+static void cam_stream_task(void *arg)
+{
+	cam_stream_msg msg;
+
+	while (g_cam.run) {
+		if (OS_QueueReceive(&g_cam.queue, &msg, 100) != OS_OK)
+			continue;
+		if (msg.type == CAM_MSG_STRIP)
+			cam_stream_strip(&msg);
+		else
+			cam_stream_frame_end(&msg);
+	}
+
+	OS_ThreadDelete(&g_cam.thread);
+}
+
+static void cam_stream_free(void)
+{
+	if (g_cam.enc)
+		jpeg_enc_destroy(g_cam.enc);
+	if (g_cam.frames)
+		free(g_cam.frames);
+	if (g_cam.strips)
+		free(g_cam.strips);
+	if (OS_QueueIsValid(&g_cam.queue))
+		OS_QueueDelete(&g_cam.queue);
+	if (OS_SemaphoreIsValid(&g_cam.ready))
+		OS_SemaphoreDelete(&g_cam.ready);
+	if (OS_MutexIsValid(&g_cam.lock))
+		OS_MutexDelete(&g_cam.lock);
+	memset(&g_cam, 0, sizeof(g_cam));
+}
+
+/**
+  * @brief Start the capture and the encoder task.
+  * @note The camera is initialized, the format and the clock divider of
+  *           cfg are set here.
+  * @param cfg: The pipeline config, CAM_STREAM_CFG_DEFAULT for QVGA.
+  * @retval 0 on success, -1 on failure.
+  */
+int cam_stream_start(const cam_stream_cfg *cfg)
+{
+	jpeg_enc_cfg enc_cfg;
+	Ov7670_StripCfg strip_cfg;
+	uint8_t *buf;
+	uint32_t i;
+
+	if (g_cam.run || cfg->strip_num < 2 || cfg->frame_num < 2 || cfg->frame_size == 0)
+		return -1;
+
+	memset(&g_cam, 0, sizeof(g_cam));
+	g_cam.cfg = *cfg;
+	g_cam.stride = cfg->width * 2;
+	g_cam.strip_size = g_cam.stride * JPEG_ENC_STRIP_LINES;
+
+	enc_cfg.width = cfg->width;
+	enc_cfg.height = cfg->height;
+	enc_cfg.format = cfg->yuv ? JPEG_ENC_YUYV : JPEG_ENC_RGB565;
+	enc_cfg.quality = cfg->quality;
+	enc_cfg.write = cam_write;
+	enc_cfg.arg = NULL;
+	g_cam.enc = jpeg_enc_create(&enc_cfg);
+	g_cam.strips = malloc(g_cam.strip_size * cfg->strip_num);
+	g_cam.frames = malloc((sizeof(cam_stream_frame) + cfg->frame_size) * cfg->frame_num);
+	if (g_cam.enc == NULL || g_cam.strips == NULL || g_cam.frames == NULL)
+		goto err;
+
+	buf = (uint8_t *)&g_cam.frames[cfg->frame_num];
+	for (i = 0; i < cfg->frame_num; i++) {
+		memset(&g_cam.frames[i], 0, sizeof(cam_stream_frame));
+		g_cam.frames[i].data = buf + i * cfg->frame_size;
+	}
+	g_cam.stat.ram = jpeg_enc_mem_size() + g_cam.strip_size * cfg->strip_num +
+	                 (sizeof(cam_stream_frame) + cfg->frame_size) * cfg->frame_num;
+
+	/* room for every strip of the ring and a few frame ends */
+	if (OS_QueueCreate(&g_cam.queue, cfg->strip_num + 4, sizeof(cam_stream_msg)) != OS_OK ||
+	    OS_SemaphoreCreate(&g_cam.ready, 0, OS_SEMAPHORE_MAX_COUNT) != OS_OK ||
+	    OS_MutexCreate(&g_cam.lock) != OS_OK)
+		goto err;
+
+	Drv_OV7670_Output_Format(cfg->yuv ? OV7670_OUTPUT_YUV422 : OV7670_OUTPUT_RGB565);
+	Drv_OV7670_Clock_Div(cfg->clk_div);
+
+	strip_cfg.buf = g_cam.strips;
+	strip_cfg.strip_size = g_cam.strip_size;
+	strip_cfg.strip_num = cfg->strip_num;
+	strip_cfg.strip_done = cam_strip_done;
+	strip_cfg.frame_done = cam_frame_done;
+	strip_cfg.arg = NULL;
+	if (Drv_Ov7670_Set_Strip_Buff(&strip_cfg) != COMP_OK)
+		goto err;
+
+	g_cam.run = 1;
+	if (OS_ThreadCreate(&g_cam.thread, "cam_stream", cam_stream_task, NULL,
+	                    OS_THREAD_PRIO_APP, CAM_STREAM_TASK_STACK) != OS_OK) {
+		g_cam.run = 0;
+		Drv_Ov7670_Set_Strip_Buff(NULL);
+		goto err;
+	}
+
+	HAL_CSI_Moudle_Enalbe(CSI_ENABLE);
+	Drv_Ov7670_Capture_Enable(CSI_VIDEO_MODE, CSI_ENABLE);
+	return 0;
+
+err:
+	COMPONENT_WARN("cam stream start failed\n");
+	cam_stream_free();
+	return -1;
+}
+
+/**
+  * @brief Stop the capture and the task.
+  * @note The readers must have put their frames back and stopped reading.
+  */
+void cam_stream_stop(void)
+{
+	if (!g_cam.run)
+		return;
+
+	Drv_Ov7670_Capture_Enable(CSI_VIDEO_MODE, CSI_DISABLE);
+	Drv_Ov7670_Set_Strip_Buff(NULL);
+	g_cam.run = 0;
+	while (OS_ThreadIsValid(&g_cam.thread))
+		OS_MSleep(1);
+	cam_stream_free();
+}
+
+int cam_stream_set_quality(uint8_t quality)
+{
+	if (!g_cam.run)
+		return -1;
+	return jpeg_enc_set_quality(g_cam.enc, quality);
+}
+
+/**
+  * @brief Get the newest frame in the queue.
+  * @param seq: The seq of the frame had before, 0 for any.
+  * @param timeout_ms: How long to wait for a frame newer than seq.
+  * @retval The frame, to give back with cam_stream_put(), NULL on timeout.
+  */
+cam_stream_frame *cam_stream_get(uint32_t seq, uint32_t timeout_ms)
+{
+	cam_stream_frame *f = NULL;
+	uint32_t end = OS_GetTicks() + OS_MSecsToTicks(timeout_ms);
+	uint32_t i, wait;
+
+	if (!g_cam.run)
+		return NULL;
+
+	CAM_LOCK();
+	while (1) {
+		for (i = 0; i < g_cam.cfg.frame_num; i++) {
+			if (g_cam.frames[i].state == CAM_FRAME_READY &&
+			    g_cam.frames[i].seq == g_cam.seq && g_cam.seq != seq) {
+				f = &g_cam.frames[i];
+				f->refs++;
+				break;
+			}
+		}
+		if (f)
+			break;
+		if (timeout_ms == OS_WAIT_FOREVER) {
+			wait = OS_WAIT_FOREVER;
+		} else {
+			if ((int32_t)(end - OS_GetTicks()) <= 0)
+				break;
+			wait = OS_TicksToMSecs(end - OS_GetTicks());
+		}
+		g_cam.waiters++;
+		CAM_UNLOCK();
+		OS_SemaphoreWait(&g_cam.ready, wait);
+		CAM_LOCK();
+	}
+	CAM_UNLOCK();
+
+	return f;
+}
+
+void cam_stream_put(cam_stream_frame *frame)
+{
+	CAM_LOCK();
+	if (frame->refs)
+		frame->refs--;
+	CAM_UNLOCK();
+}
+
+void cam_stream_get_stat(cam_stream_stat *stat, int reset)
+{
+	uint32_t ram;
+
+	CAM_LOCK();
+	*stat = g_cam.stat;
+	if (reset) {
+		ram = g_cam.stat.ram;
+		memset(&g_cam.stat, 0, sizeof(g_cam.stat));
+		g_cam.stat.ram = ram;
+	}
+	CAM_UNLOCK();
+}
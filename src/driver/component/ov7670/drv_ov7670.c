@@ -66,6 +66,14 @@ static Ov7670_PowerCtrlCfg private_ov7670_power;
 static DMA_Channel ov7670_dma_ch_fifo_a = DMA_CHANNEL_INVALID;
 static DMA_Channel ov7670_dma_ch_fifo_b = DMA_CHANNEL_INVALID;
 
+/* strip capture, see Drv_Ov7670_Set_Strip_Buff() */
+static uint8_t private_strip_en = 0;
+static uint8_t private_strip_drop = 0;
+static Ov7670_StripCfg private_strip_cfg;
+static uint32_t private_strip_fill = 0;
+static volatile uint32_t private_strip_wr = 0;	/* strips filled, by the interrupt */
+static volatile uint32_t private_strip_rd = 0;	/* strips released, by the reader */
+
 
 static void Ov7670Sccb_Init()
 {
@@ -165,8 +173,66 @@ static void Ov7620_Dma_Reque(DMA_Channel *ch)
 	HAL_DMA_Init(*ch, &param);
 }
 
+static void Ov7670_Strip_Done(void)
+{
+	uint32_t index = private_strip_wr;
+
+	private_strip_wr = index + 1;
+	if (private_strip_cfg.strip_done)
+		private_strip_cfg.strip_done(index, private_strip_fill, private_strip_cfg.arg);
+	private_strip_fill = 0;
+}
+
+static void Ov7670_Strip_Fifo(DMA_Channel channel, uint32_t fifo, uint32_t len)
+{
+	Ov7670_StripCfg *cfg = &private_strip_cfg;
+	uint32_t addr;
+
+	if (private_strip_drop)
+		return;
+
+	/*
+	 * The DMA of the FIFO before is done once this one is ready, so a full
+	 * strip is handed over when the first line after it comes.
+	 */
+	if (private_strip_fill && private_strip_fill + len > cfg->strip_size)
+		Ov7670_Strip_Done();
+
+	if (private_strip_fill == 0 &&
+	    (len > cfg->strip_size || private_strip_wr - private_strip_rd >= cfg->strip_num)) {
+		/* the reader is behind, the rest of the frame is lost */
+		private_strip_drop = 1;
+		return;
+	}
+
+	addr = (uint32_t)cfg->buf + (private_strip_wr % cfg->strip_num) * cfg->strip_size;
+	HAL_DMA_Start(channel, fifo, addr + private_strip_fill, len);
+	private_strip_fill += len;
+	private_image_data_count += len;
+}
+
+static void Ov7670_Strip_Frame_Done(void)
+{
+	uint32_t len = private_image_data_count;
+	uint8_t drop = private_strip_drop;
+
+	if (!drop && private_strip_fill)
+		Ov7670_Strip_Done();
+	private_strip_fill = 0;
+	private_strip_drop = 0;
+	private_image_data_count = 0;
+
+	if (private_strip_cfg.frame_done)
+		private_strip_cfg.frame_done(len, drop, private_strip_cfg.arg);
+}
+
 void read_fifo_a(DMA_Channel channel, uint32_t len)
 {
+	if (private_strip_en) {
+		Ov7670_Strip_Fifo(channel, CSI_FIFO_A, len);
+		return;
+	}
+
 	if (private_image_buff_addr == 0) {
 		COMPONENT_WARN("image_buff is invalid\n");
 		return;
@@ -178,6 +244,11 @@ void read_fifo_a(DMA_Channel channel, uint32_t len)
 
 void read_fifo_b(DMA_Channel channel, uint32_t len)
 {
+	if (private_strip_en) {
+		Ov7670_Strip_Fifo(channel, CSI_FIFO_B, len);
+		return;
+	}
+
 	if (private_image_buff_addr == 0) {
 		COMPONENT_WARN("image_buff is invalid\n");
 		return;
@@ -197,6 +268,8 @@ void Ov7670_Irq(void *arg)
 		read_fifo_a(ov7670_dma_ch_fifo_a, len.FIFO_0_A_Data_Len);
 	else if (irq_sta & CSI_FIFO_0_B_READY_IRQ)
 		read_fifo_b(ov7670_dma_ch_fifo_b, len.FIFO_0_B_Data_Len);
+	else if ((irq_sta & CSI_FRAME_DONE_IRQ) && private_strip_en)
+		Ov7670_Strip_Frame_Done();
 	else if (irq_sta & CSI_FRAME_DONE_IRQ) {
 		OS_Status sta = OS_SemaphoreRelease(&private_ov7670_sem_wait);
 		if (sta != OS_OK) {
@@ -207,8 +280,11 @@ void Ov7670_Irq(void *arg)
 		private_image_data_count = 0;
 	}
 
-	if (irq_sta & CSI_FIFO_0_OVERFLOW_IRQ)
+	if (irq_sta & CSI_FIFO_0_OVERFLOW_IRQ) {
 		COMPONENT_WARN("fifo overflow!\n");
+		if (private_strip_en)
+			private_strip_drop = 1;
+	}
 }
 
 void Ov7670_Csi_Init()
@@ -451,6 +527,39 @@ void Drv_OV7670_Special_Effects(OV7670_SPECAIL_EFFECTS eft)
 	Ov7670Sccb_Write(0X67, reg68val);
 }
 
+/**
+  * @brief Set the output format of the camera.
+  * @note YUV422 is sent as Y U Y V with the TSLB and COM13 of the init table.
+  * @param format: The output format.
+  * @retval None
+  */
+void Drv_OV7670_Output_Format(OV7670_OUTPUT_FORMAT format)
+{
+	if (format == OV7670_OUTPUT_YUV422) {
+		Ov7670Sccb_Write(0X12, 0X10);	//QVGA, YUV
+		Ov7670Sccb_Write(0X40, 0XC0);	//full range 00-FF
+	} else {
+		Ov7670Sccb_Write(0X12, 0X14);	//QVGA, RGB
+		Ov7670Sccb_Write(0X40, 0XD0);	//565
+	}
+}
+
+/**
+  * @brief Divide the input clock of the camera.
+  * @note The frame rate is divided by div + 1, to send the lines no faster
+  *           than they are processed.
+  * @param div: 0 - 63.
+  * @retval None
+  */
+void Drv_OV7670_Clock_Div(uint8_t div)
+{
+	uint8_t temp = 0X80;
+
+	Ov7670Sccb_Read(0X11, &temp);
+	temp = (temp & 0XC0) | (div & 0X3F);
+	Ov7670Sccb_Write(0X11, temp);
+}
+
 /**
   * @brief Set the window for camera.
   * @param sx: Starting coordinates.
@@ -493,6 +602,49 @@ void Drv_Ov7670_Set_SaveImage_Buff(uint32_t image_buff_addr)
 	private_image_buff_addr = image_buff_addr;
 }
 
+/**
+  * @brief Capture into a ring of strips instead of one frame buffer.
+  * @note The strips are handed to cfg->strip_done in the interrupt as
+  *           they fill, the reader gives them back with
+  *           Drv_Ov7670_Strip_Release() in the same order. When the ring is
+  *           full the rest of the frame is dropped, and cfg->frame_done
+  *           tells it at the end of the frame.
+  * @param cfg: The ring and the callbacks, NULL to go back to the buffer
+  *           of Drv_Ov7670_Set_SaveImage_Buff().
+  * @retval Component_Status : The driver status.
+  */
+Component_Status Drv_Ov7670_Set_Strip_Buff(const Ov7670_StripCfg *cfg)
+{
+	private_strip_en = 0;
+	if (cfg == NULL)
+		return COMP_OK;
+
+	if (cfg->buf == NULL || cfg->strip_size == 0 || cfg->strip_num < 2) {
+		COMPONENT_WARN("invalid strip buff\n");
+		return COMP_ERROR;
+	}
+
+	private_strip_cfg = *cfg;
+	private_strip_fill = 0;
+	private_strip_drop = 0;
+	private_strip_wr = 0;
+	private_strip_rd = 0;
+	private_image_data_count = 0;
+	private_strip_en = 1;
+
+	return COMP_OK;
+}
+
+/**
+  * @brief Give back strips handed over by the strip capture.
+  * @param num: The number of strips.
+  * @retval None
+  */
+void Drv_Ov7670_Strip_Release(uint32_t num)
+{
+	private_strip_rd += num;
+}
+
 /**
   * @brief Init the io for ctrl the camera power.
   * @param cfg: The io info.
@@ -567,10 +719,25 @@ Component_Status Drv_Ov7670_Init()
   */
 Component_Status Drv_Ov7670_Capture_Enable(CSI_CAPTURE_MODE mode , CSI_CTRL ctrl)
 {
-	OS_Status sta = OS_SemaphoreCreate(&private_ov7670_sem_wait, 0, OS_SEMAPHORE_MAX_COUNT);
-	if (sta != OS_OK) {
-		COMPONENT_WARN("ov7670 semaphore create error, %d\n", sta);
-		return COMP_ERROR;
+	OS_Status sta;
+
+	if (ctrl == CSI_DISABLE) {
+		HAL_CSI_Capture_Enable(mode, CSI_DISABLE);
+		if (OS_SemaphoreIsValid(&private_ov7670_sem_wait)) {
+			sta = OS_SemaphoreDelete(&private_ov7670_sem_wait);
+			if (sta != OS_OK)
+				COMPONENT_WARN("ov7670 semaphore delete error, %d\n", sta);
+		}
+		return COMP_OK;
+	}
+
+	/* a still capture leaves one made by Drv_Ov7670_Capture_Componemt() */
+	if (!OS_SemaphoreIsValid(&private_ov7670_sem_wait)) {
+		sta = OS_SemaphoreCreate(&private_ov7670_sem_wait, 0, OS_SEMAPHORE_MAX_COUNT);
+		if (sta != OS_OK) {
+			COMPONENT_WARN("ov7670 semaphore create error, %d\n", sta);
+			return COMP_ERROR;
+		}
 	}
 
 	HAL_CSI_Capture_Enable(mode, CSI_ENABLE);
@@ -624,6 +791,8 @@ void Drv_Ov7670_DeInit()
 	HAL_I2C_DeInit(OV7670_I2CID);
 	HAL_DMA_Release(ov7670_dma_ch_fifo_a);
 	HAL_DMA_Release(ov7670_dma_ch_fifo_b);
+	if (!OS_SemaphoreIsValid(&private_ov7670_sem_wait))
+		return;
 	OS_Status sta = OS_SemaphoreDelete(&private_ov7670_sem_wait);
 	if (sta != OS_OK) {
 		COMPONENT_WARN("ov7670 semaphore delete error, %d\n", sta);
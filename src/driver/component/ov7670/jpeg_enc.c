@@ -0,0 +1,671 @@
+/**
+  * @file  jpeg_enc.c
+  * @author  XRADIO IOT WLAN Team
+  */
+
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "driver/component/ov7670/jpeg_enc.h"
+
+/* jpeg_fdct_islow() of the IJG library: 13 bit constants, 2 extra bits in the first pass */
+#define CONST_BITS		13
+#define PASS1_BITS		2
+#define DESCALE(x, n)	(((x) + (1 << ((n) - 1))) >> (n))
+
+#define FIX_0_298631336	2446
+#define FIX_0_390180644	3196
+#define FIX_0_541196100	4433
+#define FIX_0_765366865	6270
+#define FIX_0_899976223	7373
+#define FIX_1_175875602	9633
+#define FIX_1_501321110	12299
+#define FIX_1_847759065	15137
+#define FIX_1_961570560	16069
+#define FIX_2_053119869	16819
+#define FIX_2_562915447	20995
+#define FIX_3_072711026	25172
+
+/* The DCT output is 8 times the coefficient, divided by 8 * q as a multiply */
+#define QUANT_BITS		18
+
+enum {
+	JPEG_STATE_IDLE = 0,
+	JPEG_STATE_FRAME,
+	JPEG_STATE_ERROR,
+};
+
+typedef struct {
+	uint16_t dc_code[12];
+	uint8_t dc_size[12];
+	uint16_t ac_code[256];
+	uint8_t ac_size[256];
+} jpeg_huff;
+
+struct jpeg_enc {
+	jpeg_enc_cfg cfg;
+	uint8_t quality;			/* of the tables */
+	uint8_t state;
+	uint8_t qtbl[2][64];		/* luminance and chrominance, natural order */
+	uint16_t qrecip[2][64];		/* (1 << QUANT_BITS) / (8 * q) */
+	jpeg_huff huff[2];
+
+	uint8_t y[8 * 16];			/* samples of one MCU */
+	uint8_t cb[8 * 8];
+	uint8_t cr[8 * 8];
+	int32_t blk[64];
+	int16_t dc_pred[3];
+
+	uint32_t bits;				/* bits not written yet, nbits < 8 */
+	int nbits;
+	uint32_t lines;				/* lines encoded in the frame */
+	uint32_t size;				/* bytes written in the frame */
+	uint32_t out_len;
+	uint8_t out[JPEG_ENC_OUT_SIZE];
+};
+
+static const uint8_t jpeg_zigzag[64] = {
+	 0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+	12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+	35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+	58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+/* Tables of Annex K of ITU T.81 */
+static const uint8_t jpeg_std_quant[2][64] = {
+	{
+		16,  11,  10,  16,  24,  40,  51,  61,
+		12,  12,  14,  19,  26,  58,  60,  55,
+		14,  13,  16,  24,  40,  57,  69,  56,
+		14,  17,  22,  29,  51,  87,  80,  62,
+		18,  22,  37,  56,  68, 109, 103,  77,
+		24,  35,  55,  64,  81, 104, 113,  92,
+		49,  64,  78,  87, 103, 121, 120, 101,
+		72,  92,  95,  98, 112, 100, 103,  99,
+	}, {
+		17,  18,  24,  47,  99,  99,  99,  99,
+		18,  21,  26,  66,  99,  99,  99,  99,
+		24,  26,  56,  99,  99,  99,  99,  99,
+		47,  66,  99,  99,  99,  99,  99,  99,
+		99,  99,  99,  99,  99,  99,  99,  99,
+		99,  99,  99,  99,  99,  99,  99,  99,
+		99,  99,  99,  99,  99,  99,  99,  99,
+		99,  99,  99,  99,  99,  99,  99,  99,
+	},
+};
+
+static const uint8_t jpeg_dc_bits[2][16] = {
+	{ 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 },
+	{ 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0 },
+};
+
+static const uint8_t jpeg_dc_vals[12] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+};
+
+static const uint8_t jpeg_ac_bits[2][16] = {
+	{ 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d },
+	{ 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77 },
+};
+
+static const uint8_t jpeg_ac_vals[2][162] = {
+	{
+		0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+		0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+		0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+		0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+		0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+		0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+		0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+		0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+		0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+		0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+		0xf9, 0xfa,
+	}, {
+		0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+		0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+		0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+		0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+		0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+		0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+		0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+		0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+		0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+		0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+		0xf9, 0xfa,
+	},
+};
+
+static void jpeg_huff_build(uint16_t *code, uint8_t *size, const uint8_t *bits, const uint8_t *vals)
+{
+	uint32_t c = 0;
+	int len, i, k = 0;
+
+	for (len = 1; len <= 16; len++) {
+		for (i = 0; i < bits[len - 1]; i++) {
+			code[vals[k]] = c++;
+			size[vals[k]] = len;
+			k++;
+		}
+		c <<= 1;
+	}
+}
+
+static void jpeg_set_quality(jpeg_enc *enc, uint8_t quality)
+{
+	int scale = quality < 50 ? 5000 / quality : 200 - quality * 2;
+	int t, i, q;
+
+	for (t = 0; t < 2; t++) {
+		for (i = 0; i < 64; i++) {
+			q = (jpeg_std_quant[t][i] * scale + 50) / 100;
+			if (q < 1)
+				q = 1;
+			else if (q > 255)
+				q = 255;
+			enc->qtbl[t][i] = q;
+			enc->qrecip[t][i] = ((1 << QUANT_BITS) + 4 * q) / (8 * q);
+		}
+	}
+	enc->quality = quality;
+}
+
+/* Output */
+
+static void jpeg_out_flush(jpeg_enc *enc)
+{
+	if (enc->out_len && enc->state != JPEG_STATE_ERROR) {
+		if (enc->cfg.write(enc->cfg.arg, enc->out, enc->out_len) != 0)
+			enc->state = JPEG_STATE_ERROR;
+		else
+			enc->size += enc->out_len;
+	}
+	enc->out_len = 0;
+}
+
+static __inline void jpeg_put_byte(jpeg_enc *enc, uint8_t b)
+{
+	enc->out[enc->out_len++] = b;
+	if (enc->out_len == JPEG_ENC_OUT_SIZE)
+		jpeg_out_flush(enc);
+}
+
+static void jpeg_put(jpeg_enc *enc, const uint8_t *data, uint32_t len)
+{
+	while (len--)
+		jpeg_put_byte(enc, *data++);
+}
+
+static __inline void jpeg_put_bits(jpeg_enc *enc, uint32_t code, int size)
+{
+	uint32_t bits = (enc->bits << size) | (code & ((1U << size) - 1));
+	int n = enc->nbits + size;
+	uint8_t b;
+
+	while (n >= 8) {
+		n -= 8;
+		b = bits >> n;
+		jpeg_put_byte(enc, b);
+		if (b == 0xff)
+			jpeg_put_byte(enc, 0);
+	}
+	enc->bits = bits & ((1U << n) - 1);
+	enc->nbits = n;
+}
+
+/* Headers */
+
+static void jpeg_put_headers(jpeg_enc *enc)
+{
+	static const uint8_t soi_app0[] = {
+		0xff, 0xd8,
+		0xff, 0xe0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0x00,
+		0x01, 0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00,
+	};
+	static const uint8_t sos[] = {
+		0xff, 0xda, 0x00, 0x0c, 0x03, 0x01, 0x00, 0x02, 0x11, 0x03, 0x11,
+		0x00, 0x3f, 0x00,
+	};
+	uint8_t hdr[19];
+	int t, i;
+
+	jpeg_put(enc, soi_app0, sizeof(soi_app0));
+
+	/* DQT, both tables in zigzag order */
+	hdr[0] = 0xff;
+	hdr[1] = 0xdb;
+	hdr[2] = 0x00;
+	hdr[3] = 2 + 2 * 65;
+	jpeg_put(enc, hdr, 4);
+	for (t = 0; t < 2; t++) {
+		jpeg_put_byte(enc, t);
+		for (i = 0; i < 64; i++)
+			jpeg_put_byte(enc, enc->qtbl[t][jpeg_zigzag[i]]);
+	}
+
+	/* SOF0, Y 2x1, Cb and Cr 1x1 */
+	hdr[0] = 0xff;
+	hdr[1] = 0xc0;
+	hdr[2] = 0x00;
+	hdr[3] = 17;
+	hdr[4] = 8;
+	hdr[5] = enc->cfg.height >> 8;
+	hdr[6] = enc->cfg.height;
+	hdr[7] = enc->cfg.width >> 8;
+	hdr[8] = enc->cfg.width;
+	hdr[9] = 3;
+	hdr[10] = 1; hdr[11] = 0x21; hdr[12] = 0;
+	hdr[13] = 2; hdr[14] = 0x11; hdr[15] = 1;
+	hdr[16] = 3; hdr[17] = 0x11; hdr[18] = 1;
+	jpeg_put(enc, hdr, 19);
+
+	/* DHT, DC and AC of both tables */
+	hdr[0] = 0xff;
+	hdr[1] = 0xc4;
+	hdr[2] = (2 + 4 * 17 + 2 * 12 + 2 * 162) >> 8;
+	hdr[3] = (2 + 4 * 17 + 2 * 12 + 2 * 162) & 0xff;
+	jpeg_put(enc, hdr, 4);
+	for (t = 0; t < 2; t++) {
+		jpeg_put_byte(enc, 0x00 | t);
+		jpeg_put(enc, jpeg_dc_bits[t], 16);
+		jpeg_put(enc, jpeg_dc_vals, 12);
+		jpeg_put_byte(enc, 0x10 | t);
+		jpeg_put(enc, jpeg_ac_bits[t], 16);
+		jpeg_put(enc, jpeg_ac_vals[t], 162);
+	}
+
+	jpeg_put(enc, sos, sizeof(sos));
+}
+
+/* Forward DCT in place, the output is scaled up by 8 */
+static void jpeg_fdct(int32_t *data)
+{
+	int32_t tmp0, tmp1, tmp2, tmp3, tmp4, tmp5, tmp6, tmp7;
+	int32_t tmp10, tmp11, tmp12, tmp13;
+	int32_t z1, z2, z3, z4, z5;
+	int32_t *p;
+	int i;
+
+	for (p = data, i = 0; i < 8; i++, p += 8) {
+		tmp0 = p[0] + p[7];
+		tmp7 = p[0] - p[7];
+		tmp1 = p[1] + p[6];
+		tmp6 = p[1] - p[6];
+		tmp2 = p[2] + p[5];
+		tmp5 = p[2] - p[5];
+		tmp3 = p[3] + p[4];
+		tmp4 = p[3] - p[4];
+
+		tmp10 = tmp0 + tmp3;
+		tmp13 = tmp0 - tmp3;
+		tmp11 = tmp1 + tmp2;
+		tmp12 = tmp1 - tmp2;
+
+		p[0] = (tmp10 + tmp11) << PASS1_BITS;
+		p[4] = (tmp10 - tmp11) << PASS1_BITS;
+
+		z1 = (tmp12 + tmp13) * FIX_0_541196100;
+		p[2] = DESCALE(z1 + tmp13 * FIX_0_765366865, CONST_BITS - PASS1_BITS);
+		p[6] = DESCALE(z1 - tmp12 * FIX_1_847759065, CONST_BITS - PASS1_BITS);
+
+		z1 = tmp4 + tmp7;
+		z2 = tmp5 + tmp6;
+		z3 = tmp4 + tmp6;
+		z4 = tmp5 + tmp7;
+		z5 = (z3 + z4) * FIX_1_175875602;
+
+		tmp4 *= FIX_0_298631336;
+		tmp5 *= FIX_2_053119869;
+		tmp6 *= FIX_3_072711026;
+		tmp7 *= FIX_1_501321110;
+		z1 *= -FIX_0_899976223;
+		z2 *= -FIX_2_562915447;
+		z3 = z3 * -FIX_1_961570560 + z5;
+		z4 = z4 * -FIX_0_390180644 + z5;
+
+		p[7] = DESCALE(tmp4 + z1 + z3, CONST_BITS - PASS1_BITS);
+		p[5] = DESCALE(tmp5 + z2 + z4, CONST_BITS - PASS1_BITS);
+		p[3] = DESCALE(tmp6 + z2 + z3, CONST_BITS - PASS1_BITS);
+		p[1] = DESCALE(tmp7 + z1 + z4, CONST_BITS - PASS1_BITS);
+	}
+
+	for (p = data, i = 0; i < 8; i++, p++) {
+		tmp0 = p[8 * 0] + p[8 * 7];
+		tmp7 = p[8 * 0] - p[8 * 7];
+		tmp1 = p[8 * 1] + p[8 * 6];
+		tmp6 = p[8 * 1] - p[8 * 6];
+		tmp2 = p[8 * 2] + p[8 * 5];
+		tmp5 = p[8 * 2] - p[8 * 5];
+		tmp3 = p[8 * 3] + p[8 * 4];
+		tmp4 = p[8 * 3] - p[8 * 4];
+
+		tmp10 = tmp0 + tmp3;
+		tmp13 = tmp0 - tmp3;
+		tmp11 = tmp1 + tmp2;
+		tmp12 = tmp1 - tmp2;
+
+		p[8 * 0] = DESCALE(tmp10 + tmp11, PASS1_BITS);
+		p[8 * 4] = DESCALE(tmp10 - tmp11, PASS1_BITS);
+
+		z1 = (tmp12 + tmp13) * FIX_0_541196100;
+		p[8 * 2] = DESCALE(z1 + tmp13 * FIX_0_765366865, CONST_BITS + PASS1_BITS);
+		p[8 * 6] = DESCALE(z1 - tmp12 * FIX_1_847759065, CONST_BITS + PASS1_BITS);
+
+		z1 = tmp4 + tmp7;
+		z2 = tmp5 + tmp6;
+		z3 = tmp4 + tmp6;
+		z4 = tmp5 + tmp7;
+		z5 = (z3 + z4) * FIX_1_175875602;
+
+		tmp4 *= FIX_0_298631336;
+		tmp5 *= FIX_2_053119869;
+		tmp6 *= FIX_3_072711026;
+		tmp7 *= FIX_1_501321110;
+		z1 *= -FIX_0_899976223;
+		z2 *= -FIX_2_562915447;
+		z3 = z3 * -FIX_1_961570560 + z5;
+		z4 = z4 * -FIX_0_390180644 + z5;
+
+		p[8 * 7] = DESCALE(tmp4 + z1 + z3, CONST_BITS + PASS1_BITS);
+		p[8 * 5] = DESCALE(tmp5 + z2 + z4, CONST_BITS + PASS1_BITS);
+		p[8 * 3] = DESCALE(tmp6 + z2 + z3, CONST_BITS + PASS1_BITS);
+		p[8 * 1] = DESCALE(tmp7 + z1 + z4, CONST_BITS + PASS1_BITS);
+	}
+}
+
+static __inline int jpeg_quant(int32_t v, uint32_t recip)
+{
+	if (v < 0)
+		return -(int)(((uint32_t)-v * recip + (1 << (QUANT_BITS - 1))) >> QUANT_BITS);
+	return (int)(((uint32_t)v * recip + (1 << (QUANT_BITS - 1))) >> QUANT_BITS);
+}
+
+static __inline int jpeg_nbits(int v)
+{
+	if (v < 0)
+		v = -v;
+	return v ? 32 - __builtin_clz(v) : 0;
+}
+
+/* Encode the 8x8 block at s of component comp, 0 is Y */
+static void jpeg_encode_block(jpeg_enc *enc, int comp, const uint8_t *s, int stride)
+{
+	int32_t *blk = enc->blk;
+	const uint16_t *recip = enc->qrecip[comp != 0];
+	const jpeg_huff *huff = &enc->huff[comp != 0];
+	int r, c, k, v, nb, run, sym;
+
+	for (r = 0; r < 8; r++, s += stride) {
+		for (c = 0; c < 8; c++)
+			*blk++ = s[c] - 128;
+	}
+	blk = enc->blk;
+	jpeg_fdct(blk);
+
+	v = jpeg_quant(blk[0], recip[0]);
+	k = v - enc->dc_pred[comp];
+	enc->dc_pred[comp] = v;
+	nb = jpeg_nbits(k);
+	jpeg_put_bits(enc, huff->dc_code[nb], huff->dc_size[nb]);
+	if (nb)
+		jpeg_put_bits(enc, k < 0 ? k - 1 : k, nb);
+
+	run = 0;
+	for (k = 1; k < 64; k++) {
+		c = jpeg_zigzag[k];
+		v = jpeg_quant(blk[c], recip[c]);
+		if (v == 0) {
+			run++;
+			continue;
+		}
+		while (run > 15) {
+			jpeg_put_bits(enc, huff->ac_code[0xf0], huff->ac_size[0xf0]);
+			run -= 16;
+		}
+		nb = jpeg_nbits(v);
+		sym = (run << 4) | nb;
+		jpeg_put_bits(enc, huff->ac_code[sym], huff->ac_size[sym]);
+		jpeg_put_bits(enc, v < 0 ? v - 1 : v, nb);
+		run = 0;
+	}
+	if (run)
+		jpeg_put_bits(enc, huff->ac_code[0x00], huff->ac_size[0x00]);
+}
+
+/* Load the MCU at column x0, the lines past lines and the columns past the width repeat the last */
+
+static void jpeg_load_yuyv(jpeg_enc *enc, const uint8_t *src, uint32_t stride,
+                           uint32_t lines, uint32_t x0)
+{
+	uint8_t *y = enc->y, *cb = enc->cb, *cr = enc->cr;
+	uint32_t width = enc->cfg.width;
+	const uint8_t *p, *q;
+	uint32_t r, i, x;
+
+	for (r = 0; r < 8; r++) {
+		p = src + (r < lines ? r : lines - 1) * stride;
+		if (x0 + 16 <= width) {
+			q = p + x0 * 2;
+			for (i = 0; i < 8; i++, q += 4) {
+				*y++ = q[0];
+				*y++ = q[2];
+				*cb++ = q[1];
+				*cr++ = q[3];
+			}
+		} else {
+			for (i = 0; i < 8; i++) {
+				x = x0 + 2 * i;
+				if (x >= width)
+					x = width - 2;
+				q = p + x * 2;
+				*y++ = q[0];
+				*y++ = q[2];
+				*cb++ = q[1];
+				*cr++ = q[3];
+			}
+		}
+	}
+}
+
+static __inline uint8_t jpeg_clamp(int32_t v)
+{
+	return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+static void jpeg_load_rgb565(jpeg_enc *enc, const uint8_t *src, uint32_t stride,
+                             uint32_t lines, uint32_t x0)
+{
+	uint8_t *y = enc->y, *cb = enc->cb, *cr = enc->cr;
+	uint32_t width = enc->cfg.width;
+	const uint8_t *p, *q;
+	uint32_t r, i, x, v;
+	int32_t r0, g0, b0, r1, g1, b1;
+
+	for (r = 0; r < 8; r++) {
+		p = src + (r < lines ? r : lines - 1) * stride;
+		for (i = 0; i < 8; i++) {
+			x = x0 + 2 * i;
+			if (x >= width)
+				x = width - 2;
+			q = p + x * 2;
+
+			v = (q[0] << 8) | q[1];
+			r0 = (v >> 8) & 0xf8;
+			g0 = (v >> 3) & 0xfc;
+			b0 = (v << 3) & 0xf8;
+			r0 |= r0 >> 5;
+			g0 |= g0 >> 6;
+			b0 |= b0 >> 5;
+			v = (q[2] << 8) | q[3];
+			r1 = (v >> 8) & 0xf8;
+			g1 = (v >> 3) & 0xfc;
+			b1 = (v << 3) & 0xf8;
+			r1 |= r1 >> 5;
+			g1 |= g1 >> 6;
+			b1 |= b1 >> 5;
+
+			/* BT.601 full range in 16 bit fixed point, chroma of the pixel pair */
+			*y++ = (19595 * r0 + 38470 * g0 + 7471 * b0 + 32768) >> 16;
+			*y++ = (19595 * r1 + 38470 * g1 + 7471 * b1 + 32768) >> 16;
+			r0 += r1;
+			g0 += g1;
+			b0 += b1;
+			*cb++ = jpeg_clamp(((-11059 * r0 - 21709 * g0 + 32768 * b0 + 65536) >> 17) + 128);
+			*cr++ = jpeg_clamp(((32768 * r0 - 27439 * g0 - 5329 * b0 + 65536) >> 17) + 128);
+		}
+	}
+}
+
+jpeg_enc *jpeg_enc_create(const jpeg_enc_cfg *cfg)
+{
+	jpeg_enc *enc;
+	int t;
+
+	if (cfg->width == 0 || (cfg->width & 1) || cfg->height == 0 ||
+	    cfg->quality < 1 || cfg->quality > 100 || cfg->write == NULL ||
+	    cfg->format > JPEG_ENC_RGB565)
+		return NULL;
+
+	enc = malloc(sizeof(*enc));
+	if (enc == NULL)
+		return NULL;
+	memset(enc, 0, sizeof(*enc));
+	enc->cfg = *cfg;
+
+	for (t = 0; t < 2; t++) {
+		jpeg_huff_build(enc->huff[t].dc_code, enc->huff[t].dc_size,
+		                jpeg_dc_bits[t], jpeg_dc_vals);
+		jpeg_huff_build(enc->huff[t].ac_code, enc->huff[t].ac_size,
+		                jpeg_ac_bits[t], jpeg_ac_vals[t]);
+	}
+	jpeg_set_quality(enc, cfg->quality);
+
+	return enc;
+}
+
+void jpeg_enc_destroy(jpeg_enc *enc)
+{
+	free(enc);
+}
+
+uint32_t jpeg_enc_mem_size(void)
+{
+	return sizeof(jpeg_enc);
+}
+
+int jpeg_enc_set_quality(jpeg_enc *enc, uint8_t quality)
+{
+	if (quality < 1 || quality > 100)
+		return -1;
+	enc->cfg.quality = quality;
+	return 0;
+}
+
+int jpeg_enc_frame_start(jpeg_enc *enc)
+{
+	if (enc->cfg.quality != enc->quality)
+		jpeg_set_quality(enc, enc->cfg.quality);
+
+	enc->state = JPEG_STATE_FRAME;
+	enc->dc_pred[0] = enc->dc_pred[1] = enc->dc_pred[2] = 0;
+	enc->bits = 0;
+	enc->nbits = 0;
+	enc->lines = 0;
+	enc->size = 0;
+	enc->out_len = 0;
+
+	jpeg_put_headers(enc);
+	return enc->state == JPEG_STATE_FRAME ? 0 : -1;
+}
+
+int jpeg_enc_strip(jpeg_enc *enc, const uint8_t *src, uint32_t stride, uint32_t lines)
+{
+	uint32_t n, x;
+
+	if (enc->state != JPEG_STATE_FRAME)
+		return -1;
+	if (enc->lines + lines > enc->cfg.height) {
+		enc->state = JPEG_STATE_ERROR;
+		return -1;
+	}
+
+	while (lines) {
+		n = lines < JPEG_ENC_STRIP_LINES ? lines : JPEG_ENC_STRIP_LINES;
+		if (n < JPEG_ENC_STRIP_LINES && enc->lines + n != enc->cfg.height) {
+			enc->state = JPEG_STATE_ERROR;
+			return -1;
+		}
+		for (x = 0; x < enc->cfg.width; x += 16) {
+			if (enc->cfg.format == JPEG_ENC_YUYV)
+				jpeg_load_yuyv(enc, src, stride, n, x);
+			else
+				jpeg_load_rgb565(enc, src, stride, n, x);
+			jpeg_encode_block(enc, 0, enc->y, 16);
+			jpeg_encode_block(enc, 0, enc->y + 8, 16);
+			jpeg_encode_block(enc, 1, enc->cb, 8);
+			jpeg_encode_block(enc, 2, enc->cr, 8);
+		}
+		enc->lines += n;
+		src += n * stride;
+		lines -= n;
+	}
+
+	return enc->state == JPEG_STATE_FRAME ? 0 : -1;
+}
+
+int jpeg_enc_frame_end(jpeg_enc *enc)
+{
+	static const uint8_t eoi[] = { 0xff, 0xd9 };
+
+	if (enc->state != JPEG_STATE_FRAME)
+		return -1;
+	if (enc->lines != enc->cfg.height) {
+		enc->state = JPEG_STATE_ERROR;
+		return -1;
+	}
+
+	/* fill the last byte with 1 bits */
+	if (enc->nbits)
+		jpeg_put_bits(enc, 0x7f, 8 - enc->nbits);
+	jpeg_put(enc, eoi, sizeof(eoi));
+	jpeg_out_flush(enc);
+
+	if (enc->state != JPEG_STATE_FRAME)
+		return -1;
+	enc->state = JPEG_STATE_IDLE;
+	return 0;
+}
+
+uint32_t jpeg_enc_frame_size(jpeg_enc *enc)
+{
+	return enc->size + enc->out_len;
+}
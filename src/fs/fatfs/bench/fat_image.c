@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fat_image.h"
+
+#define IMG_RSVD	32
+
+static void st16(uint8_t *p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static void st32(uint8_t *p, uint32_t v) { st16(p, v); st16(p + 2, v >> 16); }
+
+static int put(int fd, const uint8_t *sec, uint32_t sector)
+{
+	return pwrite(fd, sec, 512, (off_t)sector * 512) == 512 ? 0 : -1;
+}
+
+int fat_image_create(const char *path, uint32_t sectors, uint32_t spc)
+{
+	uint8_t sec[512];
+	uint32_t fatsz = 0, prev, nclst;
+	int fd;
+
+	fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0 || ftruncate(fd, (off_t)sectors * 512) != 0) {
+		perror(path);
+		return -1;
+	}
+	do {
+		prev = fatsz;
+		nclst = (sectors - IMG_RSVD - 2 * fatsz) / spc;
+		fatsz = ((nclst + 2) * 4 + 511) / 512;
+	} while (fatsz != prev);
+	if (nclst < 65526) {
+		printf("%u clusters are too few for FAT32\n", nclst);
+		close(fd);
+		return -1;
+	}
+
+	memset(sec, 0, sizeof(sec));
+	memcpy(sec, "\xEB\x58\x90" "MSWIN4.1", 11);
+	st16(sec + 11, 512);
+	sec[13] = spc;
+	st16(sec + 14, IMG_RSVD);
+	sec[16] = 2;
+	sec[21] = 0xF8;
+	st16(sec + 24, 63);
+	st16(sec + 26, 255);
+	st32(sec + 32, sectors);
+	st32(sec + 36, fatsz);
+	st32(sec + 44, 2);				/* root directory cluster */
+	st16(sec + 48, 1);				/* FSInfo */
+	st16(sec + 50, 6);				/* backup boot sector */
+	sec[64] = 0x80;
+	sec[66] = 0x29;
+	st32(sec + 67, 0x20171018);
+	memcpy(sec + 71, "BENCH      FAT32   ", 19);
+	st16(sec + 510, 0xAA55);
+	if (put(fd, sec, 0) || put(fd, sec, 6))
+		goto err;
+
+	memset(sec, 0, sizeof(sec));
+	st32(sec + 0, 0x41615252);
+	st32(sec + 484, 0x61417272);
+	st32(sec + 488, nclst - 1);
+	st32(sec + 492, 2);
+	st16(sec + 510, 0xAA55);
+	if (put(fd, sec, 1))
+		goto err;
+
+	memset(sec, 0, sizeof(sec));
+	st32(sec + 0, 0x0FFFFFF8);
+	st32(sec + 4, 0x0FFFFFFF);
+	st32(sec + 8, 0x0FFFFFFF);		/* root directory, one cluster */
+	if (put(fd, sec, IMG_RSVD) || put(fd, sec, IMG_RSVD + fatsz))
+		goto err;
+
+	printf("image %u MiB, %u clusters of %u KiB\n", sectors / 2048, nclst, spc / 2);
+	return fd;
+
+err:
+	perror(path);
+	close(fd);
+	return -1;
+}
@@ -0,0 +1,8 @@
+/*
+ * Host stand-in for driver/chip/sdmmc/hal_sdhost.h, see sd_card_sim.c.
+ */
+
+#ifndef _DRIVER_CHIP_SDMMC_HAL_SDHOST_H_
+#define _DRIVER_CHIP_SDMMC_HAL_SDHOST_H_
+
+#endif /* _DRIVER_CHIP_SDMMC_HAL_SDHOST_H_ */
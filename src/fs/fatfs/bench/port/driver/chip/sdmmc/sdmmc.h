@@ -0,0 +1,34 @@
+/*
+ * Host stand-in for driver/chip/sdmmc/sdmmc.h, the card API used by
+ * sdmmc_diskio.c as simulated by sd_card_sim.c.
+ */
+
+#ifndef _DRIVER_CHIP_HAL_SDMMC_SDMMC_H_
+#define _DRIVER_CHIP_HAL_SDMMC_SDMMC_H_
+
+#include <stdint.h>
+
+#define MMC_STATE_PRESENT       (1 << 0)
+#define MMC_STATE_BLOCKADDR     (1 << 3)
+
+struct mmc_csd {
+	uint32_t capacity;      /* KB if block addressed, else bytes */
+};
+
+struct mmc_card {
+	uint32_t state;
+	struct mmc_csd csd;
+};
+
+#define mmc_card_present(c)     ((c)->state & MMC_STATE_PRESENT)
+#define mmc_card_blockaddr(c)   ((c)->state & MMC_STATE_BLOCKADDR)
+
+struct mmc_card *mmc_card_open(uint8_t card_id);
+int32_t mmc_card_close(uint8_t card_id);
+int32_t mmc_block_read(struct mmc_card *card, uint8_t *buf, uint64_t sblk, uint32_t nblk);
+int32_t mmc_block_write(struct mmc_card *card, const uint8_t *buf, uint64_t sblk, uint32_t nblk);
+int32_t mmc_block_write2(struct mmc_card *card, const uint8_t *buf0, uint32_t nblk0,
+                         const uint8_t *buf1, uint32_t nblk1, uint64_t sblk);
+int32_t mmc_erase(struct mmc_card *card, uint64_t sblk, uint32_t nblk);
+
+#endif /* _DRIVER_CHIP_HAL_SDMMC_SDMMC_H_ */
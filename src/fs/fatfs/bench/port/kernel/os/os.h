@@ -0,0 +1,26 @@
+/*
+ * Host stand-in for kernel/os/os.h, enough for ffconf.h in the benches and
+ * the lock of diskcache.c, which run in one thread.
+ */
+
+#ifndef _KERNEL_OS_OS_H_
+#define _KERNEL_OS_OS_H_
+
+#include <stdint.h>
+
+typedef struct {
+	int dummy;
+} OS_Mutex_t;
+
+typedef int OS_Status;
+typedef uint32_t OS_Time_t;
+
+#define OS_OK			0
+#define OS_WAIT_FOREVER	0xffffffffU
+
+static inline OS_Status OS_MutexCreate(OS_Mutex_t *mutex) { return OS_OK; }
+static inline OS_Status OS_MutexDelete(OS_Mutex_t *mutex) { return OS_OK; }
+static inline OS_Status OS_MutexLock(OS_Mutex_t *mutex, OS_Time_t waitMS) { return OS_OK; }
+static inline OS_Status OS_MutexUnlock(OS_Mutex_t *mutex) { return OS_OK; }
+
+#endif /* _KERNEL_OS_OS_H_ */
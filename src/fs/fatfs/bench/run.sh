@@ -0,0 +1,16 @@
+#!/bin/sh
+#
+# Build seek_bench.c against ff.c with and without the seek cache and run
+# both on the same image, the image path is the first argument. The disk
+# cache is left out, the bench counts the sector reads of FatFs.
+#
+set -e
+cd "$(dirname "$0")"
+img=${1:-/tmp/seek_bench.img}
+for on in 0 1; do
+	gcc -O2 -Wall -Iport -I../../../../include -D_USE_SEEKCACHE=$on -D_USE_DISKCACHE=0 \
+		seek_bench.c fat_image.c ../ff.c ../option/unicode.c -o /tmp/seek_bench_$on
+done
+/tmp/seek_bench_0 "$img"
+echo
+/tmp/seek_bench_1 "$img"
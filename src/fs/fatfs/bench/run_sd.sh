@@ -0,0 +1,23 @@
+#!/bin/sh
+#
+# Build sd_bench.c against the SD card disk driver with direct transfers,
+# with read ahead, write gathering and TRIM, and with the disk cache on top
+# of them, and run the three.
+#
+set -e
+cd "$(dirname "$0")"
+img=${1:-/tmp/sd_bench.img}
+build() {
+	gcc -O2 -Wall -D__CONFIG_ARCH_APP_CORE -Iport -I.. -I../driver -I../../../../include "$@" \
+		-Wl,--wrap=disk_read,--wrap=disk_write,--wrap=disk_read_meta,--wrap=disk_write_meta \
+		sd_bench.c fat_image.c ../diskio.c ../diskcache.c ../driver/sdmmc_diskio.c \
+		../ff.c ../option/unicode.c
+}
+build -DSDMMC_RA_SECTORS=0 -DSDMMC_WB_SECTORS=0 -D_USE_DISKCACHE=0 -o /tmp/sd_bench_direct
+build -D_USE_TRIM=1 -D_USE_DISKCACHE=0 -o /tmp/sd_bench_nocache
+build -D_USE_TRIM=1 -o /tmp/sd_bench
+/tmp/sd_bench_direct "$img"
+echo
+/tmp/sd_bench_nocache "$img"
+echo
+/tmp/sd_bench "$img"
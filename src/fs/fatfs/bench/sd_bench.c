@@ -0,0 +1,532 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Linux benchmark of the SD card disk driver. driver/sdmmc_diskio.c and
+ * diskio.c run as they are over a simulated SDHC card: the mmc_* calls of
+ * sdmmc.h work on a FAT32 image file and count the SD commands they would
+ * issue, with a time model of a class 10 card on a 4 bit 50 MHz bus.
+ *
+ *   ./run_sd.sh           builds the driver with and without read ahead,
+ *                         write gathering and TRIM, and the last one
+ *                         with and without the disk cache
+ *
+ * Each workload runs through FatFs: playback reading 4 KiB at an odd
+ * offset, random 4 KiB reads, logging 100 byte lines with an f_sync()
+ * every 50, writing a file 32 KiB at a time, and a mix of playback, logging
+ * and updates of a media index, whose rounds are timed. "calls" are the
+ * disk_read() and disk_write() calls of FatFs, the old driver opened and
+ * closed the card on each. All the data read are checked, and the files
+ * written are checked again after CTRL_EJECT and a new mount.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fs/fatfs/ff.h"
+#include "fs/fatfs/diskio.h"
+#include "fs/fatfs/diskcache.h"
+#include "driver/chip/sdmmc/sdmmc.h"
+#include "fat_image.h"
+
+#define IMG_SECTORS		(8 * 1024 * 1024)	/* 4 GiB, sparse */
+#define IMG_SPC			64					/* 32 KiB clusters */
+
+/* Time model, us */
+#define CMD_US			10		/* command and response */
+#define READ_ACCESS_US	150		/* until the first block is read */
+#define XFER_US			21		/* 512 bytes at 25 MB/s */
+#define WRITE_BUSY_US	700		/* programming after a write command */
+#define PROG_US			30		/* programming per block */
+#define ERASE_US		2000
+
+#define PLAY_SIZE		(8 * 1024 * 1024)
+#define PLAY_OFS		1234	/* ID3 tag */
+#define CHUNK			4096
+#define RAND_READS		2000
+#define LOG_LINES		10000
+#define LOG_LINE		100
+#define WRITE_SIZE		(8 * 1024 * 1024)
+#define WRITE_CHUNK		(32 * 1024)
+#define MIX_ROUNDS		2000	/* 4 KiB of playback and a log line */
+#define MIX_INDEX_EVERY	20		/* rounds between index updates */
+#define INDEX_SIZE		(256 * 1024)
+#define INDEX_RECORD	64
+#define TRACKS			64
+
+struct card_stat {
+	uint32_t calls;
+	uint32_t opens;
+	uint32_t cmds;
+	uint32_t reads;		/* read transfers */
+	uint32_t writes;	/* write transfers */
+	uint32_t erases;
+	uint64_t blocks;
+	uint64_t us;
+};
+
+static struct card_stat cs;
+static struct mmc_card card;
+static int card_ref;
+static int img_fd = -1;
+
+/* sdmmc.h over the image */
+struct mmc_card *mmc_card_open(uint8_t card_id)
+{
+	cs.opens++;
+	card_ref++;
+	return &card;
+}
+
+int32_t mmc_card_close(uint8_t card_id)
+{
+	card_ref--;
+	return 0;
+}
+
+static int32_t card_io(uint8_t *buf, uint64_t sblk, uint32_t nblk, int write)
+{
+	ssize_t len = (ssize_t)nblk * 512;
+
+	if (nblk == 0 || nblk > 512 || sblk + nblk > IMG_SECTORS) {
+		printf("bad transfer %llu+%u\n", (unsigned long long)sblk, nblk);
+		exit(1);
+	}
+	if (write ? pwrite(img_fd, buf, len, sblk * 512) != len :
+	            pread(img_fd, buf, len, sblk * 512) != len)
+		return -1;
+	cs.blocks += nblk;
+	cs.cmds += 1 + (nblk > 1);				/* CMD17/18/24/25, CMD12 */
+	cs.us += CMD_US * (1 + (nblk > 1)) + XFER_US * nblk;
+	if (write) {
+		cs.writes++;
+		cs.cmds++;							/* CMD13 */
+		cs.us += CMD_US + WRITE_BUSY_US + PROG_US * nblk;
+	} else {
+		cs.reads++;
+		cs.us += READ_ACCESS_US;
+	}
+	return 0;
+}
+
+int32_t mmc_block_read(struct mmc_card *c, uint8_t *buf, uint64_t sblk, uint32_t nblk)
+{
+	return card_io(buf, sblk, nblk, 0);
+}
+
+int32_t mmc_block_write(struct mmc_card *c, const uint8_t *buf, uint64_t sblk, uint32_t nblk)
+{
+	return card_io((uint8_t *)buf, sblk, nblk, 1);
+}
+
+int32_t mmc_block_write2(struct mmc_card *c, const uint8_t *buf0, uint32_t nblk0,
+                         const uint8_t *buf1, uint32_t nblk1, uint64_t sblk)
+{
+	uint8_t *buf = malloc((nblk0 + nblk1) * 512);
+	int32_t err;
+
+	memcpy(buf, buf0, nblk0 * 512);
+	memcpy(buf + nblk0 * 512, buf1, nblk1 * 512);
+	err = card_io(buf, sblk, nblk0 + nblk1, 1);
+	free(buf);
+	return err;
+}
+
+int32_t mmc_erase(struct mmc_card *c, uint64_t sblk, uint32_t nblk)
+{
+	static const uint8_t zero[512];
+	uint32_t i;
+
+	for (i = 0; i < nblk; i++) {
+		if (pwrite(img_fd, zero, 512, (sblk + i) * 512) != 512)
+			return -1;
+	}
+	cs.erases++;
+	cs.cmds += 4;							/* CMD32, CMD33, CMD38, CMD13 */
+	cs.us += 4 * CMD_US + ERASE_US;
+	return 0;
+}
+
+/* Calls of FatFs to the driver, linked with --wrap */
+DRESULT __real_disk_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count);
+DRESULT __real_disk_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count);
+
+DRESULT __wrap_disk_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
+{
+	cs.calls++;
+	return __real_disk_read(pdrv, buff, sector, count);
+}
+
+DRESULT __wrap_disk_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
+{
+	cs.calls++;
+	return __real_disk_write(pdrv, buff, sector, count);
+}
+
+#if _USE_DISKCACHE
+DRESULT __real_disk_read_meta(BYTE pdrv, BYTE *buff, DWORD sector, UINT count);
+DRESULT __real_disk_write_meta(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count);
+
+DRESULT __wrap_disk_read_meta(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
+{
+	cs.calls++;
+	return __real_disk_read_meta(pdrv, buff, sector, count);
+}
+
+DRESULT __wrap_disk_write_meta(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
+{
+	cs.calls++;
+	return __real_disk_write_meta(pdrv, buff, sector, count);
+}
+#endif
+
+/* option/syscall.c for one thread */
+int ff_cre_syncobj(BYTE vol, _SYNC_t *sobj) { return 1; }
+int ff_req_grant(_SYNC_t sobj) { return 1; }
+void ff_rel_grant(_SYNC_t sobj) { }
+int ff_del_syncobj(_SYNC_t sobj) { return 1; }
+void *ff_memalloc(UINT msize) { return malloc(msize); }
+void ff_memfree(void *mblock) { free(mblock); }
+#if _USE_SEEKCACHE
+DWORD ff_get_ms(void) { return 0; }
+#endif
+
+static uint32_t rnd_state = 0x2545F491;
+
+static uint32_t rnd(void)
+{
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+	return rnd_state;
+}
+
+static uint8_t pattern(uint32_t seed, uint32_t ofs)
+{
+	uint32_t x = (ofs + 1) * 2654435761u ^ seed;
+
+	return x >> 24;
+}
+
+static void fill(uint8_t *buf, uint32_t seed, uint32_t ofs, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = pattern(seed, ofs + i);
+}
+
+static int check(const uint8_t *buf, uint32_t seed, uint32_t ofs, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++) {
+		if (buf[i] != pattern(seed, ofs + i))
+			return -1;
+	}
+	return 0;
+}
+
+static uint32_t errors;
+
+static void fail(const char *what)
+{
+	printf("error: %s\n", what);
+	errors++;
+}
+
+/* Write size bytes of pattern seed in chunks of chunk bytes */
+static void write_file(const char *name, uint32_t seed, uint32_t size, uint32_t chunk, int sync_every)
+{
+	static uint8_t buf[WRITE_CHUNK];
+	uint32_t ofs, n;
+	int i = 0;
+	FIL fil;
+	UINT bw;
+
+	if (f_open(&fil, name, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) {
+		fail("open for write");
+		return;
+	}
+	for (ofs = 0; ofs < size; ofs += n) {
+		n = size - ofs < chunk ? size - ofs : chunk;
+		fill(buf, seed, ofs, n);
+		if (f_write(&fil, buf, n, &bw) != FR_OK || bw != n) {
+			fail("write");
+			break;
+		}
+		if (sync_every && ++i % sync_every == 0 && f_sync(&fil) != FR_OK)
+			fail("sync");
+	}
+	if (f_close(&fil) != FR_OK)
+		fail("close");
+}
+
+/* Read the file from ofs in chunks of chunk bytes, or at random offsets */
+static void read_file(const char *name, uint32_t seed, uint32_t ofs, uint32_t chunk, int random)
+{
+	static uint8_t buf[CHUNK + 1];
+	uint32_t size, n;
+	int i = 0;
+	FIL fil;
+	UINT br;
+
+	if (f_open(&fil, name, FA_READ) != FR_OK) {
+		fail("open for read");
+		return;
+	}
+	size = f_size(&fil);
+	for (;;) {
+		if (random) {
+			if (i++ == RAND_READS)
+				break;
+			ofs = rnd() % (size - chunk);
+		} else if (ofs >= size) {
+			break;
+		}
+		n = size - ofs < chunk ? size - ofs : chunk;
+		/* the decoder buffers are not word aligned either */
+		if (f_lseek(&fil, ofs) != FR_OK || f_read(&fil, buf + 1, n, &br) != FR_OK || br != n) {
+			fail("read");
+			break;
+		}
+		if (check(buf + 1, seed, ofs, n) != 0) {
+			fail("data");
+			break;
+		}
+		ofs += n;
+	}
+	f_close(&fil);
+}
+
+static uint8_t index_copy[INDEX_SIZE];
+static uint64_t mix_us, mix_max_us;		/* card time of the rounds */
+
+/*
+ * Playback of the file 4 KiB a round while a log line is written each
+ * round, f_sync()ed every 50, and every MIX_INDEX_EVERY rounds a track of
+ * the music directory is looked up and its record of the index rewritten.
+ */
+static void mixed(const char *name, uint32_t seed)
+{
+	static uint8_t buf[CHUNK];
+	uint64_t us, start = cs.us;
+	uint32_t ofs = 0, size, n, rec;
+	char path[32];
+	FIL play, log, idx;
+	FILINFO fno;
+	UINT br;
+	int i;
+
+	if (f_open(&play, name, FA_READ) != FR_OK ||
+	    f_open(&log, "mixlog.txt", FA_WRITE | FA_CREATE_ALWAYS) != FR_OK ||
+	    f_open(&idx, "index.db", FA_READ | FA_WRITE) != FR_OK) {
+		fail("open for mixed");
+		return;
+	}
+	size = f_size(&play);
+	for (i = 0; i < MIX_ROUNDS; i++) {
+		us = cs.us;
+		if (ofs >= size)
+			ofs = 0;
+		n = size - ofs < CHUNK ? size - ofs : CHUNK;
+		if (f_lseek(&play, ofs) != FR_OK || f_read(&play, buf, n, &br) != FR_OK ||
+		    br != n || check(buf, seed, ofs, n) != 0) {
+			fail("mixed read");
+			break;
+		}
+		ofs += n;
+
+		fill(buf, 5, i * LOG_LINE, LOG_LINE);
+		if (f_write(&log, buf, LOG_LINE, &br) != FR_OK || br != LOG_LINE ||
+		    ((i + 1) % 50 == 0 && f_sync(&log) != FR_OK)) {
+			fail("mixed log");
+			break;
+		}
+
+		if (i % MIX_INDEX_EVERY == 0) {
+			sprintf(path, "music/track%03u.mp3", (unsigned)(rnd() % TRACKS));
+			rec = rnd() % (INDEX_SIZE / INDEX_RECORD) * INDEX_RECORD;
+			fill(index_copy + rec, rnd(), 0, INDEX_RECORD);
+			if (f_stat(path, &fno) != FR_OK || f_lseek(&idx, rec) != FR_OK ||
+			    f_write(&idx, index_copy + rec, INDEX_RECORD, &br) != FR_OK ||
+			    br != INDEX_RECORD || f_sync(&idx) != FR_OK) {
+				fail("mixed index");
+				break;
+			}
+		}
+
+		us = cs.us - us;
+		if (us > mix_max_us)
+			mix_max_us = us;
+	}
+	f_close(&idx);
+	f_close(&log);
+	f_close(&play);
+	mix_us = cs.us - start;
+}
+
+/* The music directory and the index, in their state before the mixed run */
+static void media_setup(void)
+{
+	char path[32];
+	FIL fil;
+	UINT bw;
+	int i;
+
+	if (f_mkdir("music") != FR_OK)
+		fail("mkdir");
+	for (i = 0; i < TRACKS; i++) {
+		sprintf(path, "music/track%03d.mp3", i);
+		if (f_open(&fil, path, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) {
+			fail("create track");
+			return;
+		}
+		f_close(&fil);
+	}
+	fill(index_copy, 6, 0, INDEX_SIZE);
+	if (f_open(&fil, "index.db", FA_WRITE | FA_CREATE_ALWAYS) != FR_OK ||
+	    f_write(&fil, index_copy, INDEX_SIZE, &bw) != FR_OK || bw != INDEX_SIZE ||
+	    f_close(&fil) != FR_OK)
+		fail("index");
+}
+
+static void check_index(void)
+{
+	static uint8_t buf[INDEX_SIZE];
+	FIL fil;
+	UINT br;
+
+	if (f_open(&fil, "index.db", FA_READ) != FR_OK ||
+	    f_read(&fil, buf, INDEX_SIZE, &br) != FR_OK || br != INDEX_SIZE ||
+	    memcmp(buf, index_copy, INDEX_SIZE) != 0)
+		fail("index data");
+	f_close(&fil);
+}
+
+static void report(const char *what, uint32_t bytes)
+{
+	printf("%-14s %7u %6u %7u %7u %7u %6u %9.1f %7.2f\n", what, cs.calls, cs.opens,
+	       cs.cmds, cs.reads, cs.writes, cs.erases, cs.us / 1000.0,
+	       bytes / (double)cs.us);
+	memset(&cs, 0, sizeof(cs));
+}
+
+int main(int argc, char **argv)
+{
+	const char *path = argc > 1 ? argv[1] : "/tmp/sd_bench.img";
+	static FATFS fs;
+	DWORD n = 0;
+
+	img_fd = fat_image_create(path, IMG_SECTORS, IMG_SPC);
+	if (img_fd < 0)
+		return 1;
+	card.state = MMC_STATE_PRESENT | MMC_STATE_BLOCKADDR;
+	card.csd.capacity = IMG_SECTORS / 2;
+	if (f_mount(&fs, "", 1) != FR_OK) {
+		printf("cannot mount\n");
+		return 1;
+	}
+	if (disk_ioctl(0, GET_SECTOR_COUNT, &n) != RES_OK || n != IMG_SECTORS)
+		fail("sector count");
+#ifdef SDMMC_RA_SECTORS
+	printf("read ahead %d, write gather %d sectors, trim %d",
+	       SDMMC_RA_SECTORS, SDMMC_WB_SECTORS, _USE_TRIM);
+#else
+	printf("default read ahead and write gather, trim %d", _USE_TRIM);
+#endif
+#if _USE_DISKCACHE
+	printf(", disk cache %d sectors, %d pinned\n\n", _DISKCACHE_SECTORS, _DISKCACHE_PINNED);
+#else
+	printf(", no disk cache\n\n");
+#endif
+	printf("%-14s %7s %6s %7s %7s %7s %6s %9s %7s\n", "workload", "calls", "opens",
+	       "cmds", "reads", "writes", "erases", "card ms", "MB/s");
+	memset(&cs, 0, sizeof(cs));
+
+	write_file("song.mp3", 1, PLAY_SIZE, WRITE_CHUNK, 0);
+	write_file("song2.mp3", 2, PLAY_SIZE, WRITE_CHUNK, 0);
+	memset(&cs, 0, sizeof(cs));
+
+	read_file("song.mp3", 1, PLAY_OFS, CHUNK, 0);
+	report("playback", PLAY_SIZE - PLAY_OFS);
+	read_file("song2.mp3", 2, 0, CHUNK, 1);
+	report("random 4K", RAND_READS * CHUNK);
+	write_file("log.txt", 3, LOG_LINES * LOG_LINE, LOG_LINE, 50);
+	report("log lines", LOG_LINES * LOG_LINE);
+	write_file("record.wav", 4, WRITE_SIZE, WRITE_CHUNK, 0);
+	report("write 32K", WRITE_SIZE);
+	media_setup();
+	memset(&cs, 0, sizeof(cs));
+#if _USE_DISKCACHE
+	disk_cache_stat(0, NULL, 1);
+#endif
+	mixed("song.mp3", 1);
+	report("mixed", MIX_ROUNDS * (CHUNK + LOG_LINE));
+	printf("%-14s round %.3f ms, max %.3f ms\n", "", mix_us / 1000.0 / MIX_ROUNDS,
+	       mix_max_us / 1000.0);
+#if _USE_DISKCACHE
+	{
+		DISKCACHE_STAT st;
+
+		disk_cache_stat(0, &st, 0);
+		printf("%-14s meta %u/%u, data %u/%u hits/misses, %u writes absorbed, "
+		       "%u written back\n", "", st.meta_hits, st.meta_misses, st.data_hits,
+		       st.data_misses, st.write_hits, st.write_backs);
+	}
+#endif
+	if (f_unlink("song2.mp3") != FR_OK)
+		fail("unlink");
+	report("unlink", 0);
+
+	/* everything must be on the card after the eject */
+	f_mount(0, "", 0);
+	disk_ioctl(0, CTRL_EJECT, NULL);
+	if (card_ref != 0)
+		fail("card still open");
+	if (f_mount(&fs, "", 1) != FR_OK) {
+		printf("cannot mount again\n");
+		return 1;
+	}
+	read_file("song.mp3", 1, 0, CHUNK, 0);
+	read_file("log.txt", 3, 0, CHUNK, 0);
+	read_file("record.wav", 4, 0, CHUNK, 0);
+	read_file("mixlog.txt", 5, 0, CHUNK, 0);
+	check_index();
+	f_mount(0, "", 0);
+	disk_ioctl(0, CTRL_EJECT, NULL);
+
+	close(img_fd);
+	unlink(path);
+	printf("\n%s\n", errors ? "FAIL" : "PASS");
+	return errors != 0;
+}
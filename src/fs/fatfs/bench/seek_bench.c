@@ -0,0 +1,332 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Linux benchmark of f_lseek on a fragmented FAT32 image file. The image is
+ * formatted here, then a few media files are written interleaved a few
+ * clusters at a time, so their chains are in thousands of fragments. The
+ * files are reopened and read at random offsets, every read is checked
+ * against the written pattern.
+ *
+ *   ./run.sh              builds ff.c with and without the seek cache
+ *
+ * or by hand, from this directory:
+ *
+ *   gcc -O2 -Wall -Iport -I../../../../include -D_USE_SEEKCACHE=1 \
+ *       seek_bench.c fat_image.c ../ff.c ../option/unicode.c -o seek_cache
+ *   ./seek_cache /tmp/seek_bench.img
+ *
+ * The sector reads done by the seeks are counted, and turned into card time
+ * at SD_READ_US per single-sector read. At the end a file is truncated and
+ * another removed, the seeks must still read the right data.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "fs/fatfs/ff.h"
+#include "fs/fatfs/diskio.h"
+#include "fat_image.h"
+
+#define IMG_SECTORS		(1024 * 1024)	/* 512 MiB */
+#define IMG_SPC			8				/* 4 KiB clusters */
+#define NFILES			4
+#define FILE_SIZE		(40 * 1024 * 1024)
+#define MAX_CHUNK		8				/* clusters written to a file in a row */
+#define NSEEKS			4000
+#define READ_LEN		256
+#define SD_READ_US		250
+
+static int img_fd = -1;
+static uint32_t sector_reads;
+
+static uint32_t rnd_state = 0x2545F491;
+
+static uint32_t rnd(void)
+{
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+	return rnd_state;
+}
+
+static uint64_t now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* diskio over the image file */
+DSTATUS disk_initialize(BYTE pdrv)
+{
+	return img_fd < 0 ? STA_NOINIT : 0;
+}
+
+DSTATUS disk_status(BYTE pdrv)
+{
+	return img_fd < 0 ? STA_NOINIT : 0;
+}
+
+DRESULT disk_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
+{
+	sector_reads += count;
+	if (pread(img_fd, buff, count * 512, (off_t)sector * 512) != (ssize_t)count * 512)
+		return RES_ERROR;
+	return RES_OK;
+}
+
+DRESULT disk_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
+{
+	if (pwrite(img_fd, buff, count * 512, (off_t)sector * 512) != (ssize_t)count * 512)
+		return RES_ERROR;
+	return RES_OK;
+}
+
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
+{
+	return cmd == CTRL_SYNC ? RES_OK : RES_PARERR;
+}
+
+/* option/syscall.c for one thread */
+int ff_cre_syncobj(BYTE vol, _SYNC_t *sobj) { return 1; }
+int ff_req_grant(_SYNC_t sobj) { return 1; }
+void ff_rel_grant(_SYNC_t sobj) { }
+int ff_del_syncobj(_SYNC_t sobj) { return 1; }
+void *ff_memalloc(UINT msize) { return malloc(msize); }
+void ff_memfree(void *mblock) { free(mblock); }
+#if _USE_SEEKCACHE
+DWORD ff_get_ms(void) { return (DWORD)(now_us() / 1000); }
+#endif
+
+static uint32_t pattern(int file, uint32_t ofs)
+{
+	return ((uint32_t)file << 28) | (ofs / 4);
+}
+
+static void fill(uint8_t *buf, int file, uint32_t ofs, uint32_t len)
+{
+	uint32_t i, w;
+
+	for (i = 0; i < len; i += 4) {
+		w = pattern(file, ofs + i);
+		memcpy(buf + i, &w, 4);
+	}
+}
+
+static int write_files(void)
+{
+	static uint8_t buf[MAX_CHUNK * IMG_SPC * 512];
+	FIL fil[NFILES];
+	char name[16];
+	uint32_t size[NFILES] = { 0 }, len;
+	UINT bw;
+	int i, left = NFILES;
+
+	for (i = 0; i < NFILES; i++) {
+		snprintf(name, sizeof(name), "story%d.mp3", i);
+		if (f_open(&fil[i], name, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+			return -1;
+	}
+	while (left) {
+		i = rnd() % NFILES;
+		if (size[i] >= FILE_SIZE)
+			continue;
+		len = (1 + rnd() % MAX_CHUNK) * IMG_SPC * 512;
+		if (len > FILE_SIZE - size[i])
+			len = FILE_SIZE - size[i];
+		fill(buf, i, size[i], len);
+		if (f_write(&fil[i], buf, len, &bw) != FR_OK || bw != len)
+			return -1;
+		size[i] += len;
+		if (size[i] == FILE_SIZE)
+			left--;
+	}
+	for (i = 0; i < NFILES; i++)
+		f_close(&fil[i]);
+	return 0;
+}
+
+/* Fragments of the chain of a file, for the report */
+static uint32_t count_fragments(const char *name)
+{
+	static uint8_t sec[512];
+	FILINFO fno;
+	FIL fil;
+	uint32_t n = 0, ofs, prev = 0, clst;
+	UINT br;
+
+	if (f_stat(name, &fno) != FR_OK || f_open(&fil, name, FA_READ) != FR_OK)
+		return 0;
+	for (ofs = 0; ofs < fno.fsize; ofs += IMG_SPC * 512) {
+		f_lseek(&fil, ofs);
+		f_read(&fil, sec, 1, &br);
+		clst = fil.clust;
+		if (clst != prev + 1)
+			n++;
+		prev = clst;
+	}
+	f_close(&fil);
+	return n;
+}
+
+struct result {
+	uint32_t seeks;
+	uint32_t reads;
+	uint32_t max_reads;
+	uint64_t us;
+	uint32_t max_us;
+	uint32_t errors;
+};
+
+/* Reopen files in turn and read them at random offsets */
+static void seek_round(int nfiles, uint32_t size, struct result *r)
+{
+	static uint8_t buf[READ_LEN];
+	char name[16];
+	FIL fil;
+	uint32_t ofs, reads, us, i, w;
+	uint64_t t;
+	UINT br;
+	int n, f;
+
+	memset(r, 0, sizeof(*r));
+	for (n = 0; n < NSEEKS; n += 50) {
+		f = (n / 50) % nfiles;
+		snprintf(name, sizeof(name), "story%d.mp3", f);
+		if (f_open(&fil, name, FA_READ) != FR_OK) {
+			r->errors++;
+			continue;
+		}
+		for (i = 0; i < 50; i++) {
+			ofs = (rnd() % (size / 4 - READ_LEN / 4)) * 4;
+			reads = sector_reads;
+			t = now_us();
+			if (f_lseek(&fil, ofs) != FR_OK)
+				r->errors++;
+			us = (uint32_t)(now_us() - t);
+			reads = sector_reads - reads;
+			r->seeks++;
+			r->reads += reads;
+			r->us += us;
+			if (reads > r->max_reads)
+				r->max_reads = reads;
+			if (us > r->max_us)
+				r->max_us = us;
+			if (f_read(&fil, buf, READ_LEN, &br) != FR_OK || br != READ_LEN) {
+				r->errors++;
+				continue;
+			}
+			for (w = 0; w < READ_LEN; w += 4) {
+				uint32_t v;
+				memcpy(&v, buf + w, 4);
+				if (v != pattern(f, ofs + w)) {
+					r->errors++;
+					break;
+				}
+			}
+		}
+		f_close(&fil);
+	}
+}
+
+static void report(const char *what, const struct result *r)
+{
+	printf("%-22s %6u %9.2f %6u %9.2f %8u %9.2f %7u\n", what, r->seeks,
+	       (double)r->reads / r->seeks, r->max_reads,
+	       (double)r->reads * SD_READ_US / 1000 / r->seeks,
+	       r->max_reads * SD_READ_US / 1000,
+	       (double)r->us / r->seeks, r->errors);
+}
+
+int main(int argc, char **argv)
+{
+	const char *path = argc > 1 ? argv[1] : "/tmp/seek_bench.img";
+	static FATFS fs;
+	struct result r;
+	uint32_t errors = 0;
+	FIL fil;
+
+	img_fd = fat_image_create(path, IMG_SECTORS, IMG_SPC);
+	if (img_fd < 0 || f_mount(&fs, "", 1) != FR_OK) {
+		printf("cannot make the volume\n");
+		return 1;
+	}
+	if (write_files() != 0) {
+		printf("cannot write the files\n");
+		return 1;
+	}
+	printf("%d files of %u MiB, %u fragments in story0.mp3\n",
+	       NFILES, FILE_SIZE >> 20, count_fragments("story0.mp3"));
+	printf("seek cache %s\n\n", _USE_SEEKCACHE ? "on" : "off");
+#if _USE_SEEKCACHE
+	f_seekstat(0, 1);
+#endif
+
+	printf("%-22s %6s %9s %6s %9s %8s %9s %7s\n", "case", "seeks",
+	       "reads", "max", "sd ms", "max ms", "host us", "errors");
+	seek_round(1, FILE_SIZE, &r);
+	report("1 file", &r);
+	errors += r.errors;
+	seek_round(NFILES, FILE_SIZE, &r);
+	report("4 files in turn", &r);
+	errors += r.errors;
+
+	/* Truncate story0 and remove story1, the maps must not outlive them */
+	if (f_open(&fil, "story0.mp3", FA_READ | FA_WRITE) != FR_OK ||
+	    f_lseek(&fil, FILE_SIZE / 2) != FR_OK || f_truncate(&fil) != FR_OK ||
+	    f_close(&fil) != FR_OK || f_unlink("story1.mp3") != FR_OK) {
+		printf("cannot truncate or remove\n");
+		return 1;
+	}
+	seek_round(1, FILE_SIZE / 2, &r);
+	report("after truncate", &r);
+	errors += r.errors;
+
+#if _USE_SEEKCACHE
+	{
+		FFSEEKSTAT st;
+
+		f_seekstat(&st, 0);
+		printf("\nf_seekstat: %u seeks, %u with a map, %u hits, %u builds, "
+		       "%u links, max %u links, max %u ms\n", st.seeks, st.map_seeks,
+		       st.hits, st.builds, st.links, st.max_links, st.max_ms);
+	}
+#endif
+	f_mount(0, "", 0);
+	close(img_fd);
+	unlink(path);
+	printf("\n%s\n", errors ? "FAIL" : "PASS");
+	return errors != 0;
+}
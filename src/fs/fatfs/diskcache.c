@@ -0,0 +1,442 @@
+/*-----------------------------------------------------------------------*/
+/* Sector cache between FatFs and the disk drivers                       */
+/*-----------------------------------------------------------------------*/
+/* Single sector transfers are kept in _DISKCACHE_SECTORS sectors. The   */
+/* victim is the least recently used data sector while the FAT,         */
+/* directory and FSInfo sectors are within _DISKCACHE_PINNED, they are   */
+/* plain LRU beyond. Writes are held until the sector is evicted or the  */
+/* cache flushed, which writes the data sectors and then the others in   */
+/* sector order. Multiple sector transfers go to the device, a read gets */
+/* the dirty sectors of its range from the cache and a write refreshes   */
+/* the cached ones. The lock serializes the device I/O of the drive, so  */
+/* disk_cache_flush() can be called out of the FatFs threads.            */
+/*-----------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "fs/fatfs/ff.h"
+#include "fs/fatfs/diskcache.h"
+
+#if _USE_DISKCACHE
+
+#if _DISKCACHE_SECTORS < 2 || _DISKCACHE_PINNED >= _DISKCACHE_SECTORS
+#error Wrong _DISKCACHE_SECTORS or _DISKCACHE_PINNED setting
+#endif
+#if _MAX_SS != _MIN_SS
+#error The disk cache needs a fixed sector size
+#endif
+
+#define	DC_VALID	0x01
+#define	DC_DIRTY	0x02
+#define	DC_META		0x04	/* FAT, directory or FSInfo sector */
+
+typedef struct {
+	DWORD	sector;
+	DWORD	stamp;			/* Last access */
+	BYTE	flag;
+} DCENT;
+
+typedef struct {
+	const DISKCACHE_OPS* ops;	/* Device of the drive (0:not attached) */
+	BYTE*	buf;			/* Sectors of the entries (0:no cache) */
+	DCENT*	ent;
+	DWORD	stamp;
+	UINT	nmeta;			/* Entries with DC_META */
+	DISKCACHE_STAT stat;
+	OS_Mutex_t lock;
+	BYTE	lock_ok;
+} DISKCACHE;
+
+static DISKCACHE Cache[_VOLUMES];
+
+#define	DC_LOCK(dc)		OS_MutexLock(&(dc)->lock, OS_WAIT_FOREVER)
+#define	DC_UNLOCK(dc)	OS_MutexUnlock(&(dc)->lock)
+#define	DC_SECT(dc, i)	((dc)->buf + (UINT)(i) * _MAX_SS)
+
+
+
+static
+int dc_find (		/* Entry of the sector, -1:not cached */
+	DISKCACHE* dc,
+	DWORD sector
+)
+{
+	int i;
+
+
+	for (i = 0; i < _DISKCACHE_SECTORS; i++) {
+		if ((dc->ent[i].flag & DC_VALID) && dc->ent[i].sector == sector) return i;
+	}
+	return -1;
+}
+
+
+static
+void dc_use (
+	DISKCACHE* dc,
+	int i,
+	BYTE meta
+)
+{
+	DCENT* e = &dc->ent[i];
+
+
+	if (meta && !(e->flag & DC_META)) {
+		e->flag |= DC_META;
+		dc->nmeta++;
+	}
+	e->stamp = ++dc->stamp;
+}
+
+
+static
+int dc_older (
+	DISKCACHE* dc,
+	int a,
+	int b
+)
+{
+	return (LONG)(dc->ent[a].stamp - dc->ent[b].stamp) < 0;
+}
+
+
+static
+int dc_slot (		/* Free entry for a sector, -1:write back error */
+	DISKCACHE* dc,
+	BYTE meta
+)
+{
+	DCENT* e;
+	int i, lru_meta = -1, lru_data = -1;
+
+
+	for (i = 0; i < _DISKCACHE_SECTORS; i++) {
+		e = &dc->ent[i];
+		if (!(e->flag & DC_VALID)) return i;
+		if (e->flag & DC_META) {
+			if (lru_meta < 0 || dc_older(dc, i, lru_meta)) lru_meta = i;
+		} else {
+			if (lru_data < 0 || dc_older(dc, i, lru_data)) lru_data = i;
+		}
+	}
+	if (lru_data < 0) {
+		i = lru_meta;
+	} else if (lru_meta < 0) {
+		i = lru_data;
+	} else if (dc->nmeta > _DISKCACHE_PINNED) {		/* Over the quota, plain LRU */
+		i = dc_older(dc, lru_meta, lru_data) ? lru_meta : lru_data;
+	} else if (meta && dc->nmeta == _DISKCACHE_PINNED) {
+		i = lru_meta;
+	} else {
+		i = lru_data;
+	}
+
+	e = &dc->ent[i];
+	if (e->flag & DC_DIRTY) {
+		if (dc->ops->write(DC_SECT(dc, i), e->sector, 1) != RES_OK) return -1;
+		dc->stat.write_backs++;
+	}
+	if (e->flag & DC_META) dc->nmeta--;
+	e->flag = 0;
+	dc->stat.evictions++;
+	return i;
+}
+
+
+static
+DRESULT dc_write_back (	/* Write the dirty data sectors, then the others */
+	DISKCACHE* dc
+)
+{
+	static const BYTE order[2] = { 0, DC_META };
+	DCENT* e;
+	UINT k;
+	int i, n;
+
+
+	for (k = 0; k < 2; k++) {
+		for (;;) {
+			n = -1;
+			for (i = 0; i < _DISKCACHE_SECTORS; i++) {
+				e = &dc->ent[i];
+				if ((e->flag & (DC_DIRTY | DC_META)) == (DC_DIRTY | order[k]) &&
+					(n < 0 || e->sector < dc->ent[n].sector)) n = i;
+			}
+			if (n < 0) break;
+			if (dc->ops->write(DC_SECT(dc, n), dc->ent[n].sector, 1) != RES_OK) return RES_ERROR;
+			dc->ent[n].flag &= ~DC_DIRTY;
+			dc->stat.write_backs++;
+		}
+	}
+	return RES_OK;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Attach the device of a drive, allocate the cache                      */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_cache_attach (
+	BYTE pdrv,					/* Physical drive number */
+	const DISKCACHE_OPS* ops	/* Device I/O */
+)
+{
+	DISKCACHE* dc;
+
+
+	if (pdrv >= _VOLUMES) return RES_PARERR;
+	dc = &Cache[pdrv];
+	if (!dc->lock_ok) {
+		if (OS_MutexCreate(&dc->lock) != OS_OK) return RES_ERROR;
+		dc->lock_ok = 1;
+	}
+
+	DC_LOCK(dc);
+	dc->ops = ops;
+	if (dc->buf == NULL) {	/* Without memory the transfers go to the device */
+		dc->buf = malloc(_DISKCACHE_SECTORS * (_MAX_SS + sizeof(DCENT)));
+		if (dc->buf != NULL) {
+			dc->ent = (DCENT*)DC_SECT(dc, _DISKCACHE_SECTORS);
+			memset(dc->ent, 0, _DISKCACHE_SECTORS * sizeof(DCENT));
+			dc->nmeta = 0;
+		}
+	}
+	DC_UNLOCK(dc);
+	return RES_OK;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Detach the device, the dirty sectors are dropped                      */
+/*-----------------------------------------------------------------------*/
+
+void disk_cache_detach (
+	BYTE pdrv
+)
+{
+	DISKCACHE* dc;
+
+
+	if (pdrv >= _VOLUMES || !Cache[pdrv].lock_ok) return;
+	dc = &Cache[pdrv];
+
+	DC_LOCK(dc);
+	free(dc->buf);
+	dc->buf = NULL;
+	dc->ent = NULL;
+	dc->nmeta = 0;
+	dc->ops = NULL;
+	DC_UNLOCK(dc);
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Read Sector(s)                                                        */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_cache_read (
+	BYTE pdrv,
+	BYTE* buff,
+	DWORD sector,
+	UINT count,
+	BYTE meta			/* 1:FAT, directory or FSInfo sector */
+)
+{
+	DISKCACHE* dc;
+	DRESULT res;
+	int i;
+
+
+	if (pdrv >= _VOLUMES || !Cache[pdrv].lock_ok) return RES_NOTRDY;
+	dc = &Cache[pdrv];
+
+	DC_LOCK(dc);
+	if (dc->ops == NULL) {
+		res = RES_NOTRDY;
+	} else if (dc->buf == NULL) {
+		res = dc->ops->read(buff, sector, count);
+	} else if (count == 1) {
+		res = RES_OK;
+		i = dc_find(dc, sector);
+		if (i >= 0) {
+			if (meta || (dc->ent[i].flag & DC_META)) dc->stat.meta_hits++; else dc->stat.data_hits++;
+		} else {
+			if (meta) dc->stat.meta_misses++; else dc->stat.data_misses++;
+			i = dc_slot(dc, meta);
+			if (i < 0 || dc->ops->read(DC_SECT(dc, i), sector, 1) != RES_OK) {
+				res = RES_ERROR;
+			} else {
+				dc->ent[i].sector = sector;
+				dc->ent[i].flag = DC_VALID;
+			}
+		}
+		if (res == RES_OK) {
+			dc_use(dc, i, meta);
+			memcpy(buff, DC_SECT(dc, i), _MAX_SS);
+		}
+	} else {
+		dc->stat.bypasses++;
+		res = dc->ops->read(buff, sector, count);
+		if (res == RES_OK) {	/* Newer data of the range are in the cache */
+			for (i = 0; i < _DISKCACHE_SECTORS; i++) {
+				if ((dc->ent[i].flag & DC_DIRTY) && dc->ent[i].sector - sector < count) {
+					memcpy(buff + (dc->ent[i].sector - sector) * _MAX_SS, DC_SECT(dc, i), _MAX_SS);
+				}
+			}
+		}
+	}
+	DC_UNLOCK(dc);
+	return res;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Write Sector(s)                                                       */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_cache_write (
+	BYTE pdrv,
+	const BYTE* buff,
+	DWORD sector,
+	UINT count,
+	BYTE meta			/* 1:FAT, directory or FSInfo sector */
+)
+{
+	DISKCACHE* dc;
+	DRESULT res;
+	int i;
+
+
+	if (pdrv >= _VOLUMES || !Cache[pdrv].lock_ok) return RES_NOTRDY;
+	dc = &Cache[pdrv];
+
+	DC_LOCK(dc);
+	if (dc->ops == NULL) {
+		res = RES_NOTRDY;
+	} else if (dc->buf == NULL) {
+		res = dc->ops->write(buff, sector, count);
+	} else if (count == 1) {
+		res = RES_OK;
+		i = dc_find(dc, sector);
+		if (i >= 0) {
+			dc->stat.write_hits++;
+		} else {
+			i = dc_slot(dc, meta);
+			if (i < 0) {
+				res = RES_ERROR;
+			} else {
+				dc->ent[i].sector = sector;
+				dc->ent[i].flag = DC_VALID;
+			}
+		}
+		if (res == RES_OK) {
+			dc_use(dc, i, meta);
+			memcpy(DC_SECT(dc, i), buff, _MAX_SS);
+			dc->ent[i].flag |= DC_DIRTY;
+		}
+	} else {
+		dc->stat.bypasses++;
+		res = dc->ops->write(buff, sector, count);
+		if (res == RES_OK) {	/* Refresh the cached sectors of the range */
+			for (i = 0; i < _DISKCACHE_SECTORS; i++) {
+				if ((dc->ent[i].flag & DC_VALID) && dc->ent[i].sector - sector < count) {
+					memcpy(DC_SECT(dc, i), buff + (dc->ent[i].sector - sector) * _MAX_SS, _MAX_SS);
+					dc->ent[i].flag &= ~DC_DIRTY;
+				}
+			}
+		}
+	}
+	DC_UNLOCK(dc);
+	return res;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Write back the dirty sectors and sync the device                      */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_cache_flush (
+	BYTE pdrv
+)
+{
+	DISKCACHE* dc;
+	DRESULT res;
+
+
+	if (pdrv >= _VOLUMES || !Cache[pdrv].lock_ok) return RES_NOTRDY;
+	dc = &Cache[pdrv];
+
+	DC_LOCK(dc);
+	if (dc->ops == NULL) {
+		res = RES_NOTRDY;
+	} else {
+		dc->stat.flushes++;
+		res = dc->buf != NULL ? dc_write_back(dc) : RES_OK;
+		if (res == RES_OK) res = dc->ops->sync();
+	}
+	DC_UNLOCK(dc);
+	return res;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Drop the sectors start to end, they are no longer used                */
+/*-----------------------------------------------------------------------*/
+
+void disk_cache_trim (
+	BYTE pdrv,
+	DWORD start,
+	DWORD end
+)
+{
+	DISKCACHE* dc;
+	int i;
+
+
+	if (pdrv >= _VOLUMES || !Cache[pdrv].lock_ok) return;
+	dc = &Cache[pdrv];
+
+	DC_LOCK(dc);
+	if (dc->buf != NULL) {
+		for (i = 0; i < _DISKCACHE_SECTORS; i++) {
+			if ((dc->ent[i].flag & DC_VALID) && dc->ent[i].sector - start <= end - start) {
+				if (dc->ent[i].flag & DC_META) dc->nmeta--;
+				dc->ent[i].flag = 0;
+			}
+		}
+	}
+	DC_UNLOCK(dc);
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Get the cache statistics                                              */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_cache_stat (
+	BYTE pdrv,
+	DISKCACHE_STAT* st,		/* Pointer to return the statistics */
+	BYTE reset				/* 1:Clear them after the copy */
+)
+{
+	DISKCACHE* dc;
+
+
+	if (pdrv >= _VOLUMES || !Cache[pdrv].lock_ok) return RES_NOTRDY;
+	dc = &Cache[pdrv];
+
+	DC_LOCK(dc);
+	if (st) *st = dc->stat;
+	if (reset) memset(&dc->stat, 0, sizeof(dc->stat));
+	DC_UNLOCK(dc);
+	return RES_OK;
+}
+
+#endif	/* _USE_DISKCACHE */
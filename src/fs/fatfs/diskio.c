@@ -7,7 +7,9 @@
 /* storage control modules to the FatFs module with a defined API.       */
 /*-----------------------------------------------------------------------*/
 
+#include "fs/fatfs/ff.h"			/* FatFs configuration */
 #include "fs/fatfs/diskio.h"		/* FatFs lower layer API */
+#include "fs/fatfs/diskcache.h"
 
 #include "driver/sdmmc_diskio.h"
 #include <stdio.h>	//for debug
@@ -20,6 +22,17 @@
 #define SUPPORT_DEV_RAM 0
 #define SUPPORT_DEV_USB 0
 
+#if _USE_DISKCACHE
+static DRESULT SDMMC_sync(void)
+{
+	return SDMMC_ioctl(CTRL_SYNC, 0);
+}
+
+static const DISKCACHE_OPS sdmmc_cache_ops = {
+	SDMMC_read, SDMMC_write, SDMMC_sync
+};
+#endif
+
 /*-----------------------------------------------------------------------*/
 /* Get Drive Status                                                      */
 /*-----------------------------------------------------------------------*/
@@ -87,6 +100,10 @@ DSTATUS disk_initialize (
 		result = SDMMC_initialize();
 
 		stat = result;// translate the reslut code here
+#if _USE_DISKCACHE
+		if (!(stat & STA_NOINIT))
+			disk_cache_attach(pdrv, &sdmmc_cache_ops);
+#endif
 
 		return stat;
 
@@ -133,7 +150,11 @@ DRESULT disk_read (
 	case DEV_MMC :
 		// translate the arguments here
 
+#if _USE_DISKCACHE
+		result = disk_cache_read(pdrv, buff, sector, count, 0);
+#else
 		result = SDMMC_read(buff, sector, count);
+#endif
 
 		res = result;// translate the reslut code here
 
@@ -185,7 +206,11 @@ DRESULT disk_write (
 	case DEV_MMC :
 		// translate the arguments here
 
+#if _USE_DISKCACHE
+		result = disk_cache_write(pdrv, buff, sector, count, 0);
+#else
 		result = SDMMC_write(buff, sector, count);
+#endif
 
 		res = result;// translate the reslut code here
 
@@ -232,6 +257,20 @@ DRESULT disk_ioctl (
 
 	case DEV_MMC :
 
+#if _USE_DISKCACHE
+		if (cmd == CTRL_SYNC) {
+			res = disk_cache_flush(pdrv);
+			return res;
+		}
+		if (cmd == CTRL_EJECT) {
+			disk_cache_flush(pdrv);
+			disk_cache_detach(pdrv);
+		}
+#if _USE_TRIM
+		if (cmd == CTRL_TRIM)
+			disk_cache_trim(pdrv, ((DWORD *)buff)[0], ((DWORD *)buff)[1]);
+#endif
+#endif
 		result = SDMMC_ioctl(cmd, buff);// Process of the command for the MMC/SD card
 
 		res = result;
@@ -250,3 +289,41 @@ DRESULT disk_ioctl (
 	return RES_PARERR;
 }
 
+
+
+#if _USE_DISKCACHE
+/*-----------------------------------------------------------------------*/
+/* FAT, directory and FSInfo Sector(s), pinned in the disk cache         */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_read_meta (
+	BYTE pdrv,		/* Physical drive nmuber to identify the drive */
+	BYTE *buff,		/* Data buffer to store read data */
+	DWORD sector,	/* Start sector in LBA */
+	UINT count		/* Number of sectors to read */
+)
+{
+	switch (pdrv) {
+	case DEV_MMC :
+		return disk_cache_read(pdrv, buff, sector, count, 1);
+	}
+
+	return disk_read(pdrv, buff, sector, count);
+}
+
+
+DRESULT disk_write_meta (
+	BYTE pdrv,			/* Physical drive nmuber to identify the drive */
+	const BYTE *buff,	/* Data to be written */
+	DWORD sector,		/* Start sector in LBA */
+	UINT count			/* Number of sectors to write */
+)
+{
+	switch (pdrv) {
+	case DEV_MMC :
+		return disk_cache_write(pdrv, buff, sector, count, 1);
+	}
+
+	return disk_write(pdrv, buff, sector, count);
+}
+#endif
@@ -27,10 +27,47 @@
 /* Block Size in Bytes */
 #define BLOCK_SIZE                512
 
+/*
+ * The card is opened by the first initialize and kept until CTRL_EJECT.
+ * A read starting where the previous one ended is read ahead to
+ * SDMMC_RA_SECTORS with one CMD18, and writes of less than SDMMC_WB_SECTORS
+ * are gathered while they follow each other, then go in one CMD25 with the
+ * next write, on CTRL_SYNC or before a read of them. FatFs sends CTRL_SYNC
+ * on f_sync() and f_close(), so nothing is held past those. Both buffers are
+ * allocated at initialize, 0 disables them.
+ */
+#ifndef SDMMC_RA_SECTORS
+#define SDMMC_RA_SECTORS          16
+#endif
+#ifndef SDMMC_WB_SECTORS
+#define SDMMC_WB_SECTORS          8
+#endif
+
+/* Sectors of one transfer, SDXC_MAX_TRANS_LEN / BLOCK_SIZE of sdhost.h */
+#ifdef __CONFIG_ARCH_APP_CORE
+#define SDMMC_MAX_SECTORS         512
+#else
+#define SDMMC_MAX_SECTORS         32
+#endif
+
+#define SDMMC_CARD_ID             0
+
 /* Private variables ---------------------------------------------------------*/
 /* Disk status */
 static volatile DSTATUS Stat = STA_NOINIT;
 
+static struct mmc_card *sd_card;
+static DWORD sd_sectors;
+
+static BYTE *sd_ra;             /* read ahead sectors */
+static DWORD sd_ra_sector;
+static UINT sd_ra_count;
+static DWORD sd_next_sector;    /* sector following the last read */
+
+static BYTE *sd_wb;             /* gathered write sectors */
+static DWORD sd_wb_sector;
+static UINT sd_wb_count;
+
 /* Private function prototypes -----------------------------------------------*/
 DSTATUS SD_initialize (BYTE);
 DSTATUS SD_status (BYTE);
@@ -52,6 +89,66 @@ DRESULT SD_read (BYTE, BYTE*, DWORD, UINT);
 #define SDMMC_ENTRY()
 #endif
 
+static int SDMMC_card_read(BYTE *buff, DWORD sector, UINT count)
+{
+	UINT n;
+
+	while (count) {
+		n = count > SDMMC_MAX_SECTORS ? SDMMC_MAX_SECTORS : count;
+		if (mmc_block_read(sd_card, buff, sector, n) != 0) {
+			SDMMC_DEBUG("sdmmc driver read failed\n");
+			return -1;
+		}
+		buff += n * BLOCK_SIZE;
+		sector += n;
+		count -= n;
+	}
+	return 0;
+}
+
+static int SDMMC_card_write(const BYTE *buff, DWORD sector, UINT count)
+{
+	UINT n;
+
+	while (count) {
+		n = count > SDMMC_MAX_SECTORS ? SDMMC_MAX_SECTORS : count;
+		if (mmc_block_write(sd_card, buff, sector, n) != 0) {
+			SDMMC_DEBUG("sdmmc driver write failed\n");
+			return -1;
+		}
+		buff += n * BLOCK_SIZE;
+		sector += n;
+		count -= n;
+	}
+	return 0;
+}
+
+static int SDMMC_flush(void)
+{
+	int err = 0;
+
+	if (sd_wb_count) {
+		err = SDMMC_card_write(sd_wb, sd_wb_sector, sd_wb_count);
+		sd_wb_count = 0;
+	}
+	return err;
+}
+
+static void SDMMC_close(void)
+{
+	SDMMC_flush();
+	if (sd_card != NULL) {
+		mmc_card_close(SDMMC_CARD_ID);
+		sd_card = NULL;
+	}
+	if (sd_ra != NULL) {
+		free(sd_ra);
+		sd_ra = NULL;
+		sd_wb = NULL;
+	}
+	sd_ra_count = 0;
+	Stat = STA_NOINIT;
+}
 
 /**
   * @brief  Initializes a Drive
@@ -64,14 +161,40 @@ DSTATUS SDMMC_initialize()
 
 	SDMMC_ENTRY();
 
+	if (sd_card != NULL) {
+		if (mmc_card_present(sd_card))
+			return Stat;
+		SDMMC_close();          /* card changed, open it again */
+	}
+
 	Stat = STA_NOINIT;
-	card = mmc_card_open(0);
-	if (card != NULL) {
-		if (mmc_card_present(card)) {
-			Stat &= ~STA_NOINIT;
-		}
+	card = mmc_card_open(SDMMC_CARD_ID);
+	if (card == NULL)
+		return Stat;
+	if (!mmc_card_present(card)) {
+		mmc_card_close(SDMMC_CARD_ID);
+		return Stat;
 	}
-	mmc_card_close(0);
+
+	sd_card = card;
+	if (mmc_card_blockaddr(card))
+		sd_sectors = card->csd.capacity * 2;    /* KB */
+	else
+		sd_sectors = card->csd.capacity / BLOCK_SIZE;
+
+#if SDMMC_RA_SECTORS || SDMMC_WB_SECTORS
+	/* word aligned for the IDMA */
+	sd_ra = malloc((SDMMC_RA_SECTORS + SDMMC_WB_SECTORS) * BLOCK_SIZE);
+	if (sd_ra == NULL)
+		SDMMC_DEBUG("sdmmc driver no buffer, direct transfers\n");
+	else
+		sd_wb = SDMMC_WB_SECTORS ? sd_ra + SDMMC_RA_SECTORS * BLOCK_SIZE : NULL;
+#endif
+	sd_ra_count = 0;
+	sd_wb_count = 0;
+	sd_next_sector = 0;
+
+	Stat &= ~STA_NOINIT;
 	return Stat;
 }
 
@@ -83,7 +206,7 @@ DSTATUS SDMMC_initialize()
 DSTATUS SDMMC_status()
 {
 	SDMMC_ENTRY();
-  	return 0;
+	return Stat;
 }
 
 /**
@@ -94,22 +217,55 @@ DSTATUS SDMMC_status()
   * @param  count: Number of sectors to read (1..128)
   * @retval DRESULT: Operation result
   */
-DRESULT SDMMC_read(BYTE *buff, const DWORD sector, UINT count)
+DRESULT SDMMC_read(BYTE *buff, DWORD sector, UINT count)
 {
-  SDMMC_ENTRY();
-  DRESULT res = RES_ERROR;
-  struct mmc_card *card;
-
-  card = mmc_card_open(0);
-  if (card != NULL) {
-  	if (mmc_block_read(card, buff, sector, count) != 0) {
-		SDMMC_DEBUG("sdmmc driver read failed\n");
- 	} else
-		res = RES_OK;
-  }
-  mmc_card_close(0);
+	DWORD end = sector + count;
+	int seq = (sector == sd_next_sector);
+	UINT n;
+
+	SDMMC_ENTRY();
+
+	if (sd_card == NULL)
+		return RES_NOTRDY;
 
-  return res;
+	/* gathered writes in the range go to the card first */
+	if (sd_wb_count && sector < sd_wb_sector + sd_wb_count &&
+	    sd_wb_sector < end && SDMMC_flush() != 0)
+		return RES_ERROR;
+
+	while (count) {
+		if (sd_ra_count && sector >= sd_ra_sector &&
+		    sector < sd_ra_sector + sd_ra_count) {
+			n = sd_ra_sector + sd_ra_count - sector;
+			if (n > count)
+				n = count;
+			memcpy(buff, sd_ra + (sector - sd_ra_sector) * BLOCK_SIZE, n * BLOCK_SIZE);
+		} else if (SDMMC_RA_SECTORS && sd_ra != NULL && seq &&
+		           count < SDMMC_RA_SECTORS) {
+			n = SDMMC_RA_SECTORS;
+			if (sd_sectors && sector + n > sd_sectors)
+				n = sd_sectors - sector;
+			sd_ra_count = 0;
+			if (sd_wb_count && sector < sd_wb_sector + sd_wb_count &&
+			    sd_wb_sector < sector + n && SDMMC_flush() != 0)
+				return RES_ERROR;
+			if (n < count || SDMMC_card_read(sd_ra, sector, n) != 0)
+				return RES_ERROR;
+			sd_ra_sector = sector;
+			sd_ra_count = n;
+			continue;
+		} else {
+			n = count;
+			if (SDMMC_card_read(buff, sector, n) != 0)
+				return RES_ERROR;
+		}
+		buff += n * BLOCK_SIZE;
+		sector += n;
+		count -= n;
+	}
+
+	sd_next_sector = end;
+	return RES_OK;
 }
 
 /**
@@ -123,23 +279,46 @@ DRESULT SDMMC_read(BYTE *buff, const DWORD sector, UINT count)
 //#if _USE_WRITE == 1
 DRESULT SDMMC_write(const BYTE *buff, DWORD sector, UINT count)
 {
-	int32_t err;
-	struct mmc_card *card;
+	UINT n;
 
 	SDMMC_ENTRY();
-	DRESULT res = RES_ERROR;
 
-	card = mmc_card_open(0);
-	if (card != NULL) {
-		err = mmc_block_write(card, (uint8_t *)buff, sector, count);
-		if (err != 0) {
-			SDMMC_DEBUG("sdmmc driver write failed\n");
-		} else
-			res = RES_OK;
+	if (sd_card == NULL)
+		return RES_NOTRDY;
+
+	if (sd_ra_count && sector < sd_ra_sector + sd_ra_count &&
+	    sd_ra_sector < sector + count)
+		sd_ra_count = 0;
+
+	if (SDMMC_WB_SECTORS && sd_wb != NULL) {
+		if (sd_wb_count && sector == sd_wb_sector + sd_wb_count) {
+			if (sd_wb_count + count <= SDMMC_WB_SECTORS) {
+				memcpy(sd_wb + sd_wb_count * BLOCK_SIZE, buff, count * BLOCK_SIZE);
+				sd_wb_count += count;
+				return RES_OK;
+			}
+			if (sd_wb_count + count <= SDMMC_MAX_SECTORS) {
+				/* the gathered sectors and these in one transfer */
+				n = sd_wb_count;
+				sd_wb_count = 0;
+				if (mmc_block_write2(sd_card, sd_wb, n, buff, count, sd_wb_sector) != 0)
+					return RES_ERROR;
+				return RES_OK;
+			}
+		}
+		if (SDMMC_flush() != 0)
+			return RES_ERROR;
+		if (count < SDMMC_WB_SECTORS) {
+			memcpy(sd_wb, buff, count * BLOCK_SIZE);
+			sd_wb_sector = sector;
+			sd_wb_count = count;
+			return RES_OK;
+		}
 	}
-	mmc_card_close(0);
 
-	return res;
+	if (SDMMC_card_write(buff, sector, count) != 0)
+		return RES_ERROR;
+	return RES_OK;
 }
 //#endif /* _USE_WRITE == 1 */
 
@@ -154,44 +333,63 @@ DRESULT SDMMC_write(const BYTE *buff, DWORD sector, UINT count)
 DRESULT SDMMC_ioctl(BYTE cmd, void *buff)
 {
 	SDMMC_ENTRY();
-  DRESULT res = RES_ERROR;
+	DRESULT res = RES_ERROR;
+#if _USE_TRIM
+	DWORD *rt;
+#endif
 
-  if (Stat & STA_NOINIT) return RES_NOTRDY;
+	if (cmd == CTRL_EJECT) {
+		SDMMC_close();
+		return RES_OK;
+	}
 
-  switch (cmd)
-  {
-  /* Make sure that no pending write process */
-  case CTRL_SYNC :
-    res = RES_OK;
-    break;
+	if (Stat & STA_NOINIT) return RES_NOTRDY;
 
-  /* Get number of sectors on the disk (DWORD) */
-  case GET_SECTOR_COUNT :
-#if ((_USE_MKFS == 0) || (_FS_READONLY == 1))
-    res = RES_OK;
-#else
-    res = RES_PARERR; /* not support now */
-#endif
-    break;
+	switch (cmd)
+	{
+	/* Make sure that no pending write process */
+	case CTRL_SYNC :
+		res = SDMMC_flush() == 0 ? RES_OK : RES_ERROR;
+		break;
 
-  /* Get R/W sector size (WORD) */
-  case GET_SECTOR_SIZE :
-    *(WORD*)buff = BLOCK_SIZE;
-    res = RES_OK;
-    break;
+	/* Get number of sectors on the disk (DWORD) */
+	case GET_SECTOR_COUNT :
+		*(DWORD*)buff = sd_sectors;
+		res = RES_OK;
+		break;
 
-  /* Get erase block size in unit of sector (DWORD) */
-  case GET_BLOCK_SIZE :
-    *(DWORD*)buff = BLOCK_SIZE;
-    break;
+	/* Get R/W sector size (WORD) */
+	case GET_SECTOR_SIZE :
+		*(WORD*)buff = BLOCK_SIZE;
+		res = RES_OK;
+		break;
+
+	/* Get erase block size in unit of sector (DWORD) */
+	case GET_BLOCK_SIZE :
+		*(DWORD*)buff = BLOCK_SIZE;
+		res = RES_OK;
+		break;
+
+#if _USE_TRIM
+	/* Erase the sectors rt[0] to rt[1] of a removed chain */
+	case CTRL_TRIM :
+		rt = buff;
+		if (sd_wb_count && rt[0] < sd_wb_sector + sd_wb_count &&
+		    sd_wb_sector <= rt[1] && SDMMC_flush() != 0)
+			break;
+		if (sd_ra_count && rt[0] < sd_ra_sector + sd_ra_count &&
+		    sd_ra_sector <= rt[1])
+			sd_ra_count = 0;
+		res = mmc_erase(sd_card, rt[0], rt[1] - rt[0] + 1) == 0 ? RES_OK : RES_ERROR;
+		break;
+#endif
 
-  default:
-    res = RES_PARERR;
-  }
+	default:
+		res = RES_PARERR;
+	}
 
-  return res;
+	return res;
 }
 //#endif /* _USE_IOCTL == 1 */
 
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
-
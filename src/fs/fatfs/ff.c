@@ -470,6 +470,16 @@
 #endif
 
 
+/* Sector I/O of the window, FAT, directory and FSInfo sectors are pinned in the disk cache */
+#if _USE_DISKCACHE
+#define	disk_read_win(fs, sect)		disk_read_meta(fs->drv, fs->win, sect, 1)
+#define	disk_write_win(fs, sect)	disk_write_meta(fs->drv, fs->win, sect, 1)
+#else
+#define	disk_read_win(fs, sect)		disk_read(fs->drv, fs->win, sect, 1)
+#define	disk_write_win(fs, sect)	disk_write(fs->drv, fs->win, sect, 1)
+#endif
+
+
 /* Definitions of volume - partition conversion */
 #if _MULTI_PARTITION
 #define LD2PD(vol) VolToPart[vol].pd	/* Get physical drive number */
@@ -543,6 +553,27 @@ static BYTE CurrVol;			/* Current drive */
 static FILESEM Files[_FS_LOCK];	/* Open object lock semaphores */
 #endif
 
+#if _USE_SEEKCACHE
+#if _USE_LFN != 3
+#error _USE_SEEKCACHE needs _USE_LFN == 3
+#endif
+#if _SEEKCACHE_ENTRIES < 1 || _SEEKCACHE_MAX_SIZE < 16
+#error Wrong _SEEKCACHE_ENTRIES or _SEEKCACHE_MAX_SIZE setting
+#endif
+typedef struct {
+	FATFS*	fs;			/* Volume of the file (0:free entry) */
+	WORD	id;			/* Mount ID of the volume */
+	DWORD	sclust;		/* Top cluster of the file */
+	FSIZE_t	objsize;	/* Size of the file */
+	DWORD	stamp;		/* Last use */
+	DWORD	stride;		/* 0:tbl is {length, top cluster} per fragment, 0-terminated, else every stride-th cluster */
+	DWORD*	tbl;		/* Link map */
+} SEEKMAP;
+static SEEKMAP SeekMap[_SEEKCACHE_ENTRIES];	/* Seek cache, used under the volume lock */
+static DWORD SeekStamp;
+static FFSEEKSTAT SeekStat;
+#endif
+
 #if _USE_LFN == 0		/* Non-LFN configuration */
 #define	DEF_NAMBUF
 #define INIT_NAMBUF(fs)
@@ -893,14 +924,14 @@ FRESULT sync_window (	/* Returns FR_OK or FR_DISK_ERROR */
 
 	if (fs->wflag) {	/* Write back the sector if it is dirty */
 		wsect = fs->winsect;	/* Current sector number */
-		if (disk_write(fs->drv, fs->win, wsect, 1) != RES_OK) {
+		if (disk_write_win(fs, wsect) != RES_OK) {
 			res = FR_DISK_ERR;
 		} else {
 			fs->wflag = 0;
 			if (wsect - fs->fatbase < fs->fsize) {		/* Is it in the FAT area? */
 				for (nf = fs->n_fats; nf >= 2; nf--) {	/* Reflect the change to all FAT copies */
 					wsect += fs->fsize;
-					disk_write(fs->drv, fs->win, wsect, 1);
+					disk_write_win(fs, wsect);
 				}
 			}
 		}
@@ -924,7 +955,7 @@ FRESULT move_window (	/* Returns FR_OK or FR_DISK_ERROR */
 		res = sync_window(fs);		/* Write-back changes */
 #endif
 		if (res == FR_OK) {			/* Fill sector window with new data */
-			if (disk_read(fs->drv, fs->win, sector, 1) != RES_OK) {
+			if (disk_read_win(fs, sector) != RES_OK) {
 				sector = 0xFFFFFFFF;	/* Invalidate window if data is not reliable */
 				res = FR_DISK_ERR;
 			}
@@ -963,7 +994,7 @@ FRESULT sync_fs (	/* FR_OK:succeeded, !=0:error */
 			st_dword(fs->win + FSI_Nxt_Free, fs->last_clst);
 			/* Write it into the FSInfo sector */
 			fs->winsect = fs->volbase + 1;
-			disk_write(fs->drv, fs->win, fs->winsect, 1);
+			disk_write_win(fs, fs->winsect);
 			fs->fsi_flag = 0;
 		}
 		/* Make sure that no pending write process in the physical drive */
@@ -1265,6 +1296,152 @@ FRESULT fill_last_frag (
 
 
 
+#if _USE_SEEKCACHE
+/*-----------------------------------------------------------------------*/
+/* Seek cache - Drop the link maps of a volume                           */
+/*-----------------------------------------------------------------------*/
+static
+void seekmap_flush (
+	FATFS* fs			/* Volume whose maps are dropped */
+)
+{
+	UINT i;
+
+
+	for (i = 0; i < _SEEKCACHE_ENTRIES; i++) {
+		if (SeekMap[i].fs == fs) {
+			ff_memfree(SeekMap[i].tbl);
+			SeekMap[i].fs = 0;
+			SeekMap[i].tbl = 0;
+		}
+	}
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Seek cache - Find or build the link map of a file                     */
+/*-----------------------------------------------------------------------*/
+static
+SEEKMAP* seekmap_get (	/* Pointer to the map, 0:no map */
+	FIL* fp,			/* File opened without FA_WRITE */
+	DWORD hops			/* Links to follow without a map */
+)
+{
+	FATFS *fs = fp->obj.fs;
+	SEEKMAP *sm, *lru;
+	DWORD bcs, ncl, nent, stride, i, cl, tcl, len, *pts, *runs, *tbl;
+	UINT k, nrun;
+
+
+	lru = SeekMap;
+	for (k = 0; k < _SEEKCACHE_ENTRIES; k++) {
+		sm = &SeekMap[k];
+		if (sm->fs == fs && sm->id == fs->id && sm->sclust == fp->obj.sclust && sm->objsize == fp->obj.objsize) {
+			sm->stamp = ++SeekStamp;
+			SeekStat.hits++;
+			return sm;
+		}
+		if (lru->fs && (!sm->fs || sm->stamp < lru->stamp)) lru = sm;	/* Free entry or least recently used one */
+	}
+	if (hops < _SEEKCACHE_MIN_LINKS) return 0;	/* The chain is short enough to follow */
+
+	bcs = (DWORD)fs->csize * SS(fs);
+	ncl = (DWORD)((fp->obj.objsize + bcs - 1) / bcs);	/* Clusters of the file */
+	nent = _SEEKCACHE_MAX_SIZE / sizeof (DWORD);
+	stride = (ncl + nent - 1) / nent;			/* Stride of the points that fit in the size */
+	pts = ff_memalloc((UINT)((ncl + stride - 1) / stride * sizeof (DWORD)));
+	runs = ff_memalloc(_SEEKCACHE_MAX_SIZE);
+	if (!pts || !runs) {
+		ff_memfree(pts); ff_memfree(runs);
+		return 0;
+	}
+
+	/* Follow the chain once, noting the fragments while they fit and every stride-th cluster */
+	cl = tcl = fp->obj.sclust; len = 0; nrun = 0;
+	for (i = 0; ; i++) {
+		if (i % stride == 0) pts[i / stride] = cl;
+		len++;
+		if (i == ncl - 1) break;
+		cl = get_fat(&fp->obj, cl);
+		SeekStat.links++;
+		if (cl <= 1 || cl >= fs->n_fatent) {	/* Broken chain, let the normal seek report it */
+			ff_memfree(pts); ff_memfree(runs);
+			return 0;
+		}
+		if (cl != tcl + len) {					/* End of a fragment */
+			if (nrun + 2 < nent) { runs[nrun++] = len; runs[nrun++] = tcl; }
+			else nrun = nent;
+			tcl = cl; len = 0;
+		}
+	}
+	if (nrun + 2 < nent) {						/* All the fragments fit, keep them */
+		runs[nrun++] = len; runs[nrun++] = tcl; runs[nrun++] = 0;
+		tbl = ff_memalloc(nrun * sizeof (DWORD));
+		if (tbl) {
+			mem_cpy(tbl, runs, nrun * sizeof (DWORD));
+			ff_memfree(pts);
+			stride = 0;
+		} else {
+			tbl = pts;
+		}
+	} else {
+		tbl = pts;
+	}
+	ff_memfree(runs);
+
+	ff_memfree(lru->tbl);
+	lru->fs = fs;
+	lru->id = fs->id;
+	lru->sclust = fp->obj.sclust;
+	lru->objsize = fp->obj.objsize;
+	lru->stamp = ++SeekStamp;
+	lru->stride = stride;
+	lru->tbl = tbl;
+	SeekStat.builds++;
+	return lru;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Seek cache - Get the cluster of an offset with a link map             */
+/*-----------------------------------------------------------------------*/
+static
+DWORD seekmap_clust (	/* 0xFFFFFFFF:Disk error, 1:Internal error, >=2:Cluster number */
+	FIL* fp,			/* File of the map */
+	SEEKMAP* sm,		/* Link map */
+	DWORD cl,			/* Cluster offset in the file */
+	DWORD* nl			/* Links followed */
+)
+{
+	FATFS *fs = fp->obj.fs;
+	DWORD ncl, clst, *tbl = sm->tbl;
+
+
+	if (!sm->stride) {
+		for (;;) {
+			ncl = *tbl++;			/* Number of clusters in the fragment */
+			if (ncl == 0) return 1;	/* End of table? (error) */
+			if (cl < ncl) break;	/* In this fragment? */
+			cl -= ncl; tbl++;		/* Next fragment */
+		}
+		return cl + *tbl;
+	}
+	clst = tbl[cl / sm->stride];
+	for (cl %= sm->stride; cl; cl--) {
+		clst = get_fat(&fp->obj, clst);
+		(*nl)++;
+		if (clst == 0xFFFFFFFF) return clst;
+		if (clst <= 1 || clst >= fs->n_fatent) return 1;
+	}
+	return clst;
+}
+
+#endif	/* _USE_SEEKCACHE */
+
+
+
 #if !_FS_READONLY
 /*-----------------------------------------------------------------------*/
 /* FAT handling - Remove a cluster chain                                 */
@@ -1287,6 +1464,9 @@ FRESULT remove_chain (	/* FR_OK(0):succeeded, !=0:error */
 #endif
 
 	if (clst < 2 || clst >= fs->n_fatent) return FR_INT_ERR;	/* Check if in valid range */
+#if _USE_SEEKCACHE
+	seekmap_flush(fs);	/* Link maps of the volume may be stale */
+#endif
 
 	/* Mark the previous cluster 'EOC' on the FAT if it exists */
 	if (pclst && (!_FS_EXFAT || fs->fs_type != FS_EXFAT || obj->stat != 2)) {
@@ -3269,6 +3449,9 @@ FRESULT f_mount (
 #if _FS_LOCK != 0
 		clear_lock(cfs);
 #endif
+#if _USE_SEEKCACHE
+		seekmap_flush(cfs);
+#endif
 #if _FS_REENTRANT						/* Discard sync object of the current volume */
 		if (!ff_del_syncobj(cfs->sobj)) return FR_INT_ERR;
 #endif
@@ -4001,6 +4184,10 @@ FRESULT f_lseek (
 #if _USE_FASTSEEK
 	DWORD cl, pcl, ncl, tcl, dsc, tlen, ulen, *tbl;
 #endif
+#if _USE_SEEKCACHE
+	SEEKMAP *sm = 0;
+	DWORD mcl, hops, nl = 0, msc, t0;
+#endif
 
 	res = validate(&fp->obj, &fs);		/* Check validity of the file object */
 	if (res == FR_OK) res = (FRESULT)fp->err;
@@ -4011,6 +4198,27 @@ FRESULT f_lseek (
 #endif
 	if (res != FR_OK) LEAVE_FF(fs, res);
 
+#if _USE_SEEKCACHE
+	t0 = ff_get_ms();
+	if (!(fp->flag & FA_WRITE) && fp->obj.sclust
+#if _USE_FASTSEEK
+		&& !fp->cltbl
+#endif
+	) {	/* Read-only file with a chain, try the seek cache */
+		if (ofs > fp->obj.objsize) ofs = fp->obj.objsize;	/* Clip offset at the file size */
+		if (ofs) {
+			bcs = (DWORD)fs->csize * SS(fs);
+			mcl = (DWORD)((ofs - 1) / bcs);		/* Cluster offset of the new pointer */
+			hops = mcl;							/* Links to follow from the top of the chain, */
+			if (fp->fptr > 0 && mcl >= (DWORD)((fp->fptr - 1) / bcs)) {
+				hops = mcl - (DWORD)((fp->fptr - 1) / bcs);	/* or from the current cluster */
+			}
+			sm = seekmap_get(fp, hops);
+			if (sm && sm->stride && mcl % sm->stride >= hops) sm = 0;	/* The chain is the shorter way */
+		}
+	}
+#endif
+
 #if _USE_FASTSEEK
 	if (fp->cltbl) {	/* Fast seek */
 		if (ofs == CREATE_LINKMAP) {	/* Create CLMT */
@@ -4062,6 +4270,25 @@ FRESULT f_lseek (
 		}
 	} else
 #endif
+#if _USE_SEEKCACHE
+	if (sm) {	/* Seek with the link map */
+		clst = seekmap_clust(fp, sm, mcl, &nl);
+		if (clst == 0xFFFFFFFF) ABORT(fs, FR_DISK_ERR);
+		if (clst <= 1) ABORT(fs, FR_INT_ERR);
+		fp->fptr = ofs;
+		fp->clust = clst;
+		msc = clust2sect(fs, clst);
+		if (!msc) ABORT(fs, FR_INT_ERR);
+		msc += (DWORD)((ofs - 1) / SS(fs)) & (fs->csize - 1);
+		if (fp->fptr % SS(fs) && msc != fp->sect) {	/* Refill sector cache if needed, never dirty without FA_WRITE */
+#if !_FS_TINY
+			if (disk_read(fs->drv, fp->buf, msc, 1) != RES_OK) ABORT(fs, FR_DISK_ERR);	/* Load current sector */
+#endif
+			fp->sect = msc;
+		}
+		SeekStat.map_seeks++;
+	} else
+#endif
 
 	/* Normal Seek */
 	{
@@ -4109,6 +4336,9 @@ FRESULT f_lseek (
 #endif
 					{
 						clst = get_fat(&fp->obj, clst);	/* Follow cluster chain if not in write mode */
+#if _USE_SEEKCACHE
+						nl++;
+#endif
 					}
 					if (clst == 0xFFFFFFFF) ABORT(fs, FR_DISK_ERR);
 					if (clst <= 1 || clst >= fs->n_fatent) ABORT(fs, FR_INT_ERR);
@@ -4140,11 +4370,35 @@ FRESULT f_lseek (
 		}
 	}
 
+#if _USE_SEEKCACHE
+	t0 = ff_get_ms() - t0;
+	SeekStat.seeks++;
+	SeekStat.links += nl;
+	if (nl > SeekStat.max_links) SeekStat.max_links = nl;
+	SeekStat.ms += t0;
+	if (t0 > SeekStat.max_ms) SeekStat.max_ms = t0;
+#endif
 	LEAVE_FF(fs, res);
 }
 
 
 
+#if _USE_SEEKCACHE
+/*-----------------------------------------------------------------------*/
+/* Get the Seek Statistics                                               */
+/*-----------------------------------------------------------------------*/
+
+FRESULT f_seekstat (
+	FFSEEKSTAT* st,		/* Pointer to the statistics to return, can be null */
+	BYTE reset			/* 1:Clear the statistics after reading */
+)
+{
+	if (st) *st = SeekStat;
+	if (reset) mem_set(&SeekStat, 0, sizeof SeekStat);
+	return FR_OK;
+}
+#endif
+
 #if _FS_MINIMIZE <= 1
 /*-----------------------------------------------------------------------*/
 /* Create a Directory Object                                             */
@@ -218,3 +218,11 @@ DWORD get_fattime (void)
 	               ((t.tm_sec >> 1) & 0x1f));        /* Second / 2 (0..29) */
 }
 #endif
+
+/* Time function of the seek statistics */
+#if _USE_SEEKCACHE
+DWORD ff_get_ms (void)
+{
+	return OS_TicksToMSecs(OS_GetTicks());
+}
+#endif
@@ -0,0 +1,687 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "kernel/FreeRTOS/tracebuf.h"
+
+#if (configDEBUG_TRACE_EN == 1)
+
+#include <stddef.h>
+#include <string.h>
+
+#include "kernel/FreeRTOS/queue.h"
+
+/*
+ * Cycle counter and interrupt masking. The hooks can run from interrupts
+ * above configMAX_SYSCALL_INTERRUPT_PRIORITY, so PRIMASK is used instead of
+ * the kernel critical section. The simulation build provides its own.
+ */
+#ifndef trcGET_CYCLES
+#define trcDEMCR            (*((volatile uint32_t *)0xE000EDFCUL))
+#define trcDWT_CTRL         (*((volatile uint32_t *)0xE0001000UL))
+#define trcDWT_CYCCNT       (*((volatile uint32_t *)0xE0001004UL))
+
+#define trcINIT_CYCLES()    do { trcDEMCR |= (1UL << 24); trcDWT_CTRL |= 1UL; } while (0)
+#define trcGET_CYCLES()     (trcDWT_CYCCNT)
+
+#define trcIRQ_SAVE(m)      __asm volatile ("mrs %0, primask\n\tcpsid i" : "=r" (m) :: "memory")
+#define trcIRQ_RESTORE(m)   __asm volatile ("msr primask, %0" :: "r" (m) : "memory")
+#endif
+
+/* thread states, kept only while recording */
+#define TRC_UNKNOWN         0
+#define TRC_RUNNING         1
+#define TRC_READY           2
+#define TRC_BLOCKED         3
+
+typedef struct {
+	OSTraceThreadStat st;
+	uint8_t state;
+	uint8_t reason;     /* TRACE_BLOCK_xxx while blocked */
+	uint8_t pend;       /* reason + 1, set by a block hook before switch out */
+	const void *obj;    /* object blocked on */
+	uint64_t since;     /* entered the current state */
+	uint64_t isr_mark;  /* isr_total when switched in */
+} TraceThread;
+
+static struct {
+	OSTraceEvent *buf;
+	uint32_t size;      /* in events */
+	uint32_t head;      /* next event to write */
+	uint32_t num;
+	uint32_t dropped;
+	uint8_t mode;
+	volatile uint8_t running;
+
+	uint32_t last;      /* cycle counter extended to 64 bits */
+	uint32_t hi;
+	uint64_t start;
+	uint64_t stop;
+
+	uint32_t cur;       /* slot of the running thread */
+	uint32_t nest;
+	uint64_t isr_ts[TRACE_ISR_NEST_MAX];
+	uint64_t isr_total;
+
+	TraceThread thread[TRACE_THREAD_MAX];
+	OSTraceIrqStat irq[TRACE_IRQ_MAX];
+	OSTraceLockStat lock[TRACE_LOCK_MAX];
+} trc;
+
+static uint64_t prvNow(void)
+{
+	uint32_t c = trcGET_CYCLES();
+
+	if (c < trc.last)
+		trc.hi++;
+	trc.last = c;
+	return ((uint64_t)trc.hi << 32) | c;
+}
+
+static void prvRecord(uint8_t type, uint8_t sub, uint16_t tid, uint32_t arg, uint64_t now)
+{
+	OSTraceEvent *ev;
+
+	if (trc.num == trc.size) {
+		trc.dropped++;
+		if (trc.mode == TRACE_MODE_ONESHOT)
+			return;
+	} else {
+		trc.num++;
+	}
+	ev = &trc.buf[trc.head];
+	ev->ts = (uint32_t)now;
+	ev->type = type;
+	ev->sub = sub;
+	ev->tid = tid;
+	ev->arg = arg;
+	if (++trc.head == trc.size)
+		trc.head = 0;
+}
+
+static __inline uint16_t prvCurTid(void)
+{
+	return trc.thread[trc.cur].st.tid;
+}
+
+static uint8_t prvQueueReason(uint8_t type)
+{
+	switch (type) {
+	case queueQUEUE_TYPE_MUTEX:
+	case queueQUEUE_TYPE_RECURSIVE_MUTEX:
+		return TRACE_BLOCK_MUTEX;
+	case queueQUEUE_TYPE_COUNTING_SEMAPHORE:
+	case queueQUEUE_TYPE_BINARY_SEMAPHORE:
+		return TRACE_BLOCK_SEM;
+	default:
+		return TRACE_BLOCK_QUEUE;
+	}
+}
+
+static void prvLockAccount(const void *obj, uint8_t reason, uint64_t d)
+{
+	OSTraceLockStat *l, *min = NULL;
+	int i;
+
+	for (i = 0; i < TRACE_LOCK_MAX; i++) {
+		l = &trc.lock[i];
+		if (l->obj == obj)
+			break;
+		if (min == NULL || l->total < min->total)
+			min = l;
+	}
+	if (i == TRACE_LOCK_MAX) {
+		/* keep the objects with the most blocked time */
+		if (min->obj != NULL && min->total >= d)
+			return;
+		l = min;
+		memset(l, 0, sizeof(*l));
+		l->obj = obj;
+		l->reason = reason;
+	}
+	l->waits++;
+	l->total += d;
+	if (d > l->max)
+		l->max = d > 0xFFFFFFFFU ? 0xFFFFFFFFU : (uint32_t)d;
+}
+
+/* account the time spent in the current state up to now */
+static void prvSettle(TraceThread *t, uint64_t now)
+{
+	uint64_t d = now - t->since;
+
+	switch (t->state) {
+	case TRC_READY:
+		t->st.ready += d;
+		break;
+	case TRC_BLOCKED:
+		t->st.blocked[t->reason] += d;
+		if (t->obj != NULL)
+			prvLockAccount(t->obj, t->reason, d);
+		break;
+	default:
+		break;
+	}
+	t->since = now;
+}
+
+static void prvAccountRun(TraceThread *t, uint64_t now)
+{
+	uint64_t d = now - t->since;
+	uint64_t isr = trc.isr_total - t->isr_mark;
+
+	t->st.run += d > isr ? d - isr : 0;
+	t->since = now;
+	t->isr_mark = trc.isr_total;
+}
+
+uint32_t uxTraceTaskCreate(uint32_t tcb_num, const char *name)
+{
+	TraceThread *t;
+	uint32_t i, slot = 0, m;
+
+	trcIRQ_SAVE(m);
+	/* prefer a never used slot, then the first one of a deleted thread */
+	for (i = 1; i < TRACE_THREAD_MAX; i++) {
+		t = &trc.thread[i];
+		if (t->st.tid == 0) {
+			slot = i;
+			break;
+		}
+		if (slot == 0 && !t->st.alive && i != trc.cur)
+			slot = i;
+	}
+	if (slot != 0) {
+		t = &trc.thread[slot];
+		memset(t, 0, sizeof(*t));
+		t->st.tid = (uint16_t)tcb_num;
+		t->st.alive = 1;
+		strncpy(t->st.name, name, TRACE_NAME_LEN - 1);
+	}
+	if (trc.running)
+		prvRecord(TRACE_EV_CREATE, 0, (uint16_t)tcb_num, slot, prvNow());
+	trcIRQ_RESTORE(m);
+	return slot;
+}
+
+void vTraceTaskDelete(uint32_t slot)
+{
+	TraceThread *t = &trc.thread[slot];
+	uint32_t m;
+
+	if (slot == 0)
+		return;
+	trcIRQ_SAVE(m);
+	t->st.alive = 0;
+	if (trc.running) {
+		uint64_t now = prvNow();
+
+		if (slot != trc.cur) {
+			prvSettle(t, now);
+			t->state = TRC_UNKNOWN;
+		}
+		prvRecord(TRACE_EV_DELETE, 0, t->st.tid, 0, now);
+	}
+	trcIRQ_RESTORE(m);
+}
+
+void vTraceTaskSwitchedOut(uint32_t slot)
+{
+	TraceThread *t = &trc.thread[slot];
+	uint64_t now;
+	uint8_t sub;
+	uint32_t m;
+
+	if (!trc.running)
+		return;
+	trcIRQ_SAVE(m);
+	now = prvNow();
+	if (t->state == TRC_RUNNING)
+		prvAccountRun(t, now);
+	if (slot == 0) {
+		/* shared by several threads, only the run time is meaningful */
+		sub = TRACE_OUT_PREEMPT;
+		t->state = TRC_UNKNOWN;
+		t->pend = 0;
+	} else if (!t->st.alive) {
+		sub = TRACE_OUT_DELETE;
+		t->state = TRC_UNKNOWN;
+	} else if (t->pend) {
+		sub = TRACE_OUT_BLOCK;
+		t->state = TRC_BLOCKED;
+		t->reason = t->pend - 1;
+		t->pend = 0;
+	} else {
+		sub = TRACE_OUT_PREEMPT;
+		t->state = TRC_READY;
+		t->st.preempts++;
+	}
+	t->since = now;
+	prvRecord(TRACE_EV_SWITCH_OUT, sub, t->st.tid, 0, now);
+	trcIRQ_RESTORE(m);
+}
+
+void vTraceTaskSwitchedIn(uint32_t slot)
+{
+	TraceThread *t = &trc.thread[slot];
+	uint64_t now;
+	uint32_t m;
+
+	trc.cur = slot;
+	if (!trc.running)
+		return;
+	trcIRQ_SAVE(m);
+	now = prvNow();
+	prvSettle(t, now);
+	t->state = TRC_RUNNING;
+	t->isr_mark = trc.isr_total;
+	t->st.switches++;
+	prvRecord(TRACE_EV_SWITCH_IN, 0, t->st.tid, 0, now);
+	trcIRQ_RESTORE(m);
+}
+
+void vTraceTaskReady(uint32_t slot)
+{
+	TraceThread *t = &trc.thread[slot];
+	uint64_t now;
+	uint32_t m;
+
+	if (!trc.running || slot == 0)
+		return;
+	trcIRQ_SAVE(m);
+	if (t->state != TRC_READY) {
+		now = prvNow();
+		if (t->state == TRC_RUNNING) {
+			/* woken before it got switched out */
+			t->pend = 0;
+		} else {
+			prvSettle(t, now);
+			t->state = TRC_READY;
+			t->obj = NULL;
+		}
+		prvRecord(TRACE_EV_READY, 0, t->st.tid, 0, now);
+	}
+	trcIRQ_RESTORE(m);
+}
+
+void vTraceTaskSuspend(uint32_t slot)
+{
+	TraceThread *t = &trc.thread[slot];
+	uint64_t now;
+	uint32_t m;
+
+	if (!trc.running || slot == 0)
+		return;
+	trcIRQ_SAVE(m);
+	now = prvNow();
+	if (slot == trc.cur) {
+		t->pend = TRACE_BLOCK_SUSPEND + 1;
+	} else {
+		prvSettle(t, now);
+		t->state = TRC_BLOCKED;
+		t->reason = TRACE_BLOCK_SUSPEND;
+	}
+	t->obj = NULL;
+	prvRecord(TRACE_EV_BLOCK, TRACE_BLOCK_SUSPEND, t->st.tid, 0, now);
+	trcIRQ_RESTORE(m);
+}
+
+void vTraceTaskPrioInherit(uint32_t slot, uint32_t prio)
+{
+	uint32_t m;
+
+	if (!trc.running)
+		return;
+	trcIRQ_SAVE(m);
+	prvRecord(TRACE_EV_PRIO_INHERIT, 0, trc.thread[slot].st.tid, prio, prvNow());
+	trcIRQ_RESTORE(m);
+}
+
+void vTraceBlock(uint32_t reason, const void *obj)
+{
+	TraceThread *t = &trc.thread[trc.cur];
+	uint32_t m;
+
+	if (!trc.running)
+		return;
+	trcIRQ_SAVE(m);
+	t->pend = reason + 1;
+	t->obj = obj;
+	prvRecord(TRACE_EV_BLOCK, reason, t->st.tid, (uint32_t)(uintptr_t)obj, prvNow());
+	trcIRQ_RESTORE(m);
+}
+
+void vTraceQueueBlock(const void *queue, uint8_t type, uint32_t op)
+{
+	vTraceBlock(prvQueueReason(type), queue);
+}
+
+void vTraceQueueOp(const void *queue, uint8_t type, uint32_t op)
+{
+	uint8_t cls;
+	uint32_t m;
+
+	if (!trc.running)
+		return;
+	switch (prvQueueReason(type)) {
+	case TRACE_BLOCK_MUTEX:
+		cls = TRACE_CLASS_MUTEX;
+		break;
+	case TRACE_BLOCK_SEM:
+		cls = TRACE_CLASS_SEM;
+		break;
+	default:
+		cls = TRACE_CLASS_QUEUE;
+		break;
+	}
+	trcIRQ_SAVE(m);
+	prvRecord((op & TRACE_OP_RECV) ? TRACE_EV_RECV : TRACE_EV_SEND,
+	          (cls << TRACE_CLASS_SHIFT) | op, prvCurTid(), (uint32_t)(uintptr_t)queue, prvNow());
+	trcIRQ_RESTORE(m);
+}
+
+static void prvUserEvent(uint8_t type, uint8_t id, uint32_t arg)
+{
+	uint32_t m;
+
+	if (!trc.running)
+		return;
+	trcIRQ_SAVE(m);
+	prvRecord(type, id, prvCurTid(), arg, prvNow());
+	trcIRQ_RESTORE(m);
+}
+
+void OSTraceMark(uint8_t id, uint32_t arg)
+{
+	prvUserEvent(TRACE_EV_MARK, id, arg);
+}
+
+void OSTraceSpanBegin(uint8_t id, uint32_t arg)
+{
+	prvUserEvent(TRACE_EV_SPAN_BEGIN, id, arg);
+}
+
+void OSTraceSpanEnd(uint8_t id, uint32_t arg)
+{
+	prvUserEvent(TRACE_EV_SPAN_END, id, arg);
+}
+
+void OSTraceIsrEnter(uint32_t irq)
+{
+	uint64_t now;
+	uint32_t m;
+
+	if (!trc.running)
+		return;
+	trcIRQ_SAVE(m);
+	now = prvNow();
+	if (trc.nest < TRACE_ISR_NEST_MAX)
+		trc.isr_ts[trc.nest] = now;
+	trc.nest++;
+	prvRecord(TRACE_EV_ISR_ENTER, 0, prvCurTid(), irq, now);
+	trcIRQ_RESTORE(m);
+}
+
+void OSTraceIsrExit(uint32_t irq)
+{
+	OSTraceIrqStat *s;
+	uint64_t now, d;
+	uint32_t m;
+
+	if (!trc.running)
+		return;
+	trcIRQ_SAVE(m);
+	if (trc.nest > 0) {
+		now = prvNow();
+		if (--trc.nest < TRACE_ISR_NEST_MAX) {
+			d = now - trc.isr_ts[trc.nest];
+			if (irq < TRACE_IRQ_MAX) {
+				s = &trc.irq[irq];
+				s->count++;
+				s->total += d;
+				if (d > s->max)
+					s->max = (uint32_t)d;
+			}
+			if (trc.nest == 0)
+				trc.isr_total += d;
+		}
+		prvRecord(TRACE_EV_ISR_EXIT, 0, prvCurTid(), irq, now);
+	}
+	trcIRQ_RESTORE(m);
+}
+
+int OSTraceStart(uint32_t size, uint8_t mode)
+{
+	TraceThread *t;
+	uint32_t n = size / sizeof(OSTraceEvent);
+	uint32_t i, m;
+	uint64_t now;
+
+	if (n < 16)
+		return -1;
+	OSTraceStop();
+	if (trc.buf != NULL && trc.size != n) {
+		vPortFree(trc.buf);
+		trc.buf = NULL;
+	}
+	if (trc.buf == NULL) {
+		trc.buf = pvPortMalloc(n * sizeof(OSTraceEvent));
+		if (trc.buf == NULL)
+			return -1;
+	}
+
+	trcIRQ_SAVE(m);
+	trc.size = n;
+	trc.head = 0;
+	trc.num = 0;
+	trc.dropped = 0;
+	trc.mode = mode;
+	trc.nest = 0;
+	trc.isr_total = 0;
+	memset(trc.irq, 0, sizeof(trc.irq));
+	memset(trc.lock, 0, sizeof(trc.lock));
+	for (i = 0; i < TRACE_THREAD_MAX; i++) {
+		t = &trc.thread[i];
+		memset(&t->st.run, 0, sizeof(OSTraceThreadStat) - offsetof(OSTraceThreadStat, run));
+		t->state = TRC_UNKNOWN;
+		t->pend = 0;
+		t->obj = NULL;
+	}
+	strcpy(trc.thread[0].st.name, "(other)");
+	trc.thread[0].st.alive = 1;
+
+	trcINIT_CYCLES();
+	now = prvNow();
+	trc.start = now;
+	t = &trc.thread[trc.cur];
+	t->state = TRC_RUNNING;
+	t->since = now;
+	t->isr_mark = 0;
+	trc.running = 1;
+	/* tell the decoder who is running */
+	prvRecord(TRACE_EV_SWITCH_IN, 0, t->st.tid, 0, now);
+	trcIRQ_RESTORE(m);
+	return 0;
+}
+
+void OSTraceStop(void)
+{
+	TraceThread *t;
+	uint64_t now;
+	uint32_t i, m;
+
+	trcIRQ_SAVE(m);
+	if (trc.running) {
+		now = prvNow();
+		for (i = 0; i < TRACE_THREAD_MAX; i++) {
+			t = &trc.thread[i];
+			if (t->state == TRC_RUNNING)
+				prvAccountRun(t, now);
+			else
+				prvSettle(t, now);
+		}
+		trc.stop = now;
+		trc.running = 0;
+		prvRecord(TRACE_EV_STOP, 0, prvCurTid(), 0, now);
+	}
+	trcIRQ_RESTORE(m);
+}
+
+void OSTraceFree(void)
+{
+	OSTraceStop();
+	if (trc.buf != NULL) {
+		vPortFree(trc.buf);
+		trc.buf = NULL;
+		trc.size = 0;
+		trc.num = 0;
+	}
+}
+
+void OSTraceGetInfo(OSTraceInfo *info)
+{
+	uint32_t m;
+
+	trcIRQ_SAVE(m);
+	info->cpu_hz = configCPU_CLOCK_HZ;
+	info->elapsed = (trc.running ? prvNow() : trc.stop) - trc.start;
+	info->isr = trc.isr_total;
+	info->event_num = trc.num;
+	info->event_max = trc.size;
+	info->dropped = trc.dropped;
+	info->mode = trc.mode;
+	info->running = trc.running;
+	trcIRQ_RESTORE(m);
+}
+
+/* statistics of running intervals are added at switch out and OSTraceStop() */
+int OSTraceGetThreadStat(OSTraceThreadStat *st, int num)
+{
+	uint32_t i, m;
+	int n = 0;
+
+	for (i = 0; i < TRACE_THREAD_MAX && n < num; i++) {
+		trcIRQ_SAVE(m);
+		if (trc.thread[i].st.tid != 0 || trc.thread[i].st.switches != 0)
+			st[n++] = trc.thread[i].st;
+		trcIRQ_RESTORE(m);
+	}
+	return n;
+}
+
+int OSTraceGetIrqStat(OSTraceIrqStat *st, int num)
+{
+	uint32_t m;
+
+	if (num > TRACE_IRQ_MAX)
+		num = TRACE_IRQ_MAX;
+	trcIRQ_SAVE(m);
+	memcpy(st, trc.irq, num * sizeof(OSTraceIrqStat));
+	trcIRQ_RESTORE(m);
+	return num;
+}
+
+/* sorted by blocked time, longest first */
+int OSTraceGetLockStat(OSTraceLockStat *st, int num)
+{
+	OSTraceLockStat l;
+	uint32_t i, m;
+	int j, n = 0;
+
+	for (i = 0; i < TRACE_LOCK_MAX; i++) {
+		trcIRQ_SAVE(m);
+		l = trc.lock[i];
+		trcIRQ_RESTORE(m);
+		if (l.obj == NULL)
+			continue;
+		for (j = n; j > 0 && st[j - 1].total < l.total; j--) {
+			if (j < num)
+				st[j] = st[j - 1];
+		}
+		if (j < num) {
+			st[j] = l;
+			if (n < num)
+				n++;
+		}
+	}
+	return n;
+}
+
+int32_t OSTraceDump(OSTraceWrite write, void *arg)
+{
+	OSTraceHeader hdr;
+	OSTraceThreadRec rec;
+	uint32_t i, first;
+	int32_t len;
+
+	OSTraceStop();
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = TRACE_MAGIC;
+	hdr.version = TRACE_VERSION;
+	hdr.hdr_size = sizeof(hdr);
+	hdr.cpu_hz = configCPU_CLOCK_HZ;
+	hdr.event_size = sizeof(OSTraceEvent);
+	hdr.event_num = trc.num;
+	hdr.dropped = trc.dropped;
+	hdr.mode = trc.mode;
+	for (i = 0; i < TRACE_THREAD_MAX; i++) {
+		if (trc.thread[i].st.tid != 0)
+			hdr.thread_num++;
+	}
+	if (write(&hdr, sizeof(hdr), arg) < 0)
+		return -1;
+	len = sizeof(hdr);
+
+	for (i = 0; i < TRACE_THREAD_MAX; i++) {
+		if (trc.thread[i].st.tid == 0)
+			continue;
+		memset(&rec, 0, sizeof(rec));
+		rec.tid = trc.thread[i].st.tid;
+		rec.alive = trc.thread[i].st.alive;
+		memcpy(rec.name, trc.thread[i].st.name, TRACE_NAME_LEN);
+		if (write(&rec, sizeof(rec), arg) < 0)
+			return -1;
+		len += sizeof(rec);
+	}
+
+	if (trc.num == 0)
+		return len;
+	first = (trc.num < trc.size) ? 0 : trc.head;
+	if (first + trc.num > trc.size) {
+		if (write(&trc.buf[first], (trc.size - first) * sizeof(OSTraceEvent), arg) < 0 ||
+		    write(&trc.buf[0], trc.head * sizeof(OSTraceEvent), arg) < 0)
+			return -1;
+	} else {
+		if (write(&trc.buf[first], trc.num * sizeof(OSTraceEvent), arg) < 0)
+			return -1;
+	}
+	return len + trc.num * sizeof(OSTraceEvent);
+}
+
+#endif /* configDEBUG_TRACE_EN */
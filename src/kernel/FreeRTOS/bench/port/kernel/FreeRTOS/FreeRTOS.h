@@ -0,0 +1,25 @@
+/*
+ * Host stand-in for FreeRTOS.h, enough to build tracebuf.c. The cycle
+ * counter is the virtual clock of the simulation, nothing runs concurrently.
+ */
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define configDEBUG_TRACE_EN	1
+#define configCPU_CLOCK_HZ		192000000U
+
+#define pvPortMalloc(size)		malloc(size)
+#define vPortFree(p)			free(p)
+
+extern uint32_t sim_cycles;
+
+#define trcINIT_CYCLES()		do { } while (0)
+#define trcGET_CYCLES()			(sim_cycles)
+#define trcIRQ_SAVE(m)			((m) = 0)
+#define trcIRQ_RESTORE(m)		((void)(m))
+
+#endif /* INC_FREERTOS_H */
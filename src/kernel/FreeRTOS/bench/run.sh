@@ -0,0 +1,21 @@
+#!/bin/sh
+#
+# Build trace_sim.c with tracebuf.c, run the simulated scheduler, and check
+# that tools/trace/xrtrace.py decodes the dumps to the statistics the
+# simulation expects. The images and the Chrome trace JSON go to the
+# directory of the first argument, /tmp by default.
+#
+set -e
+cd "$(dirname "$0")"
+out="${1:-/tmp}"
+gcc -O2 -Wall -Iport -I../../../../include \
+	trace_sim.c ../Source/tracebuf.c -o /tmp/trace_sim
+/tmp/trace_sim full "$out/trace_full.bin" > "$out/trace_expect.txt"
+python3 ../../../../tools/trace/xrtrace.py --stats "$out/trace_full.bin" > "$out/trace_decode.txt"
+diff "$out/trace_expect.txt" "$out/trace_decode.txt"
+python3 ../../../../tools/trace/xrtrace.py "$out/trace_full.bin" -o "$out/trace_full.json"
+/tmp/trace_sim wrap "$out/trace_wrap.bin" > /dev/null
+python3 ../../../../tools/trace/xrtrace.py "$out/trace_wrap.bin" -o "$out/trace_wrap.json"
+python3 -c "import json, sys; [json.load(open(f)) for f in sys.argv[1:]]" \
+	"$out/trace_full.json" "$out/trace_wrap.json"
+echo "PASS: decoded statistics match, $out/trace_full.json opens in ui.perfetto.dev"
@@ -0,0 +1,530 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Linux simulation of the trace recorder. A small round robin scheduler
+ * drives the kernel hooks of tracehook.h the way tasks.c and queue.c call
+ * them: threads work, block on mutexes, semaphores, queues and delays, get
+ * woken by other threads and by nested interrupts, and are created and
+ * deleted while recording. The scheduler keeps its own account of where
+ * every cycle went and checks the statistics of the recorder against it.
+ *
+ *   trace_sim full <image>   large one-shot buffer, image written raw,
+ *                            expected statistics printed in the format of
+ *                            "xrtrace.py --stats"
+ *   trace_sim wrap <log>     small wrapping buffer, image written as the
+ *                            "trace dump" console lines
+ *
+ * The virtual cycle counter starts close to 2^32 and wraps during the run.
+ */
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kernel/FreeRTOS/tracebuf.h"
+#include "kernel/FreeRTOS/queue.h"
+
+#define SIM_STEPS		20000
+#define SIM_THREAD_MAX	8
+#define SIM_OBJ_NUM		4
+#define SIM_IRQ_NUM		4
+
+enum { S_RUNNING, S_READY, S_BLOCKED, S_DEAD };
+
+struct sim_thread {
+	char name[TRACE_NAME_LEN];
+	uint32_t tid;
+	uint32_t slot;
+	int state;
+	int known;				/* state entered while recording */
+	int reason;
+	int pend;				/* reason + 1 */
+	int obj;				/* index in sim_obj, -1 if none */
+	uint64_t since;
+	uint64_t run;
+	uint64_t ready;
+	uint64_t blocked[TRACE_BLOCK_NUM];
+	uint32_t switches;
+	uint32_t preempts;
+};
+
+struct sim_obj {
+	uint8_t type;			/* queueQUEUE_TYPE_xxx */
+	uint32_t waits;
+	uint64_t total;
+};
+
+struct sim_irq {
+	uint32_t count;
+	uint64_t total;
+	uint64_t max;
+};
+
+uint32_t sim_cycles = 0xF0000000U;
+static uint64_t sim_now;
+static uint32_t sim_seed = 12345;
+static uint32_t sim_tcb_num;
+
+static struct sim_thread thread[SIM_THREAD_MAX];
+static int thread_num;
+static int cur;
+static int recording;
+
+static struct sim_obj obj[SIM_OBJ_NUM] = {
+	{ queueQUEUE_TYPE_MUTEX },
+	{ queueQUEUE_TYPE_RECURSIVE_MUTEX },
+	{ queueQUEUE_TYPE_BINARY_SEMAPHORE },
+	{ queueQUEUE_TYPE_BASE },
+};
+
+static struct sim_irq irq[SIM_IRQ_NUM];
+static uint32_t errors;
+
+static uint32_t rnd(uint32_t n)
+{
+	sim_seed = sim_seed * 1103515245 + 12345;
+	return (sim_seed >> 8) % n;
+}
+
+static void advance(uint32_t c)
+{
+	sim_cycles += c;
+	sim_now += c;
+}
+
+/* leave the current state, accounting its time */
+static void set_state(struct sim_thread *t, int state)
+{
+	uint64_t d = sim_now - t->since;
+
+	if (recording && t->known) {
+		if (t->state == S_READY) {
+			t->ready += d;
+		} else if (t->state == S_BLOCKED) {
+			t->blocked[t->reason] += d;
+			if (t->obj >= 0) {
+				obj[t->obj].waits++;
+				obj[t->obj].total += d;
+			}
+		}
+	}
+	t->state = state;
+	t->known = recording;
+	t->since = sim_now;
+	if (state != S_BLOCKED)
+		t->obj = -1;
+}
+
+static void work(uint32_t c)
+{
+	advance(c);
+	if (recording)
+		thread[cur].run += c;
+}
+
+static int create(const char *name)
+{
+	struct sim_thread *t = &thread[thread_num];
+
+	memset(t, 0, sizeof(*t));
+	strncpy(t->name, name, TRACE_NAME_LEN - 1);
+	t->tid = ++sim_tcb_num;
+	t->obj = -1;
+	t->slot = uxTraceTaskCreate(t->tid, t->name);
+	vTraceTaskReady(t->slot);
+	t->state = S_READY;
+	t->known = recording;
+	t->since = sim_now;
+	return thread_num++;
+}
+
+static void wake(int i)
+{
+	struct sim_thread *t = &thread[i];
+
+	vTraceTaskReady(t->slot);
+	if (i == cur)
+		t->pend = 0;
+	else if (t->state == S_BLOCKED)
+		set_state(t, S_READY);
+}
+
+static void isr(uint32_t n, uint32_t c, int waking, int nested)
+{
+	struct sim_irq *s = &irq[n];
+	uint64_t begin = sim_now;
+
+	OSTraceIsrEnter(n);
+	advance(c / 2);
+	if (nested)
+		isr((n + 1) % SIM_IRQ_NUM, c / 3, -1, 0);
+	if (waking >= 0) {
+		vTraceQueueOp(&obj[3], obj[3].type, TRACE_OP_SEND | TRACE_OP_ISR);
+		wake(waking);
+	}
+	advance(c - c / 2);
+	OSTraceIsrExit(n);
+	if (recording) {
+		s->count++;
+		s->total += sim_now - begin;
+		if (sim_now - begin > s->max)
+			s->max = sim_now - begin;
+	}
+}
+
+static int next_ready(void)
+{
+	int i, n;
+
+	for (n = 1; n <= thread_num; n++) {
+		i = (cur + n) % thread_num;
+		if (i != 0 && thread[i].state == S_READY)
+			return i;
+	}
+	return 0; /* idle */
+}
+
+static void switch_to(int next)
+{
+	struct sim_thread *t = &thread[cur];
+
+	vTraceTaskSwitchedOut(t->slot);
+	if (t->state == S_DEAD) {
+		;
+	} else if (t->pend) {
+		t->reason = t->pend - 1;
+		t->pend = 0;
+		set_state(t, S_BLOCKED);
+	} else {
+		set_state(t, S_READY);
+		if (recording)
+			t->preempts++;
+	}
+	cur = next;
+	t = &thread[cur];
+	vTraceTaskSwitchedIn(t->slot);
+	set_state(t, S_RUNNING);
+	if (recording)
+		t->switches++;
+}
+
+static void block(void)
+{
+	struct sim_thread *t = &thread[cur];
+	int o, r = rnd(5);
+
+	if (r < 3) {
+		o = rnd(SIM_OBJ_NUM);
+		vTraceQueueBlock(&obj[o], obj[o].type, TRACE_OP_RECV);
+		switch (obj[o].type) {
+		case queueQUEUE_TYPE_MUTEX:
+		case queueQUEUE_TYPE_RECURSIVE_MUTEX:
+			t->pend = TRACE_BLOCK_MUTEX + 1;
+			break;
+		case queueQUEUE_TYPE_BINARY_SEMAPHORE:
+			t->pend = TRACE_BLOCK_SEM + 1;
+			break;
+		default:
+			t->pend = TRACE_BLOCK_QUEUE + 1;
+			break;
+		}
+		t->obj = o;
+	} else {
+		r = (r == 3) ? TRACE_BLOCK_DELAY : TRACE_BLOCK_NOTIFY;
+		vTraceBlock(r, NULL);
+		t->pend = r + 1;
+		t->obj = -1;
+	}
+}
+
+static int blocked_thread(void)
+{
+	int i, n = rnd(thread_num);
+
+	for (i = 0; i < thread_num; i++, n = (n + 1) % thread_num) {
+		if (thread[n].state == S_BLOCKED)
+			return n;
+	}
+	return -1;
+}
+
+static void step(void)
+{
+	int i;
+
+	switch (rnd(10)) {
+	case 0:
+	case 1:
+		if (cur != 0) {
+			block();
+			switch_to(next_ready());
+		}
+		break;
+	case 2:
+		isr(rnd(SIM_IRQ_NUM), 200 + rnd(3000), blocked_thread(), rnd(8) == 0);
+		break;
+	case 3:
+		i = blocked_thread();
+		if (i >= 0) {
+			vTraceQueueOp(&obj[0], obj[0].type, TRACE_OP_SEND);
+			wake(i);
+		}
+		break;
+	case 4:
+		switch_to(next_ready());
+		break;
+	case 5:
+		OSTraceMark(rnd(4), sim_now);
+		break;
+	case 6:
+		OSTraceSpanBegin(1, 0);
+		work(100 + rnd(1000));
+		OSTraceSpanEnd(1, 0);
+		break;
+	case 7:
+		/* woken before the switch: goes out as preempted */
+		if (cur != 0) {
+			block();
+			isr(0, 300, cur, 0);
+			switch_to(next_ready());
+		}
+		break;
+	case 8:
+		vTraceQueueOp(&obj[3], obj[3].type, TRACE_OP_RECV | TRACE_OP_FAILED);
+		break;
+	default:
+		break;
+	}
+	work(1000 + rnd(200000));
+}
+
+static int check_stats(void)
+{
+	OSTraceThreadStat st[TRACE_THREAD_MAX];
+	OSTraceIrqStat is[TRACE_IRQ_MAX];
+	OSTraceLockStat ls[TRACE_LOCK_MAX];
+	struct sim_thread *t;
+	int i, j, k, n;
+
+	n = OSTraceGetThreadStat(st, TRACE_THREAD_MAX);
+	for (i = 0; i < thread_num; i++) {
+		t = &thread[i];
+		for (j = 0; j < n && st[j].tid != t->tid; j++)
+			;
+		if (j == n) {
+			printf("thread %s missing\n", t->name);
+			errors++;
+			continue;
+		}
+		if (st[j].run != t->run || st[j].ready != t->ready ||
+		    st[j].switches != t->switches || st[j].preempts != t->preempts ||
+		    memcmp(st[j].blocked, t->blocked, sizeof(t->blocked)) != 0) {
+			fprintf(stderr, "thread %s: run %" PRIu64 "/%" PRIu64
+			        " ready %" PRIu64 "/%" PRIu64 " switches %u/%u\n",
+			        t->name, st[j].run, t->run, st[j].ready, t->ready,
+			        st[j].switches, t->switches);
+			errors++;
+		}
+	}
+
+	OSTraceGetIrqStat(is, TRACE_IRQ_MAX);
+	for (i = 0; i < SIM_IRQ_NUM; i++) {
+		if (is[i].count != irq[i].count || is[i].total != irq[i].total ||
+		    is[i].max != irq[i].max) {
+			fprintf(stderr, "irq %d: count %u/%u\n", i, is[i].count, irq[i].count);
+			errors++;
+		}
+	}
+
+	n = OSTraceGetLockStat(ls, TRACE_LOCK_MAX);
+	for (k = 0; k < n; k++) {
+		i = (const struct sim_obj *)ls[k].obj - obj;
+		if (i < 0 || i >= SIM_OBJ_NUM || ls[k].waits != obj[i].waits ||
+		    ls[k].total != obj[i].total ||
+		    (k > 0 && ls[k].total > ls[k - 1].total)) {
+			fprintf(stderr, "lock %d: waits %u/%u\n", k, ls[k].waits,
+			        i >= 0 && i < SIM_OBJ_NUM ? obj[i].waits : 0);
+			errors++;
+		}
+	}
+	return errors;
+}
+
+static int write_raw(const void *buf, uint32_t len, void *arg)
+{
+	return fwrite(buf, 1, len, arg) == len ? 0 : -1;
+}
+
+struct hex_out {
+	FILE *f;
+	uint32_t offset;
+	uint32_t col;
+};
+
+static int write_hex(const void *buf, uint32_t len, void *arg)
+{
+	struct hex_out *h = arg;
+	const uint8_t *p = buf;
+
+	while (len--) {
+		if (h->col == 0)
+			fprintf(h->f, "TR %08x:", h->offset);
+		fprintf(h->f, " %02x", *p++);
+		h->offset++;
+		if (++h->col == 32) {
+			fprintf(h->f, "\n");
+			h->col = 0;
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	OSTraceInfo info;
+	struct hex_out hex;
+	struct sim_thread *t;
+	FILE *f;
+	int wrap, i, extra = -1;
+	int32_t len;
+
+	if (argc != 3 || (strcmp(argv[1], "full") && strcmp(argv[1], "wrap"))) {
+		fprintf(stderr, "usage: %s full|wrap <file>\n", argv[0]);
+		return 2;
+	}
+	wrap = strcmp(argv[1], "wrap") == 0;
+
+	create("IDLE");
+	create("audio");
+	create("net");
+	create("worker");
+	create("console");
+	cur = 0;
+	vTraceTaskSwitchedIn(thread[0].slot);
+	thread[0].state = S_RUNNING;
+
+	/* hooks before recording only keep track of the slots */
+	for (i = 0; i < 200; i++)
+		step();
+
+	for (i = 0; i < thread_num; i++) {
+		t = &thread[i];
+		memset(&t->run, 0, sizeof(*t) - offsetof(struct sim_thread, run));
+		t->known = (i == cur);
+		t->since = sim_now;
+	}
+	if (OSTraceStart(wrap ? 4096 : 4 * 1024 * 1024,
+	                 wrap ? TRACE_MODE_WRAP : TRACE_MODE_ONESHOT) != 0) {
+		fprintf(stderr, "start failed\n");
+		return 1;
+	}
+	recording = 1;
+
+	for (i = 0; i < SIM_STEPS; i++) {
+		if (i == SIM_STEPS / 4) {
+			extra = create("dhcp");
+		} else if (i == SIM_STEPS / 2 && extra >= 0) {
+			/* deleted while blocked or ready */
+			if (extra == cur)
+				switch_to(0);
+			vTraceTaskDelete(thread[extra].slot);
+			set_state(&thread[extra], S_DEAD);
+		} else if (i == SIM_STEPS * 3 / 4) {
+			/* a thread that deletes itself */
+			i++;
+			extra = create("oneshot");
+			switch_to(extra);
+			work(5000);
+			vTraceTaskDelete(thread[extra].slot);
+			thread[extra].state = S_DEAD;
+			switch_to(next_ready());
+		} else if (i == SIM_STEPS - 100) {
+			/* idle gap of most of the counter range */
+			switch_to(0);
+			work(3000000000U);
+		}
+		step();
+	}
+
+	OSTraceStop();
+	for (i = 0; i < thread_num; i++) {
+		if (thread[i].state != S_RUNNING && thread[i].state != S_DEAD)
+			set_state(&thread[i], thread[i].state);
+	}
+	recording = 0;
+
+	OSTraceGetInfo(&info);
+	if (info.elapsed == 0 || (wrap && info.dropped == 0) || (!wrap && info.dropped != 0)) {
+		fprintf(stderr, "info: %u events, %u dropped\n", info.event_num, info.dropped);
+		errors++;
+	}
+	check_stats();
+
+	f = fopen(argv[2], wrap ? "w" : "wb");
+	if (f == NULL) {
+		perror(argv[2]);
+		return 1;
+	}
+	if (wrap) {
+		memset(&hex, 0, sizeof(hex));
+		hex.f = f;
+		fprintf(f, "$ trace dump\nTR begin\n");
+		len = OSTraceDump(write_hex, &hex);
+		fprintf(f, "%sTR end %d\n", hex.col ? "\n" : "", len);
+	} else {
+		len = OSTraceDump(write_raw, f);
+	}
+	fclose(f);
+	if (len <= 0)
+		errors++;
+
+	for (i = 0; i < thread_num; i++) {
+		t = &thread[i];
+		printf("thread %u %s run %" PRIu64 " ready %" PRIu64 " blocked ",
+		       t->tid, t->name, t->run, t->ready);
+		printf("%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64
+		       ",%" PRIu64 ",%" PRIu64, t->blocked[0], t->blocked[1],
+		       t->blocked[2], t->blocked[3], t->blocked[4], t->blocked[5],
+		       t->blocked[6]);
+		printf(" switches %u preempts %u\n", t->switches, t->preempts);
+	}
+	for (i = 0; i < SIM_IRQ_NUM; i++) {
+		if (irq[i].count)
+			printf("irq %d count %u total %" PRIu64 " max %" PRIu64 "\n",
+			       i, irq[i].count, irq[i].total, irq[i].max);
+	}
+
+	fprintf(stderr, "%s: %u events, %u dropped, %d bytes, %u errors\n",
+	        argv[1], info.event_num, info.dropped, len, errors);
+	return errors ? 1 : 0;
+}
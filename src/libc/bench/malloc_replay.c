@@ -0,0 +1,539 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Linux replay of allocation traces through the tracing wrappers of
+ * wrap_malloc.c (__CONFIG_MALLOC_TRACE), built against the stand-ins of
+ * port/ with the C library allocator underneath.
+ *
+ *   malloc_replay [trace]
+ *
+ * A trace has one operation per line:
+ *     t <thread>          following operations run in <thread>
+ *     m <id> <size>       malloc
+ *     r <id> <size>       realloc
+ *     f <id>              free
+ *     d <thread>          <thread> is deleted, its handle may be reused
+ * Without a trace file, synthetic traces from 8 threads are replayed at 100,
+ * 600 and 880 live blocks, each one through the linear table that the
+ * wrappers used before the hash table and then through the hash table, and
+ * the cost per operation of both is printed. A churn of short-lived threads
+ * then checks that the slots of deleted threads are given back. After each
+ * trace the totals and the per-thread sums of the tracker are checked
+ * against the replayed trace.
+ */
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../wrap_malloc.c"
+
+#define REPLAY_ID_MAX           4096
+#define REPLAY_THREAD_MAX       64
+#define REPLAY_OPS              200000
+
+static int sim_errors;
+
+#define SIM_CHECK(cond, fmt, arg...)                                    \
+	do {                                                            \
+		if (!(cond)) {                                          \
+			printf("FAIL %s:%d: " fmt "\n", __func__,       \
+			       __LINE__, ##arg);                        \
+			sim_errors++;                                   \
+		}                                                       \
+	} while (0)
+
+/* ------------------------------------------------------------------------ */
+/* host stand-ins                                                            */
+
+static OS_ThreadHandle_t sim_current;
+
+void *__real_malloc(size_t size)
+{
+	return malloc(size);
+}
+
+void *__real_realloc(void *ptr, size_t size)
+{
+	return realloc(ptr, size);
+}
+
+void __real_free(void *ptr)
+{
+	free(ptr);
+}
+
+void *__real__malloc_r(struct _reent *reent, size_t size)
+{
+	return malloc(size);
+}
+
+void *__real__realloc_r(struct _reent *reent, void *ptr, size_t size)
+{
+	return realloc(ptr, size);
+}
+
+void __real__free_r(struct _reent *reent, void *ptr)
+{
+	free(ptr);
+}
+
+OS_ThreadHandle_t OS_ThreadGetCurrentHandle(void)
+{
+	return sim_current;
+}
+
+void OS_ThreadSuspendScheduler(void)
+{
+}
+
+void OS_ThreadResumeScheduler(void)
+{
+}
+
+int xTaskGetSchedulerState(void)
+{
+	return 0;
+}
+
+char *pcTaskGetTaskName(OS_ThreadHandle_t handle)
+{
+	static char name[configMAX_TASK_NAME_LEN];
+
+	snprintf(name, sizeof(name), "t%u", (unsigned)((uintptr_t)handle >> 4));
+	return name;
+}
+
+/* ------------------------------------------------------------------------ */
+/* the linear table of the wrappers before the hash table, for comparison    */
+
+#define LINEAR_MEM_MAX_CNT      1024
+
+static struct {
+	void *ptr;
+	size_t size;
+} lin_mem[LINEAR_MEM_MAX_CNT];
+
+static int lin_entry_cnt;
+static int lin_entry_cnt_max;
+static int lin_empty_idx;
+static size_t lin_sum;
+
+static void *linear_malloc(size_t size)
+{
+	malloc_mutex_lock();
+	void *ptr = __real_malloc(size + WRAP_MEM_MAGIC_LEN);
+
+	if (ptr) {
+		WRAP_MEM_SET_MAGIC(ptr, size);
+		int i;
+		for (i = lin_empty_idx; i < LINEAR_MEM_MAX_CNT; ++i) {
+			if (lin_mem[i].ptr == 0) {
+				lin_mem[i].ptr = ptr;
+				lin_mem[i].size = size;
+				lin_entry_cnt++;
+				lin_empty_idx = i + 1;
+				lin_sum += size;
+				if (lin_entry_cnt > lin_entry_cnt_max)
+					lin_entry_cnt_max = lin_entry_cnt;
+				break;
+			}
+		}
+	}
+	malloc_mutex_unlock();
+
+	return ptr;
+}
+
+static void *linear_realloc(void *ptr, size_t size)
+{
+	malloc_mutex_lock();
+	void *p = __real_realloc(ptr, size + WRAP_MEM_MAGIC_LEN);
+
+	if (p) {
+		WRAP_MEM_SET_MAGIC(p, size);
+		int i;
+		for (i = 0; i < LINEAR_MEM_MAX_CNT; ++i) {
+			if (lin_mem[i].ptr != ptr)
+				continue;
+			lin_sum -= lin_mem[i].size;
+			lin_mem[i].ptr = p;
+			lin_mem[i].size = size;
+			lin_sum += size;
+			break;
+		}
+	}
+	malloc_mutex_unlock();
+
+	return p;
+}
+
+static void linear_free(void *ptr)
+{
+	malloc_mutex_lock();
+	if (ptr) {
+		int i;
+		for (i = 0; i < LINEAR_MEM_MAX_CNT; ++i) {
+			if (lin_mem[i].ptr != ptr)
+				continue;
+			if (WRAP_MEM_CHK_MAGIC(lin_mem[i].ptr, lin_mem[i].size))
+				SIM_CHECK(0, "memory (%p) corrupt", ptr);
+			lin_sum -= lin_mem[i].size;
+			lin_mem[i].ptr = 0;
+			lin_mem[i].size = 0;
+			lin_entry_cnt--;
+			if (i < lin_empty_idx)
+				lin_empty_idx = i;
+			break;
+		}
+	}
+
+	__real_free(ptr);
+	malloc_mutex_unlock();
+}
+
+/* ------------------------------------------------------------------------ */
+/* replay                                                                    */
+
+/* A thread's handle is reused after its deletion, like a TCB address */
+struct replay_thread {
+	uint32_t gen;           /* incarnation, counted up by each deletion */
+	uint32_t sum;
+	uint32_t cnt;
+};
+
+struct replay_block {
+	void *ptr;
+	uint32_t size;
+	int thread;
+	uint32_t gen;
+};
+
+static struct replay_thread threads[REPLAY_THREAD_MAX];
+static struct replay_block blocks[REPLAY_ID_MAX];
+static int cur_thread;
+static int replay_linear;       /* through the linear table */
+static uint32_t live_sum;
+static uint32_t deleted_sum;    /* held by deleted incarnations */
+static uint32_t deleted_cnt;
+
+static OS_ThreadHandle_t replay_handle(int t)
+{
+	return (OS_ThreadHandle_t)(uintptr_t)(0x20000000 + t * 0x10);
+}
+
+static void replay_thread(int t)
+{
+	cur_thread = t;
+	sim_current = replay_handle(t);
+}
+
+static void replay_account(struct replay_block *b, int add)
+{
+	int32_t d = add ? (int32_t)b->size : -(int32_t)b->size;
+
+	live_sum += d;
+	if (b->gen == threads[b->thread].gen) {
+		threads[b->thread].sum += d;
+		threads[b->thread].cnt += add ? 1 : -1;
+	} else {
+		deleted_sum += d;
+		deleted_cnt += add ? 1 : -1;
+	}
+}
+
+static void replay_malloc(int id, uint32_t size)
+{
+	struct replay_block *b = &blocks[id];
+
+	b->ptr = replay_linear ? linear_malloc(size) : __wrap_malloc(size);
+	b->size = size;
+	b->thread = cur_thread;
+	b->gen = threads[cur_thread].gen;
+	replay_account(b, 1);
+}
+
+/* the block stays with the thread which allocated it */
+static void replay_realloc(int id, uint32_t size)
+{
+	struct replay_block *b = &blocks[id];
+
+	if (b->ptr == NULL) {
+		replay_malloc(id, size);
+		return;
+	}
+	replay_account(b, 0);
+	b->ptr = replay_linear ? linear_realloc(b->ptr, size) :
+	                         __wrap_realloc(b->ptr, size);
+	b->size = size;
+	replay_account(b, 1);
+}
+
+static void replay_free(int id)
+{
+	struct replay_block *b = &blocks[id];
+
+	if (b->ptr == NULL)
+		return;
+	replay_account(b, 0);
+	if (replay_linear)
+		linear_free(b->ptr);
+	else
+		__wrap_free(b->ptr);
+	b->ptr = NULL;
+}
+
+static void replay_delete(int t)
+{
+	deleted_sum += threads[t].sum;
+	deleted_cnt += threads[t].cnt;
+	threads[t].sum = 0;
+	threads[t].cnt = 0;
+	threads[t].gen++;
+	wrap_malloc_thread_delete(replay_handle(t));
+}
+
+static void replay_free_all(void)
+{
+	int id;
+
+	for (id = 0; id < REPLAY_ID_MAX; id++)
+		replay_free(id);
+}
+
+/* The tracker against the replayed trace */
+static void replay_check(const char *name)
+{
+	uint32_t sum = 0, dsum = 0, dcnt = 0;
+	struct heap_owner *o;
+	int i, t;
+
+	SIM_CHECK(g_mem_sum == live_sum, "%s: sum %u, trace %u",
+	          name, (unsigned)g_mem_sum, live_sum);
+	SIM_CHECK(g_mem_owner[HEAP_OWNER_OTHER].sum_max == 0,
+	          "%s: owner table overflowed", name);
+
+	for (i = 0; i < HEAP_OWNER_MAX_CNT; i++) {
+		o = &g_mem_owner[i];
+		sum += o->sum;
+		if (i == HEAP_OWNER_OTHER) {
+			continue;
+		} else if (o->state == HEAP_OWNER_FREE) {
+			SIM_CHECK(o->cnt == 0 && o->sum == 0, "%s: free slot %d in use",
+			          name, i);
+		} else if (o->state == HEAP_OWNER_DELETED) {
+			SIM_CHECK(o->cnt != 0, "%s: empty deleted slot %d kept", name, i);
+			dsum += o->sum;
+			dcnt += o->cnt;
+		} else {
+			for (t = 0; t < REPLAY_THREAD_MAX; t++) {
+				if (replay_handle(t) == o->handle)
+					break;
+			}
+			SIM_CHECK(t < REPLAY_THREAD_MAX && o->sum == threads[t].sum &&
+			          o->cnt == threads[t].cnt,
+			          "%s: slot %d (%s) %u/%u, trace %u/%u", name, i, o->name,
+			          o->sum, o->cnt, threads[t].sum, threads[t].cnt);
+		}
+	}
+	SIM_CHECK(sum == live_sum, "%s: thread sums %u, trace %u", name, sum, live_sum);
+	SIM_CHECK(dsum == deleted_sum && dcnt == deleted_cnt,
+	          "%s: deleted threads %u/%u, trace %u/%u",
+	          name, dsum, dcnt, deleted_sum, deleted_cnt);
+}
+
+static double sim_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* ------------------------------------------------------------------------ */
+/* traces                                                                    */
+
+static uint32_t rnd_state = 12345;
+
+static uint32_t rnd(uint32_t n)
+{
+	rnd_state = rnd_state * 1103515245 + 12345;
+	return (rnd_state >> 8) % n;
+}
+
+/* Random malloc/realloc/free from 8 threads around @live blocks */
+static double replay_trace(int live)
+{
+	int ids[REPLAY_ID_MAX];
+	int nlive = 0, nfree = REPLAY_ID_MAX;
+	int free_ids[REPLAY_ID_MAX];
+	double start;
+	int i, k, id, op;
+
+	rnd_state = 12345 + live;
+	for (i = 0; i < REPLAY_ID_MAX; i++)
+		free_ids[i] = REPLAY_ID_MAX - 1 - i;
+
+	while (nlive < live) {
+		replay_thread(rnd(8));
+		id = free_ids[--nfree];
+		replay_malloc(id, 8 + rnd(2000));
+		ids[nlive++] = id;
+	}
+
+	start = sim_now();
+	for (i = 0; i < REPLAY_OPS; i++) {
+		replay_thread(rnd(8));
+		op = rnd(4);
+		if (op == 0 || (op == 1 && nlive > live)) {
+			k = rnd(nlive);
+			replay_free(ids[k]);
+			free_ids[nfree++] = ids[k];
+			ids[k] = ids[--nlive];
+		} else if (op == 1 || nlive < live) {
+			id = free_ids[--nfree];
+			replay_malloc(id, 8 + rnd(2000));
+			ids[nlive++] = id;
+		} else {
+			replay_realloc(ids[rnd(nlive)], 8 + rnd(2000));
+		}
+	}
+	return sim_now() - start;
+}
+
+/* The same trace through the linear table, then through the hash table */
+static void replay_synthetic(int live)
+{
+	double lin_secs, secs;
+	char name[32];
+
+	replay_linear = 1;
+	lin_secs = replay_trace(live);
+	SIM_CHECK(lin_sum == live_sum, "%d live linear: sum %u, trace %u",
+	          live, (unsigned)lin_sum, live_sum);
+	replay_free_all();
+	replay_linear = 0;
+
+	secs = replay_trace(live);
+	snprintf(name, sizeof(name), "%d live", live);
+	replay_check(name);
+	printf("%4d live blocks: linear %6.1f ns/op, hash %6.1f ns/op, "
+	       "%d entries max\n", live, lin_secs * 1e9 / REPLAY_OPS,
+	       secs * 1e9 / REPLAY_OPS, g_mem_entry_cnt_max);
+	replay_free_all();
+	replay_check(name);
+}
+
+/* Threads come and go, some leave blocks freed by others after they are gone */
+static void replay_churn(void)
+{
+	int kept[REPLAY_THREAD_MAX * 4];
+	int head = 0, tail = 0;
+	int t, id = 0;
+
+	for (t = 0; t < REPLAY_THREAD_MAX * 4; t++) {
+		replay_thread(8 + t % (REPLAY_THREAD_MAX - 8));
+		replay_malloc(id, 100 + t);
+		replay_malloc(id + 1, 200);
+		replay_free(id + 1);
+		if (t % 3 == 0) {
+			replay_free(id);
+		} else {
+			kept[tail++] = id;
+		}
+		id += 2;
+		replay_delete(cur_thread);
+
+		/* the oldest blocks of deleted threads are freed by a survivor */
+		replay_thread(0);
+		while (tail - head > 4)
+			replay_free(kept[head++]);
+		replay_check("churn");
+	}
+	replay_thread(0);
+	replay_free_all();
+	replay_check("churn end");
+}
+
+static int replay_file(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	char line[64];
+	unsigned a, b;
+	int n = 0;
+
+	if (f == NULL) {
+		printf("FAIL cannot open %s\n", path);
+		return -1;
+	}
+	while (fgets(line, sizeof(line), f) != NULL) {
+		n++;
+		if (sscanf(line + 1, "%u %u", &a, &b) < 1 ||
+		    a >= (line[0] == 't' || line[0] == 'd' ?
+		          REPLAY_THREAD_MAX : REPLAY_ID_MAX)) {
+			printf("FAIL %s:%d: bad line\n", path, n);
+			sim_errors++;
+			continue;
+		}
+		switch (line[0]) {
+		case 't': replay_thread(a); break;
+		case 'm': replay_malloc(a, b); break;
+		case 'r': replay_realloc(a, b); break;
+		case 'f': replay_free(a); break;
+		case 'd': replay_delete(a); break;
+		}
+	}
+	fclose(f);
+	printf("%s: %d operations\n", path, n);
+	replay_check(path);
+	wrap_malloc_heap_info(0);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc > 1) {
+		replay_file(argv[1]);
+	} else {
+		replay_synthetic(100);
+		replay_synthetic(600);
+		replay_synthetic(880);
+		replay_churn();
+	}
+
+	if (sim_errors) {
+		printf("%d errors\n", sim_errors);
+		return 1;
+	}
+	return 0;
+}
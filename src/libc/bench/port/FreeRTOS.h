@@ -0,0 +1,29 @@
+/*
+ * Host stand-in for FreeRTOS.h, with only what heap_4.c needs: the heap is
+ * a static array of configTOTAL_HEAP_SIZE bytes, as on a build without the
+ * linker allocated heap. See slab_bench.c.
+ */
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define configLINKER_ALLOCATED_HEAP         0
+#define configAPPLICATION_ALLOCATED_HEAP    0
+#ifndef configTOTAL_HEAP_SIZE
+#define configTOTAL_HEAP_SIZE               (160 * 1024)
+#endif
+#define configUSE_MALLOC_FAILED_HOOK        0
+#define configASSERT(x)                     assert(x)
+
+#define portBYTE_ALIGNMENT                  8
+#define portBYTE_ALIGNMENT_MASK             0x0007
+
+#define mtCOVERAGE_TEST_MARKER()
+#define traceMALLOC(pvAddress, uiSize)
+#define traceFREE(pvAddress, uiSize)
+
+#endif /* INC_FREERTOS_H */
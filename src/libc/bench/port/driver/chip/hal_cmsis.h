@@ -0,0 +1,13 @@
+/*
+ * Host stand-in for the CMSIS core registers read by the stdio wrappers:
+ * the bench runs in thread mode with interrupts enabled.
+ */
+
+#ifndef _DRIVER_CHIP_HAL_CMSIS_H_
+#define _DRIVER_CHIP_HAL_CMSIS_H_
+
+#define __get_PRIMASK()         0
+#define __get_FAULTMASK()       0
+#define __get_IPSR()            0
+
+#endif /* _DRIVER_CHIP_HAL_CMSIS_H_ */
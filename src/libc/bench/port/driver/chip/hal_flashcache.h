@@ -0,0 +1,13 @@
+/*
+ * Host stand-in for the flash cache header: there is no XIP flash on the
+ * host, only [__RAM_BASE, __etext) counts as read-only data.
+ */
+
+#ifndef _DRIVER_CHIP_HAL_FLASHCACHE_H_
+#define _DRIVER_CHIP_HAL_FLASHCACHE_H_
+
+#include <stdint.h>
+
+#define FLASH_ROM_START_ADDR    UINTPTR_MAX
+
+#endif /* _DRIVER_CHIP_HAL_FLASHCACHE_H_ */
@@ -0,0 +1,13 @@
+/*
+ * Host stand-in for the OS errno header: libc/errno.h maps errno to
+ * OS_GetErrno(), which is the C library's errno here.
+ */
+
+#ifndef _KERNEL_OS_OS_ERRNO_H_
+#define _KERNEL_OS_OS_ERRNO_H_
+
+extern int *__errno_location(void);
+
+#define OS_GetErrno()   (*__errno_location())
+
+#endif /* _KERNEL_OS_OS_ERRNO_H_ */
@@ -0,0 +1 @@
+#include "kernel/os/os_thread.h"
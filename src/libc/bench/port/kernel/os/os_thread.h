@@ -0,0 +1,70 @@
+/*
+ * Host stand-in for the kernel/os thread, semaphore, mutex and time API used
+ * by wrap_stdio.c, stdio_defer.c and wrap_malloc.c, on POSIX threads. See
+ * stdio_bench.c and malloc_replay.c, each defines the calls it uses.
+ */
+
+#ifndef _KERNEL_OS_OS_THREAD_H_
+#define _KERNEL_OS_OS_THREAD_H_
+
+#include <stdint.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <unistd.h>
+
+typedef enum {
+	OS_OK   = 0,
+	OS_FAIL = -1,
+} OS_Status;
+
+#define OS_WAIT_FOREVER         0xffffffffU
+#define OS_PRIORITY_LOW         0
+
+typedef void (*OS_ThreadEntry_t)(void *arg);
+
+typedef struct OS_Thread {
+	pthread_t handle;
+	volatile int valid;
+} OS_Thread_t;
+
+typedef struct OS_Semaphore {
+	sem_t sem;
+} OS_Semaphore_t;
+
+typedef struct OS_Mutex {
+	pthread_mutex_t mutex;
+	volatile int valid;
+} OS_Mutex_t;
+
+OS_Status OS_ThreadCreate(OS_Thread_t *thread, const char *name,
+                          OS_ThreadEntry_t entry, void *arg,
+                          int priority, uint32_t stackSize);
+OS_Status OS_ThreadDelete(OS_Thread_t *thread);
+#define OS_ThreadIsValid(thread)        ((thread)->valid)
+#define OS_ThreadIsSchedulerRunning()   1
+
+typedef void *OS_ThreadHandle_t;
+
+OS_ThreadHandle_t OS_ThreadGetCurrentHandle(void);
+void OS_ThreadSuspendScheduler(void);
+void OS_ThreadResumeScheduler(void);
+
+/* the FreeRTOS calls wrap_malloc.c makes directly */
+#define configMAX_TASK_NAME_LEN         16
+#define taskSCHEDULER_NOT_STARTED       1
+int xTaskGetSchedulerState(void);
+char *pcTaskGetTaskName(OS_ThreadHandle_t handle);
+
+OS_Status OS_SemaphoreCreateBinary(OS_Semaphore_t *sem);
+OS_Status OS_SemaphoreDelete(OS_Semaphore_t *sem);
+OS_Status OS_SemaphoreWait(OS_Semaphore_t *sem, uint32_t waitMS);
+OS_Status OS_SemaphoreRelease(OS_Semaphore_t *sem);
+
+#define OS_MutexIsValid(mutex)          ((mutex)->valid)
+OS_Status OS_RecursiveMutexCreate(OS_Mutex_t *mutex);
+OS_Status OS_RecursiveMutexLock(OS_Mutex_t *mutex, uint32_t waitMS);
+OS_Status OS_RecursiveMutexUnlock(OS_Mutex_t *mutex);
+
+#define OS_MSleep(msec)                 usleep((msec) * 1000)
+
+#endif /* _KERNEL_OS_OS_THREAD_H_ */
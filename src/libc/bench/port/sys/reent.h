@@ -0,0 +1,11 @@
+/*
+ * Host stand-in for the newlib reentrancy header: the _r allocator entry
+ * points of wrap_malloc.c only pass the pointer through.
+ */
+
+#ifndef _SYS_REENT_H_
+#define _SYS_REENT_H_
+
+struct _reent;
+
+#endif /* _SYS_REENT_H_ */
@@ -0,0 +1,13 @@
+/*
+ * Host stand-in for the XRADIO utility header: sys/xr_debug.h only needs
+ * sys_abort().
+ */
+
+#ifndef _SYS_XR_UTIL_H_
+#define _SYS_XR_UTIL_H_
+
+#include <stdlib.h>
+
+#define sys_abort()     abort()
+
+#endif /* _SYS_XR_UTIL_H_ */
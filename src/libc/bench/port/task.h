@@ -0,0 +1,12 @@
+/*
+ * Host stand-in for task.h: the scheduler lock of heap_4.c. See
+ * slab_bench.c.
+ */
+
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+void vTaskSuspendAll(void);
+long xTaskResumeAll(void);
+
+#endif /* INC_TASK_H */
@@ -0,0 +1,33 @@
+#!/bin/sh
+#
+# Build wrap_stdio.c and stdio_defer.c with the deferred stdout against the
+# host stand-ins of port/, check the formatting against the C library and
+# run the producer contention benchmark. The read-only data of the image is
+# mapped to the host executable's text and read-only data.
+#
+# Then replay allocation traces through the tracing wrappers of
+# wrap_malloc.c, and compare heap_4 of the kernel with and without the size
+# classes of malloc_slab.c, using a 64 KB arena in a 160 KB heap.
+# Arguments are passed to stdio_bench.
+#
+set -e
+cd "$(dirname "$0")"
+gcc -O2 -Wall -Wno-format -pthread -D__CONFIG_LIBC_WRAP_STDIO -D__CONFIG_LIBC_WRAP_STDIO_DEFER \
+	-Iport -I../../../include/libc -I../../../include \
+	-no-pie -Wl,--defsym,__RAM_BASE=__executable_start -Wl,--defsym,__etext=__data_start \
+	stdio_bench.c ../wrap_stdio.c ../stdio_defer.c -o /tmp/stdio_bench
+/tmp/stdio_bench "$@"
+
+gcc -O2 -Wall -Wno-int-to-pointer-cast -Wno-pointer-to-int-cast -Wno-format -Wno-stringop-truncation \
+	-D__CONFIG_OS_FREERTOS -D__CONFIG_MALLOC_USE_STDLIB -D__CONFIG_MALLOC_TRACE \
+	-Iport -I../../../include \
+	malloc_replay.c -o /tmp/malloc_replay
+
+gcc -O2 -Wall -Wno-pointer-to-int-cast \
+	-D__CONFIG_MALLOC_SLAB -DMALLOC_SLAB_ARENA_SIZE=65536 \
+	-Iport -I../../../include \
+	slab_bench.c -o /tmp/slab_bench
+/tmp/slab_bench
+/tmp/malloc_replay
+
+echo "PASS"
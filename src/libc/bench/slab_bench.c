@@ -0,0 +1,440 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Linux benchmark and test of malloc_slab.c over heap_4.c of this tree, as
+ * built with __CONFIG_MALLOC_SLAB=y and __CONFIG_MALLOC_USE_STDLIB=n.
+ *
+ *   slab_bench [ops]
+ *
+ * The size classes are checked first: blocks never overlap, realloc keeps
+ * the data, empty pages go back to the arena and requests spill to the heap
+ * once the arena is full. Then one synthetic trace, about 600 live blocks of
+ * small short-lived and larger long-lived requests, is replayed on heap_4
+ * alone and on heap_4 under the size classes. The heap fragmentation
+ * (1 - largest free block / free bytes) and the cost of each call are
+ * printed for both.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../kernel/FreeRTOS/Source/portable/MemMang/heap_4.c"
+#include "../malloc_slab.c"
+
+#define SIM_SMALL_LIVE          520
+#define SIM_LARGE_LIVE          80
+#define SIM_ID_MAX              (SIM_SMALL_LIVE + SIM_LARGE_LIVE)
+#define SIM_OPS                 200000
+
+static int sim_errors;
+
+#define SIM_CHECK(cond, fmt, arg...)                                    \
+	do {                                                            \
+		if (!(cond)) {                                          \
+			printf("FAIL %s:%d: " fmt "\n", __func__,       \
+			       __LINE__, ##arg);                        \
+			sim_errors++;                                   \
+		}                                                       \
+	} while (0)
+
+/* ------------------------------------------------------------------------ */
+/* host stand-ins, single threaded                                           */
+
+void vTaskSuspendAll(void)
+{
+}
+
+long xTaskResumeAll(void)
+{
+	return 0;
+}
+
+void OS_ThreadSuspendScheduler(void)
+{
+}
+
+void OS_ThreadResumeScheduler(void)
+{
+}
+
+/* Start again from an empty heap_4 and an arena not taken yet */
+static void sim_reset(void)
+{
+	pxEnd = NULL;
+	xBlockAllocatedBit = 0;
+	xFreeBytesRemaining = 0;
+	xMinimumEverFreeBytesRemaining = 0;
+	memset(ucHeap, 0, sizeof(ucHeap));
+
+	g_slab_arena = NULL;
+	g_slab_state = 0;
+	memset(g_slab_class_info, 0, sizeof(g_slab_class_info));
+	g_slab_large_cnt = 0;
+	g_slab_full_cnt = 0;
+}
+
+/* Fragmentation of the free list of heap_4, in 1/1000 */
+static unsigned sim_heap_frag(size_t *largest)
+{
+	BlockLink_t *b;
+	size_t max = 0, sum = 0;
+
+	for (b = xStart.pxNextFreeBlock; b != pxEnd; b = b->pxNextFreeBlock) {
+		sum += b->xBlockSize;
+		if (b->xBlockSize > max)
+			max = b->xBlockSize;
+	}
+	*largest = max;
+	return sum ? (unsigned)(1000 - max * 1000 / sum) : 0;
+}
+
+static uint64_t sim_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static uint32_t rnd_state;
+
+static uint32_t rnd(uint32_t n)
+{
+	rnd_state = rnd_state * 1103515245 + 12345;
+	return (rnd_state >> 8) % n;
+}
+
+/* ------------------------------------------------------------------------ */
+/* size classes                                                              */
+
+struct sim_block {
+	uint8_t *ptr;
+	uint32_t size;
+};
+
+static void sim_fill(struct sim_block *b, int id)
+{
+	memset(b->ptr, (uint8_t)(id * 7 + 1), b->size);
+}
+
+static int sim_intact(struct sim_block *b, int id, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++) {
+		if (b->ptr[i] != (uint8_t)(id * 7 + 1))
+			return 0;
+	}
+	return 1;
+}
+
+static void slab_check_classes(void)
+{
+	struct sim_block b;
+	uint32_t size;
+	int idx;
+
+	sim_reset();
+	for (size = 1; size <= MALLOC_SLAB_MAX_SIZE; size++) {
+		b.ptr = malloc_slab_alloc(size);
+		b.size = size;
+		idx = slab_page_of(b.ptr);
+		SIM_CHECK(idx >= 0, "size %u not from the arena", size);
+		if (idx < 0)
+			continue;
+		SIM_CHECK(g_slab_size[g_slab_page[idx].cls] >= size &&
+		          (g_slab_page[idx].cls == 0 ||
+		           g_slab_size[g_slab_page[idx].cls - 1] < size),
+		          "size %u in class %u", size, g_slab_size[g_slab_page[idx].cls]);
+		SIM_CHECK(((uintptr_t)b.ptr & (portBYTE_ALIGNMENT - 1)) == 0,
+		          "size %u at %p", size, b.ptr);
+		malloc_slab_free(b.ptr);
+	}
+
+	b.ptr = malloc_slab_alloc(0);
+	SIM_CHECK(!malloc_slab_owns(b.ptr), "size 0 from the arena");
+	malloc_slab_free(b.ptr);
+	b.ptr = malloc_slab_alloc(MALLOC_SLAB_MAX_SIZE + 1);
+	SIM_CHECK(b.ptr && !malloc_slab_owns(b.ptr), "large block from the arena");
+	malloc_slab_free(b.ptr);
+	SIM_CHECK(g_slab_large_cnt == 2, "large count %u", g_slab_large_cnt);
+}
+
+/* Random traffic with a pattern per block, then everything is freed */
+static void slab_check_random(void)
+{
+	static struct sim_block blk[SIM_ID_MAX];
+	uint32_t cnt[MALLOC_SLAB_CLASS_CNT] = { 0 };
+	int i, id, c;
+
+	sim_reset();
+	rnd_state = 1;
+	memset(blk, 0, sizeof(blk));
+	for (i = 0; i < 50000; i++) {
+		id = rnd(SIM_SMALL_LIVE);
+		if (blk[id].ptr == NULL) {
+			blk[id].size = 1 + rnd(MALLOC_SLAB_MAX_SIZE);
+			blk[id].ptr = malloc_slab_alloc(blk[id].size);
+			if (malloc_slab_owns(blk[id].ptr))
+				cnt[g_slab_class[(blk[id].size - 1) >> 4]]++;
+			sim_fill(&blk[id], id);
+		} else {
+			SIM_CHECK(sim_intact(&blk[id], id, blk[id].size),
+			          "block %d (%u bytes) overwritten", id, blk[id].size);
+			if (malloc_slab_owns(blk[id].ptr))
+				cnt[g_slab_class[(blk[id].size - 1) >> 4]]--;
+			malloc_slab_free(blk[id].ptr);
+			blk[id].ptr = NULL;
+		}
+	}
+	for (c = 0; c < MALLOC_SLAB_CLASS_CNT; c++) {
+		SIM_CHECK(g_slab_class_info[c].inuse == cnt[c], "class %u: %u in use, %u",
+		          g_slab_size[c], g_slab_class_info[c].inuse, cnt[c]);
+	}
+
+	for (id = 0; id < SIM_SMALL_LIVE; id++) {
+		if (blk[id].ptr == NULL)
+			continue;
+		SIM_CHECK(sim_intact(&blk[id], id, blk[id].size),
+		          "block %d (%u bytes) overwritten", id, blk[id].size);
+		malloc_slab_free(blk[id].ptr);
+	}
+	for (c = 0; c < MALLOC_SLAB_CLASS_CNT; c++) {
+		SIM_CHECK(g_slab_class_info[c].inuse == 0 && g_slab_class_info[c].pages <= 1,
+		          "class %u: %u in use, %u pages after free", g_slab_size[c],
+		          g_slab_class_info[c].inuse, g_slab_class_info[c].pages);
+	}
+	SIM_CHECK(g_slab_free_page_cnt >= MALLOC_SLAB_PAGE_CNT - MALLOC_SLAB_CLASS_CNT,
+	          "%u free pages after free", g_slab_free_page_cnt);
+}
+
+static void slab_check_realloc(void)
+{
+	struct sim_block b;
+	uint8_t *p;
+
+	sim_reset();
+	b.size = 20;
+	b.ptr = malloc_slab_alloc(b.size);
+	sim_fill(&b, 3);
+
+	p = malloc_slab_realloc(b.ptr, 30);
+	SIM_CHECK(p == b.ptr, "moved within its class");
+	p = malloc_slab_realloc(b.ptr, 100);
+	SIM_CHECK(p != b.ptr && sim_intact(&(struct sim_block){ p, 20 }, 3, 20),
+	          "grown to another class");
+	b.ptr = p;
+	p = malloc_slab_realloc(b.ptr, 10);
+	SIM_CHECK(p != b.ptr && slab_page_of(p) >= 0 &&
+	          g_slab_page[slab_page_of(p)].cls == 0 &&
+	          sim_intact(&(struct sim_block){ p, 10 }, 3, 10), "shrunk to 16");
+	b.ptr = p;
+	p = malloc_slab_realloc(b.ptr, 1000);
+	SIM_CHECK(p && !malloc_slab_owns(p) &&
+	          sim_intact(&(struct sim_block){ p, 10 }, 3, 10), "moved to the heap");
+	malloc_slab_free(p);
+	SIM_CHECK(g_slab_class_info[0].inuse + g_slab_class_info[1].inuse +
+	          g_slab_class_info[4].inuse == 0, "blocks left behind");
+}
+
+/* Once every page is used, requests go to the heap and come back */
+static void slab_check_full(void)
+{
+	static void *ptr[MALLOC_SLAB_ARENA_SIZE / 16 + 16];
+	int n = 0, i;
+
+	sim_reset();
+	while (g_slab_full_cnt == 0 && n < (int)(sizeof(ptr) / sizeof(ptr[0])))
+		ptr[n++] = malloc_slab_alloc(16);
+	SIM_CHECK(n == MALLOC_SLAB_ARENA_SIZE / 16 + 1, "arena full after %d blocks", n);
+	SIM_CHECK(ptr[n - 1] && !malloc_slab_owns(ptr[n - 1]), "spilled block");
+	for (i = 0; i < n; i++)
+		malloc_slab_free(ptr[i]);
+	SIM_CHECK(g_slab_class_info[0].inuse == 0 && g_slab_class_info[0].pages == 1,
+	          "%u in use, %u pages", g_slab_class_info[0].inuse,
+	          g_slab_class_info[0].pages);
+}
+
+/* ------------------------------------------------------------------------ */
+/* trace replay                                                              */
+
+static int cmp_u32(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* Pick a block of the pool to free, or a free id to allocate */
+struct sim_pool {
+	int *live;
+	int *idle;
+	int nlive;
+	int nidle;
+	int target;
+};
+
+static void sim_pool_init(struct sim_pool *p, int *ids, int base, int target)
+{
+	int i;
+
+	p->live = ids;
+	p->idle = ids + target * 2;
+	p->nlive = 0;
+	p->nidle = target * 2;
+	p->target = target;
+	for (i = 0; i < p->nidle; i++)
+		p->idle[i] = base + i;
+}
+
+/*
+ * Small requests (3/4 up to 128 bytes, the others up to 256) come and go 8
+ * times as often as larger ones of 300 ~ 1100 bytes, each pool stays around
+ * its number of live blocks.
+ */
+static void sim_replay(const char *name, int slab, int ops)
+{
+	static struct sim_block blk[SIM_ID_MAX * 2];
+	static int ids[SIM_ID_MAX * 4];
+	static uint32_t lat[SIM_OPS];
+	struct sim_pool pool[2], *p;
+	unsigned frag, frag_sum = 0, frag_max = 0, samples = 0;
+	uint32_t nlat = 0, fail = 0;
+	size_t largest, largest_min = configTOTAL_HEAP_SIZE;
+	uint64_t t0, t1;
+	int i, k, id;
+
+	sim_reset();
+	rnd_state = 12345;
+	memset(blk, 0, sizeof(blk));
+	sim_pool_init(&pool[0], ids, 0, SIM_SMALL_LIVE);
+	sim_pool_init(&pool[1], ids + SIM_SMALL_LIVE * 4, SIM_SMALL_LIVE * 2,
+	              SIM_LARGE_LIVE);
+
+	for (i = -SIM_ID_MAX * 2; i < ops; i++) {
+		p = &pool[rnd(8) == 0];
+		if (p->nlive < p->target || (p->nlive == p->target && rnd(2))) {
+			id = p->idle[--p->nidle];
+			if (p == &pool[1])
+				blk[id].size = 300 + rnd(800);
+			else if (rnd(4) != 0)
+				blk[id].size = 8 + rnd(120);
+			else
+				blk[id].size = 128 + rnd(128);
+			t0 = sim_ns();
+			blk[id].ptr = slab ? malloc_slab_alloc(blk[id].size) :
+			                     pvPortMalloc(blk[id].size);
+			t1 = sim_ns();
+			if (blk[id].ptr == NULL) {
+				fail++;
+				p->idle[p->nidle++] = id;
+				continue;
+			}
+			p->live[p->nlive++] = id;
+		} else {
+			k = rnd(p->nlive);
+			id = p->live[k];
+			p->live[k] = p->live[--p->nlive];
+			p->idle[p->nidle++] = id;
+			t0 = sim_ns();
+			if (slab)
+				malloc_slab_free(blk[id].ptr);
+			else
+				vPortFree(blk[id].ptr);
+			t1 = sim_ns();
+			blk[id].ptr = NULL;
+		}
+		if (i < 0)
+			continue;
+
+		lat[nlat++] = (uint32_t)(t1 - t0);
+		if ((i & 255) == 0) {
+			frag = sim_heap_frag(&largest);
+			frag_sum += frag;
+			samples++;
+			if (frag > frag_max)
+				frag_max = frag;
+			if (largest < largest_min)
+				largest_min = largest;
+		}
+	}
+
+	qsort(lat, nlat, sizeof(lat[0]), cmp_u32);
+	printf("%-12s %4u.%u%% %4u.%u%% %7zu %6u %6u %6u\n", name,
+	       frag_sum / samples / 10, frag_sum / samples % 10,
+	       frag_max / 10, frag_max % 10, largest_min,
+	       lat[nlat / 2], lat[nlat * 99 / 100], fail);
+	if (slab)
+		printf("%-12s %u requests spilled to the heap, arena full\n", "",
+		       g_slab_full_cnt);
+
+	for (id = 0; id < SIM_ID_MAX * 2; id++) {
+		if (blk[id].ptr == NULL)
+			continue;
+		if (slab)
+			malloc_slab_free(blk[id].ptr);
+		else
+			vPortFree(blk[id].ptr);
+	}
+	if (slab)
+		slab_heap_free(g_slab_arena);
+	SIM_CHECK(sim_heap_frag(&largest) == 0 && largest == xFreeBytesRemaining,
+	          "%s: heap not merged back, %zu of %zu", name, largest,
+	          xFreeBytesRemaining);
+}
+
+int main(int argc, char *argv[])
+{
+	int ops = (argc > 1) ? atoi(argv[1]) : SIM_OPS;
+
+	if (ops <= 0 || ops > SIM_OPS)
+		ops = SIM_OPS;
+
+	slab_check_classes();
+	slab_check_random();
+	slab_check_realloc();
+	slab_check_full();
+
+	printf("%u KB heap_4, %u KB arena, %u live blocks, %d operations\n",
+	       configTOTAL_HEAP_SIZE / 1024, MALLOC_SLAB_ARENA_SIZE / 1024,
+	       SIM_ID_MAX, ops);
+	printf("             frag avg  max  largest p50 ns p99 ns  fails\n");
+	sim_replay("heap_4", 0, ops);
+	sim_replay("heap_4+slab", 1, ops);
+
+	if (sim_errors) {
+		printf("%d errors\n", sim_errors);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,495 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Linux test and benchmark of the deferred stdout of stdio_defer.c, built
+ * with wrap_stdio.c against the stand-ins of port/ (POSIX threads for the
+ * drain thread, a memory buffer for the UART).
+ *
+ *   stdio_bench [messages per producer]
+ *
+ * Checks that deferred printf() writes the same text and returns the same
+ * length as vsnprintf() for the conversions the capture understands, that an
+ * overlong conversion does not shift the arguments after it, that long and
+ * dropped messages still return their length, that putchar() returns the
+ * character and that XR_DEBUG obeys the run-time level of a module. Then 1
+ * to 8 producer threads print concurrently into the ring, and the
+ * synchronous path under the stdout mutex for comparison; every producer's messages must come out whole and in order. The UART is a memory
+ * copy, so the times are the CPU cost of the two paths under contention, not
+ * the wait for the UART that the deferred path takes off the caller.
+ */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "kernel/os/os_thread.h"
+#include "sys/xr_debug.h"
+#include "../stdio_defer.h"
+
+#define BENCH_OUT_SIZE          (8 << 20)
+#define BENCH_PRODUCER_MAX      8
+#define BENCH_BURST             8       /* 8 producers' bursts fit the ring */
+#define BENCH_PAUSE_US          200
+
+int __wrap_printf(const char *format, ...);
+int __wrap_putchar(int c);
+
+static int sim_errors;
+
+#define SIM_CHECK(cond, fmt, arg...)                                    \
+	do {                                                            \
+		if (!(cond)) {                                          \
+			printf("FAIL %s:%d: " fmt "\n", __func__,       \
+			       __LINE__, ##arg);                        \
+			sim_errors++;                                   \
+		}                                                       \
+	} while (0)
+
+/* ------------------------------------------------------------------------ */
+/* host stand-ins                                                            */
+
+struct sim_thread_start {
+	OS_ThreadEntry_t entry;
+	void *arg;
+};
+
+static void *sim_thread_main(void *arg)
+{
+	struct sim_thread_start start = *(struct sim_thread_start *)arg;
+
+	free(arg);
+	start.entry(start.arg);
+	return NULL;
+}
+
+OS_Status OS_ThreadCreate(OS_Thread_t *thread, const char *name,
+                          OS_ThreadEntry_t entry, void *arg,
+                          int priority, uint32_t stackSize)
+{
+	struct sim_thread_start *start = malloc(sizeof(*start));
+
+	start->entry = entry;
+	start->arg = arg;
+	thread->valid = 1;
+	if (pthread_create(&thread->handle, NULL, sim_thread_main, start)) {
+		thread->valid = 0;
+		free(start);
+		return OS_FAIL;
+	}
+	pthread_detach(thread->handle);
+	return OS_OK;
+}
+
+/* only deleting itself */
+OS_Status OS_ThreadDelete(OS_Thread_t *thread)
+{
+	thread->valid = 0;
+	pthread_exit(NULL);
+}
+
+OS_Status OS_SemaphoreCreateBinary(OS_Semaphore_t *sem)
+{
+	return sem_init(&sem->sem, 0, 0) ? OS_FAIL : OS_OK;
+}
+
+OS_Status OS_SemaphoreDelete(OS_Semaphore_t *sem)
+{
+	return sem_destroy(&sem->sem) ? OS_FAIL : OS_OK;
+}
+
+OS_Status OS_SemaphoreWait(OS_Semaphore_t *sem, uint32_t waitMS)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec += waitMS / 1000;
+	ts.tv_nsec += (waitMS % 1000) * 1000000;
+	if (ts.tv_nsec >= 1000000000) {
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000;
+	}
+	return sem_timedwait(&sem->sem, &ts) ? OS_FAIL : OS_OK;
+}
+
+OS_Status OS_SemaphoreRelease(OS_Semaphore_t *sem)
+{
+	int value;
+
+	sem_getvalue(&sem->sem, &value);
+	if (value > 0)
+		return OS_OK; /* binary */
+	return sem_post(&sem->sem) ? OS_FAIL : OS_OK;
+}
+
+OS_Status OS_RecursiveMutexCreate(OS_Mutex_t *mutex)
+{
+	pthread_mutexattr_t attr;
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&mutex->mutex, &attr);
+	mutex->valid = 1;
+	return OS_OK;
+}
+
+OS_Status OS_RecursiveMutexLock(OS_Mutex_t *mutex, uint32_t waitMS)
+{
+	return pthread_mutex_lock(&mutex->mutex) ? OS_FAIL : OS_OK;
+}
+
+OS_Status OS_RecursiveMutexUnlock(OS_Mutex_t *mutex)
+{
+	return pthread_mutex_unlock(&mutex->mutex) ? OS_FAIL : OS_OK;
+}
+
+/* ------------------------------------------------------------------------ */
+/* the UART                                                                  */
+
+static char *out_buf;
+static size_t out_len;
+static pthread_mutex_t out_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t out_cond = PTHREAD_COND_INITIALIZER;
+static int out_blocked;
+
+static int sim_write(const char *buf, int len)
+{
+	pthread_mutex_lock(&out_lock);
+	while (out_blocked)
+		pthread_cond_wait(&out_cond, &out_lock);
+	if (out_len + len < BENCH_OUT_SIZE) {
+		memcpy(out_buf + out_len, buf, len);
+		out_len += len;
+		out_buf[out_len] = '\0';
+	}
+	pthread_mutex_unlock(&out_lock);
+	return len;
+}
+
+static void sim_out_reset(void)
+{
+	pthread_mutex_lock(&out_lock);
+	out_len = 0;
+	out_buf[0] = '\0';
+	pthread_mutex_unlock(&out_lock);
+}
+
+static void sim_out_block(int block)
+{
+	pthread_mutex_lock(&out_lock);
+	out_blocked = block;
+	pthread_cond_broadcast(&out_cond);
+	pthread_mutex_unlock(&out_lock);
+}
+
+static double sim_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* ------------------------------------------------------------------------ */
+/* formatting                                                                */
+
+/* printf() through the wrapper against snprintf() of the C library */
+#define FMT_CASE(deferred, fmt, arg...)                                 \
+	do {                                                            \
+		char exp_[1024];                                        \
+		stdio_defer_stats_t st0_, st1_;                         \
+		int e_, n_;                                             \
+		e_ = snprintf(exp_, sizeof(exp_), fmt, ##arg);          \
+		sim_out_reset();                                        \
+		stdio_defer_get_stats(&st0_);                           \
+		n_ = __wrap_printf(fmt, ##arg);                         \
+		stdio_defer_flush();                                    \
+		stdio_defer_get_stats(&st1_);                           \
+		SIM_CHECK(n_ == e_, "\"%s\" returned %d, expected %d",  \
+		          fmt, n_, e_);                                 \
+		SIM_CHECK(strcmp(out_buf, exp_) == 0,                   \
+		          "\"%s\" wrote \"%s\", expected \"%s\"",       \
+		          fmt, out_buf, exp_);                          \
+		SIM_CHECK((st1_.records - st0_.records) == (deferred),  \
+		          "\"%s\" not %s", fmt,                         \
+		          (deferred) ? "deferred" : "synchronous");     \
+	} while (0)
+
+static void bench_format(void)
+{
+	char fmt[64];
+	char line[400];
+	int n;
+
+	FMT_CASE(1, "plain text\n");
+	FMT_CASE(1, "%d %i %u %x %X %o|", -42, 17, 3000000000u, 0xbeef, 0xbeef, 8);
+	FMT_CASE(1, "[%5d][%-5d][%05d][%+d][% d][%+d]", 42, 42, 42, 42, 42, -42);
+	FMT_CASE(1, "[%.3d][%.0d][%.0d][%8.3d][%-8.3x]", 7, 0, 5, -7, 0xa);
+	FMT_CASE(1, "[%#x][%#X][%#x][%#o][%#o][%#.0o][%#5o]", 255, 255, 0, 8, 0, 0, 8);
+	FMT_CASE(1, "[%hhd][%hhu][%hd][%hu][%hhx]", 300, -1, 70000, -1, 0x1ff);
+	FMT_CASE(1, "[%ld][%lu][%lld][%llx][%zu][%zd][%td][%jd]", -5L, 6UL,
+	         -1234567890123LL, 0x123456789abcULL, (size_t)99, (ssize_t)-99,
+	         (ptrdiff_t)-3, (intmax_t)INT64_MIN);
+	FMT_CASE(1, "[%*d][%-*d][%*d][%.*d][%*.*d]", 6, 1, 6, 2, -6, 3, 4, 4, 7, 3, 5);
+	FMT_CASE(1, "[%c][%3c][%-3c]", 'a', 'b', 'c');
+	FMT_CASE(1, "[%s][%8s][%-8s][%.2s][%*.*s][%.*s]", "abc", "abc", "abc",
+	         "abc", 6, 1, "xyz", -1, "all");
+	FMT_CASE(1, "[%%][%5%]");
+	FMT_CASE(1, "[%p][%10p]", (void *)0x1234, (void *)&n);
+	FMT_CASE(1, "[%f][%.2f][%10.3e][%g]", 3.14159, -2.5, 12345.678, 0.0001);
+	FMT_CASE(1, "[%d%n][%s]", 12, &n, "after");
+
+	/* a format outside the read-only data is copied into the record */
+	strcpy(fmt, "copied %s %d\n");
+	FMT_CASE(1, fmt, "fmt", 5);
+
+	/* longer than the drain formats, written synchronously */
+	memset(line, 'x', sizeof(line) - 1);
+	line[sizeof(line) - 1] = '\0';
+	FMT_CASE(0, "%s|%d", line, 1);
+
+	/*
+	 * A conversion longer than DEFER_SPEC_MAX is printed as is, its
+	 * argument must still be consumed so the next ones stay in place.
+	 */
+	sim_out_reset();
+	n = __wrap_printf("%000000000000000000000000000008d|%s|%d|%llx\n",
+	                  99, "next", 77, 0xabcULL);
+	stdio_defer_flush();
+	strcpy(line, "%000000000000000000000000000008d|next|77|abc\n");
+	SIM_CHECK(strcmp(out_buf, line) == 0, "overlong spec wrote \"%s\"", out_buf);
+	SIM_CHECK(n == (int)strlen(line), "overlong spec returned %d", n);
+
+	sim_out_reset();
+	n = __wrap_printf("%-00000000000000000000000000000.3s|%s|%c\n",
+	                  "skipped", "next", 'z');
+	stdio_defer_flush();
+	strcpy(line, "%-00000000000000000000000000000.3s|next|z\n");
+	SIM_CHECK(strcmp(out_buf, line) == 0, "overlong %%s wrote \"%s\"", out_buf);
+	SIM_CHECK(n == (int)strlen(line), "overlong %%s returned %d", n);
+
+	/* putchar() returns the character as unsigned char */
+	sim_out_reset();
+	SIM_CHECK(__wrap_putchar('A') == 'A', "putchar('A')");
+	SIM_CHECK(__wrap_putchar(-23) == 0xE9, "putchar(-23)");
+	stdio_defer_flush();
+	SIM_CHECK(strcmp(out_buf, "A\xE9") == 0, "putchar wrote \"%s\"", out_buf);
+}
+
+/* A full ring drops the message, printf() still returns its length */
+static void bench_drop(void)
+{
+	stdio_defer_stats_t st0, st1;
+	int n = 0, i;
+
+	stdio_defer_get_stats(&st0);
+	sim_out_block(1);
+	for (i = 0; i < 10000; i++) {
+		n = __wrap_printf("fill %d %s\n", i, "abcdefghijklmnopqrstuvwxyz");
+		stdio_defer_get_stats(&st1);
+		if (st1.dropped != st0.dropped)
+			break;
+	}
+	SIM_CHECK(st1.dropped == st0.dropped + 1, "ring never filled");
+	SIM_CHECK(n == snprintf(NULL, 0, "fill %d %s\n", i, "abcdefghijklmnopqrstuvwxyz"),
+	          "dropped message returned %d", n);
+	sim_out_block(0);
+	stdio_defer_flush();
+	sim_out_reset();
+}
+
+/* XR_DEBUG of a module with an id obeys the run-time level of the id */
+#undef XR_DEBUG_PRINT
+#define XR_DEBUG_PRINT(msg, arg...) __wrap_printf(msg, ##arg)
+
+static void bench_level(void)
+{
+	int mod = DBG_ON | XR_LEVEL_INFO | XR_MOD_ID(5);
+	int other = DBG_ON | XR_LEVEL_INFO | XR_MOD_ID(6);
+
+	SIM_CHECK(stdio_defer_get_level(5) == XR_LEVEL_ALL, "initial level %d",
+	          stdio_defer_get_level(5));
+	SIM_CHECK(stdio_defer_set_level(0, XR_LEVEL_ERROR) != 0, "id 0 was set");
+	SIM_CHECK(stdio_defer_set_level(STDIO_DEFER_MOD_MAX, 0) != 0, "id out of range");
+
+	sim_out_reset();
+	XR_INFO(mod, NOEXPAND, "a%d ", 1);
+	XR_DEBUG(mod, NOEXPAND, "b%d ", 2);	/* above the mask level */
+	stdio_defer_set_level(5, XR_LEVEL_ERROR);
+	XR_INFO(mod, NOEXPAND, "c%d ", 3);
+	XR_ERROR(mod, NOEXPAND, "d%d ", 4);
+	XR_INFO(other, NOEXPAND, "e%d ", 5);
+	XR_INFO(DBG_ON | XR_LEVEL_INFO, NOEXPAND, "f%d", 6);
+	stdio_defer_set_level(5, XR_LEVEL_ALL);
+	stdio_defer_flush();
+	SIM_CHECK(strcmp(out_buf, "a1 d4 e5 f6") == 0, "levels wrote \"%s\"", out_buf);
+}
+
+/* ------------------------------------------------------------------------ */
+/* contention                                                                */
+
+struct producer {
+	pthread_t thread;
+	int id;
+	int count;
+	double secs;
+};
+
+static pthread_barrier_t prod_barrier;
+
+/* Bursts of messages with pauses the drain can catch up in, like logging */
+static void *producer_main(void *arg)
+{
+	struct producer *p = arg;
+	double start;
+	int i, j;
+
+	p->secs = 0;
+	pthread_barrier_wait(&prod_barrier);
+	for (i = 0; i < p->count; i += BENCH_BURST) {
+		start = sim_now();
+		for (j = i; j < i + BENCH_BURST && j < p->count; j++)
+			__wrap_printf("p%d %d %s\n", p->id, j, "payload");
+		p->secs += sim_now() - start;
+		usleep(BENCH_PAUSE_US);
+	}
+	return NULL;
+}
+
+/* Every line is whole and each producer's sequence only goes up */
+static int bench_check_lines(int producers, int count)
+{
+	int last[BENCH_PRODUCER_MAX];
+	char *line = out_buf;
+	char *end;
+	int lines = 0;
+	int id, seq;
+	char payload[16];
+
+	memset(last, -1, sizeof(last));
+	while ((end = strchr(line, '\n')) != NULL) {
+		*end = '\0';
+		if (sscanf(line, "p%d %d %15s", &id, &seq, payload) != 3 ||
+		    id < 0 || id >= producers || seq >= count ||
+		    strcmp(payload, "payload") != 0) {
+			SIM_CHECK(0, "broken line \"%s\"", line);
+			return lines;
+		}
+		SIM_CHECK(seq > last[id], "producer %d: %d after %d", id, seq, last[id]);
+		last[id] = seq;
+		lines++;
+		line = end + 1;
+	}
+	SIM_CHECK(*line == '\0', "trailing text \"%s\"", line);
+	return lines;
+}
+
+static void bench_contention(int producers, int count, int deferred)
+{
+	struct producer prod[BENCH_PRODUCER_MAX];
+	stdio_defer_stats_t st0, st1;
+	double secs = 0, start, wall;
+	uint32_t dropped;
+	int i, lines;
+
+	if (deferred)
+		stdio_defer_start(sim_write);
+	sim_out_reset();
+	stdio_defer_get_stats(&st0);
+
+	pthread_barrier_init(&prod_barrier, NULL, producers);
+	start = sim_now();
+	for (i = 0; i < producers; i++) {
+		prod[i].id = i;
+		prod[i].count = count;
+		pthread_create(&prod[i].thread, NULL, producer_main, &prod[i]);
+	}
+	for (i = 0; i < producers; i++) {
+		pthread_join(prod[i].thread, NULL);
+		secs += prod[i].secs;
+	}
+	wall = sim_now() - start;
+	pthread_barrier_destroy(&prod_barrier);
+
+	if (deferred)
+		stdio_defer_stop();
+	stdio_defer_get_stats(&st1);
+	dropped = st1.dropped - st0.dropped;
+
+	lines = bench_check_lines(producers, count);
+	SIM_CHECK(lines + dropped == (uint32_t)(producers * count),
+	          "%d lines + %u dropped of %d", lines, dropped, producers * count);
+	if (!deferred)
+		SIM_CHECK(dropped == 0 && st1.records == st0.records,
+		          "synchronous path went through the ring");
+	SIM_CHECK(st1.max_used <= 4096, "high water mark %u over the ring", st1.max_used);
+
+	printf("%-12s %d producers: %6.0f ns/printf, %5.1f%% dropped, %.2f s\n",
+	       deferred ? "deferred" : "synchronous", producers,
+	       secs * 1e9 / (producers * count),
+	       100.0 * dropped / (producers * count), wall);
+}
+
+int main(int argc, char *argv[])
+{
+	int count = (argc > 1) ? atoi(argv[1]) : 4000;
+	int producers;
+
+	out_buf = malloc(BENCH_OUT_SIZE);
+	out_buf[0] = '\0';
+	stdio_set_write(sim_write);
+
+	if (stdio_defer_start(sim_write) != 0) {
+		printf("FAIL stdio_defer_start\n");
+		return 1;
+	}
+	bench_format();
+	bench_drop();
+	bench_level();
+	stdio_defer_stop();
+
+	for (producers = 1; producers <= BENCH_PRODUCER_MAX; producers *= 2) {
+		bench_contention(producers, count, 1);
+		bench_contention(producers, count, 0);
+	}
+
+	free(out_buf);
+	if (sim_errors) {
+		printf("%d errors\n", sim_errors);
+		return 1;
+	}
+	return 0;
+}
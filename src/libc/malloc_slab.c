@@ -0,0 +1,364 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef __CONFIG_MALLOC_SLAB
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "kernel/os/os_thread.h"
+#include "malloc_slab.h"
+
+/*
+ * Size-class allocator for small blocks
+ *
+ * A fixed arena, taken from the heap at the first small allocation, is cut
+ * into pages. Each page in use serves one size class and keeps its own free
+ * list, so small short-lived blocks never split the heap. The page of a block
+ * is found from its address, no per-block header is needed. An empty page
+ * goes back to the arena and may serve another class later. Requests larger
+ * than the biggest class, or made while the arena is full, fall through to
+ * the heap.
+ */
+
+#ifndef MALLOC_SLAB_ARENA_SIZE
+#define MALLOC_SLAB_ARENA_SIZE	(16 * 1024)
+#endif
+#define MALLOC_SLAB_PAGE_SIZE	1024
+#define MALLOC_SLAB_PAGE_CNT	(MALLOC_SLAB_ARENA_SIZE / MALLOC_SLAB_PAGE_SIZE)
+#define MALLOC_SLAB_NONE		0xFF
+
+#if (MALLOC_SLAB_PAGE_CNT >= MALLOC_SLAB_NONE)
+#error "MALLOC_SLAB_ARENA_SIZE too large"
+#endif
+
+#define SLAB_SYSLOG				printf
+
+#ifdef __CONFIG_MALLOC_USE_STDLIB
+void *__real_malloc(size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+#define slab_heap_malloc(size)			__real_malloc(size)
+#define slab_heap_realloc(ptr, size)	__real_realloc(ptr, size)
+#define slab_heap_free(ptr)				__real_free(ptr)
+#else
+void *pvPortMalloc(size_t xWantedSize);
+void vPortFree(void *pv);
+
+#define slab_heap_malloc(size)			pvPortMalloc(size)
+#define slab_heap_realloc(ptr, size)	NULL	/* not supported by heap */
+#define slab_heap_free(ptr)				vPortFree(ptr)
+#endif
+
+static __inline void slab_lock(void)
+{
+	OS_ThreadSuspendScheduler();
+}
+
+static __inline void slab_unlock(void)
+{
+	OS_ThreadResumeScheduler();
+}
+
+static const uint16_t g_slab_size[] = { 16, 32, 48, 64, 96, 128, 192, 256 };
+#define MALLOC_SLAB_CLASS_CNT	(sizeof(g_slab_size) / sizeof(g_slab_size[0]))
+#define MALLOC_SLAB_MAX_SIZE	256
+
+/* size class of (size - 1) / 16, for size 1 ~ 256 */
+static const uint8_t g_slab_class[MALLOC_SLAB_MAX_SIZE / 16] = {
+	0, 1, 2, 3, 4, 4, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7
+};
+
+struct slab_page {
+	void *free;			/* free blocks of this page */
+	uint16_t carve;		/* offset of the first never used block */
+	uint16_t inuse;
+	uint8_t cls;
+	uint8_t prev;
+	uint8_t next;		/* partial list of the class, or free page list */
+};
+
+struct slab_class {
+	uint8_t partial;	/* first page with free blocks */
+	uint16_t pages;
+	uint32_t inuse;
+	uint32_t inuse_max;
+	uint32_t alloc_cnt;
+	uint32_t req_sum;	/* requested bytes, accumulated */
+};
+
+static uint8_t *g_slab_arena;
+static int8_t g_slab_state;		/* 0: not init, 1: ready, -1: no arena */
+static uint8_t g_slab_free_page;
+static uint16_t g_slab_free_page_cnt;
+static struct slab_page g_slab_page[MALLOC_SLAB_PAGE_CNT];
+static struct slab_class g_slab_class_info[MALLOC_SLAB_CLASS_CNT];
+static uint32_t g_slab_large_cnt;	/* too large, passed to heap */
+static uint32_t g_slab_full_cnt;	/* arena full, passed to heap */
+
+static int slab_init(void)
+{
+	int i;
+
+	g_slab_arena = slab_heap_malloc(MALLOC_SLAB_ARENA_SIZE);
+	if (g_slab_arena == NULL) {
+		g_slab_state = -1;
+		return -1;
+	}
+
+	for (i = 0; i < MALLOC_SLAB_PAGE_CNT; ++i) {
+		g_slab_page[i].cls = MALLOC_SLAB_NONE;
+		g_slab_page[i].next = (i + 1 < MALLOC_SLAB_PAGE_CNT) ? i + 1 : MALLOC_SLAB_NONE;
+	}
+	for (i = 0; i < MALLOC_SLAB_CLASS_CNT; ++i)
+		g_slab_class_info[i].partial = MALLOC_SLAB_NONE;
+	g_slab_free_page = 0;
+	g_slab_free_page_cnt = MALLOC_SLAB_PAGE_CNT;
+	g_slab_state = 1;
+	return 0;
+}
+
+static __inline int slab_page_of(void *ptr)
+{
+	uint32_t off = (uint8_t *)ptr - g_slab_arena;
+
+	if (g_slab_state <= 0 || (uint8_t *)ptr < g_slab_arena ||
+	    off >= MALLOC_SLAB_ARENA_SIZE)
+		return -1;
+	return off / MALLOC_SLAB_PAGE_SIZE;
+}
+
+static void slab_partial_del(struct slab_class *c, int idx)
+{
+	struct slab_page *pg = &g_slab_page[idx];
+
+	if (pg->prev != MALLOC_SLAB_NONE)
+		g_slab_page[pg->prev].next = pg->next;
+	else
+		c->partial = pg->next;
+	if (pg->next != MALLOC_SLAB_NONE)
+		g_slab_page[pg->next].prev = pg->prev;
+}
+
+static void slab_partial_add(struct slab_class *c, int idx)
+{
+	struct slab_page *pg = &g_slab_page[idx];
+
+	pg->prev = MALLOC_SLAB_NONE;
+	pg->next = c->partial;
+	if (c->partial != MALLOC_SLAB_NONE)
+		g_slab_page[c->partial].prev = idx;
+	c->partial = idx;
+}
+
+static void *slab_alloc(int cls)
+{
+	struct slab_class *c = &g_slab_class_info[cls];
+	struct slab_page *pg;
+	int idx = c->partial;
+	void *ptr;
+
+	if (idx == MALLOC_SLAB_NONE) {
+		idx = g_slab_free_page;
+		if (idx == MALLOC_SLAB_NONE)
+			return NULL;
+		pg = &g_slab_page[idx];
+		g_slab_free_page = pg->next;
+		g_slab_free_page_cnt--;
+		pg->free = NULL;
+		pg->carve = 0;
+		pg->inuse = 0;
+		pg->cls = cls;
+		c->pages++;
+		slab_partial_add(c, idx);
+	}
+
+	pg = &g_slab_page[idx];
+	if (pg->free != NULL) {
+		ptr = pg->free;
+		pg->free = *(void **)ptr;
+	} else {
+		ptr = g_slab_arena + idx * MALLOC_SLAB_PAGE_SIZE + pg->carve;
+		pg->carve += g_slab_size[cls];
+	}
+	pg->inuse++;
+
+	if (pg->free == NULL &&
+	    pg->carve + g_slab_size[cls] > MALLOC_SLAB_PAGE_SIZE)
+		slab_partial_del(c, idx); /* page full */
+
+	c->inuse++;
+	if (c->inuse > c->inuse_max)
+		c->inuse_max = c->inuse;
+	c->alloc_cnt++;
+	return ptr;
+}
+
+static void slab_free(int idx, void *ptr)
+{
+	struct slab_page *pg = &g_slab_page[idx];
+	struct slab_class *c = &g_slab_class_info[pg->cls];
+	int was_full;
+
+	was_full = (pg->free == NULL &&
+	            pg->carve + g_slab_size[pg->cls] > MALLOC_SLAB_PAGE_SIZE);
+
+	*(void **)ptr = pg->free;
+	pg->free = ptr;
+	pg->inuse--;
+	c->inuse--;
+
+	if (was_full)
+		slab_partial_add(c, idx);
+
+	/* give an empty page back, unless it is the only one of the class */
+	if (pg->inuse == 0 && (pg->prev != MALLOC_SLAB_NONE ||
+	                       pg->next != MALLOC_SLAB_NONE)) {
+		slab_partial_del(c, idx);
+		c->pages--;
+		pg->cls = MALLOC_SLAB_NONE;
+		pg->next = g_slab_free_page;
+		g_slab_free_page = idx;
+		g_slab_free_page_cnt++;
+	}
+}
+
+void *malloc_slab_alloc(size_t size)
+{
+	void *ptr = NULL;
+	int cls;
+
+	if (size == 0 || size > MALLOC_SLAB_MAX_SIZE) {
+		slab_lock();
+		g_slab_large_cnt++;
+		slab_unlock();
+		return slab_heap_malloc(size);
+	}
+
+	cls = g_slab_class[(size - 1) >> 4];
+
+	slab_lock();
+	if (g_slab_state > 0 || (g_slab_state == 0 && slab_init() == 0)) {
+		ptr = slab_alloc(cls);
+		if (ptr) {
+			g_slab_class_info[cls].req_sum += size;
+		} else {
+			g_slab_full_cnt++;
+		}
+	}
+	slab_unlock();
+
+	if (ptr == NULL)
+		ptr = slab_heap_malloc(size);
+	return ptr;
+}
+
+void malloc_slab_free(void *ptr)
+{
+	int idx;
+
+	if (ptr == NULL)
+		return;
+
+	slab_lock();
+	idx = slab_page_of(ptr);
+	if (idx >= 0)
+		slab_free(idx, ptr);
+	slab_unlock();
+
+	if (idx < 0)
+		slab_heap_free(ptr);
+}
+
+void *malloc_slab_realloc(void *ptr, size_t size)
+{
+	void *p;
+	size_t old;
+	int idx;
+
+	slab_lock();
+	idx = (ptr == NULL) ? -1 : slab_page_of(ptr);
+	old = (idx < 0) ? 0 : g_slab_size[g_slab_page[idx].cls];
+	slab_unlock();
+
+	if (idx < 0) {
+		if (ptr == NULL)
+			return malloc_slab_alloc(size);
+		return slab_heap_realloc(ptr, size);
+	}
+
+	if (size <= old && size > old / 2)
+		return ptr; /* still the best class */
+
+	p = malloc_slab_alloc(size);
+	if (p) {
+		memcpy(p, ptr, size < old ? size : old);
+		malloc_slab_free(ptr);
+	}
+	return p;
+}
+
+/* Return 1 if @ptr is a block of the arena */
+int malloc_slab_owns(void *ptr)
+{
+	return (slab_page_of(ptr) >= 0);
+}
+
+/* Show usage and fragmentation of the size classes */
+void malloc_slab_info(void)
+{
+	struct slab_class *c;
+	uint32_t used = 0;
+	uint32_t pages = 0;
+	int i;
+
+	slab_lock();
+	SLAB_SYSLOG("<<< malloc slab info >>>\n"
+	            "arena %p, %u pages of %u, free %u\n"
+	            "size pages inuse   max  blocks   allocs  avg req\n",
+	            g_slab_arena, MALLOC_SLAB_PAGE_CNT, MALLOC_SLAB_PAGE_SIZE,
+	            g_slab_free_page_cnt);
+	for (i = 0; i < MALLOC_SLAB_CLASS_CNT; ++i) {
+		c = &g_slab_class_info[i];
+		SLAB_SYSLOG("%4u %5u %5u %5u %7u %8u %8u\n",
+		            g_slab_size[i], c->pages, c->inuse, c->inuse_max,
+		            c->pages * (MALLOC_SLAB_PAGE_SIZE / g_slab_size[i]),
+		            c->alloc_cnt, c->alloc_cnt ? c->req_sum / c->alloc_cnt : 0);
+		used += c->inuse * g_slab_size[i];
+		pages += c->pages;
+	}
+	SLAB_SYSLOG("utilization %u/%u bytes of pages in use\n"
+	            "to heap: large %u, arena full %u\n",
+	            used, pages * MALLOC_SLAB_PAGE_SIZE,
+	            g_slab_large_cnt, g_slab_full_cnt);
+	slab_unlock();
+}
+
+#endif /* __CONFIG_MALLOC_SLAB */
@@ -0,0 +1,935 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if (defined(__CONFIG_LIBC_WRAP_STDIO) && defined(__CONFIG_LIBC_WRAP_STDIO_DEFER))
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "driver/chip/hal_cmsis.h"
+#include "driver/chip/hal_flashcache.h"
+#include "kernel/os/os_thread.h"
+#include "kernel/os/os_semaphore.h"
+#include "kernel/os/os_time.h"
+#include "stdio_defer.h"
+
+/*
+ * Deferred stdout
+ *
+ * printf() only parses the format string and copies the raw arguments into a
+ * lock-free byte ring, the text is generated and written to the UART by a low
+ * priority drain thread. A record is laid out as
+ *     [ defer_rec | args... ]
+ * where args are stored in the order of the conversions, each one as its C
+ * type after default argument promotion. "%s" arguments are copied inline,
+ * so the caller's buffer may be reused as soon as printf() returns. A format
+ * string in the read-only part of the image is kept by pointer, any other one
+ * is copied in front of the args.
+ *
+ * printf() returns the length of the text it will produce, like vsnprintf()
+ * would: integer, character and string conversions are measured while their
+ * arguments are captured, the rare floating point and pointer ones with a
+ * snprintf() of that conversion alone. Messages longer than DEFER_LINE_MAX
+ * are written synchronously instead of being cut by the drain.
+ *
+ * There is one ring per image. Each core of the chip runs its own image and
+ * stdout, so this already is a ring per core; a ring per thread would cost
+ * 4KB each for messages that are written out in order by one drain anyway.
+ * Producers only contend on the compare-and-swap of the head, see
+ * src/libc/bench for a measurement with concurrent producers.
+ */
+
+#define DEFER_RING_SIZE		4096	/* must be a power of 2 */
+#define DEFER_ARG_MAX		128	/* max argument bytes of one message */
+#define DEFER_OUT_SIZE		512	/* text buffer of the drain thread */
+#define DEFER_LINE_MAX		256	/* max text of one message */
+#define DEFER_SPEC_MAX		24	/* longer conversions are printed as is */
+#define DEFER_IDLE_MS		200
+
+#define DEFER_THREAD_STACK	(1536)
+#define DEFER_THREAD_PRIO	OS_PRIORITY_LOW
+
+#define DEFER_ALIGN		sizeof(void *)
+#define DEFER_ROUNDUP(n)	(((n) + DEFER_ALIGN - 1) & ~(DEFER_ALIGN - 1))
+#define DEFER_RING_MASK		(DEFER_RING_SIZE - 1)
+
+/* record state, a zeroed record is not committed yet */
+#define REC_FREE		0
+#define REC_READY		1
+#define REC_PAD			2
+
+#define REC_F_STRING		0x01	/* args are a plain string, no format */
+#define REC_F_FMT_COPY		0x02	/* format string copied in front of args */
+
+struct defer_rec {
+	uint16_t len;		/* bytes of the whole record, aligned */
+	uint8_t state;
+	uint8_t flags;
+	const char *fmt;
+	uint8_t arg[0];
+};
+
+#define REC_HDR_SIZE		offsetof(struct defer_rec, arg)
+
+enum defer_arg_type {
+	ARG_NONE = 0,		/* unknown conversion, print as is */
+	ARG_PERCENT,		/* "%%" */
+	ARG_INT,
+	ARG_LONG,
+	ARG_LLONG,
+	ARG_SIZE,
+	ARG_PTRDIFF,
+	ARG_INTMAX,
+	ARG_DOUBLE,
+	ARG_LDOUBLE,
+	ARG_PTR,
+	ARG_STR,
+	ARG_COUNT,		/* "%n", consumed but not written */
+};
+
+#define SPEC_F_PLUS		0x01
+#define SPEC_F_SPACE		0x02
+#define SPEC_F_ALT		0x04	/* '#' */
+
+struct defer_spec {
+	const char *start;	/* points to '%' */
+	uint8_t len;		/* length of the conversion specification */
+	uint8_t type;
+	uint8_t wstar;		/* width is '*' */
+	uint8_t pstar;		/* precision is '*' */
+	uint8_t flags;		/* SPEC_F_xxx */
+	char lmod;		/* length modifier, 'H' for "hh", 'q' for "ll" */
+	char conv;		/* conversion character */
+	int width;		/* literal width, 0 if not given */
+	int prec;		/* literal precision, -1 if not given */
+};
+
+extern const unsigned char __RAM_BASE[];	/* SRAM start address */
+extern const unsigned char __etext[];	/* end of code and read-only data in SRAM */
+
+static uint8_t s_ring[DEFER_RING_SIZE] __attribute__((aligned(8)));
+static uint32_t s_head;		/* reserved by producers, free running */
+static uint32_t s_tail;		/* consumed by the drain, free running */
+
+static stdio_write_fn s_defer_write;
+static volatile uint8_t s_defer_run;
+static uint8_t s_drain_idle;
+static OS_Thread_t s_defer_thread;
+static OS_Semaphore_t s_defer_sem;
+static char s_defer_out[DEFER_OUT_SIZE];
+
+static stdio_defer_stats_t s_defer_stats;
+
+/* XR_LEVEL_ALL for all, the module id 0 is never filtered */
+uint8_t stdio_defer_mod_level[STDIO_DEFER_MOD_MAX] = {
+	[0 ... STDIO_DEFER_MOD_MAX - 1] = 0x0F
+};
+
+static const char *defer_parse_spec(const char *p, struct defer_spec *sp)
+{
+	char lmod = 0;
+
+	sp->start = p++;
+	sp->wstar = 0;
+	sp->pstar = 0;
+	sp->flags = 0;
+	sp->width = 0;
+	sp->prec = -1;
+
+	while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0') {
+		if (*p == '+')
+			sp->flags |= SPEC_F_PLUS;
+		else if (*p == ' ')
+			sp->flags |= SPEC_F_SPACE;
+		else if (*p == '#')
+			sp->flags |= SPEC_F_ALT;
+		p++;
+	}
+
+	if (*p == '*') {
+		sp->wstar = 1;
+		p++;
+	} else {
+		while (*p >= '0' && *p <= '9')
+			sp->width = sp->width * 10 + (*p++ - '0');
+	}
+
+	if (*p == '.') {
+		p++;
+		if (*p == '*') {
+			sp->pstar = 1;
+			p++;
+		} else {
+			sp->prec = 0;
+			while (*p >= '0' && *p <= '9')
+				sp->prec = sp->prec * 10 + (*p++ - '0');
+		}
+	}
+
+	switch (*p) {
+	case 'h':
+		lmod = 'h';
+		if (*++p == 'h') {
+			lmod = 'H';
+			p++;
+		}
+		break;
+	case 'l':
+		lmod = 'l';
+		if (*++p == 'l') {
+			lmod = 'q';
+			p++;
+		}
+		break;
+	case 'q':
+	case 'L':
+	case 'z':
+	case 't':
+	case 'j':
+		lmod = *p++;
+		break;
+	}
+
+	switch (*p) {
+	case 'd':
+	case 'i':
+	case 'u':
+	case 'o':
+	case 'x':
+	case 'X':
+	case 'c':
+		if (lmod == 'l')
+			sp->type = ARG_LONG;
+		else if (lmod == 'q' || lmod == 'L')
+			sp->type = ARG_LLONG;
+		else if (lmod == 'z')
+			sp->type = ARG_SIZE;
+		else if (lmod == 't')
+			sp->type = ARG_PTRDIFF;
+		else if (lmod == 'j')
+			sp->type = ARG_INTMAX;
+		else
+			sp->type = ARG_INT;
+		break;
+	case 'f':
+	case 'F':
+	case 'e':
+	case 'E':
+	case 'g':
+	case 'G':
+	case 'a':
+	case 'A':
+		sp->type = (lmod == 'L') ? ARG_LDOUBLE : ARG_DOUBLE;
+		break;
+	case 'p':
+		sp->type = ARG_PTR;
+		break;
+	case 's':
+		sp->type = ARG_STR;
+		break;
+	case 'n':
+		sp->type = ARG_COUNT;
+		break;
+	case '%':
+		sp->type = ARG_PERCENT;
+		break;
+	default:
+		sp->type = ARG_NONE;
+		if (*p == '\0')
+			p--; /* keep the terminator for the caller */
+		break;
+	}
+
+	sp->lmod = lmod;
+	sp->conv = *p++;
+	sp->len = p - sp->start;
+	return p;
+}
+
+/* Text length of an integer or character conversion of @v */
+static int defer_int_len(const struct defer_spec *sp, intmax_t v,
+                         int width, int prec)
+{
+	int is_signed = (sp->conv == 'd' || sp->conv == 'i');
+	unsigned base = 10;
+	uintmax_t u;
+	int digits = 0;
+	int n;
+
+	if (sp->conv == 'c')
+		return (width > 1) ? width : 1;
+
+	if (sp->conv == 'o')
+		base = 8;
+	else if (sp->conv == 'x' || sp->conv == 'X')
+		base = 16;
+
+	/* the value as printf() sees it after the length modifier */
+	if (sp->lmod == 'H')
+		v = is_signed ? (intmax_t)(signed char)v : (intmax_t)(unsigned char)v;
+	else if (sp->lmod == 'h')
+		v = is_signed ? (intmax_t)(short)v : (intmax_t)(unsigned short)v;
+	u = (is_signed && v < 0) ? -(uintmax_t)v : (uintmax_t)v;
+
+	for (; u != 0; u /= base)
+		digits++;
+	if (digits == 0 && prec != 0)
+		digits = 1;
+
+	n = (prec > digits) ? prec : digits;
+	if (base == 8 && (sp->flags & SPEC_F_ALT) && (n == digits || n == 0) &&
+	    (v != 0 || n == 0))
+		n++; /* leading '0' */
+	else if (base == 16 && (sp->flags & SPEC_F_ALT) && v != 0)
+		n += 2; /* "0x" */
+	if (is_signed && (v < 0 || (sp->flags & (SPEC_F_PLUS | SPEC_F_SPACE))))
+		n++;
+
+	return (width > n) ? width : n;
+}
+
+#define DEFER_PUT(type, v)					\
+	do {							\
+		type v_ = (v);					\
+		if (pos + sizeof(type) > (size_t)size)		\
+			return -1;				\
+		memcpy(buf + pos, &v_, sizeof(type));		\
+		pos += sizeof(type);				\
+	} while (0)
+
+/* Unsigned conversions of a signed type keep the bits of the unsigned one */
+#define DEFER_PUT_INT(type, utype, v)				\
+	do {							\
+		type i_ = (v);					\
+		DEFER_PUT(type, i_);				\
+		if (sp.conv == 'd' || sp.conv == 'i')		\
+			n = defer_int_len(&sp, i_, width, prec);	\
+		else						\
+			n = defer_int_len(&sp, (utype)i_, width, prec); \
+	} while (0)
+
+/* Rare conversions are measured by the C library */
+#define DEFER_PUT_MEASURE(type, v)				\
+	do {							\
+		type m_ = (v);					\
+		DEFER_PUT(type, m_);				\
+		if (sp.len < DEFER_SPEC_MAX) {			\
+			memcpy(spec, sp.start, sp.len);		\
+			spec[sp.len] = '\0';			\
+			if (nstar == 2)				\
+				n = snprintf(NULL, 0, spec, star[0], star[1], m_); \
+			else if (nstar == 1)			\
+				n = snprintf(NULL, 0, spec, star[0], m_); \
+			else					\
+				n = snprintf(NULL, 0, spec, m_);	\
+		}						\
+	} while (0)
+
+/*
+ * Copy the arguments of @format into @buf and measure the text it produces.
+ * Return the bytes used or -1, the text length is stored in @text.
+ */
+static int defer_capture(uint8_t *buf, int size, const char *format, va_list ap,
+                         int *text)
+{
+	struct defer_spec sp;
+	const char *p = format;
+	const char *q;
+	const char *s;
+	char spec[DEFER_SPEC_MAX];
+	size_t pos = 0;
+	int star[2];
+	int nstar;
+	int width;
+	int prec;
+	int len = 0;
+	int n;
+
+	while ((q = strchr(p, '%')) != NULL) {
+		len += q - p;
+		p = defer_parse_spec(q, &sp);
+		width = sp.width;
+		prec = sp.prec;
+		nstar = 0;
+		if (sp.wstar) {
+			width = va_arg(ap, int);
+			star[nstar++] = width;
+			DEFER_PUT(int, width);
+			if (width < 0)
+				width = -width; /* left justified */
+		}
+		if (sp.pstar) {
+			prec = va_arg(ap, int);
+			star[nstar++] = prec;
+			DEFER_PUT(int, prec);
+			if (prec < 0)
+				prec = -1; /* as if omitted */
+		}
+
+		/* what defer_format() writes for conversions it cannot handle */
+		n = sp.len;
+
+		switch (sp.type) {
+		case ARG_INT:
+			DEFER_PUT_INT(int, unsigned int, va_arg(ap, int));
+			break;
+		case ARG_LONG:
+			DEFER_PUT_INT(long, unsigned long, va_arg(ap, long));
+			break;
+		case ARG_LLONG:
+			DEFER_PUT_INT(long long, unsigned long long, va_arg(ap, long long));
+			break;
+		case ARG_SIZE:
+			DEFER_PUT_INT(ptrdiff_t, size_t, va_arg(ap, ptrdiff_t));
+			break;
+		case ARG_PTRDIFF:
+			DEFER_PUT_INT(ptrdiff_t, size_t, va_arg(ap, ptrdiff_t));
+			break;
+		case ARG_INTMAX:
+			DEFER_PUT_INT(intmax_t, uintmax_t, va_arg(ap, intmax_t));
+			break;
+		case ARG_DOUBLE:
+			DEFER_PUT_MEASURE(double, va_arg(ap, double));
+			break;
+		case ARG_LDOUBLE:
+			DEFER_PUT_MEASURE(long double, va_arg(ap, long double));
+			break;
+		case ARG_PTR:
+			DEFER_PUT_MEASURE(void *, va_arg(ap, void *));
+			break;
+		case ARG_COUNT:
+			DEFER_PUT(void *, va_arg(ap, void *));
+			n = 0;
+			break;
+		case ARG_STR:
+			s = va_arg(ap, const char *);
+			if (s == NULL)
+				s = "(null)";
+			n = (prec >= 0) ? strnlen(s, prec) : strlen(s);
+			if (pos + n + 1 > (size_t)size)
+				return -1;
+			memcpy(buf + pos, s, n);
+			buf[pos + n] = '\0';
+			pos += n + 1;
+			if (width > n)
+				n = width;
+			break;
+		case ARG_PERCENT:
+			n = 1;
+			break;
+		default:
+			break;
+		}
+
+		/* the argument is kept, but the text is the spec itself */
+		if (sp.len >= DEFER_SPEC_MAX && sp.type != ARG_PERCENT)
+			n = sp.len;
+		if (n < 0)
+			return -1;
+		len += n;
+	}
+
+	*text = len + strlen(p);
+	return pos;
+}
+
+#undef DEFER_PUT_MEASURE
+#undef DEFER_PUT_INT
+#undef DEFER_PUT
+
+/* Step over the captured argument of @sp */
+static const uint8_t *defer_skip_arg(const struct defer_spec *sp, const uint8_t *a)
+{
+	switch (sp->type) {
+	case ARG_INT:
+		return a + sizeof(int);
+	case ARG_LONG:
+		return a + sizeof(long);
+	case ARG_LLONG:
+		return a + sizeof(long long);
+	case ARG_SIZE:
+		return a + sizeof(size_t);
+	case ARG_PTRDIFF:
+		return a + sizeof(ptrdiff_t);
+	case ARG_INTMAX:
+		return a + sizeof(intmax_t);
+	case ARG_DOUBLE:
+		return a + sizeof(double);
+	case ARG_LDOUBLE:
+		return a + sizeof(long double);
+	case ARG_PTR:
+	case ARG_COUNT:
+		return a + sizeof(void *);
+	case ARG_STR:
+		return a + strlen((const char *)a) + 1;
+	default:
+		return a;
+	}
+}
+
+#define DEFER_GET(type, v)					\
+	do {							\
+		memcpy(&(v), a, sizeof(type));			\
+		a += sizeof(type);				\
+	} while (0)
+
+#define DEFER_SNPRINTF(v)						\
+	do {								\
+		if (nstar == 2)						\
+			n = snprintf(o, room, spec, star[0], star[1], v); \
+		else if (nstar == 1)					\
+			n = snprintf(o, room, spec, star[0], v);	\
+		else							\
+			n = snprintf(o, room, spec, v);			\
+	} while (0)
+
+#define DEFER_FORMAT(type)					\
+	do {							\
+		type v_;					\
+		DEFER_GET(type, v_);				\
+		DEFER_SNPRINTF(v_);				\
+	} while (0)
+
+/* Generate the text of @fmt with args @a into @out, return its length */
+static int defer_format(const char *fmt, const uint8_t *a, char *out, int size)
+{
+	struct defer_spec sp;
+	const char *p = fmt;
+	const char *q;
+	const char *s;
+	char spec[DEFER_SPEC_MAX];
+	char *o;
+	int star[2];
+	int nstar;
+	int pos = 0;
+	int room;
+	int n;
+
+	while (*p != '\0' && pos < size - 1) {
+		q = strchr(p, '%');
+		n = (q != NULL) ? (q - p) : (int)strlen(p);
+		if (n > size - 1 - pos)
+			n = size - 1 - pos;
+		memcpy(out + pos, p, n);
+		pos += n;
+		if (q == NULL || pos >= size - 1)
+			break;
+
+		p = defer_parse_spec(q, &sp);
+		o = out + pos;
+		room = size - pos;
+		n = 0;
+
+		nstar = 0;
+		if (sp.wstar)
+			DEFER_GET(int, star[nstar++]);
+		if (sp.pstar)
+			DEFER_GET(int, star[nstar++]);
+
+		if (sp.len >= sizeof(spec) ||
+		    sp.type == ARG_NONE || sp.type == ARG_PERCENT) {
+			/* printed as is, its argument still has to be consumed */
+			a = defer_skip_arg(&sp, a);
+			n = (sp.type == ARG_PERCENT) ? 1 : sp.len;
+			if (n > room - 1)
+				n = room - 1;
+			memcpy(o, (sp.type == ARG_PERCENT) ? "%" : sp.start, n);
+			pos += n;
+			continue;
+		}
+		memcpy(spec, sp.start, sp.len);
+		spec[sp.len] = '\0';
+
+		switch (sp.type) {
+		case ARG_INT:
+			DEFER_FORMAT(int);
+			break;
+		case ARG_LONG:
+			DEFER_FORMAT(long);
+			break;
+		case ARG_LLONG:
+			DEFER_FORMAT(long long);
+			break;
+		case ARG_SIZE:
+			DEFER_FORMAT(size_t);
+			break;
+		case ARG_PTRDIFF:
+			DEFER_FORMAT(ptrdiff_t);
+			break;
+		case ARG_INTMAX:
+			DEFER_FORMAT(intmax_t);
+			break;
+		case ARG_DOUBLE:
+			DEFER_FORMAT(double);
+			break;
+		case ARG_LDOUBLE:
+			DEFER_FORMAT(long double);
+			break;
+		case ARG_PTR:
+			DEFER_FORMAT(void *);
+			break;
+		case ARG_STR:
+			s = (const char *)a;
+			a += strlen(s) + 1;
+			DEFER_SNPRINTF(s);
+			break;
+		case ARG_COUNT:
+			a += sizeof(void *); /* the target may be gone */
+			break;
+		default:
+			break;
+		}
+
+		if (n < 0)
+			n = 0;
+		pos += (n < room) ? n : (room - 1);
+	}
+
+	out[pos] = '\0';
+	return pos;
+}
+
+#undef DEFER_FORMAT
+#undef DEFER_SNPRINTF
+#undef DEFER_GET
+
+static struct defer_rec *defer_reserve(uint32_t len)
+{
+	struct defer_rec *pad;
+	uint32_t head, tail, off, need, used, max;
+
+	do {
+		head = __atomic_load_n(&s_head, __ATOMIC_RELAXED);
+		tail = __atomic_load_n(&s_tail, __ATOMIC_ACQUIRE);
+		off = head & DEFER_RING_MASK;
+		need = len;
+		if (off + len > DEFER_RING_SIZE)
+			need += DEFER_RING_SIZE - off; /* skip the end of ring */
+		used = head - tail;
+		if (used + need > DEFER_RING_SIZE)
+			return NULL;
+	} while (!__atomic_compare_exchange_n(&s_head, &head, head + need, 1,
+	                                      __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+	used += need;
+	max = __atomic_load_n(&s_defer_stats.max_used, __ATOMIC_RELAXED);
+	while (used > max &&
+	       !__atomic_compare_exchange_n(&s_defer_stats.max_used, &max, used, 1,
+	                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		;
+
+	if (need != len) {
+		pad = (struct defer_rec *)&s_ring[off];
+		pad->len = DEFER_RING_SIZE - off;
+		__atomic_store_n(&pad->state, REC_PAD, __ATOMIC_RELEASE);
+		off = 0;
+	}
+	return (struct defer_rec *)&s_ring[off];
+}
+
+static void defer_commit(struct defer_rec *rec)
+{
+	__atomic_store_n(&rec->state, REC_READY, __ATOMIC_RELEASE);
+	__atomic_add_fetch(&s_defer_stats.records, 1, __ATOMIC_RELAXED);
+
+	if (__atomic_exchange_n(&s_drain_idle, 0, __ATOMIC_ACQ_REL))
+		OS_SemaphoreRelease(&s_defer_sem);
+}
+
+static __inline int defer_fmt_is_const(const char *fmt)
+{
+	return ((fmt >= (const char *)__RAM_BASE && fmt < (const char *)__etext) ||
+	        (uintptr_t)fmt >= FLASH_ROM_START_ADDR);
+}
+
+/* Return 0 when queued or dropped, -1 if the caller has to write it */
+static int defer_queue(const char *fmt, uint8_t flags, const uint8_t *arg, int len)
+{
+	struct defer_rec *rec;
+	uint32_t flen = 0;
+	uint32_t size;
+
+	if (fmt != NULL && !defer_fmt_is_const(fmt)) {
+		flen = strlen(fmt) + 1;
+		flags |= REC_F_FMT_COPY;
+	}
+	size = DEFER_ROUNDUP(REC_HDR_SIZE + flen + len);
+	if (size > DEFER_RING_SIZE / 4) {
+		__atomic_add_fetch(&s_defer_stats.sync, 1, __ATOMIC_RELAXED);
+		return -1;
+	}
+
+	rec = defer_reserve(size);
+	if (rec == NULL) {
+		__atomic_add_fetch(&s_defer_stats.dropped, 1, __ATOMIC_RELAXED);
+		return 0;
+	}
+
+	rec->len = size;
+	rec->flags = flags;
+	rec->fmt = fmt;
+	if (flen > 0)
+		memcpy(rec->arg, fmt, flen);
+	memcpy(rec->arg + flen, arg, len);
+	defer_commit(rec);
+	return 0;
+}
+
+/* Writing is allowed from ISR, but not with IRQ disabled or before scheduling */
+static int defer_is_usable(void)
+{
+	return (s_defer_run &&
+	        !__get_PRIMASK() &&
+	        !__get_FAULTMASK() &&
+	        OS_ThreadIsSchedulerRunning());
+}
+
+static __inline int defer_is_sync_context(void)
+{
+	return (__get_PRIMASK() ||
+	        __get_FAULTMASK() ||
+	        __get_IPSR() ||
+	        !OS_ThreadIsSchedulerRunning());
+}
+
+int stdio_defer_vprintf(const char *format, va_list ap)
+{
+	uint8_t arg[DEFER_ARG_MAX];
+	int text;
+	int len;
+
+	if (!defer_is_usable())
+		return -1;
+
+	len = defer_capture(arg, sizeof(arg), format, ap, &text);
+	if (len < 0 || text >= DEFER_LINE_MAX) {
+		__atomic_add_fetch(&s_defer_stats.sync, 1, __ATOMIC_RELAXED);
+		return -1;
+	}
+
+	/* a dropped message still reports its length, like a lost UART byte */
+	return (defer_queue(format, 0, arg, len) == 0) ? text : -1;
+}
+
+int stdio_defer_puts(const char *s, int newline)
+{
+	uint8_t arg[DEFER_ARG_MAX];
+	size_t len;
+
+	if (!defer_is_usable())
+		return -1;
+
+	len = strlen(s);
+	if (len + newline + 1 > sizeof(arg)) {
+		__atomic_add_fetch(&s_defer_stats.sync, 1, __ATOMIC_RELAXED);
+		return -1;
+	}
+
+	memcpy(arg, s, len);
+	if (newline)
+		arg[len++] = '\n';
+	arg[len] = '\0';
+
+	if (defer_queue(NULL, REC_F_STRING, arg, len + 1) != 0)
+		return -1;
+	return len;
+}
+
+/* Write out committed records, stdout mutex held */
+static void defer_drain(void)
+{
+	struct defer_rec *rec;
+	uint32_t tail, len;
+	uint8_t state;
+	int out = 0;
+	int n;
+
+	tail = __atomic_load_n(&s_tail, __ATOMIC_RELAXED);
+	while (tail != __atomic_load_n(&s_head, __ATOMIC_ACQUIRE)) {
+		rec = (struct defer_rec *)&s_ring[tail & DEFER_RING_MASK];
+		state = __atomic_load_n(&rec->state, __ATOMIC_ACQUIRE);
+		if (state == REC_FREE)
+			break; /* reserved but not committed yet */
+
+		len = rec->len;
+		if (state == REC_READY) {
+			if (out > DEFER_OUT_SIZE - DEFER_LINE_MAX) {
+				s_defer_write(s_defer_out, out);
+				out = 0;
+			}
+			if (rec->flags & REC_F_STRING) {
+				n = strlen((const char *)rec->arg);
+				if (n > DEFER_OUT_SIZE - out)
+					n = DEFER_OUT_SIZE - out;
+				memcpy(s_defer_out + out, rec->arg, n);
+			} else if (rec->flags & REC_F_FMT_COPY) {
+				n = strlen((const char *)rec->arg) + 1;
+				n = defer_format((const char *)rec->arg, rec->arg + n,
+				                 s_defer_out + out, DEFER_LINE_MAX);
+			} else {
+				n = defer_format(rec->fmt, rec->arg,
+				                 s_defer_out + out, DEFER_LINE_MAX);
+			}
+			out += n;
+		}
+
+		/* a zeroed region is never taken as a committed record */
+		memset(rec, 0, len);
+		tail += len;
+		__atomic_store_n(&s_tail, tail, __ATOMIC_RELEASE);
+	}
+
+	if (out > 0)
+		s_defer_write(s_defer_out, out);
+}
+
+static int defer_is_pending(void)
+{
+	struct defer_rec *rec;
+	uint32_t tail = __atomic_load_n(&s_tail, __ATOMIC_RELAXED);
+
+	if (tail == __atomic_load_n(&s_head, __ATOMIC_ACQUIRE))
+		return 0;
+
+	rec = (struct defer_rec *)&s_ring[tail & DEFER_RING_MASK];
+	return (__atomic_load_n(&rec->state, __ATOMIC_ACQUIRE) != REC_FREE);
+}
+
+static void defer_task(void *arg)
+{
+	while (s_defer_run) {
+		stdout_mutex_lock();
+		defer_drain();
+		stdout_mutex_unlock();
+
+		__atomic_store_n(&s_drain_idle, 1, __ATOMIC_RELEASE);
+		if (!defer_is_pending())
+			OS_SemaphoreWait(&s_defer_sem, DEFER_IDLE_MS);
+		__atomic_store_n(&s_drain_idle, 0, __ATOMIC_RELEASE);
+	}
+
+	stdout_mutex_lock();
+	defer_drain();
+	stdout_mutex_unlock();
+
+	OS_ThreadDelete(&s_defer_thread);
+}
+
+void stdio_defer_sync(void)
+{
+	if (s_defer_write != NULL && !defer_is_sync_context())
+		defer_drain();
+}
+
+/**
+ * @brief Start writing stdout messages from the drain thread
+ * @param[in] fn Write function used by the drain thread, it may block
+ * @retval 0 on success, -1 on failure
+ */
+int stdio_defer_start(stdio_write_fn fn)
+{
+	if (s_defer_run)
+		return 0;
+
+	if (OS_SemaphoreCreateBinary(&s_defer_sem) != OS_OK)
+		return -1;
+
+	stdout_mutex_lock();
+	s_defer_write = fn;
+	s_defer_run = 1;
+	stdout_mutex_unlock();
+
+	if (OS_ThreadCreate(&s_defer_thread,
+	                    "stdio_defer",
+	                    defer_task,
+	                    NULL,
+	                    DEFER_THREAD_PRIO,
+	                    DEFER_THREAD_STACK) != OS_OK) {
+		s_defer_run = 0;
+		s_defer_write = NULL;
+		OS_SemaphoreDelete(&s_defer_sem);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief Stop the drain thread, queued messages are written out first
+ * @return None
+ */
+void stdio_defer_stop(void)
+{
+	if (!s_defer_run)
+		return;
+
+	s_defer_run = 0;
+	OS_SemaphoreRelease(&s_defer_sem);
+	while (OS_ThreadIsValid(&s_defer_thread))
+		OS_MSleep(10);
+
+	s_defer_write = NULL;
+	OS_SemaphoreDelete(&s_defer_sem);
+}
+
+/**
+ * @brief Write out all queued messages in the caller's context
+ * @return None
+ */
+void stdio_defer_flush(void)
+{
+	stdout_mutex_lock();
+	stdio_defer_sync();
+	stdout_mutex_unlock();
+}
+
+void stdio_defer_get_stats(stdio_defer_stats_t *stats)
+{
+	memcpy(stats, &s_defer_stats, sizeof(*stats));
+}
+
+int stdio_defer_set_level(unsigned int id, int level)
+{
+	if (id == 0 || id >= STDIO_DEFER_MOD_MAX || level < 0 || level > 0x0F)
+		return -1;
+
+	stdio_defer_mod_level[id] = level;
+	return 0;
+}
+
+int stdio_defer_get_level(unsigned int id)
+{
+	if (id >= STDIO_DEFER_MOD_MAX)
+		return -1;
+
+	return stdio_defer_mod_level[id];
+}
+
+#endif /* (defined(__CONFIG_LIBC_WRAP_STDIO) && defined(__CONFIG_LIBC_WRAP_STDIO_DEFER)) */
@@ -30,6 +30,7 @@
 #include <sys/reent.h>
 #include <stdint.h>
 #include <stddef.h>
+#include "malloc_slab.h"
 
 #ifdef __CONFIG_MALLOC_USE_STDLIB
 
@@ -54,6 +55,16 @@ void *__real__malloc_r(struct _reent *reent, size_t size);
 void *__real__realloc_r(struct _reent *reent, void *ptr, size_t size);
 void __real__free_r(struct _reent *reent, void *ptr);
 
+#ifdef __CONFIG_MALLOC_SLAB
+#define heap_real_malloc(size)			malloc_slab_alloc(size)
+#define heap_real_realloc(ptr, size)	malloc_slab_realloc(ptr, size)
+#define heap_real_free(ptr)				malloc_slab_free(ptr)
+#else
+#define heap_real_malloc(size)			__real_malloc(size)
+#define heap_real_realloc(ptr, size)	__real_realloc(ptr, size)
+#define heap_real_free(ptr)				__real_free(ptr)
+#endif
+
 #define WRAP_MALLOC_MEM_TRACE	defined(__CONFIG_MALLOC_TRACE)
 
 #if WRAP_MALLOC_MEM_TRACE
@@ -65,9 +76,44 @@ void __real__free_r(struct _reent *reent, void *ptr);
 #define HEAP_MEM_ERR_ON 		1
 
 #define HEAP_MEM_DBG_MIN_SIZE	100
-#define HEAP_MEM_MAX_CNT		1024
 #define HEAP_SYSLOG 			printf
 
+/*
+ * Live allocations are kept in an open addressing hash table keyed by
+ * pointer (linear probing, backward shift deletion), so tracing costs a
+ * few probes per call instead of a scan of the whole table.
+ * The table is filled to 7/8 at most to keep the probe runs short: the
+ * default 1024 entries (12 KB) trace up to 896 live allocations, where the
+ * linear table traced 1024 in 8 KB. Define HEAP_MEM_HASH_BITS to 11 for up
+ * to 1792 live allocations in 24 KB.
+ */
+#ifndef HEAP_MEM_HASH_BITS
+#define HEAP_MEM_HASH_BITS		10
+#endif
+#define HEAP_MEM_MAX_CNT		(1 << HEAP_MEM_HASH_BITS)
+#define HEAP_MEM_MAX_LOAD		(HEAP_MEM_MAX_CNT * 7 / 8)
+#define HEAP_MEM_MASK			(HEAP_MEM_MAX_CNT - 1)
+
+/*
+ * Allocations are also summed up by caller (return address) and by thread.
+ * malloc() carries no subsystem tag, so these two stand in for a per
+ * subsystem account: most subsystems run in threads of their own, and the
+ * caller table splits the shared ones. The slot of a deleted thread is
+ * released once its last allocation is freed, see wrap_malloc_thread_delete().
+ */
+#define HEAP_CALLER_HASH_BITS	7
+#define HEAP_CALLER_MAX_CNT		(1 << HEAP_CALLER_HASH_BITS)
+#define HEAP_CALLER_OTHER		HEAP_CALLER_MAX_CNT	/* caller table full */
+#define HEAP_OWNER_MAX_CNT		16
+#define HEAP_OWNER_OTHER		(HEAP_OWNER_MAX_CNT - 1)	/* owner table full */
+#define HEAP_OWNER_FREE			0
+#define HEAP_OWNER_LIVE			1
+#define HEAP_OWNER_DELETED		2	/* thread gone, allocations left */
+#define HEAP_SEQ_MASK			0xFFFFFF
+
+#define HEAP_PTR_HASH(p, bits)	\
+	((((uint32_t)(uintptr_t)(p) >> 2) * 2654435761U) >> (32 - (bits)))
+
 #define HEAP_MEM_IS_TRACED(size)	(size > HEAP_MEM_DBG_MIN_SIZE)
 
 #define HEAP_MEM_LOG(flags, fmt, arg...)	\
@@ -85,14 +131,35 @@ void __real__free_r(struct _reent *reent, void *ptr);
 
 struct heap_mem {
 	void *ptr;
-	size_t size;
+	uint32_t size   : 24;
+	uint32_t owner  : 8;
+	uint32_t seq    : 24;	/* allocation sequence, for leak check */
+	uint32_t caller : 8;
+};
+
+struct heap_caller {
+	void *ra;
+	uint32_t sum;
+	uint32_t sum_max;
+	uint32_t cnt;
+};
+
+struct heap_owner {
+	OS_ThreadHandle_t handle;
+	char name[configMAX_TASK_NAME_LEN];
+	uint8_t state;
+	uint32_t sum;
+	uint32_t sum_max;
+	uint32_t cnt;
 };
 
 static struct heap_mem g_mem[HEAP_MEM_MAX_CNT];
+static struct heap_caller g_mem_caller[HEAP_CALLER_MAX_CNT + 1];
+static struct heap_owner g_mem_owner[HEAP_OWNER_MAX_CNT];
 
 static int g_mem_entry_cnt = 0;
 static int g_mem_entry_cnt_max = 0;
-static int g_mem_empty_idx = 0; // beginning idx to do the search for new one
+static uint32_t g_mem_seq = 0;
 
 static size_t g_mem_sum = 0;
 static size_t g_mem_sum_max = 0;
@@ -102,8 +169,173 @@ static const char g_mem_magic[WRAP_MEM_MAGIC_LEN] = {0x4a, 0x5b, 0x6c, 0x7f};
 #define WRAP_MEM_SET_MAGIC(p, l)	memcpy((((char *)(p)) + (l)), g_mem_magic, 4)
 #define WRAP_MEM_CHK_MAGIC(p, l)	memcmp((((char *)(p)) + (l)), g_mem_magic, 4)
 
+static int heap_mem_find(void *ptr)
+{
+	uint32_t i = HEAP_PTR_HASH(ptr, HEAP_MEM_HASH_BITS);
+
+	while (g_mem[i].ptr != NULL) {
+		if (g_mem[i].ptr == ptr)
+			return i;
+		i = (i + 1) & HEAP_MEM_MASK;
+	}
+	return -1;
+}
+
+static uint32_t heap_mem_new(void *ptr)
+{
+	uint32_t i = HEAP_PTR_HASH(ptr, HEAP_MEM_HASH_BITS);
+
+	while (g_mem[i].ptr != NULL)
+		i = (i + 1) & HEAP_MEM_MASK;
+	g_mem[i].ptr = ptr;
+	return i;
+}
+
+static void heap_mem_del(uint32_t i)
+{
+	uint32_t j = i;
+	uint32_t k;
+
+	/* move back following entries which would not be found any more */
+	for (;;) {
+		j = (j + 1) & HEAP_MEM_MASK;
+		if (g_mem[j].ptr == NULL)
+			break;
+		k = HEAP_PTR_HASH(g_mem[j].ptr, HEAP_MEM_HASH_BITS);
+		if (((j - k) & HEAP_MEM_MASK) >= ((j - i) & HEAP_MEM_MASK)) {
+			g_mem[i] = g_mem[j];
+			i = j;
+		}
+	}
+	g_mem[i].ptr = NULL;
+}
+
+static int heap_caller_get(void *ra)
+{
+	uint32_t i = HEAP_PTR_HASH(ra, HEAP_CALLER_HASH_BITS);
+	uint32_t n;
+
+	for (n = 0; n < HEAP_CALLER_MAX_CNT; ++n) {
+		if (g_mem_caller[i].ra == ra)
+			return i;
+		if (g_mem_caller[i].ra == NULL) {
+			g_mem_caller[i].ra = ra;
+			return i;
+		}
+		i = (i + 1) & (HEAP_CALLER_MAX_CNT - 1);
+	}
+	return HEAP_CALLER_OTHER;
+}
+
+static int heap_owner_get(void)
+{
+	OS_ThreadHandle_t handle = NULL;
+	int i;
+
+	/* scheduler is suspended by malloc_mutex_lock() */
+	if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+		handle = OS_ThreadGetCurrentHandle();
+
+	for (i = 0; i < HEAP_OWNER_OTHER; ++i) {
+		if (g_mem_owner[i].state == HEAP_OWNER_LIVE &&
+		    g_mem_owner[i].handle == handle)
+			return i;
+	}
+	for (i = 0; i < HEAP_OWNER_OTHER; ++i) {
+		if (g_mem_owner[i].state == HEAP_OWNER_FREE)
+			break;
+	}
+	if (i == HEAP_OWNER_OTHER)
+		return HEAP_OWNER_OTHER;
+
+	g_mem_owner[i].handle = handle;
+	g_mem_owner[i].state = HEAP_OWNER_LIVE;
+	strncpy(g_mem_owner[i].name, handle ? pcTaskGetTaskName(handle) : "-",
+	        sizeof(g_mem_owner[i].name) - 1);
+	return i;
+}
+
+static void heap_owner_release(struct heap_owner *o)
+{
+	memset(o, 0, sizeof(*o));
+}
+
+/*
+ * Called by the kernel when a thread is deleted (traceTASK_DELETE), with
+ * interrupts disabled. The slot is released now if the thread holds no
+ * allocation, or by the free of its last one, so that a new thread never
+ * inherits the sums of a deleted one with the same handle.
+ */
+void wrap_malloc_thread_delete(void *handle)
+{
+	struct heap_owner *o;
+	int i;
+
+	for (i = 0; i < HEAP_OWNER_OTHER; ++i) {
+		o = &g_mem_owner[i];
+		if (o->state != HEAP_OWNER_LIVE || o->handle != handle)
+			continue;
+		if (o->cnt == 0)
+			heap_owner_release(o);
+		else
+			o->state = HEAP_OWNER_DELETED;
+		break;
+	}
+}
+
+static void heap_mem_account(struct heap_mem *m, int add)
+{
+	struct heap_caller *c = &g_mem_caller[m->caller];
+	struct heap_owner *o = &g_mem_owner[m->owner];
+
+	if (add) {
+		g_mem_sum += m->size;
+		c->sum += m->size;
+		c->cnt++;
+		o->sum += m->size;
+		o->cnt++;
+		if (g_mem_sum > g_mem_sum_max)
+			g_mem_sum_max = g_mem_sum;
+		if (c->sum > c->sum_max)
+			c->sum_max = c->sum;
+		if (o->sum > o->sum_max)
+			o->sum_max = o->sum;
+	} else {
+		g_mem_sum -= m->size;
+		c->sum -= m->size;
+		c->cnt--;
+		o->sum -= m->size;
+		o->cnt--;
+		if (o->cnt == 0 && o->state == HEAP_OWNER_DELETED)
+			heap_owner_release(o);
+	}
+}
+
+static void heap_mem_add(void *ptr, size_t size, void *ra)
+{
+	struct heap_mem *m;
+
+	if (g_mem_entry_cnt >= HEAP_MEM_MAX_LOAD) {
+		HEAP_MEM_ERR("heap memory count exceed %d\n", HEAP_MEM_MAX_LOAD);
+		return;
+	}
+
+	m = &g_mem[heap_mem_new(ptr)];
+	m->size = size;
+	m->seq = ++g_mem_seq;
+	m->caller = heap_caller_get(ra);
+	m->owner = heap_owner_get();
+	heap_mem_account(m, 1);
+
+	g_mem_entry_cnt++;
+	if (g_mem_entry_cnt > g_mem_entry_cnt_max)
+		g_mem_entry_cnt_max = g_mem_entry_cnt;
+}
+
 uint32_t wrap_malloc_heap_info(int verbose)
 {
+	int i, j = 0;
+
 	malloc_mutex_lock();
 	HEAP_SYSLOG("<<< malloc heap info >>>\n"
 		    "g_mem_sum       %u (%u KB)\n"
@@ -113,12 +345,34 @@ uint32_t wrap_malloc_heap_info(int verbose)
 		    g_mem_sum_max, g_mem_sum_max / 1024,
 		    g_mem_entry_cnt, g_mem_entry_cnt_max);
 
-	int i, j = 0;
+	HEAP_SYSLOG("<<< by thread: name, cnt, sum, max (* deleted) >>>\n");
+	for (i = 0; i < HEAP_OWNER_MAX_CNT; ++i) {
+		if (g_mem_owner[i].sum_max != 0) {
+			HEAP_SYSLOG("%-16s%c%4u %7u %7u\n",
+				    i == HEAP_OWNER_OTHER ? "(other)" : g_mem_owner[i].name,
+				    g_mem_owner[i].state == HEAP_OWNER_DELETED ? '*' : ' ',
+				    g_mem_owner[i].cnt, g_mem_owner[i].sum,
+				    g_mem_owner[i].sum_max);
+		}
+	}
+
+	if (verbose) {
+		HEAP_SYSLOG("<<< by caller: addr, cnt, sum, max >>>\n");
+		for (i = 0; i <= HEAP_CALLER_MAX_CNT; ++i) {
+			if (g_mem_caller[i].cnt != 0) {
+				HEAP_SYSLOG("%p %4u %7u %7u\n",
+					    g_mem_caller[i].ra, g_mem_caller[i].cnt,
+					    g_mem_caller[i].sum, g_mem_caller[i].sum_max);
+			}
+		}
+	}
+
 	for (i = 0; i < HEAP_MEM_MAX_CNT; ++i) {
 		if (g_mem[i].ptr != 0) {
 			if (verbose) {
-				HEAP_SYSLOG("%03d. %03d, %p, %u\n",
-					    ++j, i, g_mem[i].ptr, g_mem[i].size);
+				HEAP_SYSLOG("%03d. %04d, %p, %u, %p\n",
+					    ++j, i, g_mem[i].ptr, g_mem[i].size,
+					    g_mem_caller[g_mem[i].caller].ra);
 			}
 
 			if (WRAP_MEM_CHK_MAGIC(g_mem[i].ptr, g_mem[i].size)) {
@@ -131,36 +385,51 @@ uint32_t wrap_malloc_heap_info(int verbose)
 	return ret;
 }
 
-void *__wrap_malloc(size_t size)
+/* Return a mark for wrap_malloc_heap_leak() */
+uint32_t wrap_malloc_heap_mark(void)
+{
+	return g_mem_seq & HEAP_SEQ_MASK;
+}
+
+/* Show allocations made after @mark and not freed yet, return their sum */
+uint32_t wrap_malloc_heap_leak(uint32_t mark)
+{
+	uint32_t sum = 0;
+	uint32_t age, d;
+	int i, j = 0;
+
+	malloc_mutex_lock();
+	age = (g_mem_seq - mark) & HEAP_SEQ_MASK;
+	HEAP_SYSLOG("<<< malloc heap leak since %u >>>\n", mark);
+	for (i = 0; i < HEAP_MEM_MAX_CNT; ++i) {
+		if (g_mem[i].ptr == 0)
+			continue;
+		d = (g_mem[i].seq - mark) & HEAP_SEQ_MASK;
+		if (d == 0 || d > age)
+			continue; /* allocated before the mark */
+		HEAP_SYSLOG("%03d. %p, %u, seq %u, %p, %s\n",
+			    ++j, g_mem[i].ptr, g_mem[i].size, g_mem[i].seq,
+			    g_mem_caller[g_mem[i].caller].ra,
+			    g_mem[i].owner == HEAP_OWNER_OTHER ? "(other)" :
+			    g_mem_owner[g_mem[i].owner].name);
+		sum += g_mem[i].size;
+	}
+	HEAP_SYSLOG("%d entries, %u bytes\n", j, sum);
+	malloc_mutex_unlock();
+	return sum;
+}
+
+static void *heap_malloc(size_t size, void *ra)
 {
 	malloc_mutex_lock();
-	void *ptr = __real_malloc(size + WRAP_MEM_MAGIC_LEN);
+	void *ptr = heap_real_malloc(size + WRAP_MEM_MAGIC_LEN);
 
 	if (ptr) {
 		WRAP_MEM_SET_MAGIC(ptr, size);
 		if (HEAP_MEM_IS_TRACED(size)) {
 			HEAP_MEM_DBG("m (%p, %u)\n", ptr, size);
 		}
-		int i;
-		for (i = g_mem_empty_idx; i < HEAP_MEM_MAX_CNT; ++i) {
-			if (g_mem[i].ptr == 0) {
-				/* add new entry */
-				g_mem[i].ptr = ptr;
-				g_mem[i].size = size;
-				g_mem_entry_cnt++;
-				g_mem_empty_idx = i + 1;
-				g_mem_sum += size;
-				if (g_mem_sum > g_mem_sum_max)
-					g_mem_sum_max = g_mem_sum;
-				if (g_mem_entry_cnt > g_mem_entry_cnt_max)
-					g_mem_entry_cnt_max = g_mem_entry_cnt;
-				break;
-			}
-		}
-		if (i >= HEAP_MEM_MAX_CNT) {
-			HEAP_MEM_ERR("heap memory count exceed %d\n",
-				     HEAP_MEM_MAX_CNT);
-		}
+		heap_mem_add(ptr, size, ra);
 	} else {
 		HEAP_MEM_ERR("heap memory exhausted!\n");
 	}
@@ -169,40 +438,48 @@ void *__wrap_malloc(size_t size)
 	return ptr;
 }
 
+void *__wrap_malloc(size_t size)
+{
+	return heap_malloc(size, __builtin_return_address(0));
+}
+
 void *__wrap_realloc(void *ptr, size_t size)
 {
+	struct heap_mem *m;
+	int i = -1;
+
 	malloc_mutex_lock();
-	void *p = __real_realloc(ptr, size + WRAP_MEM_MAGIC_LEN);
+	if (ptr) {
+		i = heap_mem_find(ptr);
+		if (i < 0) {
+			HEAP_MEM_ERR("heap memory entry (%p) missed\n", ptr);
+		}
+	}
+	void *p = heap_real_realloc(ptr, size + WRAP_MEM_MAGIC_LEN);
 
 	if (p) {
 		WRAP_MEM_SET_MAGIC(p, size);
-		int i;
-		for (i = 0; i < HEAP_MEM_MAX_CNT; ++i) {
-			if (g_mem[i].ptr != ptr)
-				continue;
-
+		if (i >= 0) {
 			/* update the old entry */
+			m = &g_mem[i];
 			if (HEAP_MEM_IS_TRACED(size)) {
 				HEAP_MEM_DBG("r (%p, %u) <- (%p, %u)\n",
-					     p, size,
-					     g_mem[i].ptr, g_mem[i].size);
+					     p, size, m->ptr, m->size);
 			}
-			g_mem_sum -= g_mem[i].size;
-			g_mem[i].ptr = p;
-			g_mem[i].size = size;
-			g_mem_sum += size;
-			if (g_mem_sum > g_mem_sum_max)
-				g_mem_sum_max = g_mem_sum;
-			if (ptr == NULL) {
-				g_mem_entry_cnt++;
-				g_mem_empty_idx = i + 1;
-				if (g_mem_entry_cnt > g_mem_entry_cnt_max)
-					g_mem_entry_cnt_max = g_mem_entry_cnt;
+			heap_mem_account(m, 0);
+			if (p != ptr) {
+				struct heap_mem old = *m;
+
+				heap_mem_del(i);
+				i = heap_mem_new(p);
+				old.ptr = p;
+				g_mem[i] = old;
+				m = &g_mem[i];
 			}
-			break;
-		}
-		if (i >= HEAP_MEM_MAX_CNT) {
-			HEAP_MEM_ERR("heap memory entry (%p) missed\n", p);
+			m->size = size;
+			heap_mem_account(m, 1);
+		} else {
+			heap_mem_add(p, size, __builtin_return_address(0));
 		}
 	} else {
 		HEAP_MEM_ERR("heap memory exhausted!\n");
@@ -214,41 +491,36 @@ void *__wrap_realloc(void *ptr, size_t size)
 
 void __wrap_free(void *ptr)
 {
+	struct heap_mem *m;
+	int i;
+
 	malloc_mutex_lock();
 	if (ptr) {
-		int i;
-		for (i = 0; i < HEAP_MEM_MAX_CNT; ++i) {
-			if (g_mem[i].ptr != ptr)
-				continue;
-
+		i = heap_mem_find(ptr);
+		if (i >= 0) {
 			/* delete the old entry */
-			if (HEAP_MEM_IS_TRACED(g_mem[i].size)) {
-				HEAP_MEM_DBG("f (%p, %u)\n",
-					     g_mem[i].ptr, g_mem[i].size);
+			m = &g_mem[i];
+			if (HEAP_MEM_IS_TRACED(m->size)) {
+				HEAP_MEM_DBG("f (%p, %u)\n", m->ptr, m->size);
 			}
-			if (WRAP_MEM_CHK_MAGIC(g_mem[i].ptr, g_mem[i].size)) {
+			if (WRAP_MEM_CHK_MAGIC(m->ptr, m->size)) {
 				HEAP_MEM_ERR("memory f (%p) corrupt\n", ptr);
 			}
-			g_mem_sum -= g_mem[i].size;
-			g_mem[i].ptr = 0;
-			g_mem[i].size = 0;
+			heap_mem_account(m, 0);
+			heap_mem_del(i);
 			g_mem_entry_cnt--;
-			if (i < g_mem_empty_idx)
-				g_mem_empty_idx = i;
-			break;
-		}
-		if (i >= HEAP_MEM_MAX_CNT) {
+		} else {
 			HEAP_MEM_ERR("heap memory entry (%p) missed\n", ptr);
 		}
 	}
 
-	__real_free(ptr);
+	heap_real_free(ptr);
 	malloc_mutex_unlock();
 }
 
 void *__wrap_calloc(size_t cnt, size_t size)
 {
-	void *ptr = malloc(cnt * size);
+	void *ptr = heap_malloc(cnt * size, __builtin_return_address(0));
 	if (ptr) {
 		memset(ptr, 0, cnt * size);
 	}
@@ -262,7 +534,7 @@ char *__wrap_strdup(const char *s)
 	if (s == NULL)
 		return NULL;
 	len = strlen(s);
-	res = malloc(len + 1);
+	res = heap_malloc(len + 1, __builtin_return_address(0));
 	if (res)
 		memcpy(res, s, len + 1);
 	return res;
@@ -275,7 +547,7 @@ void *__wrap_malloc(size_t size)
 	void *ret;
 
 	malloc_mutex_lock();
-	ret = __real_malloc(size);
+	ret = heap_real_malloc(size);
 	malloc_mutex_unlock();
 
 	return ret;
@@ -286,7 +558,7 @@ void *__wrap_realloc(void *ptr, size_t size)
 	void *ret;
 
 	malloc_mutex_lock();
-	ret = __real_realloc(ptr, size);
+	ret = heap_real_realloc(ptr, size);
 	malloc_mutex_unlock();
 
 	return ret;
@@ -295,7 +567,7 @@ void *__wrap_realloc(void *ptr, size_t size)
 void __wrap_free(void *ptr)
 {
 	malloc_mutex_lock();
-	__real_free(ptr);
+	heap_real_free(ptr);
 	malloc_mutex_unlock();
 }
 
@@ -317,6 +589,11 @@ void *__wrap__realloc_r(struct _reent *reent, void *ptr, size_t size)
 	void *ret;
 
 	malloc_mutex_lock();
+#ifdef __CONFIG_MALLOC_SLAB
+	if (malloc_slab_owns(ptr))
+		ret = malloc_slab_realloc(ptr, size);
+	else
+#endif
 	ret = __real__realloc_r(reent, ptr, size);
 	malloc_mutex_unlock();
 
@@ -326,6 +603,11 @@ void *__wrap__realloc_r(struct _reent *reent, void *ptr, size_t size)
 void __wrap__free_r(struct _reent *reent, void *ptr)
 {
 	malloc_mutex_lock();
+#ifdef __CONFIG_MALLOC_SLAB
+	if (malloc_slab_owns(ptr))
+		malloc_slab_free(ptr);
+	else
+#endif
 	__real__free_r(reent, ptr);
 	malloc_mutex_unlock();
 }
@@ -335,38 +617,46 @@ void __wrap__free_r(struct _reent *reent, void *ptr)
 void *pvPortMalloc( size_t xWantedSize );
 void vPortFree( void *pv );
 
+#ifdef __CONFIG_MALLOC_SLAB
+#define heap_real_malloc(size)	malloc_slab_alloc(size)
+#define heap_real_free(ptr)		malloc_slab_free(ptr)
+#else
+#define heap_real_malloc(size)	pvPortMalloc(size)
+#define heap_real_free(ptr)		vPortFree(ptr)
+#endif
+
 void *__wrap_malloc(size_t size)
 {
-	return pvPortMalloc(size);
+	return heap_real_malloc(size);
 }
 
 void *__wrap_realloc(void *ptr, size_t size)
 {
 #error "realloc() not support"
-	vPortFree(ptr);
-	return pvPortMalloc(size);
+	heap_real_free(ptr);
+	return heap_real_malloc(size);
 }
 
 void __wrap_free(void *ptr)
 {
-	vPortFree(ptr);
+	heap_real_free(ptr);
 }
 
 void *__wrap__malloc_r(struct _reent *reent, size_t size)
 {
-	return pvPortMalloc(size);
+	return heap_real_malloc(size);
 }
 
 void *__wrap__realloc_r(struct _reent *reent, void *ptr, size_t size)
 {
 #error "realloc() not support"
-	vPortFree(ptr);
-	return pvPortMalloc(size);
+	heap_real_free(ptr);
+	return heap_real_malloc(size);
 }
 
 void __wrap__free_r(struct _reent *reent, void *ptr)
 {
-	vPortFree(ptr);
+	heap_real_free(ptr);
 }
 
 #endif /* __CONFIG_MALLOC_USE_STDLIB */
@@ -34,6 +34,7 @@
 #include <string.h>
 #include "driver/chip/hal_cmsis.h"
 #include "kernel/os/os_mutex.h"
+#include "stdio_defer.h"
 
 #define WRAP_STDOUT_BUF_SIZE	1024
 
@@ -87,6 +88,13 @@ void stdio_set_write(stdio_write_fn fn)
 	stdout_mutex_unlock();
 }
 
+#ifdef __CONFIG_LIBC_WRAP_STDIO_DEFER
+/* keep the order with messages still queued for the drain thread */
+#define STDIO_DEFER_SYNC()	stdio_defer_sync()
+#else
+#define STDIO_DEFER_SYNC()	do { } while (0)
+#endif
+
 static __inline int stdio_wrap_write(char *buf, int len, int max)
 {
 #ifndef __CONFIG_LIBC_PRINTF_FLOAT
@@ -110,11 +118,20 @@ int __wrap_printf(const char *format, ...)
 	int len;
 	va_list ap;
 
+#ifdef __CONFIG_LIBC_WRAP_STDIO_DEFER
+	va_start(ap, format);
+	len = stdio_defer_vprintf(format, ap);
+	va_end(ap);
+	if (len >= 0)
+		return len;
+#endif
+
 	stdout_mutex_lock();
 
 	if (s_stdio_write == NULL) {
 		len = 0;
 	} else {
+		STDIO_DEFER_SYNC();
 		va_start(ap, format);
 		len = vsnprintf(s_stdout_buf, WRAP_STDOUT_BUF_SIZE, format, ap);
 		va_end(ap);
@@ -130,11 +147,22 @@ int __wrap_vprintf(const char *format, va_list ap)
 {
 	int len;
 
+#ifdef __CONFIG_LIBC_WRAP_STDIO_DEFER
+	va_list aq;
+
+	va_copy(aq, ap);
+	len = stdio_defer_vprintf(format, aq);
+	va_end(aq);
+	if (len >= 0)
+		return len;
+#endif
+
 	stdout_mutex_lock();
 
 	if (s_stdio_write == NULL) {
 		len = 0;
 	} else {
+		STDIO_DEFER_SYNC();
 		len = vsnprintf(s_stdout_buf, WRAP_STDOUT_BUF_SIZE, format, ap);
 		len = stdio_wrap_write(s_stdout_buf, len, WRAP_STDOUT_BUF_SIZE - 1);
 	}
@@ -148,11 +176,18 @@ int __wrap_puts(const char *s)
 {
 	int len;
 
+#ifdef __CONFIG_LIBC_WRAP_STDIO_DEFER
+	len = stdio_defer_puts(s, 1);
+	if (len >= 0)
+		return len;
+#endif
+
 	stdout_mutex_lock();
 
 	if (s_stdio_write == NULL) {
 		len = 0;
 	} else {
+		STDIO_DEFER_SYNC();
 		len = s_stdio_write(s, strlen(s));
 		len += s_stdio_write("\n", 1);
 	}
@@ -170,11 +205,20 @@ int __wrap_fprintf(FILE *stream, const char *format, ...)
 	if (stream != stdout && stream != stderr)
 		return 0;
 
+#ifdef __CONFIG_LIBC_WRAP_STDIO_DEFER
+	va_start(ap, format);
+	len = stdio_defer_vprintf(format, ap);
+	va_end(ap);
+	if (len >= 0)
+		return len;
+#endif
+
 	stdout_mutex_lock();
 
 	if (s_stdio_write == NULL) {
 		len = 0;
 	} else {
+		STDIO_DEFER_SYNC();
 		va_start(ap, format);
 		len = vsnprintf(s_stdout_buf, WRAP_STDOUT_BUF_SIZE, format, ap);
 		va_end(ap);
@@ -208,13 +252,21 @@ int __wrap_putchar(int c)
 	int len;
 	char cc;
 
+#ifdef __CONFIG_LIBC_WRAP_STDIO_DEFER
+	char str[2] = { c, '\0' };
+
+	if (c != '\0' && stdio_defer_puts(str, 0) >= 0)
+		return (unsigned char)c;
+#endif
+
 	stdout_mutex_lock();
 
 	if (s_stdio_write == NULL) {
-		len = 0;
+		len = EOF;
 	} else {
+		STDIO_DEFER_SYNC();
 		cc = c;
-		len = s_stdio_write(&cc, 1);
+		len = (s_stdio_write(&cc, 1) == 1) ? (unsigned char)c : EOF;
 	}
 
 	stdout_mutex_unlock();
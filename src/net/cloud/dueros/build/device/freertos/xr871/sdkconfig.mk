@@ -30,6 +30,18 @@ CFLAGS += -std=gnu99
 # open this if want to use the AES-CBC encrypted communication
 #COM_DEFS += NET_TRANS_ENCRYPTED_BY_AES_CBC
 
+# open this if want to upload voice as binary speex frames, see lightduer_voice.c
+#COM_DEFS += DUER_VOICE_BINARY_UPLOAD
+
+# voice segments waiting for upload, each one takes about 1 KB with the
+# binary upload and 600 bytes without it
+#COM_DEFS += DUER_VOICE_RING_SLOTS=16
+
+# speex is built fixed-point with the Cortex-M4 DSP kernels, open these for
+# the floating-point variant or the plain C fixed-point kernels
+#SPEEX_FLOATING_POINT=y
+#SPEEX_DSP=n
+
 #=====start modules select=======#
 modules_module_System_Info=y
 modules_module_Device_Info=y
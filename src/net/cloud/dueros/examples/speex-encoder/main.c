@@ -22,6 +22,7 @@
 #include <string.h>
 #include <getopt.h>
 #include <libgen.h>
+#include <time.h>
 
 #include "lightduer_types.h"
 #include "lightduer_speex.h"
@@ -209,6 +210,9 @@ int pcm2spx(const char *pcm, const char *spx) {
     int frame_size = 0;
     char frame[1024];
     duer_speex_handler speex = NULL;
+    int frames = 0;
+    clock_t cost = 0;
+    clock_t start;
 
     f_in = fopen(pcm, "rb");
     if (f_in == NULL) {
@@ -257,12 +261,24 @@ int pcm2spx(const char *pcm, const char *spx) {
         DEBUG("The read size = %u", rs);
 
         if (rs > 0) {
+            start = clock();
             duer_speex_encode(speex, frame, rs, speex_encode_callback);
+            cost += clock() - start;
+            frames++;
         }
     } while (rs > 0);
 
     duer_speex_destroy(speex);
 
+    if (frames > 0) {
+        // each frame holds 20ms of audio
+        PRINT("Encoded %d frames in %ld ms, %ld us/frame, %.1fx realtime\n",
+              frames,
+              (long)(cost * 1000 / CLOCKS_PER_SEC),
+              (long)(cost * 1000000 / CLOCKS_PER_SEC / frames),
+              cost > 0 ? frames * 0.02 * CLOCKS_PER_SEC / cost : 0.0);
+    }
+
 exit:
 
     g_file_out = NULL;
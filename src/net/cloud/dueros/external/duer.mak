@@ -115,7 +115,14 @@ LOCAL_INCLUDES := \
     $(MODULE_PATH)-port
 
 LOCAL_CDEFS := HAVE_CONFIG_H
+ifeq ($(SPEEX_FLOATING_POINT),y)
+LOCAL_CDEFS += FLOATING_POINT
+else
 LOCAL_CDEFS += FIXED_POINT
+endif
+ifeq ($(SPEEX_DSP),n)
+LOCAL_CDEFS += DISABLE_SPEEX_DSP
+endif
 
 include $(BUILD_STATIC_LIB)
 
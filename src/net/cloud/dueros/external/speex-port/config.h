@@ -37,11 +37,17 @@
 /* Debug fixed-point implementation */
 /* #undef FIXED_DEBUG */
 
-/* Compile as fixed-point */
-/* #undef FIXED_POINT */
+/* Compile as fixed-point, unless the floating-point variant is selected
+   (SPEEX_FLOATING_POINT=y in the device config) */
+#if !defined(FIXED_POINT) && !defined(FLOATING_POINT)
+#define FIXED_POINT /**/
+#endif
 
-/* Compile as floating-point */
-#define FLOATING_POINT /**/
+/* Use the Cortex-M4 DSP kernels for the fixed-point build,
+   see fixed_armv7em.h. Define DISABLE_SPEEX_DSP for the plain C kernels. */
+#if defined(FIXED_POINT) && defined(__ARM_ARCH_7EM__) && !defined(DISABLE_SPEEX_DSP)
+#define ARMV7EM_ASM /**/
+#endif
 
 /* Define to 1 if you have the <alloca.h> header file. */
 #define HAVE_ALLOCA_H 1
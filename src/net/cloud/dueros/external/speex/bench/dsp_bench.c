@@ -0,0 +1,571 @@
+/* Copyright (C) 2017 Baidu Inc. */
+/**
+   @file dsp_bench.c
+   @brief Host check of the ARMv7E-M speex kernels
+*/
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   - Neither the name of the Xiph.org Foundation nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * dsp_bench OUT [repeat]
+ *
+ * run.sh builds this file with libspeex twice: with ARMV7EM_ASM, so the
+ * *_armv7em.h kernels are used with SMLAD and SMLAWB done in C, and with
+ * the generic C kernels. Both builds write the same report to OUT:
+ *
+ * - inner_prod, vq_nbest, vq_nbest_sign, _spx_autocorr and the
+ *   MULT16_32_Q15/Q11 and MAC forms, on random and edge-case vectors,
+ * - the encoded bitstream of a synthetic corpus, narrowband and wideband.
+ *
+ * The reports have to be identical. The ARMV7EM_ASM build also checks the
+ * C SMLAD and SMLAWB against a model of the instructions taken from the
+ * ARMv7-M Architecture Reference Manual, so the kernels are checked with
+ * the semantics they have on the Cortex-M4. The encode time per frame is
+ * printed for each build; it is host time, not Cortex-M4 cycles.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+#include "config.h"
+#include "arch.h"
+#include "ltp.h"
+#include "vq.h"
+#include "lpc.h"
+#include "speex/speex.h"
+
+#ifdef ARMV7EM_ASM
+#define BUILD_NAME "armv7em"
+#else
+#define BUILD_NAME "generic"
+#endif
+
+#define BENCH_CHECK(cond, fmt, ...)                                           \
+    do {                                                                      \
+        if (!(cond)) {                                                        \
+            printf("FAIL %s:%d: " fmt "\n", __FILE__, __LINE__, ##__VA_ARGS__); \
+            s_errors++;                                                       \
+        }                                                                     \
+    } while (0)
+
+static int s_errors;
+static FILE *s_out;
+static uint32_t s_seed;
+
+/* speex-port/config.c logs through lightduer, the bench just uses libc */
+void *speex_alloc(int size) { return calloc(size, 1); }
+void *speex_alloc_scratch(int size) { return calloc(size, 1); }
+void *speex_realloc(void *ptr, int size) { return realloc(ptr, size); }
+void speex_free(void *ptr) { free(ptr); }
+void speex_free_scratch(void *ptr) { free(ptr); }
+void speex_error(const char *str) { fprintf(stderr, "speex error: %s\n", str); }
+void speex_warning(const char *str) { (void)str; }
+void speex_warning_int(const char *str, int val) { (void)str; (void)val; }
+void speex_notify(const char *str) { (void)str; }
+
+static uint32_t rnd(void)
+{
+    s_seed ^= s_seed << 13;
+    s_seed ^= s_seed >> 17;
+    s_seed ^= s_seed << 5;
+    return s_seed;
+}
+
+static spx_word16_t rnd16(void)
+{
+    /* a quarter of the samples at the ends of the range */
+    switch (rnd() & 7) {
+    case 0: return -32768;
+    case 1: return 32767;
+    default: return (spx_word16_t)rnd();
+    }
+}
+
+/* random value in [-limit, limit) */
+static spx_word32_t rnd_range(spx_word32_t limit)
+{
+    return (spx_word32_t)(rnd() % (2 * (uint32_t)limit)) - limit;
+}
+
+/* FNV-1a over everything a case produced */
+typedef struct {
+    uint32_t h;
+    int n;
+} digest_t;
+
+static void digest_init(digest_t *d)
+{
+    d->h = 2166136261u;
+    d->n = 0;
+}
+
+static void digest_add(digest_t *d, const void *data, size_t len)
+{
+    const unsigned char *p = data;
+
+    while (len--) {
+        d->h = (d->h ^ *p++) * 16777619u;
+    }
+    d->n++;
+}
+
+static void report(const char *name, const digest_t *d)
+{
+    fprintf(s_out, "%-28s n=%-6d %08x\n", name, d->n, d->h);
+}
+
+#ifdef ARMV7EM_ASM
+/*
+ * The instructions as the ARMv7-M ARM gives them, on 32-bit registers:
+ *
+ * SMLAD:  result = SInt(Rn<15:0>)*SInt(Rm<15:0>)
+ *                + SInt(Rn<31:16>)*SInt(Rm<31:16>) + SInt(Ra);  Rd = result<31:0>
+ * SMLAWB: result = SInt(Rn)*SInt(Rm<15:0>) + (SInt(Ra) << 16);   Rd = result<47:16>
+ */
+static uint32_t model_smlad(uint32_t rn, uint32_t rm, uint32_t ra)
+{
+    int64_t result = (int64_t)(int16_t)(rn & 0xffff) * (int16_t)(rm & 0xffff)
+                   + (int64_t)(int16_t)(rn >> 16) * (int16_t)(rm >> 16)
+                   + (int32_t)ra;
+
+    return (uint32_t)result;
+}
+
+static uint32_t model_smlawb(uint32_t rn, uint32_t rm, uint32_t ra)
+{
+    int64_t result = (int64_t)(int32_t)rn * (int16_t)(rm & 0xffff)
+                   + (int64_t)(int32_t)ra * 65536;
+
+    return (uint32_t)((uint64_t)result >> 16);
+}
+
+static void check_intrinsics(int count)
+{
+    static const uint32_t edges[] = {
+        0x00000000, 0x00000001, 0x0000ffff, 0x00007fff, 0x00008000,
+        0x7fff7fff, 0x80008000, 0x80007fff, 0x7fff8000, 0xffffffff,
+        0x7fffffff, 0x80000000, 0x12345678, 0xfedcba98,
+    };
+    const int n_edges = sizeof(edges) / sizeof(edges[0]);
+    int i, j, k, fails = 0;
+
+    for (i = 0; i < n_edges; i++) {
+        for (j = 0; j < n_edges; j++) {
+            for (k = 0; k < n_edges; k++) {
+                uint32_t x = edges[i], y = edges[j], a = edges[k];
+
+                if ((uint32_t)SMLAD(x, y, a) != model_smlad(x, y, a) && fails++ < 5)
+                    BENCH_CHECK(0, "SMLAD(%08x, %08x, %08x) = %08x, instruction gives %08x",
+                                x, y, a, (uint32_t)SMLAD(x, y, a), model_smlad(x, y, a));
+                if ((uint32_t)SMLAWB(x, y, a) != model_smlawb(x, y, a) && fails++ < 5)
+                    BENCH_CHECK(0, "SMLAWB(%08x, %04x, %08x) = %08x, instruction gives %08x",
+                                x, y & 0xffff, a, (uint32_t)SMLAWB(x, y, a), model_smlawb(x, y, a));
+            }
+        }
+    }
+    for (i = 0; i < count; i++) {
+        uint32_t x = rnd(), y = rnd(), a = rnd();
+
+        if ((uint32_t)SMLAD(x, y, a) != model_smlad(x, y, a) && fails++ < 5)
+            BENCH_CHECK(0, "SMLAD(%08x, %08x, %08x) = %08x, instruction gives %08x",
+                        x, y, a, (uint32_t)SMLAD(x, y, a), model_smlad(x, y, a));
+        if ((uint32_t)SMLAWB(x, y, a) != model_smlawb(x, y, a) && fails++ < 5)
+            BENCH_CHECK(0, "SMLAWB(%08x, %04x, %08x) = %08x, instruction gives %08x",
+                        x, y & 0xffff, a, (uint32_t)SMLAWB(x, y, a), model_smlawb(x, y, a));
+    }
+    BENCH_CHECK(fails == 0, "%d SMLAD/SMLAWB results differ from the instructions", fails);
+    printf("%s: SMLAD/SMLAWB match the instruction model, %d cases\n",
+           BUILD_NAME, n_edges * n_edges * n_edges + count);
+}
+#endif
+
+/*
+ * The MULT16_32 forms shift b left before SMLAWB, as fixed_arm5e.h does, so
+ * they are specified for b that fits after the shift: |b| < 2^30 for Q15,
+ * |b| < 2^26 for Q11.
+ */
+static void check_mult16_32(int count)
+{
+    static const spx_word16_t a_edges[] = { -32768, -32767, -1, 0, 1, 32767 };
+    const spx_word32_t q15_edges[] = { -(1 << 30), -(1 << 30) + 1, -32769, -32768, -1, 0,
+                                       1, 32767, 32768, (1 << 30) - 1 };
+    const spx_word32_t q11_edges[] = { -(1 << 26), -(1 << 26) + 1, -2049, -2048, -1, 0,
+                                       1, 2047, 2048, (1 << 26) - 1 };
+    digest_t q15, q11;
+    int i, j;
+
+    digest_init(&q15);
+    digest_init(&q11);
+    for (i = 0; i < (int)(sizeof(a_edges) / sizeof(a_edges[0])); i++) {
+        for (j = 0; j < (int)(sizeof(q15_edges) / sizeof(q15_edges[0])); j++) {
+            spx_word32_t r[4];
+
+            r[0] = MULT16_32_Q15(a_edges[i], q15_edges[j]);
+            r[1] = MAC16_32_Q15(q15_edges[j], a_edges[i], q15_edges[j]);
+            r[2] = MULT16_32_Q11(a_edges[i], q11_edges[j]);
+            r[3] = MAC16_32_Q11(q11_edges[j], a_edges[i], q11_edges[j]);
+            digest_add(&q15, r, 2 * sizeof(r[0]));
+            digest_add(&q11, r + 2, 2 * sizeof(r[0]));
+        }
+    }
+    report("mult16_32_q15 edges", &q15);
+    report("mult16_32_q11 edges", &q11);
+
+    digest_init(&q15);
+    digest_init(&q11);
+    for (i = 0; i < count; i++) {
+        spx_word16_t a = rnd16();
+        spx_word32_t b15 = rnd_range(1 << 30), b11 = rnd_range(1 << 26);
+        spx_word32_t c = (spx_word32_t)rnd();
+        spx_word32_t r[4];
+
+        r[0] = MULT16_32_Q15(a, b15);
+        r[1] = MAC16_32_Q15(c, a, b15);
+        r[2] = MULT16_32_Q11(a, b11);
+        r[3] = MAC16_32_Q11(c, a, b11);
+        digest_add(&q15, r, 2 * sizeof(r[0]));
+        digest_add(&q11, r + 2, 2 * sizeof(r[0]));
+    }
+    report("mult16_32_q15 random", &q15);
+    report("mult16_32_q11 random", &q11);
+}
+
+/* odd offsets make LD16X2 read across word boundaries */
+static void check_inner_prod(int count)
+{
+    spx_word16_t x[256], y[256];
+    digest_t rd, ed;
+    int i, j;
+
+    digest_init(&ed);
+    for (i = 0; i < 4; i++) {
+        for (j = 0; j < 256; j++) {
+            switch (i) {
+            case 0: x[j] = y[j] = -32768; break;
+            case 1: x[j] = 32767; y[j] = -32768; break;
+            case 2: x[j] = (j & 1) ? 32767 : -32768; y[j] = -32768; break;
+            default: x[j] = (j & 2) ? 32767 : -32768; y[j] = (j & 1) ? 32767 : -32768; break;
+            }
+        }
+        for (j = 0; j <= 240; j += 40) {
+            spx_word32_t r = inner_prod(x + (j / 40 & 1), y, j + 3);
+
+            digest_add(&ed, &r, sizeof(r));
+        }
+    }
+    report("inner_prod edges", &ed);
+
+    digest_init(&rd);
+    for (i = 0; i < count; i++) {
+        int len = rnd() % 200;
+        int xo = rnd() % 8, yo = rnd() % 8;
+        spx_word32_t r;
+
+        for (j = 0; j < 256; j++) {
+            x[j] = rnd16();
+            y[j] = (i & 1) ? (spx_word16_t)(rnd() >> 20) : rnd16();
+        }
+        r = inner_prod(x + xo, y + yo, len);
+        digest_add(&rd, &r, sizeof(r));
+    }
+    report("inner_prod random", &rd);
+}
+
+static void run_vq(digest_t *d, int sign, const spx_word16_t *in, const spx_word16_t *codebook,
+                   int len, int entries, spx_word32_t *E, int N)
+{
+    spx_word16_t in_copy[64];
+    int nbest[16];
+    spx_word32_t best_dist[16];
+    char stack[16];
+
+    memcpy(in_copy, in, len * sizeof(in[0]));
+    memset(nbest, 0, sizeof(nbest));
+    memset(best_dist, 0, sizeof(best_dist));
+    if (sign)
+        vq_nbest_sign(in_copy, codebook, len, entries, E, N, nbest, best_dist, stack);
+    else
+        vq_nbest(in_copy, codebook, len, entries, E, N, nbest, best_dist, stack);
+    digest_add(d, nbest, N * sizeof(nbest[0]));
+    digest_add(d, best_dist, N * sizeof(best_dist[0]));
+}
+
+static void check_vq(int count)
+{
+    static spx_word16_t codebook[64 * 64];
+    spx_word16_t in[64];
+    spx_word32_t E[64];
+    digest_t rd[2], ed[2];
+    int i, j, sign;
+
+    /*
+     * Ties and the ends of the range: repeated entries must keep the lowest
+     * index first, and full-scale products must wrap like the C sums.
+     */
+    for (sign = 0; sign < 2; sign++) {
+        digest_init(&ed[sign]);
+        for (i = 0; i < 64 * 64; i++)
+            codebook[i] = (i / 10) % 3 ? -32768 : 32767;
+        for (i = 0; i < 64; i++) {
+            in[i] = (i & 1) ? 32767 : -32768;
+            E[i] = (i % 3) ? 0x7fffffff : 0;
+        }
+        for (j = 1; j <= 20; j++)
+            run_vq(&ed[sign], sign, in, codebook, j, 64, E, 1 + j % 10);
+    }
+    report("vq_nbest edges", &ed[0]);
+    report("vq_nbest_sign edges", &ed[1]);
+
+    for (sign = 0; sign < 2; sign++)
+        digest_init(&rd[sign]);
+    for (i = 0; i < count; i++) {
+        int len = 1 + rnd() % 20;
+        int entries = 1 + rnd() % 64;
+        int N = 1 + rnd() % 10;
+        int dup = rnd() & 1;
+
+        if (N > entries)
+            N = entries;
+        for (j = 0; j < entries; j++) {
+            int k;
+
+            if (dup && j > 0 && (rnd() & 1)) {
+                memcpy(codebook + j * len, codebook + (rnd() % j) * len, len * sizeof(codebook[0]));
+                continue;
+            }
+            for (k = 0; k < len; k++)
+                codebook[j * len + k] = (spx_word16_t)(rnd16() >> (rnd() % 4));
+        }
+        for (j = 0; j < len; j++)
+            in[j] = (spx_word16_t)(rnd16() >> (rnd() % 8));
+        for (j = 0; j < entries; j++)
+            E[j] = (spx_word32_t)(rnd() >> 2);
+        for (sign = 0; sign < 2; sign++)
+            run_vq(&rd[sign], sign, in, codebook, len, entries, E, N);
+    }
+    report("vq_nbest random", &rd[0]);
+    report("vq_nbest_sign random", &rd[1]);
+}
+
+/*
+ * The kernel pairs products only when no per-product shift is needed, so
+ * the levels around that switch matter most.
+ */
+static void check_autocorr(int count)
+{
+    spx_word16_t x[330], ac[16];
+    digest_t d;
+    int i, j;
+
+    digest_init(&d);
+    for (i = 0; i < count; i++) {
+        int n = 1 + rnd() % 320;
+        int lag = 1 + rnd() % 12;
+        int level = rnd() % 16;
+        int xo = rnd() & 1;
+
+        if (lag > n)
+            lag = n;
+        for (j = 0; j < n + 1; j++) {
+            if (level == 15)
+                x[j] = (j & 1) ? -32768 : 32767;
+            else
+                x[j] = (spx_word16_t)((spx_word16_t)rnd() >> level);
+        }
+        _spx_autocorr(x + xo, ac, lag, n);
+        digest_add(&d, ac, lag * sizeof(ac[0]));
+    }
+    report("_spx_autocorr random", &d);
+}
+
+/* 2 s of each, at the given rate */
+#define CORPUS_SECONDS 2
+
+enum { SIG_SINE, SIG_CHIRP, SIG_NOISE, SIG_SPEECH, SIG_CLIPPED, SIG_QUIET, SIG_COUNT };
+
+static const char *const s_signal_names[SIG_COUNT] = {
+    "sine", "chirp", "noise", "speech", "clipped", "quiet",
+};
+
+static spx_int16_t clip16(double v)
+{
+    if (v > 32767)
+        return 32767;
+    if (v < -32768)
+        return -32768;
+    return (spx_int16_t)lrint(v);
+}
+
+/*
+ * Synthetic speech: a 90..160 Hz glottal pulse train through three
+ * formant resonators, gated in syllables.
+ */
+static void make_signal(int kind, int rate, spx_int16_t *pcm, int len)
+{
+    double state[3][2] = { { 0 } };
+    static const double formants[3] = { 650, 1100, 2600 };
+    double phase = 0;
+    int i, k;
+
+    s_seed = 0x5eed0000u + kind;
+    for (i = 0; i < len; i++) {
+        double t = (double)i / rate;
+        double v;
+
+        switch (kind) {
+        case SIG_SINE:
+            v = 12000 * sin(2 * M_PI * 440 * t);
+            break;
+        case SIG_CHIRP:
+            v = 12000 * sin(2 * M_PI * (100 * t + (rate / 2 - 200) * t * t / (2 * CORPUS_SECONDS)));
+            break;
+        case SIG_NOISE:
+            v = (spx_int16_t)rnd() / 4;
+            break;
+        case SIG_SPEECH:
+            phase += (90 + 70 * (0.5 + 0.5 * sin(2 * M_PI * 1.3 * t))) / rate;
+            v = 0;
+            if (phase >= 1) {
+                phase -= 1;
+                v = 8000;
+            }
+            for (k = 0; k < 3; k++) {
+                double r = 0.97, w = 2 * M_PI * formants[k] * (1 + 0.2 * sin(2 * M_PI * (k + 1) * 0.7 * t)) / rate;
+                double y = v + 2 * r * cos(w) * state[k][0] - r * r * state[k][1];
+
+                state[k][1] = state[k][0];
+                state[k][0] = y;
+                v = y * (1 - r);
+            }
+            v *= 40 * (sin(2 * M_PI * 3 * t) > -0.3);
+            break;
+        case SIG_CLIPPED:
+            v = 60000 * sin(2 * M_PI * 300 * t);
+            break;
+        default:
+            v = (int)(rnd() % 5) - 2;
+            break;
+        }
+        pcm[i] = clip16(v);
+    }
+}
+
+static double now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void check_encoder(int wideband, int repeat)
+{
+    const SpeexMode *mode = speex_lib_get_mode(wideband ? SPEEX_MODEID_WB : SPEEX_MODEID_NB);
+    const int rate = wideband ? 16000 : 8000;
+    const int len = rate * CORPUS_SECONDS;
+    spx_int16_t *pcm = malloc(len * sizeof(*pcm));
+    double total_us = 0;
+    int frames = 0;
+    int kind, r;
+
+    for (kind = 0; kind < SIG_COUNT; kind++) {
+        char name[40];
+        digest_t d;
+
+        make_signal(kind, rate, pcm, len);
+        digest_init(&d);
+        for (r = 0; r < repeat; r++) {
+            void *enc = speex_encoder_init(mode);
+            int quality = 5, frame_size, i;
+            SpeexBits bits;
+            double start;
+
+            speex_encoder_ctl(enc, SPEEX_SET_QUALITY, &quality);
+            speex_encoder_ctl(enc, SPEEX_GET_FRAME_SIZE, &frame_size);
+            speex_bits_init(&bits);
+            digest_init(&d);
+            start = now_us();
+            for (i = 0; i + frame_size <= len; i += frame_size) {
+                spx_int16_t frame[320];
+                char out[200];
+                int nbytes;
+
+                /* the encoder works in place on its input */
+                memcpy(frame, pcm + i, frame_size * sizeof(frame[0]));
+                speex_bits_reset(&bits);
+                speex_encode_int(enc, frame, &bits);
+                nbytes = speex_bits_write(&bits, out, sizeof(out));
+                digest_add(&d, out, nbytes);
+                frames++;
+            }
+            total_us += now_us() - start;
+            speex_bits_destroy(&bits);
+            speex_encoder_destroy(enc);
+        }
+        snprintf(name, sizeof(name), "encode %s %s", wideband ? "wb" : "nb", s_signal_names[kind]);
+        report(name, &d);
+    }
+    printf("%s: %s q5 encode %.1f us/frame (host)\n", BUILD_NAME,
+           wideband ? "wideband" : "narrowband", total_us / frames);
+    free(pcm);
+}
+
+int main(int argc, char **argv)
+{
+    int repeat = argc > 2 ? atoi(argv[2]) : 1;
+
+    if (argc < 2 || repeat < 1) {
+        fprintf(stderr, "usage: %s OUT [repeat]\n", argv[0]);
+        return 2;
+    }
+    s_out = fopen(argv[1], "w");
+    if (s_out == NULL) {
+        perror(argv[1]);
+        return 2;
+    }
+
+    s_seed = 0x2017c0de;
+#ifdef ARMV7EM_ASM
+    check_intrinsics(1000000);
+#endif
+    s_seed = 0x00c0ffee;
+    check_mult16_32(200000);
+    check_inner_prod(20000);
+    check_vq(20000);
+    check_autocorr(20000);
+    check_encoder(0, repeat);
+    check_encoder(1, repeat);
+
+    fclose(s_out);
+    return s_errors ? 1 : 0;
+}
@@ -0,0 +1,495 @@
+/* Copyright (C) 2017 Baidu Inc. */
+/**
+   @file quality_bench.c
+   @brief Host quality comparison of the fixed-point and float speex builds
+*/
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   - Neither the name of the Xiph.org Foundation nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * quality_bench gen DIR
+ * quality_bench OUT FILE.raw...
+ * quality_bench -c FLOAT_OUT FIXED_OUT
+ *
+ * gen writes the synthetic corpus to DIR, 16 kHz mono 16-bit raw PCM:
+ * formant speech at three levels, a tone, a chirp, noise, a clipped tone
+ * and near silence.
+ *
+ * run.sh builds this file with libspeex in float and in fixed point. Each
+ * build encodes every file in wideband at quality 5, decodes it again and
+ * writes to OUT, per file, the segmental SNR and the log-spectral distance
+ * of the decoded signal against the input. These two objective measures
+ * stand in for PESQ, which is not available here: segmental SNR follows
+ * the waveform error frame by frame, log-spectral distance the error of
+ * the spectral envelope the listener hears.
+ *
+ * -c compares the two reports: on every file the fixed-point build may
+ * lose at most QUALITY_SNR_LOSS dB of segmental SNR and add at most
+ * QUALITY_LSD_GAIN dB of log-spectral distance against the float build.
+ * Files driven to full scale are listed but not checked: the fixed-point
+ * codec has no headroom above it and saturates, which the float build
+ * does not.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "speex/speex.h"
+
+#ifdef FIXED_POINT
+#define BUILD_NAME "fixed"
+#else
+#define BUILD_NAME "float"
+#endif
+
+#define QUALITY_RATE        16000
+#define QUALITY_SECONDS     3
+#define QUALITY_SNR_LOSS    1.5     /* dB */
+#define QUALITY_LSD_GAIN    0.5     /* dB */
+
+#define SEG_LEN             320     /* 20 ms */
+#define SEG_MIN_DB          (-10.0)
+#define SEG_MAX_DB          35.0
+#define SEG_SILENT          (SEG_LEN * 50.0 * 50.0)   /* energy of a frame at rms 50 */
+#define LSD_LEN             512
+#define LSD_RANGE           1e-5    /* -50 dB */
+#define DELAY_MAX           640
+
+#define FULL_SCALE_RATIO    1000    /* 1 in this many samples at full scale */
+
+#define FILE_MAX            64
+
+/* speex-port/config.c logs through lightduer, the bench just uses libc */
+void *speex_alloc(int size) { return calloc(size, 1); }
+void *speex_alloc_scratch(int size) { return calloc(size, 1); }
+void *speex_realloc(void *ptr, int size) { return realloc(ptr, size); }
+void speex_free(void *ptr) { free(ptr); }
+void speex_free_scratch(void *ptr) { free(ptr); }
+void speex_error(const char *str) { fprintf(stderr, "speex error: %s\n", str); }
+void speex_warning(const char *str) { (void)str; }
+void speex_warning_int(const char *str, int val) { (void)str; (void)val; }
+void speex_notify(const char *str) { (void)str; }
+
+static unsigned int s_seed;
+
+static int rnd(void)
+{
+    s_seed ^= s_seed << 13;
+    s_seed ^= s_seed >> 17;
+    s_seed ^= s_seed << 5;
+    return (short)s_seed;
+}
+
+static short clip16(double v)
+{
+    if (v > 32767)
+        return 32767;
+    if (v < -32768)
+        return -32768;
+    return (short)lrint(v);
+}
+
+/*
+ * Synthetic speech: a 90..160 Hz glottal pulse train through three moving
+ * formant resonators, gated in syllables, with a noise burst (fricative)
+ * at the start of every syllable.
+ */
+static void make_speech(short *pcm, int len, double gain)
+{
+    static const double formants[3] = { 650, 1100, 2600 };
+    double state[3][2] = { { 0 } };
+    double phase = 0;
+    int i, k;
+
+    for (i = 0; i < len; i++) {
+        double t = (double)i / QUALITY_RATE;
+        double syl = fmod(t * 3, 1.0);
+        double v = 0;
+
+        phase += (90 + 70 * (0.5 + 0.5 * sin(2 * M_PI * 1.3 * t))) / QUALITY_RATE;
+        if (phase >= 1) {
+            phase -= 1;
+            v = 8000;
+        }
+        for (k = 0; k < 3; k++) {
+            double r = 0.97;
+            double w = 2 * M_PI * formants[k] * (1 + 0.2 * sin(2 * M_PI * (k + 1) * 0.7 * t)) / QUALITY_RATE;
+            double y = v + 2 * r * cos(w) * state[k][0] - r * r * state[k][1];
+
+            state[k][1] = state[k][0];
+            state[k][0] = y;
+            v = y * (1 - r);
+        }
+        v *= 40;
+        if (syl < 0.08)
+            v = rnd() / 8.0;
+        else if (syl > 0.75)
+            v = 0;
+        pcm[i] = clip16(v * gain);
+    }
+}
+
+static int write_raw(const char *dir, const char *name, const short *pcm, int len)
+{
+    char path[512];
+    FILE *f;
+
+    snprintf(path, sizeof(path), "%s/%s.raw", dir, name);
+    f = fopen(path, "wb");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    fwrite(pcm, sizeof(*pcm), len, f);
+    fclose(f);
+    return 0;
+}
+
+static int gen_corpus(const char *dir)
+{
+    const int len = QUALITY_RATE * QUALITY_SECONDS;
+    short *pcm = malloc(len * sizeof(*pcm));
+    int i, ret = 0;
+
+    s_seed = 0x5eed0001u;
+    make_speech(pcm, len, 1.0);
+    ret |= write_raw(dir, "speech", pcm, len);
+    make_speech(pcm, len, 0.25);                /* -12 dB */
+    ret |= write_raw(dir, "speech-12dB", pcm, len);
+    make_speech(pcm, len, 0.03);                /* -30 dB */
+    ret |= write_raw(dir, "speech-30dB", pcm, len);
+
+    for (i = 0; i < len; i++)
+        pcm[i] = clip16(12000 * sin(2 * M_PI * 440 * i / QUALITY_RATE));
+    ret |= write_raw(dir, "sine", pcm, len);
+
+    for (i = 0; i < len; i++) {
+        double t = (double)i / QUALITY_RATE;
+
+        pcm[i] = clip16(12000 * sin(2 * M_PI * (100 * t + 7800 * t * t / (2 * QUALITY_SECONDS))));
+    }
+    ret |= write_raw(dir, "chirp", pcm, len);
+
+    for (i = 0; i < len; i++)
+        pcm[i] = rnd() / 4;
+    ret |= write_raw(dir, "noise", pcm, len);
+
+    for (i = 0; i < len; i++)
+        pcm[i] = clip16(60000 * sin(2 * M_PI * 300 * i / QUALITY_RATE));
+    ret |= write_raw(dir, "clipped", pcm, len);
+
+    for (i = 0; i < len; i++)
+        pcm[i] = rnd() % 3;
+    ret |= write_raw(dir, "quiet", pcm, len);
+
+    free(pcm);
+    return ret ? 1 : 0;
+}
+
+static short *read_raw(const char *path, int *len)
+{
+    FILE *f = fopen(path, "rb");
+    short *pcm;
+    long size;
+
+    if (f == NULL) {
+        perror(path);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    pcm = malloc(size > 0 ? size : 1);
+    *len = fread(pcm, sizeof(*pcm), size / sizeof(*pcm), f);
+    fclose(f);
+    return pcm;
+}
+
+/* wideband quality 5 encode and decode, out has the length of in */
+static void code(const short *in, short *out, int len)
+{
+    void *enc = speex_encoder_init(&speex_wb_mode);
+    void *dec = speex_decoder_init(&speex_wb_mode);
+    int quality = 5, frame_size, i;
+    SpeexBits bits;
+
+    speex_encoder_ctl(enc, SPEEX_SET_QUALITY, &quality);
+    speex_encoder_ctl(enc, SPEEX_GET_FRAME_SIZE, &frame_size);
+    speex_bits_init(&bits);
+    memset(out, 0, len * sizeof(*out));
+    for (i = 0; i + frame_size <= len; i += frame_size) {
+        spx_int16_t frame[320];
+        char buf[200];
+        int nbytes;
+
+        /* the encoder works in place on its input */
+        memcpy(frame, in + i, frame_size * sizeof(frame[0]));
+        speex_bits_reset(&bits);
+        speex_encode_int(enc, frame, &bits);
+        nbytes = speex_bits_write(&bits, buf, sizeof(buf));
+
+        speex_bits_read_from(&bits, buf, nbytes);
+        speex_decode_int(dec, &bits, out + i);
+    }
+    speex_bits_destroy(&bits);
+    speex_decoder_destroy(dec);
+    speex_encoder_destroy(enc);
+}
+
+/* codec delay: the lag of out against in with the highest correlation */
+static int find_delay(const short *in, const short *out, int len)
+{
+    double best = -1;
+    int lag, best_lag = 0, i;
+
+    for (lag = 0; lag <= DELAY_MAX && lag < len; lag++) {
+        double xy = 0, yy = 1;
+
+        for (i = 0; i + lag < len; i++) {
+            xy += (double)in[i] * out[i + lag];
+            yy += (double)out[i + lag] * out[i + lag];
+        }
+        if (xy / sqrt(yy) > best) {
+            best = xy / sqrt(yy);
+            best_lag = lag;
+        }
+    }
+    return best_lag;
+}
+
+/* mean of the per frame SNR, clamped, over the frames that are not silent */
+static double seg_snr(const short *in, const short *out, int len)
+{
+    double sum = 0;
+    int n = 0, i, j;
+
+    for (i = 0; i + SEG_LEN <= len; i += SEG_LEN) {
+        double s = 0, e = 0, db;
+
+        for (j = i; j < i + SEG_LEN; j++) {
+            double d = (double)in[j] - out[j];
+
+            s += (double)in[j] * in[j];
+            e += d * d;
+        }
+        if (s < SEG_SILENT)
+            continue;
+        db = 10 * log10(s / (e + 1));
+        if (db < SEG_MIN_DB)
+            db = SEG_MIN_DB;
+        if (db > SEG_MAX_DB)
+            db = SEG_MAX_DB;
+        sum += db;
+        n++;
+    }
+    return n ? sum / n : SEG_MAX_DB;
+}
+
+/*
+ * mean over the frames that are not silent of the rms over the bins of the
+ * difference of the log power spectra, dB. Both spectra are floored at
+ * LSD_RANGE below the peak of the input frame, so the empty bins of a tone
+ * do not dominate.
+ */
+static double lsd(const short *in, const short *out, int len)
+{
+    static double win[LSD_LEN], cs[LSD_LEN];
+    double px[LSD_LEN / 2], py[LSD_LEN / 2];
+    double sum = 0;
+    int n = 0, i, j, k;
+
+    for (i = 0; i < LSD_LEN; i++) {
+        win[i] = 0.5 - 0.5 * cos(2 * M_PI * i / LSD_LEN);
+        cs[i] = cos(2 * M_PI * i / LSD_LEN);
+    }
+
+    for (i = 0; i + LSD_LEN <= len; i += LSD_LEN / 2) {
+        double energy = 0, peak = 0, floor, frame = 0;
+
+        for (j = i; j < i + LSD_LEN; j++)
+            energy += (double)in[j] * in[j];
+        if (energy < SEG_SILENT * LSD_LEN / SEG_LEN)
+            continue;
+
+        for (k = 1; k < LSD_LEN / 2; k++) {
+            double xr = 0, xi = 0, yr = 0, yi = 0;
+
+            for (j = 0; j < LSD_LEN; j++) {
+                int p = (j * k) % LSD_LEN;
+                double c = cs[p], s = cs[(p + LSD_LEN * 3 / 4) % LSD_LEN];
+
+                xr += win[j] * in[i + j] * c;
+                xi -= win[j] * in[i + j] * s;
+                yr += win[j] * out[i + j] * c;
+                yi -= win[j] * out[i + j] * s;
+            }
+            px[k] = xr * xr + xi * xi;
+            py[k] = yr * yr + yi * yi;
+            if (px[k] > peak)
+                peak = px[k];
+        }
+
+        floor = peak * LSD_RANGE;
+        for (k = 1; k < LSD_LEN / 2; k++) {
+            double d = 10 * log10((px[k] > floor ? px[k] : floor) /
+                                  (py[k] > floor ? py[k] : floor));
+
+            frame += d * d;
+        }
+        sum += sqrt(frame / (LSD_LEN / 2 - 1));
+        n++;
+    }
+    return n ? sum / n : 0;
+}
+
+static const char *base_name(const char *path)
+{
+    const char *p = strrchr(path, '/');
+
+    return p ? p + 1 : path;
+}
+
+/* the delay of the codec, measured on noise where the lag is unambiguous */
+static int codec_delay(void)
+{
+    const int len = QUALITY_RATE;
+    short *in = malloc(len * sizeof(*in));
+    short *out = malloc(len * sizeof(*out));
+    int i, delay;
+
+    s_seed = 0x5eed0002u;
+    for (i = 0; i < len; i++)
+        in[i] = rnd() / 4;
+    code(in, out, len);
+    delay = find_delay(in, out, len);
+    free(out);
+    free(in);
+    return delay;
+}
+
+static int measure(const char *report, int argc, char **argv)
+{
+    FILE *f = fopen(report, "w");
+    int delay = codec_delay();
+    int i;
+
+    if (f == NULL) {
+        perror(report);
+        return 2;
+    }
+    for (i = 0; i < argc; i++) {
+        int len, full = 0, j;
+        short *in = read_raw(argv[i], &len);
+        short *out;
+
+        if (in == NULL || len < QUALITY_RATE / 2) {
+            fprintf(stderr, "%s: too short\n", argv[i]);
+            free(in);
+            fclose(f);
+            return 2;
+        }
+        out = malloc(len * sizeof(*out));
+        code(in, out, len);
+        for (j = 0; j < len; j++)
+            full += (in[j] >= 32767 || in[j] <= -32768);
+        fprintf(f, "%s %.2f %.2f %d %d\n", base_name(argv[i]),
+                seg_snr(in, out + delay, len - delay),
+                lsd(in, out + delay, len - delay), delay,
+                full * FULL_SCALE_RATIO > len);
+        free(out);
+        free(in);
+    }
+    fclose(f);
+    return 0;
+}
+
+struct result {
+    char name[128];
+    double snr;
+    double lsd;
+    int delay;
+    int full_scale;
+};
+
+static int read_report(const char *path, struct result *r)
+{
+    FILE *f = fopen(path, "r");
+    int n = 0;
+
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    while (n < FILE_MAX && fscanf(f, "%127s %lf %lf %d %d", r[n].name, &r[n].snr,
+                                  &r[n].lsd, &r[n].delay, &r[n].full_scale) == 5)
+        n++;
+    fclose(f);
+    return n;
+}
+
+static int compare(const char *float_report, const char *fixed_report)
+{
+    static struct result flt[FILE_MAX], fix[FILE_MAX];
+    int n = read_report(float_report, flt);
+    int errors = 0, i;
+
+    if (n <= 0 || read_report(fixed_report, fix) != n) {
+        printf("FAIL reports differ in length\n");
+        return 1;
+    }
+    printf("wideband q5          segSNR dB       LSD dB\n"
+           "                    float  fixed   float  fixed\n");
+    for (i = 0; i < n; i++) {
+        int ok = strcmp(flt[i].name, fix[i].name) == 0 &&
+                 (flt[i].full_scale ||
+                  (fix[i].snr >= flt[i].snr - QUALITY_SNR_LOSS &&
+                   fix[i].lsd <= flt[i].lsd + QUALITY_LSD_GAIN));
+
+        printf("%-18s %6.2f %6.2f  %6.2f %6.2f%s\n", flt[i].name, flt[i].snr,
+               fix[i].snr, flt[i].lsd, fix[i].lsd,
+               !ok ? "  FAIL" : flt[i].full_scale ? "  full scale, not checked" : "");
+        errors += !ok;
+    }
+    return errors ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 3 && strcmp(argv[1], "gen") == 0)
+        return gen_corpus(argv[2]);
+    if (argc == 4 && strcmp(argv[1], "-c") == 0)
+        return compare(argv[2], argv[3]);
+    if (argc >= 3)
+        return measure(argv[1], argc - 2, argv + 2);
+
+    fprintf(stderr, "usage: %s gen DIR | OUT FILE.raw... | -c FLOAT_OUT FIXED_OUT\n", argv[0]);
+    return 2;
+}
@@ -0,0 +1,42 @@
+#!/bin/sh
+#
+# Build libspeex in fixed point on the host twice, with the ARMv7E-M
+# kernels (ARMV7EM_ASM, SMLAD/SMLAWB in C) and with the generic C kernels,
+# and check that both give the same kernel results and bitstreams.
+# -fwrapv makes the C sums wrap like the Cortex-M4 adds. Arguments are
+# passed to dsp_bench after the report file.
+#
+# Then build quality_bench in float and in fixed point, code the synthetic
+# corpus with both and compare the decoded quality. Recorded clips, 16 kHz
+# mono 16-bit raw, can be added with SPEEX_CORPUS=DIR; none are committed.
+#
+set -e
+cd "$(dirname "$0")"
+S=../libspeex
+build() {
+	CFLAGS="-O2 -fwrapv -DHAVE_CONFIG_H -DFIXED_POINT $* -I../include -I../../speex-port -I$S"
+	gcc $CFLAGS -Wall -c dsp_bench.c -o /tmp/dsp_bench.o
+	gcc $CFLAGS -w /tmp/dsp_bench.o $S/*.c -lm -o /tmp/dsp_bench
+}
+build -DARMV7EM_ASM
+/tmp/dsp_bench /tmp/dsp_bench.armv7em "$@"
+build
+/tmp/dsp_bench /tmp/dsp_bench.generic "$@"
+diff /tmp/dsp_bench.generic /tmp/dsp_bench.armv7em
+cat /tmp/dsp_bench.armv7em
+quality() {
+	CFLAGS="-O2 -fwrapv -DHAVE_CONFIG_H -D$1 -I../include -I../../speex-port -I$S"
+	gcc $CFLAGS -Wall -c quality_bench.c -o /tmp/quality_bench.o
+	gcc $CFLAGS -w /tmp/quality_bench.o $S/*.c -lm -o /tmp/quality_bench.$2
+}
+quality FLOATING_POINT float
+quality FIXED_POINT fixed
+rm -rf /tmp/speex_corpus
+mkdir /tmp/speex_corpus
+/tmp/quality_bench.float gen /tmp/speex_corpus
+CORPUS="/tmp/speex_corpus/*.raw"
+[ -n "$SPEEX_CORPUS" ] && CORPUS="$CORPUS $SPEEX_CORPUS/*.raw"
+/tmp/quality_bench.float /tmp/quality.float $CORPUS
+/tmp/quality_bench.fixed /tmp/quality.fixed $CORPUS
+/tmp/quality_bench.float -c /tmp/quality.float /tmp/quality.fixed
+echo "PASS"
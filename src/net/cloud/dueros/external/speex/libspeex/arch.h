@@ -89,6 +89,8 @@ typedef spx_word32_t spx_sig_t;
 #include "fixed_arm5e.h"
 #elif defined (BFIN_ASM)
 #include "fixed_bfin.h"
+#elif defined (ARMV7EM_ASM)
+#include "fixed_armv7em.h"
 #endif
 
 #endif
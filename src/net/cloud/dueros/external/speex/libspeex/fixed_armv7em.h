@@ -0,0 +1,92 @@
+/* Copyright (C) 2017 Baidu Inc. */
+/**
+   @file fixed_armv7em.h
+   @brief ARMv7E-M (Cortex-M4) DSP fixed-point operations
+*/
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+   
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+   
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+   
+   - Neither the name of the Xiph.org Foundation nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+   
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef FIXED_ARMV7EM_H
+#define FIXED_ARMV7EM_H
+
+/* The kernels below keep the rounding of fixed_generic.h, so encoder output
+   is bit-exact with the plain C fixed-point build. Without the DSP
+   extension (e.g. when checking the kernels on a host) the same operations
+   are done in C. */
+
+#include <string.h>
+
+/* Two adjacent Q15 samples, low address in the bottom half-word */
+static inline spx_uint32_t LD16X2(const spx_word16_t *p) {
+  spx_uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+/* a + x.bottom*y.bottom + x.top*y.top */
+static inline spx_word32_t SMLAD(spx_uint32_t x, spx_uint32_t y, spx_word32_t a) {
+#ifdef __ARM_ARCH_7EM__
+  int res;
+  asm ("smlad  %0,%1,%2,%3;\n"
+              : "=r"(res)
+              : "%r"(x),"r"(y),"r"(a));
+  return(res);
+#else
+  return (spx_word32_t)((spx_uint32_t)a
+      + (spx_uint32_t)((spx_word32_t)(spx_word16_t)x*(spx_word16_t)y)
+      + (spx_uint32_t)((spx_word32_t)(spx_word16_t)(x>>16)*(spx_word16_t)(y>>16)));
+#endif
+}
+
+/* a + (x*y.bottom)>>16 */
+static inline spx_word32_t SMLAWB(spx_word32_t x, spx_word16_t y, spx_word32_t a) {
+#ifdef __ARM_ARCH_7EM__
+  int res;
+  asm ("smlawb  %0,%1,%2,%3;\n"
+              : "=r"(res)
+              : "r"(x),"r"(y),"r"(a));
+  return(res);
+#else
+  return (spx_word32_t)((spx_uint32_t)a + (spx_uint32_t)(((long long)x*y)>>16));
+#endif
+}
+
+#undef MULT16_32_Q15
+#define MULT16_32_Q15(a,b) SMLAWB(SHL32(b,1),a,0)
+
+#undef MAC16_32_Q15
+#define MAC16_32_Q15(c,a,b) SMLAWB(SHL32(b,1),a,c)
+
+#undef MULT16_32_Q11
+#define MULT16_32_Q11(a,b) SMLAWB(SHL32(b,5),a,0)
+
+#undef MAC16_32_Q11
+#define MAC16_32_Q11(c,a,b) SMLAWB(SHL32(b,5),a,c)
+
+#endif
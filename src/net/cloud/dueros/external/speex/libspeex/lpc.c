@@ -57,6 +57,8 @@
 
 #ifdef BFIN_ASM
 #include "lpc_bfin.h"
+#elif defined(ARMV7EM_ASM)
+#include "lpc_armv7em.h"
 #endif
 
 /* LPC analysis
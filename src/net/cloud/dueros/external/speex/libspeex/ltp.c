@@ -52,6 +52,8 @@
 #include "ltp_arm4.h"
 #elif defined (BFIN_ASM)
 #include "ltp_bfin.h"
+#elif defined (ARMV7EM_ASM)
+#include "ltp_armv7em.h"
 #endif
 
 #ifndef OVERRIDE_INNER_PROD
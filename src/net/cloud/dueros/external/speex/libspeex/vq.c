@@ -45,6 +45,8 @@
 #include "vq_arm4.h"
 #elif defined(BFIN_ASM)
 #include "vq_bfin.h"
+#elif defined(ARMV7EM_ASM)
+#include "vq_armv7em.h"
 #endif
 
 
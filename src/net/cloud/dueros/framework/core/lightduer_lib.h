@@ -23,6 +23,7 @@
 #include <string.h>
 
 #define DUER_MEMCPY(...)     memcpy(__VA_ARGS__)
+#define DUER_MEMMOVE(...)    memmove(__VA_ARGS__)
 #define DUER_MEMCMP(...)     memcmp(__VA_ARGS__)
 #define DUER_MEMSET(...)     memset(__VA_ARGS__)
 #define DUER_STRLEN(...)     strlen(__VA_ARGS__)
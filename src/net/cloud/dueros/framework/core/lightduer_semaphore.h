@@ -0,0 +1,87 @@
+/**
+ * Copyright (2017) Baidu Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+//
+// Description: Wrapper for semaphore
+
+#ifndef BAIDU_IOT_TINYDU_IOT_OS_SRC_IOT_BAIDU_CA_SOURCE_BAIDU_CA_SEMAPHORE_H
+#define BAIDU_IOT_TINYDU_IOT_OS_SRC_IOT_BAIDU_CA_SOURCE_BAIDU_CA_SEMAPHORE_H
+
+#include "lightduer_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void* duer_semaphore_t;
+
+/*
+ * Create an empty semaphore, NULL when the platform has none. A release
+ * with nobody waiting may wake the next waiter early, so the waiter checks
+ * its condition again.
+ *
+ * @Return duer_semaphore_t, the created semaphore context
+ */
+DUER_INT duer_semaphore_t duer_semaphore_create(void);
+
+/*
+ * Wait for a release
+ *
+ * @Param sem, the semaphore context
+ * @Param timeout, in ms
+ * @Return DUER_OK when released, DUER_ERR_FAILED on timeout
+ */
+DUER_INT duer_status_t duer_semaphore_wait(duer_semaphore_t sem, duer_u32_t timeout);
+
+/*
+ * Release the semaphore, wakes one waiter
+ *
+ * @Param sem, the semaphore context
+ */
+DUER_INT duer_status_t duer_semaphore_release(duer_semaphore_t sem);
+
+/*
+ * Destroy the semaphore context
+ *
+ * @Param sem, the semaphore context
+ */
+DUER_INT duer_status_t duer_semaphore_destroy(duer_semaphore_t sem);
+
+/*
+ * The semaphore callbacks
+ */
+typedef duer_semaphore_t (*duer_semaphore_create_f)(void);
+typedef duer_status_t (*duer_semaphore_wait_f)(duer_semaphore_t sem, duer_u32_t timeout);
+typedef duer_status_t (*duer_semaphore_release_f)(duer_semaphore_t sem);
+typedef duer_status_t (*duer_semaphore_destroy_f)(duer_semaphore_t sem);
+
+/*
+ * Initial the semaphore callbacks for Baidu CA
+ *
+ * @Param f_create, in, the function create semaphore context
+ * @Param f_wait, in, the function wait with a timeout
+ * @Param f_release, in, the function release semaphore
+ * @Param f_destroy, in, the function destroy semaphore context
+ */
+DUER_EXT void baidu_ca_semaphore_init(duer_semaphore_create_f f_create,
+                                     duer_semaphore_wait_f f_wait,
+                                     duer_semaphore_release_f f_release,
+                                     duer_semaphore_destroy_f f_destroy);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BAIDU_IOT_TINYDU_IOT_OS_SRC_IOT_BAIDU_CA_SOURCE_BAIDU_CA_SEMAPHORE_H
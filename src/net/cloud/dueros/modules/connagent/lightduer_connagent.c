@@ -585,6 +585,15 @@ int duer_data_report_async(duer_context_t *context, const baidu_json *data)
 #endif
 }
 
+#ifdef DUER_VOICE_BINARY_UPLOAD
+int duer_voice_report_async(duer_context_t *context, const void *data, duer_size_t size)
+{
+    int rs = duer_engine_enqueue_report_voice(context, data, size);
+
+    return duer_after_enqueue_handler(rs);
+}
+#endif
+
 int duer_data_report(const baidu_json *data)
 {
     if (duer_engine_qcache_length() > DUER_MAX_MSG_NUM_IN_CA_QUEUE) {
@@ -100,6 +100,18 @@ int duer_data_report(const baidu_json *data);
  */
 int duer_data_report_async(duer_context_t *context, const baidu_json *data);
 
+#ifdef DUER_VOICE_BINARY_UPLOAD
+/**
+ * Send binary voice segment to server, no JSON wrapping and base64 encoding.
+ *
+ * @param context, duer_context_t *, the report callbacks.
+ * @param data, const void *, the voice segment, see lightduer_voice.c for the layout.
+ * @param size, duer_size_t, the segment size, should fit in one CoAP message.
+ * @return int, the report data result, success return DUER_OK, failed return DUER_ERR_FAILED.
+ */
+int duer_voice_report_async(duer_context_t *context, const void *data, duer_size_t size);
+#endif
+
 /**
  * Response the request from Origin Server.
  *
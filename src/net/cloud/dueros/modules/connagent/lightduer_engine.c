@@ -59,6 +59,14 @@ static duer_u32_t g_recv_timestamp = 0;
 #define DUER_RECV_TIMEOUT_THRESHOLD (DUER_KEEPALIVE_INTERVAL + 3000)
 #define DUER_COAP_EXEC_INTERVAL (5 * 1000)
 
+#ifdef DUER_VOICE_BINARY_UPLOAD
+// the binary voice reports are the only requests not carrying a JSON string
+static const char DUER_VOICE_REPORT_PATH[] = "v1/device/voice";
+#define DUER_MESSAGE_IS_VOICE(_m)   ((_m)->path == (duer_u8_t *)DUER_VOICE_REPORT_PATH)
+#else
+#define DUER_MESSAGE_IS_VOICE(_m)   (0)
+#endif
+
 static void duer_timer_expired(void *param)
 {
     duer_emitter_emit(duer_engine_timer_handler, 0, NULL);
@@ -293,7 +301,7 @@ void duer_engine_release_data(duer_msg_t *msg)
 {
     if (msg) {
         if (msg->payload != NULL) {
-            if (DUER_MESSAGE_IS_RESPONSE(msg->msg_code)) {
+            if (DUER_MESSAGE_IS_RESPONSE(msg->msg_code) || DUER_MESSAGE_IS_VOICE(msg)) {
                 DUER_FREE(msg->payload);
             } else {
                 baidu_json_release(msg->payload);
@@ -402,6 +410,72 @@ int duer_engine_enqueue_report_data(duer_context_t *context, const baidu_json *d
     return rs;
 }
 
+#ifdef DUER_VOICE_BINARY_UPLOAD
+/** return the cache length if success, or error code
+ */
+int duer_engine_enqueue_report_voice(duer_context_t *context, const void *data, duer_size_t size)
+{
+    int rs = DUER_ERR_INVALID_PARAMETER;
+    duer_u8_t *content = NULL;
+    duer_msg_t *msg = NULL;
+
+    do {
+        if (baidu_ca_is_started(g_handler) == DUER_FALSE) {
+            DUER_LOGW("duer_engine_send not started");
+            rs = DUER_ERR_CA_NOT_CONNECTED;
+            break;
+        }
+
+        if (data == NULL || size == 0 || g_qcache_handler == NULL || g_handler == NULL) {
+            break;
+        }
+
+        content = DUER_MALLOC(size);
+        if (content == NULL) {
+            rs = DUER_ERR_MEMORY_OVERLOW;
+            break;
+        }
+        DUER_MEMCPY(content, data, size);
+
+        msg = baidu_ca_build_report_message(g_handler, DUER_TRUE);
+        if (msg == NULL) {
+            rs = DUER_ERR_MEMORY_OVERLOW;
+            break;
+        }
+
+        msg->path = (duer_u8_t *)DUER_VOICE_REPORT_PATH;
+        msg->path_len = sizeof(DUER_VOICE_REPORT_PATH) - 1;
+        msg->payload = content;
+        msg->payload_len = size;
+
+        if (context != NULL) {
+            msg->context = DUER_MALLOC(sizeof(duer_context_t));
+            if (msg->context) {
+                DUER_MEMCPY(msg->context, context, sizeof(duer_context_t));
+            }
+        }
+
+        duer_mutex_lock(g_qcache_mutex);
+        rs = duer_qcache_push(g_qcache_handler, msg);
+        if (rs == DUER_OK) {
+            rs = duer_qcache_length(g_qcache_handler);
+        }
+        duer_mutex_unlock(g_qcache_mutex);
+    } while (0);
+
+    if (rs < 0) {
+        DUER_LOGE("Report voice failed: rs = %d", rs);
+        if (msg) {
+            duer_engine_release_data(msg);
+        } else if (content) {
+            DUER_FREE(content);
+        }
+    }
+
+    return rs;
+}
+#endif
+
 /** return the cache length if success, or error code
  */
 int duer_engine_enqueue_response(const duer_msg_t *req, int msg_code, const void *data, duer_size_t size)
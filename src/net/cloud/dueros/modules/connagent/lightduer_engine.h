@@ -56,6 +56,10 @@ void duer_engine_data_available(int what, void *object);
 
 int duer_engine_enqueue_report_data(duer_context_t *context, const baidu_json *data);
 
+#ifdef DUER_VOICE_BINARY_UPLOAD
+int duer_engine_enqueue_report_voice(duer_context_t *context, const void *data, duer_size_t size);
+#endif
+
 void duer_engine_send(int what, void *object);
 
 void duer_engine_stop(int what, void *object);
@@ -0,0 +1,26 @@
+#!/bin/sh
+#
+# Build lightduer_voice.c with baidu_json and base64 on the host, with and
+# without DUER_VOICE_BINARY_UPLOAD, and run the upload checks and counts.
+# A short run under AddressSanitizer follows. Arguments are passed to
+# voice_bench.
+#
+set -e
+cd "$(dirname "$0")"
+D=../../..
+build() {
+	gcc -O2 -Wall -pthread "$@" \
+		-I$D/framework/include -I$D/framework/core -I$D/platform/include \
+		-I$D/external/baidu_json -I$D/external/mbedtls/include \
+		-I$D/modules/connagent -I$D/modules/coap -I.. -I$D/modules/device_status \
+		voice_bench.c ../lightduer_voice.c ../lightduer_voice_ring.c ../lightduer_session.c \
+		$D/external/baidu_json/baidu_json.c $D/external/mbedtls/library/base64.c \
+		-lm -o /tmp/voice_bench
+}
+build -DDUER_VOICE_BINARY_UPLOAD
+/tmp/voice_bench "$@"
+build
+/tmp/voice_bench "$@"
+build -DDUER_VOICE_BINARY_UPLOAD -fsanitize=address -g
+/tmp/voice_bench 20 > /dev/null
+echo "PASS"
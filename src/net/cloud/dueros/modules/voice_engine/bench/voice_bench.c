@@ -0,0 +1,563 @@
+/**
+ * Copyright (2017) Baidu Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * File: voice_bench.c
+ * Desc: Linux benchmark of the voice upload formats.
+ *
+ * lightduer_voice.c and lightduer_voice_ring.c are built with baidu_json,
+ * the mbedtls base64 and the real session ids. The speex encoder is replaced
+ * by one that turns every 20 ms of PCM into a numbered frame of about
+ * BENCH_FRAME_LEN bytes, varying so that the segments end at every offset,
+ * and the connagent by a sender that completes the segment in flight after
+ * every duer_voice_send(), like a fast uplink.
+ *
+ *   voice_bench [seconds of audio]
+ *
+ * Every JSON report is parsed back and its base64 decoded, every binary
+ * segment has its header and length prefixed frames parsed, and the frames
+ * must come back whole, in order and once, in segments within the size
+ * limit of the format, with the segment numbers in
+ * sequence and eof on the last segment only. Prints the payload bytes,
+ * messages and allocations per second of audio and the CPU time of each
+ * format. Built without DUER_VOICE_BINARY_UPLOAD it checks that the binary
+ * format is refused and runs JSON only.
+ *
+ * Then DUER_VOICE_OVERFLOW_BLOCK runs with the uplink held back. The
+ * semaphore stub plays the CA thread: a wait completes the segments in
+ * flight, which must release the semaphore, or with the uplink stalled
+ * times out. Every wait must be woken by a release, and a stalled uplink
+ * must block once for DUER_VOICE_BLOCK_TIMEOUT and drop the newest segment.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "baidu_json.h"
+#include "lightduer_coap_defs.h"
+#include "lightduer_connagent.h"
+#include "lightduer_memory.h"
+#include "lightduer_mutex.h"
+#include "lightduer_semaphore.h"
+#include "lightduer_session.h"
+#include "lightduer_speex.h"
+#include "lightduer_types.h"
+#include "lightduer_voice.h"
+#include "mbedtls/base64.h"
+
+#define BENCH_RATE          (16000)
+#define BENCH_PCM_FRAME     (BENCH_RATE / 50 * 2)   // 20 ms of 16 bit samples
+#define BENCH_FRAME_LEN     (70)                    // 28 kbps speex wideband, mean
+#define BENCH_FRAME_VAR     (9)                     // lengths BENCH_FRAME_LEN -8..+8
+#define BENCH_SEND_FRAMES   (5)                     // 100 ms per duer_voice_send()
+#define BENCH_BIN_HEAD_LEN  (20)
+#define BENCH_BIN_MAX_LEN   (960)                   // DUER_VOICE_BIN_MAX_LEN
+#define BENCH_JSON_MAX_LEN  ((800 - 1) / 4 * 3)     // I_BUFFER_LEN
+#define BENCH_BLOCK_TIMEOUT (2000)                  // DUER_VOICE_BLOCK_TIMEOUT
+#define BENCH_RING_SLOTS    (16)                    // DUER_VOICE_RING_SLOTS
+
+extern int duer_voice_initialize(void);
+extern void duer_voice_finalize(void);
+
+static int s_errors;
+
+#define BENCH_CHECK(cond, fmt, ...)                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            printf("FAIL %s:%d: " fmt "\n", __func__, __LINE__,         \
+                   ##__VA_ARGS__);                                      \
+            s_errors++;                                                 \
+        }                                                               \
+    } while (0)
+
+typedef struct _bench_result_s {
+    const char *name;
+    duer_u32_t  frames;
+    duer_u32_t  speex;
+    duer_u32_t  messages;
+    duer_u32_t  bytes;
+    duer_u32_t  allocs;
+    double      cpu_us;
+} bench_result_t;
+
+static duer_u32_t s_timestamp;
+static int s_count_allocs;
+static duer_u32_t s_allocs;
+
+// encoder and receiver state
+static duer_u32_t s_encoded;        // frames out of the encoder
+static duer_u32_t s_speex_bytes;
+static size_t s_pcm_pending;
+static duer_u32_t s_received;       // frames parsed back
+static duer_u32_t s_segment;        // next segment expected
+static duer_u32_t s_topic;          // taken from the first segment
+static int s_eof_seen;
+static duer_context_t s_inflight;
+static int s_has_inflight;
+static bench_result_t *s_result;
+static int s_allow_gap;             // dropped segments leave gaps in the frames
+static duer_u32_t s_gaps;
+
+// the slot semaphore and the CA thread behind it
+static int s_sem_given;
+static int s_stalled;
+static duer_u32_t s_waits;
+static duer_u32_t s_wait_ok;
+
+static void bench_uplink(void);
+
+void duer_debug(duer_u32_t level, const char *file, duer_u32_t line, const char *fmt, ...)
+{
+}
+
+void *duer_malloc(duer_size_t size)
+{
+    s_allocs += s_count_allocs;
+    return malloc(size);
+}
+
+void duer_free(void *ptr)
+{
+    free(ptr);
+}
+
+duer_mutex_t duer_mutex_create(void)
+{
+    pthread_mutex_t *mutex = malloc(sizeof(*mutex));
+
+    pthread_mutex_init(mutex, NULL);
+    return mutex;
+}
+
+duer_status_t duer_mutex_lock(duer_mutex_t mutex)
+{
+    return pthread_mutex_lock(mutex) ? DUER_ERR_FAILED : DUER_OK;
+}
+
+duer_status_t duer_mutex_unlock(duer_mutex_t mutex)
+{
+    return pthread_mutex_unlock(mutex) ? DUER_ERR_FAILED : DUER_OK;
+}
+
+duer_status_t duer_mutex_destroy(duer_mutex_t mutex)
+{
+    pthread_mutex_destroy(mutex);
+    free(mutex);
+    return DUER_OK;
+}
+
+duer_u32_t duer_timestamp(void)
+{
+    return s_timestamp;
+}
+
+duer_semaphore_t duer_semaphore_create(void)
+{
+    static int sem;
+
+    return &sem;
+}
+
+duer_status_t duer_semaphore_wait(duer_semaphore_t sem, duer_u32_t timeout)
+{
+    s_waits++;
+    if (!s_sem_given && !s_stalled) {
+        // the CA thread gets the message out meanwhile
+        bench_uplink();
+    }
+    if (s_sem_given) {
+        s_sem_given = 0;
+        s_wait_ok++;
+        return DUER_OK;
+    }
+    s_timestamp += timeout;
+    return DUER_ERR_FAILED;
+}
+
+duer_status_t duer_semaphore_release(duer_semaphore_t sem)
+{
+    s_sem_given = 1;
+    return DUER_OK;
+}
+
+duer_status_t duer_semaphore_destroy(duer_semaphore_t sem)
+{
+    return DUER_OK;
+}
+
+duer_s32_t duer_random(void)
+{
+    return rand();
+}
+
+duer_status_t duer_ds_log_rec_start(duer_u32_t id)
+{
+    return DUER_OK;
+}
+
+duer_status_t duer_ds_log_rec_stop(duer_u32_t id)
+{
+    return DUER_OK;
+}
+
+void duer_ds_rec_delay_info_update(const duer_u32_t request, const duer_u32_t send_start,
+                                   const duer_size_t send_finish)
+{
+}
+
+duer_speex_handler duer_speex_create(int rate)
+{
+    static int handler;
+
+    return &handler;
+}
+
+void duer_speex_destroy(duer_speex_handler handler)
+{
+}
+
+static size_t bench_frame(duer_u32_t n, duer_u8_t *frame)
+{
+    size_t len = BENCH_FRAME_LEN + (n * 7) % (2 * BENCH_FRAME_VAR - 1) - (BENCH_FRAME_VAR - 1);
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        frame[i] = (duer_u8_t)(n * 131 + i * 7);
+    }
+    frame[0] = (duer_u8_t)(n >> 8);
+    frame[1] = (duer_u8_t)n;
+    return len;
+}
+
+void duer_speex_encode(duer_speex_handler handler, const void *data, size_t size,
+                       duer_encoded_func func)
+{
+    duer_u8_t frame[BENCH_FRAME_LEN + BENCH_FRAME_VAR];
+    size_t len;
+
+    // the real encoder pads and flushes the last partial frame
+    s_pcm_pending += data ? size : (s_pcm_pending ? BENCH_PCM_FRAME : 0);
+    while (s_pcm_pending >= BENCH_PCM_FRAME) {
+        s_pcm_pending -= BENCH_PCM_FRAME;
+        len = bench_frame(s_encoded++, frame);
+        s_speex_bytes += len;
+        func(frame, len);
+    }
+    s_pcm_pending = data ? s_pcm_pending : 0;
+}
+
+// the speex bytes of a segment must be the next frames, whole
+static void bench_check_frames(const duer_u8_t *data, size_t len, int prefixed)
+{
+    duer_u8_t frame[BENCH_FRAME_LEN + BENCH_FRAME_VAR];
+    size_t flen;
+    duer_u32_t n;
+
+    if (s_allow_gap && len >= (prefixed ? 4 : 2)) {
+        n = (data[prefixed ? 2 : 0] << 8) | data[prefixed ? 3 : 1];
+        if (n > s_received) {
+            s_gaps++;
+            s_received = n;
+        }
+    }
+
+    while (len > 0) {
+        flen = bench_frame(s_received, frame);
+        if (prefixed) {
+            BENCH_CHECK(len >= 2, "truncated length prefix");
+            if (len < 2) {
+                return;
+            }
+            BENCH_CHECK(flen == (size_t)((data[0] << 8) | data[1]),
+                        "frame %u prefixed with %u bytes", s_received, (data[0] << 8) | data[1]);
+            data += 2;
+            len -= 2;
+        }
+        BENCH_CHECK(len >= flen, "frame %u of %u bytes, %u left",
+                    s_received, (unsigned)flen, (unsigned)len);
+        if (len < flen) {
+            return;
+        }
+        BENCH_CHECK(memcmp(data, frame, flen) == 0, "frame %u differs", s_received);
+        s_received++;
+        data += flen;
+        len -= flen;
+    }
+}
+
+static void bench_check_segment(duer_u32_t id, duer_u32_t segment, duer_u32_t rate, int eof)
+{
+    if (s_segment == 0) {
+        BENCH_CHECK(id != s_topic, "topic id %u used twice", id);
+        s_topic = id;
+    }
+    BENCH_CHECK(id == s_topic, "topic %u, expected %u", id, s_topic);
+    BENCH_CHECK(segment == s_segment, "segment %u, expected %u", segment, s_segment);
+    BENCH_CHECK(rate == BENCH_RATE, "rate %u", rate);
+    BENCH_CHECK(!s_eof_seen, "segment %u after eof", segment);
+    s_segment = segment + 1;
+    s_eof_seen = eof;
+}
+
+static void bench_queue(duer_context_t *context, size_t bytes)
+{
+    BENCH_CHECK(!s_has_inflight, "two segments in flight");
+    s_inflight = *context;
+    s_has_inflight = 1;
+    s_result->messages++;
+    s_result->bytes += bytes;
+}
+
+int duer_data_report_async(duer_context_t *context, const baidu_json *data)
+{
+    baidu_json *voice = baidu_json_GetObjectItem((baidu_json *)data, "duer_voice");
+    baidu_json *item = NULL;
+    duer_u8_t speex[1024];
+    size_t len = 0;
+    char *text = NULL;
+    int counting = s_count_allocs;
+
+    // serializing is the engine's part of the cost, not counted here
+    s_count_allocs = 0;
+    text = baidu_json_PrintUnformatted(data);
+    BENCH_CHECK(voice != NULL && text != NULL, "no duer_voice object");
+    if (voice == NULL || text == NULL) {
+        s_count_allocs = counting;
+        return DUER_ERR_FAILED;
+    }
+
+    bench_check_segment(baidu_json_GetObjectItem(voice, "id")->valueint,
+                        baidu_json_GetObjectItem(voice, "segment")->valueint,
+                        baidu_json_GetObjectItem(voice, "rate")->valueint,
+                        baidu_json_GetObjectItem(voice, "eof")->valueint);
+    item = baidu_json_GetObjectItem(voice, "voice_data");
+    if (item) {
+        BENCH_CHECK(mbedtls_base64_decode(speex, sizeof(speex), &len,
+                                          (const unsigned char *)item->valuestring,
+                                          strlen(item->valuestring)) == 0, "bad base64");
+        BENCH_CHECK(len <= BENCH_JSON_MAX_LEN, "json segment of %u bytes", (unsigned)len);
+        bench_check_frames(speex, len, 0);
+    }
+    bench_queue(context, strlen(text));
+    DUER_FREE(text);
+    s_count_allocs = counting;
+    return DUER_OK;
+}
+
+static duer_u32_t bench_get_u32(const duer_u8_t *buf)
+{
+    return ((duer_u32_t)buf[0] << 24) | ((duer_u32_t)buf[1] << 16) | (buf[2] << 8) | buf[3];
+}
+
+int duer_voice_report_async(duer_context_t *context, const void *data, duer_size_t size)
+{
+    const duer_u8_t *buf = data;
+
+    BENCH_CHECK(size >= BENCH_BIN_HEAD_LEN && size <= BENCH_BIN_MAX_LEN,
+                "binary segment of %u bytes", (unsigned)size);
+    if (size < BENCH_BIN_HEAD_LEN) {
+        return DUER_ERR_FAILED;
+    }
+    BENCH_CHECK(buf[0] == 1 && (buf[1] & ~1) == 0 && buf[2] == DUER_VOICE_MODE_DEFAULT &&
+                buf[3] == 1, "header %02x %02x %02x %02x", buf[0], buf[1], buf[2], buf[3]);
+    bench_check_segment(bench_get_u32(buf + 4), bench_get_u32(buf + 8),
+                        bench_get_u32(buf + 12), buf[1] & 1);
+    BENCH_CHECK(bench_get_u32(buf + 16) <= s_timestamp, "timestamp in the future");
+    bench_check_frames(buf + BENCH_BIN_HEAD_LEN, size - BENCH_BIN_HEAD_LEN, 1);
+    bench_queue(context, size);
+    return DUER_OK;
+}
+
+// what the CA thread does when the CoAP message is out
+static void bench_uplink(void)
+{
+    duer_context_t context;
+
+    while (s_has_inflight) {
+        context = s_inflight;
+        s_has_inflight = 0;
+        context._on_report_start(&context);
+        context._on_report_finish(&context);
+    }
+}
+
+static void bench_run(bench_result_t *result, duer_voice_upload format, int seconds)
+{
+    static duer_u8_t pcm[BENCH_PCM_FRAME * BENCH_SEND_FRAMES];
+    duer_voice_ring_stat_t stat;
+    struct timespec t0, t1;
+    int i, sends = seconds * 50 / BENCH_SEND_FRAMES;
+
+    memset(result, 0, sizeof(*result));
+    result->name = format == DUER_VOICE_UPLOAD_BINARY ? "binary" : "json";
+    s_result = result;
+    s_encoded = s_received = s_segment = s_speex_bytes = 0;
+    s_eof_seen = 0;
+    s_pcm_pending = 0;
+
+    BENCH_CHECK(duer_voice_set_upload(format) == DUER_OK, "%s not accepted", result->name);
+    duer_voice_start(BENCH_RATE);
+    duer_voice_get_ring_stat(&stat, DUER_TRUE);
+
+    s_allocs = 0;
+    s_count_allocs = 1;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t0);
+    for (i = 0; i < sends; i++) {
+        s_timestamp += 1000 / 50 * BENCH_SEND_FRAMES;
+        duer_voice_send(pcm, sizeof(pcm));
+        bench_uplink();
+    }
+    duer_voice_stop();
+    bench_uplink();
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t1);
+    s_count_allocs = 0;
+
+    result->frames = s_encoded;
+    result->speex = s_speex_bytes;
+    result->allocs = s_allocs;
+    result->cpu_us = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / 1e3;
+
+    duer_voice_get_ring_stat(&stat, DUER_FALSE);
+    BENCH_CHECK(s_received == s_encoded, "%s: %u of %u frames received",
+                result->name, s_received, s_encoded);
+    BENCH_CHECK(s_eof_seen, "%s: no eof segment", result->name);
+    BENCH_CHECK(stat.dropped == 0 && stat.sent == s_segment, "%s: sent %u dropped %u of %u",
+                result->name, stat.sent, stat.dropped, s_segment);
+}
+
+static void bench_block(void)
+{
+    static duer_u8_t pcm[BENCH_PCM_FRAME * BENCH_SEND_FRAMES];
+    bench_result_t result;
+    duer_voice_ring_stat_t stat;
+    int i;
+
+    memset(&result, 0, sizeof(result));
+    result.name = "block";
+    s_result = &result;
+    s_encoded = s_received = s_segment = s_speex_bytes = 0;
+    s_eof_seen = 0;
+    s_pcm_pending = 0;
+    s_sem_given = 0;
+    s_waits = s_wait_ok = 0;
+
+    duer_voice_set_upload(DUER_VOICE_UPLOAD_JSON);
+    duer_voice_set_overflow(DUER_VOICE_OVERFLOW_BLOCK);
+    duer_voice_start(BENCH_RATE);
+    duer_voice_get_ring_stat(&stat, DUER_TRUE);
+
+    // the uplink runs only while duer_voice_send() waits
+    for (i = 0; i < BENCH_RING_SLOTS * 8; i++) {
+        s_timestamp += 1000 / 50 * BENCH_SEND_FRAMES;
+        duer_voice_send(pcm, sizeof(pcm));
+    }
+    duer_voice_get_ring_stat(&stat, DUER_TRUE);
+    BENCH_CHECK(s_waits > 0, "never blocked on a full ring");
+    BENCH_CHECK(s_wait_ok == s_waits, "%u of %u waits not woken by a release",
+                s_waits - s_wait_ok, s_waits);
+    BENCH_CHECK(stat.dropped == 0 && stat.blocked_ms == 0, "dropped %u, blocked %u ms",
+                stat.dropped, stat.blocked_ms);
+    printf("block   %u waits, all woken by a released slot\n", s_waits);
+
+    // no uplink at all, each commit on the full ring waits out the timeout
+    s_stalled = 1;
+    s_allow_gap = 1;
+    s_waits = s_wait_ok = 0;
+    for (i = 0; i < BENCH_RING_SLOTS * 2; i++) {
+        s_timestamp += 1000 / 50 * BENCH_SEND_FRAMES;
+        duer_voice_send(pcm, sizeof(pcm));
+    }
+    duer_voice_get_ring_stat(&stat, DUER_TRUE);
+    BENCH_CHECK(s_waits > 0 && s_wait_ok == 0, "stalled: %u of %u waits woken",
+                s_wait_ok, s_waits);
+    BENCH_CHECK(stat.dropped == s_waits && stat.blocked_ms == s_waits * BENCH_BLOCK_TIMEOUT,
+                "stalled: %u waits, dropped %u, blocked %u ms",
+                s_waits, stat.dropped, stat.blocked_ms);
+    printf("stalled %u waits of %u ms, %u newest segments dropped\n", s_waits,
+           stat.blocked_ms / (s_waits ? s_waits : 1), stat.dropped);
+
+    s_stalled = 0;
+    duer_voice_stop();
+    bench_uplink();
+    BENCH_CHECK(s_eof_seen, "block: no eof segment");
+    BENCH_CHECK(s_gaps > 0 && s_gaps <= s_waits, "block: %u gaps for %u dropped",
+                s_gaps, s_waits);
+
+    s_allow_gap = 0;
+    duer_voice_set_overflow(DUER_VOICE_OVERFLOW_DROP_NEWEST);
+}
+
+static void bench_print(const bench_result_t *r, int seconds)
+{
+    printf("%-7s %6.0f %8.2fx %6.1f %8.1f %8.1f\n", r->name, r->bytes / (double)seconds,
+           r->bytes / (double)r->speex, r->messages / (double)seconds, r->allocs / (double)seconds,
+           r->cpu_us / seconds);
+}
+
+int main(int argc, char *argv[])
+{
+    baidu_json_Hooks hooks = { duer_malloc, duer_free };
+    bench_result_t json;
+    int seconds = argc > 1 ? atoi(argv[1]) : 600;
+#ifdef DUER_VOICE_BINARY_UPLOAD
+    bench_result_t binary;
+#endif
+
+    baidu_json_InitHooks(&hooks);
+    duer_session_initialize();
+    duer_voice_initialize();
+
+    printf("%d s of %d Hz audio, %d+-%d byte speex frames (%d B/s)\n\n", seconds, BENCH_RATE,
+           BENCH_FRAME_LEN, BENCH_FRAME_VAR - 1, BENCH_FRAME_LEN * 50);
+    printf("format     B/s  vs speex  msg/s allocs/s  CPU us/s\n");
+
+    bench_run(&json, DUER_VOICE_UPLOAD_JSON, seconds);
+    bench_print(&json, seconds);
+
+#ifdef DUER_VOICE_BINARY_UPLOAD
+    bench_run(&binary, DUER_VOICE_UPLOAD_BINARY, seconds);
+    bench_print(&binary, seconds);
+
+    BENCH_CHECK(binary.bytes * 100 < json.bytes * 75, "binary %u bytes, json %u",
+                binary.bytes, json.bytes);
+    BENCH_CHECK(binary.bytes < (binary.speex + binary.frames * 2) * 1.05,
+                "binary overhead over the length prefixes above 5%%");
+    BENCH_CHECK(binary.messages < json.messages, "binary %u messages, json %u",
+                binary.messages, json.messages);
+    BENCH_CHECK(binary.allocs == 0, "binary path allocated %u times", binary.allocs);
+
+    // JSON again after binary, the ring keeps its slots
+    bench_run(&json, DUER_VOICE_UPLOAD_JSON, 1);
+#else
+    BENCH_CHECK(duer_voice_set_upload(DUER_VOICE_UPLOAD_BINARY) != DUER_OK,
+                "binary upload accepted without DUER_VOICE_BINARY_UPLOAD");
+    BENCH_CHECK(duer_voice_get_upload() == DUER_VOICE_UPLOAD_JSON, "upload format changed");
+#endif
+
+    printf("\n");
+    bench_block();
+
+    duer_voice_finalize();
+    duer_session_finalize();
+
+    if (s_errors) {
+        printf("%d errors\n", s_errors);
+        return 1;
+    }
+    return 0;
+}
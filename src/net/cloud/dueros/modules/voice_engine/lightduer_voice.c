@@ -39,8 +39,9 @@
 #include "lightduer_ds_log_recorder.h"
 #include "lightduer_timestamp.h"
 #include "lightduer_ds_log_e2e.h"
-#include "lightduer_queue_cache.h"
 #include "lightduer_mutex.h"
+#include "lightduer_semaphore.h"
+#include "lightduer_voice_ring.h"
 
 #ifdef ENABLE_DUER_STORE_VOICE
 #include "lightduer_store_voice.h"
@@ -50,14 +51,29 @@
 
 #define O_BUFFER_LEN        (800)
 #define I_BUFFER_LEN        ((O_BUFFER_LEN - 1) / 4 * 3)
-#define MAX_CACHED_VOICE_SEGMENTS ((5000) / ((O_BUFFER_LEN) / 4))
+
+/*
+ * The segments waiting for upload live in a ring allocated at the first
+ * duer_voice_start(), each slot takes about DUER_VOICE_SEG_MAX_LEN bytes.
+ * The encoder writes into the slot being filled, the JSON or binary payload
+ * is built when the segment is sent, so the queued segments hold no cJSON
+ * and the segment numbers have no gaps when some are dropped.
+ */
+#ifndef DUER_VOICE_RING_SLOTS
+#define DUER_VOICE_RING_SLOTS       (16)
+#endif
+
+// how long DUER_VOICE_OVERFLOW_BLOCK waits for a free slot, in ms
+#ifndef DUER_VOICE_BLOCK_TIMEOUT
+#define DUER_VOICE_BLOCK_TIMEOUT    (2000)
+#endif
 
 typedef struct _duer_topic_s {
     duer_u32_t  _id;
     duer_u32_t  _samplerate;
     duer_u32_t  _segment;
-    duer_bool   _eof;
-    duer_qcache_handler cache;
+    duer_u32_t  _committed;
+    duer_bool   _binary;
 } duer_topic_t;
 
 typedef struct _duer_voice_statistics {
@@ -69,16 +85,35 @@ typedef struct _duer_voice_statistics {
     duer_u32_t  _finish;
 } duer_vstat_t;
 
-typedef struct _duer_cache_item_s {
-    baidu_json *    value;
-    duer_context_t  context;
-} duer_cache_item_t;
+#ifdef DUER_VOICE_BINARY_UPLOAD
+/*
+ * Binary voice segment, multi-byte fields are big endian:
+ *
+ *   | ver:1 | flags:1 | mode:1 | channel:1 | id:4 | segment:4 | rate:4 | ts:4 |
+ *   | len:2 | speex frame | len:2 | speex frame | ...
+ *
+ * flags bit 0 is eof, mode is the duer_voice_mode. Without base64 and JSON,
+ * a segment carries about 1.6 times the speex data of a JSON one in fewer
+ * bytes. The header is filled in place when the segment is sent.
+ */
+#define DUER_VOICE_BIN_VERSION      (1)
+#define DUER_VOICE_BIN_FLAG_EOF     (0x01)
+#define DUER_VOICE_BIN_HEAD_LEN     (20)
+#define DUER_VOICE_BIN_MAX_LEN      (960)
+#define DUER_VOICE_SEG_MAX_LEN      DUER_VOICE_BIN_MAX_LEN
+#else
+#define DUER_VOICE_SEG_MAX_LEN      I_BUFFER_LEN
+#endif
 
 static duer_topic_t     g_topic;
 static duer_mutex_t     s_mutex;
+static duer_semaphore_t s_slot_sem = NULL;  // released when a slot frees
 
-static char     _data[I_BUFFER_LEN];
-static size_t   _size;
+static duer_voice_ring_t *s_voice_ring = NULL;
+static duer_voice_overflow s_voice_overflow = DUER_VOICE_OVERFLOW_DROP_NEWEST;
+static const duer_voice_spill_t *s_voice_spill = NULL;
+static duer_vstat_t     s_voice_stat;   // the segment in flight
+static char             s_voice_base64[O_BUFFER_LEN];
 
 static duer_speex_handler     _speex = NULL;
 
@@ -87,11 +122,14 @@ static duer_events_handler g_events_handler = NULL;
 #endif
 
 static duer_voice_mode s_voice_mode = DUER_VOICE_MODE_DEFAULT;
+static duer_voice_upload s_voice_upload = DUER_VOICE_UPLOAD_JSON;
 static duer_mutex_t s_func_mutex = NULL;
 
 static duer_u32_t s_voice_delay_threshold = (duer_u32_t)-1;
 static duer_voice_delay_func s_voice_delay_callback = NULL;
 
+static void duer_voice_send_next(void);
+
 static void local_mutex_lock(duer_bool status)
 {
     duer_status_t rs;
@@ -106,37 +144,28 @@ static void local_mutex_lock(duer_bool status)
     }
 }
 
-static void duer_cache_item_release(void *param)
+/*
+ * Wake duer_voice_commit() blocked on a full ring
+ */
+static void duer_voice_slot_freed(void)
 {
-    duer_cache_item_t *item = (duer_cache_item_t *)param;
-    if (item) {
-        if (item->value) {
-            baidu_json_Delete(item->value);
-            item->value = NULL;
-        }
-
-        if (item->context._param) {
-            DUER_FREE(item->context._param);
-            item->context._param = NULL;
-        }
-        DUER_FREE(item);
+    if (s_slot_sem) {
+        duer_semaphore_release(s_slot_sem);
     }
 }
 
 static int duer_request_send_start(duer_context_t *context)
 {
-    duer_vstat_t *stat = context ? context->_param : NULL;
+    duer_voice_seg_t *seg = context ? context->_param : NULL;
 
-    if (stat) {
+    if (seg) {
         local_mutex_lock(DUER_TRUE);
-        duer_cache_item_t *item = duer_qcache_top(g_topic.cache);
-        local_mutex_lock(DUER_FALSE);
-
-        if (item == NULL || item->context._param != stat) {
-            DUER_LOGE("The qcache is not matched, may be destroyed, stat:%p, item:%p", stat, item);
+        if (seg != duer_voice_ring_inflight(s_voice_ring)) {
+            DUER_LOGE("The voice segment is not in flight, may be reset, seg:%p", seg);
         } else {
-            stat->_start = duer_timestamp();
+            s_voice_stat._start = duer_timestamp();
         }
+        local_mutex_lock(DUER_FALSE);
     }
 
     return DUER_OK;
@@ -144,44 +173,39 @@ static int duer_request_send_start(duer_context_t *context)
 
 static int duer_request_send_finish(duer_context_t *context)
 {
-    duer_vstat_t *stat = context ? context->_param : NULL;
+    duer_voice_seg_t *seg = context ? context->_param : NULL;
+    duer_vstat_t stat;
     duer_u32_t delay = 0;
 
-    if (stat) {
-        local_mutex_lock(DUER_TRUE);
-        duer_cache_item_t *item = duer_qcache_pop(g_topic.cache);
+    if (seg == NULL) {
+        DUER_LOGE("No stat in the request!!!");
+        return DUER_OK;
+    }
+
+    local_mutex_lock(DUER_TRUE);
+    if (seg != duer_voice_ring_inflight(s_voice_ring)) {
         local_mutex_lock(DUER_FALSE);
+        DUER_LOGE("The voice segment is not in flight, may be reset, seg:%p", seg);
+        return DUER_OK;
+    }
 
-        if (item == NULL || item->context._param != stat) {
-            DUER_LOGE("The qcache is not matched, may be destroyed, item:%p, stat:%p", item, stat);
-        } else {
-            stat->_finish = duer_timestamp();
-            delay = stat->_finish - stat->_request;
+    s_voice_stat._finish = duer_timestamp();
+    DUER_MEMCPY(&stat, &s_voice_stat, sizeof(stat));
 
-            DUER_LOGD("id: %d, segment: %d, eof: %d, request: %u, start: %u, finish: %u, send delay: %u, sent usage: %u", stat->_topic_id, stat->_segment, stat->_eof, stat->_request, stat->_start, stat->_finish, stat->_start - stat->_request, stat->_finish - stat->_start);
-            duer_ds_rec_delay_info_update(stat->_request, stat->_start, stat->_finish);
+    duer_voice_ring_release(s_voice_ring, DUER_TRUE);
+    duer_voice_send_next();
+    local_mutex_lock(DUER_FALSE);
+    duer_voice_slot_freed();
 
-            duer_ds_e2e_update_latest_request(DUER_E2E_SENT, stat->_segment);
+    delay = stat._finish - stat._request;
 
-            if (delay > s_voice_delay_threshold && s_voice_delay_callback) {
-                s_voice_delay_callback(stat->_finish - stat->_request);
-            }
+    DUER_LOGD("id: %d, segment: %d, eof: %d, request: %u, start: %u, finish: %u, send delay: %u, sent usage: %u", stat._topic_id, stat._segment, stat._eof, stat._request, stat._start, stat._finish, stat._start - stat._request, stat._finish - stat._start);
+    duer_ds_rec_delay_info_update(stat._request, stat._start, stat._finish);
 
-            duer_cache_item_release(item);
+    duer_ds_e2e_update_latest_request(DUER_E2E_SENT, stat._segment);
 
-            local_mutex_lock(DUER_TRUE);
-            item = duer_qcache_top(g_topic.cache);
-            if (item) {
-                duer_data_report_async(&(item->context), item->value);
-                if (item->value) {
-                    baidu_json_Delete(item->value);
-                    item->value = NULL;
-                }
-            }
-            local_mutex_lock(DUER_FALSE);
-        }
-    } else {
-        DUER_LOGE("No stat in the request!!!");
+    if (delay > s_voice_delay_threshold && s_voice_delay_callback) {
+        s_voice_delay_callback(delay);
     }
 
     return DUER_OK;
@@ -215,161 +239,236 @@ void duer_add_translate_flag(baidu_json *data)
     }
 }
 
-static int duer_send_content(const void *data, size_t size, int eof)
+static int duer_send_content(duer_context_t *context, const duer_voice_seg_t *seg)
 {
     baidu_json *voice = NULL;
     baidu_json *value = NULL;
-    duer_vstat_t * stat = NULL;
-    duer_u32_t timestamp;
-    duer_cache_item_t *item = NULL;
-    duer_cache_item_t *top = NULL;
-    int voice_segments_num = 0;
-
-    int rs = DUER_ERR_FAILED;;
+    int rs = DUER_ERR_FAILED;
     size_t olen;
-    char buff[O_BUFFER_LEN];
 
     DUER_LOGV("duer_send_content ==>");
-    local_mutex_lock(DUER_TRUE);
-    voice_segments_num = duer_qcache_length(g_topic.cache);
-    local_mutex_lock(DUER_FALSE);
-
-    if (voice_segments_num > MAX_CACHED_VOICE_SEGMENTS) {
-        // ignore the voice data
-        DUER_LOGW("too many voice segmetns cached, max:%d!!!", MAX_CACHED_VOICE_SEGMENTS);
-        return rs;
-    }
 
     do {
-        g_topic._eof = eof || data == NULL || size == 0;
-
-        if (data != NULL && size > 0) {
-#ifdef ENABLE_DUER_STORE_VOICE
-            duer_store_speex_write(data, size);
-#endif // ENABLE_DUER_STORE_VOICE
+        if (seg->len > 0) {
             rs = mbedtls_base64_encode(
-                                       (unsigned char *)buff,
+                                       (unsigned char *)s_voice_base64,
                                        O_BUFFER_LEN,
                                        &olen,
-                                       (const unsigned char *)data, size);
+                                       seg->data, seg->len);
             if (rs < 0) {
                 DUER_LOGE("Encode the speex data failed: rs = %d", rs);
                 break;
             }
         }
 
-        timestamp = duer_timestamp();
-
-        item = DUER_MALLOC(sizeof(duer_cache_item_t));
-        if (item == NULL) {
-            DUER_LOGE("Memory overflow!!!");
-            break;
-        }
-        DUER_MEMSET(item, 0, sizeof(duer_cache_item_t));
-
         voice = baidu_json_CreateObject();
         if (voice == NULL) {
             DUER_LOGE("Memory overflow!!!");
+            rs = DUER_ERR_MEMORY_OVERLOW;
             break;
         }
 
         value = baidu_json_CreateObject();
         if (value == NULL) {
             DUER_LOGE("Memory overflow!!!");
+            rs = DUER_ERR_MEMORY_OVERLOW;
             break;
         }
 
-        stat = DUER_MALLOC(sizeof(duer_vstat_t));
-        if (stat) {
-            DUER_MEMSET(stat, 0, sizeof(duer_vstat_t));
-            stat->_request = timestamp;
-            stat->_topic_id = g_topic._id;
-            stat->_segment = g_topic._segment;
-            stat->_eof = g_topic._eof;
-
-            duer_ds_e2e_update_latest_request(DUER_E2E_REQUEST, stat->_segment);
-        } else {
-            DUER_LOGE("Memory overflow!!!");
-        }
-
         baidu_json_AddNumberToObject(voice, "id", g_topic._id);
-        baidu_json_AddNumberToObject(voice, "segment", g_topic._segment++);
+        baidu_json_AddNumberToObject(voice, "segment", s_voice_stat._segment);
         baidu_json_AddNumberToObject(voice, "rate", g_topic._samplerate);
         baidu_json_AddNumberToObject(voice, "channel", 1);
-        baidu_json_AddNumberToObject(voice, "eof", g_topic._eof ? 1 : 0);
+        baidu_json_AddNumberToObject(voice, "eof", seg->eof ? 1 : 0);
         duer_add_translate_flag(voice);
 
-        baidu_json_AddNumberToObject(voice, "ts", timestamp);
+        baidu_json_AddNumberToObject(voice, "ts", seg->ts);
 
-        if (data != NULL && size > 0) {
-            baidu_json_AddStringToObject(voice, "voice_data", buff);
+        if (seg->len > 0) {
+            baidu_json_AddStringToObject(voice, "voice_data", s_voice_base64);
         }
 
         baidu_json_AddItemToObject(value, "duer_voice", voice);
         voice = NULL;
 
-        item->context._param = stat;
-        item->context._on_report_start = duer_request_send_start;
-        item->context._on_report_finish = duer_request_send_finish;
+        rs = duer_data_report_async(context, value);
+    } while (0);
 
-        local_mutex_lock(DUER_TRUE);
-        top = duer_qcache_top(g_topic.cache);
-        rs = duer_qcache_push(g_topic.cache, item);
-        local_mutex_lock(DUER_FALSE);
+    DUER_LOGV("duer_send_content <== rs = %d", rs);
+
+    if (voice != NULL) {
+        baidu_json_Delete(voice);
+    }
+
+    if (value != NULL) {
+        baidu_json_Delete(value);
+    }
+
+    return rs;
+}
+
+#ifdef DUER_VOICE_BINARY_UPLOAD
+static void duer_voice_put_u32(duer_u8_t *buf, duer_u32_t value)
+{
+    buf[0] = (duer_u8_t)(value >> 24);
+    buf[1] = (duer_u8_t)(value >> 16);
+    buf[2] = (duer_u8_t)(value >> 8);
+    buf[3] = (duer_u8_t)value;
+}
+
+static int duer_send_binary(duer_context_t *context, duer_voice_seg_t *seg)
+{
+    duer_u8_t *buf = seg->data;
+
+    buf[0] = DUER_VOICE_BIN_VERSION;
+    buf[1] = seg->eof ? DUER_VOICE_BIN_FLAG_EOF : 0;
+    buf[2] = (duer_u8_t)s_voice_mode;
+    buf[3] = 1;
+    duer_voice_put_u32(buf + 4, g_topic._id);
+    duer_voice_put_u32(buf + 8, s_voice_stat._segment);
+    duer_voice_put_u32(buf + 12, g_topic._samplerate);
+    duer_voice_put_u32(buf + 16, seg->ts);
+
+    return duer_voice_report_async(context, seg->data, seg->len);
+}
+#endif // DUER_VOICE_BINARY_UPLOAD
+
+/*
+ * Send the oldest segment if none is in flight, called with s_mutex locked
+ */
+static void duer_voice_send_next(void)
+{
+    duer_voice_seg_t *seg = NULL;
+    duer_context_t context;
+    int rs;
+
+    while (duer_voice_ring_inflight(s_voice_ring) == NULL
+            && (seg = duer_voice_ring_front(s_voice_ring)) != NULL) {
+        DUER_MEMSET(&s_voice_stat, 0, sizeof(s_voice_stat));
+        s_voice_stat._request = seg->ts;
+        s_voice_stat._topic_id = g_topic._id;
+        s_voice_stat._segment = g_topic._segment++;
+        s_voice_stat._eof = seg->eof;
+        duer_ds_e2e_update_latest_request(DUER_E2E_REQUEST, s_voice_stat._segment);
+
+        DUER_MEMSET(&context, 0, sizeof(context));
+        context._param = seg;
+        context._on_report_start = duer_request_send_start;
+        context._on_report_finish = duer_request_send_finish;
+
+#ifdef DUER_VOICE_BINARY_UPLOAD
+        if (g_topic._binary) {
+            rs = duer_send_binary(&context, seg);
+        } else
+#endif
+        {
+            rs = duer_send_content(&context, seg);
+        }
 
         if (rs < DUER_OK) {
-            DUER_LOGE("send segment %d fail for topic_id:%d!", g_topic._segment, g_topic._id);
+            DUER_LOGE("send segment %d fail for topic_id:%d", s_voice_stat._segment, g_topic._id);
             --g_topic._segment;
-            break;
+            duer_voice_ring_release(s_voice_ring, DUER_FALSE);
         }
+    }
+}
 
-        if (top == NULL) {
-            rs = duer_data_report_async(&(item->context), value);
-            if (rs < DUER_OK) {
-                DUER_LOGE("send segment %d fail for topic_id:%d", g_topic._segment, g_topic._id);
-                local_mutex_lock(DUER_TRUE);
-                duer_qcache_pop(g_topic.cache);
-                local_mutex_lock(DUER_FALSE);
-                --g_topic._segment;
-                break;
-            }
-        } else {
-            item->value = value;
-            value = NULL;
-        }
+static size_t duer_voice_seg_limit(void)
+{
+    return g_topic._binary ? duer_voice_ring_capacity(s_voice_ring) : I_BUFFER_LEN;
+}
 
-        item = NULL;
-    } while (0);
+/*
+ * The segment being filled, called with s_mutex locked
+ */
+static duer_voice_seg_t *duer_voice_producer(void)
+{
+    duer_voice_seg_t *seg = duer_voice_ring_producer(s_voice_ring);
 
-    DUER_LOGV("duer_send_content <== rs = %d", rs);
+#ifdef DUER_VOICE_BINARY_UPLOAD
+    // room for the header written by duer_send_binary()
+    if (g_topic._binary && seg->len < DUER_VOICE_BIN_HEAD_LEN) {
+        seg->len = DUER_VOICE_BIN_HEAD_LEN;
+    }
+#endif
 
-    if (value != NULL) {
-        baidu_json_Delete(value);
+    return seg;
+}
+
+/*
+ * Queue the segment being filled, called with s_mutex locked
+ */
+static void duer_voice_commit(duer_bool eof)
+{
+    duer_voice_seg_t *seg = duer_voice_ring_producer(s_voice_ring);
+    duer_u32_t begin;
+    duer_u32_t waited = 0;
+
+    if (s_voice_overflow == DUER_VOICE_OVERFLOW_BLOCK && s_slot_sem
+            && duer_voice_ring_full(s_voice_ring)) {
+        // the sender releases the slots from the CA thread
+        begin = duer_timestamp();
+        do {
+            local_mutex_lock(DUER_FALSE);
+            duer_semaphore_wait(s_slot_sem, DUER_VOICE_BLOCK_TIMEOUT - waited);
+            local_mutex_lock(DUER_TRUE);
+            waited = duer_timestamp() - begin;
+        } while (duer_voice_ring_full(s_voice_ring) && waited < DUER_VOICE_BLOCK_TIMEOUT);
+        duer_voice_ring_add_blocked(s_voice_ring, waited);
     }
 
-    if (item != NULL) {
-        if (item->value) {
-            baidu_json_Delete(item->value);
-        }
-        if (item->context._param) {
-            DUER_FREE(item->context._param);
-        }
-        DUER_FREE(item);
+    seg->ts = duer_timestamp();
+    seg->eof = eof ? 1 : 0;
+    g_topic._committed++;
+
+    if (duer_voice_ring_commit(s_voice_ring, s_voice_overflow) != DUER_OK) {
+        DUER_LOGW("too many voice segments cached, max:%d, drop the newest!!!", DUER_VOICE_RING_SLOTS);
     }
 
-    return rs;
+    duer_voice_send_next();
 }
 
 static void duer_speex_encoded_callback(const void *data, size_t size)
 {
-    //DUER_LOGI("_size + size:%d, I_BUFFER_LEN:%d", _size + size, I_BUFFER_LEN);
-    if (_size + size > I_BUFFER_LEN) {
-        duer_send_content(_data, _size, 0);
-        _size = 0;
+    duer_voice_seg_t *seg = NULL;
+    size_t limit = duer_voice_seg_limit();
+    size_t need = size;
+
+#ifdef DUER_VOICE_BINARY_UPLOAD
+    if (g_topic._binary) {
+        need += 2;
+        if (need > limit - DUER_VOICE_BIN_HEAD_LEN) {
+            DUER_LOGE("speex frame too large: %d", size);
+            return;
+        }
     }
+#endif
+    if (need > limit) {
+        DUER_LOGE("speex frame too large: %d", size);
+        return;
+    }
+
+#ifdef ENABLE_DUER_STORE_VOICE
+    duer_store_speex_write(data, size);
+#endif // ENABLE_DUER_STORE_VOICE
 
-    DUER_MEMCPY(_data + _size, data, size);
-    _size += size;
+    local_mutex_lock(DUER_TRUE);
+    seg = duer_voice_producer();
+    //DUER_LOGI("seg->len + need:%d, limit:%d", seg->len + need, limit);
+    if (seg->len + need > limit) {
+        duer_voice_commit(DUER_FALSE);
+        seg = duer_voice_producer();
+    }
+
+#ifdef DUER_VOICE_BINARY_UPLOAD
+    if (g_topic._binary) {
+        seg->data[seg->len++] = (duer_u8_t)(size >> 8);
+        seg->data[seg->len++] = (duer_u8_t)size;
+    }
+#endif
+    DUER_MEMCPY(seg->data + seg->len, data, size);
+    seg->len += size;
+    local_mutex_lock(DUER_FALSE);
 }
 
 size_t duer_increase_topic_id(void)
@@ -379,15 +478,12 @@ size_t duer_increase_topic_id(void)
 
 static void duer_voice_terminate_internal(int what, void *object)
 {
-    //duer_cache_item_t *top = NULL; //unused
     duer_session_consume(g_topic._id);
 
     local_mutex_lock(DUER_TRUE);
-    if (g_topic.cache) {
-        duer_qcache_destroy_traverse(g_topic.cache, duer_cache_item_release);
-        g_topic.cache = NULL;
-    }
+    duer_voice_ring_reset(s_voice_ring);
     local_mutex_lock(DUER_FALSE);
+    duer_voice_slot_freed();
 }
 
 static void duer_voice_start_internal(int what, void *object)
@@ -403,14 +499,26 @@ static void duer_voice_start_internal(int what, void *object)
     g_topic._samplerate = what;
     g_topic._id = duer_session_generate();
     g_topic._segment = 0;
-    g_topic._eof = DUER_FALSE;
+    g_topic._committed = 0;
+    g_topic._binary = DUER_FALSE;
+
     local_mutex_lock(DUER_TRUE);
-    g_topic.cache = duer_qcache_create();
+    if (s_voice_ring == NULL) {
+        s_voice_ring = duer_voice_ring_create(DUER_VOICE_RING_SLOTS, DUER_VOICE_SEG_MAX_LEN);
+        duer_voice_ring_set_spill(s_voice_ring, s_voice_spill);
+    }
     local_mutex_lock(DUER_FALSE);
 
-    _speex = duer_speex_create(g_topic._samplerate);
+    if (s_voice_ring == NULL) {
+        DUER_LOGE("no memory for voice segments!!!");
+        return;
+    }
 
-    _size = 0;
+#ifdef DUER_VOICE_BINARY_UPLOAD
+    g_topic._binary = s_voice_upload == DUER_VOICE_UPLOAD_BINARY;
+#endif
+
+    _speex = duer_speex_create(g_topic._samplerate);
 
     duer_ds_log_rec_start(g_topic._id);
 #ifdef ENABLE_DUER_STORE_VOICE
@@ -440,15 +548,25 @@ static void duer_voice_send_internal(int what, void *object)
 
 static void duer_voice_stop_internal(int what, void *object)
 {
+    duer_voice_seg_t *seg = NULL;
+    size_t empty = 0;
+
     if (_speex) {
         if (duer_session_is_matched(g_topic._id) == DUER_TRUE) {
             duer_speex_encode(_speex, NULL, 0, duer_speex_encoded_callback);
 
-            if (_size > 0 || g_topic._segment > 0) {
-                duer_send_content(_data, _size, 1);
+#ifdef DUER_VOICE_BINARY_UPLOAD
+            if (g_topic._binary) {
+                empty = DUER_VOICE_BIN_HEAD_LEN;
+            }
+#endif
+            local_mutex_lock(DUER_TRUE);
+            seg = duer_voice_producer();
+            if (seg->len > empty || g_topic._committed > 0) {
+                duer_voice_commit(DUER_TRUE);
             }
+            local_mutex_lock(DUER_FALSE);
         }
-        _size = 0;
 
         duer_ds_log_rec_stop(g_topic._id);
 
@@ -504,6 +622,10 @@ int duer_voice_initialize(void)
         s_func_mutex = duer_mutex_create();
     }
 
+    if (s_slot_sem == NULL) {
+        s_slot_sem = duer_semaphore_create();
+    }
+
     return DUER_OK;
 }
 
@@ -525,6 +647,16 @@ void duer_voice_finalize(void)
         duer_mutex_destroy(s_func_mutex);
         s_func_mutex = NULL;
     }
+
+    if (s_slot_sem != NULL) {
+        duer_semaphore_destroy(s_slot_sem);
+        s_slot_sem = NULL;
+    }
+
+    if (s_voice_ring != NULL) {
+        duer_voice_ring_destroy(s_voice_ring);
+        s_voice_ring = NULL;
+    }
 }
 
 void duer_voice_set_delay_threshold(duer_u32_t delay, duer_voice_delay_func func)
@@ -543,6 +675,57 @@ duer_voice_mode duer_voice_get_mode(void)
     return s_voice_mode;
 }
 
+int duer_voice_set_upload(duer_voice_upload format)
+{
+#ifndef DUER_VOICE_BINARY_UPLOAD
+    if (format == DUER_VOICE_UPLOAD_BINARY) {
+        DUER_LOGW("binary voice upload is not built in");
+        return DUER_ERR_FAILED;
+    }
+#endif
+    s_voice_upload = format;
+    return DUER_OK;
+}
+
+duer_voice_upload duer_voice_get_upload(void)
+{
+    return s_voice_upload;
+}
+
+void duer_voice_set_overflow(duer_voice_overflow policy)
+{
+    s_voice_overflow = policy;
+}
+
+duer_voice_overflow duer_voice_get_overflow(void)
+{
+    return s_voice_overflow;
+}
+
+void duer_voice_set_spill(const duer_voice_spill_t *spill)
+{
+    local_mutex_lock(DUER_TRUE);
+    s_voice_spill = spill;
+    duer_voice_ring_set_spill(s_voice_ring, spill);
+    local_mutex_lock(DUER_FALSE);
+}
+
+int duer_voice_get_ring_stat(duer_voice_ring_stat_t *stat, duer_bool clear)
+{
+    if (stat == NULL || s_voice_ring == NULL) {
+        return DUER_ERR_FAILED;
+    }
+
+    local_mutex_lock(DUER_TRUE);
+    duer_voice_ring_get_stat(s_voice_ring, stat);
+    if (clear) {
+        duer_voice_ring_clear_stat(s_voice_ring);
+    }
+    local_mutex_lock(DUER_FALSE);
+
+    return DUER_OK;
+}
+
 int duer_voice_start(int samplerate)
 {
     return duer_events_call_internal(duer_voice_start_internal, samplerate, NULL);
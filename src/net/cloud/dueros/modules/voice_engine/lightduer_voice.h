@@ -20,6 +20,7 @@
  */
 
 #include "baidu_json.h"
+#include "lightduer_voice_ring.h"
 
 #ifndef BAIDU_DUER_LIGHTDUER_INCLUDE_LIGHTDUER_VOICE_H
 #define BAIDU_DUER_LIGHTDUER_INCLUDE_LIGHTDUER_VOICE_H
@@ -37,6 +38,15 @@ typedef enum _duer_voice_mode_enum {
     DUER_VOICE_MODE_INTERACTIVE_CLASS,
 } duer_voice_mode;
 
+/*
+ * How the speex segments are uploaded, DUER_VOICE_UPLOAD_BINARY needs the
+ * SDK built with DUER_VOICE_BINARY_UPLOAD, otherwise JSON is used.
+ */
+typedef enum _duer_voice_upload_enum {
+    DUER_VOICE_UPLOAD_JSON,     // base64 voice in a duer_voice JSON object
+    DUER_VOICE_UPLOAD_BINARY,   // length prefixed speex frames, see lightduer_voice.c
+} duer_voice_upload;
+
 typedef void (*duer_voice_delay_func)(duer_u32_t);
 
 void duer_voice_set_delay_threshold(duer_u32_t delay, duer_voice_delay_func);
@@ -45,6 +55,46 @@ void duer_voice_set_mode(duer_voice_mode mode);
 
 duer_voice_mode duer_voice_get_mode(void);
 
+/*
+ * Select the upload format, it takes effect from the next duer_voice_start()
+ *
+ * * Return: DUER_OK        Success
+ *           DUER_ERR_FAILED The format is not built in
+ */
+int duer_voice_set_upload(duer_voice_upload format);
+
+duer_voice_upload duer_voice_get_upload(void);
+
+/*
+ * Select what to do when the uplink is slower than the recording and all the
+ * DUER_VOICE_RING_SLOTS segments are waiting, DUER_VOICE_OVERFLOW_DROP_NEWEST
+ * by default. DUER_VOICE_OVERFLOW_BLOCK stalls duer_voice_send() up to
+ * DUER_VOICE_BLOCK_TIMEOUT ms until the sender frees a slot, it needs the
+ * platform semaphore and drops the newest segment without one.
+ * DUER_VOICE_OVERFLOW_SPILL needs a spill store and drops the oldest segment
+ * when it fails.
+ */
+void duer_voice_set_overflow(duer_voice_overflow policy);
+
+duer_voice_overflow duer_voice_get_overflow(void);
+
+/*
+ * Set the spill store on SD card or flash, call it before recording,
+ * the spill pointer should be valid until it is replaced
+ */
+void duer_voice_set_spill(const duer_voice_spill_t *spill);
+
+/*
+ * Get the fill level and the counters of the voice segment ring
+ *
+ * @Param stat, the statistics
+ * @Param clear, reset the counters after read
+ *
+ * * Return: DUER_OK        Success
+ *           DUER_ERR_FAILED Nothing recorded yet
+ */
+int duer_voice_get_ring_stat(duer_voice_ring_stat_t *stat, duer_bool clear);
+
 int duer_voice_start(int samplerate);
 
 int duer_voice_send(const void *data, size_t size);
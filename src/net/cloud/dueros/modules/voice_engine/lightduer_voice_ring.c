@@ -0,0 +1,306 @@
+/**
+ * Copyright (2017) Baidu Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * File: lightduer_voice_ring.c
+ * Desc: Fixed footprint ring of the voice segments waiting for upload.
+ *
+ * The slots are allocated once: `slots` for the pending segments, one being
+ * filled by the encoder and one to restore the spilled segments. The pending
+ * segments are kept in order[] by age, the spilled ones are always older than
+ * them, so they are sent first. The ring is not locked, the caller serializes
+ * the producer and the sender.
+ */
+
+#include "lightduer_voice_ring.h"
+
+#include "lightduer_log.h"
+#include "lightduer_memory.h"
+#include "lightduer_lib.h"
+
+#define DUER_VOICE_RING_MAX_SLOTS   (254)
+
+struct _duer_voice_ring_s {
+    duer_u8_t  *slab;
+    size_t      stride;
+    size_t      capacity;
+    duer_u8_t   slots;
+    duer_u8_t   count;          // pending segments in order[]
+    duer_u8_t   filling;
+    duer_u8_t   restore;
+    duer_u8_t  *order;
+    duer_u8_t  *used;
+    duer_voice_seg_t   *inflight;
+    const duer_voice_spill_t *spill;
+    duer_voice_ring_stat_t stat;
+};
+
+#define RING_SEG(_r, _i)    ((duer_voice_seg_t *)((_r)->slab + (_i) * (_r)->stride))
+
+duer_voice_ring_t *duer_voice_ring_create(size_t slots, size_t capacity)
+{
+    duer_voice_ring_t *ring = NULL;
+    size_t stride;
+    size_t index_len;
+    size_t size;
+
+    if (slots == 0 || slots > DUER_VOICE_RING_MAX_SLOTS || capacity == 0 || capacity > 0xFFFF) {
+        DUER_LOGE("invalid ring: slots = %d, capacity = %d", slots, capacity);
+        return NULL;
+    }
+
+    stride = (DUER_VOICE_SEG_HEAD_LEN + capacity + 3) & ~(size_t)3;
+    // order[slots] and used[slots + 1], the restore slot is never in used[]
+    index_len = (slots * 2 + 1 + 3) & ~(size_t)3;
+    size = ((sizeof(duer_voice_ring_t) + 3) & ~(size_t)3) + index_len + stride * (slots + 2);
+
+    ring = DUER_MALLOC(size);
+    if (ring == NULL) {
+        DUER_LOGE("Memory overflow!!!");
+        return NULL;
+    }
+    DUER_MEMSET(ring, 0, size);
+
+    ring->order = (duer_u8_t *)ring + ((sizeof(duer_voice_ring_t) + 3) & ~(size_t)3);
+    ring->used = ring->order + slots;
+    ring->slab = ring->order + index_len;
+    ring->stride = stride;
+    ring->capacity = capacity;
+    ring->slots = (duer_u8_t)slots;
+    ring->filling = 0;
+    ring->used[0] = 1;
+    ring->restore = (duer_u8_t)(slots + 1);
+    ring->stat.slots = slots;
+
+    return ring;
+}
+
+void duer_voice_ring_destroy(duer_voice_ring_t *ring)
+{
+    if (ring) {
+        DUER_FREE(ring);
+    }
+}
+
+void duer_voice_ring_set_spill(duer_voice_ring_t *ring, const duer_voice_spill_t *spill)
+{
+    if (ring) {
+        ring->spill = spill;
+    }
+}
+
+size_t duer_voice_ring_capacity(duer_voice_ring_t *ring)
+{
+    return ring ? ring->capacity : 0;
+}
+
+duer_voice_seg_t *duer_voice_ring_producer(duer_voice_ring_t *ring)
+{
+    return ring ? RING_SEG(ring, ring->filling) : NULL;
+}
+
+duer_bool duer_voice_ring_full(duer_voice_ring_t *ring)
+{
+    return ring && ring->count >= ring->slots ? DUER_TRUE : DUER_FALSE;
+}
+
+static void duer_voice_ring_remove(duer_voice_ring_t *ring, int pos)
+{
+    ring->used[ring->order[pos]] = 0;
+    ring->count--;
+    DUER_MEMMOVE(ring->order + pos, ring->order + pos + 1, ring->count - pos);
+    ring->stat.fill = ring->count;
+}
+
+/*
+ * Position of the oldest pending segment that is not in flight, or -1
+ */
+static int duer_voice_ring_victim(duer_voice_ring_t *ring)
+{
+    int pos = 0;
+
+    if (ring->count > 0 && ring->inflight == RING_SEG(ring, ring->order[0])) {
+        pos = 1;
+    }
+
+    return pos < ring->count ? pos : -1;
+}
+
+int duer_voice_ring_commit(duer_voice_ring_t *ring, duer_voice_overflow policy)
+{
+    duer_voice_seg_t *seg = NULL;
+    duer_voice_seg_t *victim = NULL;
+    int pos;
+    int i;
+
+    if (ring == NULL) {
+        return DUER_ERR_FAILED;
+    }
+
+    seg = RING_SEG(ring, ring->filling);
+
+    if (ring->count >= ring->slots) {
+        pos = duer_voice_ring_victim(ring);
+        victim = pos >= 0 ? RING_SEG(ring, ring->order[pos]) : NULL;
+
+        if (policy == DUER_VOICE_OVERFLOW_SPILL && victim && ring->spill && ring->spill->write
+                && ring->spill->write(victim, DUER_VOICE_SEG_HEAD_LEN + victim->len) == DUER_OK) {
+            ring->stat.spilled++;
+            ring->stat.spill_fill++;
+        } else if (victim && ((policy != DUER_VOICE_OVERFLOW_DROP_NEWEST
+                    && policy != DUER_VOICE_OVERFLOW_BLOCK) || seg->eof)) {
+            // a spill failure drops the oldest too, the eof segment is never dropped
+            ring->stat.dropped++;
+        } else {
+            ring->stat.dropped++;
+            seg->len = 0;
+            seg->eof = 0;
+            return DUER_ERR_FAILED;
+        }
+        duer_voice_ring_remove(ring, pos);
+    }
+
+    ring->order[ring->count++] = ring->filling;
+    for (i = 0; i <= ring->slots; i++) {
+        if (!ring->used[i]) {
+            break;
+        }
+    }
+    // count <= slots, so one of the slots + 1 entries is free
+    ring->used[i] = 1;
+    ring->filling = (duer_u8_t)i;
+    seg = RING_SEG(ring, i);
+    seg->len = 0;
+    seg->eof = 0;
+
+    ring->stat.committed++;
+    ring->stat.fill = ring->count;
+    ring->stat.fill_sum += ring->count;
+    if (ring->count > ring->stat.fill_max) {
+        ring->stat.fill_max = ring->count;
+    }
+
+    return DUER_OK;
+}
+
+duer_voice_seg_t *duer_voice_ring_front(duer_voice_ring_t *ring)
+{
+    duer_voice_seg_t *seg = NULL;
+    int rs;
+
+    if (ring == NULL) {
+        return NULL;
+    }
+
+    if (ring->inflight) {
+        return ring->inflight;
+    }
+
+    while (ring->stat.spill_fill > 0) {
+        seg = RING_SEG(ring, ring->restore);
+        ring->stat.spill_fill--;
+        rs = ring->spill && ring->spill->read
+                ? ring->spill->read(seg, DUER_VOICE_SEG_HEAD_LEN + ring->capacity) : DUER_ERR_FAILED;
+        if (rs >= (int)DUER_VOICE_SEG_HEAD_LEN && rs == (int)(DUER_VOICE_SEG_HEAD_LEN + seg->len)) {
+            ring->stat.restored++;
+            ring->inflight = seg;
+            return seg;
+        }
+        DUER_LOGW("restore the spilled voice segment failed: rs = %d", rs);
+        ring->stat.dropped++;
+    }
+
+    if (ring->count > 0) {
+        ring->inflight = RING_SEG(ring, ring->order[0]);
+    }
+
+    return ring->inflight;
+}
+
+duer_voice_seg_t *duer_voice_ring_inflight(duer_voice_ring_t *ring)
+{
+    return ring ? ring->inflight : NULL;
+}
+
+void duer_voice_ring_release(duer_voice_ring_t *ring, duer_bool sent)
+{
+    if (ring == NULL || ring->inflight == NULL) {
+        return;
+    }
+
+    if (ring->inflight != RING_SEG(ring, ring->restore)) {
+        duer_voice_ring_remove(ring, 0);
+    }
+    ring->inflight = NULL;
+
+    if (sent) {
+        ring->stat.sent++;
+    } else {
+        ring->stat.dropped++;
+    }
+}
+
+void duer_voice_ring_reset(duer_voice_ring_t *ring)
+{
+    duer_voice_seg_t *seg = NULL;
+
+    if (ring == NULL) {
+        return;
+    }
+
+    DUER_MEMSET(ring->used, 0, ring->slots + 1);
+    ring->count = 0;
+    ring->filling = 0;
+    ring->used[0] = 1;
+    ring->inflight = NULL;
+    seg = RING_SEG(ring, 0);
+    seg->len = 0;
+    seg->eof = 0;
+
+    if (ring->stat.spill_fill > 0 && ring->spill && ring->spill->reset) {
+        ring->spill->reset();
+    }
+    ring->stat.fill = 0;
+    ring->stat.spill_fill = 0;
+}
+
+void duer_voice_ring_add_blocked(duer_voice_ring_t *ring, duer_u32_t ms)
+{
+    if (ring) {
+        ring->stat.blocked_ms += ms;
+    }
+}
+
+void duer_voice_ring_get_stat(duer_voice_ring_t *ring, duer_voice_ring_stat_t *stat)
+{
+    if (ring && stat) {
+        DUER_MEMCPY(stat, &ring->stat, sizeof(*stat));
+    }
+}
+
+void duer_voice_ring_clear_stat(duer_voice_ring_t *ring)
+{
+    duer_u32_t spill_fill;
+
+    if (ring) {
+        // spill_fill is the state of the spill store
+        spill_fill = ring->stat.spill_fill;
+        DUER_MEMSET(&ring->stat, 0, sizeof(ring->stat));
+        ring->stat.spill_fill = spill_fill;
+        ring->stat.slots = ring->slots;
+        ring->stat.fill = ring->count;
+        ring->stat.fill_max = ring->count;
+    }
+}
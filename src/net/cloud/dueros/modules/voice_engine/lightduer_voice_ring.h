@@ -0,0 +1,138 @@
+/**
+ * Copyright (2017) Baidu Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * File: lightduer_voice_ring.h
+ * Desc: Fixed footprint ring of the voice segments waiting for upload.
+ */
+
+#ifndef BAIDU_DUER_LIGHTDUER_MODULES_VOICE_ENGINE_LIGHTDUER_VOICE_RING_H
+#define BAIDU_DUER_LIGHTDUER_MODULES_VOICE_ENGINE_LIGHTDUER_VOICE_RING_H
+
+#include "lightduer_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * What to do with a new segment when all the slots are waiting for upload
+ */
+typedef enum _duer_voice_overflow_enum {
+    DUER_VOICE_OVERFLOW_DROP_NEWEST,    // discard the new segment
+    DUER_VOICE_OVERFLOW_DROP_OLDEST,    // discard the oldest one not in flight
+    DUER_VOICE_OVERFLOW_BLOCK,          // wait for the sender, then drop the newest
+    DUER_VOICE_OVERFLOW_SPILL,          // move the oldest one not in flight to the spill store
+} duer_voice_overflow;
+
+/*
+ * A voice segment, the spill store saves and restores it as one record of
+ * DUER_VOICE_SEG_HEAD_LEN + len bytes.
+ */
+typedef struct _duer_voice_seg_s {
+    duer_u32_t  ts;         // when the segment was committed
+    duer_u16_t  len;        // bytes used in data
+    duer_u8_t   eof;
+    duer_u8_t   rsv;
+    duer_u8_t   data[];
+} duer_voice_seg_t;
+
+#define DUER_VOICE_SEG_HEAD_LEN     (sizeof(duer_voice_seg_t))
+
+/*
+ * FIFO of records on SD card or flash, provided by the application
+ */
+typedef struct _duer_voice_spill_s {
+    // append one record, return DUER_OK on success
+    int (*write)(const void *data, size_t size);
+    // take the oldest record, return its size or a negative error code
+    int (*read)(void *data, size_t size);
+    // discard all the records
+    void (*reset)(void);
+} duer_voice_spill_t;
+
+typedef struct _duer_voice_ring_stat_s {
+    duer_u32_t  slots;
+    duer_u32_t  fill;           // segments waiting in the ring, the one in flight included
+    duer_u32_t  fill_max;
+    duer_u32_t  fill_sum;       // fill after each commit, fill_sum / committed is the mean
+    duer_u32_t  spill_fill;     // segments waiting in the spill store
+    duer_u32_t  committed;
+    duer_u32_t  sent;
+    duer_u32_t  dropped;
+    duer_u32_t  spilled;
+    duer_u32_t  restored;
+    duer_u32_t  blocked_ms;
+} duer_voice_ring_stat_t;
+
+typedef struct _duer_voice_ring_s duer_voice_ring_t;
+
+/*
+ * Create the ring with one allocation
+ *
+ * @Param slots, the segments that can wait for upload, at most 254
+ * @Param capacity, the data bytes of each segment
+ */
+duer_voice_ring_t *duer_voice_ring_create(size_t slots, size_t capacity);
+
+void duer_voice_ring_destroy(duer_voice_ring_t *ring);
+
+void duer_voice_ring_set_spill(duer_voice_ring_t *ring, const duer_voice_spill_t *spill);
+
+size_t duer_voice_ring_capacity(duer_voice_ring_t *ring);
+
+/*
+ * The segment being filled by the encoder, it is never NULL
+ */
+duer_voice_seg_t *duer_voice_ring_producer(duer_voice_ring_t *ring);
+
+duer_bool duer_voice_ring_full(duer_voice_ring_t *ring);
+
+/*
+ * Queue the segment being filled and switch the producer to a free slot,
+ * the policy is applied when the ring is full
+ *
+ * * Return: DUER_OK        Success
+ *           DUER_ERR_FAILED The new segment is dropped
+ */
+int duer_voice_ring_commit(duer_voice_ring_t *ring, duer_voice_overflow policy);
+
+/*
+ * The oldest segment, it is in flight until released
+ *
+ * * Return: NULL if nothing to send
+ */
+duer_voice_seg_t *duer_voice_ring_front(duer_voice_ring_t *ring);
+
+duer_voice_seg_t *duer_voice_ring_inflight(duer_voice_ring_t *ring);
+
+void duer_voice_ring_release(duer_voice_ring_t *ring, duer_bool sent);
+
+/*
+ * Discard all the segments, the statistics are kept
+ */
+void duer_voice_ring_reset(duer_voice_ring_t *ring);
+
+void duer_voice_ring_add_blocked(duer_voice_ring_t *ring, duer_u32_t ms);
+
+void duer_voice_ring_get_stat(duer_voice_ring_t *ring, duer_voice_ring_stat_t *stat);
+
+void duer_voice_ring_clear_stat(duer_voice_ring_t *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif/*BAIDU_DUER_LIGHTDUER_MODULES_VOICE_ENGINE_LIGHTDUER_VOICE_RING_H*/
@@ -25,6 +25,7 @@
 #include "lightduer_types.h"
 #include "lightduer_net_transport.h"
 #include "lightduer_mutex.h"
+#include "lightduer_semaphore.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -80,6 +81,18 @@ extern duer_status_t unlock_mutex(duer_mutex_t mutex);
 
 extern duer_status_t delete_mutex_lock(duer_mutex_t mutex);
 
+/*
+ * Semaphore adapter
+ */
+
+extern duer_semaphore_t create_semaphore(void);
+
+extern duer_status_t wait_semaphore(duer_semaphore_t sem, duer_u32_t timeout);
+
+extern duer_status_t release_semaphore(duer_semaphore_t sem);
+
+extern duer_status_t delete_semaphore(duer_semaphore_t sem);
+
 #ifdef __cplusplus
 }
 #endif
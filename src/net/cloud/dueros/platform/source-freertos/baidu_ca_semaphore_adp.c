@@ -0,0 +1,68 @@
+/**
+ * Copyright (2017) Baidu Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * File: baidu_ca_semaphore_adp.c
+ * Desc: Adapt the semaphore function to FreeRTOS.
+ */
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "lightduer_semaphore.h"
+
+#ifdef DUER_PLATFORM_ESP8266
+#include "adaptation.h"
+#endif
+
+duer_semaphore_t create_semaphore(void)
+{
+    return (duer_semaphore_t)xSemaphoreCreateBinary();
+}
+
+duer_status_t wait_semaphore(duer_semaphore_t sem, duer_u32_t timeout)
+{
+    if (!sem) {
+        return DUER_ERR_FAILED;
+    }
+
+    if (xSemaphoreTake((SemaphoreHandle_t)sem, timeout / portTICK_PERIOD_MS) == pdTRUE) {
+        return DUER_OK;
+    } else {
+        return DUER_ERR_FAILED;
+    }
+}
+
+duer_status_t release_semaphore(duer_semaphore_t sem)
+{
+    if (!sem) {
+        return DUER_ERR_FAILED;
+    }
+
+    // a binary semaphore already given stays given
+    xSemaphoreGive((SemaphoreHandle_t)sem);
+
+    return DUER_OK;
+}
+
+duer_status_t delete_semaphore(duer_semaphore_t sem)
+{
+    if (!sem) {
+        return DUER_ERR_FAILED;
+    }
+
+    vSemaphoreDelete((SemaphoreHandle_t)sem);
+
+    return DUER_OK;
+}
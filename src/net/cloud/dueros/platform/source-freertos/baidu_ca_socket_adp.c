@@ -31,12 +31,11 @@
 #include "lightduer_log.h"
 #include "lightduer_lib.h"
 #include "lightduer_memory.h"
-#include "lightduer_events.h"
-#include "lightduer_timers.h"
 #include "lightduer_priority_conf.h"
 #include "lightduer_timestamp.h"
 
 #include "FreeRTOS.h"
+#include "task.h"
 #include "semphr.h"
 
 #ifdef DUER_PLATFORM_ESP8266
@@ -44,9 +43,9 @@
 #endif
 
 #ifdef DUER_PLATFORM_ESP8266
-#define TASK_STACK_SIZE (1024 * 4)
+#define TASK_STACK_SIZE (1024 * 4 / sizeof(portSTACK_TYPE))
 #else
-#define TASK_STACK_SIZE (1024 * 8 / sizeof(portSTACK_TYPE))
+#define TASK_STACK_SIZE (1024 * 2 / sizeof(portSTACK_TYPE))
 #endif
 
 #if defined(DUER_PLATFORM_MARVELL)
@@ -76,21 +75,34 @@ extern duer_handler my_handler;
 #undef fcntl
 #define fcntl(a,b,c)          lwip_fcntl(a,b,c)
 
+#define BCASOC_IO_TASK_NAME   "lightduer_socket"
 
+
+/*
+ * All the sockets are watched by one I/O task, which blocks in select() until
+ * a socket is readable, a blocked send can go on or a send times out. Other
+ * tasks wake it through a UDP socket connected to itself on the loopback
+ * interface when the set of watched sockets changes, so nothing runs while
+ * the connection is idle.
+ */
 typedef struct _bcasoc_s
 {
     volatile int fd;
+    volatile int close_fd;      // closed by the I/O task, it may be in select()
     volatile int is_send_block;
+    volatile int is_recv_wait;  // notify DUER_TEVT_RECV_RDY when readable
     volatile int destroy;
-    volatile int ref_count;
     duer_u32_t           send_data_block_begin_time; // unit is ms
-    duer_timer_handler  _timer;
     duer_transevt_func  _callback;
+    struct _bcasoc_s *  _next;
 } bcasoc_t;
 
-static duer_events_handler  g_lightduer_events = NULL;
 static SemaphoreHandle_t    g_mutex = NULL;
-static duer_timer_handler   s_finalize_timer = NULL;
+static bcasoc_t *           s_sockets = NULL;
+static TaskHandle_t         s_io_task = NULL;
+static int                  s_wakeup_fd = -1;
+static volatile int         s_wakeup_pending = 0;
+static volatile int         s_terminate = 0;
 
 static void bcasoc_lock() {
     if (g_mutex) {
@@ -131,129 +143,211 @@ static unsigned int bcasoc_parse_ip(const duer_addr_t *addr)
     return rs;
 }
 
-static void bcasoc_check_data(int what, void *object)
+static int bcasoc_wakeup_open(void)
 {
-    bcasoc_lock();
-    bcasoc_t *soc = (bcasoc_t *)object;
-    int rs = 0;
-    int fd = -1;
-    duer_transevt_func callback = NULL;
-
-    DUER_LOGD("soc:%p, destroy:%d, fd:%d, ref_count:%d, timer:%p",
-            soc, soc->destroy, soc->fd, soc->ref_count, soc->_timer);
-    if (!soc || soc->ref_count <= 0) {
-        DUER_LOGE("soc:%p, ref_count:%d", soc, soc->ref_count);
-        goto out;
-    } else {
-        soc->ref_count--;
-        if (soc->fd == -1) {
-            DUER_LOGI("soc:%p, destroy:%d, fd:%d, ref_count:%d, timer:%p",
-                    soc, soc->destroy, soc->fd, soc->ref_count, soc->_timer);
-            if (soc->destroy == 1) {
-                if (soc->_timer) {
-                    duer_timer_release(soc->_timer);
-                    soc->_timer = NULL;
-                }
-                if (!soc->ref_count) {
-                    soc->ref_count = -1; // prevent reenter to free twice
-                    DUER_FREE(soc);
-                }
-            }
-            goto out;
-        }
+    struct sockaddr_in addr_in;
+    socklen_t len = sizeof(addr_in);
+    int fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+    if (fd < 0) {
+        DUER_LOGE("wakeup socket create failed: %d", fd);
+        return -1;
     }
 
-    callback = soc->_callback;
+    DUER_MEMSET(&addr_in, 0, sizeof(addr_in));
+    addr_in.sin_family = AF_INET;
+    addr_in.sin_port = 0;
+    addr_in.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, (struct sockaddr *)&addr_in, sizeof(addr_in)) < 0
+            || getsockname(fd, (struct sockaddr *)&addr_in, &len) < 0
+            || connect(fd, (struct sockaddr *)&addr_in, sizeof(addr_in)) < 0) {
+        DUER_LOGE("wakeup socket setup failed");
+        close(fd);
+        return -1;
+    }
 
-    if (soc->is_send_block == 1) {
-        duer_u32_t current_ts = duer_timestamp();
-        if ( current_ts - soc->send_data_block_begin_time > DUER_SENDTIMEOUT) {
-            DUER_LOGD("send time out, current timestamp:%u, begin_time:%u",
-                    current_ts, soc->send_data_block_begin_time);
-            soc->send_data_block_begin_time = duer_timestamp();// reset the timestamp
-            if (callback) {
-                callback(DUER_TEVT_SEND_TIMEOUT);
-            }
-        }
+    return fd;
+}
+
+/* Called with the lock held */
+static void bcasoc_wakeup(void)
+{
+    char c = 0;
+
+    if (s_wakeup_fd != -1 && !s_wakeup_pending) {
+        s_wakeup_pending = 1;
+        send(s_wakeup_fd, &c, sizeof(c), MSG_DONTWAIT);
     }
+}
 
-    fd = soc->fd;
+static void bcasoc_wakeup_drain(void)
+{
+    char buf[8];
 
-    fd_set fdread, fdwrite, fdex;
-    struct timeval time = {0, 0};
+    s_wakeup_pending = 0;
+    while (recv(s_wakeup_fd, buf, sizeof(buf), MSG_DONTWAIT) > 0) {
+    }
+}
 
-    FD_ZERO(&fdread);
-    FD_ZERO(&fdwrite);
-    FD_ZERO(&fdex);
+/* Close the sockets given up by bcasoc_close and free the destroyed ones */
+static void bcasoc_reap(void)
+{
+    bcasoc_t **link = &s_sockets;
+    bcasoc_t *soc;
 
-    FD_SET(fd, &fdread);
-    FD_SET(fd, &fdwrite);
-    FD_SET(fd, &fdex);
+    while ((soc = *link) != NULL) {
+        if (soc->close_fd != -1) {
+            close(soc->close_fd);
+            soc->close_fd = -1;
+        }
+        if (soc->destroy) {
+            *link = soc->_next;
+            DUER_FREE(soc);
+        } else {
+            link = &soc->_next;
+        }
+    }
+}
 
-    rs = select(fd + 1, &fdread, &fdwrite, &fdex, &time);
-    DUER_LOGD("select rs:%d, block:%d", rs, soc->is_send_block);
+static void bcasoc_io_task(void *param)
+{
+    fd_set fdread, fdwrite, fdex;
+    struct timeval time;
+    struct timeval *timeout;
+    duer_u32_t now;
+    duer_u32_t spent;
+    duer_u32_t wait;
+    bcasoc_t *soc;
+    int maxfd;
+    int rs;
+
+    while (1) {
+        bcasoc_lock();
+        bcasoc_reap();
+        if (s_terminate) {
+            bcasoc_unlock();
+            break;
+        }
 
-    if (rs > 0) {
-        if (FD_ISSET(fd, &fdread)) {
-            if (callback) {
-                callback(DUER_TEVT_RECV_RDY);
+        FD_ZERO(&fdread);
+        FD_ZERO(&fdwrite);
+        FD_ZERO(&fdex);
+        FD_SET(s_wakeup_fd, &fdread);
+        maxfd = s_wakeup_fd;
+        wait = (duer_u32_t)-1;
+        now = duer_timestamp();
+
+        for (soc = s_sockets; soc != NULL; soc = soc->_next) {
+            if (soc->fd == -1) {
+                continue;
+            }
+            if (soc->is_recv_wait) {
+                FD_SET(soc->fd, &fdread);
+                FD_SET(soc->fd, &fdex);
+            }
+            if (soc->is_send_block) {
+                FD_SET(soc->fd, &fdwrite);
+                spent = now - soc->send_data_block_begin_time;
+                if (spent >= DUER_SENDTIMEOUT) {
+                    wait = 0;
+                } else if (DUER_SENDTIMEOUT - spent < wait) {
+                    wait = DUER_SENDTIMEOUT - spent;
+                }
+            }
+            if (soc->fd > maxfd) {
+                maxfd = soc->fd;
             }
-        } else if (FD_ISSET(fd, &fdex)) {
-            DUER_LOGE("exception occurs %d:%s", errno, strerror(errno));
-            rs = -1;
         }
+        bcasoc_unlock();
 
-        if (FD_ISSET(fd, &fdwrite) && soc->is_send_block == 1) {
-            if (callback) {
-                callback(DUER_TEVT_SEND_RDY);
-            }
-            soc->is_send_block = 0;
-            soc->send_data_block_begin_time = 0;
+        if (wait == (duer_u32_t)-1) {
+            timeout = NULL;
+        } else {
+            time.tv_sec = wait / 1000;
+            time.tv_usec = (wait % 1000) * 1000;
+            timeout = &time;
         }
 
-        if (!FD_ISSET(fd, &fdread)) {
-            if (soc->_timer) {
-                duer_timer_start(soc->_timer, 100);
-            }
+        rs = select(maxfd + 1, &fdread, &fdwrite, &fdex, timeout);
+        if (rs < 0) {
+            DUER_LOGE("select failed %d:%s", errno, strerror(errno));
+            vTaskDelay(100 / portTICK_PERIOD_MS);
+            continue;
         }
-    } else if (rs == 0) {
-        if (soc->_timer) {
-            duer_timer_start(soc->_timer, 100);
+
+        bcasoc_lock();
+        if (rs > 0 && FD_ISSET(s_wakeup_fd, &fdread)) {
+            bcasoc_wakeup_drain();
         }
-    }
 
-out:
-    bcasoc_unlock();
-}
+        now = duer_timestamp();
+        for (soc = s_sockets; soc != NULL; soc = soc->_next) {
+            if (soc->fd == -1 || soc->destroy) {
+                continue;
+            }
 
-static int bcasoc_events_call(duer_events_func func, int what, void *object)
-{
-    if (g_lightduer_events) {
-        return duer_events_call(g_lightduer_events, func, what, object);
-    }
-    return DUER_ERR_FAILED;
-}
+            if (soc->is_recv_wait && rs > 0
+                    && (FD_ISSET(soc->fd, &fdread) || FD_ISSET(soc->fd, &fdex))) {
+                if (FD_ISSET(soc->fd, &fdex)) {
+                    DUER_LOGE("exception occurs on fd:%d", soc->fd);
+                }
+                // the reader learns about the error from recv
+                soc->is_recv_wait = 0;
+                if (soc->_callback) {
+                    soc->_callback(DUER_TEVT_RECV_RDY);
+                }
+            }
 
-static void bcasoc_timer_expired(void *param)
-{
-    bcasoc_lock();
-    bcasoc_t *soc = (bcasoc_t *)param;
-    if (!soc->ref_count) {
-        soc->ref_count++;
-        bcasoc_events_call(bcasoc_check_data, 0, param);
+            if (soc->is_send_block) {
+                if (rs > 0 && FD_ISSET(soc->fd, &fdwrite)) {
+                    soc->is_send_block = 0;
+                    soc->send_data_block_begin_time = 0;
+                    if (soc->_callback) {
+                        soc->_callback(DUER_TEVT_SEND_RDY);
+                    }
+                } else if (now - soc->send_data_block_begin_time >= DUER_SENDTIMEOUT) {
+                    DUER_LOGD("send time out, current timestamp:%u, begin_time:%u",
+                            now, soc->send_data_block_begin_time);
+                    soc->send_data_block_begin_time = now; // reset the timestamp
+                    if (soc->_callback) {
+                        soc->_callback(DUER_TEVT_SEND_TIMEOUT);
+                    }
+                }
+            }
+        }
+        bcasoc_unlock();
     }
-    bcasoc_unlock();
+
+    DUER_LOGI("bcasoc_io_task exit");
+    close(s_wakeup_fd);
+    s_wakeup_fd = -1;
+    s_io_task = NULL;
+    vSemaphoreDelete(g_mutex);
+    g_mutex = NULL;
+    vTaskDelete(NULL);
 }
 
 void bcasoc_initialize(void)
 {
-    if (g_lightduer_events == NULL) {
-        g_lightduer_events = duer_events_create("lightduer_socket", TASK_STACK_SIZE, 10);
-    }
-
     if (g_mutex == NULL) {
         g_mutex = xSemaphoreCreateMutex();
     }
+
+    if (s_io_task == NULL) {
+        s_terminate = 0;
+        s_wakeup_pending = 0;
+        s_wakeup_fd = bcasoc_wakeup_open();
+        if (s_wakeup_fd == -1) {
+            return;
+        }
+        xTaskCreate(&bcasoc_io_task, BCASOC_IO_TASK_NAME, TASK_STACK_SIZE, NULL,
+                    duer_priority_get(DUER_TASK_SOCKET), &s_io_task);
+        if (s_io_task == NULL) {
+            DUER_LOGE("Create the socket task failed!");
+            close(s_wakeup_fd);
+            s_wakeup_fd = -1;
+        }
+    }
 }
 
 duer_socket_t bcasoc_create(duer_transevt_func func)
@@ -262,11 +356,17 @@ duer_socket_t bcasoc_create(duer_transevt_func func)
     if (soc) {
         DUER_MEMSET(soc, 0, sizeof(bcasoc_t));
         soc->fd = -1;
+        soc->close_fd = -1;
         soc->is_send_block = 0;
+        soc->is_recv_wait = 0;
         soc->destroy = 0;
-        soc->ref_count = 0;
         soc->send_data_block_begin_time = 0;
         soc->_callback = func;
+
+        bcasoc_lock();
+        soc->_next = s_sockets;
+        s_sockets = soc;
+        bcasoc_unlock();
     }
     return soc;
 }
@@ -275,16 +375,17 @@ duer_status_t bcasoc_connect(duer_socket_t ctx, const duer_addr_t *addr)
 {
     int rs = DUER_ERR_FAILED;
     bcasoc_t *soc = (bcasoc_t *)ctx;
+    int fd;
 
     DUER_LOGV("Entry bcasoc_connect ctx = %p", ctx);
 
     if (soc && addr) {
-        soc->fd = socket(AF_INET, addr->type == DUER_PROTO_TCP ? SOCK_STREAM : SOCK_DGRAM,
-                         addr->type == DUER_PROTO_TCP ? IPPROTO_TCP : IPPROTO_UDP);
-        DUER_LOGV("Result bcasoc_connect fd = %d", soc->fd);
-        if (soc->fd < 0) {
-            DUER_LOGE("socket create failed: %d", soc->fd);
-            return soc->fd;
+        fd = socket(AF_INET, addr->type == DUER_PROTO_TCP ? SOCK_STREAM : SOCK_DGRAM,
+                    addr->type == DUER_PROTO_TCP ? IPPROTO_TCP : IPPROTO_UDP);
+        DUER_LOGV("Result bcasoc_connect fd = %d", fd);
+        if (fd < 0) {
+            DUER_LOGE("socket create failed: %d", fd);
+            return fd;
         }
 
         struct sockaddr_in addr_in;
@@ -296,18 +397,23 @@ duer_status_t bcasoc_connect(duer_socket_t ctx, const duer_addr_t *addr)
             addr_in.sin_addr.s_addr = htonl(ip_data);
         } else {
             DUER_LOGI("got ip failed!");
+            close(fd);
             return DUER_ERR_TRANS_DNS_FAIL;
         }
-        rs = connect(soc->fd, (struct sockaddr *)&addr_in, sizeof(addr_in));
+        rs = connect(fd, (struct sockaddr *)&addr_in, sizeof(addr_in));
 
         if (rs >= 0) {
 #if defined(NON_BLOCKING) && (NON_BLOCKING == 1)
-            int flags = fcntl(soc->fd, F_GETFL, 0);
-            fcntl(soc->fd, F_SETFL, flags | O_NONBLOCK);
+            int flags = fcntl(fd, F_GETFL, 0);
+            fcntl(fd, F_SETFL, flags | O_NONBLOCK);
 #endif
-            soc->_timer = duer_timer_acquire(bcasoc_timer_expired, soc, DUER_TIMER_ONCE);
-            //DUER_LOGI("before call bcasoc_timer_expired, soc:%p, fd:%d", soc, soc->fd);
-            bcasoc_timer_expired((void*)soc);
+            bcasoc_lock();
+            soc->fd = fd;
+            soc->is_recv_wait = 1;
+            bcasoc_wakeup();
+            bcasoc_unlock();
+        } else {
+            close(fd);
         }
     }
 
@@ -338,8 +444,13 @@ duer_status_t bcasoc_send(duer_socket_t ctx, const void *data, duer_size_t size,
         rs = send(soc->fd, data, size, MSG_FLAG);
     } else if (rs == 0) {
         rs = DUER_ERR_TRANS_WOULD_BLOCK;
-        soc->is_send_block = 1;
-        soc->send_data_block_begin_time = duer_timestamp();
+        bcasoc_lock();
+        if (!soc->is_send_block) {
+            soc->is_send_block = 1;
+            soc->send_data_block_begin_time = duer_timestamp();
+            bcasoc_wakeup();
+        }
+        bcasoc_unlock();
     } else if (errno != EINTR) {
         rs = DUER_ERR_TRANS_INTERNAL_ERROR;
     }
@@ -381,11 +492,14 @@ duer_status_t bcasoc_recv(duer_socket_t ctx, void *data, duer_size_t size, duer_
         rs = DUER_ERR_TRANS_INTERNAL_ERROR;
     }
 
-    if (rs > 0 ) {
-        if (soc->fd != -1) {
-            //DUER_LOGI("before call bcasoc_timer_expired, soc:%p, fd:%d", soc, soc->fd);
-            bcasoc_timer_expired(soc);
+    if (rs > 0 || rs == DUER_ERR_TRANS_WOULD_BLOCK) {
+        // watch the socket again, the next data is notified as soon as it comes
+        bcasoc_lock();
+        if (soc->fd != -1 && !soc->is_recv_wait) {
+            soc->is_recv_wait = 1;
+            bcasoc_wakeup();
         }
+        bcasoc_unlock();
     }
 
     if (rs < 0 && rs != DUER_ERR_TRANS_WOULD_BLOCK) {
@@ -432,14 +546,18 @@ duer_status_t bcasoc_close(duer_socket_t ctx)
 {
     bcasoc_t *soc = (bcasoc_t *)ctx;
     if (soc) {
-        duer_timer_stop(soc->_timer);
-        DUER_LOGI("stop timer:%p", soc->_timer);
         bcasoc_lock();
         if (soc->fd != -1) {
-            close(soc->fd);
+            if (s_io_task) {
+                soc->close_fd = soc->fd;
+                bcasoc_wakeup();
+            } else {
+                close(soc->fd);
+            }
             soc->fd = -1;
         }
-
+        soc->is_recv_wait = 0;
+        soc->is_send_block = 0;
         bcasoc_unlock();
     }
     return DUER_OK;
@@ -448,38 +566,36 @@ duer_status_t bcasoc_close(duer_socket_t ctx)
 duer_status_t bcasoc_destroy(duer_socket_t ctx)
 {
     bcasoc_t *soc = (bcasoc_t *)ctx;
+    bcasoc_t **link;
+
     bcasoc_lock();
-    soc->destroy = 1;
-    DUER_LOGI("start last timer:%p, soc:%p", soc->_timer, soc);
-    if (soc->_timer) {
-        duer_timer_start(soc->_timer, 200);
+    DUER_LOGI("destroy soc:%p", soc);
+    if (s_io_task) {
+        soc->destroy = 1;
+        bcasoc_wakeup();
     } else {
+        for (link = &s_sockets; *link != NULL; link = &(*link)->_next) {
+            if (*link == soc) {
+                *link = soc->_next;
+                break;
+            }
+        }
+        if (soc->close_fd != -1) {
+            close(soc->close_fd);
+        }
         DUER_FREE(soc);
     }
     bcasoc_unlock();
     return DUER_OK;
 }
 
-static void bcasoc_destroy_events(int what, void *object)
-{
-    DUER_LOGI("bcasoc_destroy_events");
-    duer_events_destroy(g_lightduer_events);
-    g_lightduer_events = NULL;
-    vSemaphoreDelete(g_mutex);
-    g_mutex = NULL;
-    duer_timer_release(s_finalize_timer);
-    s_finalize_timer = NULL;
-}
-
-static void bcasoc_finalize_callback(void *param)
-{
-    bcasoc_events_call(bcasoc_destroy_events, 0, NULL);
-}
-
 void bcasoc_finalize(void)
 {
-    s_finalize_timer = duer_timer_acquire(bcasoc_finalize_callback, NULL, DUER_TIMER_ONCE);
-    if (s_finalize_timer) {
-        duer_timer_start(s_finalize_timer, 200);
+    bcasoc_lock();
+    if (s_io_task) {
+        // the I/O task releases the resources when it exits
+        s_terminate = 1;
+        bcasoc_wakeup();
     }
+    bcasoc_unlock();
 }
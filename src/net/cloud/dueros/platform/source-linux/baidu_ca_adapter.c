@@ -31,6 +31,7 @@
 #include "lightduer_memory.h"
 #include "lightduer_net_transport.h"
 #include "lightduer_sleep.h"
+#include "lightduer_semaphore.h"
 #include "lightduer_timestamp.h"
 #include "lightduer_random.h"
 #include "lightduer_random_impl.h"
@@ -69,6 +70,12 @@ void baidu_ca_adapter_initialize()
           unlock_mutex,
           delete_mutex_lock);
 
+    baidu_ca_semaphore_init(
+          create_semaphore,
+          wait_semaphore,
+          release_semaphore,
+          delete_semaphore);
+
     baidu_ca_debug_init(NULL, bcadbg);
 
     bcasoc_initialize();
@@ -23,6 +23,7 @@
 #define BAIDU_DUER_IOT_CA_ADAPTER_BAIDU_CA_ADAPTER_INTERNAL_H
 
 #include "lightduer_mutex.h"
+#include "lightduer_semaphore.h"
 #include "lightduer_net_transport.h"
 #include "lightduer_types.h"
 
@@ -78,6 +79,18 @@ extern duer_status_t unlock_mutex(duer_mutex_t mutex);
 
 extern duer_status_t delete_mutex_lock(duer_mutex_t mutex);
 
+/*
+ * Semaphore adapter
+ */
+
+extern duer_semaphore_t create_semaphore(void);
+
+extern duer_status_t wait_semaphore(duer_semaphore_t sem, duer_u32_t timeout);
+
+extern duer_status_t release_semaphore(duer_semaphore_t sem);
+
+extern duer_status_t delete_semaphore(duer_semaphore_t sem);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,114 @@
+/**
+ * Copyright (2017) Baidu Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+//
+// File: baidu_ca_semaphore_adp.c
+// Desc: Adapt the semaphore function to linux, a binary semaphore on a
+//       condition variable, timed against CLOCK_MONOTONIC.
+
+
+#include "lightduer_semaphore.h"
+
+#include <pthread.h>
+#include <time.h>
+
+#include "lightduer_log.h"
+#include "lightduer_memory.h"
+
+typedef struct _bcasem_s {
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    int             given;
+} bcasem_t;
+
+duer_semaphore_t create_semaphore(void)
+{
+    pthread_condattr_t attr;
+    bcasem_t *sem = (bcasem_t *)DUER_MALLOC(sizeof(bcasem_t));
+
+    if (!sem) {
+        DUER_LOGW("malloc semaphore fail!");
+        return NULL;
+    }
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&sem->mutex, NULL);
+    pthread_cond_init(&sem->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    sem->given = 0;
+
+    return (duer_semaphore_t)sem;
+}
+
+duer_status_t wait_semaphore(duer_semaphore_t sem, duer_u32_t timeout)
+{
+    bcasem_t *s = (bcasem_t *)sem;
+    struct timespec ts;
+    int ret = 0;
+
+    if (!s) {
+        return DUER_ERR_FAILED;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += timeout / 1000;
+    ts.tv_nsec += (long)(timeout % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&s->mutex);
+    while (!s->given && ret == 0) {
+        ret = pthread_cond_timedwait(&s->cond, &s->mutex, &ts);
+    }
+    ret = s->given ? DUER_OK : DUER_ERR_FAILED;
+    s->given = 0;
+    pthread_mutex_unlock(&s->mutex);
+
+    return ret;
+}
+
+duer_status_t release_semaphore(duer_semaphore_t sem)
+{
+    bcasem_t *s = (bcasem_t *)sem;
+
+    if (!s) {
+        return DUER_ERR_FAILED;
+    }
+
+    pthread_mutex_lock(&s->mutex);
+    s->given = 1;
+    pthread_cond_signal(&s->cond);
+    pthread_mutex_unlock(&s->mutex);
+
+    return DUER_OK;
+}
+
+duer_status_t delete_semaphore(duer_semaphore_t sem)
+{
+    bcasem_t *s = (bcasem_t *)sem;
+
+    if (!s) {
+        return DUER_ERR_FAILED;
+    }
+
+    pthread_cond_destroy(&s->cond);
+    pthread_mutex_destroy(&s->mutex);
+    DUER_FREE(s);
+
+    return DUER_OK;
+}
@@ -40,16 +40,12 @@
 #include <unistd.h>
 
 #include "lightduer_connagent.h"
-#include "lightduer_events.h"
 #include "lightduer_lib.h"
 #include "lightduer_log.h"
 #include "lightduer_memory.h"
 #include "lightduer_priority_conf.h"
-#include "lightduer_timers.h"
 #include "lightduer_timestamp.h"
 
-#define TASK_STACK_SIZE (1024 * 4)
-
 #ifndef NON_BLOCKING
 #define NON_BLOCKING    (0)
 #endif
@@ -66,19 +62,30 @@ extern duer_handler my_handler;
 #define DUER_SENDTIMEOUT    8000 // 8s
 #endif
 
+/*
+ * All the sockets are watched by one I/O thread, which blocks in select() until
+ * a socket is readable, a blocked send can go on or a send times out. Other
+ * threads wake it through a pipe when the set of watched sockets changes, so
+ * nothing runs while the connection is idle.
+ */
 typedef struct _bcasoc_s
 {
     volatile int fd;
+    volatile int close_fd;      // closed by the I/O thread, it may be in select()
     volatile int is_send_block;
+    volatile int is_recv_wait;  // notify DUER_TEVT_RECV_RDY when readable
     volatile int destroy;
-    volatile int ref_count;
     duer_u32_t           send_data_block_begin_time; // unit is ms
-    duer_timer_handler  _timer;
     duer_transevt_func  _callback;
+    struct _bcasoc_s *  _next;
 } bcasoc_t;
 
-static duer_events_handler  g_lightduer_events = NULL;
-static pthread_mutex_t    g_mutex;
+static pthread_mutex_t      g_mutex;
+static bcasoc_t *           s_sockets = NULL;
+static pthread_t            s_io_thread;
+static int                  s_io_running = 0;
+static int                  s_wakeup_fd[2] = {-1, -1};
+static volatile int         s_wakeup_pending = 0;
 
 static void bcasoc_lock() {
         pthread_mutex_lock(&g_mutex);
@@ -98,7 +105,7 @@ static unsigned int bcasoc_parse_ip(const duer_addr_t *addr)
         if (!hp) {
             DUER_LOGE("DNS failed!!!");
         } else {
-            struct in_addr* ip4_addr;
+            struct in_addr* ip4_addr = NULL;
             if (hp->h_addrtype == AF_INET) {
                 ip4_addr = (struct in_addr*)hp->h_addr_list[0];
                 DUER_LOGI("DNS lookup succeeded. IP=%s", inet_ntoa(*ip4_addr));
@@ -118,142 +125,219 @@ static unsigned int bcasoc_parse_ip(const duer_addr_t *addr)
     return rs;
 }
 
-static void bcasoc_check_data(int what, void *object)
+static int bcasoc_wakeup_open(void)
 {
-    bcasoc_lock();
-    bcasoc_t *soc = (bcasoc_t *)object;
-    int rs = 0;
-    int fd = -1;
-    duer_transevt_func callback = NULL;
-
-    DUER_LOGD("soc:%p, destroy:%d, fd:%d, ref_count:%d, timer:%p",
-            soc, soc->destroy, soc->fd, soc->ref_count, soc->_timer);
-    if (!soc) {
-        goto out;
-    } else {
-        soc->ref_count--;
-        if (soc->fd == -1) {
-            DUER_LOGI("soc:%p, destroy:%d, fd:%d, ref_count:%d, timer:%p",
-                    soc, soc->destroy, soc->fd, soc->ref_count, soc->_timer);
-            if (soc->destroy == 1) {
-                if (soc->_timer) {
-                    duer_timer_release(soc->_timer);
-                    soc->_timer = NULL;
-                }
-                if (!soc->ref_count) {
-                    DUER_FREE(soc);
-                }
-            }
-            goto out;
-        }
+    int i;
+
+    if (pipe(s_wakeup_fd) < 0) {
+        DUER_LOGE("wakeup pipe create failed %d:%s", errno, strerror(errno));
+        return -1;
     }
 
-    callback = soc->_callback;
+    for (i = 0; i < 2; i++) {
+        fcntl(s_wakeup_fd[i], F_SETFL, fcntl(s_wakeup_fd[i], F_GETFL, 0) | O_NONBLOCK);
+    }
 
-    if (soc->is_send_block == 1) {
-        duer_u32_t current_ts = duer_timestamp();
-        if ( current_ts - soc->send_data_block_begin_time > DUER_SENDTIMEOUT) {
-            DUER_LOGD("send time out, current timestamp:%u, begin_time:%u",
-                    current_ts, soc->send_data_block_begin_time);
-            soc->send_data_block_begin_time = duer_timestamp();// reset the timestamp
-            if (callback) {
-                callback(DUER_TEVT_SEND_TIMEOUT);
-            }
+    return 0;
+}
+
+/* Called with the lock held */
+static void bcasoc_wakeup(void)
+{
+    char c = 0;
+
+    if (s_wakeup_fd[1] != -1 && !s_wakeup_pending) {
+        s_wakeup_pending = 1;
+        if (write(s_wakeup_fd[1], &c, sizeof(c)) < 0) {
+            DUER_LOGW("wakeup failed %d:%s", errno, strerror(errno));
         }
     }
+}
 
-    fd = soc->fd;
-
-    fd_set fdread, fdwrite, fdex;
-    struct timeval time = {0, 0};
+static void bcasoc_wakeup_drain(void)
+{
+    char buf[8];
 
-    FD_ZERO(&fdread);
-    FD_ZERO(&fdwrite);
-    FD_ZERO(&fdex);
+    s_wakeup_pending = 0;
+    while (read(s_wakeup_fd[0], buf, sizeof(buf)) > 0) {
+    }
+}
 
-    FD_SET(fd, &fdread);
-    FD_SET(fd, &fdwrite);
-    FD_SET(fd, &fdex);
+/* Close the sockets given up by bcasoc_close and free the destroyed ones */
+static void bcasoc_reap(void)
+{
+    bcasoc_t **link = &s_sockets;
+    bcasoc_t *soc;
 
-    rs = select(fd + 1, &fdread, &fdwrite, &fdex, &time);
-    DUER_LOGD("select rs:%d, block:%d", rs, soc->is_send_block);
+    while ((soc = *link) != NULL) {
+        if (soc->close_fd != -1) {
+            close(soc->close_fd);
+            soc->close_fd = -1;
+        }
+        if (soc->destroy) {
+            *link = soc->_next;
+            DUER_FREE(soc);
+        } else {
+            link = &soc->_next;
+        }
+    }
+}
 
-    if (rs > 0) {
-        if (FD_ISSET(fd, &fdread)) {
-            if (callback) {
-                callback(DUER_TEVT_RECV_RDY);
+static void *bcasoc_io_task(void *param)
+{
+    fd_set fdread, fdwrite, fdex;
+    struct timeval time;
+    struct timeval *timeout;
+    duer_u32_t now;
+    duer_u32_t spent;
+    duer_u32_t wait;
+    bcasoc_t *soc;
+    int maxfd;
+    int rs;
+
+    while (1) {
+        bcasoc_lock();
+        bcasoc_reap();
+
+        FD_ZERO(&fdread);
+        FD_ZERO(&fdwrite);
+        FD_ZERO(&fdex);
+        FD_SET(s_wakeup_fd[0], &fdread);
+        maxfd = s_wakeup_fd[0];
+        wait = (duer_u32_t)-1;
+        now = duer_timestamp();
+
+        for (soc = s_sockets; soc != NULL; soc = soc->_next) {
+            if (soc->fd == -1) {
+                continue;
             }
-        } else if (FD_ISSET(fd, &fdex)) {
-            DUER_LOGE("exception occurs %d:%s", errno, strerror(errno));
-            rs = -1;
-        }
-        if (soc->is_send_block == 1) {
-            if (FD_ISSET(fd, &fdwrite)) {
-                if (callback) {
-                    callback(DUER_TEVT_SEND_RDY);
+            if (soc->is_recv_wait) {
+                FD_SET(soc->fd, &fdread);
+                FD_SET(soc->fd, &fdex);
+            }
+            if (soc->is_send_block) {
+                FD_SET(soc->fd, &fdwrite);
+                spent = now - soc->send_data_block_begin_time;
+                if (spent >= DUER_SENDTIMEOUT) {
+                    wait = 0;
+                } else if (DUER_SENDTIMEOUT - spent < wait) {
+                    wait = DUER_SENDTIMEOUT - spent;
                 }
-                soc->is_send_block = 0;
-                soc->send_data_block_begin_time = 0;
+            }
+            if (soc->fd > maxfd) {
+                maxfd = soc->fd;
             }
         }
+        bcasoc_unlock();
 
-        if (!FD_ISSET(fd, &fdread)) {
-            if (soc->_timer) {
-                duer_timer_start(soc->_timer, 100);
-            }
+        if (wait == (duer_u32_t)-1) {
+            timeout = NULL;
+        } else {
+            time.tv_sec = wait / 1000;
+            time.tv_usec = (wait % 1000) * 1000;
+            timeout = &time;
         }
-    } else if (rs == 0) {
-        DUER_LOGD("run: %p", soc);
-        if (soc->_timer) {
-            duer_timer_start(soc->_timer, 100);
+
+        rs = select(maxfd + 1, &fdread, &fdwrite, &fdex, timeout);
+        if (rs < 0) {
+            if (errno != EINTR) {
+                DUER_LOGE("select failed %d:%s", errno, strerror(errno));
+                usleep(100 * 1000);
+            }
+            continue;
         }
-    }
 
-out:
-    bcasoc_unlock();
-}
+        bcasoc_lock();
+        if (rs > 0 && FD_ISSET(s_wakeup_fd[0], &fdread)) {
+            bcasoc_wakeup_drain();
+        }
 
-static int bcasoc_events_call(duer_events_func func, int what, void *object)
-{
-    if (g_lightduer_events) {
-        return duer_events_call(g_lightduer_events, func, what, object);
-    }
-    return DUER_ERR_FAILED;
-}
+        now = duer_timestamp();
+        for (soc = s_sockets; soc != NULL; soc = soc->_next) {
+            if (soc->fd == -1 || soc->destroy) {
+                continue;
+            }
 
-static void bcasoc_timer_expired(void *param)
-{
-    bcasoc_lock();
+            if (soc->is_recv_wait && rs > 0
+                    && (FD_ISSET(soc->fd, &fdread) || FD_ISSET(soc->fd, &fdex))) {
+                if (FD_ISSET(soc->fd, &fdex)) {
+                    DUER_LOGE("exception occurs on fd:%d", soc->fd);
+                }
+                // the reader learns about the error from recv
+                soc->is_recv_wait = 0;
+                if (soc->_callback) {
+                    soc->_callback(DUER_TEVT_RECV_RDY);
+                }
+            }
 
-    bcasoc_t *soc = (bcasoc_t *)param;
-    if (!soc->ref_count) {
-        soc->ref_count++;
-        bcasoc_events_call(bcasoc_check_data, 0, param);
+            if (soc->is_send_block) {
+                if (rs > 0 && FD_ISSET(soc->fd, &fdwrite)) {
+                    soc->is_send_block = 0;
+                    soc->send_data_block_begin_time = 0;
+                    if (soc->_callback) {
+                        soc->_callback(DUER_TEVT_SEND_RDY);
+                    }
+                } else if (now - soc->send_data_block_begin_time >= DUER_SENDTIMEOUT) {
+                    DUER_LOGD("send time out, current timestamp:%u, begin_time:%u",
+                            now, soc->send_data_block_begin_time);
+                    soc->send_data_block_begin_time = now; // reset the timestamp
+                    if (soc->_callback) {
+                        soc->_callback(DUER_TEVT_SEND_TIMEOUT);
+                    }
+                }
+            }
+        }
+        bcasoc_unlock();
     }
 
-    bcasoc_unlock();
+    return NULL;
 }
 
 void bcasoc_initialize(void)
 {
-    if (g_lightduer_events == NULL) {
-        g_lightduer_events = duer_events_create("lightduer_socket", TASK_STACK_SIZE, 10);
+    pthread_attr_t attr;
+
+    if (s_io_running) {
+        return;
     }
 
     pthread_mutex_init(&g_mutex, NULL);
+
+    s_wakeup_pending = 0;
+    if (bcasoc_wakeup_open() < 0) {
+        return;
+    }
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&s_io_thread, &attr, bcasoc_io_task, NULL) == 0) {
+        s_io_running = 1;
+    } else {
+        DUER_LOGE("Create the socket thread failed!");
+        close(s_wakeup_fd[0]);
+        close(s_wakeup_fd[1]);
+        s_wakeup_fd[0] = s_wakeup_fd[1] = -1;
+    }
+    pthread_attr_destroy(&attr);
 }
 
-duer_socket_t bcasoc_create(duer_transevt_func context)
+duer_socket_t bcasoc_create(duer_transevt_func func)
 {
     bcasoc_t *soc = DUER_MALLOC(sizeof(bcasoc_t));
     if (soc) {
         DUER_MEMSET(soc, 0, sizeof(bcasoc_t));
         soc->fd = -1;
+        soc->close_fd = -1;
         soc->is_send_block = 0;
+        soc->is_recv_wait = 0;
         soc->destroy = 0;
-        soc->ref_count = 0;
         soc->send_data_block_begin_time = 0;
-        soc->_callback = context;
+        soc->_callback = func;
+
+        bcasoc_lock();
+        soc->_next = s_sockets;
+        s_sockets = soc;
+        bcasoc_unlock();
     }
     return soc;
 }
@@ -262,20 +346,21 @@ duer_status_t bcasoc_connect(duer_socket_t ctx, const duer_addr_t *addr)
 {
     int rs = DUER_ERR_FAILED;
     bcasoc_t *soc = (bcasoc_t *)ctx;
+    int fd;
 
     DUER_LOGV("Entry bcasoc_connect ctx = %p", ctx);
 
     if (soc && addr) {
-        soc->fd = socket(AF_INET, addr->type == DUER_PROTO_TCP ? SOCK_STREAM : SOCK_DGRAM,
-                         addr->type == DUER_PROTO_TCP ? IPPROTO_TCP : IPPROTO_UDP);
-        DUER_LOGV("Result bcasoc_connect fd = %d", soc->fd);
-        if (soc->fd < 0) {
-            DUER_LOGE("socket create failed: %d", soc->fd);
-            return soc->fd;
+        fd = socket(AF_INET, addr->type == DUER_PROTO_TCP ? SOCK_STREAM : SOCK_DGRAM,
+                    addr->type == DUER_PROTO_TCP ? IPPROTO_TCP : IPPROTO_UDP);
+        DUER_LOGV("Result bcasoc_connect fd = %d", fd);
+        if (fd < 0) {
+            DUER_LOGE("socket create failed: %d", fd);
+            return fd;
         }
 #ifdef ENABLE_TCP_NODELAY
         int flag = 1;
-        if (setsockopt(soc->fd, IPPROTO_TCP, TCP_NODELAY, (char *)&flag, sizeof(flag)) == -1) {
+        if (setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, (char *)&flag, sizeof(flag)) == -1) {
             DUER_LOGW("setsockopt(TCP_NODELAY) failed\n");
         }
 #endif
@@ -289,20 +374,24 @@ duer_status_t bcasoc_connect(duer_socket_t ctx, const duer_addr_t *addr)
             addr_in.sin_addr.s_addr = htonl(ip_data);
         } else {
             DUER_LOGI("got ip failed!");
+            close(fd);
             return DUER_ERR_TRANS_DNS_FAIL;
         }
-        rs = connect(soc->fd, (struct sockaddr *)&addr_in, sizeof(addr_in));
+        rs = connect(fd, (struct sockaddr *)&addr_in, sizeof(addr_in));
 
         if (rs >= 0) {
 #if defined(NON_BLOCKING) && (NON_BLOCKING == 1)
-            int flags = fcntl(soc->fd, F_GETFL, 0);
-            fcntl(soc->fd, F_SETFL, flags | O_NONBLOCK);
+            int flags = fcntl(fd, F_GETFL, 0);
+            fcntl(fd, F_SETFL, flags | O_NONBLOCK);
 #endif
-            soc->_timer = duer_timer_acquire(bcasoc_timer_expired, soc, DUER_TIMER_ONCE);
-            //DUER_LOGI("before call bcasoc_timer_expired, soc:%p, fd:%d", soc, soc->fd);
-            bcasoc_timer_expired((void*)soc);
+            bcasoc_lock();
+            soc->fd = fd;
+            soc->is_recv_wait = 1;
+            bcasoc_wakeup();
+            bcasoc_unlock();
         } else {
             DUER_LOGE("Connect failed: rs = %d, errno = %d(%s)", rs, errno, strerror(errno));
+            close(fd);
         }
     }
 
@@ -329,22 +418,22 @@ duer_status_t bcasoc_send(duer_socket_t ctx, const void *data, duer_size_t size,
     tv.tv_usec = 0;
 
     rs = select(soc->fd + 1, NULL, &fdw, NULL, &tv);
-    DUER_LOGD("bcasoc_send select rs:%d, EINTR:%d, size:%d", rs, EINTR, size);
     if (FD_ISSET(soc->fd, &fdw)) {
         rs = send(soc->fd, data, size, MSG_FLAG);
-        DUER_LOGD("try send rs:%d!", rs);
     } else if (rs == 0) {
-        //DUER_LOGW("send timeout -> WOULD_BLOCK!!!");
         rs = DUER_ERR_TRANS_WOULD_BLOCK;
-        soc->is_send_block = 1;
-        soc->send_data_block_begin_time = duer_timestamp();
-    } else if (rs != EINTR) {
-        DUER_LOGE("write socket error %d:%s", rs, strerror(rs));
+        bcasoc_lock();
+        if (!soc->is_send_block) {
+            soc->is_send_block = 1;
+            soc->send_data_block_begin_time = duer_timestamp();
+            bcasoc_wakeup();
+        }
+        bcasoc_unlock();
+    } else if (errno != EINTR) {
         rs = DUER_ERR_TRANS_INTERNAL_ERROR;
     }
 
-    DUER_LOGD("Result bcasoc_send rs = %d", rs);
-    if (rs < 0) {
+    if (rs < 0 && rs != DUER_ERR_TRANS_WOULD_BLOCK) {
         DUER_LOGE("write socket error %d:%s", errno, strerror(errno));
     }
 
@@ -369,7 +458,6 @@ duer_status_t bcasoc_recv(duer_socket_t ctx, void *data, duer_size_t size, duer_
     tv.tv_usec = 0;
 
     rs = select(soc->fd + 1, &fdr, NULL, NULL, &tv);
-    DUER_LOGD("recv select result:%d, size:%d", rs, size);
     if (FD_ISSET(soc->fd, &fdr)) {
         rs = recv(soc->fd, data, size, MSG_FLAG);
         if (rs <= 0) {
@@ -379,21 +467,22 @@ duer_status_t bcasoc_recv(duer_socket_t ctx, void *data, duer_size_t size, duer_
     } else if (rs == 0) {
         rs = DUER_ERR_TRANS_WOULD_BLOCK;
     } else if (errno != EINTR) {
-        DUER_LOGE("read socket error %d:%s", rs, strerror(rs));
         rs = DUER_ERR_TRANS_INTERNAL_ERROR;
     }
 
-    if (rs > 0 ) {
-        if (soc->fd != -1) {
-            //DUER_LOGI("before call bcasoc_timer_expired, soc:%p, fd:%d", soc, soc->fd);
-            bcasoc_timer_expired(soc);
+    if (rs > 0 || rs == DUER_ERR_TRANS_WOULD_BLOCK) {
+        // watch the socket again, the next data is notified as soon as it comes
+        bcasoc_lock();
+        if (soc->fd != -1 && !soc->is_recv_wait) {
+            soc->is_recv_wait = 1;
+            bcasoc_wakeup();
         }
+        bcasoc_unlock();
     }
 
     if (rs < 0 && rs != DUER_ERR_TRANS_WOULD_BLOCK) {
         DUER_LOGE("read socket error %d:%s", errno, strerror(errno));
     }
-    DUER_LOGD("Result bcasoc_recv rs = %d", rs);
 
     return rs;
 }
@@ -435,14 +524,18 @@ duer_status_t bcasoc_close(duer_socket_t ctx)
 {
     bcasoc_t *soc = (bcasoc_t *)ctx;
     if (soc) {
-        duer_timer_stop(soc->_timer);
-        DUER_LOGI("stop timer:%p", soc->_timer);
         bcasoc_lock();
         if (soc->fd != -1) {
-            close(soc->fd);
+            if (s_io_running) {
+                soc->close_fd = soc->fd;
+                bcasoc_wakeup();
+            } else {
+                close(soc->fd);
+            }
             soc->fd = -1;
         }
-
+        soc->is_recv_wait = 0;
+        soc->is_send_block = 0;
         bcasoc_unlock();
     }
     return DUER_OK;
@@ -451,12 +544,23 @@ duer_status_t bcasoc_close(duer_socket_t ctx)
 duer_status_t bcasoc_destroy(duer_socket_t ctx)
 {
     bcasoc_t *soc = (bcasoc_t *)ctx;
+    bcasoc_t **link;
+
     bcasoc_lock();
-    soc->destroy = 1;
-    DUER_LOGI("start last timer:%p, soc:%p", soc->_timer, soc);
-    if (soc->_timer) {
-        duer_timer_start(soc->_timer, 200);
+    DUER_LOGI("destroy soc:%p", soc);
+    if (s_io_running) {
+        soc->destroy = 1;
+        bcasoc_wakeup();
     } else {
+        for (link = &s_sockets; *link != NULL; link = &(*link)->_next) {
+            if (*link == soc) {
+                *link = soc->_next;
+                break;
+            }
+        }
+        if (soc->close_fd != -1) {
+            close(soc->close_fd);
+        }
         DUER_FREE(soc);
     }
     bcasoc_unlock();
@@ -0,0 +1,29 @@
+#!/bin/sh
+#
+# Build baidu_ca_socket_adp.c on the host and run the readiness checks and
+# timings against a loopback TCP server, then a short run under
+# AddressSanitizer. DUER_SENDTIMEOUT is cut to 300 ms so the time-out case
+# runs quickly. ADP=<file> benches another version of the adapter, e.g. the
+# timer-driven one before the I/O thread:
+#
+#   git show dace26a^:./baidu_ca_socket_adp.c > /tmp/adp.c  (from ..)
+#   ADP=/tmp/adp.c ./run.sh
+#
+# Arguments are passed to socket_bench.
+#
+set -e
+cd "$(dirname "$0")"
+D=../../..
+ADP=${ADP:-../baidu_ca_socket_adp.c}
+build() {
+	gcc -O2 -Wall -pthread -DDUER_SENDTIMEOUT=300 "$@" \
+		-I.. -I$D/platform/include -I$D/framework/include -I$D/framework/core \
+		-I$D/modules/connagent -I$D/external/baidu_json \
+		socket_bench.c "$ADP" ../lightduer_timers.c ../lightduer_events.c \
+		-Wl,--wrap=select,--wrap=connect -lrt -o /tmp/socket_bench
+}
+build
+/tmp/socket_bench "$@"
+build -fsanitize=address -g
+/tmp/socket_bench 10 > /dev/null
+echo "PASS"
@@ -0,0 +1,493 @@
+/**
+ * Copyright (2017) Baidu Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * File: socket_bench.c
+ * Desc: Linux benchmark of the socket adapter readiness events.
+ *
+ * baidu_ca_socket_adp.c is driven through its bcasoc_* API against a TCP
+ * server on the loopback interface, the bench plays the server side.
+ * select() is wrapped (-Wl,--wrap=select) to count the calls made by the
+ * adapter's own threads, and connect() to give the sockets a fixed send
+ * buffer.
+ *
+ *   socket_bench [responses]
+ *
+ * Checks and measures:
+ * - RECV_RDY latency from the server write, over the given number of
+ *   responses, and that RECV_RDY fires once until the next recv;
+ * - select() calls per second on an idle, armed connection;
+ * - SEND_RDY latency after a blocked send, once the server drains;
+ * - SEND_TIMEOUT after DUER_SENDTIMEOUT on a send that stays blocked;
+ * - RECV_RDY and a recv error when the server closes;
+ * - connect/close/destroy cycles leave no descriptor behind.
+ *
+ * The callbacks run with the adapter lock held, like in the CA they only
+ * record the event; the bench thread then calls back into the adapter.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+
+#include "baidu_ca_adapter_internal.h"
+#include "lightduer_connagent.h"
+#include "lightduer_timestamp.h"
+
+#define BENCH_RECV_MAX_MS   (20)    // a readiness event, not a poll period
+#define BENCH_IDLE_MS       (2000)
+#define BENCH_IDLE_MAX      (1)     // select() calls per second while idle
+#define BENCH_CYCLES        (200)
+#define BENCH_CHUNK         (1024)
+#define BENCH_SNDBUF        (8192)
+
+#ifndef DUER_SENDTIMEOUT
+#define DUER_SENDTIMEOUT    8000 // 8s, as in the adapter
+#endif
+
+static int s_errors;
+
+#define BENCH_CHECK(cond, fmt, ...)                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            printf("FAIL %s:%d: " fmt "\n", __func__, __LINE__,         \
+                   ##__VA_ARGS__);                                      \
+            s_errors++;                                                 \
+        }                                                               \
+    } while (0)
+
+static pthread_mutex_t s_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_cond = PTHREAD_COND_INITIALIZER;
+static int s_events[DUER_TEVT_SEND_TIMEOUT + 1];
+static double s_event_us[DUER_TEVT_SEND_TIMEOUT + 1];
+
+static pthread_t s_main_thread;
+static volatile unsigned long s_adapter_selects;
+
+void duer_debug(duer_u32_t level, const char *file, duer_u32_t line, const char *fmt, ...)
+{
+}
+
+void *duer_malloc(duer_size_t size)
+{
+    return malloc(size);
+}
+
+void duer_free(void *ptr)
+{
+    free(ptr);
+}
+
+static double now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+duer_u32_t duer_timestamp(void)
+{
+    return (duer_u32_t)(now_us() / 1000);
+}
+
+int __real_select(int nfds, fd_set *r, fd_set *w, fd_set *e, struct timeval *timeout);
+
+int __wrap_select(int nfds, fd_set *r, fd_set *w, fd_set *e, struct timeval *timeout)
+{
+    if (!pthread_equal(pthread_self(), s_main_thread)) {
+        __sync_fetch_and_add(&s_adapter_selects, 1);
+    }
+    return __real_select(nfds, r, w, e, timeout);
+}
+
+int __real_connect(int fd, const struct sockaddr *addr, socklen_t len);
+
+/* A fixed send buffer, else Linux grows it and a blocked send unblocks itself */
+int __wrap_connect(int fd, const struct sockaddr *addr, socklen_t len)
+{
+    int sndbuf = BENCH_SNDBUF;
+
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    return __real_connect(fd, addr, len);
+}
+
+static void bench_callback(duer_transevt_e event)
+{
+    if (event < 0 || event > DUER_TEVT_SEND_TIMEOUT) {
+        return;
+    }
+    pthread_mutex_lock(&s_mutex);
+    s_events[event]++;
+    s_event_us[event] = now_us();
+    pthread_cond_broadcast(&s_cond);
+    pthread_mutex_unlock(&s_mutex);
+}
+
+static void events_reset(void)
+{
+    pthread_mutex_lock(&s_mutex);
+    memset(s_events, 0, sizeof(s_events));
+    pthread_mutex_unlock(&s_mutex);
+}
+
+static int events_count(duer_transevt_e event)
+{
+    int count;
+
+    pthread_mutex_lock(&s_mutex);
+    count = s_events[event];
+    pthread_mutex_unlock(&s_mutex);
+    return count;
+}
+
+/* Time of the event once it has fired `count' times, 0 on time-out */
+static double events_wait(duer_transevt_e event, int count, int timeout_ms)
+{
+    struct timespec deadline;
+    double at = 0;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&s_mutex);
+    while (s_events[event] < count) {
+        if (pthread_cond_timedwait(&s_cond, &s_mutex, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    if (s_events[event] >= count) {
+        at = s_event_us[event];
+    }
+    pthread_mutex_unlock(&s_mutex);
+    return at;
+}
+
+/* The first of two events to fire, with its time; DUER_TEVT_NONE on time-out */
+static duer_transevt_e events_wait_first(duer_transevt_e a, duer_transevt_e b, int timeout_ms,
+                                         double *at)
+{
+    duer_transevt_e first = DUER_TEVT_NONE;
+    int i;
+
+    for (i = 0; i < timeout_ms && first == DUER_TEVT_NONE; i++) {
+        usleep(1000);
+        pthread_mutex_lock(&s_mutex);
+        if (s_events[a]) {
+            first = a;
+        } else if (s_events[b]) {
+            first = b;
+        }
+        if (first != DUER_TEVT_NONE) {
+            *at = s_event_us[first];
+        }
+        pthread_mutex_unlock(&s_mutex);
+    }
+    return first;
+}
+
+static int count_fds(void)
+{
+    DIR *dir = opendir("/proc/self/fd");
+    struct dirent *entry;
+    int count = 0;
+
+    if (dir == NULL) {
+        return -1;
+    }
+    while ((entry = readdir(dir)) != NULL) {
+        count += entry->d_name[0] != '.';
+    }
+    closedir(dir);
+    return count;
+}
+
+static int server_listen(duer_u16_t *port)
+{
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    int rcvbuf = 4096;
+    int one = 1;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    // keep the window small, so a send blocks soon
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+        perror("listen");
+        exit(2);
+    }
+    getsockname(fd, (struct sockaddr *)&addr, &len);
+    *port = ntohs(addr.sin_port);
+    return fd;
+}
+
+static duer_socket_t client_connect(int listen_fd, duer_u16_t port, int *server_fd)
+{
+    duer_addr_t addr;
+    duer_socket_t soc = bcasoc_create(bench_callback);
+    int rs;
+
+    addr.type = DUER_PROTO_TCP;
+    addr.port = port;
+    addr.host = "127.0.0.1";
+    addr.host_size = strlen(addr.host);
+    rs = bcasoc_connect(soc, &addr);
+    BENCH_CHECK(rs >= 0, "connect: %d", rs);
+    *server_fd = accept(listen_fd, NULL, NULL);
+    fcntl(*server_fd, F_SETFL, fcntl(*server_fd, F_GETFL, 0) | O_NONBLOCK);
+    return soc;
+}
+
+static void server_drain(int fd)
+{
+    char buf[16384];
+
+    while (read(fd, buf, sizeof(buf)) > 0) {
+    }
+}
+
+/* Read what is there, the next RECV_RDY is armed again */
+static int client_recv_all(duer_socket_t soc)
+{
+    char buf[512];
+    int total = 0;
+    int rs;
+
+    while ((rs = bcasoc_recv(soc, buf, sizeof(buf), NULL)) > 0) {
+        total += rs;
+    }
+    BENCH_CHECK(rs == DUER_ERR_TRANS_WOULD_BLOCK, "recv ended with %d", rs);
+    return total;
+}
+
+static void bench_recv(duer_socket_t soc, int server_fd, int responses)
+{
+    static const char response[64] = "response";
+    double sum = 0, max = 0;
+    int i;
+
+    events_reset();
+    for (i = 0; i < responses; i++) {
+        double start, at;
+
+        usleep(1000 * (1 + i % 7));
+        start = now_us();
+        BENCH_CHECK(write(server_fd, response, sizeof(response)) == sizeof(response), "server write");
+        at = events_wait(DUER_TEVT_RECV_RDY, i + 1, 1000);
+        BENCH_CHECK(at > 0, "no RECV_RDY for response %d", i);
+        if (at <= 0) {
+            break;
+        }
+        sum += at - start;
+        if (at - start > max) {
+            max = at - start;
+        }
+        if (i == 0) {
+            // RECV_RDY is not repeated before the data is read
+            BENCH_CHECK(write(server_fd, response, sizeof(response)) == sizeof(response), "server write");
+            usleep(300 * 1000);
+            BENCH_CHECK(events_count(DUER_TEVT_RECV_RDY) == 1,
+                        "RECV_RDY %d times before recv", events_count(DUER_TEVT_RECV_RDY));
+        }
+        client_recv_all(soc);
+    }
+    printf("recv ready: %d responses, mean %.2f ms, max %.2f ms\n",
+           i, i ? sum / i / 1000 : 0, max / 1000);
+    BENCH_CHECK(max / 1000 <= BENCH_RECV_MAX_MS, "RECV_RDY %.2f ms after the write", max / 1000);
+}
+
+static void bench_idle(void)
+{
+    unsigned long selects;
+
+    usleep(50 * 1000);
+    selects = s_adapter_selects;
+    usleep(BENCH_IDLE_MS * 1000);
+    selects = s_adapter_selects - selects;
+    printf("idle: %.1f select() calls/s\n", selects * 1000.0 / BENCH_IDLE_MS);
+    BENCH_CHECK(selects * 1000 / BENCH_IDLE_MS <= BENCH_IDLE_MAX,
+                "%lu select() calls in %d ms idle", selects, BENCH_IDLE_MS);
+}
+
+/*
+ * Send until the adapter reports a blocked send, and return when that was.
+ * The loopback may still move data into the peer window for a while, so
+ * with `settle_ms' the send has to stay blocked that long; a SEND_RDY in
+ * between is right and the filling goes on.
+ */
+static double client_fill(duer_socket_t soc, int settle_ms)
+{
+    static char chunk[BENCH_CHUNK];
+    double blocked;
+    int i, rs = 0;
+
+    events_reset();
+    for (i = 0; i < 100000; i++) {
+        rs = bcasoc_send(soc, chunk, sizeof(chunk), NULL);
+        if (rs == DUER_ERR_TRANS_WOULD_BLOCK) {
+            blocked = now_us();
+            if (settle_ms == 0 || events_wait(DUER_TEVT_SEND_RDY, 1, settle_ms) == 0) {
+                return blocked;
+            }
+            events_reset();
+            continue;
+        }
+        BENCH_CHECK(rs == sizeof(chunk), "send: %d", rs);
+        if (rs != sizeof(chunk)) {
+            break;
+        }
+    }
+    BENCH_CHECK(0, "the send never stayed blocked");
+    return 0;
+}
+
+static void bench_send(duer_socket_t soc, int server_fd)
+{
+    duer_transevt_e event = DUER_TEVT_NONE;
+    double start, at;
+    int tries;
+
+    if (client_fill(soc, 100) == 0) {
+        return;
+    }
+    start = now_us();
+    server_drain(server_fd);
+    at = events_wait(DUER_TEVT_SEND_RDY, 1, 1000);
+    BENCH_CHECK(at > 0, "no SEND_RDY after the drain");
+    if (at > 0) {
+        printf("send ready: %.2f ms after the drain\n", (at - start) / 1000);
+        BENCH_CHECK(at - start <= BENCH_RECV_MAX_MS * 1000, "SEND_RDY %.2f ms after the drain",
+                    (at - start) / 1000);
+    }
+
+    // blocked again and left so, until the time-out
+    for (tries = 0; tries < 20 && event != DUER_TEVT_SEND_TIMEOUT; tries++) {
+        start = client_fill(soc, 0);
+        if (start == 0) {
+            return;
+        }
+        event = events_wait_first(DUER_TEVT_SEND_TIMEOUT, DUER_TEVT_SEND_RDY,
+                                  DUER_SENDTIMEOUT * 2, &at);
+        BENCH_CHECK(event != DUER_TEVT_NONE, "neither SEND_TIMEOUT nor SEND_RDY");
+        if (event == DUER_TEVT_NONE) {
+            return;
+        }
+    }
+    BENCH_CHECK(event == DUER_TEVT_SEND_TIMEOUT, "the send never stayed blocked until the time-out");
+    if (event == DUER_TEVT_SEND_TIMEOUT) {
+        printf("send timeout: after %.0f ms, DUER_SENDTIMEOUT %d ms\n", (at - start) / 1000,
+               DUER_SENDTIMEOUT);
+        BENCH_CHECK(at - start >= (DUER_SENDTIMEOUT - 10) * 1000.0
+                    && at - start <= (DUER_SENDTIMEOUT + BENCH_RECV_MAX_MS) * 1000.0,
+                    "SEND_TIMEOUT after %.0f ms", (at - start) / 1000);
+    }
+    server_drain(server_fd);
+    BENCH_CHECK(events_wait(DUER_TEVT_SEND_RDY, 1, 1000) > 0, "no SEND_RDY after the time-out");
+}
+
+static void bench_peer_close(duer_socket_t soc, int server_fd)
+{
+    char buf[64];
+    int rs;
+
+    server_drain(server_fd);
+    events_reset();
+    close(server_fd);
+    BENCH_CHECK(events_wait(DUER_TEVT_RECV_RDY, 1, 1000) > 0, "no RECV_RDY on the peer close");
+    rs = bcasoc_recv(soc, buf, sizeof(buf), NULL);
+    BENCH_CHECK(rs == DUER_ERR_TRANS_INTERNAL_ERROR, "recv after the peer close: %d", rs);
+}
+
+static void bench_cycles(int listen_fd, duer_u16_t port)
+{
+    double start;
+    int fds;
+    int i;
+
+    // the sockets closed before are closed by the adapter thread
+    usleep(300 * 1000);
+    fds = count_fds();
+    start = now_us();
+
+    for (i = 0; i < BENCH_CYCLES; i++) {
+        int server_fd;
+        duer_socket_t soc = client_connect(listen_fd, port, &server_fd);
+
+        if (i & 1) {
+            // let the adapter see data on the socket it is about to close
+            BENCH_CHECK(write(server_fd, "x", 1) == 1, "server write");
+        }
+        bcasoc_close(soc);
+        bcasoc_destroy(soc);
+        close(server_fd);
+    }
+    printf("cycles: %d connect/close/destroy, %.0f us each\n", BENCH_CYCLES,
+           (now_us() - start) / BENCH_CYCLES);
+
+    // the adapter closes and frees in its own thread
+    for (i = 0; i < 50 && count_fds() != fds; i++) {
+        usleep(20 * 1000);
+    }
+    BENCH_CHECK(count_fds() == fds, "%d descriptors left after the cycles", count_fds() - fds);
+}
+
+int main(int argc, char *argv[])
+{
+    int responses = argc > 1 ? atoi(argv[1]) : 40;
+    duer_socket_t soc;
+    duer_u16_t port;
+    int listen_fd, server_fd;
+
+    s_main_thread = pthread_self();
+    bcasoc_initialize();
+    listen_fd = server_listen(&port);
+
+    soc = client_connect(listen_fd, port, &server_fd);
+    bench_recv(soc, server_fd, responses);
+    bench_idle();
+    bench_send(soc, server_fd);
+    bench_peer_close(soc, server_fd);
+    bcasoc_close(soc);
+    bcasoc_destroy(soc);
+
+    bench_cycles(listen_fd, port);
+    close(listen_fd);
+
+    usleep(100 * 1000);
+    if (s_errors) {
+        printf("%d checks failed\n", s_errors);
+        return 1;
+    }
+    return 0;
+}
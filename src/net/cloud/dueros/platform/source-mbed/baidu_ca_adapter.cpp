@@ -25,6 +25,7 @@
 #include "lightduer_debug.h"
 #include "lightduer_timestamp.h"
 #include "lightduer_sleep.h"
+#include "lightduer_semaphore.h"
 #include "lightduer_net_transport.h"
 #include "lightduer_thread.h"
 #include "lightduer_thread_impl.h"
@@ -76,6 +77,12 @@ void baidu_ca_adapter_initialize(void)
         bcamutex_unlock,
         bcamutex_destroy);
 
+    baidu_ca_semaphore_init(
+        bcasem_create,
+        bcasem_wait,
+        bcasem_release,
+        bcasem_destroy);
+
     baidu_ca_debug_init(NULL, bcadbg);
 
     bcasoc_initialize();
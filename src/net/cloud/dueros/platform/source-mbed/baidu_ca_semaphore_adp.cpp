@@ -0,0 +1,65 @@
+/**
+ * Copyright (2017) Baidu Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * File: baidu_ca_semaphore_adp.cpp
+ * Desc: Adapt the semaphore function to mbed.
+ */
+
+#include <mbed.h>
+#include "baidu_ca_adapter_internal.h"
+#include "lightduer_semaphore.h"
+#include "lightduer_log.h"
+
+duer_semaphore_t bcasem_create(void)
+{
+    duer_semaphore_t sem = new rtos::Semaphore(0);
+
+    return sem;
+}
+
+duer_status_t bcasem_wait(duer_semaphore_t sem, duer_u32_t timeout)
+{
+    rtos::Semaphore *object = reinterpret_cast<rtos::Semaphore *>(sem);
+
+    if (object == NULL || object->wait(timeout) <= 0) {
+        return DUER_ERR_FAILED;
+    }
+
+    return DUER_OK;
+}
+
+duer_status_t bcasem_release(duer_semaphore_t sem)
+{
+    rtos::Semaphore *object = reinterpret_cast<rtos::Semaphore *>(sem);
+
+    if (object == NULL || object->release() != osOK) {
+        DUER_LOGE("release failed: %p", object);
+        return DUER_ERR_FAILED;
+    }
+
+    return DUER_OK;
+}
+
+duer_status_t bcasem_destroy(duer_semaphore_t sem)
+{
+    rtos::Semaphore *object = reinterpret_cast<rtos::Semaphore *>(sem);
+
+    if (object) {
+        delete object;
+    }
+
+    return DUER_OK;
+}
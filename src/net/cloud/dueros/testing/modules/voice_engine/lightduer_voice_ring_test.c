@@ -0,0 +1,380 @@
+/**
+ * Copyright (2017) Baidu Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test.h"
+
+#include <string.h>
+
+#undef DUER_MEMORY_DEBUG
+#include "lightduer_memory.h"
+#include "lightduer_voice_ring.h"
+
+static const size_t SLOTS = 8;
+static const size_t CAPACITY = 597;
+// one segment every tick, the uplinks below are driven by the same tick
+static const int TICKS = 400;
+
+static int s_malloc_count;
+static int s_free_count;
+
+DUER_INT void* duer_malloc(duer_size_t size) {
+    s_malloc_count++;
+    return test_malloc(size);
+}
+
+DUER_INT void duer_free(void* ptr) {
+    s_free_count++;
+    test_free(ptr);
+}
+
+DUER_INT void duer_debug(duer_u32_t level, const char* file, duer_u32_t line,
+                         const char* fmt, ...) {
+}
+
+//================ spill store, a FIFO of records in memory
+
+#define SPILL_SIZE  (256 * 1024)
+
+static char s_spill[SPILL_SIZE];
+static size_t s_spill_head;
+static size_t s_spill_tail;
+static int s_spill_fail;
+
+static int spill_write(const void *data, size_t size) {
+    if (s_spill_fail || s_spill_tail + sizeof(size) + size > SPILL_SIZE) {
+        return DUER_ERR_FAILED;
+    }
+    memcpy(s_spill + s_spill_tail, &size, sizeof(size));
+    memcpy(s_spill + s_spill_tail + sizeof(size), data, size);
+    s_spill_tail += sizeof(size) + size;
+    return DUER_OK;
+}
+
+static int spill_read(void *data, size_t size) {
+    size_t len;
+
+    if (s_spill_head == s_spill_tail) {
+        return DUER_ERR_FAILED;
+    }
+    memcpy(&len, s_spill + s_spill_head, sizeof(len));
+    if (len > size) {
+        return DUER_ERR_FAILED;
+    }
+    memcpy(data, s_spill + s_spill_head + sizeof(len), len);
+    s_spill_head += sizeof(len) + len;
+    memmove(s_spill, s_spill + s_spill_head, s_spill_tail - s_spill_head);
+    s_spill_tail -= s_spill_head;
+    s_spill_head = 0;
+    return (int)len;
+}
+
+static void spill_reset(void) {
+    s_spill_head = s_spill_tail = 0;
+}
+
+static const duer_voice_spill_t SPILL = {
+    spill_write,
+    spill_read,
+    spill_reset,
+};
+
+//================ the simulation
+
+typedef enum {
+    UPLINK_FAST,    // one segment every tick
+    UPLINK_SLOW,    // one segment every 3 ticks
+    UPLINK_BURSTY,  // stalled for 30 ticks, then 4 segments every tick for 10 ticks
+} uplink_t;
+
+typedef struct {
+    int produced;
+    int received;
+    int out_of_order;
+    int blocked_ticks;
+    duer_bool eof;
+} result_t;
+
+static int uplink_budget(uplink_t uplink, int tick) {
+    switch (uplink) {
+    case UPLINK_SLOW:
+        return tick % 3 == 0 ? 1 : 0;
+    case UPLINK_BURSTY:
+        return tick % 40 < 30 ? 0 : 4;
+    default:
+        return 1;
+    }
+}
+
+static void put_seq(duer_voice_seg_t *seg, int seq) {
+    memset(seg->data, (char)seq, CAPACITY);
+    memcpy(seg->data, &seq, sizeof(seq));
+    seg->len = CAPACITY;
+}
+
+static void uplink_send(duer_voice_ring_t *ring, int budget, int *last, result_t *result) {
+    duer_voice_seg_t *seg = NULL;
+    int seq;
+
+    while (budget-- > 0 && (seg = duer_voice_ring_front(ring)) != NULL) {
+        assert_int_equal(seg->len, CAPACITY);
+        memcpy(&seq, seg->data, sizeof(seq));
+        assert_int_equal(seg->data[CAPACITY - 1], (duer_u8_t)seq);
+        if (seq <= *last) {
+            result->out_of_order++;
+        }
+        *last = seq;
+        result->received++;
+        if (seg->eof) {
+            result->eof = DUER_TRUE;
+        }
+        duer_voice_ring_release(ring, DUER_TRUE);
+    }
+}
+
+static void simulate(duer_voice_ring_t *ring, duer_voice_overflow policy,
+                     uplink_t uplink, result_t *result) {
+    int tick = 0;
+    int last = -1;
+    int seq;
+
+    memset(result, 0, sizeof(*result));
+
+    for (seq = 0; seq < TICKS; seq++, tick++) {
+        put_seq(duer_voice_ring_producer(ring), seq);
+        duer_voice_ring_producer(ring)->eof = seq == TICKS - 1;
+        // what duer_voice_commit() does: wait for the sender
+        while (policy == DUER_VOICE_OVERFLOW_BLOCK && duer_voice_ring_full(ring)) {
+            uplink_send(ring, uplink_budget(uplink, tick++), &last, result);
+            result->blocked_ticks++;
+        }
+        duer_voice_ring_commit(ring, policy);
+        result->produced++;
+        uplink_send(ring, uplink_budget(uplink, tick), &last, result);
+    }
+
+    // drain after the recording
+    for (; duer_voice_ring_front(ring) != NULL; tick++) {
+        uplink_send(ring, uplink_budget(uplink, tick), &last, result);
+    }
+}
+
+static duer_voice_ring_t *create_ring(void) {
+    duer_voice_ring_t *ring = NULL;
+
+    s_malloc_count = 0;
+    s_free_count = 0;
+    spill_reset();
+    s_spill_fail = 0;
+
+    ring = duer_voice_ring_create(SLOTS, CAPACITY);
+    assert_non_null(ring);
+    assert_int_equal(s_malloc_count, 1);
+    return ring;
+}
+
+static void destroy_ring(duer_voice_ring_t *ring) {
+    duer_voice_ring_destroy(ring);
+    // one allocation per ring, whatever the uplink does
+    assert_int_equal(s_malloc_count, 1);
+    assert_int_equal(s_free_count, 1);
+}
+
+//================
+
+void duer_voice_ring_create_test(void** state) {
+    assert_null(duer_voice_ring_create(0, CAPACITY));
+    assert_null(duer_voice_ring_create(255, CAPACITY));
+    assert_null(duer_voice_ring_create(SLOTS, 0));
+    assert_null(duer_voice_ring_create(SLOTS, 0x10000));
+
+    duer_voice_ring_t *ring = create_ring();
+    assert_int_equal(duer_voice_ring_capacity(ring), CAPACITY);
+    assert_non_null(duer_voice_ring_producer(ring));
+    assert_null(duer_voice_ring_front(ring));
+    assert_false(duer_voice_ring_full(ring));
+    destroy_ring(ring);
+}
+
+void duer_voice_ring_fast_uplink_test(void** state) {
+    duer_voice_overflow policy;
+    duer_voice_ring_stat_t stat;
+    result_t result;
+
+    for (policy = DUER_VOICE_OVERFLOW_DROP_NEWEST; policy <= DUER_VOICE_OVERFLOW_SPILL; policy++) {
+        duer_voice_ring_t *ring = create_ring();
+        duer_voice_ring_set_spill(ring, &SPILL);
+        simulate(ring, policy, UPLINK_FAST, &result);
+        duer_voice_ring_get_stat(ring, &stat);
+
+        assert_int_equal(result.received, TICKS);
+        assert_int_equal(result.out_of_order, 0);
+        assert_true(result.eof);
+        assert_int_equal(stat.dropped, 0);
+        assert_int_equal(stat.spilled, 0);
+        assert_int_equal(stat.fill_max, 1);
+        destroy_ring(ring);
+    }
+}
+
+void duer_voice_ring_slow_uplink_test(void** state) {
+    duer_voice_ring_stat_t stat;
+    result_t result;
+    duer_voice_ring_t *ring = NULL;
+
+    // the uplink takes one third, the rest beyond the slots is dropped
+    ring = create_ring();
+    simulate(ring, DUER_VOICE_OVERFLOW_DROP_NEWEST, UPLINK_SLOW, &result);
+    duer_voice_ring_get_stat(ring, &stat);
+    assert_int_equal(result.out_of_order, 0);
+    assert_true(result.eof);
+    assert_int_equal(stat.fill_max, SLOTS);
+    assert_int_equal(stat.sent + stat.dropped, TICKS);
+    assert_int_equal(stat.sent, result.received);
+    assert_true(stat.dropped > TICKS / 2);
+    destroy_ring(ring);
+
+    ring = create_ring();
+    simulate(ring, DUER_VOICE_OVERFLOW_DROP_OLDEST, UPLINK_SLOW, &result);
+    duer_voice_ring_get_stat(ring, &stat);
+    assert_int_equal(result.out_of_order, 0);
+    assert_true(result.eof);
+    assert_int_equal(stat.committed, TICKS);
+    assert_int_equal(stat.sent + stat.dropped, TICKS);
+    assert_true(stat.dropped > TICKS / 2);
+    destroy_ring(ring);
+
+    // nothing is lost when the recorder waits or the store takes the rest
+    ring = create_ring();
+    simulate(ring, DUER_VOICE_OVERFLOW_BLOCK, UPLINK_SLOW, &result);
+    duer_voice_ring_get_stat(ring, &stat);
+    assert_int_equal(result.received, TICKS);
+    assert_int_equal(result.out_of_order, 0);
+    assert_int_equal(stat.dropped, 0);
+    assert_true(result.blocked_ticks > 0);
+    destroy_ring(ring);
+
+    ring = create_ring();
+    duer_voice_ring_set_spill(ring, &SPILL);
+    simulate(ring, DUER_VOICE_OVERFLOW_SPILL, UPLINK_SLOW, &result);
+    duer_voice_ring_get_stat(ring, &stat);
+    assert_int_equal(result.received, TICKS);
+    assert_int_equal(result.out_of_order, 0);
+    assert_true(result.eof);
+    assert_int_equal(stat.dropped, 0);
+    assert_true(stat.spilled > 0);
+    assert_int_equal(stat.spilled, stat.restored);
+    assert_int_equal(stat.spill_fill, 0);
+    destroy_ring(ring);
+}
+
+void duer_voice_ring_bursty_uplink_test(void** state) {
+    duer_voice_ring_stat_t stat;
+    result_t result;
+    duer_voice_ring_t *ring = NULL;
+
+    // the uplink keeps up on average, the slots absorb part of the stalls
+    ring = create_ring();
+    simulate(ring, DUER_VOICE_OVERFLOW_DROP_OLDEST, UPLINK_BURSTY, &result);
+    duer_voice_ring_get_stat(ring, &stat);
+    assert_int_equal(result.out_of_order, 0);
+    assert_true(result.eof);
+    assert_int_equal(stat.sent + stat.dropped, TICKS);
+    assert_true(stat.dropped > 0);
+    assert_int_equal(stat.fill_max, SLOTS);
+    destroy_ring(ring);
+
+    ring = create_ring();
+    duer_voice_ring_set_spill(ring, &SPILL);
+    simulate(ring, DUER_VOICE_OVERFLOW_SPILL, UPLINK_BURSTY, &result);
+    duer_voice_ring_get_stat(ring, &stat);
+    assert_int_equal(result.received, TICKS);
+    assert_int_equal(result.out_of_order, 0);
+    assert_int_equal(stat.dropped, 0);
+    assert_int_equal(stat.spilled, stat.restored);
+    destroy_ring(ring);
+
+    // a failing store falls back to drop the oldest
+    ring = create_ring();
+    duer_voice_ring_set_spill(ring, &SPILL);
+    s_spill_fail = 1;
+    simulate(ring, DUER_VOICE_OVERFLOW_SPILL, UPLINK_BURSTY, &result);
+    duer_voice_ring_get_stat(ring, &stat);
+    assert_int_equal(result.out_of_order, 0);
+    assert_true(result.eof);
+    assert_int_equal(stat.spilled, 0);
+    assert_int_equal(stat.sent + stat.dropped, TICKS);
+    destroy_ring(ring);
+}
+
+void duer_voice_ring_inflight_test(void** state) {
+    duer_voice_ring_t *ring = create_ring();
+    duer_voice_ring_stat_t stat;
+    duer_voice_seg_t *inflight = NULL;
+    int i;
+
+    for (i = 0; i < (int)SLOTS; i++) {
+        put_seq(duer_voice_ring_producer(ring), i);
+        assert_int_equal(duer_voice_ring_commit(ring, DUER_VOICE_OVERFLOW_DROP_OLDEST), DUER_OK);
+    }
+    inflight = duer_voice_ring_front(ring);
+    assert_ptr_equal(duer_voice_ring_inflight(ring), inflight);
+    assert_true(duer_voice_ring_full(ring));
+
+    // the segment in flight is never the one dropped or overwritten
+    put_seq(duer_voice_ring_producer(ring), SLOTS);
+    assert_int_equal(duer_voice_ring_commit(ring, DUER_VOICE_OVERFLOW_DROP_OLDEST), DUER_OK);
+    assert_int_equal(*(int *)inflight->data, 0);
+    assert_ptr_equal(duer_voice_ring_front(ring), inflight);
+    duer_voice_ring_release(ring, DUER_TRUE);
+    assert_int_equal(*(int *)duer_voice_ring_front(ring)->data, 2);
+
+    // the eof segment is kept with DUER_VOICE_OVERFLOW_DROP_NEWEST
+    put_seq(duer_voice_ring_producer(ring), SLOTS + 1);
+    assert_int_equal(duer_voice_ring_commit(ring, DUER_VOICE_OVERFLOW_DROP_NEWEST), DUER_OK);
+    put_seq(duer_voice_ring_producer(ring), SLOTS + 2);
+    assert_int_equal(duer_voice_ring_commit(ring, DUER_VOICE_OVERFLOW_DROP_NEWEST), DUER_ERR_FAILED);
+    assert_int_equal(duer_voice_ring_producer(ring)->len, 0);
+    put_seq(duer_voice_ring_producer(ring), SLOTS + 3);
+    duer_voice_ring_producer(ring)->eof = 1;
+    assert_int_equal(duer_voice_ring_commit(ring, DUER_VOICE_OVERFLOW_DROP_NEWEST), DUER_OK);
+
+    duer_voice_ring_get_stat(ring, &stat);
+    assert_int_equal(stat.committed, SLOTS + 3);
+    assert_int_equal(stat.dropped, 3);
+    assert_int_equal(stat.fill, SLOTS);
+    assert_int_equal(stat.fill_max, SLOTS);
+
+    // a late release after the reset is ignored
+    duer_voice_ring_reset(ring);
+    assert_null(duer_voice_ring_inflight(ring));
+    duer_voice_ring_release(ring, DUER_TRUE);
+    assert_null(duer_voice_ring_front(ring));
+    duer_voice_ring_get_stat(ring, &stat);
+    assert_int_equal(stat.fill, 0);
+    assert_int_equal(stat.sent, 1);
+
+    duer_voice_ring_clear_stat(ring);
+    duer_voice_ring_get_stat(ring, &stat);
+    assert_int_equal(stat.slots, SLOTS);
+    assert_int_equal(stat.committed, 0);
+    destroy_ring(ring);
+}
+
+CMOCKA_UNIT_TEST(duer_voice_ring_create_test);
+CMOCKA_UNIT_TEST(duer_voice_ring_fast_uplink_test);
+CMOCKA_UNIT_TEST(duer_voice_ring_slow_uplink_test);
+CMOCKA_UNIT_TEST(duer_voice_ring_bursty_uplink_test);
+CMOCKA_UNIT_TEST(duer_voice_ring_inflight_test);
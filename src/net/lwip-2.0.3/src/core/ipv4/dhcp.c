@@ -720,6 +720,26 @@ void dhcp_cleanup(struct netif *netif)
 err_t
 dhcp_start(struct netif *netif)
 {
+#if LWIP_XR_IMPL
+  return dhcp_start_reboot(netif, NULL);
+}
+
+/**
+ * @ingroup dhcp4
+ * Start DHCP negotiation from the INIT-REBOOT state.
+ *
+ * The client asks the server to confirm a previously leased address with a
+ * broadcast REQUEST, skipping DISCOVER/OFFER. A NAK or no reply falls back to
+ * the normal discovery. A NULL or any address behaves as dhcp_start().
+ *
+ * @param netif The lwIP network interface
+ * @param ipaddr The address leased last time
+ * @return lwIP error code
+ */
+err_t
+dhcp_start_reboot(struct netif *netif, const ip4_addr_t *ipaddr)
+{
+#endif /* LWIP_XR_IMPL */
   struct dhcp *dhcp;
   err_t result;
 
@@ -769,6 +789,25 @@ dhcp_start(struct netif *netif)
   }
   dhcp->pcb_allocated = 1;
 
+#if LWIP_XR_IMPL
+  if ((ipaddr != NULL) && !ip4_addr_isany(ipaddr)) {
+    ip4_addr_copy(dhcp->offered_ip_addr, *ipaddr);
+#if LWIP_DHCP_CHECK_LINK_UP
+    if (!netif_is_link_up(netif)) {
+      /* set state REBOOTING and wait for dhcp_network_changed() to call dhcp_reboot() */
+      dhcp_set_state(dhcp, DHCP_STATE_REBOOTING);
+      return ERR_OK;
+    }
+#endif /* LWIP_DHCP_CHECK_LINK_UP */
+    result = dhcp_reboot(netif);
+    if (result != ERR_OK) {
+      dhcp_stop(netif);
+      return ERR_MEM;
+    }
+    return result;
+  }
+#endif /* LWIP_XR_IMPL */
+
 #if LWIP_DHCP_CHECK_LINK_UP
   if (!netif_is_link_up(netif)) {
     /* set state INIT and wait for dhcp_network_changed() to call dhcp_discover() */
@@ -45,6 +45,11 @@
 #include "mbedtls/aesni.h"
 #endif
 
+#if defined(MBEDTLS_AES_C) && defined(MBEDTLS_AES_ALT)
+#include "mbedtls/aes.h"
+#define GCM_AES_BULK
+#endif
+
 #if defined(MBEDTLS_SELF_TEST) && defined(MBEDTLS_AES_C)
 #if defined(MBEDTLS_PLATFORM_C)
 #include "mbedtls/platform.h"
@@ -344,6 +349,77 @@ int mbedtls_gcm_starts( mbedtls_gcm_context *ctx,
     return( 0 );
 }
 
+#if defined(GCM_AES_BULK)
+/*
+ * With the crypto engine, a run of counter blocks is encrypted in one
+ * submission, in the key stream buffer of the AES context, and then hashed
+ * block by block with the 4-bit GHASH tables.
+ */
+static int gcm_is_aes( const mbedtls_gcm_context *ctx )
+{
+    mbedtls_cipher_type_t type = ctx->cipher_ctx.cipher_info->type;
+
+    return( type == MBEDTLS_CIPHER_AES_128_ECB ||
+            type == MBEDTLS_CIPHER_AES_192_ECB ||
+            type == MBEDTLS_CIPHER_AES_256_ECB );
+}
+
+static int gcm_update_bulk( mbedtls_gcm_context *ctx,
+                size_t length,
+                const unsigned char *input,
+                unsigned char *output )
+{
+    int ret;
+    mbedtls_aes_context *aes = ctx->cipher_ctx.cipher_ctx;
+    unsigned char *ectr = aes->ks;
+    unsigned char *ep;
+    size_t i, j, blocks;
+    size_t use_len;
+
+    while( length > 0 )
+    {
+        blocks = ( length + 15 ) / 16;
+        if( blocks > MBEDTLS_AES_ALT_BULK_BLOCKS )
+            blocks = MBEDTLS_AES_ALT_BULK_BLOCKS;
+
+        for( j = 0; j < blocks; j++ )
+        {
+            for( i = 16; i > 12; i-- )
+                if( ++ctx->y[i - 1] != 0 )
+                    break;
+
+            memcpy( ectr + j * 16, ctx->y, 16 );
+        }
+
+        if( ( ret = mbedtls_aes_crypt_ecb_bulk( aes, MBEDTLS_AES_ENCRYPT,
+                                blocks * 16, ectr, ectr ) ) != 0 )
+            return( ret );
+
+        for( ep = ectr; blocks > 0; blocks--, ep += 16 )
+        {
+            use_len = ( length < 16 ) ? length : 16;
+
+            for( i = 0; i < use_len; i++ )
+            {
+                if( ctx->mode == MBEDTLS_GCM_DECRYPT )
+                    ctx->buf[i] ^= input[i];
+                output[i] = ep[i] ^ input[i];
+                if( ctx->mode == MBEDTLS_GCM_ENCRYPT )
+                    ctx->buf[i] ^= output[i];
+            }
+
+            gcm_mult( ctx, ctx->buf, ctx->buf );
+
+            length -= use_len;
+            input += use_len;
+            output += use_len;
+        }
+    }
+
+    return( 0 );
+}
+#endif /* GCM_AES_BULK */
+
 int mbedtls_gcm_update( mbedtls_gcm_context *ctx,
                 size_t length,
                 const unsigned char *input,
@@ -369,6 +445,11 @@ int mbedtls_gcm_update( mbedtls_gcm_context *ctx,
 
     ctx->len += length;
 
+#if defined(GCM_AES_BULK)
+    if( gcm_is_aes( ctx ) )
+        return( gcm_update_bulk( ctx, length, input, output ) );
+#endif
+
     p = input;
     while( length > 0 )
     {
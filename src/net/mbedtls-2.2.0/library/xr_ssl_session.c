@@ -0,0 +1,299 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#include <string.h>
+#include "mbedtls/ssl.h"
+#include "mbedtls/xr_ssl_session.h"
+
+#if defined(MBEDTLS_XR_SESSION_CACHE) && defined(MBEDTLS_SSL_CLI_C)
+
+#include <stdlib.h>
+#include "kernel/os/os.h"
+
+#if defined(MBEDTLS_PLATFORM_C)
+#include "mbedtls/platform.h"
+#else
+#define mbedtls_calloc    calloc
+#define mbedtls_free      free
+#endif
+
+#ifndef MBEDTLS_XR_SESSION_CACHE_ENTRIES
+#define MBEDTLS_XR_SESSION_CACHE_ENTRIES    4
+#endif
+
+/* used when the server gives no ticket lifetime hint */
+#ifndef MBEDTLS_XR_SESSION_CACHE_TIMEOUT
+#define MBEDTLS_XR_SESSION_CACHE_TIMEOUT    (2 * 3600)  /* seconds */
+#endif
+
+#define XR_SSL_SESSION_HOST_LEN             64
+
+typedef struct xr_ssl_session_entry {
+	char                host[XR_SSL_SESSION_HOST_LEN];
+	uint16_t            port;
+	uint8_t             valid;
+	uint32_t            used;   /* ticks of last load/save, for LRU */
+	uint32_t            expire; /* ticks */
+	mbedtls_ssl_session session;
+} xr_ssl_session_entry_t;
+
+static xr_ssl_session_entry_t g_sess_cache[MBEDTLS_XR_SESSION_CACHE_ENTRIES];
+static xr_ssl_session_stats_t g_sess_stats;
+static OS_Mutex_t g_sess_mutex;
+
+static int xr_ssl_session_lock(void)
+{
+	if (!OS_MutexIsValid(&g_sess_mutex)) {
+		OS_ThreadSuspendScheduler();
+		if (!OS_MutexIsValid(&g_sess_mutex) &&
+		    OS_MutexCreate(&g_sess_mutex) != OS_OK) {
+			OS_ThreadResumeScheduler();
+			return -1;
+		}
+		OS_ThreadResumeScheduler();
+	}
+	return (OS_MutexLock(&g_sess_mutex, OS_WAIT_FOREVER) == OS_OK) ? 0 : -1;
+}
+
+static void xr_ssl_session_unlock(void)
+{
+	OS_MutexUnlock(&g_sess_mutex);
+}
+
+static void xr_ssl_session_entry_free(xr_ssl_session_entry_t *entry)
+{
+	mbedtls_ssl_session_free(&entry->session);
+	entry->valid = 0;
+}
+
+/* Copy without the peer certificate, only the verify result is needed */
+static int xr_ssl_session_copy(mbedtls_ssl_session *dst, const mbedtls_ssl_session *src)
+{
+	memcpy(dst, src, sizeof(mbedtls_ssl_session));
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+	dst->peer_cert = NULL;
+#endif
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+	dst->ticket = NULL;
+	if (src->ticket != NULL && src->ticket_len > 0) {
+		dst->ticket = mbedtls_calloc(1, src->ticket_len);
+		if (dst->ticket == NULL) {
+			dst->ticket_len = 0;
+			return -1;
+		}
+		memcpy(dst->ticket, src->ticket, src->ticket_len);
+	}
+#endif
+	return 0;
+}
+
+static xr_ssl_session_entry_t *xr_ssl_session_find(const char *host, uint16_t port)
+{
+	int i;
+	uint32_t now = OS_GetTicks();
+	xr_ssl_session_entry_t *entry;
+
+	for (i = 0; i < MBEDTLS_XR_SESSION_CACHE_ENTRIES; ++i) {
+		entry = &g_sess_cache[i];
+		if (!entry->valid || entry->port != port ||
+		    strncmp(entry->host, host, XR_SSL_SESSION_HOST_LEN) != 0)
+			continue;
+		if (OS_TimeAfterEqual(now, entry->expire)) {
+			xr_ssl_session_entry_free(entry);
+			g_sess_stats.expired++;
+			return NULL;
+		}
+		return entry;
+	}
+	return NULL;
+}
+
+static xr_ssl_session_entry_t *xr_ssl_session_victim(void)
+{
+	int i;
+	xr_ssl_session_entry_t *lru = &g_sess_cache[0];
+
+	for (i = 0; i < MBEDTLS_XR_SESSION_CACHE_ENTRIES; ++i) {
+		if (!g_sess_cache[i].valid)
+			return &g_sess_cache[i];
+		if (OS_TimeBefore(g_sess_cache[i].used, lru->used))
+			lru = &g_sess_cache[i];
+	}
+	g_sess_stats.evictions++;
+	return lru;
+}
+
+int xr_ssl_session_load(mbedtls_ssl_context *ssl, const char *host, uint16_t port)
+{
+	int ret = -1;
+	xr_ssl_session_entry_t *entry;
+
+	if (ssl == NULL || host == NULL || xr_ssl_session_lock() != 0)
+		return -1;
+
+	g_sess_stats.lookups++;
+	entry = xr_ssl_session_find(host, port);
+	if (entry != NULL && mbedtls_ssl_set_session(ssl, &entry->session) == 0) {
+		entry->used = OS_GetTicks();
+		g_sess_stats.hits++;
+		ret = 0;
+	}
+	xr_ssl_session_unlock();
+
+	return ret;
+}
+
+int xr_ssl_session_save(mbedtls_ssl_context *ssl, const char *host, uint16_t port)
+{
+	uint32_t lifetime = MBEDTLS_XR_SESSION_CACHE_TIMEOUT;
+	mbedtls_ssl_session *session;
+	xr_ssl_session_entry_t *entry;
+	int ret = -1;
+
+	if (ssl == NULL || ssl->session == NULL || host == NULL ||
+	    ssl->conf->endpoint != MBEDTLS_SSL_IS_CLIENT ||
+	    strlen(host) >= XR_SSL_SESSION_HOST_LEN)
+		return -1;
+
+	session = ssl->session;
+	/* nothing to resume with, the server supports neither IDs nor tickets */
+	if (session->id_len == 0
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+	    && session->ticket == NULL
+#endif
+	   )
+		return -1;
+
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+	if (session->ticket != NULL && session->ticket_lifetime != 0 &&
+	    session->ticket_lifetime < lifetime)
+		lifetime = session->ticket_lifetime;
+#endif
+
+	if (xr_ssl_session_lock() != 0)
+		return -1;
+
+	entry = xr_ssl_session_find(host, port);
+	if (entry != NULL) {
+		/* an abbreviated handshake keeps the master secret */
+		if (memcmp(entry->session.master, session->master,
+		           sizeof(session->master)) == 0)
+			g_sess_stats.resumed++;
+		xr_ssl_session_entry_free(entry);
+	} else {
+		entry = xr_ssl_session_victim();
+		if (entry->valid)
+			xr_ssl_session_entry_free(entry);
+	}
+
+	if (xr_ssl_session_copy(&entry->session, session) == 0) {
+		strcpy(entry->host, host);
+		entry->port = port;
+		entry->used = OS_GetTicks();
+		entry->expire = entry->used + OS_SecsToTicks(lifetime);
+		entry->valid = 1;
+		g_sess_stats.stores++;
+		ret = 0;
+	} else {
+		mbedtls_ssl_session_free(&entry->session);
+	}
+	xr_ssl_session_unlock();
+
+	return ret;
+}
+
+void xr_ssl_session_remove(const char *host, uint16_t port)
+{
+	xr_ssl_session_entry_t *entry;
+
+	if (host == NULL || xr_ssl_session_lock() != 0)
+		return;
+
+	entry = xr_ssl_session_find(host, port);
+	if (entry != NULL)
+		xr_ssl_session_entry_free(entry);
+	xr_ssl_session_unlock();
+}
+
+void xr_ssl_session_flush(void)
+{
+	int i;
+
+	if (xr_ssl_session_lock() != 0)
+		return;
+
+	for (i = 0; i < MBEDTLS_XR_SESSION_CACHE_ENTRIES; ++i) {
+		if (g_sess_cache[i].valid)
+			xr_ssl_session_entry_free(&g_sess_cache[i]);
+	}
+	xr_ssl_session_unlock();
+}
+
+void xr_ssl_session_get_stats(xr_ssl_session_stats_t *stats)
+{
+	if (stats == NULL || xr_ssl_session_lock() != 0)
+		return;
+
+	memcpy(stats, &g_sess_stats, sizeof(*stats));
+	xr_ssl_session_unlock();
+}
+
+#else /* MBEDTLS_XR_SESSION_CACHE && MBEDTLS_SSL_CLI_C */
+
+int xr_ssl_session_load(mbedtls_ssl_context *ssl, const char *host, uint16_t port)
+{
+	return -1;
+}
+
+int xr_ssl_session_save(mbedtls_ssl_context *ssl, const char *host, uint16_t port)
+{
+	return -1;
+}
+
+void xr_ssl_session_remove(const char *host, uint16_t port)
+{
+}
+
+void xr_ssl_session_flush(void)
+{
+}
+
+void xr_ssl_session_get_stats(xr_ssl_session_stats_t *stats)
+{
+	if (stats != NULL)
+		memset(stats, 0, sizeof(*stats));
+}
+
+#endif /* MBEDTLS_XR_SESSION_CACHE && MBEDTLS_SSL_CLI_C */
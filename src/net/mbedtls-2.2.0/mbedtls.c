@@ -276,6 +276,24 @@ int mbedtls_config_context(mbedtls_context *context, void *param, int verify)
 
 #if defined(MBEDTLS_SSL_CLI_C)
 
+/* Remember host:port, the handshake uses it to look up a cached session */
+static void mbedtls_session_key(mbedtls_context *context, const char *hostname,
+                                const struct sockaddr *name)
+{
+	const struct sockaddr_in *addr = (const struct sockaddr_in *)name;
+
+	context->peer_host[0] = '\0';
+	if (name->sa_family != AF_INET)
+		return;
+
+	if (hostname == NULL)
+		hostname = inet_ntoa(addr->sin_addr);
+	if (strlen(hostname) >= sizeof(context->peer_host))
+		return;
+	strcpy(context->peer_host, hostname);
+	context->peer_port = ntohs(addr->sin_port);
+}
+
 static int mbedtls_get_noblock(mbedtls_net_context *ctx)
 {
 	if (ctx == NULL) {
@@ -328,6 +346,7 @@ int mbedtls_connect(mbedtls_context *context, mbedtls_sock *fd, struct sockaddr
 	}
 	if (is_noblock == 1)
 		mbedtls_net_set_nonblock(net_fd);
+	mbedtls_session_key(pContext, hostname, ServerAddress);
 	mbedtls_dbg(inf, "Connect ok..\n");
 	return ret;
 }
@@ -433,6 +452,11 @@ int mbedtls_handshake(mbedtls_context *context, mbedtls_sock* fd)
 
 	mbedtls_ssl_set_bio(&(pContext->ssl), net_fd, mbedtls_net_send, mbedtls_net_recv, NULL);
 
+#if defined(MBEDTLS_SSL_CLI_C)
+	if (pContext->is_client == MBEDTLS_SSL_IS_CLIENT && pContext->peer_host[0] != '\0')
+		xr_ssl_session_load(&(pContext->ssl), pContext->peer_host, pContext->peer_port);
+#endif
+
 	while ((ret = mbedtls_ssl_handshake(&(pContext->ssl))) != 0) {
 		if( ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE ) {
 			mbedtls_dbg(err, "mbedtls_ssl_handshake failed.(%x)\n", ret);
@@ -463,9 +487,18 @@ int mbedtls_handshake(mbedtls_context *context, mbedtls_sock* fd)
 	}
 	if (ret == 0) {
 		mbedtls_dbg(inf, "Handshake ok(%s).\n", mbedtls_ssl_get_ciphersuite(&(pContext->ssl)));
+#if defined(MBEDTLS_SSL_CLI_C)
+		if (pContext->is_client == MBEDTLS_SSL_IS_CLIENT && pContext->peer_host[0] != '\0')
+			xr_ssl_session_save(&(pContext->ssl), pContext->peer_host, pContext->peer_port);
+#endif
 		return 0;
 	}
 exit:
+#if defined(MBEDTLS_SSL_CLI_C)
+	/* do not offer a session of a failed connection again */
+	if (pContext->is_client == MBEDTLS_SSL_IS_CLIENT && pContext->peer_host[0] != '\0')
+		xr_ssl_session_remove(pContext->peer_host, pContext->peer_port);
+#endif
 	return ret;
 }
 
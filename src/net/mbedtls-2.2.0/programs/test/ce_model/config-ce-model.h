@@ -0,0 +1,52 @@
+/*
+ *  Host configuration for testing the crypto engine AES layer
+ *
+ *  Copyright (C) 2006-2015, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of mbed TLS (https://tls.mbed.org)
+ */
+
+/*
+ * The default configuration with AES routed through aes_alt.c and the
+ * software CE model, plus the client session cache over the host OS model
+ * in kernel/os/os.h. Build with
+ *   -DMBEDTLS_CONFIG_FILE='<config-ce-model.h>' -Iprograms/test/ce_model
+ * and -DMBEDTLS_AES_ALT_SW_THRESHOLD=0 to send every block to the model.
+ */
+#ifndef MBEDTLS_CONFIG_CE_MODEL_H
+#define MBEDTLS_CONFIG_CE_MODEL_H
+
+#include "mbedtls/config.h"
+
+/* The x86 accelerators work on the software AES context */
+#undef MBEDTLS_AESNI_C
+#undef MBEDTLS_PADLOCK_C
+
+#define MBEDTLS_AES_ALT
+
+/* CE_Model_GetStats() is available, see hal_crypto_model.c */
+#define MBEDTLS_XR_CE_MODEL
+
+/* Same as config-xr-fast-cliserv.h */
+#if !defined(MBEDTLS_AES_ALT_SW_THRESHOLD)
+#define MBEDTLS_AES_ALT_SW_THRESHOLD        32
+#endif
+
+/* Same as config-xr-fast-cliserv.h */
+#define MBEDTLS_XR_SESSION_CACHE
+#define MBEDTLS_XR_SESSION_CACHE_ENTRIES    4
+
+#endif /* MBEDTLS_CONFIG_CE_MODEL_H */
@@ -0,0 +1,108 @@
+/*
+ *  Host stand-in for the XRadio crypto engine driver header
+ *
+ *  Copyright (C) 2006-2015, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of mbed TLS (https://tls.mbed.org)
+ */
+
+/*
+ * Only the AES part of include/driver/chip/hal_crypto.h, with the same
+ * names and values, so aes_alt.c builds on a PC against the software model
+ * in hal_crypto_model.c.
+ */
+#ifndef _DRIVER_CHIP_HAL_CRYPTO_H_
+#define _DRIVER_CHIP_HAL_CRYPTO_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    HAL_OK      = 0,
+    HAL_ERROR   = -1,
+    HAL_BUSY    = -2,
+    HAL_TIMEOUT = -3,
+    HAL_INVALID = -4
+} HAL_Status;
+
+#define CE_CTL_KEY_SEL_SHIFT                    (24)
+typedef enum {
+    CE_CTL_KEYSOURCE_INPUT          = 0         << CE_CTL_KEY_SEL_SHIFT,
+    CE_CTL_KEYSOURCE_SID            = 1         << CE_CTL_KEY_SEL_SHIFT
+} CE_CTL_KeySource;
+
+#define CE_CTL_OP_MODE_SHIFT                    (12)
+typedef enum {
+    CE_CTL_CRYPT_MODE_ECB           = 0         << CE_CTL_OP_MODE_SHIFT,
+    CE_CTL_CRYPT_MODE_CBC           = 1         << CE_CTL_OP_MODE_SHIFT
+} CE_CTL_Crypto_Mode;
+
+#define CE_CTL_AES_KEY_SIZE_SHIFT               (8)
+typedef enum {
+    CE_CTL_AES_KEYSIZE_128BITS      = 0         << CE_CTL_AES_KEY_SIZE_SHIFT,
+    CE_CTL_AES_KEYSIZE_192BITS      = 1         << CE_CTL_AES_KEY_SIZE_SHIFT,
+    CE_CTL_AES_KEYSIZE_256BITS      = 2         << CE_CTL_AES_KEY_SIZE_SHIFT
+} CE_CTL_AES_KeySize;
+
+typedef enum {
+    CE_CRYPT_MODE_ECB = CE_CTL_CRYPT_MODE_ECB,
+    CE_CRYPT_MODE_CBC = CE_CTL_CRYPT_MODE_CBC
+} CE_Crypto_Mode;
+
+typedef CE_CTL_KeySource CE_Crypto_KeySrc;
+typedef CE_CTL_AES_KeySize CE_AES_KeySize;
+
+#define AES_BLOCK_SIZE          (16)
+
+typedef struct {
+    struct {
+        CE_Crypto_Mode mode;
+        struct {
+            uint8_t iv[16];
+        };
+    };
+
+    struct {
+        CE_Crypto_KeySrc src;
+        uint8_t key[32];
+        CE_CTL_AES_KeySize keysize;
+    };
+} CE_AES_Config;
+
+/*
+ * Submission counters kept by the model, to check that the bulk paths
+ * really batch blocks.
+ */
+typedef struct {
+    unsigned long calls;
+    unsigned long bytes;
+    unsigned long dma_calls;    /* above 300 bytes, where the HAL uses DMA */
+} CE_Model_Stats;
+
+HAL_Status HAL_AES_Encrypt(CE_AES_Config *aes, uint8_t *plain, uint8_t *cipher, uint32_t size);
+HAL_Status HAL_AES_Decrypt(CE_AES_Config *aes, uint8_t *cipher, uint8_t *plain, uint32_t size);
+
+void CE_Model_GetStats(CE_Model_Stats *stats);
+void CE_Model_ResetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DRIVER_CHIP_HAL_CRYPTO_H_ */
@@ -0,0 +1,276 @@
+/*
+ *  Software model of the XRadio crypto engine AES interface
+ *
+ *  Copyright (C) 2006-2015, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of mbed TLS (https://tls.mbed.org)
+ */
+
+/*
+ * Implements HAL_AES_Encrypt()/HAL_AES_Decrypt() with the semantics of
+ * src/driver/chip/hal_crypto.c (ECB and CBC, trailing partial block zero
+ * padded, CBC IV written back), so that library/aes_alt.c and the GCM/CTR
+ * bulk paths can be run on a PC. The cipher is a plain byte oriented AES,
+ * deliberately unrelated to the table code in aes.c and aes_alt.c.
+ *
+ * selftest (NIST vectors) and benchmark are built against it with
+ *   cmake -DUSE_XR_CE_MODEL=ON
+ * which adds library/aes_alt.c and this file to the library and selects
+ * config-ce-model.h.
+ */
+
+#include "driver/chip/hal_crypto.h"
+
+#include <string.h>
+
+static const uint8_t sbox[256] =
+{
+    0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5, 0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
+    0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0, 0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
+    0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC, 0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+    0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A, 0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
+    0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0, 0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
+    0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B, 0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+    0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85, 0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
+    0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5, 0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
+    0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17, 0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+    0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88, 0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
+    0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C, 0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
+    0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9, 0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+    0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6, 0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
+    0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E, 0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
+    0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94, 0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+    0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68, 0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16
+};
+
+static uint8_t rsbox[256];
+static int rsbox_done = 0;
+
+static CE_Model_Stats model_stats;
+
+static uint8_t xtime( uint8_t x )
+{
+    return( (uint8_t)( ( x << 1 ) ^ ( ( x & 0x80 ) ? 0x1B : 0x00 ) ) );
+}
+
+static uint8_t gmul( uint8_t a, uint8_t b )
+{
+    uint8_t p = 0;
+
+    while( b != 0 )
+    {
+        if( b & 1 )
+            p ^= a;
+        a = xtime( a );
+        b >>= 1;
+    }
+
+    return( p );
+}
+
+static int model_expand_key( const CE_AES_Config *aes, uint8_t rk[240] )
+{
+    int nk, nr, i;
+    uint8_t t[4], rcon = 1, tmp;
+
+    switch( aes->keysize )
+    {
+        case CE_CTL_AES_KEYSIZE_128BITS: nk = 4; break;
+        case CE_CTL_AES_KEYSIZE_192BITS: nk = 6; break;
+        case CE_CTL_AES_KEYSIZE_256BITS: nk = 8; break;
+        default: return( -1 );
+    }
+    nr = nk + 6;
+
+    memcpy( rk, aes->key, nk * 4 );
+
+    for( i = nk; i < 4 * ( nr + 1 ); i++ )
+    {
+        memcpy( t, rk + ( i - 1 ) * 4, 4 );
+
+        if( i % nk == 0 )
+        {
+            tmp = t[0]; t[0] = t[1]; t[1] = t[2]; t[2] = t[3]; t[3] = tmp;
+            t[0] = sbox[t[0]]; t[1] = sbox[t[1]];
+            t[2] = sbox[t[2]]; t[3] = sbox[t[3]];
+            t[0] ^= rcon;
+            rcon = xtime( rcon );
+        }
+        else if( nk > 6 && i % nk == 4 )
+        {
+            t[0] = sbox[t[0]]; t[1] = sbox[t[1]];
+            t[2] = sbox[t[2]]; t[3] = sbox[t[3]];
+        }
+
+        rk[i * 4 + 0] = rk[( i - nk ) * 4 + 0] ^ t[0];
+        rk[i * 4 + 1] = rk[( i - nk ) * 4 + 1] ^ t[1];
+        rk[i * 4 + 2] = rk[( i - nk ) * 4 + 2] ^ t[2];
+        rk[i * 4 + 3] = rk[( i - nk ) * 4 + 3] ^ t[3];
+    }
+
+    return( nr );
+}
+
+static void model_block_enc( const uint8_t *rk, int nr, uint8_t s[16] )
+{
+    int r, c, i;
+    uint8_t t[16];
+
+    for( i = 0; i < 16; i++ )
+        s[i] ^= rk[i];
+
+    for( r = 1; r <= nr; r++ )
+    {
+        /* SubBytes + ShiftRows */
+        for( c = 0; c < 4; c++ )
+            for( i = 0; i < 4; i++ )
+                t[c * 4 + i] = sbox[s[( ( c + i ) & 3 ) * 4 + i]];
+
+        /* MixColumns */
+        if( r != nr )
+        {
+            for( c = 0; c < 4; c++ )
+            {
+                uint8_t *p = t + c * 4;
+                uint8_t a0 = p[0], a1 = p[1], a2 = p[2], a3 = p[3];
+
+                p[0] = xtime( a0 ) ^ ( xtime( a1 ) ^ a1 ) ^ a2 ^ a3;
+                p[1] = a0 ^ xtime( a1 ) ^ ( xtime( a2 ) ^ a2 ) ^ a3;
+                p[2] = a0 ^ a1 ^ xtime( a2 ) ^ ( xtime( a3 ) ^ a3 );
+                p[3] = ( xtime( a0 ) ^ a0 ) ^ a1 ^ a2 ^ xtime( a3 );
+            }
+        }
+
+        for( i = 0; i < 16; i++ )
+            s[i] = t[i] ^ rk[r * 16 + i];
+    }
+}
+
+static void model_block_dec( const uint8_t *rk, int nr, uint8_t s[16] )
+{
+    int r, c, i;
+    uint8_t t[16];
+
+    if( !rsbox_done )
+    {
+        for( i = 0; i < 256; i++ )
+            rsbox[sbox[i]] = (uint8_t) i;
+        rsbox_done = 1;
+    }
+
+    for( i = 0; i < 16; i++ )
+        s[i] ^= rk[nr * 16 + i];
+
+    for( r = nr - 1; r >= 0; r-- )
+    {
+        /* InvShiftRows + InvSubBytes */
+        for( c = 0; c < 4; c++ )
+            for( i = 0; i < 4; i++ )
+                t[( ( c + i ) & 3 ) * 4 + i] = rsbox[s[c * 4 + i]];
+
+        for( i = 0; i < 16; i++ )
+            t[i] ^= rk[r * 16 + i];
+
+        /* InvMixColumns */
+        if( r != 0 )
+        {
+            for( c = 0; c < 4; c++ )
+            {
+                uint8_t *p = t + c * 4;
+                uint8_t a0 = p[0], a1 = p[1], a2 = p[2], a3 = p[3];
+
+                p[0] = gmul( a0, 14 ) ^ gmul( a1, 11 ) ^ gmul( a2, 13 ) ^ gmul( a3,  9 );
+                p[1] = gmul( a0,  9 ) ^ gmul( a1, 14 ) ^ gmul( a2, 11 ) ^ gmul( a3, 13 );
+                p[2] = gmul( a0, 13 ) ^ gmul( a1,  9 ) ^ gmul( a2, 14 ) ^ gmul( a3, 11 );
+                p[3] = gmul( a0, 11 ) ^ gmul( a1, 13 ) ^ gmul( a2,  9 ) ^ gmul( a3, 14 );
+            }
+        }
+
+        memcpy( s, t, 16 );
+    }
+}
+
+static HAL_Status model_crypt( CE_AES_Config *aes, int decrypt,
+                               const uint8_t *in, uint8_t *out, uint32_t size )
+{
+    uint8_t rk[240];
+    uint8_t blk[16], prev[16];
+    uint32_t off, n;
+    int nr, i;
+
+    if( size == 0 )
+        return( HAL_INVALID );
+    if( ( nr = model_expand_key( aes, rk ) ) < 0 )
+        return( HAL_INVALID );
+
+    model_stats.calls++;
+    model_stats.bytes += size;
+    if( size > 300 )
+        model_stats.dma_calls++;
+
+    /* Like the CE, a trailing partial block is zero padded */
+    for( off = 0; off < size; off += 16 )
+    {
+        n = ( size - off < 16 ) ? size - off : 16;
+        memset( blk, 0, 16 );
+        memcpy( blk, in + off, n );
+
+        if( decrypt )
+        {
+            memcpy( prev, blk, 16 );
+            model_block_dec( rk, nr, blk );
+            if( aes->mode == CE_CRYPT_MODE_CBC )
+            {
+                for( i = 0; i < 16; i++ )
+                    blk[i] ^= aes->iv[i];
+                memcpy( aes->iv, prev, 16 );
+            }
+        }
+        else
+        {
+            if( aes->mode == CE_CRYPT_MODE_CBC )
+                for( i = 0; i < 16; i++ )
+                    blk[i] ^= aes->iv[i];
+            model_block_enc( rk, nr, blk );
+            if( aes->mode == CE_CRYPT_MODE_CBC )
+                memcpy( aes->iv, blk, 16 );
+        }
+
+        memcpy( out + off, blk, 16 );
+    }
+
+    return( HAL_OK );
+}
+
+HAL_Status HAL_AES_Encrypt(CE_AES_Config *aes, uint8_t *plain, uint8_t *cipher, uint32_t size)
+{
+    return( model_crypt( aes, 0, plain, cipher, size ) );
+}
+
+HAL_Status HAL_AES_Decrypt(CE_AES_Config *aes, uint8_t *cipher, uint8_t *plain, uint32_t size)
+{
+    return( model_crypt( aes, 1, cipher, plain, size ) );
+}
+
+void CE_Model_GetStats(CE_Model_Stats *stats)
+{
+    *stats = model_stats;
+}
+
+void CE_Model_ResetStats(void)
+{
+    memset( &model_stats, 0, sizeof( model_stats ) );
+}
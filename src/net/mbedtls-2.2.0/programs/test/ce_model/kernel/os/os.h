@@ -0,0 +1,102 @@
+/*
+ *  Host stand-in for the XRadio OS abstraction header
+ *
+ *  Copyright (C) 2006-2015, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of mbed TLS (https://tls.mbed.org)
+ */
+
+/*
+ * The mutex, tick and scheduler calls of include/kernel/os/os.h used by
+ * library/xr_ssl_session.c, mapped onto pthreads and CLOCK_MONOTONIC, so
+ * the client session cache can be exercised by ssl_handshake_bench on a PC.
+ */
+#ifndef _KERNEL_OS_OS_H_
+#define _KERNEL_OS_OS_H_
+
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    OS_OK   = 0,
+    OS_FAIL = -1,
+} OS_Status;
+
+#define OS_WAIT_FOREVER         0xffffffffU
+
+#define OS_HZ                   1000
+#define OS_SecsToTicks(sec)     ((uint32_t)(sec) * OS_HZ)
+
+#define OS_TimeAfter(a, b)      ((int32_t)(b) - (int32_t)(a) < 0)
+#define OS_TimeBefore(a, b)     OS_TimeAfter(b, a)
+#define OS_TimeAfterEqual(a, b) ((int32_t)(a) - (int32_t)(b) >= 0)
+
+typedef struct {
+    pthread_mutex_t mutex;
+    int             valid;
+} OS_Mutex_t;
+
+static __inline uint32_t OS_GetTicks( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return( (uint32_t)( ts.tv_sec * OS_HZ + ts.tv_nsec / ( 1000000000 / OS_HZ ) ) );
+}
+
+static __inline int OS_MutexIsValid( OS_Mutex_t *mutex )
+{
+    return( mutex->valid );
+}
+
+static __inline OS_Status OS_MutexCreate( OS_Mutex_t *mutex )
+{
+    if( pthread_mutex_init( &mutex->mutex, NULL ) != 0 )
+        return( OS_FAIL );
+    mutex->valid = 1;
+    return( OS_OK );
+}
+
+static __inline OS_Status OS_MutexLock( OS_Mutex_t *mutex, uint32_t waitMS )
+{
+    (void) waitMS;
+    return( pthread_mutex_lock( &mutex->mutex ) == 0 ? OS_OK : OS_FAIL );
+}
+
+static __inline OS_Status OS_MutexUnlock( OS_Mutex_t *mutex )
+{
+    return( pthread_mutex_unlock( &mutex->mutex ) == 0 ? OS_OK : OS_FAIL );
+}
+
+/* The benchmark is single threaded, nothing to suspend */
+static __inline void OS_ThreadSuspendScheduler( void )
+{
+}
+
+static __inline void OS_ThreadResumeScheduler( void )
+{
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _KERNEL_OS_OS_H_ */
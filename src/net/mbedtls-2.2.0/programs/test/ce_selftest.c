@@ -0,0 +1,246 @@
+/*
+ *  Crypto engine AES layer self-test
+ *
+ *  Copyright (C) 2006-2015, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of mbed TLS (https://tls.mbed.org)
+ */
+
+/*
+ * Checks library/aes_alt.c and the GCM bulk path against references that
+ * do not go through the bulk submissions:
+ *  - AES and GCM NIST vectors (mbedtls_aes_self_test, mbedtls_gcm_self_test),
+ *  - CTR output for odd lengths and split calls against a key stream built
+ *    one mbedtls_aes_crypt_ecb() block at a time,
+ *  - GCM ciphertext against the same key stream started at J0 + 1, and the
+ *    tag by decrypting it again,
+ *  - with the software CE model, the number of CE submissions a long CTR
+ *    run takes, to make sure the blocks really are batched, and that they
+ *    are large enough for the HAL DMA path.
+ *
+ * Build with the CE model, eg. cmake -DUSE_XR_CE_MODEL=ON, once with the
+ * default MBEDTLS_AES_ALT_SW_THRESHOLD and once with it set to 0.
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_PLATFORM_C)
+#include "mbedtls/platform.h"
+#else
+#include <stdio.h>
+#define mbedtls_printf     printf
+#endif
+
+#if !defined(MBEDTLS_AES_C) || !defined(MBEDTLS_AES_ALT) ||          \
+    !defined(MBEDTLS_CIPHER_MODE_CTR) || !defined(MBEDTLS_GCM_C)
+int main( void )
+{
+    mbedtls_printf( "MBEDTLS_AES_C and/or MBEDTLS_AES_ALT and/or "
+            "MBEDTLS_CIPHER_MODE_CTR and/or MBEDTLS_GCM_C not defined.\n" );
+    return( 0 );
+}
+#else
+
+#include <string.h>
+
+#include "mbedtls/aes.h"
+#include "mbedtls/gcm.h"
+
+#define DATA_LEN        4096
+
+static unsigned char plain[DATA_LEN];
+static unsigned char cipher[DATA_LEN];
+static unsigned char expect[DATA_LEN];
+
+static const size_t chunks[] =
+    { 1, 15, 16, 17, 31, 33, 100, 511, 512, 513, 1000, 1 };
+
+static int errors = 0;
+
+#define CHECK( cond, what )                                             \
+    do {                                                                \
+        if( !( cond ) )                                                 \
+        {                                                               \
+            mbedtls_printf( "  FAILED: %s (%s:%d)\n", what,             \
+                            __FILE__, __LINE__ );                       \
+            errors++;                                                   \
+        }                                                               \
+    } while( 0 )
+
+/*
+ * Reference key stream: counter blocks encrypted one at a time
+ */
+static void ref_ctr( mbedtls_aes_context *aes, const unsigned char nonce[16],
+                     const unsigned char *input, unsigned char *output,
+                     size_t length )
+{
+    unsigned char ctr[16], ks[16];
+    size_t i, j;
+
+    memcpy( ctr, nonce, 16 );
+    for( i = 0; i < length; i += 16 )
+    {
+        mbedtls_aes_crypt_ecb( aes, MBEDTLS_AES_ENCRYPT, ctr, ks );
+        for( j = 0; j < 16 && i + j < length; j++ )
+            output[i + j] = (unsigned char)( input[i + j] ^ ks[j] );
+
+        for( j = 16; j > 0; j-- )
+            if( ++ctr[j - 1] != 0 )
+                break;
+    }
+}
+
+static void test_ctr( const unsigned char *key, unsigned int keybits )
+{
+    mbedtls_aes_context aes;
+    unsigned char nonce[16], nc[16], sb[16];
+    size_t off = 0, pos = 0, k;
+
+    mbedtls_aes_init( &aes );
+    mbedtls_aes_setkey_enc( &aes, key, keybits );
+
+    /* wraps the low counter bytes inside the first batch */
+    memset( nonce, 0xFE, sizeof( nonce ) );
+    ref_ctr( &aes, nonce, plain, expect, DATA_LEN );
+
+    /* same stream cut at odd places, the tail of a block carried over */
+    memcpy( nc, nonce, 16 );
+    for( k = 0; pos < DATA_LEN; k = ( k + 1 ) % ( sizeof( chunks ) / sizeof( chunks[0] ) ) )
+    {
+        size_t len = chunks[k];
+
+        if( len > DATA_LEN - pos )
+            len = DATA_LEN - pos;
+        CHECK( mbedtls_aes_crypt_ctr( &aes, len, &off, nc, sb,
+                                      plain + pos, cipher + pos ) == 0,
+               "mbedtls_aes_crypt_ctr" );
+        pos += len;
+    }
+    CHECK( memcmp( cipher, expect, DATA_LEN ) == 0, "CTR split calls" );
+
+    /* one call over everything */
+    memcpy( nc, nonce, 16 );
+    off = 0;
+    CHECK( mbedtls_aes_crypt_ctr( &aes, DATA_LEN, &off, nc, sb,
+                                  plain, cipher ) == 0 &&
+           memcmp( cipher, expect, DATA_LEN ) == 0, "CTR single call" );
+
+    mbedtls_aes_free( &aes );
+}
+
+static void test_gcm( const unsigned char *key, unsigned int keybits )
+{
+    mbedtls_aes_context aes;
+    mbedtls_gcm_context gcm;
+    unsigned char iv[12], j1[16], tag[16], add[13];
+    size_t k, len;
+
+    memset( iv, 0x5A, sizeof( iv ) );
+    memset( add, 0xA5, sizeof( add ) );
+
+    /* 96 bit IV: J0 = IV || 1, payload starts at J0 + 1 */
+    memcpy( j1, iv, 12 );
+    j1[12] = 0; j1[13] = 0; j1[14] = 0; j1[15] = 2;
+
+    mbedtls_aes_init( &aes );
+    mbedtls_aes_setkey_enc( &aes, key, keybits );
+    mbedtls_gcm_init( &gcm );
+    mbedtls_gcm_setkey( &gcm, MBEDTLS_CIPHER_ID_AES, key, keybits );
+
+    for( k = 0; k < sizeof( chunks ) / sizeof( chunks[0] ); k++ )
+    {
+        len = chunks[k] * 3;
+        if( len > DATA_LEN )
+            len = DATA_LEN;
+
+        ref_ctr( &aes, j1, plain, expect, len );
+        CHECK( mbedtls_gcm_crypt_and_tag( &gcm, MBEDTLS_GCM_ENCRYPT, len,
+                                          iv, sizeof( iv ), add, sizeof( add ),
+                                          plain, cipher, sizeof( tag ), tag ) == 0,
+               "mbedtls_gcm_crypt_and_tag" );
+        CHECK( memcmp( cipher, expect, len ) == 0, "GCM key stream" );
+        CHECK( mbedtls_gcm_auth_decrypt( &gcm, len, iv, sizeof( iv ),
+                                         add, sizeof( add ), tag, sizeof( tag ),
+                                         cipher, expect ) == 0 &&
+               memcmp( expect, plain, len ) == 0, "GCM round trip" );
+    }
+
+    mbedtls_gcm_free( &gcm );
+    mbedtls_aes_free( &aes );
+}
+
+#if defined(MBEDTLS_XR_CE_MODEL)
+static void test_batching( const unsigned char *key )
+{
+    mbedtls_aes_context aes;
+    unsigned char nc[16], sb[16];
+    size_t off = 0;
+    CE_Model_Stats stats;
+
+    mbedtls_aes_init( &aes );
+    mbedtls_aes_setkey_enc( &aes, key, 128 );
+    memset( nc, 0, sizeof( nc ) );
+
+    CE_Model_ResetStats();
+    mbedtls_aes_crypt_ctr( &aes, DATA_LEN, &off, nc, sb, plain, cipher );
+    CE_Model_GetStats( &stats );
+
+    CHECK( stats.calls == DATA_LEN / 16 / MBEDTLS_AES_ALT_BULK_BLOCKS,
+           "one CE submission per MBEDTLS_AES_ALT_BULK_BLOCKS blocks" );
+    CHECK( stats.bytes == DATA_LEN, "CE submitted bytes" );
+    CHECK( MBEDTLS_AES_ALT_BULK_BLOCKS * 16 <= 300 ||
+           stats.dma_calls == stats.calls, "full submissions go by DMA" );
+
+    mbedtls_aes_free( &aes );
+}
+#endif
+
+int main( void )
+{
+    unsigned char key[32];
+    unsigned int keybits;
+    size_t i;
+
+    for( i = 0; i < sizeof( key ); i++ )
+        key[i] = (unsigned char) i;
+    for( i = 0; i < DATA_LEN; i++ )
+        plain[i] = (unsigned char)( i * 7 + 3 );
+
+    mbedtls_printf( "  CE AES, %d blocks per submission, software below %d bytes\n",
+                    MBEDTLS_AES_ALT_BULK_BLOCKS, MBEDTLS_AES_ALT_SW_THRESHOLD );
+
+    CHECK( mbedtls_aes_self_test( 0 ) == 0, "AES NIST vectors" );
+    CHECK( mbedtls_gcm_self_test( 0 ) == 0, "GCM NIST vectors" );
+
+    for( keybits = 128; keybits <= 256; keybits += 64 )
+    {
+        test_ctr( key, keybits );
+        test_gcm( key, keybits );
+    }
+#if defined(MBEDTLS_XR_CE_MODEL)
+    test_batching( key );
+#endif
+
+    mbedtls_printf( "  CE AES self-test %s\n", errors == 0 ? "passed" : "FAILED" );
+
+    return( errors != 0 );
+}
+
+#endif /* MBEDTLS_AES_C && MBEDTLS_AES_ALT && MBEDTLS_CIPHER_MODE_CTR && MBEDTLS_GCM_C */
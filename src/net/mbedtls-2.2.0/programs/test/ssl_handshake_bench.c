@@ -0,0 +1,588 @@
+/*
+ *  TLS handshake and record throughput benchmark
+ *
+ *  Copyright (C) 2006-2015, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of mbed TLS (https://tls.mbed.org)
+ */
+
+/*
+ * Runs a client and a server in one process, connected by in-memory pipes,
+ * and measures for each ciphersuite:
+ *  - full handshakes per second,
+ *  - abbreviated handshakes resuming by session ID,
+ *  - abbreviated handshakes resuming by session ticket,
+ *  - abbreviated handshakes through the client session cache
+ *    (xr_ssl_session_load/save, as used by the mbedtls wrapper),
+ *  - application data throughput.
+ *
+ * Build with the profile under test, eg.
+ *   -DMBEDTLS_CONFIG_FILE='<config-xr-fast-cliserv.h>'
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_PLATFORM_C)
+#include "mbedtls/platform.h"
+#else
+#include <stdio.h>
+#define mbedtls_printf     printf
+#endif
+
+#if !defined(MBEDTLS_SSL_CLI_C) || !defined(MBEDTLS_SSL_SRV_C) ||    \
+    !defined(MBEDTLS_CERTS_C) || !defined(MBEDTLS_PEM_PARSE_C) ||     \
+    !defined(MBEDTLS_CTR_DRBG_C) || !defined(MBEDTLS_X509_CRT_PARSE_C)
+int main( void )
+{
+    mbedtls_printf( "MBEDTLS_SSL_CLI_C and/or MBEDTLS_SSL_SRV_C and/or "
+            "MBEDTLS_CERTS_C and/or MBEDTLS_PEM_PARSE_C and/or "
+            "MBEDTLS_CTR_DRBG_C and/or MBEDTLS_X509_CRT_PARSE_C "
+            "not defined.\n" );
+    return( 0 );
+}
+#else
+
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "mbedtls/ssl.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/certs.h"
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/pk.h"
+#if defined(MBEDTLS_SSL_CACHE_C)
+#include "mbedtls/ssl_cache.h"
+#endif
+#if defined(MBEDTLS_SSL_TICKET_C)
+#include "mbedtls/ssl_ticket.h"
+#endif
+#if defined(MBEDTLS_XR_SESSION_CACHE)
+#include "mbedtls/xr_ssl_session.h"
+#endif
+
+#define PIPE_SIZE       ( 4 * MBEDTLS_SSL_MAX_CONTENT_LEN )
+#define BULK_RECORD     1024
+#define BULK_BYTES      ( 1024 * 1024 )
+#define HEADER_FORMAT   "  %-46s :  "
+
+#define RESUME_NONE     0
+#define RESUME_ID       1
+#define RESUME_TICKET   2
+#define RESUME_XR_CACHE 3
+
+/* key of the client session cache entry */
+#define XR_CACHE_HOST   "bench.local"
+#define XR_CACHE_PORT   443
+
+/*
+ * One direction of the in-memory transport
+ */
+typedef struct
+{
+    unsigned char buf[PIPE_SIZE];
+    size_t head;
+    size_t len;
+} pipe_t;
+
+typedef struct
+{
+    pipe_t *in;
+    pipe_t *out;
+    unsigned long bytes_sent;
+} endpoint_t;
+
+static int pipe_send( void *ctx, const unsigned char *buf, size_t len )
+{
+    endpoint_t *ep = (endpoint_t *) ctx;
+    pipe_t *p = ep->out;
+    size_t i;
+
+    if( len > PIPE_SIZE - p->len )
+        len = PIPE_SIZE - p->len;
+    if( len == 0 )
+        return( MBEDTLS_ERR_SSL_WANT_WRITE );
+
+    for( i = 0; i < len; i++ )
+        p->buf[( p->head + p->len + i ) % PIPE_SIZE] = buf[i];
+    p->len += len;
+    ep->bytes_sent += len;
+
+    return( (int) len );
+}
+
+static int pipe_recv( void *ctx, unsigned char *buf, size_t len )
+{
+    endpoint_t *ep = (endpoint_t *) ctx;
+    pipe_t *p = ep->in;
+    size_t i;
+
+    if( len > p->len )
+        len = p->len;
+    if( len == 0 )
+        return( MBEDTLS_ERR_SSL_WANT_READ );
+
+    for( i = 0; i < len; i++ )
+        buf[i] = p->buf[( p->head + i ) % PIPE_SIZE];
+    p->head = ( p->head + len ) % PIPE_SIZE;
+    p->len -= len;
+
+    return( (int) len );
+}
+
+/*
+ * Deterministic entropy, good enough for a benchmark
+ */
+static int bench_entropy( void *data, unsigned char *output, size_t len )
+{
+    size_t i;
+    (void) data;
+
+    for( i = 0; i < len; i++ )
+        output[i] = (unsigned char) rand();
+
+    return( 0 );
+}
+
+static double now_sec( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return( ts.tv_sec + ts.tv_nsec / 1e9 );
+}
+
+typedef struct
+{
+    mbedtls_ctr_drbg_context drbg;
+    mbedtls_x509_crt srv_crt;
+    mbedtls_pk_context srv_key;
+    mbedtls_ssl_config srv_conf;
+    mbedtls_ssl_config cli_conf;
+#if defined(MBEDTLS_SSL_CACHE_C)
+    mbedtls_ssl_cache_context cache;
+#endif
+#if defined(MBEDTLS_SSL_TICKET_C)
+    mbedtls_ssl_ticket_context ticket;
+#endif
+    int ciphersuites[2];
+} bench_t;
+
+static int bench_setup( bench_t *b, int suite, const char *crt, size_t crt_len,
+                        const char *key, size_t key_len )
+{
+    int ret;
+
+    mbedtls_ctr_drbg_init( &b->drbg );
+    mbedtls_x509_crt_init( &b->srv_crt );
+    mbedtls_pk_init( &b->srv_key );
+    mbedtls_ssl_config_init( &b->srv_conf );
+    mbedtls_ssl_config_init( &b->cli_conf );
+#if defined(MBEDTLS_SSL_CACHE_C)
+    mbedtls_ssl_cache_init( &b->cache );
+#endif
+#if defined(MBEDTLS_SSL_TICKET_C)
+    mbedtls_ssl_ticket_init( &b->ticket );
+#endif
+
+    b->ciphersuites[0] = suite;
+    b->ciphersuites[1] = 0;
+
+    if( ( ret = mbedtls_ctr_drbg_seed( &b->drbg, bench_entropy, NULL,
+                                       NULL, 0 ) ) != 0 ||
+        ( ret = mbedtls_x509_crt_parse( &b->srv_crt,
+                                        (const unsigned char *) crt, crt_len ) ) != 0 ||
+        ( ret = mbedtls_pk_parse_key( &b->srv_key,
+                                      (const unsigned char *) key, key_len,
+                                      NULL, 0 ) ) != 0 )
+        return( ret );
+
+    if( ( ret = mbedtls_ssl_config_defaults( &b->srv_conf,
+                    MBEDTLS_SSL_IS_SERVER, MBEDTLS_SSL_TRANSPORT_STREAM,
+                    MBEDTLS_SSL_PRESET_DEFAULT ) ) != 0 ||
+        ( ret = mbedtls_ssl_config_defaults( &b->cli_conf,
+                    MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                    MBEDTLS_SSL_PRESET_DEFAULT ) ) != 0 )
+        return( ret );
+
+    mbedtls_ssl_conf_rng( &b->srv_conf, mbedtls_ctr_drbg_random, &b->drbg );
+    mbedtls_ssl_conf_rng( &b->cli_conf, mbedtls_ctr_drbg_random, &b->drbg );
+    mbedtls_ssl_conf_ciphersuites( &b->srv_conf, b->ciphersuites );
+    mbedtls_ssl_conf_ciphersuites( &b->cli_conf, b->ciphersuites );
+
+    /* The benchmark measures the handshake, not the chain verification */
+    mbedtls_ssl_conf_authmode( &b->cli_conf, MBEDTLS_SSL_VERIFY_NONE );
+
+    if( ( ret = mbedtls_ssl_conf_own_cert( &b->srv_conf, &b->srv_crt,
+                                           &b->srv_key ) ) != 0 )
+        return( ret );
+
+#if defined(MBEDTLS_SSL_CACHE_C)
+    mbedtls_ssl_conf_session_cache( &b->srv_conf, &b->cache,
+                                    mbedtls_ssl_cache_get,
+                                    mbedtls_ssl_cache_set );
+#endif
+#if defined(MBEDTLS_SSL_TICKET_C)
+    if( ( ret = mbedtls_ssl_ticket_setup( &b->ticket, mbedtls_ctr_drbg_random,
+                    &b->drbg, MBEDTLS_CIPHER_AES_256_GCM, 86400 ) ) != 0 )
+        return( ret );
+    mbedtls_ssl_conf_session_tickets_cb( &b->srv_conf, mbedtls_ssl_ticket_write,
+                                         mbedtls_ssl_ticket_parse, &b->ticket );
+#endif
+
+    return( 0 );
+}
+
+static void bench_free( bench_t *b )
+{
+    mbedtls_ssl_config_free( &b->cli_conf );
+    mbedtls_ssl_config_free( &b->srv_conf );
+    mbedtls_pk_free( &b->srv_key );
+    mbedtls_x509_crt_free( &b->srv_crt );
+    mbedtls_ctr_drbg_free( &b->drbg );
+#if defined(MBEDTLS_SSL_CACHE_C)
+    mbedtls_ssl_cache_free( &b->cache );
+#endif
+#if defined(MBEDTLS_SSL_TICKET_C)
+    mbedtls_ssl_ticket_free( &b->ticket );
+#endif
+}
+
+typedef struct
+{
+    pipe_t c2s, s2c;
+    endpoint_t cli_ep, srv_ep;
+    mbedtls_ssl_context cli, srv;
+} conn_t;
+
+static int conn_open( bench_t *b, conn_t *c, const mbedtls_ssl_session *session,
+                      int resume )
+{
+    int ret, cret, sret;
+
+    memset( &c->c2s, 0, sizeof( c->c2s ) );
+    memset( &c->s2c, 0, sizeof( c->s2c ) );
+    c->cli_ep.in = &c->s2c;
+    c->cli_ep.out = &c->c2s;
+    c->cli_ep.bytes_sent = 0;
+    c->srv_ep.in = &c->c2s;
+    c->srv_ep.out = &c->s2c;
+    c->srv_ep.bytes_sent = 0;
+
+    mbedtls_ssl_init( &c->cli );
+    mbedtls_ssl_init( &c->srv );
+
+    if( ( ret = mbedtls_ssl_setup( &c->cli, &b->cli_conf ) ) != 0 ||
+        ( ret = mbedtls_ssl_setup( &c->srv, &b->srv_conf ) ) != 0 )
+        return( ret );
+
+    mbedtls_ssl_set_bio( &c->cli, &c->cli_ep, pipe_send, pipe_recv, NULL );
+    mbedtls_ssl_set_bio( &c->srv, &c->srv_ep, pipe_send, pipe_recv, NULL );
+
+    if( session != NULL &&
+        ( ret = mbedtls_ssl_set_session( &c->cli, session ) ) != 0 )
+        return( ret );
+#if defined(MBEDTLS_XR_SESSION_CACHE)
+    /* same sequence as mbedtls_handshake() in the XR mbedtls wrapper */
+    if( resume == RESUME_XR_CACHE )
+        xr_ssl_session_load( &c->cli, XR_CACHE_HOST, XR_CACHE_PORT );
+#else
+    (void) resume;
+#endif
+
+    do
+    {
+        cret = mbedtls_ssl_handshake( &c->cli );
+        if( cret != 0 && cret != MBEDTLS_ERR_SSL_WANT_READ &&
+            cret != MBEDTLS_ERR_SSL_WANT_WRITE )
+            return( cret );
+
+        sret = mbedtls_ssl_handshake( &c->srv );
+        if( sret != 0 && sret != MBEDTLS_ERR_SSL_WANT_READ &&
+            sret != MBEDTLS_ERR_SSL_WANT_WRITE )
+            return( sret );
+    }
+    while( cret != 0 || sret != 0 );
+
+#if defined(MBEDTLS_XR_SESSION_CACHE)
+    if( resume == RESUME_XR_CACHE &&
+        xr_ssl_session_save( &c->cli, XR_CACHE_HOST, XR_CACHE_PORT ) != 0 )
+        return( MBEDTLS_ERR_SSL_BAD_INPUT_DATA );
+#endif
+
+    return( 0 );
+}
+
+static void conn_close( conn_t *c )
+{
+    mbedtls_ssl_free( &c->cli );
+    mbedtls_ssl_free( &c->srv );
+}
+
+static int bench_handshake( bench_t *b, const char *title, int resume, int count )
+{
+    int ret = 0, i, resumed = 0;
+    unsigned long wire = 0;
+    double start, elapsed;
+    mbedtls_ssl_session session;
+#if defined(MBEDTLS_XR_SESSION_CACHE)
+    xr_ssl_session_stats_t stats;
+    uint32_t resumed_before = 0;
+#endif
+    conn_t *c;
+
+    if( ( c = malloc( sizeof( conn_t ) ) ) == NULL )
+        return( MBEDTLS_ERR_SSL_ALLOC_FAILED );
+
+    mbedtls_printf( HEADER_FORMAT, title );
+    fflush( stdout );
+
+#if !defined(MBEDTLS_XR_SESSION_CACHE)
+    if( resume == RESUME_XR_CACHE )
+    {
+        mbedtls_printf( "skipped, no MBEDTLS_XR_SESSION_CACHE\n" );
+        free( c );
+        return( 0 );
+    }
+#endif
+
+    /* The cache resumes with whatever the server offers, like a device would */
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets( &b->cli_conf,
+                                      ( resume == RESUME_TICKET ||
+                                        resume == RESUME_XR_CACHE ) ?
+                                      MBEDTLS_SSL_SESSION_TICKETS_ENABLED :
+                                      MBEDTLS_SSL_SESSION_TICKETS_DISABLED );
+#else
+    if( resume == RESUME_TICKET )
+    {
+        mbedtls_printf( "skipped, no MBEDTLS_SSL_SESSION_TICKETS\n" );
+        free( c );
+        return( 0 );
+    }
+#endif
+
+    /* Prime the session with one full handshake */
+    memset( &session, 0, sizeof( session ) );
+    if( resume == RESUME_ID || resume == RESUME_TICKET )
+    {
+        if( ( ret = conn_open( b, c, NULL, resume ) ) != 0 ||
+            ( ret = mbedtls_ssl_get_session( &c->cli, &session ) ) != 0 )
+            goto exit;
+        conn_close( c );
+    }
+#if defined(MBEDTLS_XR_SESSION_CACHE)
+    else if( resume == RESUME_XR_CACHE )
+    {
+        /* the first connection misses and fills the cache */
+        xr_ssl_session_flush();
+        if( ( ret = conn_open( b, c, NULL, resume ) ) != 0 )
+            goto exit;
+        conn_close( c );
+        xr_ssl_session_get_stats( &stats );
+        resumed_before = stats.resumed;
+    }
+#endif
+
+    start = now_sec();
+    for( i = 0; i < count; i++ )
+    {
+        if( ( ret = conn_open( b, c, ( resume == RESUME_ID ||
+                                       resume == RESUME_TICKET ) ? &session : NULL,
+                               resume ) ) != 0 )
+            goto exit;
+        if( ( resume == RESUME_ID || resume == RESUME_TICKET ) &&
+            memcmp( c->cli.session->master, session.master, sizeof( session.master ) ) == 0 )
+            resumed++;
+        wire += c->cli_ep.bytes_sent + c->srv_ep.bytes_sent;
+        conn_close( c );
+    }
+    elapsed = now_sec() - start;
+
+#if defined(MBEDTLS_XR_SESSION_CACHE)
+    if( resume == RESUME_XR_CACHE )
+    {
+        xr_ssl_session_get_stats( &stats );
+        resumed = (int)( stats.resumed - resumed_before );
+    }
+#endif
+
+    mbedtls_printf( "%8.2f ms/handshake, %5lu bytes, %3d%% resumed\n",
+                    elapsed * 1000 / count, wire / count, resumed * 100 / count );
+
+exit:
+    if( ret != 0 )
+    {
+        mbedtls_printf( "FAILED: -0x%04x\n", -ret );
+        conn_close( c );
+#if defined(MBEDTLS_XR_SESSION_CACHE)
+        if( resume == RESUME_XR_CACHE )
+            xr_ssl_session_remove( XR_CACHE_HOST, XR_CACHE_PORT );
+#endif
+    }
+    mbedtls_ssl_session_free( &session );
+    free( c );
+    return( ret );
+}
+
+static int bench_bulk( bench_t *b, const char *title )
+{
+    int ret, n;
+    size_t sent = 0, rcvd = 0;
+    double start, elapsed;
+    unsigned char *buf;
+    conn_t *c;
+
+    mbedtls_printf( HEADER_FORMAT, title );
+    fflush( stdout );
+
+    buf = calloc( 1, BULK_RECORD );
+    c = malloc( sizeof( conn_t ) );
+    if( buf == NULL || c == NULL )
+    {
+        free( buf );
+        free( c );
+        return( MBEDTLS_ERR_SSL_ALLOC_FAILED );
+    }
+
+    if( ( ret = conn_open( b, c, NULL, RESUME_NONE ) ) != 0 )
+        goto exit;
+
+    start = now_sec();
+    while( rcvd < BULK_BYTES )
+    {
+        if( sent < BULK_BYTES )
+        {
+            n = mbedtls_ssl_write( &c->cli, buf, BULK_RECORD );
+            if( n > 0 )
+                sent += n;
+            else if( n != MBEDTLS_ERR_SSL_WANT_WRITE )
+            {
+                ret = n;
+                goto exit;
+            }
+        }
+
+        do
+        {
+            n = mbedtls_ssl_read( &c->srv, buf, BULK_RECORD );
+            if( n > 0 )
+                rcvd += n;
+        }
+        while( n > 0 );
+        if( n != MBEDTLS_ERR_SSL_WANT_READ )
+        {
+            ret = n;
+            goto exit;
+        }
+    }
+    elapsed = now_sec() - start;
+
+    mbedtls_printf( "%8.2f MB/s, %5lu bytes overhead/record\n",
+                    BULK_BYTES / elapsed / ( 1024 * 1024 ),
+                    ( c->cli_ep.bytes_sent - BULK_BYTES ) / ( BULK_BYTES / BULK_RECORD ) );
+
+exit:
+    if( ret != 0 )
+        mbedtls_printf( "FAILED: -0x%04x\n", -ret );
+    conn_close( c );
+    free( buf );
+    free( c );
+    return( ret );
+}
+
+typedef struct
+{
+    const char *name;
+    int id;
+    int ecdsa;
+} suite_t;
+
+static const suite_t suites[] =
+{
+#if defined(MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA_ENABLED) && defined(MBEDTLS_GCM_C)
+    { "ECDHE-ECDSA-AES128-GCM-SHA256",
+      MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256, 1 },
+#endif
+#if defined(MBEDTLS_KEY_EXCHANGE_ECDHE_RSA_ENABLED) && defined(MBEDTLS_GCM_C)
+    { "ECDHE-RSA-AES128-GCM-SHA256",
+      MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256, 0 },
+#endif
+#if defined(MBEDTLS_KEY_EXCHANGE_RSA_ENABLED) && defined(MBEDTLS_GCM_C)
+    { "RSA-AES128-GCM-SHA256",
+      MBEDTLS_TLS_RSA_WITH_AES_128_GCM_SHA256, 0 },
+#endif
+#if defined(MBEDTLS_KEY_EXCHANGE_RSA_ENABLED) && defined(MBEDTLS_CIPHER_MODE_CBC)
+    { "RSA-AES128-CBC-SHA",
+      MBEDTLS_TLS_RSA_WITH_AES_128_CBC_SHA, 0 },
+#endif
+    { NULL, 0, 0 }
+};
+
+int main( int argc, char *argv[] )
+{
+    int ret = 0, count = 20;
+    const suite_t *s;
+    char title[64];
+    bench_t b;
+
+    if( argc > 1 )
+        count = atoi( argv[1] );
+    if( count <= 0 )
+        count = 20;
+
+    mbedtls_printf( "\n  %d handshakes per measurement\n\n", count );
+
+    for( s = suites; s->name != NULL; s++ )
+    {
+        if( s->ecdsa )
+            ret = bench_setup( &b, s->id,
+                               mbedtls_test_srv_crt_ec, mbedtls_test_srv_crt_ec_len,
+                               mbedtls_test_srv_key_ec, mbedtls_test_srv_key_ec_len );
+        else
+            ret = bench_setup( &b, s->id,
+                               mbedtls_test_srv_crt_rsa, mbedtls_test_srv_crt_rsa_len,
+                               mbedtls_test_srv_key_rsa, mbedtls_test_srv_key_rsa_len );
+        if( ret != 0 )
+        {
+            mbedtls_printf( "  %s setup FAILED: -0x%04x\n", s->name, -ret );
+            bench_free( &b );
+            continue;
+        }
+
+        snprintf( title, sizeof( title ), "%s full", s->name );
+        bench_handshake( &b, title, RESUME_NONE, count );
+        snprintf( title, sizeof( title ), "%s resume (id)", s->name );
+        bench_handshake( &b, title, RESUME_ID, count );
+        snprintf( title, sizeof( title ), "%s resume (ticket)", s->name );
+        bench_handshake( &b, title, RESUME_TICKET, count );
+        snprintf( title, sizeof( title ), "%s resume (cache)", s->name );
+        bench_handshake( &b, title, RESUME_XR_CACHE, count );
+        snprintf( title, sizeof( title ), "%s bulk", s->name );
+        bench_bulk( &b, title );
+        mbedtls_printf( "\n" );
+
+        bench_free( &b );
+    }
+
+    return( 0 );
+}
+
+#endif /* MBEDTLS_SSL_CLI_C && MBEDTLS_SSL_SRV_C && MBEDTLS_CERTS_C && ... */
@@ -22,6 +22,7 @@
 #include "lwip/sockets.h"
 #include "lwip/netdb.h"
 #include "errno.h"
+#include "net/mbedtls/xr_ssl_session.h"
 
 #ifdef XR_MQTT_PLATFORM_UTEST
 static unsigned int tick;
@@ -660,6 +661,11 @@ int TLSConnectNetwork(Network *n, const char *addr, const char *port,
     mbedtls_ssl_set_hostname(&(n->ssl), addr);
     mbedtls_ssl_set_bio( &(n->ssl), &(n->fd), mbedtls_net_send, mbedtls_net_recv, mbedtls_net_recv_timeout);
 
+    /*
+     * 3. Offer the session of the last connection to this broker, if any
+     */
+    xr_ssl_session_load(&(n->ssl), addr, (uint16_t)atoi(port));
+
     /*
       * 4. Handshake
       */
@@ -667,6 +673,7 @@ int TLSConnectNetwork(Network *n, const char *addr, const char *port,
     while ((ret = mbedtls_ssl_handshake(&(n->ssl))) != 0) {
         if ((ret != MBEDTLS_ERR_SSL_WANT_READ) && (ret != MBEDTLS_ERR_SSL_WANT_WRITE)) {
             printf( " failed  ! mbedtls_ssl_handshake returned -0x%04x", -ret);
+            xr_ssl_session_remove(addr, (uint16_t)atoi(port));
             return ret;
         }
     }
@@ -677,8 +684,10 @@ int TLSConnectNetwork(Network *n, const char *addr, const char *port,
     printf("  . Verifying peer X.509 certificate..\n");
     if (0 != (ret = mqtt_real_confirm(mbedtls_ssl_get_verify_result(&(n->ssl))))) {
         printf(" failed  ! verify result not confirmed.\n");
+        xr_ssl_session_remove(addr, (uint16_t)atoi(port));
         return ret;
     }
+    xr_ssl_session_save(&(n->ssl), addr, (uint16_t)atoi(port));
     n->my_socket = (int)((n->fd).fd);
     printf("  . my_socket = %d \n\n", n->my_socket);
 
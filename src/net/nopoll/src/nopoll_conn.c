@@ -1006,12 +1006,16 @@ noPollConn * __nopoll_conn_new_common (noPollCtx       * ctx,
 			}
 		}
 
+		/* offer the session of the last connection to this site, if any */
+		xr_ssl_session_load(conn->ssl, conn->host, (uint16_t)atoi(conn->port));
+
 		/* do the initial connect connect */
 		nopoll_log (ctx, NOPOLL_LEVEL_DEBUG, "connecting to remote TLS site %s:%s", conn->host, conn->port);
 		iterator = 0;
 		while ((ssl_error = mbedtls_ssl_handshake(conn->ssl)) != 0) {
 			if ((ssl_error != MBEDTLS_ERR_SSL_WANT_READ) && (ssl_error != MBEDTLS_ERR_SSL_WANT_WRITE)) {
 				nopoll_log (ctx, NOPOLL_LEVEL_CRITICAL, "mbedtls_ssl_handshake failed\n");
+				xr_ssl_session_remove(conn->host, (uint16_t)atoi(conn->port));
 				goto fail_ssl_connection2;
 			}
 
@@ -1036,8 +1040,10 @@ noPollConn * __nopoll_conn_new_common (noPollCtx       * ctx,
 
 		if (mbedtls_ssl_get_verify_result(conn->ssl) != 0) {
 			nopoll_log (ctx, NOPOLL_LEVEL_CRITICAL, "mbedtls_ssl_get_verify_result failed\n");
+			xr_ssl_session_remove(conn->host, (uint16_t)atoi(conn->port));
 			goto fail_ssl_connection2;
 		}
+		xr_ssl_session_save(conn->ssl, conn->host, (uint16_t)atoi(conn->port));
 #else
 		/* found TLS connection request, enable it */
 		conn->ssl_ctx  = __nopoll_conn_get_ssl_context (ctx, conn, options, nopoll_true);
@@ -48,6 +48,7 @@
 #include <net/mbedtls/x509_crt.h>
 #include <net/mbedtls/entropy.h>
 #include <net/mbedtls/ctr_drbg.h>
+#include <net/mbedtls/xr_ssl_session.h>
 
 #ifndef EVP_MAX_MD_SIZE
 #define EVP_MAX_MD_SIZE	20
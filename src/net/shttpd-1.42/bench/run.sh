@@ -0,0 +1,27 @@
+#!/bin/sh
+#
+# Build the shttpd RTOS sources on the host, with the stand-ins in port/,
+# pack web/ with tools/shttpd_pack.py, and serve it over loopback: as the
+# usr_file list and as the packed table. app.js keeps its identity body
+# too, for the Accept-Encoding checks. Then a short run under
+# AddressSanitizer.
+#
+# Arguments are passed to shttpd_bench, the web directory by default.
+#
+set -e
+cd "$(dirname "$0")"
+R=../../../..
+SOURCE_DATE_EPOCH=1700000000 python3 ../tools/shttpd_pack.py web \
+	-n bench_assets --plain app.js -o /tmp/shttpd_bench_assets.c 2> /dev/null
+build() {
+	gcc -O2 -Wall -DFREE_RTOS "$@" -Iport -I$R/include/net/shttpd \
+		-I$R/include -c ../src/*.c /tmp/shttpd_bench_assets.c \
+		shttpd_bench.c
+	gcc -pthread "$@" *.o -Wl,--wrap=accept -lz -o /tmp/shttpd_bench
+	rm -f *.o
+}
+build
+/tmp/shttpd_bench "$@"
+build -fsanitize=address -g
+/tmp/shttpd_bench "$@" > /dev/null
+echo "PASS"
@@ -0,0 +1,727 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host bench of the shttpd RTOS file path, built from ../src with the
+ * stand-ins in port/ and served over loopback by shttpd_poll(). The same
+ * web directory is served twice: as a usr_file list, the way the demo
+ * registers its pages, and as the table tools/shttpd_pack.py generates.
+ *
+ * Checks, on the packed table:
+ * - gzip bodies decode to the file, identity bodies match it;
+ * - the encoding follows Accept-Encoding, gzip;q=0 refuses gzip, a
+ *   gzip only asset gets 406 when gzip is refused;
+ * - 304 on a matching If-None-Match or "*", and on If-Modified-Since
+ *   alone; a "*" inside the field matches nothing;
+ *   200 on an older date, or an etag of the other encoding;
+ * - ETag, Last-Modified, Cache-Control and Vary are sent, HEAD has no body;
+ * - SSI pages run their #call, and give the same page as the usr_file list;
+ * - bodies larger than the socket buffer survive partial sends;
+ * - a 304 keeps the connection open, a warm load takes one connection.
+ *
+ * Measures, for a cold and a warm load of every page, the response bytes,
+ * connections and loopback time of each server. The time on the soft-AP
+ * link is computed from the bytes, it is not measured.
+ */
+
+#define	_GNU_SOURCE			/* memmem() */
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <zlib.h>
+
+#include "defs.h"
+
+#define	BENCH_FILE_MAX	16384		/* Largest file in the web dir	*/
+#define	BENCH_RESP_MAX	32768		/* Largest response		*/
+#define	BENCH_SNDBUF	4096		/* Server socket buffer		*/
+#define	BENCH_RCVBUF	2048		/* Client socket buffer		*/
+#define	BENCH_LINK_KBPS	1000		/* Soft-AP link, for the computed time */
+#define	BENCH_MTIME	"Tue, 14 Nov 2023 22:13:20 GMT"	/* SOURCE_DATE_EPOCH */
+#define	BENCH_SSID	"bench-ssid"
+#define	BENCH_PASSWD	"bench-passwd"
+
+static int s_errors;
+
+#define BENCH_CHECK(cond, fmt, ...)					\
+	do {								\
+		if (!(cond)) {						\
+			printf("FAIL %s:%d: " fmt "\n", __func__,	\
+			    __LINE__, ##__VA_ARGS__);			\
+			s_errors++;					\
+		}							\
+	} while (0)
+
+/* web_assets.c, generated by tools/shttpd_pack.py */
+extern const struct usr_asset_table bench_assets;
+
+static const char *s_names[] = {
+	"index.html", "style.css", "app.js", "config.shtml"
+};
+#define	NFILES	(sizeof(s_names) / sizeof(s_names[0]))
+
+static char s_bodies[NFILES][BENCH_FILE_MAX];
+static size_t s_sizes[NFILES];
+static char s_paths[NFILES][64];
+static struct usr_file s_file_list[NFILES + 2];
+
+static struct shttpd_ctx *s_ctx;
+static volatile int s_stop;
+static pthread_t s_server;
+static int s_port;
+static int s_small_buffers;		/* For the checks, not the timing */
+
+struct reply {
+	int	status;
+	char	buf[BENCH_RESP_MAX];
+	size_t	head_len;		/* Headers, with the empty line	*/
+	size_t	len;			/* Headers and body		*/
+	char	*body;
+	size_t	body_len;
+};
+
+struct client {
+	int	sock;
+	int	connects;
+	size_t	bytes;			/* Response bytes received	*/
+	int	slow;			/* Read the next body late	*/
+};
+
+static struct reply s_reply;
+
+static double
+now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec * 1e3 + ts.tv_nsec / 1e6);
+}
+
+int __real_accept(int sock, struct sockaddr *sa, socklen_t *len);
+
+/* A small send buffer, so the larger bodies go out in several sends */
+int
+__wrap_accept(int sock, struct sockaddr *sa, socklen_t *len)
+{
+	int	fd, size = BENCH_SNDBUF;
+
+	fd = __real_accept(sock, sa, len);
+	if (fd >= 0 && s_small_buffers)
+		(void) setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+	return (fd);
+}
+
+static void
+ssi_value(struct shttpd_arg *arg)
+{
+	shttpd_printf(arg, "%s", (const char *)arg->user_data);
+	arg->flags |= SHTTPD_END_OF_OUTPUT;
+}
+
+static void
+load_files(const char *dir)
+{
+	char	path[256];
+	FILE	*fp;
+	size_t	i;
+
+	s_file_list[0].name = "./";
+	s_file_list[0].body = "";
+	for (i = 0; i < NFILES; i++) {
+		snprintf(path, sizeof(path), "%s/%s", dir, s_names[i]);
+		if ((fp = fopen(path, "rb")) == NULL) {
+			printf("cannot open %s: %s\n", path, strerror(errno));
+			exit(1);
+		}
+		s_sizes[i] = fread(s_bodies[i], 1, BENCH_FILE_MAX - 1, fp);
+		BENCH_CHECK(feof(fp), "%s is larger than %d bytes",
+		    path, BENCH_FILE_MAX - 1);
+		fclose(fp);
+		snprintf(s_paths[i], sizeof(s_paths[i]), "./%s", s_names[i]);
+		s_file_list[i + 1].name = s_paths[i];
+		s_file_list[i + 1].body = s_bodies[i];
+	}
+}
+
+static void
+check_table(void)
+{
+	const struct usr_asset	*a;
+	size_t			i;
+
+	for (i = 0; i < NFILES; i++) {
+		a = _shttpd_lookup_asset(s_paths[i]);
+		BENCH_CHECK(a != NULL, "%s not in the table", s_paths[i]);
+	}
+}
+
+static void *
+serve(void *arg)
+{
+	while (!s_stop)
+		shttpd_poll(s_ctx, 100);
+	return (NULL);
+}
+
+static void
+server_start(const struct usr_asset_table *table)
+{
+	_shttpd_init_assets(table);
+	s_stop = 0;
+	pthread_create(&s_server, NULL, serve, NULL);
+}
+
+static void
+server_stop(void)
+{
+	s_stop = 1;
+	pthread_join(s_server, NULL);
+}
+
+static int
+free_port(void)
+{
+	struct sockaddr_in	sa;
+	socklen_t		len = sizeof(sa);
+	int			sock, port;
+
+	sock = socket(AF_INET, SOCK_STREAM, 0);
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(sock, (struct sockaddr *)&sa, sizeof(sa)) != 0 ||
+	    getsockname(sock, (struct sockaddr *)&sa, &len) != 0) {
+		printf("cannot find a free port: %s\n", strerror(errno));
+		exit(1);
+	}
+	port = ntohs(sa.sin_port);
+	close(sock);
+	return (port);
+}
+
+static int
+client_connect(struct client *cl)
+{
+	struct sockaddr_in	sa;
+	int			size = BENCH_RCVBUF;
+
+	cl->sock = socket(AF_INET, SOCK_STREAM, 0);
+	if (s_small_buffers)
+		(void) setsockopt(cl->sock, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_port = htons(s_port);
+	sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (connect(cl->sock, (struct sockaddr *)&sa, sizeof(sa)) != 0) {
+		close(cl->sock);
+		cl->sock = -1;
+		return (-1);
+	}
+	cl->connects++;
+	return (0);
+}
+
+static void
+client_close(struct client *cl)
+{
+	if (cl->sock >= 0)
+		close(cl->sock);
+	cl->sock = -1;
+}
+
+/* The value of a response header, NUL terminated in hdr, or NULL */
+static const char *
+header(const struct reply *r, const char *name, char *hdr, size_t size)
+{
+	const char	*s = r->buf, *e = r->buf + r->head_len, *v, *eol;
+	size_t		len = strlen(name);
+
+	*hdr = '\0';
+	while ((s = memchr(s, '\n', e - s)) != NULL && ++s < e) {
+		if (e - s > (int)len + 1 && !strncasecmp(s, name, len) &&
+		    s[len] == ':') {
+			for (v = s + len + 1; *v == ' '; v++) ;
+			eol = memchr(v, '\r', e - v);
+			if (eol == NULL || (size_t)(eol - v) >= size)
+				return (NULL);
+			memcpy(hdr, v, eol - v);
+			hdr[eol - v] = '\0';
+			return (hdr);
+		}
+	}
+	return (NULL);
+}
+
+/*
+ * Read one response: the headers, then Content-Length bytes, or up to
+ * the close when there is none. 304 and HEAD replies have no body.
+ */
+static int
+read_reply(struct client *cl, int head, struct reply *r)
+{
+	char		hdr[32], *eoh;
+	long		cl_len = -1;
+	ssize_t		n;
+
+	r->len = r->head_len = r->body_len = 0;
+	r->status = 0;
+	r->body = NULL;
+	while ((eoh = r->len ? memmem(r->buf, r->len, "\r\n\r\n", 4) : NULL)
+	    == NULL) {
+		if (r->len == sizeof(r->buf))
+			return (-1);
+		n = recv(cl->sock, r->buf + r->len, sizeof(r->buf) - r->len, 0);
+		if (n <= 0)
+			return (r->len == 0 ? 0 : -1);
+		r->len += n;
+	}
+	r->head_len = eoh + 4 - r->buf;
+	r->body = r->buf + r->head_len;
+	if (sscanf(r->buf, "HTTP/1.%*d %d", &r->status) != 1)
+		return (-1);
+	if (header(r, "Content-Length", hdr, sizeof(hdr)) != NULL)
+		cl_len = atol(hdr);
+	if (head || r->status == 304)
+		cl_len = 0;
+	if (cl->slow)
+		usleep(50 * 1000);
+	while (cl_len < 0 || r->len - r->head_len < (size_t)cl_len) {
+		if (r->len == sizeof(r->buf))
+			return (-1);
+		n = recv(cl->sock, r->buf + r->len, sizeof(r->buf) - r->len, 0);
+		if (n < 0)
+			return (-1);
+		if (n == 0) {
+			if (cl_len >= 0)
+				return (-1);
+			client_close(cl);
+			break;
+		}
+		r->len += n;
+	}
+	r->body_len = r->len - r->head_len;
+	cl->bytes += r->len;
+	return (1);
+}
+
+/*
+ * One request. A kept-alive connection the server has closed meanwhile
+ * is opened again and the request sent once more, like a browser does.
+ */
+static int
+fetch(struct client *cl, const char *method, const char *uri,
+    const char *extra, struct reply *r)
+{
+	char	req[1024];
+	int	len, tries, rc = -1;
+
+	len = snprintf(req, sizeof(req), "%s %s HTTP/1.1\r\n"
+	    "Host: 127.0.0.1\r\n%s\r\n", method, uri, extra ? extra : "");
+	for (tries = 0; tries < 2; tries++) {
+		if (cl->sock < 0 && client_connect(cl) != 0)
+			break;
+		if (send(cl->sock, req, len, 0) == len &&
+		    (rc = read_reply(cl, !strcmp(method, "HEAD"), r)) > 0)
+			break;
+		client_close(cl);
+		rc = -1;
+	}
+	cl->slow = 0;
+	BENCH_CHECK(rc > 0, "%s %s: no response", method, uri);
+	return (rc > 0 ? 0 : -1);
+}
+
+static int
+gunzip(const char *in, size_t in_len, char *out, size_t *out_len)
+{
+	z_stream	zs;
+	int		rc;
+
+	memset(&zs, 0, sizeof(zs));
+	if (inflateInit2(&zs, 16 + MAX_WBITS) != Z_OK)
+		return (-1);
+	zs.next_in = (Bytef *)in;
+	zs.avail_in = in_len;
+	zs.next_out = (Bytef *)out;
+	zs.avail_out = *out_len;
+	rc = inflate(&zs, Z_FINISH);
+	*out_len = zs.total_out;
+	inflateEnd(&zs);
+	return (rc == Z_STREAM_END && zs.avail_in == 0 ? 0 : -1);
+}
+
+static int
+body_is(const struct reply *r, size_t i)
+{
+	return (r->body_len == s_sizes[i] &&
+	    !memcmp(r->body, s_bodies[i], s_sizes[i]));
+}
+
+static int
+is_ssi(size_t i)
+{
+	return (strstr(s_names[i], ".shtml") != NULL);
+}
+
+/* The page the SSI processing should give */
+static void
+expand_ssi(size_t i, char *out, size_t size)
+{
+	const char	*s = s_bodies[i], *m;
+	size_t		n = 0;
+	struct {
+		const char *tag, *value;
+	} calls[] = {
+		{"<!--#call DeviceName -->", BENCH_SSID},
+		{"<!--#call DevicePasswd -->", BENCH_PASSWD},
+	};
+	size_t		k;
+
+	while (*s != '\0' && n + 1 < size) {
+		for (k = 0; k < 2; k++) {
+			m = calls[k].tag;
+			if (!strncmp(s, m, strlen(m)))
+				break;
+		}
+		if (k < 2) {
+			n += snprintf(out + n, size - n, "%s", calls[k].value);
+			s += strlen(calls[k].tag);
+		} else
+			out[n++] = *s++;
+	}
+	out[n] = '\0';
+}
+
+static void
+check_page(const struct reply *r, size_t i)
+{
+	static char	page[BENCH_FILE_MAX];
+
+	expand_ssi(i, page, sizeof(page));
+	BENCH_CHECK(r->body_len == strlen(page) &&
+	    !memcmp(r->body, page, r->body_len),
+	    "%s: SSI page differs (%zu bytes, %zu expected)",
+	    s_names[i], r->body_len, strlen(page));
+}
+
+/* Correctness of one packed asset */
+static void
+check_asset(struct client *cl, size_t i)
+{
+	static char		out[BENCH_FILE_MAX];
+	struct reply		*r = &s_reply;
+	const struct usr_asset	*a = _shttpd_lookup_asset(s_paths[i]);
+	char			uri[80], hdr[128] = "", etag[96] = "", lm[64] = "";
+	char			req[256];
+	size_t			out_len = sizeof(out);
+	int			gz;
+
+	if (a == NULL)
+		return;
+	gz = a->gz_body != NULL;
+	snprintf(uri, sizeof(uri), "/%s", s_names[i]);
+
+	/* Cold, gzip accepted */
+	if (fetch(cl, "GET", uri, "Accept-Encoding: gzip, deflate\r\n", r))
+		return;
+	BENCH_CHECK(r->status == 200, "%s: status %d", uri, r->status);
+	if (is_ssi(i)) {
+		/* The output is made per request, it has no validators */
+		check_page(r, i);
+		BENCH_CHECK(!header(r, "Etag", hdr, sizeof(hdr)),
+		    "%s: SSI page has an etag", uri);
+		return;
+	}
+	BENCH_CHECK(header(r, "Vary", hdr, sizeof(hdr)) &&
+	    !strcmp(hdr, "Accept-Encoding"), "%s: no Vary", uri);
+	BENCH_CHECK(header(r, "Cache-Control", hdr, sizeof(hdr)) &&
+	    !strcmp(hdr, ASSET_CACHE), "%s: no Cache-Control", uri);
+	BENCH_CHECK(header(r, "Last-Modified", lm, sizeof(lm)) &&
+	    !strcmp(lm, BENCH_MTIME), "%s: Last-Modified %s", uri, lm);
+	BENCH_CHECK(header(r, "Etag", etag, sizeof(etag)) != NULL,
+	    "%s: no Etag", uri);
+	if (gz) {
+		BENCH_CHECK(header(r, "Content-Encoding", hdr, sizeof(hdr)) &&
+		    !strcmp(hdr, "gzip"), "%s: not gzip", uri);
+		BENCH_CHECK(strstr(etag, "-gz\"") != NULL,
+		    "%s: gzip etag %s", uri, etag);
+		BENCH_CHECK(gunzip(r->body, r->body_len, out, &out_len) == 0 &&
+		    out_len == s_sizes[i] && !memcmp(out, s_bodies[i], out_len),
+		    "%s: gzip body does not decode to the file", uri);
+	} else {
+		BENCH_CHECK(body_is(r, i), "%s: body differs", uri);
+	}
+
+	/* If-None-Match, and If-Modified-Since alone */
+	snprintf(req, sizeof(req), "Accept-Encoding: gzip\r\n"
+	    "If-None-Match: %s\r\n", etag);
+	if (fetch(cl, "GET", uri, req, r) == 0)
+		BENCH_CHECK(r->status == 304 && r->body_len == 0 &&
+		    header(r, "Etag", hdr, sizeof(hdr)) && !strcmp(hdr, etag),
+		    "%s: If-None-Match gave %d, %zu bytes", uri, r->status,
+		    r->body_len);
+	snprintf(req, sizeof(req), "Accept-Encoding: gzip\r\n"
+	    "If-Modified-Since: %s\r\n", lm);
+	if (fetch(cl, "GET", uri, req, r) == 0)
+		BENCH_CHECK(r->status == 304,
+		    "%s: If-Modified-Since gave %d", uri, r->status);
+	snprintf(req, sizeof(req), "Accept-Encoding: gzip\r\n"
+	    "If-Modified-Since: Sun, 01 Jan 2023 00:00:00 GMT\r\n");
+	if (fetch(cl, "GET", uri, req, r) == 0)
+		BENCH_CHECK(r->status == 200,
+		    "%s: older If-Modified-Since gave %d", uri, r->status);
+	/* The etag decides over the date */
+	snprintf(req, sizeof(req), "Accept-Encoding: gzip\r\n"
+	    "If-None-Match: \"0123456789abcdef\"\r\n"
+	    "If-Modified-Since: %s\r\n", lm);
+	if (fetch(cl, "GET", uri, req, r) == 0)
+		BENCH_CHECK(r->status == 200,
+		    "%s: stale If-None-Match gave %d", uri, r->status);
+
+	/* HEAD, then the connection still serves */
+	if (fetch(cl, "HEAD", uri, "Accept-Encoding: gzip\r\n", r) == 0)
+		BENCH_CHECK(r->status == 200 && r->body_len == 0 &&
+		    header(r, "Content-Length", hdr, sizeof(hdr)) &&
+		    (unsigned long)atol(hdr) == (gz ? a->gz_size : a->size),
+		    "%s: HEAD gave %d, %zu bytes", uri, r->status, r->body_len);
+
+	/* "*" as the whole field, and only then */
+	if (fetch(cl, "GET", uri, "Accept-Encoding: gzip\r\n"
+	    "If-None-Match:  * \r\n", r) == 0)
+		BENCH_CHECK(r->status == 304,
+		    "%s: If-None-Match * gave %d", uri, r->status);
+	if (fetch(cl, "GET", uri, "Accept-Encoding: gzip\r\n"
+	    "If-None-Match: \"0123*\", W/\"*\"\r\n", r) == 0)
+		BENCH_CHECK(r->status == 200,
+		    "%s: * inside If-None-Match gave %d", uri, r->status);
+
+	if (gz && a->body == NULL) {
+		/* Gzip only: refused gzip is not acceptable, "*" is gzip */
+		if (fetch(cl, "GET", uri, "Accept-Encoding: identity\r\n",
+		    r) == 0)
+			BENCH_CHECK(r->status == 406 &&
+			    !header(r, "Content-Encoding", hdr, sizeof(hdr)),
+			    "%s: identity only gave %d", uri, r->status);
+		if (fetch(cl, "GET", uri, "Accept-Encoding: deflate, gzip;q=0, "
+		    "*\r\n", r) == 0)
+			BENCH_CHECK(r->status == 406,
+			    "%s: gzip;q=0 gave %d", uri, r->status);
+		if (fetch(cl, "GET", uri, "Accept-Encoding: *\r\n", r) == 0)
+			BENCH_CHECK(r->status == 200 &&
+			    header(r, "Content-Encoding", hdr, sizeof(hdr)),
+			    "%s: * gave %d, not gzip", uri, r->status);
+		if (fetch(cl, "GET", uri, NULL, r) == 0)
+			BENCH_CHECK(r->status == 200 &&
+			    header(r, "Content-Encoding", hdr, sizeof(hdr)),
+			    "%s: no Accept-Encoding gave %d, not gzip", uri,
+			    r->status);
+	}
+
+	if (!gz || a->body == NULL)
+		return;
+
+	/* Identity: refused gzip, no Accept-Encoding, read late */
+	cl->slow = 1;
+	if (fetch(cl, "GET", uri, "Accept-Encoding: deflate, gzip;q=0\r\n", r))
+		return;
+	BENCH_CHECK(r->status == 200 && body_is(r, i) &&
+	    !header(r, "Content-Encoding", hdr, sizeof(hdr)),
+	    "%s: gzip;q=0 gave %d, %zu bytes", uri, r->status, r->body_len);
+	BENCH_CHECK(header(r, "Etag", hdr, sizeof(hdr)) && !strstr(hdr, "-gz"),
+	    "%s: identity etag %s", uri, hdr);
+	if (fetch(cl, "GET", uri, NULL, r) == 0)
+		BENCH_CHECK(r->status == 200 && body_is(r, i),
+		    "%s: no Accept-Encoding gave %d, %zu bytes", uri,
+		    r->status, r->body_len);
+	if (fetch(cl, "GET", uri, "Accept-Encoding: gzip;q=0.5\r\n", r) == 0)
+		BENCH_CHECK(header(r, "Content-Encoding", hdr, sizeof(hdr)),
+		    "%s: gzip;q=0.5 not gzip", uri);
+	/* The gzip etag does not validate the identity body */
+	snprintf(req, sizeof(req), "If-None-Match: %s\r\n", etag);
+	if (fetch(cl, "GET", uri, req, r) == 0)
+		BENCH_CHECK(r->status == 200 && body_is(r, i),
+		    "%s: gzip etag on identity gave %d", uri, r->status);
+}
+
+static void
+check_packed(void)
+{
+	struct client	cl = {-1};
+	struct reply	*r = &s_reply;
+	size_t		i;
+
+	for (i = 0; i < NFILES; i++)
+		check_asset(&cl, i);
+	/* The directory index, from the table */
+	if (fetch(&cl, "GET", "/", "Accept-Encoding: gzip\r\n", r) == 0)
+		BENCH_CHECK(r->status == 200 && r->body_len > 0,
+		    "/: status %d, %zu bytes", r->status, r->body_len);
+	if (fetch(&cl, "GET", "/missing.html", NULL, r) == 0)
+		BENCH_CHECK(r->status == 404, "/missing.html: status %d",
+		    r->status);
+	client_close(&cl);
+}
+
+static void
+check_plain(void)
+{
+	struct client	cl = {-1};
+	struct reply	*r = &s_reply;
+	char		uri[80];
+	size_t		i;
+
+	for (i = 0; i < NFILES; i++) {
+		snprintf(uri, sizeof(uri), "/%s", s_names[i]);
+		cl.slow = 1;
+		if (fetch(&cl, "GET", uri, "Accept-Encoding: gzip\r\n", r))
+			continue;
+		BENCH_CHECK(r->status == 200, "%s: status %d", uri, r->status);
+		if (is_ssi(i))
+			check_page(r, i);
+		else
+			BENCH_CHECK(body_is(r, i), "%s: body differs", uri);
+	}
+	client_close(&cl);
+}
+
+/*
+ * Load every page like a browser: cold with no cache, then warm with the
+ * validators of the cold load.
+ */
+static void
+bench_load(const char *server, int packed)
+{
+	static char	etags[NFILES][96], lms[NFILES][64];
+	struct client	cl = {-1};
+	struct reply	*r = &s_reply;
+	char		uri[80], req[512];
+	const char	*load;
+	double		start, ms;
+	size_t		i;
+	int		warm;
+
+	for (warm = 0; warm < 2; warm++) {
+		load = warm ? "warm" : "cold";
+		cl.bytes = cl.connects = 0;
+		start = now_ms();
+		for (i = 0; i < NFILES; i++) {
+			snprintf(uri, sizeof(uri), "/%s", s_names[i]);
+			snprintf(req, sizeof(req),
+			    "Accept-Encoding: gzip, deflate\r\n");
+			if (warm && etags[i][0] != '\0')
+				snprintf(req + strlen(req),
+				    sizeof(req) - strlen(req),
+				    "If-None-Match: %s\r\n", etags[i]);
+			if (warm && lms[i][0] != '\0')
+				snprintf(req + strlen(req),
+				    sizeof(req) - strlen(req),
+				    "If-Modified-Since: %s\r\n", lms[i]);
+			if (fetch(&cl, "GET", uri, req, r))
+				continue;
+			if (warm) {
+				BENCH_CHECK(!packed || is_ssi(i) ||
+				    r->status == 304, "%s: warm status %d",
+				    uri, r->status);
+				continue;
+			}
+			if (header(r, "Etag", etags[i], sizeof(etags[i])) == NULL)
+				etags[i][0] = '\0';
+			if (header(r, "Last-Modified", lms[i],
+			    sizeof(lms[i])) == NULL)
+				lms[i][0] = '\0';
+		}
+		ms = now_ms() - start;
+		client_close(&cl);
+		/* 304 keeps the connection, only the SSI page closes it */
+		BENCH_CHECK(!packed || cl.connects == 1,
+		    "%s %s load took %d connections", server, load,
+		    cl.connects);
+		printf("%-7s %-5s %9zu %6d %11.2f %11.1f\n", server, load,
+		    cl.bytes, cl.connects, ms,
+		    cl.bytes * 8.0 / BENCH_LINK_KBPS);
+	}
+	memset(etags, 0, sizeof(etags));
+	memset(lms, 0, sizeof(lms));
+}
+
+int
+main(int argc, char *argv[])
+{
+	char	port[16];
+	char	*args[] = {"shttpd_bench", NULL};
+
+	signal(SIGPIPE, SIG_IGN);
+	load_files(argc > 1 ? argv[1] : "web");
+	_shttpd_init_local_file(s_file_list, NFILES + 2);
+	_shttpd_init_assets(&bench_assets);
+	check_table();
+
+	if ((s_ctx = shttpd_init(1, args)) == NULL) {
+		printf("shttpd_init failed\n");
+		return (1);
+	}
+	s_port = free_port();
+	snprintf(port, sizeof(port), "%d", s_port);
+	shttpd_set_option(s_ctx, "ports", port);
+	shttpd_register_ssi_func(s_ctx, "DeviceName", ssi_value, BENCH_SSID);
+	shttpd_register_ssi_func(s_ctx, "DevicePasswd", ssi_value,
+	    BENCH_PASSWD);
+
+	printf("%zu pages, response bytes, link time computed at %d kbit/s\n",
+	    NFILES, BENCH_LINK_KBPS);
+	printf("%-7s %-5s %9s %6s %11s %11s\n", "server", "load", "bytes",
+	    "conns", "loopback ms", "link ms");
+
+	server_start(NULL);
+	s_small_buffers = 1;
+	check_plain();
+	s_small_buffers = 0;
+	bench_load("plain", 0);
+	server_stop();
+
+	server_start(&bench_assets);
+	s_small_buffers = 1;
+	check_packed();
+	s_small_buffers = 0;
+	bench_load("packed", 1);
+	server_stop();
+
+	shttpd_fini(s_ctx);
+	if (s_errors) {
+		printf("%d checks failed\n", s_errors);
+		return (1);
+	}
+	return (0);
+}
@@ -0,0 +1,202 @@
+/* Provisioning page of the XR871 web server demo */
+(function () {
+  'use strict';
+
+  var SCAN_PERIOD = 5000;
+  var STATUS_PERIOD = 2000;
+  var RETRY_MAX = 5;
+
+  var $ = function (id) { return document.getElementById(id); };
+
+  var state = {
+    aps: [],
+    selected: null,
+    failures: 0,
+    scanTimer: 0,
+    statusTimer: 0
+  };
+
+  function toast(text, error) {
+    var el = $('toast');
+    el.textContent = text;
+    el.className = error ? 'toast error' : 'toast';
+    el.hidden = false;
+    clearTimeout(toast.timer);
+    toast.timer = setTimeout(function () { el.hidden = true; }, 3000);
+  }
+
+  function setState(online) {
+    var el = $('state');
+    el.textContent = online ? 'online' : 'offline';
+    el.className = online ? 'state online' : 'state offline';
+  }
+
+  function request(method, url, body, done) {
+    var xhr = new XMLHttpRequest();
+    xhr.open(method, url, true);
+    xhr.timeout = 4000;
+    if (body !== null)
+      xhr.setRequestHeader('Content-Type', 'application/x-www-form-urlencoded');
+    xhr.onload = function () {
+      if (xhr.status >= 200 && xhr.status < 300)
+        done(null, xhr.responseText);
+      else
+        done(new Error('HTTP ' + xhr.status), null);
+    };
+    xhr.onerror = function () { done(new Error('network error'), null); };
+    xhr.ontimeout = function () { done(new Error('timed out'), null); };
+    xhr.send(body);
+  }
+
+  function encode(fields) {
+    var parts = [];
+    for (var k in fields) {
+      if (Object.prototype.hasOwnProperty.call(fields, k))
+        parts.push(encodeURIComponent(k) + '=' + encodeURIComponent(fields[k]));
+    }
+    return parts.join('&');
+  }
+
+  /* RSSI in dBm to 1..4 bars */
+  function bars(rssi) {
+    if (rssi >= -55)
+      return 4;
+    if (rssi >= -67)
+      return 3;
+    if (rssi >= -78)
+      return 2;
+    return 1;
+  }
+
+  function parseScan(text) {
+    /* one access point per line: ssid<TAB>rssi<TAB>secure */
+    var aps = [];
+    var seen = {};
+    text.split('\n').forEach(function (line) {
+      var f = line.split('\t');
+      if (f.length < 3 || f[0] === '' || seen[f[0]])
+        return;
+      seen[f[0]] = true;
+      aps.push({ ssid: f[0], rssi: parseInt(f[1], 10), secure: f[2] === '1' });
+    });
+    aps.sort(function (a, b) { return b.rssi - a.rssi; });
+    return aps;
+  }
+
+  function renderAps() {
+    var list = $('aps');
+    while (list.firstChild)
+      list.removeChild(list.firstChild);
+    if (state.aps.length === 0) {
+      var empty = document.createElement('li');
+      empty.className = 'empty';
+      empty.textContent = 'No networks found';
+      list.appendChild(empty);
+      return;
+    }
+    state.aps.forEach(function (ap) {
+      var li = document.createElement('li');
+      var name = document.createElement('span');
+      var sig = document.createElement('span');
+      name.className = ap.secure ? 'ssid lock' : 'ssid';
+      name.textContent = ap.ssid;
+      sig.className = 'signal s' + bars(ap.rssi);
+      sig.title = ap.rssi + ' dBm';
+      for (var i = 0; i < 4; i++)
+        sig.appendChild(document.createElement('i'));
+      li.appendChild(name);
+      li.appendChild(sig);
+      if (ap.ssid === state.selected)
+        li.className = 'selected';
+      li.addEventListener('click', function () { select(ap); });
+      list.appendChild(li);
+    });
+  }
+
+  function select(ap) {
+    state.selected = ap.ssid;
+    $('ssid').value = ap.ssid;
+    $('psk').disabled = !ap.secure;
+    if (ap.secure)
+      $('psk').focus();
+    renderAps();
+  }
+
+  function scan() {
+    clearTimeout(state.scanTimer);
+    request('GET', '/get/scan', null, function (err, text) {
+      if (!err) {
+        state.aps = parseScan(text);
+        renderAps();
+      }
+      state.scanTimer = setTimeout(scan, SCAN_PERIOD);
+    });
+  }
+
+  function uptime(sec) {
+    var d = Math.floor(sec / 86400);
+    var h = Math.floor(sec / 3600) % 24;
+    var m = Math.floor(sec / 60) % 60;
+    var s = sec % 60;
+    var pad = function (n) { return n < 10 ? '0' + n : '' + n; };
+    return (d ? d + 'd ' : '') + pad(h) + ':' + pad(m) + ':' + pad(s);
+  }
+
+  function status() {
+    clearTimeout(state.statusTimer);
+    request('GET', '/get/status', null, function (err, text) {
+      if (err) {
+        if (++state.failures >= RETRY_MAX)
+          setState(false);
+      } else {
+        var kv = {};
+        text.split('\n').forEach(function (line) {
+          var i = line.indexOf('=');
+          if (i > 0)
+            kv[line.slice(0, i)] = line.slice(i + 1);
+        });
+        state.failures = 0;
+        setState(true);
+        $('fw').textContent = kv.fw || '-';
+        $('mac').textContent = kv.mac || '-';
+        $('uptime').textContent = kv.uptime ? uptime(parseInt(kv.uptime, 10)) : '-';
+        $('heap').textContent = kv.heap ? Math.round(kv.heap / 1024) + ' KB' : '-';
+      }
+      state.statusTimer = setTimeout(status, STATUS_PERIOD);
+    });
+  }
+
+  function join(ev) {
+    ev.preventDefault();
+    var ssid = $('ssid').value.trim();
+    var psk = $('psk').value;
+    if (ssid.length === 0 || ssid.length > 32) {
+      toast('The network name must be 1 to 32 characters', true);
+      return;
+    }
+    if (!$('psk').disabled && psk.length > 0 && (psk.length < 8 || psk.length > 64)) {
+      toast('The password must be 8 to 63 characters, or 64 hex digits', true);
+      return;
+    }
+    var button = ev.target.querySelector('button[type="submit"]');
+    button.disabled = true;
+    request('POST', '/devicename', encode({ DeviceName: ssid, DevicePasswd: psk }),
+      function (err) {
+        button.disabled = false;
+        if (err)
+          toast('Saving failed: ' + err.message, true);
+        else
+          toast('Saved, the device joins ' + ssid + ' now');
+      });
+  }
+
+  document.addEventListener('DOMContentLoaded', function () {
+    $('join').addEventListener('submit', join);
+    $('rescan').addEventListener('click', scan);
+    $('show').addEventListener('change', function (ev) {
+      $('psk').type = ev.target.checked ? 'text' : 'password';
+    });
+    scan();
+    status();
+  });
+})();
@@ -49,6 +49,11 @@ static const struct usr_file file_list[] = {
 	{NULL},
 };
 
+#if defined(SHTTPD_ASSETS)
+/* web_assets.c, generated by tools/shttpd_pack.py */
+extern const struct usr_asset_table shttpd_assets;
+#endif
+
 struct shttpd_ap_info ap_info;
 
 static const char init_ssid[] = "ap-ssid";
@@ -188,6 +193,9 @@ int webserver_start(int argc, char *argv[])
 	struct shttpd_ctx *ctx;
 
 	_shttpd_init_local_file(file_list, ARRAY_SIZE(file_list));
+#if defined(SHTTPD_ASSETS)
+	_shttpd_init_assets(&shttpd_assets);
+#endif
 
 	if ((ctx = shttpd_init(argc, argv)) == NULL) {
 		_shttpd_elog(E_FATAL, NULL, "Cannot initialize SHTTPD context.");
@@ -38,6 +38,8 @@ struct local {
 
 struct llhead	registered_file;
 
+static const struct usr_asset_table *registered_assets;
+
 time_t TIME(time_t *timer)
 {
 	if (!timer)
@@ -73,20 +75,17 @@ void _shttpd_init_local_file(const struct usr_file *list, int count)
 	struct local *file = NULL;
 
 	LL_INIT(&registered_file);
-	for (i = 0; i < count; i++) {
+	for (i = 0; i < count && list[i].name != NULL; i++) {
 		if ((file = _shttpd_zalloc(sizeof(*file))) == NULL)
 		{
 			_shttpd_elog(E_LOG, NULL, "init local file _shttpd_zalloc failed.");
 			return;
 		}
-		if (list[i].name != NULL) {
-			file->name = list[i].name;
-			file->mode = (file->name[strlen(file->name)-1]
-				             == '/')? _S_IFDIR : _S_IFREG;
-			if (file->mode == _S_IFREG)
-				file->body = list[i].body;
-		} else
-			break;
+		file->name = list[i].name;
+		file->mode = (file->name[strlen(file->name)-1]
+			             == '/')? _S_IFDIR : _S_IFREG;
+		if (file->mode == _S_IFREG)
+			file->body = list[i].body;
 		LL_ADD(&registered_file, &file->link);
 	}
 }
@@ -150,18 +149,75 @@ int _shttpd_lookup_file(struct local **file, const char *name)
 	return -1;
 }
 
+void _shttpd_init_assets(const struct usr_asset_table *table)
+{
+	if (table != NULL && (table->nslots == 0 ||
+	    (table->nslots & (table->nslots - 1)) != 0)) {
+		_shttpd_elog(E_LOG, NULL, "invalid param (%s)",__func__);
+		return;
+	}
+	registered_assets = table;
+}
+
+/* FNV-1a of the lower case name, must match tools/shttpd_pack.py */
+static unsigned long asset_hash(unsigned long seed, const char *name)
+{
+	unsigned long h = 2166136261UL ^ seed;
+
+	for (; *name != '\0'; name++) {
+		h ^= (unsigned char)tolower(*(const unsigned char *)name);
+		h = (h * 16777619UL) & 0xffffffffUL;
+	}
+	/* FNV leaves the low bits poor, mix them before masking */
+	h ^= h >> 16;
+	h = (h * 0x85ebca6bUL) & 0xffffffffUL;
+	h ^= h >> 13;
+	return h;
+}
+
+const struct usr_asset *_shttpd_lookup_asset(const char *name)
+{
+	const struct usr_asset_table *table = registered_assets;
+	const struct usr_asset *asset;
+	unsigned int slot;
+
+	if (table == NULL)
+		return NULL;
+	slot = table->slots[asset_hash(table->seed, name) & (table->nslots - 1)];
+	if (slot == 0)
+		return NULL;
+	asset = &table->assets[slot - 1];
+	if (_shttpd_strncasecmp(asset->name, name, strlen(asset->name) + 1) != 0)
+		return NULL;
+	return asset;
+}
+
 void _shttpd_set_close_on_exec(int fd)
 {
 }
 
 int _shttpd_stat(const char *path, struct stat *stp)
 {
-        struct local *file;
+	struct local *file;
+	const struct usr_asset *asset;
+
+	if ((asset = _shttpd_lookup_asset(path)) != NULL) {
+		if (asset->body == NULL && asset->gz_body == NULL) {
+			stp->st_mode = _S_IFDIR;
+			stp->st_size = 0;
+		} else {
+			stp->st_mode = _S_IFREG;
+			stp->st_size = asset->body ? asset->size : asset->gz_size;
+		}
+		stp->st_mtime = (time_t)asset->mtime;
+		return 0;
+	}
 	 if (_shttpd_lookup_file(&file, path) != 0) {
 	 	_shttpd_elog(E_LOG, NULL, "file path mismatch (%s).", __func__);
 		return -1;
 	 }
 	stp->st_mode = file->mode;
+	stp->st_mtime = 0;
 	if (stp->st_mode == _S_IFREG)
 		stp->st_size = strlen(file->body);
 	else
@@ -172,7 +228,11 @@ int _shttpd_stat(const char *path, struct stat *stp)
 char* _shttpd_open(const char *path, int flags, int mode)
 {
 	struct local *file;
+	const struct usr_asset *asset;
 
+	/* Only the identity body, for SSI */
+	if ((asset = _shttpd_lookup_asset(path)) != NULL)
+		return (char *)asset->body;
 	if (_shttpd_lookup_file(&file, path) != 0) {
 		_shttpd_elog(E_LOG, NULL, "file path mismatch (%s).", __func__);
 		return NULL;
@@ -23,7 +23,7 @@ write_file(struct stream *stream, const void *buf, size_t len)
 #else
 	int		n;
 	if (stream->io.total + len > stream->io.size)
-	char *fp = (char *)stream->conn->loc.chan.fh;
+	char *fp = stream->conn->loc.chan.fh;
 	memcpy(fp + stream->io.total, buf, len);
 #endif
 
@@ -46,6 +46,44 @@ write_file(struct stream *stream, const void *buf, size_t len)
 
 }
 
+#if !defined(SHTTPD_FS) && defined(SHTTPD_ZERO_COPY)
+/*
+ * The body is in memory already, send it to the socket from there
+ * instead of copying it through the IO buffer, like sendfile() does.
+ */
+static int
+send_body(struct stream *stream)
+{
+	int		sock, n;
+	const char	*fp = stream->chan.fh;
+
+	sock = stream->conn->rem.chan.sock;
+	stream->flags |= FLAG_DONT_CLOSE;
+
+	/* The headers go first */
+	if (io_data_len(&stream->io) > 0) {
+		n = send(sock, io_data(&stream->io), io_data_len(&stream->io), 0);
+		if (n > 0)
+			io_inc_tail(&stream->io, n);
+		if (io_data_len(&stream->io) > 0)
+			goto check;
+	}
+
+	n = send(sock, fp + stream->io.total,
+	    stream->content_len - stream->io.total, 0);
+	if (n > 0) {
+		stream->io.total += n;
+		return (0);
+	}
+check:
+	if (n <= 0 && !(n == -1 && (ERRNO == EINTR || ERRNO == EWOULDBLOCK))) {
+		stream->flags &= ~FLAG_DONT_CLOSE;
+		return (-1);
+	}
+	return (0);
+}
+#endif /* !SHTTPD_FS && SHTTPD_ZERO_COPY */
+
 static int
 read_file(struct stream *stream, void *buf, size_t len)
 {
@@ -93,9 +131,13 @@ read_file(struct stream *stream, void *buf, size_t len)
 	assert(stream->chan.fd != -1);
 	return (read(stream->chan.fd, buf, len));
 #else
+#if defined(SHTTPD_ZERO_COPY)
+	if (stream->conn->rem.io_class == &_shttpd_io_socket)
+		return (send_body(stream));
+#endif
 	int sent_length = 0;
 	sent_length = len;
-	char *fp = (char *)stream->conn->loc.chan.fh;
+	char *fp = stream->conn->loc.chan.fh;
 	memcpy(buf, fp + stream->io.total, sent_length);
 	return sent_length;
 #endif
@@ -108,7 +150,7 @@ close_file(struct stream *stream)
 	assert(stream->chan.fd != -1);
 	(void) close(stream->chan.fd);
 #else
-	stream->conn->loc.chan.fh = 0;
+	stream->conn->loc.chan.fh = NULL;
 	//stream->conn->loc.chan.fi.filelength = 0;
 #endif
 }
@@ -188,6 +230,167 @@ _shttpd_get_file(struct conn *c, struct stat *stp)
 		_shttpd_stop_stream(&c->loc);
 }
 
+#if !defined(SHTTPD_FS)
+/*
+ * Does the Accept-Encoding: header allow gzip, by name or by "*"
+ */
+static int
+accept_gzip(const struct vec *ae)
+{
+	const char	*s = ae->ptr, *e = ae->ptr + ae->len, *q;
+	size_t		n;
+	int		ok, star = FALSE;
+
+	while (s != NULL && s < e) {
+		while (s < e && (*s == ' ' || *s == ','))
+			s++;
+		for (n = 0; s + n < e && s[n] != ',' && s[n] != ';' &&
+		    s[n] != ' '; n++) ;
+		if ((n == 4 && !_shttpd_strncasecmp(s, "gzip", 4)) ||
+		    (n == 1 && *s == '*')) {
+			/* gzip;q=0 refuses it */
+			for (q = s + n; q < e && *q != ',' && *q != '='; q++) ;
+			if (q == e || *q == ',') {
+				ok = TRUE;
+			} else {
+				for (q++; q < e && (*q == '0' || *q == '.'); q++) ;
+				ok = q < e && *q >= '1' && *q <= '9';
+			}
+			if (n == 4)
+				return (ok);
+			star = ok;
+		}
+		s = memchr(s, ',', e - s);
+	}
+	return (star);
+}
+
+/*
+ * Does the If-None-Match: header list the etag
+ */
+static int
+match_etag(const struct vec *inm, const char *etag)
+{
+	const char	*s = inm->ptr, *e = inm->ptr + inm->len;
+	size_t		len = strlen(etag);
+
+	/* "*" matches any etag, but only as the whole field */
+	while (s < e && *s == ' ')
+		s++;
+	while (e > s && e[-1] == ' ')
+		e--;
+	if (e - s == 1 && *s == '*')
+		return (TRUE);
+
+	for (; s < e; s++) {
+		if (*s == '"' && (size_t)(e - s) >= len + 2 &&
+		    !memcmp(s + 1, etag, len) && s[len + 1] == '"')
+			return (TRUE);
+	}
+	return (FALSE);
+}
+
+/*
+ * Send an asset packed with tools/shttpd_pack.py: pick the encoding,
+ * answer 304 to a cached copy, or send the body from where it is.
+ */
+void
+_shttpd_get_asset(struct conn *c, const struct usr_asset *asset)
+{
+	char		date[64], lm[64], etag[72];
+	const char	*fmt = "%a, %d %b %Y %H:%M:%S GMT", *body, *ce = "";
+	time_t		mtime = (time_t)asset->mtime;
+	big_int_t	cl;
+	size_t		n;
+
+	if (c->mime_type.len == 0)
+		_shttpd_get_mime_type(c->ctx, c->uri,
+		    strlen(c->uri), &c->mime_type);
+
+	if (asset->body == NULL && c->ch.ae.v_vec.len > 0 &&
+	    !accept_gzip(&c->ch.ae.v_vec)) {
+		/* Packed gzip only, and the client refuses gzip */
+		_shttpd_send_server_error(c, 406, "Not Acceptable");
+		return;
+	}
+
+	if (asset->gz_body != NULL &&
+	    (asset->body == NULL || accept_gzip(&c->ch.ae.v_vec))) {
+		/* Without Accept-Encoding any encoding is acceptable */
+		body = asset->gz_body;
+		cl = asset->gz_size;
+		ce = "Content-Encoding: gzip\r\n";
+		(void) _shttpd_snprintf(etag, sizeof(etag), "%s-gz", asset->etag);
+	} else {
+		body = asset->body;
+		cl = asset->size;
+		_shttpd_strlcpy(etag, asset->etag, sizeof(etag));
+	}
+
+	(void) strftime(date, sizeof(date),
+	    fmt, gmtime(&_shttpd_current_time));
+	(void) strftime(lm, sizeof(lm), fmt, gmtime(&mtime));
+
+	io_clear(&c->loc.io);
+	if ((c->ch.inm.v_vec.len > 0 && match_etag(&c->ch.inm.v_vec, etag)) ||
+	    (c->ch.inm.v_vec.len == 0 && c->ch.ims.v_time &&
+	     mtime <= c->ch.ims.v_time)) {
+		c->loc.io.head = c->loc.headers_len = _shttpd_snprintf(
+		    c->loc.io.buf, c->loc.io.size,
+		    "HTTP/1.1 304 Not Modified\r\n"
+		    "Date: %s\r\n"
+		    "Etag: \"%s\"\r\n"
+		    "Cache-Control: %s\r\n"
+		    "Vary: Accept-Encoding\r\n"
+		    "\r\n",
+		    date, etag, ASSET_CACHE);
+		c->status = 304;
+		c->loc.content_len = 0;
+		_shttpd_stop_stream(&c->loc);
+		return;
+	}
+
+	c->loc.io.head = c->loc.headers_len = _shttpd_snprintf(c->loc.io.buf,
+	    c->loc.io.size,
+	    "HTTP/1.1 200 OK\r\n"
+	    "Date: %s\r\n"
+	    "Last-Modified: %s\r\n"
+	    "Etag: \"%s\"\r\n"
+	    "Cache-Control: %s\r\n"
+	    "Vary: Accept-Encoding\r\n"
+	    "%s"
+	    "Content-Type: %.*s\r\n"
+	    "Content-Length: %lu\r\n"
+	    "\r\n",
+	    date, lm, etag, ASSET_CACHE, ce,
+	    c->mime_type.len, c->mime_type.ptr, cl);
+
+	c->status = 200;
+	c->loc.chan.fh = (char *)body;
+	c->loc.content_len = cl;
+	c->loc.io_class = &_shttpd_io_file;
+	c->loc.flags |= FLAG_R | FLAG_ALWAYS_READY;
+
+	if (c->method == METHOD_HEAD || cl == 0) {
+		_shttpd_stop_stream(&c->loc);
+		return;
+	}
+
+	/*
+	 * Put the start of the body behind the headers, so that they leave
+	 * in one send: a small body sent after them waits for the delayed
+	 * ACK of the peer, 40 ms or more.
+	 */
+	n = io_space_len(&c->loc.io);
+	if ((big_int_t)n > cl)
+		n = cl;
+	(void) memcpy(io_space(&c->loc.io), body, n);
+	io_inc_head(&c->loc.io, n);
+	if (c->loc.io.total == cl)
+		_shttpd_stop_stream(&c->loc);
+}
+#endif /* !SHTTPD_FS */
+
 const struct io_class	_shttpd_io_file =  {
 	"file",
 	read_file,
@@ -543,8 +543,8 @@ _shttpd_do_ssi(struct conn *c)
 		    "Cannot allocate SSI descriptor");
 	} else {
 #if !defined(SHTTPD_FS)
-		ssi->incs[0].fp = (char *)c->loc.chan.fh;
-		ssi->incs[0].fl = strlen((char *)(c->loc.chan.fh));
+		ssi->incs[0].fp = c->loc.chan.fh;
+		ssi->incs[0].fl = strlen(c->loc.chan.fh);
 #else
 		ssi->incs[0].fp = fdopen(c->loc.chan.fd, "r");
 #endif
@@ -48,6 +48,8 @@ static const struct http_header http_headers[] = {
 	{7,  HDR_STRING, OFFSET(range),		"Range: "		},
 	{12, HDR_STRING, OFFSET(connection),	"Connection: "		},
 	{19, HDR_STRING, OFFSET(transenc),	"Transfer-Encoding: "	},
+	{15, HDR_STRING, OFFSET(inm),		"If-None-Match: "	},
+	{17, HDR_STRING, OFFSET(ae),		"Accept-Encoding: "	},
 	{0,  HDR_INT,	 0,			NULL			}
 };
 
@@ -556,6 +558,9 @@ decide_what_to_do(struct conn *c)
 	int		rc = 0;
 	rc = rc;
 	struct registered_uri	*ruri;
+#if !defined(SHTTPD_FS)
+	const struct usr_asset	*asset;
+#endif
 
 #if defined(SHTTPD_MEM_IN_HEAP)
 	if ((buf = (char *)_shttpd_zalloc(1024)) == NULL) {
@@ -693,7 +698,7 @@ decide_what_to_do(struct conn *c)
 	} else if (_shttpd_match_extension(path,
 	    c->ctx->options[OPT_SSI_EXTENSIONS])) {
 #if !defined(SHTTPD_FS)
-	    	if ((c->loc.chan.fh =(unsigned int)_shttpd_open(path, 0, 0)) == 0) {
+	    	if ((c->loc.chan.fh = _shttpd_open(path, 0, 0)) == NULL) {
 #else
 		if ((c->loc.chan.fd = _shttpd_open(path,
 		    O_RDONLY | O_BINARY, 0644)) == -1) {
@@ -710,8 +715,9 @@ decide_what_to_do(struct conn *c)
 	    O_RDONLY | O_BINARY, 0644)) != -1) {
 		_shttpd_get_file(c, &st);
 #else
-	}
-	else if ((c->loc.chan.fh = (unsigned int)_shttpd_open(path, 0, 0)) != 0) {
+	} else if ((asset = _shttpd_lookup_asset(path)) != NULL) {
+		_shttpd_get_asset(c, asset);
+	} else if ((c->loc.chan.fh = _shttpd_open(path, 0, 0)) != NULL) {
 		_shttpd_get_file(c, &st);
 #endif
 	} else {
@@ -1078,9 +1084,12 @@ connection_desctructor(struct llhead *lp)
 	if (c->rem.io_class == NULL)
 		do_close = 1;
 
-	/* Keep the connection open only if we have Content-Length set */
+	/*
+	 * Keep the connection open only if we have Content-Length set,
+	 * or the reply has no body, like a 304 to a cached asset
+	 */
 
-	if (!do_close && c->loc.content_len > 0) {
+	if (!do_close && (c->loc.content_len > 0 || c->status == 304)) {
 		DBG(("Keep connection.\n"));
 		c->loc.io_class = NULL;
 		c->loc.flags = 0;
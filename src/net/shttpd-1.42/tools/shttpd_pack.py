@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+#
+#  Redistribution and use in source and binary forms, with or without
+#  modification, are permitted provided that the following conditions
+#  are met:
+#    1. Redistributions of source code must retain the above copyright
+#       notice, this list of conditions and the following disclaimer.
+#    2. Redistributions in binary form must reproduce the above copyright
+#       notice, this list of conditions and the following disclaimer in the
+#       documentation and/or other materials provided with the
+#       distribution.
+#    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+#       its contributors may be used to endorse or promote products derived
+#       from this software without specific prior written permission.
+#
+#  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+#  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+#  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+#  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+#  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+#  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+#  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+#  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+#  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+#  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+#  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+
+"""Pack a directory of web assets into a C table for shttpd.
+
+    shttpd_pack.py web/ -o web_assets.c
+
+The output defines `const struct usr_asset_table <name>`; register it with
+_shttpd_init_assets(&<name>) before shttpd_init(). Files are stored gzip
+compressed when that saves at least 10%, SSI pages and files given with
+--plain keep their identity body too. Names are looked up through a perfect
+hash, the seed is searched here and the hash must match asset_hash() in
+compat_rtos.c. bench/run.sh serves a packed directory with the shttpd sources
+built on the host.
+"""
+
+import argparse
+import gzip
+import hashlib
+import os
+import sys
+
+SSI_EXT = ('.shtml', '.shtm')
+STORED_EXT = ('.png', '.jpg', '.jpeg', '.gif', '.ico', '.gz', '.zip', '.mp3')
+
+
+def fnv1a(seed, name):
+    h = 2166136261 ^ seed
+    for c in name.lower().encode():
+        h ^= c
+        h = (h * 16777619) & 0xffffffff
+    # FNV leaves the low bits poor, mix them before masking
+    h ^= h >> 16
+    h = (h * 0x85ebca6b) & 0xffffffff
+    h ^= h >> 13
+    return h
+
+
+def perfect_hash(names):
+    nslots = 1
+    while nslots < 2 * len(names):
+        nslots <<= 1
+    for seed in range(1 << 20):
+        slots = {}
+        for i, name in enumerate(names):
+            slot = fnv1a(seed, name) & (nslots - 1)
+            if slot in slots:
+                break
+            slots[slot] = i
+        else:
+            return nslots, seed, slots
+    sys.exit('no perfect hash found for %d names' % len(names))
+
+
+def collect(root, prefix, plain):
+    assets = []
+    dirs = set([prefix])
+    for base, subdirs, files in os.walk(root):
+        subdirs.sort()
+        rel = os.path.relpath(base, root)
+        for f in sorted(files):
+            path = os.path.join(base, f)
+            name = prefix + os.path.normpath(os.path.join(rel, f)).replace(os.sep, '/')
+            with open(path, 'rb') as fp:
+                data = fp.read()
+            mtime = int(os.environ.get('SOURCE_DATE_EPOCH', os.path.getmtime(path)))
+            gz = None
+            if not f.endswith(SSI_EXT + STORED_EXT):
+                gz = gzip.compress(data, 9, mtime=0)
+                if len(gz) > len(data) * 9 // 10:
+                    gz = None
+            keep = gz is None or f.endswith(SSI_EXT) or f in plain or name in plain
+            assets.append({
+                'name': name,
+                'body': data if keep else None,
+                'gz': gz,
+                'mtime': mtime,
+                'etag': hashlib.sha1(data).hexdigest()[:16],
+            })
+            d = name.rsplit('/', 1)[0] + '/'
+            while d not in dirs:
+                dirs.add(d)
+                d = d[:-1].rsplit('/', 1)[0] + '/'
+    for d in sorted(dirs):
+        assets.append({'name': d, 'body': None, 'gz': None, 'mtime': 0, 'etag': ''})
+    return assets
+
+
+def c_bytes(data, terminate):
+    if terminate:
+        data = data + b'\0'
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append('\t' + ' '.join('0x%02x,' % b for b in data[i:i + 16]))
+    return '\n'.join(lines)
+
+
+def emit(assets, name, out):
+    nslots, seed, slots = perfect_hash([a['name'] for a in assets])
+    w = out.write
+    w('/* Generated by shttpd_pack.py, do not edit */\n\n')
+    w('#include "net/shttpd/compat_rtos.h"\n\n')
+    for i, a in enumerate(assets):
+        if a['body'] is not None:
+            # identity bodies are terminated for SSI, size does not count it
+            w('static const char %s_%d[] = {\n%s\n};\n\n' % (name, i, c_bytes(a['body'], True)))
+        if a['gz'] is not None:
+            w('static const char %s_%d_gz[] = {\n%s\n};\n\n' % (name, i, c_bytes(a['gz'], False)))
+    w('static const struct usr_asset %s_list[] = {\n' % name)
+    for i, a in enumerate(assets):
+        body = '%s_%d' % (name, i) if a['body'] is not None else 'NULL'
+        gz = '%s_%d_gz' % (name, i) if a['gz'] is not None else 'NULL'
+        w('\t{"%s", %s, %s, %dUL, %dUL, %dUL, "%s"},\n' % (
+            a['name'], body, gz, len(a['body'] or b''), len(a['gz'] or b''),
+            a['mtime'], a['etag']))
+    w('};\n\n')
+    w('static const unsigned short %s_slots[%d] = {\n' % (name, nslots))
+    for i in range(0, nslots, 16):
+        w('\t' + ' '.join('%d,' % (slots[s] + 1 if s in slots else 0)
+                         for s in range(i, min(i + 16, nslots))) + '\n')
+    w('};\n\n')
+    w('const struct usr_asset_table %s = {\n' % name)
+    w('\t%s_list,\n\t%s_slots,\n\t%d,\n\t%dUL\n};\n' % (name, name, nslots, seed))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    ap.add_argument('root', help='directory of the web assets')
+    ap.add_argument('-o', '--output', help='C file to write, stdout by default')
+    ap.add_argument('-n', '--name', default='shttpd_assets', help='name of the table')
+    ap.add_argument('--prefix', default='./', help='prefix of the names, the root option')
+    ap.add_argument('--plain', action='append', default=[],
+                    help='file that keeps its identity body too, may repeat')
+    args = ap.parse_args()
+
+    assets = collect(args.root, args.prefix, set(args.plain))
+    if args.output:
+        with open(args.output, 'w') as out:
+            emit(assets, args.name, out)
+    else:
+        emit(assets, args.name, sys.stdout)
+    raw = sum(len(a['body'] or b'') for a in assets)
+    gz = sum(len(a['gz'] or b'') for a in assets)
+    sys.stderr.write('%d entries, %d identity bytes, %d gzip bytes\n' % (len(assets), raw, gz))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,16 @@
+#!/bin/sh
+#
+# Build wlan.c against the real wlan headers and the host stand-ins of
+# project/common/framework/bench/port/, shared with the fast connect bench,
+# and run the station configuration checks and counts.
+#
+set -e
+cd "$(dirname "$0")"
+PORT=../../../../project/common/framework/bench/port
+gcc -O2 -Wall -Wno-int-to-pointer-cast -pthread \
+	-D__CONFIG_OS_FREERTOS -D__CONFIG_CHIP_XR871 -D__CONFIG_ARCH_DUAL_CORE -D__CONFIG_ARCH_APP_CORE \
+	-I$PORT -I.. -I../../../../include -I../../../../include/kernel/FreeRTOS \
+	-I../../../../include/kernel/FreeRTOS/portable/GCC/ARM_CM4F -I../../../../include/net/lwip-2.0.3 \
+	sta_config_bench.c ../wlan.c -o /tmp/sta_config_bench
+/tmp/sta_config_bench
+echo "PASS"
@@ -0,0 +1,291 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Linux benchmark of the station configuration path of wlan.c. wlan.c is
+ * built against the real wlan headers, and wpa_ctrl_request() stands in for
+ * the net core: it keeps the fields of the one supplicant network block and
+ * counts the round trips, each costing SIM_RTT_US on the target.
+ *
+ *   ./run.sh
+ *
+ * Checks that after every wlan_sta_set() the network block holds exactly
+ * the requested network, whatever the cache skipped, through passphrase
+ * changes, open/PSK switches, a failed field, wlan_sta_set_config(), WPS
+ * and a wlan restart. Then two threads configure different networks and the
+ * net core checks that no batch is interleaved with the other.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kernel/os/os.h"
+#include "net/wlan/wlan.h"
+#include "net/wlan/wlan_defs.h"
+#include "wpa_ctrl_req.h"
+
+#define SIM_RTT_US		300		/* one STA_SET round trip over ducc */
+#define SIM_LOOPS		2000
+
+static int sim_errors;
+
+#define SIM_CHECK(cond, fmt, arg...)                                    \
+	do {                                                            \
+		if (!(cond)) {                                          \
+			printf("FAIL %s:%d: " fmt "\n", __func__,       \
+			       __LINE__, ##arg);                        \
+			sim_errors++;                                   \
+		}                                                       \
+	} while (0)
+
+/* the network block of the supplicant on the net core */
+struct sim_block {
+	wlan_ssid_t ssid;
+	uint8_t psk[65];
+	int val[WLAN_STA_FIELD_NUM];	/* int fields */
+};
+
+static struct sim_block sim_net;
+static pthread_mutex_t sim_net_lock = PTHREAD_MUTEX_INITIALIZER;
+static int sim_requests;
+static int sim_fail_field = -1;		/* next STA_SET of this field fails */
+
+/* concurrency check: whose batch the block holds */
+static __thread int sim_tid;
+static int sim_last_tid;
+static int sim_interleaved;
+static int (*sim_block_ok)(void);
+
+size_t strlcpy(char *dst, const char *src, size_t size)
+{
+	size_t len = strlen(src);
+
+	if (size) {
+		size_t n = len < size - 1 ? len : size - 1;
+		memcpy(dst, src, n);
+		dst[n] = '\0';
+	}
+	return len;
+}
+
+OS_Status OS_MutexCreate(OS_Mutex_t *mutex)
+{
+	pthread_mutex_t *m = malloc(sizeof(*m));
+
+	pthread_mutex_init(m, NULL);
+	mutex->handle = m;
+	return OS_OK;
+}
+
+OS_Status OS_MutexDelete(OS_Mutex_t *mutex)
+{
+	pthread_mutex_destroy(mutex->handle);
+	free(mutex->handle);
+	mutex->handle = OS_INVALID_HANDLE;
+	return OS_OK;
+}
+
+OS_Status OS_MutexLock(OS_Mutex_t *mutex, OS_Time_t waitMS)
+{
+	return pthread_mutex_lock(mutex->handle) ? OS_FAIL : OS_OK;
+}
+
+OS_Status OS_MutexUnlock(OS_Mutex_t *mutex)
+{
+	return pthread_mutex_unlock(mutex->handle) ? OS_FAIL : OS_OK;
+}
+
+/* what the supplicant keeps of a STA_SET, a WPS run and a restart */
+int wpa_ctrl_request(wpa_ctrl_cmd_t cmd, void *data)
+{
+	wlan_sta_config_t *config = data;
+	int ret = 0;
+
+	pthread_mutex_lock(&sim_net_lock);
+	sim_requests++;
+	if (sim_block_ok && sim_tid != sim_last_tid) {
+		/* another caller takes over, the last one must have finished */
+		if (sim_last_tid && !sim_block_ok())
+			sim_interleaved++;
+		sim_last_tid = sim_tid;
+	}
+
+	switch (cmd) {
+	case WPA_CTRL_CMD_STA_SET:
+		/* a request may time out after the net core applied it */
+		if ((int)config->field == sim_fail_field) {
+			sim_fail_field = -1;
+			ret = -1;
+		}
+		if (config->field == WLAN_STA_FIELD_SSID) {
+			sim_net.ssid = config->u.ssid;
+		} else if (config->field == WLAN_STA_FIELD_PSK) {
+			memcpy(sim_net.psk, config->u.psk, sizeof(sim_net.psk));
+		} else {
+			sim_net.val[config->field] = config->u.key_mgmt;
+		}
+		break;
+	case WPA_CTRL_CMD_STA_WPS_PBC:
+		/* the registrar hands out another network */
+		memset(&sim_net, 0, sizeof(sim_net));
+		strcpy((char *)sim_net.ssid.ssid, "wps");
+		sim_net.ssid.ssid_len = 3;
+		sim_net.val[WLAN_STA_FIELD_KEY_MGMT] = WPA_KEY_MGMT_PSK;
+		sim_net.val[WLAN_STA_FIELD_PROTO] = WPA_PROTO_RSN;
+		sim_net.val[WLAN_STA_FIELD_PAIRWISE_CIPHER] = WPA_CIPHER_CCMP;
+		break;
+	default:
+		break;
+	}
+	pthread_mutex_unlock(&sim_net_lock);
+
+	sched_yield();
+	return ret;
+}
+
+/* what wlan_start() does to the station, the supplicant starts again */
+static void sim_restart(void)
+{
+	memset(&sim_net, 0, sizeof(sim_net));
+	wlan_sta_cache_clear();
+}
+
+/* the block holds exactly the network wlan_sta_set() describes */
+static int sim_block_is(const char *ssid, const char *psk)
+{
+	int open = psk[0] == '\0';
+
+	if (sim_net.ssid.ssid_len != strlen(ssid) ||
+	    memcmp(sim_net.ssid.ssid, ssid, sim_net.ssid.ssid_len) != 0 ||
+	    strcmp((char *)sim_net.psk, psk) != 0)
+		return 0;
+	if (sim_net.val[WLAN_STA_FIELD_KEY_MGMT] !=
+	    (open ? WPA_KEY_MGMT_NONE : WPA_KEY_MGMT_PSK))
+		return 0;
+	if (!open && (sim_net.val[WLAN_STA_FIELD_PROTO] != (WPA_PROTO_WPA | WPA_PROTO_RSN) ||
+	              sim_net.val[WLAN_STA_FIELD_PAIRWISE_CIPHER] != (WPA_CIPHER_CCMP | WPA_CIPHER_TKIP) ||
+	              sim_net.val[WLAN_STA_FIELD_GROUP_CIPHER] != (WPA_CIPHER_CCMP | WPA_CIPHER_TKIP |
+	                                                          WPA_CIPHER_WEP40 | WPA_CIPHER_WEP104)))
+		return 0;
+	return sim_net.val[WLAN_STA_FIELD_AUTH_ALG] == WPA_AUTH_ALG_OPEN &&
+	       sim_net.val[WLAN_STA_FIELD_SCAN_SSID] == 1;
+}
+
+static void sim_set(const char *name, const char *ssid, const char *psk, int expect)
+{
+	int ret;
+
+	sim_requests = 0;
+	ret = wlan_sta_set((uint8_t *)ssid, strlen(ssid), (uint8_t *)psk);
+	printf("%-26s %2d requests %6.1f ms\n", name, sim_requests,
+	       sim_requests * SIM_RTT_US / 1000.0);
+	SIM_CHECK(ret == 0, "%s: wlan_sta_set() %d", name, ret);
+	SIM_CHECK(sim_requests == expect, "%s: %d requests, expected %d", name, sim_requests, expect);
+	SIM_CHECK(sim_block_is(ssid, psk), "%s: network block differs from %s/%s", name, ssid, psk);
+}
+
+static int sim_block_ab(void)
+{
+	return sim_block_is("alpha", "alpha passphrase") || sim_block_is("beta", "");
+}
+
+static void *sim_thread(void *arg)
+{
+	int i;
+
+	sim_tid = (int)(intptr_t)arg;
+	for (i = 0; i < SIM_LOOPS; ++i) {
+		if (sim_tid == 1)
+			wlan_sta_set((uint8_t *)"alpha", 5, (uint8_t *)"alpha passphrase");
+		else
+			wlan_sta_set((uint8_t *)"beta", 4, NULL);
+	}
+	return NULL;
+}
+
+int main(void)
+{
+	wlan_sta_config_t config;
+	pthread_t t[2];
+	int ret, i;
+
+	printf("STA_SET round trip %u us\n\n", SIM_RTT_US);
+	ret = wlan_sta_set((uint8_t *)"home", 4, (uint8_t *)"home passphrase");
+	SIM_CHECK(ret == -1, "set before wlan_start() %d", ret);
+
+	sim_restart();
+	sim_set("first PSK network", "home", "home passphrase", 8);
+	sim_set("same network again", "home", "home passphrase", 2);
+	sim_set("new passphrase", "home", "other passphrase", 2);
+	sim_set("other PSK network", "office", "office passphrase", 2);
+	sim_set("switch to open", "cafe", "", 3);
+	sim_set("open again", "cafe", "", 2);
+	sim_set("switch back to PSK", "home", "home passphrase", 3);
+
+	/* a failed field is unknown, it must be sent again even if unchanged */
+	sim_fail_field = WLAN_STA_FIELD_KEY_MGMT;
+	ret = wlan_sta_set((uint8_t *)"cafe", 4, NULL);
+	SIM_CHECK(ret == -1, "failed key_mgmt: wlan_sta_set() %d", ret);
+	sim_set("after failed key_mgmt", "home", "home passphrase", 3);
+	sim_set("switch to open", "cafe", "", 3);
+
+	/* a field set on its own keeps the cache in step */
+	memset(&config, 0, sizeof(config));
+	config.field = WLAN_STA_FIELD_SCAN_SSID;
+	config.u.scan_ssid = 0;
+	wlan_sta_set_config(&config);
+	sim_set("after set_config", "cafe", "", 3);
+
+	wlan_sta_wps_pbc();
+	sim_set("after WPS", "home", "home passphrase", 8);
+
+	sim_restart();
+	sim_set("after wlan restart", "home", "home passphrase", 8);
+
+	/* two callers, every batch must land whole */
+	sim_block_ok = sim_block_ab;
+	sim_last_tid = 0;
+	for (i = 0; i < 2; ++i)
+		pthread_create(&t[i], NULL, sim_thread, (void *)(intptr_t)(i + 1));
+	for (i = 0; i < 2; ++i)
+		pthread_join(t[i], NULL);
+	sim_block_ok = NULL;
+	printf("\n2 threads x %d sets, %d interleaved batches\n", SIM_LOOPS, sim_interleaved);
+	SIM_CHECK(sim_interleaved == 0, "%d batches interleaved", sim_interleaved);
+	SIM_CHECK(sim_block_ab(), "network block mixed after the threads");
+
+	if (sim_errors) {
+		printf("%d errors\n", sim_errors);
+		return 1;
+	}
+	return 0;
+}
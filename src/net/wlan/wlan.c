@@ -54,6 +54,91 @@
 #define WLAN_ASSERT_POINTER(p)	do { } while (0)
 #endif
 
+/*
+ * Every station field is set by its own synchronous request to the net core.
+ * The supplicant keeps the network block between requests until wlan_stop(),
+ * so the plain integer fields already applied are cached here and a batch
+ * skips the unchanged ones. SSID, PSK and WEP keys are always sent, since
+ * the supplicant derives the PMK again when they are set.
+ */
+#define WLAN_STA_CACHE_FIELD(f)	((f) >= WLAN_STA_FIELD_WEP_KEY_INDEX && \
+				 (f) < WLAN_STA_FIELD_NUM)
+
+static OS_Mutex_t m_wlan_sta_cfg_mutex;
+static uint32_t m_wlan_sta_cfg_valid;	/* bitmap of cached fields */
+static int m_wlan_sta_cfg_val[WLAN_STA_FIELD_NUM];
+
+static void wlan_sta_cache_update(wlan_sta_config_t *config, int ok)
+{
+	if (!WLAN_STA_CACHE_FIELD(config->field))
+		return;
+
+	/* all cached fields are an int at the head of the union */
+	if (ok) {
+		m_wlan_sta_cfg_val[config->field] = config->u.key_mgmt;
+		m_wlan_sta_cfg_valid |= (1 << config->field);
+	} else {
+		m_wlan_sta_cfg_valid &= ~(1 << config->field);
+	}
+}
+
+static int wlan_sta_cache_hit(wlan_sta_config_t *config)
+{
+	return (WLAN_STA_CACHE_FIELD(config->field) &&
+	        (m_wlan_sta_cfg_valid & (1 << config->field)) &&
+	        m_wlan_sta_cfg_val[config->field] == config->u.key_mgmt);
+}
+
+/* called by wlan_start()/wlan_stop(), the supplicant starts from scratch */
+void wlan_sta_cache_clear(void)
+{
+	if (!OS_MutexIsValid(&m_wlan_sta_cfg_mutex))
+		OS_MutexCreate(&m_wlan_sta_cfg_mutex);
+
+	OS_MutexLock(&m_wlan_sta_cfg_mutex, OS_WAIT_FOREVER);
+	m_wlan_sta_cfg_valid = 0;
+	OS_MutexUnlock(&m_wlan_sta_cfg_mutex);
+}
+
+/**
+ * @brief Set several station fields as one configuration
+ * @param[in] config Array of field configurations, applied in order
+ * @param[in] num Number of elements in the array
+ * @return 0 on success, -1 on failure
+ *
+ * @note The fields are applied under one lock, no other configuration of
+ *       station is interleaved. Fields equal to the values applied before are
+ *       skipped, so reconfiguring the same kind of network costs only the
+ *       requests for its SSID and PSK.
+ */
+int wlan_sta_set_config_batch(wlan_sta_config_t *config, int num)
+{
+	int i;
+	int ret = 0;
+
+	WLAN_ASSERT_POINTER(config);
+
+	if (!OS_MutexIsValid(&m_wlan_sta_cfg_mutex)) {
+		WLAN_ERR("wlan not started\n");
+		return -1;
+	}
+
+	OS_MutexLock(&m_wlan_sta_cfg_mutex, OS_WAIT_FOREVER);
+	for (i = 0; i < num; ++i) {
+		if (wlan_sta_cache_hit(&config[i]))
+			continue;
+		ret = wpa_ctrl_request(WPA_CTRL_CMD_STA_SET, &config[i]);
+		wlan_sta_cache_update(&config[i], ret == 0);
+		if (ret != 0) {
+			WLAN_ERR("set field %d failed\n", config[i].field);
+			break;
+		}
+	}
+	OS_MutexUnlock(&m_wlan_sta_cfg_mutex);
+
+	return ret == 0 ? 0 : -1;
+}
+
 /**
  * @brief Configure station in a convenient way to join a specified network
  * @param[in] ssid Network name, length is [1, 32]
@@ -74,74 +159,55 @@ int wlan_sta_set(uint8_t *ssid, uint8_t ssid_len, uint8_t *psk)
 		return -1;
 	}
 
-	wlan_sta_config_t config;
-	wlan_memset(&config, 0, sizeof(config));
+	wlan_sta_config_t config[8];
+	int num = 0;
+	wlan_memset(config, 0, sizeof(config));
 
 	if ((psk == NULL) || (psk[0] == '\0')) {
 		/* psk */
-		config.field = WLAN_STA_FIELD_PSK;
-		config.u.psk[0] = '\0';
-		if (wpa_ctrl_request(WPA_CTRL_CMD_STA_SET, &config) != 0)
-			return -1;
+		config[num].field = WLAN_STA_FIELD_PSK;
+		config[num++].u.psk[0] = '\0';
 
 		/* key_mgmt: NONE */
-		config.field = WLAN_STA_FIELD_KEY_MGMT;
-		config.u.key_mgmt = WPA_KEY_MGMT_NONE;
-		if (wpa_ctrl_request(WPA_CTRL_CMD_STA_SET, &config) != 0)
-			return -1;
+		config[num].field = WLAN_STA_FIELD_KEY_MGMT;
+		config[num++].u.key_mgmt = WPA_KEY_MGMT_NONE;
 	} else {
 		/* psk */
-		config.field = WLAN_STA_FIELD_PSK;
-		wlan_strlcpy((char *)config.u.psk, (char *)psk, sizeof(config.u.psk));
-		if (wpa_ctrl_request(WPA_CTRL_CMD_STA_SET, &config) != 0)
-			return -1;
+		config[num].field = WLAN_STA_FIELD_PSK;
+		wlan_strlcpy((char *)config[num++].u.psk, (char *)psk, sizeof(config[0].u.psk));
 
 		/* key_mgmt: PSK */
-		config.field = WLAN_STA_FIELD_KEY_MGMT;
-		config.u.key_mgmt = WPA_KEY_MGMT_PSK;
-		if (wpa_ctrl_request(WPA_CTRL_CMD_STA_SET, &config) != 0)
-			return -1;
+		config[num].field = WLAN_STA_FIELD_KEY_MGMT;
+		config[num++].u.key_mgmt = WPA_KEY_MGMT_PSK;
 
 		/* proto: WPA | RSN */
-		config.field = WLAN_STA_FIELD_PROTO;
-		config.u.proto = WPA_PROTO_WPA | WPA_PROTO_RSN;
-		if (wpa_ctrl_request(WPA_CTRL_CMD_STA_SET, &config) != 0)
-			return -1;
+		config[num].field = WLAN_STA_FIELD_PROTO;
+		config[num++].u.proto = WPA_PROTO_WPA | WPA_PROTO_RSN;
 
 		/* pairwise: CCMP | TKIP */
-		config.field = WLAN_STA_FIELD_PAIRWISE_CIPHER;
-		config.u.pairwise_cipher = WPA_CIPHER_CCMP | WPA_CIPHER_TKIP;
-		if (wpa_ctrl_request(WPA_CTRL_CMD_STA_SET, &config) != 0)
-			return -1;
+		config[num].field = WLAN_STA_FIELD_PAIRWISE_CIPHER;
+		config[num++].u.pairwise_cipher = WPA_CIPHER_CCMP | WPA_CIPHER_TKIP;
 
 		/* group: CCMP | TKIP | WEP40 | WEP104 */
-		config.field = WLAN_STA_FIELD_GROUP_CIPHER;
-		config.u.pairwise_cipher = WPA_CIPHER_CCMP | WPA_CIPHER_TKIP
-					   | WPA_CIPHER_WEP40 | WPA_CIPHER_WEP104;
-		if (wpa_ctrl_request(WPA_CTRL_CMD_STA_SET, &config) != 0)
-			return -1;
+		config[num].field = WLAN_STA_FIELD_GROUP_CIPHER;
+		config[num++].u.group_cipher = WPA_CIPHER_CCMP | WPA_CIPHER_TKIP
+					       | WPA_CIPHER_WEP40 | WPA_CIPHER_WEP104;
 	}
 
 	/* ssid */
-	config.field = WLAN_STA_FIELD_SSID;
-	wlan_memcpy(config.u.ssid.ssid, ssid, ssid_len);
-	config.u.ssid.ssid_len = ssid_len;
-	if (wpa_ctrl_request(WPA_CTRL_CMD_STA_SET, &config) != 0)
-		return -1;
+	config[num].field = WLAN_STA_FIELD_SSID;
+	wlan_memcpy(config[num].u.ssid.ssid, ssid, ssid_len);
+	config[num++].u.ssid.ssid_len = ssid_len;
 
 	/* auth_alg: OPEN */
-	config.field = WLAN_STA_FIELD_AUTH_ALG;
-	config.u.auth_alg = WPA_AUTH_ALG_OPEN;
-	if (wpa_ctrl_request(WPA_CTRL_CMD_STA_SET, &config) != 0)
-		return -1;
+	config[num].field = WLAN_STA_FIELD_AUTH_ALG;
+	config[num++].u.auth_alg = WPA_AUTH_ALG_OPEN;
 
 	/* scan_ssid: 1 */
-	config.field = WLAN_STA_FIELD_SCAN_SSID;
-	config.u.scan_ssid = 1;
-	if (wpa_ctrl_request(WPA_CTRL_CMD_STA_SET, &config) != 0)
-		return -1;
+	config[num].field = WLAN_STA_FIELD_SCAN_SSID;
+	config[num++].u.scan_ssid = 1;
 
-	return 0;
+	return wlan_sta_set_config_batch(config, num);
 }
 
 /**
@@ -151,9 +217,17 @@ int wlan_sta_set(uint8_t *ssid, uint8_t ssid_len, uint8_t *psk)
  */
 int wlan_sta_set_config(wlan_sta_config_t *config)
 {
+	int ret;
+
 	WLAN_ASSERT_POINTER(config);
 
-	return wpa_ctrl_request(WPA_CTRL_CMD_STA_SET, config);
+	ret = wpa_ctrl_request(WPA_CTRL_CMD_STA_SET, config);
+	if (OS_MutexIsValid(&m_wlan_sta_cfg_mutex)) {
+		OS_MutexLock(&m_wlan_sta_cfg_mutex, OS_WAIT_FOREVER);
+		wlan_sta_cache_update(config, ret == 0);
+		OS_MutexUnlock(&m_wlan_sta_cfg_mutex);
+	}
+	return ret;
 }
 
 /**
@@ -301,6 +375,7 @@ int wlan_sta_gen_psk(wlan_gen_psk_param_t *param)
  */
 int wlan_sta_wps_pbc(void)
 {
+	wlan_sta_cache_clear(); /* WPS rewrites the network */
 	return wpa_ctrl_request(WPA_CTRL_CMD_STA_WPS_PBC, NULL);
 }
 
@@ -327,6 +402,7 @@ int wlan_sta_wps_pin_set(wlan_sta_wps_pin_t *wps)
 {
 	WLAN_ASSERT_POINTER(wps);
 
+	wlan_sta_cache_clear(); /* WPS rewrites the network */
 	return wpa_ctrl_request(WPA_CTRL_CMD_STA_WPS_SET_PIN, wps);
 }
 
@@ -69,6 +69,7 @@ int wlan_start(struct netif *nif)
 		return -1;
 	}
 
+	wlan_sta_cache_clear();
 	return wpa_ctrl_open();
 }
 
@@ -79,6 +80,7 @@ int wlan_stop(void)
 		return -1;
 	}
 	wpa_ctrl_close();
+	wlan_sta_cache_clear();
 	return 0;
 }
 
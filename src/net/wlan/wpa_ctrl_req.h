@@ -84,6 +84,8 @@ typedef enum wpa_ctrl_cmd {
 
 int wpa_ctrl_request(wpa_ctrl_cmd_t cmd, void *data);
 
+void wlan_sta_cache_clear(void);
+
 #ifdef __cplusplus
 }
 #endif
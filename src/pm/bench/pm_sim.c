@@ -0,0 +1,679 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Linux simulation of the suspend and resume path of pm.c. pm.c and
+ * pm_prof.c are built against the stand-ins of port/: a list of simulated
+ * devices is registered, pm_enter_mode() walks it, and the sleep
+ * instructions move a virtual clock forward by the residency the scenario
+ * asks for and report its wakeup source. Device callbacks really sleep,
+ * the resume workers are POSIX threads.
+ *
+ *   pm_sim
+ *
+ * Checks that devices of a resume stage are resumed after the lower stages
+ * and, with workers, in parallel, and that the list order survives the
+ * cycles. With __CONFIG_PM_PROFILE it also checks the callback timings,
+ * the residency histograms, the wakeup source and irq attribution, the
+ * aborted suspends and the wakeup latencies against the scenario, then
+ * prints the report of pm_stats_show().
+ */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "kernel/os/os_thread.h"
+#include "driver/chip/chip.h"
+#include "pm/pm.h"
+
+#define SIM_NO_IRQ      (-1)
+#define SIM_SLACK_US    5000    /* allowed overshoot of usleep() and the path */
+
+/* ------------------------------------------------------------------------ */
+/* host stand-ins                                                            */
+
+SIM_NVIC_Type sim_nvic;
+SIM_SCB_Type sim_scb;
+SIM_CCM_Type sim_ccm;
+
+unsigned int nvic_int_mask[] = {
+	NVIC_PERIPH_IRQ_MASK0,
+	NVIC_PERIPH_IRQ_MASK1,
+};
+
+static pthread_mutex_t sim_irq_lock;
+static volatile unsigned long sim_primask;
+static volatile uint64_t sim_offset;    /* virtual us added to the host clock */
+
+/* the wakeup of the next sleep */
+static uint32_t sim_wake_us;
+static uint32_t sim_wake_event;
+static int sim_wake_irq = SIM_NO_IRQ;
+static int sim_setsrc_fail;
+static uint32_t sim_event;
+static int sim_slept;
+
+static int sim_errors;
+
+#define SIM_CHECK(cond, fmt, arg...)                                    \
+	do {                                                            \
+		if (!(cond)) {                                          \
+			printf("FAIL %s:%d: " fmt "\n", __func__,       \
+			       __LINE__, ##arg);                        \
+			sim_errors++;                                   \
+		}                                                       \
+	} while (0)
+
+static uint64_t sim_host_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+uint64_t HAL_RTC_GetFreeRunTime(void)
+{
+	return sim_host_us() + sim_offset;
+}
+
+unsigned long arch_irq_save(void)
+{
+	pthread_mutex_lock(&sim_irq_lock);
+	return 0;
+}
+
+void arch_irq_restore(unsigned long flags)
+{
+	pthread_mutex_unlock(&sim_irq_lock);
+}
+
+unsigned long arch_irq_get_flags(void)
+{
+	return sim_primask;
+}
+
+void __disable_irq(void)
+{
+	sim_primask = 1;
+}
+
+/* pending irqs are taken */
+void __enable_irq(void)
+{
+	sim_primask = 0;
+	sim_nvic.ISPR[0] = 0;
+	sim_nvic.ISPR[1] = 0;
+}
+
+void HAL_NVIC_CPUReset(void)
+{
+	printf("FAIL: reset requested\n");
+	exit(1);
+}
+
+static void sim_set_pending(int irq)
+{
+	if (irq != SIM_NO_IRQ)
+		sim_nvic.ISPR[irq / 32] |= 1U << (irq % 32);
+}
+
+static void sim_sleep(enum suspend_state_t state)
+{
+	SIM_CHECK(sim_primask, "sleep with irqs enabled");
+	sim_offset += sim_wake_us;
+	sim_event = sim_wake_event;
+	sim_set_pending(sim_wake_irq);
+	sim_slept = 1;
+}
+
+void __cpu_sleep(enum suspend_state_t state)
+{
+	SIM_CHECK(state == PM_MODE_SLEEP, "cpu sleep in mode %d", state);
+	sim_sleep(state);
+}
+
+void __cpu_suspend(enum suspend_state_t state)
+{
+	SIM_CHECK(state == PM_MODE_STANDBY, "cpu suspend in mode %d", state);
+	sim_sleep(state);
+}
+
+uint32_t HAL_Wakeup_GetEvent(void)
+{
+	return sim_event;
+}
+
+int32_t HAL_Wakeup_SetSrc(uint32_t en_irq)
+{
+	return sim_setsrc_fail;
+}
+
+void HAL_Wakeup_ClrSrc(uint32_t en_irq) { }
+int32_t HAL_Wakeup_SetIOHold(uint32_t hold_io) { return 0; }
+uint32_t HAL_Wakeup_ReadIO(void) { return 0; }
+uint32_t HAL_Wakeup_ReadTimerPending(void) { return 0; }
+uint32_t HAL_Wakeup_CheckIOMode(void) { return 1; }
+void HAL_Wakeup_Init(void) { }
+
+int platform_prepare(enum suspend_state_t state) { return 0; }
+void platform_wake(enum suspend_state_t state) { }
+
+struct sim_thread_start {
+	OS_ThreadEntry_t entry;
+	void *arg;
+};
+
+static void *sim_thread_main(void *p)
+{
+	struct sim_thread_start start = *(struct sim_thread_start *)p;
+
+	free(p);
+	start.entry(start.arg);
+	return NULL;
+}
+
+OS_Status OS_ThreadCreate(OS_Thread_t *thread, const char *name,
+                          OS_ThreadEntry_t entry, void *arg,
+                          int priority, uint32_t stackSize)
+{
+	struct sim_thread_start *start = malloc(sizeof(*start));
+
+	start->entry = entry;
+	start->arg = arg;
+	thread->valid = 1;
+	if (pthread_create(&thread->handle, NULL, sim_thread_main, start)) {
+		thread->valid = 0;
+		free(start);
+		return OS_FAIL;
+	}
+	pthread_detach(thread->handle);
+	return OS_OK;
+}
+
+/* only deleting itself */
+OS_Status OS_ThreadDelete(OS_Thread_t *thread)
+{
+	thread->valid = 0;
+	pthread_exit(NULL);
+	return OS_OK;
+}
+
+static volatile int sim_sched_suspended;
+
+void OS_ThreadSuspendScheduler(void)
+{
+	sim_sched_suspended = 1;
+}
+
+void OS_ThreadResumeScheduler(void)
+{
+	sim_sched_suspended = 0;
+}
+
+OS_Status OS_SemaphoreCreate(OS_Semaphore_t *sem, uint32_t initCount, uint32_t maxCount)
+{
+	return sem_init(&sem->sem, 0, initCount) ? OS_FAIL : OS_OK;
+}
+
+OS_Status OS_SemaphoreDelete(OS_Semaphore_t *sem)
+{
+	sem_destroy(&sem->sem);
+	return OS_OK;
+}
+
+OS_Status OS_SemaphoreWait(OS_Semaphore_t *sem, uint32_t waitMS)
+{
+	return sem_wait(&sem->sem) ? OS_FAIL : OS_OK;
+}
+
+OS_Status OS_SemaphoreRelease(OS_Semaphore_t *sem)
+{
+	return sem_post(&sem->sem) ? OS_FAIL : OS_OK;
+}
+
+/* ------------------------------------------------------------------------ */
+/* simulated devices                                                         */
+
+struct sim_dev {
+	struct soc_device dev;
+	struct soc_device_driver drv;
+	uint32_t us[PM_DEV_OP_NUM];     /* time taken by each callback */
+	int noirq_irq;                  /* raised by the next suspend_noirq */
+
+	uint32_t calls[PM_DEV_OP_NUM];
+	uint32_t suspend_seq;           /* position in the last suspend */
+	uint64_t resume_start;
+	uint64_t resume_end;
+	pthread_t resume_thread;
+};
+
+#define SIM_DEV(n, s, r, sn, rn, stage) \
+	{ .dev = { .name = n, .resume_stage = stage }, .us = { s, sn, rn, r }, \
+	  .noirq_irq = SIM_NO_IRQ }
+
+static struct sim_dev sim_devs[] = {
+	SIM_DEV("clk",     1000,  1500,  300,  300, 0),
+	SIM_DEV("uart",    2000,  3000,    0,    0, 0),
+	SIM_DEV("sensor0", 1000, 20000,    0,    0, 1),
+	SIM_DEV("sensor1", 1000, 20000,    0,    0, 1),
+	SIM_DEV("sensor2", 1000, 20000,    0,    0, 1),
+	SIM_DEV("codec",   1000,  6000,    0,    0, 2),
+	SIM_DEV("spi",      500,  2500,    0,    0, 0),
+	SIM_DEV("gpio",       0,     0,  400,  400, 0),
+};
+
+#define SIM_DEV_NUM     (sizeof(sim_devs) / sizeof(sim_devs[0]))
+
+static uint32_t sim_suspend_seq;
+
+static struct sim_dev *sim_dev_of(struct soc_device *dev)
+{
+	return (struct sim_dev *)dev;
+}
+
+static int sim_callback(struct soc_device *dev, enum pm_dev_op_t op)
+{
+	struct sim_dev *d = sim_dev_of(dev);
+	uint64_t start = HAL_RTC_GetFreeRunTime();
+
+	if (op == PM_DEV_SUSPEND_NOIRQ || op == PM_DEV_RESUME_NOIRQ)
+		SIM_CHECK(sim_primask, "%s noirq callback with irqs enabled", dev->name);
+	if (op == PM_DEV_RESUME && dev->resume_stage)
+		SIM_CHECK(!sim_sched_suspended, "%s resumed with the scheduler suspended",
+		          dev->name);
+
+	usleep(d->us[op]);
+	d->calls[op]++;
+	if (op == PM_DEV_SUSPEND)
+		d->suspend_seq = sim_suspend_seq++;
+	if (op == PM_DEV_SUSPEND_NOIRQ && d->noirq_irq != SIM_NO_IRQ) {
+		sim_set_pending(d->noirq_irq);
+		d->noirq_irq = SIM_NO_IRQ;
+	}
+	if (op == PM_DEV_RESUME) {
+		d->resume_start = start;
+		d->resume_end = HAL_RTC_GetFreeRunTime();
+		d->resume_thread = pthread_self();
+	}
+	return 0;
+}
+
+static int sim_suspend(struct soc_device *dev, enum suspend_state_t state)
+{
+	return sim_callback(dev, PM_DEV_SUSPEND);
+}
+
+static int sim_resume(struct soc_device *dev, enum suspend_state_t state)
+{
+	return sim_callback(dev, PM_DEV_RESUME);
+}
+
+static int sim_suspend_noirq(struct soc_device *dev, enum suspend_state_t state)
+{
+	return sim_callback(dev, PM_DEV_SUSPEND_NOIRQ);
+}
+
+static int sim_resume_noirq(struct soc_device *dev, enum suspend_state_t state)
+{
+	return sim_callback(dev, PM_DEV_RESUME_NOIRQ);
+}
+
+static void sim_register(void)
+{
+	struct sim_dev *d;
+	unsigned int i;
+
+	for (i = 0; i < SIM_DEV_NUM; i++) {
+		d = &sim_devs[i];
+		d->drv.name = d->dev.name;
+		if (d->us[PM_DEV_SUSPEND] || d->us[PM_DEV_RESUME]) {
+			d->drv.suspend = sim_suspend;
+			d->drv.resume = sim_resume;
+		}
+		if (d->us[PM_DEV_SUSPEND_NOIRQ] || d->us[PM_DEV_RESUME_NOIRQ]) {
+			d->drv.suspend_noirq = sim_suspend_noirq;
+			d->drv.resume_noirq = sim_resume_noirq;
+		}
+		d->dev.driver = &d->drv;
+		SIM_CHECK(pm_register_ops(&d->dev) == 0, "register %s", d->dev.name);
+	}
+}
+
+/* ------------------------------------------------------------------------ */
+/* scenario                                                                  */
+
+enum sim_abort {
+	SIM_SLEEP = 0,
+	SIM_ABORT_IRQ,          /* an irq gets pending during suspend noirq */
+	SIM_ABORT_SETSRC,       /* HAL_Wakeup_SetSrc() fails */
+};
+
+struct sim_cycle {
+	enum suspend_state_t mode;
+	unsigned int workers;
+	enum sim_abort abort;
+	uint32_t sleep_us;
+	uint32_t event;         /* reported by HAL_Wakeup_GetEvent() */
+	int irq;                /* pending at wakeup or raised for the abort */
+	uint32_t awake_us;      /* virtual time awake before the next cycle */
+};
+
+static const struct sim_cycle sim_cycles[] = {
+	{ PM_MODE_SLEEP,   3, SIM_SLEEP,        500,      PM_WAKEUP_SRC_WKSEV,   SIM_NO_IRQ,     2000 },
+	{ PM_MODE_SLEEP,   3, SIM_SLEEP,        3000,     PM_WAKEUP_SRC_WKSEV,   35,           300000 },
+	{ PM_MODE_STANDBY, 3, SIM_SLEEP,        1500000,  PM_WAKEUP_SRC_WKTIMER, SIM_NO_IRQ, 10000000 },
+	{ PM_MODE_STANDBY, 3, SIM_SLEEP,        40000000, PM_WAKEUP_SRC_WKIO3,   SIM_NO_IRQ,  7000000 },
+	{ PM_MODE_STANDBY, 3, SIM_ABORT_IRQ,    0,        0,                     33,            50000 },
+	{ PM_MODE_SLEEP,   3, SIM_ABORT_SETSRC, 0,        0,                     SIM_NO_IRQ,    50000 },
+	{ PM_MODE_STANDBY, 0, SIM_SLEEP,        200000,   PM_WAKEUP_SRC_WKTIMER, SIM_NO_IRQ,  4000000 },
+	{ PM_MODE_STANDBY, 2, SIM_SLEEP,        200000,   PM_WAKEUP_SRC_WKTIMER | PM_WAKEUP_SRC_WKIO1, SIM_NO_IRQ, 0 },
+};
+
+#define SIM_CYCLE_NUM   (sizeof(sim_cycles) / sizeof(sim_cycles[0]))
+
+static const char *sim_dev_name(unsigned int i)
+{
+	return sim_devs[i].dev.name;
+}
+
+/* stages follow each other, devices of a stage overlap with workers */
+static void sim_check_resume_order(const struct sim_cycle *c)
+{
+	struct sim_dev *a, *b;
+	unsigned int i, j, threads;
+	int overlap;
+
+	for (i = 0; i < SIM_DEV_NUM; i++) {
+		a = &sim_devs[i];
+		if (!a->drv.resume)
+			continue;
+		for (j = 0; j < SIM_DEV_NUM; j++) {
+			b = &sim_devs[j];
+			if (!b->drv.resume || a->dev.resume_stage >= b->dev.resume_stage)
+				continue;
+			SIM_CHECK(a->resume_end <= b->resume_start,
+			          "%s (stage %u) not resumed before %s (stage %u)",
+			          sim_dev_name(i), a->dev.resume_stage,
+			          sim_dev_name(j), b->dev.resume_stage);
+		}
+		/* stage 0 in the reverse order of suspend */
+		for (j = 0; j < SIM_DEV_NUM; j++) {
+			b = &sim_devs[j];
+			if (!b->drv.resume || a->dev.resume_stage || b->dev.resume_stage ||
+			    a->suspend_seq <= b->suspend_seq)
+				continue;
+			SIM_CHECK(a->resume_end <= b->resume_start,
+			          "%s not resumed before %s", sim_dev_name(i), sim_dev_name(j));
+		}
+	}
+
+	/* sensor0 ~ sensor2 are stage 1 */
+	overlap = 1;
+	threads = 1;
+	for (i = 2; i < 5; i++) {
+		for (j = 2; j < 5; j++) {
+			if (i == j)
+				continue;
+			if (sim_devs[i].resume_start >= sim_devs[j].resume_end)
+				overlap = 0;
+		}
+		if (i > 2 && !pthread_equal(sim_devs[i].resume_thread,
+		                            sim_devs[2].resume_thread))
+			threads++;
+	}
+	if (c->workers >= 2) {
+		SIM_CHECK(overlap, "stage 1 not resumed in parallel with %u workers",
+		          c->workers);
+		SIM_CHECK(threads > 1, "stage 1 resumed by one thread with %u workers",
+		          c->workers);
+	} else if (c->workers == 0) {
+		SIM_CHECK(!overlap, "stage 1 resumed in parallel without workers");
+		SIM_CHECK(sim_devs[2].resume_end <= sim_devs[3].resume_start &&
+		          sim_devs[3].resume_end <= sim_devs[4].resume_start,
+		          "stage 1 not in resume order without workers");
+	}
+}
+
+static void sim_run_cycle(unsigned int n, uint32_t order[SIM_DEV_NUM])
+{
+	const struct sim_cycle *c = &sim_cycles[n];
+	unsigned int i;
+
+	SIM_CHECK(pm_set_resume_workers(c->workers) == 0, "set %u workers", c->workers);
+
+	sim_wake_us = c->sleep_us;
+	sim_wake_event = c->event;
+	sim_wake_irq = (c->abort == SIM_SLEEP) ? c->irq : SIM_NO_IRQ;
+	sim_setsrc_fail = (c->abort == SIM_ABORT_SETSRC);
+	if (c->abort == SIM_ABORT_IRQ)
+		sim_devs[7].noirq_irq = c->irq;
+	sim_slept = 0;
+	sim_suspend_seq = 0;
+
+	pm_enter_mode(c->mode);
+
+	SIM_CHECK(sim_slept == (c->abort == SIM_SLEEP), "cycle %u slept %d", n, sim_slept);
+	SIM_CHECK(!sim_primask, "cycle %u left irqs disabled", n);
+	for (i = 0; i < SIM_DEV_NUM; i++) {
+		if (sim_devs[i].drv.suspend)
+			order[i] = sim_devs[i].suspend_seq;
+	}
+	sim_check_resume_order(c);
+
+	sim_offset += c->awake_us;
+}
+
+#ifdef __CONFIG_PM_PROFILE
+static int sim_hist_idx(uint64_t us)
+{
+	/* the boundaries of the scenario, see PM_RESIDENCY_HIST_NUM */
+	if (us < 1000)
+		return 0;
+	if (us < 4000)
+		return 2;
+	if (us < 256000)
+		return 8;
+	if (us < 2048000)
+		return 11;
+	return 15;
+}
+
+static void sim_check_prof(uint32_t serial_resume, uint32_t parallel_resume)
+{
+	struct pm_prof_stats st;
+	struct pm_dev_stats dev[SIM_DEV_NUM + 1];
+	struct pm_residency_stats expect_mode[PM_MODE_MAX];
+	uint64_t expect_sleep[PM_WAKE_SRC_NUM], expect_awake[PM_WAKE_SRC_NUM];
+	uint32_t expect_count[PM_WAKE_SRC_NUM], event;
+	uint32_t sleeps = 0, aborts = 0, min_suspend = 0;
+	const struct sim_cycle *c;
+	struct sim_dev *d;
+	unsigned int i, j, k;
+	int num;
+
+	memset(expect_mode, 0, sizeof(expect_mode));
+	memset(expect_sleep, 0, sizeof(expect_sleep));
+	memset(expect_awake, 0, sizeof(expect_awake));
+	memset(expect_count, 0, sizeof(expect_count));
+	for (i = 0; i < SIM_CYCLE_NUM; i++) {
+		c = &sim_cycles[i];
+		if (c->abort != SIM_SLEEP) {
+			aborts++;
+			continue;
+		}
+		sleeps++;
+		expect_mode[c->mode].count++;
+		expect_mode[c->mode].total += c->sleep_us;
+		expect_mode[c->mode].hist[sim_hist_idx(c->sleep_us)]++;
+		event = (c->irq != SIM_NO_IRQ) ? PM_WAKEUP_SRC_DEVICES : c->event;
+		for (j = 0; j < PM_WAKE_SRC_NUM; j++) {
+			if (!(event & (1 << j)))
+				continue;
+			expect_count[j]++;
+			expect_sleep[j] += c->sleep_us;
+			/* awake until the next cycle, the last one stays open */
+			if (i + 1 < SIM_CYCLE_NUM)
+				expect_awake[j] += c->awake_us;
+		}
+	}
+
+	SIM_CHECK(pm_get_prof_stats(&st) == 0, "get stats");
+	for (i = PM_MODE_SLEEP; i <= PM_MODE_STANDBY; i++) {
+		SIM_CHECK(st.mode[i].count == expect_mode[i].count, "mode %u count %u, expect %u",
+		          i, st.mode[i].count, expect_mode[i].count);
+		SIM_CHECK(st.mode[i].total >= expect_mode[i].total &&
+		          st.mode[i].total < expect_mode[i].total + SIM_SLACK_US,
+		          "mode %u residency %" PRIu64 " us, expect %" PRIu64 " us",
+		          i, st.mode[i].total, expect_mode[i].total);
+		for (j = 0; j < PM_RESIDENCY_HIST_NUM; j++)
+			SIM_CHECK(st.mode[i].hist[j] == expect_mode[i].hist[j],
+			          "mode %u hist[%u] %u, expect %u", i, j,
+			          st.mode[i].hist[j], expect_mode[i].hist[j]);
+	}
+
+	for (j = 0; j < PM_WAKE_SRC_NUM; j++) {
+		SIM_CHECK(st.src[j].count == expect_count[j], "source %u count %u, expect %u",
+		          j, st.src[j].count, expect_count[j]);
+		SIM_CHECK(st.src[j].sleep >= expect_sleep[j] &&
+		          st.src[j].sleep < expect_sleep[j] + SIM_SLACK_US,
+		          "source %u slept %" PRIu64 " us, expect %" PRIu64 " us",
+		          j, st.src[j].sleep, expect_sleep[j]);
+		/* plus the real time of resume and of the next suspend request */
+		SIM_CHECK(st.src[j].awake >= expect_awake[j] &&
+		          st.src[j].awake < expect_awake[j] + 400000,
+		          "source %u awake %" PRIu64 " us, expect %" PRIu64 " us",
+		          j, st.src[j].awake, expect_awake[j]);
+	}
+	for (j = 0; j < PM_WAKE_IRQ_NUM; j++) {
+		SIM_CHECK(st.wake_irq[j] == (j == 35), "irq %u wakeups %u", j, st.wake_irq[j]);
+		SIM_CHECK(st.abort_irq[j] == (j == 33), "irq %u aborts %u", j, st.abort_irq[j]);
+	}
+	SIM_CHECK(st.aborts == aborts, "aborts %u, expect %u", st.aborts, aborts);
+
+	/* the suspend path runs every suspend and noirq suspend callback */
+	for (i = 0; i < SIM_DEV_NUM; i++)
+		min_suspend += sim_devs[i].us[PM_DEV_SUSPEND] + sim_devs[i].us[PM_DEV_SUSPEND_NOIRQ];
+	SIM_CHECK(st.suspend.count == sleeps, "suspend latency count %u", st.suspend.count);
+	SIM_CHECK(st.suspend.max >= min_suspend, "suspend latency max %u us, below %u us",
+	          st.suspend.max, min_suspend);
+	SIM_CHECK(st.first_task.count == sleeps, "first task count %u", st.first_task.count);
+	SIM_CHECK(st.first_task.max >= 700 &&
+	          st.first_task.total / st.first_task.count < 700 + SIM_SLACK_US,
+	          "first task latency avg %u us max %u us, expect about 700 us",
+	          (uint32_t)(st.first_task.total / st.first_task.count), st.first_task.max);
+	SIM_CHECK(st.resume.count == sleeps, "resume count %u", st.resume.count);
+	SIM_CHECK(serial_resume >= 700 + 1500 + 3000 + 2500 + 3 * 20000 + 6000,
+	          "resume latency %u us without workers", serial_resume);
+	SIM_CHECK(parallel_resume + 30000 < serial_resume,
+	          "resume latency %u us with workers, %u us without",
+	          parallel_resume, serial_resume);
+
+	num = pm_get_dev_stats(dev, SIM_DEV_NUM + 1);
+	SIM_CHECK(num == (int)SIM_DEV_NUM, "%d devices profiled", num);
+	for (k = 0; k < (unsigned int)num; k++) {
+		for (i = 0; i < SIM_DEV_NUM && &sim_devs[i].dev != dev[k].dev; i++)
+			;
+		SIM_CHECK(i < SIM_DEV_NUM, "unknown device %p", dev[k].dev);
+		if (i == SIM_DEV_NUM)
+			continue;
+		d = &sim_devs[i];
+		for (j = 0; j < PM_DEV_OP_NUM; j++) {
+			struct pm_time_stats *t = &dev[k].op[j];
+
+			SIM_CHECK(t->count == d->calls[j], "%s op %u count %u, expect %u",
+			          d->dev.name, j, t->count, d->calls[j]);
+			if (!t->count)
+				continue;
+			SIM_CHECK(t->max >= d->us[j] && t->total / t->count < d->us[j] + SIM_SLACK_US,
+			          "%s op %u avg %u us max %u us, expect %u us", d->dev.name, j,
+			          (uint32_t)(t->total / t->count), t->max, d->us[j]);
+		}
+	}
+}
+#endif /* __CONFIG_PM_PROFILE */
+
+int main(void)
+{
+	uint32_t order[SIM_CYCLE_NUM][SIM_DEV_NUM];
+	uint32_t serial_resume = 0, parallel_resume = 0;
+	unsigned int i, j;
+	pthread_mutexattr_t attr;
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&sim_irq_lock, &attr);
+	sim_offset = 1000000;
+
+	sim_register();
+	for (i = 0; i < SIM_CYCLE_NUM; i++) {
+		memset(order[i], 0, sizeof(order[i]));
+		sim_run_cycle(i, order[i]);
+#ifdef __CONFIG_PM_PROFILE
+		if (sim_cycles[i].abort == SIM_SLEEP) {
+			struct pm_prof_stats st;
+
+			pm_get_prof_stats(&st);
+			if (sim_cycles[i].workers == 0)
+				serial_resume = st.resume.last;
+			else if (sim_cycles[i].workers == 3)
+				parallel_resume = st.resume.last;
+		}
+#endif
+	}
+	pm_stop();
+
+	/* an aborted suspend still suspends all normal callbacks in order */
+	for (i = 1; i < SIM_CYCLE_NUM; i++) {
+		for (j = 0; j < SIM_DEV_NUM; j++)
+			SIM_CHECK(order[i][j] == order[0][j], "cycle %u suspended %s at %u, "
+			          "first cycle at %u", i, sim_dev_name(j), order[i][j], order[0][j]);
+	}
+
+#ifdef __CONFIG_PM_PROFILE
+	sim_check_prof(serial_resume, parallel_resume);
+	pm_stats_show();
+#else
+	(void)serial_resume;
+	(void)parallel_resume;
+#endif
+
+	if (sim_errors) {
+		printf("%d errors\n", sim_errors);
+		return 1;
+	}
+	printf("%u cycles, %u devices\n", (unsigned int)SIM_CYCLE_NUM, (unsigned int)SIM_DEV_NUM);
+	return 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * Host stand-in for the chip and HAL headers used by pm.c. Registers are
+ * plain variables, the sleep instructions and the wakeup HAL are functions
+ * of pm_sim.c that advance the virtual part of the clock.
+ */
+
+#ifndef _SIM_CHIP_H_
+#define _SIM_CHIP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "sys/io.h"
+
+#ifndef __containerof
+#define __containerof(ptr, type, field) \
+	((type *)((char *)(ptr) - offsetof(type, field)))
+#endif
+
+#define MAX_IRQn                40
+#define NVIC_PERIPH_IRQ_NUM     MAX_IRQn
+#define NVIC_PERIPH_IRQ_MASK0   (0xffffffff)
+#define NVIC_PERIPH_IRQ_MASK1   ((1 << (MAX_IRQn - 32)) - 1)
+
+typedef struct {
+	volatile uint32_t ISER[2];
+	volatile uint32_t ISPR[2];
+} SIM_NVIC_Type;
+
+typedef struct {
+	volatile uint32_t SCR;
+} SIM_SCB_Type;
+
+typedef struct {
+	volatile uint32_t BUS_PERIPH_RST_CTRL;
+	volatile uint32_t BUS_PERIPH_CLK_CTRL;
+} SIM_CCM_Type;
+
+extern SIM_NVIC_Type sim_nvic;
+extern SIM_SCB_Type sim_scb;
+extern SIM_CCM_Type sim_ccm;
+
+#define NVIC                    (&sim_nvic)
+#define SCB                     (&sim_scb)
+#define CCM                     (&sim_ccm)
+
+#define __NOP()                 do { } while (0)
+#define __ISB()                 do { } while (0)
+#define __DSB()                 do { } while (0)
+#define __DMB()                 do { } while (0)
+#define __WFI()                 do { } while (0)
+#define __WFE()                 do { } while (0)
+#define __disable_fault_irq()   do { } while (0)
+
+extern void __disable_irq(void);
+extern void __enable_irq(void);
+
+/* prcm, ccm and system */
+#define PRCM_CPUA_BOOT_FROM_COLD_RESET  0
+#define PRCM_CPU_CLK_SRC_HFCLK          0
+#define PRCM_SYS_CLK_FACTOR_80M         0
+#define SYSTEM_DEINIT_FLAG_RESET_CLK    0
+
+#define HAL_PRCM_SetCPUABootFlag(f)             ((void)(f))
+#define HAL_PRCM_SetCPUABootArg(a)              ((void)(a))
+#define HAL_PRCM_GetCPUABootArg()               0
+#define HAL_PRCM_SetCPUAPrivateData(d)          ((void)(d))
+#define HAL_PRCM_GetCPUAPrivateData()           0
+#define HAL_PRCM_SetSys1WakeupPowerFlags(f)     ((void)(f))
+#define HAL_PRCM_SetSys1SleepPowerFlags(f)      ((void)(f))
+#define HAL_PRCM_IsSys3Release()                0
+#define HAL_PRCM_SetCPUNClk(src, factor)        do { } while (0)
+#define HAL_PRCM_DisableSysClk2(factor)         do { } while (0)
+#define HAL_PRCM_Start()                        do { } while (0)
+#define HAL_PRCM_IsCPUNReleased()               0
+#define SystemDeInit(flag)                      do { } while (0)
+#define HAL_UDelay(us)                          usleep(us)
+#define timeofday_save()                        do { } while (0)
+
+extern void HAL_NVIC_CPUReset(void);
+
+/* wakeup */
+#define WAKEUP_IO_MAX           10
+
+#define PM_WAKEUP_SRC_WKIO0     BIT(0 )
+#define PM_WAKEUP_SRC_WKIO1     BIT(1 )
+#define PM_WAKEUP_SRC_WKIO2     BIT(2 )
+#define PM_WAKEUP_SRC_WKIO3     BIT(3 )
+#define PM_WAKEUP_SRC_WKIO4     BIT(4 )
+#define PM_WAKEUP_SRC_WKIO5     BIT(5 )
+#define PM_WAKEUP_SRC_WKIO6     BIT(6 )
+#define PM_WAKEUP_SRC_WKIO7     BIT(7 )
+#define PM_WAKEUP_SRC_WKIO8     BIT(8 )
+#define PM_WAKEUP_SRC_WKIO9     BIT(9 )
+#define PM_WAKEUP_SRC_WKTIMER   BIT(10)
+#define PM_WAKEUP_SRC_WKSEV     BIT(11)
+#define PM_WAKEUP_SRC_NETCPU    (PM_WAKEUP_SRC_WKSEV)
+#define PM_WAKEUP_SRC_DEVICES   BIT(12)
+
+extern uint32_t HAL_Wakeup_GetEvent(void);
+extern int32_t HAL_Wakeup_SetSrc(uint32_t en_irq);
+extern void HAL_Wakeup_ClrSrc(uint32_t en_irq);
+extern int32_t HAL_Wakeup_SetIOHold(uint32_t hold_io);
+extern uint32_t HAL_Wakeup_ReadIO(void);
+extern uint32_t HAL_Wakeup_ReadTimerPending(void);
+extern uint32_t HAL_Wakeup_CheckIOMode(void);
+extern void HAL_Wakeup_Init(void);
+
+/* rtc */
+extern uint64_t HAL_RTC_GetFreeRunTime(void);
+
+#endif /* _SIM_CHIP_H_ */
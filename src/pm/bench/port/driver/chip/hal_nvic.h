@@ -0,0 +1 @@
+#include "driver/chip/chip.h"
@@ -0,0 +1,49 @@
+/*
+ * Host stand-in for the kernel/os thread, semaphore and time API used by
+ * pm.c, on POSIX threads and semaphores. See pm_sim.c.
+ */
+
+#ifndef _KERNEL_OS_OS_THREAD_H_
+#define _KERNEL_OS_OS_THREAD_H_
+
+#include <stdint.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <unistd.h>
+
+typedef enum {
+	OS_OK   = 0,
+	OS_FAIL = -1,
+} OS_Status;
+
+#define OS_WAIT_FOREVER         0xffffffffU
+#define OS_THREAD_PRIO_SYS_CTRL 0
+
+typedef void (*OS_ThreadEntry_t)(void *arg);
+
+typedef struct OS_Thread {
+	pthread_t handle;
+	volatile int valid;
+} OS_Thread_t;
+
+typedef struct OS_Semaphore {
+	sem_t sem;
+} OS_Semaphore_t;
+
+OS_Status OS_ThreadCreate(OS_Thread_t *thread, const char *name,
+                          OS_ThreadEntry_t entry, void *arg,
+                          int priority, uint32_t stackSize);
+OS_Status OS_ThreadDelete(OS_Thread_t *thread);
+#define OS_ThreadIsValid(thread)        ((thread)->valid)
+
+void OS_ThreadSuspendScheduler(void);
+void OS_ThreadResumeScheduler(void);
+
+OS_Status OS_SemaphoreCreate(OS_Semaphore_t *sem, uint32_t initCount, uint32_t maxCount);
+OS_Status OS_SemaphoreDelete(OS_Semaphore_t *sem);
+OS_Status OS_SemaphoreWait(OS_Semaphore_t *sem, uint32_t waitMS);
+OS_Status OS_SemaphoreRelease(OS_Semaphore_t *sem);
+
+#define OS_MSleep(msec)                 usleep((msec) * 1000)
+
+#endif /* _KERNEL_OS_OS_THREAD_H_ */
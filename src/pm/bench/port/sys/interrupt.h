@@ -0,0 +1,16 @@
+/*
+ * Host stand-in for sys/interrupt.h. Saving the irq state takes one lock
+ * shared by the threads of pm_sim.c, the PRIMASK of the suspending thread
+ * is a variable set by __disable_irq().
+ */
+
+#ifndef _SYS_INTERRUPT_H_
+#define _SYS_INTERRUPT_H_
+
+#include "compiler.h"
+
+extern unsigned long arch_irq_save(void);
+extern void arch_irq_restore(unsigned long flags);
+extern unsigned long arch_irq_get_flags(void);
+
+#endif /* _SYS_INTERRUPT_H_ */
@@ -0,0 +1,6 @@
+#ifndef _SYS_XR_DEBUG_H_
+#define _SYS_XR_DEBUG_H_
+
+#define print_hex_dump_words(addr, len) do { } while (0)
+
+#endif /* _SYS_XR_DEBUG_H_ */
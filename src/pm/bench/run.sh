@@ -0,0 +1,15 @@
+#!/bin/sh
+#
+# Build pm.c and pm_prof.c against the host stand-ins of port/ with the
+# profiler and without it, and run the simulated devices through suspend
+# and resume cycles.
+#
+set -e
+cd "$(dirname "$0")"
+for profile in "-D__CONFIG_PM_PROFILE" ""; do
+	gcc -O2 -Wall -Wno-int-to-pointer-cast -Wno-pointer-to-int-cast -pthread $profile -D__CONFIG_CHIP_XR871 -D__CONFIG_ARCH_APP_CORE \
+		-Iport -I.. -I../../../include \
+		pm_sim.c ../pm.c ../pm_prof.c -o /tmp/pm_sim
+	/tmp/pm_sim
+done
+echo "PASS"
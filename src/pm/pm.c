@@ -40,6 +40,7 @@
 #include "sys/interrupt.h"
 #include "sys/param.h"
 #include "kernel/os/os_thread.h"
+#include "kernel/os/os_semaphore.h"
 
 #include "driver/chip/system_chip.h"
 #include "driver/chip/chip.h"
@@ -207,13 +208,53 @@ static void pm_power_off(pm_operate_t type)
 #endif
 }
 
+#ifdef __CONFIG_PM_PROFILE
+/* the first pending wakeup irq, or -1 */
+static int pending_wakeup_irq(void)
+{
+	int i, bit;
+	unsigned int val;
+
+	for (i = 0; i < DIV_ROUND_UP(NVIC_PERIPH_IRQ_NUM, 32); i++) {
+		val = NVIC->ISPR[i] & nvic_int_mask[i];
+		for (bit = 0; val; val >>= 1, bit++) {
+			if (val & 1)
+				return i * 32 + bit;
+		}
+	}
+
+	return -1;
+}
+
+/* Wakeups by a peripheral irq leave no wakeup event but SEV, attribute them
+ * to the irq still pending, irqs are disabled until the end of resume noirq.
+ */
+static void pm_prof_wakeup(enum suspend_state_t state)
+{
+	uint32_t event = HAL_Wakeup_GetEvent();
+	int irq = -1;
+
+	if (!(event & (PM_WAKEUP_SRC_WKTIMER | ((1 << WAKEUP_IO_MAX) - 1)))) {
+		irq = pending_wakeup_irq();
+		if (irq >= 0)
+			event = PM_WAKEUP_SRC_DEVICES;
+	}
+	pm_prof_wake(state, event, irq);
+}
+#else
+#define pending_wakeup_irq() (-1)
+#define pm_prof_wakeup(state)
+#endif
+
 static void __suspend_enter(enum suspend_state_t state)
 {
 	__record_dbg_status(PM_SUSPEND_ENTER | 5);
 
 	__record_dbg_status(PM_SUSPEND_ENTER | 6);
-	if (HAL_Wakeup_SetSrc(1))
+	if (HAL_Wakeup_SetSrc(1)) {
+		pm_prof_abort(-1);
 		return ;
+	}
 
 	PM_LOGN("device info. rst:%x clk:%x\n", CCM->BUS_PERIPH_RST_CTRL,
 	        CCM->BUS_PERIPH_CLK_CTRL); /* debug info. */
@@ -237,11 +278,13 @@ static void __suspend_enter(enum suspend_state_t state)
 		pm_power_off(PM_SHUTDOWN); /* never return */
 	} else if (state < PM_MODE_STANDBY) {
 		__record_dbg_status(PM_SUSPEND_ENTER | 8);
+		pm_prof_enter(state);
 		/* TODO: set system bus to low freq */
 		__cpu_sleep(state);
 		/* TODO: restore system bus to normal freq */
 	} else {
 		__record_dbg_status(PM_SUSPEND_ENTER | 9);
+		pm_prof_enter(state);
 		__cpu_suspend(state);
 	}
 
@@ -249,6 +292,7 @@ static void __suspend_enter(enum suspend_state_t state)
 
 	__record_dbg_status(PM_SUSPEND_ENTER | 0xa);
 	HAL_Wakeup_ClrSrc(1);
+	pm_prof_wakeup(state);
 
 	__record_dbg_status(PM_SUSPEND_ENTER | 0xb);
 }
@@ -450,6 +494,7 @@ static int dpm_suspend_noirq(enum suspend_state_t state)
 #ifdef CONFIG_PM_DEBUG
 	ktime_t starttime = ktime_get();
 #endif
+	uint64_t t;
 	int error = 0;
 
 	while (!list_empty(&dpm_late_early_list)) {
@@ -457,7 +502,9 @@ static int dpm_suspend_noirq(enum suspend_state_t state)
 
 		get_device(dev);
 
+		t = PM_PROF_TIME();
 		error = dev->driver->suspend_noirq(dev, state);
+		pm_prof_dev(dev, PM_DEV_SUSPEND_NOIRQ, t);
 		if (initcall_debug_delay_us > 0) {
 			PM_LOGD("%s sleep %d us for debug.\n", dev->name,
 			        initcall_debug_delay_us);
@@ -480,6 +527,7 @@ static int dpm_suspend_noirq(enum suspend_state_t state)
 			PM_REBOOT();
 		}
 		if (wakeup) {
+			pm_prof_abort(pending_wakeup_irq());
 			error = -1;
 			break;
 		}
@@ -508,13 +556,16 @@ static int dpm_suspend(enum suspend_state_t state)
 #ifdef CONFIG_PM_DEBUG
 	ktime_t starttime = ktime_get();
 #endif
+	uint64_t t;
 	int error = 0;
 
 	while (!list_empty(&dpm_list)) {
 		dev = to_device(dpm_list.next, PM_OP_NORMAL);
 
 		get_device(dev);
+		t = PM_PROF_TIME();
 		error = dev->driver->suspend(dev, state);
+		pm_prof_dev(dev, PM_DEV_SUSPEND, t);
 		if (initcall_debug_delay_us > 0) {
 			PM_LOGD("sleep %d ms for debug.\n", initcall_debug_delay_us);
 			pm_udelay(initcall_debug_delay_us);
@@ -555,6 +606,7 @@ static void dpm_resume_noirq(enum suspend_state_t state)
 {
 	struct soc_device *dev;
 	ktime_t starttime = ktime_get();
+	uint64_t t;
 	int error;
 
 	while (!list_empty(&dpm_noirq_list)) {
@@ -565,7 +617,9 @@ static void dpm_resume_noirq(enum suspend_state_t state)
 		dsb();
 		isb();
 
+		t = PM_PROF_TIME();
 		error = dev->driver->resume_noirq(dev, state);
+		pm_prof_dev(dev, PM_DEV_RESUME_NOIRQ, t);
 #ifdef CONFIG_PM_DEBUG
 		if (error) {
 			suspend_stats.failed_resume_noirq++;
@@ -581,6 +635,122 @@ static void dpm_resume_noirq(enum suspend_state_t state)
 	dpm_show_time(starttime, state, "noirq");
 }
 
+#define PM_RESUME_WORKER_MAX    4
+#define PM_RESUME_WORKER_STACK  (2 * 1024)
+#define PM_RESUME_STAGED_MAX    32
+
+/* threads resuming devices of resume_stage above 0 with the calling thread */
+struct pm_resume_workers {
+	OS_Thread_t thread[PM_RESUME_WORKER_MAX];
+	OS_Semaphore_t start;
+	OS_Semaphore_t done;
+	unsigned int num;
+	volatile int run;
+
+	/* the stage being resumed */
+	struct soc_device **dev;
+	unsigned int dev_num;
+	unsigned int next;
+	enum suspend_state_t state;
+};
+
+static struct pm_resume_workers pm_resume;
+
+static void dpm_resume_device(struct soc_device *dev, enum suspend_state_t state)
+{
+	uint64_t t;
+	int error;
+
+	t = PM_PROF_TIME();
+	error = dev->driver->resume(dev, state);
+	pm_prof_dev(dev, PM_DEV_RESUME, t);
+#ifdef CONFIG_PM_DEBUG
+	if (error) {
+		unsigned long flags = PM_IRQ_SAVE();
+		suspend_stats.failed_resume++;
+		PM_IRQ_RESTORE(flags);
+		PM_LOGE("%s resume failed!\n", dev->name);
+	}
+#else
+	(void)error;
+#endif
+
+	put_device(dev);
+}
+
+/* take the devices of the stage one by one until none is left */
+static void dpm_resume_stage_run(void)
+{
+	struct soc_device *dev;
+	unsigned long flags;
+
+	while (1) {
+		flags = PM_IRQ_SAVE();
+		dev = NULL;
+		if (pm_resume.next < pm_resume.dev_num)
+			dev = pm_resume.dev[pm_resume.next++];
+		PM_IRQ_RESTORE(flags);
+		if (dev == NULL)
+			break;
+		dpm_resume_device(dev, pm_resume.state);
+	}
+}
+
+static void pm_resume_task(void *arg)
+{
+	while (pm_resume.run) {
+		if (OS_SemaphoreWait(&pm_resume.start, OS_WAIT_FOREVER) != OS_OK ||
+		    !pm_resume.run)
+			continue;
+		dpm_resume_stage_run();
+		OS_SemaphoreRelease(&pm_resume.done);
+	}
+
+	OS_ThreadDelete(arg);
+}
+
+/**
+ * dpm_resume_staged - Resume devices of resume_stage above 0.
+ * @dev: Devices in resume order.
+ * @num: Number of devices.
+ * @state: PM transition of the system being carried out.
+ *
+ * Stages are resumed in increasing order. All devices of a stage are resumed
+ * before the next stage starts, by the workers and the calling thread.
+ */
+static void dpm_resume_staged(struct soc_device **dev, unsigned int num,
+                              enum suspend_state_t state)
+{
+	struct soc_device *d;
+	unsigned int i, j, k, workers;
+
+	/* stable, devices of a stage keep the resume order */
+	for (i = 1; i < num; i++) {
+		d = dev[i];
+		for (j = i; j > 0 && dev[j - 1]->resume_stage > d->resume_stage; j--)
+			dev[j] = dev[j - 1];
+		dev[j] = d;
+	}
+
+	for (i = 0; i < num; i = j) {
+		for (j = i + 1; j < num && dev[j]->resume_stage == dev[i]->resume_stage; j++)
+			;
+		pm_resume.dev = &dev[i];
+		pm_resume.dev_num = j - i;
+		pm_resume.next = 0;
+		pm_resume.state = state;
+
+		workers = pm_resume.num;
+		if (workers > j - i - 1)
+			workers = j - i - 1;
+		for (k = 0; k < workers; k++)
+			OS_SemaphoreRelease(&pm_resume.start);
+		dpm_resume_stage_run();
+		for (k = 0; k < workers; k++)
+			OS_SemaphoreWait(&pm_resume.done, OS_WAIT_FOREVER);
+	}
+}
+
 /**
  * dpm_resume - Execute "resume" callbacks for non-sysdev devices.
  * @state: PM transition of the system being carried out.
@@ -591,8 +761,9 @@ static void dpm_resume_noirq(enum suspend_state_t state)
 static void dpm_resume(enum suspend_state_t state)
 {
 	struct soc_device *dev;
+	struct soc_device *staged[PM_RESUME_STAGED_MAX];
+	unsigned int staged_num = 0;
 	ktime_t starttime = ktime_get();
-	int error;
 
 	while (!list_empty(&dpm_suspended_list)) {
 		dev = to_device(dpm_suspended_list.next, PM_OP_NORMAL);
@@ -602,19 +773,17 @@ static void dpm_resume(enum suspend_state_t state)
 		dsb();
 		isb();
 
-		error = dev->driver->resume(dev, state);
-#ifdef CONFIG_PM_DEBUG
-		if (error) {
-			suspend_stats.failed_resume++;
-			PM_LOGE("%s resume failed!\n", dev->name);
+		if (dev->resume_stage && staged_num < PM_RESUME_STAGED_MAX) {
+			staged[staged_num++] = dev;
+			continue;
 		}
-#else
-		(void)error;
-		(void)starttime;
-#endif
-
-		put_device(dev);
+		dpm_resume_device(dev, state);
 	}
+	if (staged_num)
+		dpm_resume_staged(staged, staged_num, state);
+#ifndef CONFIG_PM_DEBUG
+	(void)starttime;
+#endif
 	dpm_show_time(starttime, state, "resume");
 }
 
@@ -643,6 +812,7 @@ static int suspend_enter(enum suspend_state_t state)
 		PM_REBOOT();
 	}
 	if (wakeup) {
+		pm_prof_abort(pending_wakeup_irq());
 		error = -1;
 		goto Platform_finish;
 	}
@@ -678,6 +848,8 @@ static int suspend_enter(enum suspend_state_t state)
 		__record_dbg_status(PM_SUSPEND_ENTER | 3);
 		suspend_ops.enter(state);
 		__record_dbg_status(PM_SUSPEND_ENTER | 4);
+	} else if (wakeup) {
+		pm_prof_abort(pending_wakeup_irq());
 	}
 
 Platform_wake:
@@ -737,6 +909,7 @@ static int suspend_devices_and_enter(enum suspend_state_t state)
 	OS_ThreadSuspendScheduler();
 	__record_dbg_status(PM_SUSPEND_ENTER);
 	suspend_enter(state);
+	pm_prof_first_task();
 	OS_ThreadResumeScheduler();
 
 Resume_devices:
@@ -780,6 +953,7 @@ int pm_register_ops(struct soc_device *dev)
 	PM_BUG_ON(dev, !dev->driver ||
 	          ((!dev->driver->suspend_noirq || !dev->driver->resume_noirq) &&
 	           (!dev->driver->suspend || !dev->driver->resume)));
+	pm_prof_add_dev(dev);
 
 	if (dev->driver->suspend || dev->driver->resume) {
 		PM_BUG_ON(dev, !dev->driver->suspend || !dev->driver->resume);
@@ -868,6 +1042,7 @@ void pm_stats_show(void)
 	        suspend_stats.failed_suspend, suspend_stats.failed_resume,
 	        suspend_stats.last_failed_step, suspend_stats.failed_devs,
 	        HAL_Wakeup_GetEvent());
+	pm_prof_show();
 }
 #else
 void pm_stats_show(void)
@@ -1026,6 +1201,7 @@ int pm_enter_mode(enum suspend_state_t state)
 	if (state_use < PM_MODE_SLEEP)
 		return 0;
 
+	pm_prof_begin();
 	pm_select_mode(state_use);
 	PM_LOGA(PM_SYS" enter mode: %s\n", pm_states[state_use]);
 	record = __get_last_record_step();
@@ -1054,16 +1230,80 @@ int pm_enter_mode(enum suspend_state_t state)
 		pm_wlan_power_onoff_cb(1);
 	}
 #endif
+	pm_prof_end();
 
 	return err;
 }
 
+static void pm_resume_workers_stop(void)
+{
+	unsigned int i;
+
+	if (!pm_resume.run)
+		return;
+
+	pm_resume.run = 0;
+	for (i = 0; i < pm_resume.num; i++)
+		OS_SemaphoreRelease(&pm_resume.start);
+	for (i = 0; i < pm_resume.num; i++) {
+		while (OS_ThreadIsValid(&pm_resume.thread[i]))
+			OS_MSleep(1);
+	}
+	OS_SemaphoreDelete(&pm_resume.start);
+	OS_SemaphoreDelete(&pm_resume.done);
+	pm_resume.num = 0;
+}
+
+/**
+ * @brief Set the number of threads resuming devices of resume_stage above 0.
+ * @note The calling thread of pm_enter_mode() resumes devices too. With 0
+ *       workers the devices of a stage are resumed one after another.
+ *       Not to be called while pm_enter_mode() is running.
+ * @param num:
+ *        @arg num->Worker threads, 0 ~ 4.
+ * @retval  0 if success or other if failed.
+ */
+int pm_set_resume_workers(unsigned int num)
+{
+	unsigned int i;
+
+	if (num > PM_RESUME_WORKER_MAX)
+		return -EINVAL;
+
+	pm_resume_workers_stop();
+	if (!num)
+		return 0;
+
+	if (OS_SemaphoreCreate(&pm_resume.start, 0, PM_RESUME_WORKER_MAX) != OS_OK)
+		return -1;
+	if (OS_SemaphoreCreate(&pm_resume.done, 0, PM_RESUME_WORKER_MAX) != OS_OK) {
+		OS_SemaphoreDelete(&pm_resume.start);
+		return -1;
+	}
+	pm_resume.run = 1;
+	for (i = 0; i < num; i++) {
+		if (OS_ThreadCreate(&pm_resume.thread[i], "pm_resume", pm_resume_task,
+		                    &pm_resume.thread[i], OS_THREAD_PRIO_SYS_CTRL,
+		                    PM_RESUME_WORKER_STACK) != OS_OK)
+			break;
+	}
+	pm_resume.num = i;
+	if (i < num) {
+		PM_LOGE("create resume worker %u failed\n", i);
+		pm_resume_workers_stop();
+		return -1;
+	}
+
+	return 0;
+}
+
 void pm_start(void)
 {
 }
 
 void pm_stop(void)
 {
+	pm_resume_workers_stop();
 }
 
 //#define CONFIG_PM_TEST 1
@@ -160,6 +160,35 @@ struct platform_suspend_ops {
 
 extern void __cpu_sleep(enum suspend_state_t state);
 extern void __cpu_suspend(enum suspend_state_t state);
+
+/* pm profiler, see pm_prof.c */
+#ifdef __CONFIG_PM_PROFILE
+#define PM_PROF_TIME() pm_time_us()
+
+extern void pm_prof_add_dev(struct soc_device *dev);
+extern void pm_prof_dev(struct soc_device *dev, enum pm_dev_op_t op, uint64_t start);
+extern void pm_prof_begin(void);
+extern void pm_prof_abort(int irq);
+extern void pm_prof_enter(enum suspend_state_t state);
+extern void pm_prof_wake(enum suspend_state_t state, uint32_t event, int irq);
+extern void pm_prof_first_task(void);
+extern void pm_prof_end(void);
+extern void pm_prof_show(void);
+#else
+#define PM_PROF_TIME() 0
+
+static inline void pm_prof_add_dev(struct soc_device *dev) {;}
+static inline void pm_prof_dev(struct soc_device *dev, enum pm_dev_op_t op,
+                               uint64_t start) {;}
+static inline void pm_prof_begin(void) {;}
+static inline void pm_prof_abort(int irq) {;}
+static inline void pm_prof_enter(enum suspend_state_t state) {;}
+static inline void pm_prof_wake(enum suspend_state_t state, uint32_t event,
+                                int irq) {;}
+static inline void pm_prof_first_task(void) {;}
+static inline void pm_prof_end(void) {;}
+static inline void pm_prof_show(void) {;}
+#endif
 #endif
 
 #endif
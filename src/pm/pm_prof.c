@@ -0,0 +1,330 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sys/interrupt.h"
+
+#include "pm/pm.h"
+#include "pm_i.h"
+#include "port.h"
+
+#if (defined(CONFIG_PM) && defined(__CONFIG_PM_PROFILE))
+
+/*
+ * Profiler of the suspend and resume path. Times are taken by pm_time_us(),
+ * the RTC free run counter on XR871, it keeps counting in sleep and standby
+ * and has a resolution of one LF clock cycle, about 31 us.
+ */
+
+#define PM_PROF_DEV_MAX 32
+
+static struct pm_dev_stats pm_prof_devs[PM_PROF_DEV_MAX];
+static volatile int pm_prof_dev_num;
+
+static struct pm_prof_stats pm_prof;
+
+/* the suspend in progress */
+static uint64_t pm_prof_t_begin;        /* pm_enter_mode() called */
+static uint64_t pm_prof_t_enter;        /* sleep instruction */
+static uint64_t pm_prof_t_wake;         /* back from the sleep instruction */
+static int pm_prof_woken;               /* pm_prof_t_wake is of this suspend */
+static uint32_t pm_prof_wake_src;       /* sources of pm_prof_t_wake, awake time not added */
+
+static const char *const pm_prof_src_names[PM_WAKE_SRC_NUM] = {
+	"io0", "io1", "io2", "io3", "io4", "io5", "io6", "io7", "io8", "io9",
+	"timer", "sev", "devices",
+};
+
+static const char *const pm_prof_mode_names[PM_MODE_MAX] = {
+	[PM_MODE_ON]            = "on",
+	[PM_MODE_SLEEP]         = "sleep",
+	[PM_MODE_STANDBY]       = "standby",
+	[PM_MODE_HIBERNATION]   = "hibernation",
+	[PM_MODE_POWEROFF]      = "poweroff",
+};
+
+static uint32_t pm_prof_sat(uint64_t us)
+{
+	return (us > UINT32_MAX) ? UINT32_MAX : (uint32_t)us;
+}
+
+static void pm_prof_time_add(struct pm_time_stats *st, uint64_t us)
+{
+	uint32_t t = pm_prof_sat(us);
+
+	st->count++;
+	st->last = t;
+	if (t > st->max)
+		st->max = t;
+	st->total += t;
+}
+
+/* hist[0]: below 1 ms, hist[n]: [2^(n-1), 2^n) ms */
+static int pm_prof_hist_idx(uint64_t us)
+{
+	uint64_t ms = us / 1000;
+	int idx = 0;
+
+	while (ms && idx < PM_RESIDENCY_HIST_NUM - 1) {
+		ms >>= 1;
+		idx++;
+	}
+	return idx;
+}
+
+/* called by pm_register_ops(), not use printf */
+void pm_prof_add_dev(struct soc_device *dev)
+{
+	unsigned long flags;
+	int i;
+
+	flags = arch_irq_save();
+	for (i = 0; i < pm_prof_dev_num; i++) {
+		if (pm_prof_devs[i].dev == dev)
+			break;
+	}
+	if (i == pm_prof_dev_num && i < PM_PROF_DEV_MAX) {
+		pm_prof_devs[i].dev = dev;
+		pm_prof_dev_num = i + 1;
+	}
+	arch_irq_restore(flags);
+}
+
+/* the resume workers call this in parallel, for different devices */
+void pm_prof_dev(struct soc_device *dev, enum pm_dev_op_t op, uint64_t start)
+{
+	uint64_t now = pm_time_us();
+	int i;
+
+	for (i = 0; i < pm_prof_dev_num; i++) {
+		if (pm_prof_devs[i].dev == dev) {
+			pm_prof_time_add(&pm_prof_devs[i].op[op], now - start);
+			return;
+		}
+	}
+}
+
+void pm_prof_begin(void)
+{
+	uint64_t now = pm_time_us();
+	uint32_t src;
+	int i;
+
+	/* awake time of a wakeup ends at the first suspend after it */
+	for (src = pm_prof_wake_src, i = 0; src; src >>= 1, i++) {
+		if (src & 1)
+			pm_prof.src[i].awake += now - pm_prof_t_wake;
+	}
+	pm_prof_wake_src = 0;
+	pm_prof_woken = 0;
+	pm_prof_t_begin = now;
+}
+
+void pm_prof_abort(int irq)
+{
+	pm_prof.aborts++;
+	if (irq >= 0 && irq < PM_WAKE_IRQ_NUM)
+		pm_prof.abort_irq[irq]++;
+}
+
+void pm_prof_enter(enum suspend_state_t state)
+{
+	pm_prof_t_enter = pm_time_us();
+	pm_prof_time_add(&pm_prof.suspend, pm_prof_t_enter - pm_prof_t_begin);
+}
+
+void pm_prof_wake(enum suspend_state_t state, uint32_t event, int irq)
+{
+	struct pm_residency_stats *mode = &pm_prof.mode[state];
+	uint64_t sleep;
+	uint32_t src;
+	int i;
+
+	pm_prof_t_wake = pm_time_us();
+	pm_prof_woken = 1;
+	sleep = pm_prof_t_wake - pm_prof_t_enter;
+
+	mode->count++;
+	mode->total += sleep;
+	if (pm_prof_sat(sleep) > mode->max)
+		mode->max = pm_prof_sat(sleep);
+	mode->hist[pm_prof_hist_idx(sleep)]++;
+
+	if (irq >= 0 && irq < PM_WAKE_IRQ_NUM)
+		pm_prof.wake_irq[irq]++;
+	event &= (1 << PM_WAKE_SRC_NUM) - 1;
+	for (src = event, i = 0; src; src >>= 1, i++) {
+		if (src & 1) {
+			pm_prof.src[i].count++;
+			pm_prof.src[i].sleep += sleep;
+		}
+	}
+	pm_prof_wake_src = event;
+}
+
+/* called with the scheduler still suspended, the next thing to run is a task */
+void pm_prof_first_task(void)
+{
+	if (pm_prof_woken)
+		pm_prof_time_add(&pm_prof.first_task, pm_time_us() - pm_prof_t_wake);
+}
+
+void pm_prof_end(void)
+{
+	if (pm_prof_woken)
+		pm_prof_time_add(&pm_prof.resume, pm_time_us() - pm_prof_t_wake);
+}
+
+static void pm_prof_show_time(const char *name, struct pm_time_stats *st)
+{
+	if (!st->count)
+		return;
+	PM_LOGA("  %-10s %u times, last %u us, avg %u us, max %u us\n", name,
+	        st->count, st->last, (uint32_t)(st->total / st->count), st->max);
+}
+
+void pm_prof_show(void)
+{
+	struct pm_residency_stats *mode;
+	struct pm_dev_stats *dev;
+	int i, j;
+
+	PM_LOGA("residency:\n");
+	for (i = PM_MODE_SLEEP; i < PM_MODE_MAX; i++) {
+		mode = &pm_prof.mode[i];
+		if (!mode->count)
+			continue;
+		PM_LOGA("  %-10s %u times, avg %u ms, max %u ms, hist(ms)",
+		        pm_prof_mode_names[i], mode->count,
+		        (uint32_t)(mode->total / mode->count / 1000), mode->max / 1000);
+		for (j = 0; j < PM_RESIDENCY_HIST_NUM; j++) {
+			if (mode->hist[j])
+				printf(" %s%u:%u", j ? ">=" : "<", j ? 1U << (j - 1) : 1U,
+				       mode->hist[j]);
+		}
+		printf("\n");
+	}
+
+	PM_LOGA("wakeup sources:\n");
+	for (i = 0; i < PM_WAKE_SRC_NUM; i++) {
+		if (!pm_prof.src[i].count)
+			continue;
+		PM_LOGA("  %-10s %u times, slept %u ms, awake %u ms\n",
+		        pm_prof_src_names[i], pm_prof.src[i].count,
+		        (uint32_t)(pm_prof.src[i].sleep / 1000),
+		        (uint32_t)(pm_prof.src[i].awake / 1000));
+	}
+	for (i = 0; i < PM_WAKE_IRQ_NUM; i++) {
+		if (pm_prof.wake_irq[i] || pm_prof.abort_irq[i])
+			PM_LOGA("  irq %-6d %u wakeups, %u aborts\n", i,
+			        pm_prof.wake_irq[i], pm_prof.abort_irq[i]);
+	}
+	PM_LOGA("  aborted    %u times\n", pm_prof.aborts);
+
+	PM_LOGA("latency:\n");
+	pm_prof_show_time("suspend", &pm_prof.suspend);
+	pm_prof_show_time("first task", &pm_prof.first_task);
+	pm_prof_show_time("resume", &pm_prof.resume);
+
+	PM_LOGA("device callbacks, avg/max us:\n");
+	PM_LOGA("  %-12s %15s %15s %15s %15s\n", "", "suspend", "suspend_noirq",
+	        "resume_noirq", "resume");
+	for (i = 0; i < pm_prof_dev_num; i++) {
+		dev = &pm_prof_devs[i];
+		PM_LOGA("  %-12s", dev->dev->name ? dev->dev->name : "NULL");
+		for (j = 0; j < PM_DEV_OP_NUM; j++) {
+			if (dev->op[j].count)
+				printf(" %7u/%-7u",
+				       (uint32_t)(dev->op[j].total / dev->op[j].count),
+				       dev->op[j].max);
+			else
+				printf(" %15s", "-");
+		}
+		printf("\n");
+	}
+}
+
+/**
+ * @brief Get the statistics of the pm profiler.
+ * @retval  0 if success or other if failed.
+ */
+int pm_get_prof_stats(struct pm_prof_stats *st)
+{
+	unsigned long flags;
+
+	if (!st)
+		return -1;
+
+	flags = arch_irq_save();
+	memcpy(st, &pm_prof, sizeof(*st));
+	arch_irq_restore(flags);
+
+	return 0;
+}
+
+/**
+ * @brief Get the callback timings of the registered devices.
+ * @param st:
+ *        @arg st->Array receiving the timings.
+ * @param num:
+ *        @arg num->Entries of the array.
+ * @retval  Number of entries filled.
+ */
+int pm_get_dev_stats(struct pm_dev_stats *st, int num)
+{
+	unsigned long flags;
+
+	flags = arch_irq_save();
+	if (num > pm_prof_dev_num)
+		num = pm_prof_dev_num;
+	if (num > 0)
+		memcpy(st, pm_prof_devs, num * sizeof(*st));
+	arch_irq_restore(flags);
+
+	return num > 0 ? num : 0;
+}
+
+/** @brief Clear the statistics of the pm profiler. */
+void pm_prof_reset(void)
+{
+	unsigned long flags;
+	int i;
+
+	flags = arch_irq_save();
+	memset(&pm_prof, 0, sizeof(pm_prof));
+	for (i = 0; i < pm_prof_dev_num; i++)
+		memset(pm_prof_devs[i].op, 0, sizeof(pm_prof_devs[i].op));
+	pm_prof_wake_src = 0;
+	arch_irq_restore(flags);
+}
+
+#endif /* CONFIG_PM && __CONFIG_PM_PROFILE */
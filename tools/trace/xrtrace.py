@@ -0,0 +1,337 @@
+#!/usr/bin/env python3
+#
+# Decode a trace image written by OSTraceDump() (kernel/FreeRTOS/tracebuf.h).
+#
+# The input is either the raw image or a console log holding the output of
+# "trace dump". The default output is Chrome trace JSON, which Perfetto
+# (ui.perfetto.dev) and chrome://tracing open directly.
+#
+#   xrtrace.py console.log -o trace.json
+#   xrtrace.py trace.bin --stats
+#
+
+import argparse
+import json
+import re
+import struct
+import sys
+
+TRACE_MAGIC = 0x52545258
+
+HDR = struct.Struct('<IHHIHHIIB3x')
+REC = struct.Struct('<HBB16s')
+EV = struct.Struct('<IBBHI')
+
+EV_SWITCH_IN, EV_SWITCH_OUT, EV_READY, EV_BLOCK, EV_ISR_ENTER, EV_ISR_EXIT, \
+    EV_SEND, EV_RECV, EV_PRIO_INHERIT, EV_CREATE, EV_DELETE, EV_MARK, \
+    EV_SPAN_BEGIN, EV_SPAN_END, EV_STOP = range(1, 16)
+
+OUT_PREEMPT, OUT_BLOCK, OUT_DELETE = range(3)
+
+BLOCK_NAMES = ['mutex', 'sem', 'queue', 'event', 'notify', 'delay', 'suspend']
+CLASS_NAMES = ['queue', 'mutex', 'sem']
+OP_RECV, OP_FAILED, OP_ISR = 0x1, 0x2, 0x4
+
+IRQ_TRACK = 0x10000
+
+UNKNOWN, RUNNING, READY, BLOCKED = range(4)
+
+
+class Trace(object):
+    def __init__(self, data):
+        if len(data) < HDR.size:
+            raise ValueError('image too short')
+        (magic, self.version, hdr_size, self.cpu_hz, thread_num, event_size,
+         event_num, self.dropped, self.mode) = HDR.unpack_from(data, 0)
+        if magic != TRACE_MAGIC:
+            raise ValueError('bad magic 0x%08x' % magic)
+        if event_size != EV.size:
+            raise ValueError('unsupported event size %d' % event_size)
+        off = hdr_size
+        self.names = {0: '(other)'}
+        for _ in range(thread_num):
+            tid, alive, _, name = REC.unpack_from(data, off)
+            self.names[tid] = name.split(b'\0')[0].decode('ascii', 'replace')
+            off += REC.size
+        self.events = []
+        t64 = None
+        for _ in range(event_num):
+            ts, typ, sub, tid, arg = EV.unpack_from(data, off)
+            off += EV.size
+            if t64 is None:
+                t64 = ts
+            else:
+                t64 += (ts - t64) & 0xffffffff
+            self.events.append((t64, typ, sub, tid, arg))
+
+    def name(self, tid):
+        return self.names.get(tid, 'tid %d' % tid)
+
+    def us(self, t):
+        return (t - self.events[0][0]) * 1e6 / self.cpu_hz
+
+
+def read_image(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:4] == struct.pack('<I', TRACE_MAGIC):
+        return data
+    # console log: "TR <offset>: <hex bytes>" lines after "TR begin"
+    image = bytearray()
+    inside = False
+    for line in data.decode('ascii', 'replace').splitlines():
+        m = re.search(r'TR (begin|end|([0-9a-fA-F]{8}):(.*))', line)
+        if not m:
+            continue
+        if m.group(1) == 'begin':
+            image = bytearray()
+            inside = True
+        elif m.group(1).startswith('end'):
+            inside = False
+        elif inside:
+            if int(m.group(2), 16) != len(image):
+                raise ValueError('missing dump line at offset %s' % m.group(2))
+            image += bytes.fromhex(m.group(3))
+    if not image:
+        raise ValueError('no trace dump found in %s' % path)
+    return bytes(image)
+
+
+class ThreadStat(object):
+    def __init__(self):
+        self.state = UNKNOWN
+        self.since = 0
+        self.reason = 0
+        self.pend = None
+        self.isr_mark = 0
+        self.run = 0
+        self.ready = 0
+        self.blocked = [0] * len(BLOCK_NAMES)
+        self.switches = 0
+        self.preempts = 0
+
+    def settle(self, now):
+        if self.state == READY:
+            self.ready += now - self.since
+        elif self.state == BLOCKED:
+            self.blocked[self.reason] += now - self.since
+        self.since = now
+
+
+def statistics(tr):
+    """Replay the events the way the recorder accounts them."""
+    threads = {}
+    irqs = {}
+    isr_total = 0
+    nest = []
+    cur = None
+
+    def thread(tid):
+        if tid not in threads:
+            threads[tid] = ThreadStat()
+        return threads[tid]
+
+    def account_run(t, now):
+        d = now - t.since
+        isr = isr_total - t.isr_mark
+        t.run += d - isr if d > isr else 0
+        t.since = now
+        t.isr_mark = isr_total
+
+    for i, (now, typ, sub, tid, arg) in enumerate(tr.events):
+        if typ == EV_SWITCH_IN:
+            t = thread(tid)
+            t.settle(now)
+            t.state = RUNNING
+            t.isr_mark = isr_total
+            if i > 0:
+                t.switches += 1
+            cur = tid
+        elif typ == EV_SWITCH_OUT:
+            t = thread(tid)
+            if t.state == RUNNING:
+                account_run(t, now)
+            if tid == 0 or sub == OUT_DELETE:
+                t.state = UNKNOWN
+                t.pend = None
+            elif sub == OUT_BLOCK:
+                t.state = BLOCKED
+                t.reason = t.pend if t.pend is not None else 0
+                t.pend = None
+            else:
+                t.state = READY
+                t.preempts += 1
+            t.since = now
+        elif typ == EV_READY:
+            t = thread(tid)
+            if t.state == RUNNING:
+                t.pend = None
+            else:
+                t.settle(now)
+                t.state = READY
+        elif typ == EV_BLOCK:
+            t = thread(tid)
+            if tid == cur:
+                t.pend = sub
+            else:
+                t.settle(now)
+                t.state = BLOCKED
+                t.reason = sub
+        elif typ == EV_DELETE:
+            t = thread(tid)
+            if tid != cur:
+                t.settle(now)
+                t.state = UNKNOWN
+        elif typ == EV_ISR_ENTER:
+            nest.append(now)
+        elif typ == EV_ISR_EXIT and nest:
+            d = now - nest.pop()
+            s = irqs.setdefault(arg, [0, 0, 0])
+            s[0] += 1
+            s[1] += d
+            s[2] = max(s[2], d)
+            if not nest:
+                isr_total += d
+        elif typ == EV_STOP:
+            for t in threads.values():
+                if t.state == RUNNING:
+                    account_run(t, now)
+                else:
+                    t.settle(now)
+            break
+    return threads, irqs
+
+
+def print_stats(tr, out):
+    threads, irqs = statistics(tr)
+    for tid in sorted(threads):
+        t = threads[tid]
+        out.write('thread %d %s run %d ready %d blocked %s switches %d preempts %d\n' %
+                  (tid, tr.name(tid), t.run, t.ready,
+                   ','.join('%d' % b for b in t.blocked), t.switches, t.preempts))
+    for irq in sorted(irqs):
+        s = irqs[irq]
+        out.write('irq %d count %d total %d max %d\n' % (irq, s[0], s[1], s[2]))
+
+
+def chrome_trace(tr):
+    out = []
+    pid = 1
+
+    def meta(tid, name):
+        out.append({'ph': 'M', 'pid': pid, 'tid': tid, 'name': 'thread_name',
+                    'args': {'name': name}})
+
+    def slice_(tid, name, begin, end, cat, args=None):
+        ev = {'ph': 'X', 'pid': pid, 'tid': tid, 'name': name, 'cat': cat,
+              'ts': tr.us(begin), 'dur': tr.us(end) - tr.us(begin)}
+        if args:
+            ev['args'] = args
+        out.append(ev)
+
+    def instant(tid, name, now, cat, args=None):
+        ev = {'ph': 'i', 's': 't', 'pid': pid, 'tid': tid, 'name': name,
+              'cat': cat, 'ts': tr.us(now)}
+        if args:
+            ev['args'] = args
+        out.append(ev)
+
+    out.append({'ph': 'M', 'pid': pid, 'name': 'process_name',
+                'args': {'name': 'XR trace, %d Hz' % tr.cpu_hz}})
+    meta(IRQ_TRACK, 'IRQ')
+    seen = set()
+    running = {}
+    blocked = {}
+    pend = {}
+    isr = []
+    spans = {}
+
+    for now, typ, sub, tid, arg in tr.events:
+        if tid not in seen:
+            seen.add(tid)
+            meta(tid, tr.name(tid))
+        if typ == EV_SWITCH_IN:
+            running[tid] = now
+            if tid in blocked:
+                begin, name, args = blocked.pop(tid)
+                slice_(tid, name, begin, now, 'blocked', args)
+        elif typ == EV_SWITCH_OUT:
+            if tid in running:
+                slice_(tid, 'running', running.pop(tid), now, 'sched')
+            if sub == OUT_BLOCK and tid in pend:
+                reason, obj = pend.pop(tid)
+                name = 'blocked: %s' % BLOCK_NAMES[reason]
+                blocked[tid] = (now, name, {'object': '0x%08x' % obj} if obj else None)
+        elif typ == EV_READY:
+            if tid in blocked:
+                begin, name, args = blocked.pop(tid)
+                slice_(tid, name, begin, now, 'blocked', args)
+            elif tid in running:
+                pend.pop(tid, None)
+            instant(tid, 'ready', now, 'sched')
+        elif typ == EV_BLOCK:
+            pend[tid] = (sub, arg)
+        elif typ == EV_ISR_ENTER:
+            isr.append((arg, now))
+        elif typ == EV_ISR_EXIT and isr:
+            irq, begin = isr.pop()
+            slice_(IRQ_TRACK, 'irq %d' % irq, begin, now, 'irq')
+        elif typ in (EV_SEND, EV_RECV):
+            cls = CLASS_NAMES[sub >> 4] if (sub >> 4) < len(CLASS_NAMES) else 'object'
+            if cls == 'queue':
+                op = 'recv' if typ == EV_RECV else 'send'
+            else:
+                op = 'take' if typ == EV_RECV else 'give'
+            name = '%s %s%s%s' % (op, cls, ' (isr)' if sub & OP_ISR else '',
+                                  ' failed' if sub & OP_FAILED else '')
+            instant(tid, name, now, 'ipc', {'object': '0x%08x' % arg})
+        elif typ == EV_PRIO_INHERIT:
+            instant(tid, 'priority inherit', now, 'sched', {'priority': arg})
+        elif typ == EV_CREATE:
+            instant(tid, 'create', now, 'sched')
+        elif typ == EV_DELETE:
+            instant(tid, 'delete', now, 'sched')
+        elif typ == EV_MARK:
+            instant(tid, 'mark %d' % sub, now, 'user', {'value': arg})
+        elif typ == EV_SPAN_BEGIN:
+            spans[(tid, sub)] = (now, arg)
+        elif typ == EV_SPAN_END and (tid, sub) in spans:
+            begin, value = spans.pop((tid, sub))
+            slice_(tid, 'span %d' % sub, begin, now, 'user',
+                   {'begin': value, 'end': arg})
+        elif typ == EV_STOP:
+            break
+
+    if tr.events:
+        last = tr.events[-1][0]
+        for tid, begin in running.items():
+            slice_(tid, 'running', begin, last, 'sched')
+    return {'traceEvents': out, 'displayTimeUnit': 'ns',
+            'otherData': {'cpu_hz': tr.cpu_hz, 'dropped': tr.dropped}}
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Decode an OSTraceDump() image.')
+    ap.add_argument('input', help='trace image or console log')
+    ap.add_argument('-o', '--output', help='Chrome trace JSON file (default stdout)')
+    ap.add_argument('--stats', action='store_true',
+                    help='print per-thread and per-IRQ cycle statistics instead')
+    args = ap.parse_args()
+
+    tr = Trace(read_image(args.input))
+    if not tr.events:
+        sys.stderr.write('trace is empty\n')
+    if args.stats:
+        print_stats(tr, sys.stdout)
+        return 0
+    out = open(args.output, 'w') if args.output else sys.stdout
+    json.dump(chrome_trace(tr), out)
+    if args.output:
+        out.close()
+    else:
+        sys.stdout.write('\n')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())